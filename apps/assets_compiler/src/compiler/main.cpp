@@ -1,78 +1,380 @@
 // Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <unordered_set>
 
 #include <clara/clapa.hpp>
 
+#include <asset/asset_manifest.h>
 #include <asset/bin.h>
+#include <asset/io.h>
 #include <asset/model_asset.h>
+#include <asset/pbr_material_desc.h>
 
-#include <core/log.h>
-#include <core/string.h>
+#include <core/hash.h>
+#include <core/job_system.h>
+#include <core/project.h>
+
+namespace era_engine
+{
+	enum class AssetCompileStatus
+	{
+		UpToDate,	// Size and write time match the manifest, the source wasn't even read.
+		Unchanged,	// Touched, but the content hash matches. Only the cache's write time is refreshed.
+		Compiled,
+		Failed,
+	};
+
+	struct AssetCompileTask
+	{
+		fs::path source_path;
+		std::string key;
+		fs::path cache_path;
+
+		uint64 source_size = 0;
+		int64 source_write_time = 0;
+
+		AssetCompileStatus status = AssetCompileStatus::Failed;
+		AssetManifestEntry entry;
+		double seconds = 0.0;
+		std::string error;
+	};
+
+	using compiler_clock = std::chrono::high_resolution_clock;
+
+	static double seconds_since(compiler_clock::time_point start)
+	{
+		return std::chrono::duration<double>(compiler_clock::now() - start).count();
+	}
+
+	static double to_megabytes(uint64 bytes)
+	{
+		return (double)bytes / (1024.0 * 1024.0);
+	}
+
+	static bool is_compilable_extension(const fs::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](char c) { return std::tolower(c); });
+		return extension == ".fbx" || extension == ".obj";
+	}
+
+	// Relative paths are looked up in the working directory first and in the engine directory second.
+	// Doesn't go through get_full_path, which pulls in the Win32 string conversions.
+	static fs::path resolve_input_path(const fs::path& path)
+	{
+		if (path.is_absolute() || fs::exists(path))
+		{
+			return path;
+		}
+		return fs::path(Project::engine_path) / path;
+	}
+
+	// The runtime looks models up by the path it loads them from, which is relative to the working directory.
+	// Assets outside of it keep their absolute path, get_model_cache_path maps those into the cache as well.
+	static fs::path get_asset_key_path(const fs::path& path)
+	{
+		const fs::path absolute_path = fs::absolute(path).lexically_normal();
+		const fs::path relative_path = absolute_path.lexically_proximate(fs::current_path());
+		if (relative_path.empty() || *relative_path.begin() == "..")
+		{
+			return absolute_path;
+		}
+		return relative_path;
+	}
+
+	static AssetCompileTask create_task(const fs::path& path, uint32 mesh_flags)
+	{
+		AssetCompileTask task;
+
+		const fs::path key_path = get_asset_key_path(path);
+		task.source_path = key_path;
+		task.key = key_path.generic_string();
+		task.cache_path = get_model_cache_path(key_path, mesh_flags);
+		task.source_size = fs::file_size(path);
+		task.source_write_time = (int64)fs::last_write_time(path).time_since_epoch().count();
+
+		return task;
+	}
+
+	static void compile_asset(AssetCompileTask& task, const AssetManifest& manifest, uint32 mesh_flags)
+	{
+		const compiler_clock::time_point start = compiler_clock::now();
+
+		EntireFile file = map_file(task.source_path);
+		if (!file.content && task.source_size > 0)
+		{
+			task.error = "Could not read source file";
+			task.seconds = seconds_since(start);
+			return;
+		}
+		const uint64 content_hash = hash_bytes(file.content, file.size);
+		free_file(file);
+
+		task.entry.content_hash = content_hash;
+		task.entry.importer_version = model_importer_version;
+		task.entry.mesh_flags = mesh_flags;
+		task.entry.source_size = task.source_size;
+		task.entry.source_write_time = task.source_write_time;
+
+		if (manifest.is_unchanged(task.key, mesh_flags, content_hash) && fs::exists(task.cache_path))
+		{
+			// load_3d_model_from_file compares write times, so the cache has to stay newer than the source.
+			std::error_code error;
+			fs::last_write_time(task.cache_path, fs::file_time_type::clock::now(), error);
+
+			task.status = AssetCompileStatus::Unchanged;
+			task.seconds = seconds_since(start);
+			return;
+		}
+
+		std::string extension = task.source_path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](char c) { return std::tolower(c); });
+
+		ModelAsset model = (extension == ".fbx")
+			? loadFBX(task.source_path, mesh_flags)
+			: loadOBJ(task.source_path, mesh_flags);
+
+		if (model.meshes.empty() && model.animations.empty())
+		{
+			task.error = "Importer produced neither meshes nor animations";
+			task.seconds = seconds_since(start);
+			return;
+		}
+
+		// Written next to the final file and renamed, so readers never see a half written cache.
+		fs::path temp_path = task.cache_path;
+		temp_path += ".tmp";
+
+		fs::create_directories(task.cache_path.parent_path());
+		writeBIN(model, temp_path);
+
+		std::error_code error;
+		fs::rename(temp_path, task.cache_path, error);
+		if (error)
+		{
+			fs::remove(temp_path, error);
+			task.error = "Could not write '" + task.cache_path.string() + "'";
+			task.seconds = seconds_since(start);
+			return;
+		}
+
+		task.status = AssetCompileStatus::Compiled;
+		task.seconds = seconds_since(start);
+	}
+
+	static int compile_assets(const std::vector<fs::path>& sources, const fs::path& manifest_path, uint32 mesh_flags, bool force, bool verbose)
+	{
+		const compiler_clock::time_point start = compiler_clock::now();
+
+		AssetManifest manifest;
+		if (!force)
+		{
+			manifest.load(manifest_path);
+		}
+
+		std::vector<AssetCompileTask> tasks;
+		tasks.reserve(sources.size());
+
+		std::unordered_set<std::string> keys;
+		for (const fs::path& source : sources)
+		{
+			AssetCompileTask task = create_task(source, mesh_flags);
+			if (keys.insert(task.key).second)
+			{
+				tasks.push_back(std::move(task));
+			}
+		}
+
+		// Unchanged sources are recognized from the manifest alone, without touching their contents.
+		std::vector<uint32> pending;
+		for (uint32 i = 0; i < (uint32)tasks.size(); ++i)
+		{
+			AssetCompileTask& task = tasks[i];
+
+			if (manifest.is_up_to_date(task.key, mesh_flags, task.source_size, task.source_write_time) && fs::exists(task.cache_path))
+			{
+				task.status = AssetCompileStatus::UpToDate;
+				task.entry = *manifest.find(task.key);
+				continue;
+			}
+
+			pending.push_back(i);
+		}
+
+		// Largest first, so a big model picked up last doesn't leave the other workers idle.
+		std::sort(pending.begin(), pending.end(), [&tasks](uint32 a, uint32 b) { return tasks[a].source_size > tasks[b].source_size; });
+
+		std::mutex output_mutex;
+
+		parallel_for(0, (uint32)pending.size(), 1, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				AssetCompileTask& task = tasks[pending[i]];
+
+				try
+				{
+					compile_asset(task, manifest, mesh_flags);
+				}
+				catch (const std::exception& ex)
+				{
+					task.status = AssetCompileStatus::Failed;
+					task.error = ex.what();
+				}
+
+				std::lock_guard lock{ output_mutex };
+				if (task.status == AssetCompileStatus::Compiled)
+				{
+					std::cout << "Compiled '" << task.key << "' (" << std::fixed << std::setprecision(2)
+						<< to_megabytes(task.source_size) << " MB) in " << std::setprecision(1) << task.seconds * 1000.0 << " ms.\n";
+				}
+				else if (task.status == AssetCompileStatus::Unchanged && verbose)
+				{
+					std::cout << "Content of '" << task.key << "' is unchanged.\n";
+				}
+				else if (task.status == AssetCompileStatus::Failed)
+				{
+					std::cerr << "Failed to compile '" << task.key << "': " << task.error << "\n";
+				}
+			}
+		});
+
+		uint32 num_compiled = 0;
+		uint32 num_unchanged = 0;
+		uint32 num_up_to_date = 0;
+		uint32 num_failed = 0;
+		uint64 compiled_bytes = 0;
+
+		std::ofstream error_log;
+
+		for (const AssetCompileTask& task : tasks)
+		{
+			switch (task.status)
+			{
+			case AssetCompileStatus::UpToDate: ++num_up_to_date; break;
+			case AssetCompileStatus::Unchanged: ++num_unchanged; break;
+			case AssetCompileStatus::Compiled: ++num_compiled; compiled_bytes += task.source_size; break;
+			case AssetCompileStatus::Failed:
+			{
+				++num_failed;
+				if (!error_log.is_open())
+				{
+					fs::create_directories("logs");
+					error_log.open("logs/compiler_error_log.txt");
+				}
+				error_log << "Runtime Error>" << task.key << ": " << task.error << std::endl;
+				continue;
+			}
+			}
+
+			if (verbose && task.status == AssetCompileStatus::UpToDate)
+			{
+				std::cout << "Asset '" << task.key << "' is already compiled.\n";
+			}
+
+			manifest.set(task.key, task.entry);
+		}
+
+		if (!manifest.save(manifest_path))
+		{
+			std::cerr << "Could not write manifest '" << manifest_path.string() << "'.\n";
+		}
+
+		const double seconds = seconds_since(start);
+		std::cout << tasks.size() << " asset(s): " << num_compiled << " compiled, " << num_unchanged << " unchanged, "
+			<< num_up_to_date << " up to date, " << num_failed << " failed.\n";
+		std::cout << "Compiled " << std::fixed << std::setprecision(2) << to_megabytes(compiled_bytes) << " MB in " << seconds << " s ("
+			<< to_megabytes(compiled_bytes) / max(seconds, 1e-6) << " MB/s, " << num_compiled / max(seconds, 1e-6) << " assets/s).\n";
+
+		return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+}
 
 int main(int argc, char** argv)
 {
 	using namespace era_engine;
 	using namespace clara;
 
+	int exit_code = EXIT_SUCCESS;
+
 	try
 	{
 		fs::path path;
+		fs::path directory;
+		fs::path manifest_path = L"asset_cache/manifest.txt";
+		bool force = false;
 		bool verbose = false;
+		bool show_help = false;
 
 		Parser cli;
-		cli += Opt(verbose, "verbose")["-v"]["--verbose"]("Enable verbose logging");
+		cli += Help(show_help);
+		cli += Opt(verbose)["-v"]["--verbose"]("Enable verbose logging");
 		cli += Opt(path, "path")["-p"]["--path"]("Path to asset");
+		cli += Opt(directory, "directory")["-d"]["--dir"]("Compile all FBX and OBJ assets below this directory");
+		cli += Opt(manifest_path, "manifest")["-m"]["--manifest"]("Manifest of compiled assets (default: asset_cache/manifest.txt)");
+		cli += Opt(force)["-f"]["--force"]("Ignore the manifest and recompile everything");
 
 		auto result = cli.parse(Args(argc, argv));
 		if (!result)
 		{
 			std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+			return EXIT_FAILURE;
 		}
 
-		path = get_full_path(path);
-
-		if (!fs::exists(path))
+		if (show_help || (path.empty() && directory.empty()))
 		{
-			std::cerr << "Could not find file '" << path << "'.\n";
-			return EXIT_FAILURE;
+			std::cout << cli;
+			return show_help ? EXIT_SUCCESS : EXIT_FAILURE;
 		}
 
-		std::string extension = path.extension().string();
-
-		fs::path cached_filename = path;
-		cached_filename.replace_extension("." + std::to_string(mesh_flag_default) + ".cache.bin");
-		fs::path cache_filepath = L"asset_cache" / cached_filename;
+		std::vector<fs::path> sources;
 
-		if (fs::exists(cache_filepath))
+		if (!path.empty())
 		{
-			auto last_cache_write_time = fs::last_write_time(cache_filepath);
-			auto last_original_write_time = fs::last_write_time(path);
+			path = resolve_input_path(path);
 
-			if (last_cache_write_time > last_original_write_time)
+			if (!fs::exists(path))
 			{
-				std::cout << "Asset is already compiled! \n";
-				return EXIT_SUCCESS;
+				std::cerr << "Could not find file '" << path << "'.\n";
+				return EXIT_FAILURE;
 			}
+
+			sources.push_back(path);
 		}
 
-		std::cout << "Preprocessing asset '" << path << "' for faster loading next time.\n";
+		if (!directory.empty())
+		{
+			directory = resolve_input_path(directory);
 
-		ModelAsset result_mesh;
+			if (!fs::is_directory(directory))
+			{
+				std::cerr << "Could not find directory '" << directory << "'.\n";
+				return EXIT_FAILURE;
+			}
 
-		std::transform(extension.begin(), extension.end(), extension.begin(),
-			[](char c) { return std::tolower(c); });
-		if (extension == ".fbx")
-		{
-			result_mesh = loadFBX(path, mesh_flag_default);
-		}
-		else if (extension == ".obj")
-		{
-			result_mesh = loadOBJ(path, mesh_flag_default);
+			for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory, fs::directory_options::skip_permission_denied))
+			{
+				if (entry.is_regular_file() && is_compilable_extension(entry.path()))
+				{
+					sources.push_back(entry.path());
+				}
+			}
 		}
 
-		fs::create_directories(cache_filepath.parent_path());
-		writeBIN(result_mesh, cache_filepath);
+		// Independent assets are compiled on the high priority queue. The FBX importer spreads its own work over the same queue.
+		initialize_job_system();
+
+		exit_code = compile_assets(sources, manifest_path, mesh_flag_default, force, verbose);
 	}
 	catch (const std::exception& ex)
 	{
@@ -82,9 +384,10 @@ int main(int argc, char** argv)
 		output << "Runtime Error>" << ex.what() << std::endl;
 		output.close();
 
-		std::this_thread::sleep_for(std::chrono::duration<float>(5000.0f));
-		return EXIT_FAILURE;
+		exit_code = EXIT_FAILURE;
 	}
 
-	return EXIT_SUCCESS;
-}
\ No newline at end of file
+	// Job system workers are never joined, so skip static destruction (which would wait for them on some platforms).
+	fflush(stdout);
+	std::quick_exit(exit_code);
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <animation/animation_clip.h>
+#include <animation/animation_clip_utils.h>
+#include <animation/skeleton.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 clip_num_joints = 64;
+    static constexpr uint32 num_instances = 256;
+
+    // Ten seconds at 30 Hz. Like real rigs, a part of the joints never moves and scale is constant everywhere.
+    static animation::ClipInfo create_clip_info()
+    {
+        using namespace animation;
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> phase(0.0f, M_TAU);
+        std::uniform_real_distribution<float> amplitude(0.05f, 0.6f);
+
+        ClipInfo info;
+        info.sample_rate = 30.0f;
+        info.num_samples = 301;
+
+        for (uint32 joint = 0; joint < clip_num_joints; ++joint)
+        {
+            TrackInfo& track = info.tracks.emplace_back();
+            track.joint_id = "joint_" + std::to_string(joint);
+            track.parent_index = joint == 0 ? INVALID_JOINT : (joint - 1) / 2;
+
+            const bool is_static = joint % 4 == 3;
+            const float phase0 = phase(rng);
+            const float phase1 = phase(rng);
+            const float amplitude0 = amplitude(rng);
+            const float amplitude1 = amplitude(rng);
+
+            for (uint32 sample = 0; sample < info.num_samples; ++sample)
+            {
+                const float t = is_static ? 0.0f : (float)sample / info.sample_rate;
+                const vec3 euler(amplitude0 * sinf(2.0f * t + phase0), amplitude1 * sinf(3.3f * t + phase1), 0.1f * sinf(0.7f * t));
+                const vec3 position = joint == 0 ? vec3(1.5f * t, 0.9f + 0.05f * sinf(6.0f * t), 0.0f) : vec3(0.0f, 0.2f, 0.0f);
+
+                track.joint_transforms.push_back(trs(position, euler_to_quat(euler), vec3(1.0f)));
+            }
+        }
+
+        return info;
+    }
+
+    ERA_BENCHMARK(AnimationClip, CompressedVsRaw)
+    {
+        using namespace animation;
+
+        const ClipInfo info = create_clip_info();
+
+        ref<AnimationAssetClip> raw = AnimationAssetClipUtils::make_clip(info);
+
+        ref<AnimationAssetClip> compressed;
+        report("compress (ACL, automatic level)", measure_with_setup(3, [&]()
+            {
+                compressed = AnimationAssetClipUtils::make_clip(info);
+            }, [&]()
+            {
+                compressed->compress();
+            }));
+
+        const double raw_kb = (double)raw->get_memory_footprint() / 1024.0;
+        const double compressed_kb = (double)compressed->get_memory_footprint() / 1024.0;
+        printf("  memory: raw %.1f KB, compressed %.1f KB (%.1fx smaller)\n", raw_kb, compressed_kb, raw_kb / compressed_kb);
+
+        // Every instance samples its own point in time, as a crowd playing the same clip would.
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> start_time(0.0f, raw->get_duration());
+
+        std::vector<float> times(num_instances);
+        for (float& time : times)
+        {
+            time = start_time(rng);
+        }
+
+        std::vector<SkeletonPose> poses(num_instances, SkeletonPose(clip_num_joints));
+        std::vector<AnimationClipSamplingContext> contexts(num_instances);
+
+        auto advance = [&]()
+            {
+                for (float& time : times)
+                {
+                    time = fmodf(time + 1.0f / 60.0f, raw->get_duration());
+                }
+            };
+
+        report("raw tracks", measure_with_setup(50, advance, [&]()
+            {
+                for (uint32 i = 0; i < num_instances; ++i)
+                {
+                    raw->sample_joints(times[i], poses[i]);
+                }
+            }), num_instances);
+
+        report("compressed, new context per call", measure_with_setup(50, advance, [&]()
+            {
+                for (uint32 i = 0; i < num_instances; ++i)
+                {
+                    compressed->sample_joints(times[i], poses[i]);
+                }
+            }), num_instances);
+
+        report("compressed, context reused across frames", measure_with_setup(50, advance, [&]()
+            {
+                for (uint32 i = 0; i < num_instances; ++i)
+                {
+                    compressed->sample_joints(contexts[i], times[i], poses[i], {});
+                }
+            }), num_instances);
+    }
+}
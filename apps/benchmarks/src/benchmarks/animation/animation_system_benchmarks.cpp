@@ -0,0 +1,191 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <animation/animation_clip.h>
+#include <animation/animation_clip_utils.h>
+#include <animation/animation_pose_sampler.h>
+#include <animation/skeleton.h>
+
+#include <core/frame_allocator.h>
+#include <core/job_system.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 crowd_num_joints = 64;
+    static constexpr uint32 crowd_size = 1000;
+
+    // Joints form a binary tree, parents always come before their children.
+    static uint32 get_crowd_parent(uint32 joint)
+    {
+        return joint == 0 ? INVALID_JOINT : (joint - 1) / 2;
+    }
+
+    // A one second loop at 30 Hz, every joint swings around its own axis.
+    static ref<animation::AnimationAssetClip> create_crowd_clip()
+    {
+        using namespace animation;
+
+        ClipInfo info;
+        info.sample_rate = 30.0f;
+        info.num_samples = 31;
+
+        for (uint32 joint = 0; joint < crowd_num_joints; ++joint)
+        {
+            TrackInfo& track = info.tracks.emplace_back();
+            track.joint_id = "joint_" + std::to_string(joint);
+            track.parent_index = get_crowd_parent(joint);
+
+            for (uint32 sample = 0; sample < info.num_samples; ++sample)
+            {
+                const float phase = M_TAU * (float)sample / (float)(info.num_samples - 1);
+                const vec3 euler(0.4f * sinf(phase + 0.3f * joint), 0.2f * cosf(phase + 0.7f * joint), 0.0f);
+                const vec3 position = joint == 0 ? vec3(0.0f, 0.9f + 0.03f * sinf(2.0f * phase), 0.0f) : vec3(0.0f, 0.15f, 0.0f);
+
+                track.joint_transforms.push_back(trs(position, euler_to_quat(euler), vec3(1.0f)));
+            }
+        }
+
+        ref<AnimationAssetClip> clip = AnimationAssetClipUtils::make_clip(info);
+        clip->compress();
+        return clip;
+    }
+
+    static ref<animation::Skeleton> create_crowd_skeleton()
+    {
+        using namespace animation;
+
+        ref<Skeleton> skeleton = make_ref<Skeleton>();
+        for (uint32 joint = 0; joint < crowd_num_joints; ++joint)
+        {
+            SkeletonJoint& skeleton_joint = skeleton->joints.emplace_back();
+            skeleton_joint.name = "joint_" + std::to_string(joint);
+            skeleton_joint.limb_type = limb_type_none;
+            skeleton_joint.parent_id = get_crowd_parent(joint);
+            skeleton_joint.bind_transform = mat4::identity;
+            skeleton_joint.inv_bind_transform = mat4::identity;
+
+            skeleton->local_transforms.emplace_back(trs::identity);
+            skeleton->name_to_joint_id[skeleton_joint.name] = joint;
+        }
+        return skeleton;
+    }
+
+    // The state AnimationSystem keeps per entity, minus the GPU side of skinning.
+    struct CrowdCharacter
+    {
+        ref<animation::Skeleton> skeleton;
+        animation::AnimationPoseSampler sampler;
+        animation::SkeletonPose pose;
+        float time = 0.0f;
+
+        std::vector<mat4> skinning_matrices;
+        trs* global_transforms = nullptr;
+    };
+
+    ERA_BENCHMARK(AnimationSystem, Crowd1000)
+    {
+        using namespace animation;
+
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        const ref<AnimationAssetClip> clip = create_crowd_clip();
+        const float duration = clip->get_duration();
+
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> start_time(0.0f, duration);
+
+        // Every character owns its skeleton, like entities with their own SkeletonComponent.
+        std::vector<CrowdCharacter> crowd(crowd_size);
+        for (CrowdCharacter& character : crowd)
+        {
+            character.skeleton = create_crowd_skeleton();
+            character.time = start_time(rng);
+            character.skinning_matrices.resize(crowd_num_joints);
+        }
+
+        printf(" %u characters, %u joints each\n", crowd_size, crowd_num_joints);
+
+        FrameAllocator allocator(MB(64), KB(64));
+        JointMappingCache joint_mapping_cache;
+
+        auto begin_frame = [&]()
+            {
+                allocator.begin_frame();
+                for (CrowdCharacter& character : crowd)
+                {
+                    character.time = fmodf(character.time + 1.0f / 60.0f, duration);
+                }
+            };
+
+        // What the update used to do: a new sampler (name lookups) and a new pose for every entity, every frame.
+        report("serial, sampler and pose rebuilt per frame", measure_with_setup(20, begin_frame, [&]()
+            {
+                for (CrowdCharacter& character : crowd)
+                {
+                    AnimationPoseSampler sampler;
+                    sampler.init(character.skeleton.get(), clip);
+
+                    SkeletonPose pose(crowd_num_joints);
+                    sampler.sample_pose(character.time, pose);
+                    character.skeleton->apply_pose(pose);
+                    character.pose = pose;
+
+                    std::vector<trs> global_transforms(crowd_num_joints);
+                    character.skeleton->get_skinning_matrices_from_local_transforms(global_transforms.data(), character.skinning_matrices.data());
+                }
+            }), crowd_size);
+
+        auto update_character = [&](CrowdCharacter& character)
+            {
+                if (character.sampler.get_animation() != clip || character.sampler.get_skeleton() != character.skeleton.get())
+                {
+                    ref<const std::vector<uint32>> joint_mapping = joint_mapping_cache.get_joint_mapping(character.skeleton, clip);
+                    character.sampler.init(character.skeleton.get(), clip, *joint_mapping);
+                }
+
+                if (character.pose.size() != crowd_num_joints)
+                {
+                    character.pose = SkeletonPose(crowd_num_joints);
+                }
+
+                character.sampler.sample_pose(character.time, character.pose);
+                character.skeleton->apply_pose(character.pose);
+
+                character.global_transforms = allocator.allocate<trs>(crowd_num_joints, FrameLifetime::TwoFrames);
+                character.skeleton->get_skinning_matrices_from_local_transforms(character.global_transforms, character.skinning_matrices.data());
+            };
+
+        report("serial, cached mapping and pooled buffers", measure_with_setup(20, begin_frame, [&]()
+            {
+                for (CrowdCharacter& character : crowd)
+                {
+                    update_character(character);
+                }
+            }), crowd_size);
+
+        for (uint32 grain : { 4u, 16u, 64u })
+        {
+            char label[96];
+            snprintf(label, sizeof(label), "parallel, %u characters per chunk, %u threads", grain, high_priority_job_queue.get_num_threads() + 1);
+
+            report(label, measure_with_setup(20, begin_frame, [&]()
+                {
+                    parallel_for(0, crowd_size, grain, [&](uint32 begin, uint32 end)
+                        {
+                            for (uint32 i = begin; i < end; ++i)
+                            {
+                                update_character(crowd[i]);
+                            }
+                        });
+                }), crowd_size);
+        }
+
+        printf("  %u cached joint mappings\n", joint_mapping_cache.size());
+    }
+}
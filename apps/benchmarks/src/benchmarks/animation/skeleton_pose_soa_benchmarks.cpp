@@ -0,0 +1,144 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <animation/skeleton.h>
+#include <animation/skeleton_pose_soa.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    // Few enough poses to stay in cache, like the poses of one character during its update.
+    static constexpr uint32 pose_num_instances = 16;
+
+    static trs create_random_transform(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> angle(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> offset(0.05f, 0.3f);
+
+        return trs(vec3(0.0f, offset(rng), 0.0f), euler_to_quat(vec3(angle(rng), angle(rng), angle(rng))), vec3(1.0f));
+    }
+
+    // Chains of four joints hanging off random earlier joints, close to what rigs with fingers and face joints look like.
+    static ref<animation::Skeleton> create_pose_skeleton(uint32 num_joints, std::mt19937& rng)
+    {
+        using namespace animation;
+
+        ref<Skeleton> skeleton = make_ref<Skeleton>();
+        for (uint32 joint = 0; joint < num_joints; ++joint)
+        {
+            SkeletonJoint& skeleton_joint = skeleton->joints.emplace_back();
+            skeleton_joint.name = "joint_" + std::to_string(joint);
+            skeleton_joint.limb_type = limb_type_none;
+            if (joint == 0)
+            {
+                skeleton_joint.parent_id = INVALID_JOINT;
+            }
+            else
+            {
+                skeleton_joint.parent_id = joint % 4 == 0 ? std::uniform_int_distribution<uint32>(0, joint - 1)(rng) : joint - 1;
+            }
+            skeleton_joint.inv_bind_transform = trs_to_mat4(create_random_transform(rng));
+            skeleton_joint.bind_transform = invert(skeleton_joint.inv_bind_transform);
+
+            skeleton->local_transforms.emplace_back(create_random_transform(rng));
+        }
+        return skeleton;
+    }
+
+    ERA_BENCHMARK(Animation, SoaPose)
+    {
+        using namespace animation;
+
+        std::mt19937 rng(13);
+
+        for (uint32 num_joints : { 50u, 150u, 500u })
+        {
+            ref<Skeleton> skeleton = create_pose_skeleton(num_joints, rng);
+            SoaSkeletonHierarchy hierarchy(*skeleton);
+
+            printf(" %u joints, %u poses, %.0f%% of the hierarchy lanes are padding\n", num_joints, pose_num_instances, hierarchy.get_padding_ratio() * 100.0f);
+
+            std::vector<std::vector<trs>> from(pose_num_instances);
+            std::vector<std::vector<trs>> to(pose_num_instances);
+            std::vector<std::vector<trs>> blended(pose_num_instances, std::vector<trs>(num_joints));
+
+            std::vector<SoaSkeletonPose> soa_from(pose_num_instances, SoaSkeletonPose(num_joints));
+            std::vector<SoaSkeletonPose> soa_to(pose_num_instances, SoaSkeletonPose(num_joints));
+            std::vector<SoaSkeletonPose> soa_blended(pose_num_instances, SoaSkeletonPose(num_joints));
+
+            for (uint32 i = 0; i < pose_num_instances; ++i)
+            {
+                for (uint32 joint = 0; joint < num_joints; ++joint)
+                {
+                    from[i].push_back(create_random_transform(rng));
+                    to[i].push_back(create_random_transform(rng));
+
+                    soa_from[i].set_joint_transform(from[i][joint], joint);
+                    soa_to[i].set_joint_transform(to[i][joint], joint);
+                }
+            }
+
+            report("  blend, scalar (Skeleton::blend_local_transforms)", measure(20, [&]()
+                {
+                    for (uint32 i = 0; i < pose_num_instances; ++i)
+                    {
+                        skeleton->blend_local_transforms(from[i].data(), to[i].data(), 0.4f, blended[i].data());
+                    }
+                }), pose_num_instances);
+
+            report("  blend, scalar slerp_shortest_approx", measure(20, [&]()
+                {
+                    for (uint32 i = 0; i < pose_num_instances; ++i)
+                    {
+                        for (uint32 joint = 0; joint < num_joints; ++joint)
+                        {
+                            const trs& a = from[i][joint];
+                            const trs& b = to[i][joint];
+                            blended[i][joint] = trs(lerp(a.position, b.position, 0.4f), slerp_shortest_approx(a.rotation, b.rotation, 0.4f), lerp(a.scale, b.scale, 0.4f));
+                        }
+                    }
+                }), pose_num_instances);
+
+            report("  blend, SoA nlerp", measure(20, [&]()
+                {
+                    for (uint32 i = 0; i < pose_num_instances; ++i)
+                    {
+                        SoaPoseUtils::blend_nlerp(soa_from[i], soa_to[i], 0.4f, soa_blended[i]);
+                    }
+                }), pose_num_instances);
+
+            report("  blend, SoA slerp", measure(20, [&]()
+                {
+                    for (uint32 i = 0; i < pose_num_instances; ++i)
+                    {
+                        SoaPoseUtils::blend_slerp(soa_from[i], soa_to[i], 0.4f, soa_blended[i]);
+                    }
+                }), pose_num_instances);
+
+            std::vector<trs> global_transforms(num_joints);
+            std::vector<mat4> skinning_matrices(num_joints);
+
+            report("  local to skinning matrices, scalar (pose applied to the skeleton)", measure(20, [&]()
+                {
+                    for (uint32 i = 0; i < pose_num_instances; ++i)
+                    {
+                        for (uint32 joint = 0; joint < num_joints; ++joint)
+                        {
+                            skeleton->local_transforms[joint].set_transform(from[i][joint]);
+                        }
+                        skeleton->get_skinning_matrices_from_local_transforms(global_transforms.data(), skinning_matrices.data());
+                    }
+                }), pose_num_instances);
+
+            report("  local to skinning matrices, SoA", measure(20, [&]()
+                {
+                    for (uint32 i = 0; i < pose_num_instances; ++i)
+                    {
+                        SoaPoseUtils::get_skinning_matrices(hierarchy, soa_from[i], global_transforms.data(), skinning_matrices.data());
+                    }
+                }), pose_num_instances);
+        }
+    }
+}
@@ -0,0 +1,294 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <asset/io.h>
+#include <asset/bin.h>
+#include <asset/deflate.h>
+#include <asset/model_asset.h>
+#include <core/job_system.h>
+
+#include <cstdlib>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace era_engine::benchmarks
+{
+    // Semicolon separated list of .fbx/.bin files, e.g. ERA_BENCHMARK_MODEL_FILES=assets/sponza.fbx;asset_cache/sponza.cache.bin
+    static std::vector<fs::path> get_model_files()
+    {
+        std::vector<fs::path> result;
+        if (const char* list = std::getenv("ERA_BENCHMARK_MODEL_FILES"))
+        {
+            std::stringstream stream(list);
+            std::string path;
+            while (std::getline(stream, path, ';'))
+            {
+                if (!path.empty() && fs::exists(path))
+                {
+                    result.push_back(path);
+                }
+            }
+        }
+        return result;
+    }
+
+    // Drops the file's pages from the OS file cache, so that the next read has to go to the disk.
+    static void evict_from_file_cache(const fs::path& path)
+    {
+#if defined(_WIN32)
+        // Opening a file unbuffered invalidates its cached pages.
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, 0);
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file);
+        }
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+#endif
+    }
+
+    // Reads one byte per page, so that mapped files are actually paged in.
+    static uint64 touch_pages(const EntireFile& file)
+    {
+        uint64 sum = 0;
+        for (uint64 offset = 0; offset < file.size; offset += 4096)
+        {
+            sum += file.content[offset];
+        }
+        return sum;
+    }
+
+    static ModelAsset import_model(const fs::path& path, bool parallel = true)
+    {
+        if (path.extension() == ".bin")
+        {
+            return loadBIN(path);
+        }
+        return loadFBX(path, mesh_flag_default, parallel);
+    }
+
+    ERA_BENCHMARK(AssetIO, LoadModelFiles)
+    {
+        const std::vector<fs::path> files = get_model_files();
+        if (files.empty())
+        {
+            printf(" skipped, set ERA_BENCHMARK_MODEL_FILES to a ';' separated list of .fbx/.bin files\n");
+            return;
+        }
+
+        // Imports run their parallel parts on the high priority queue.
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        uint64 sink = 0;
+
+        for (const fs::path& path : files)
+        {
+            const uint64 file_size = (uint64)fs::file_size(path);
+            const double megabytes = (double)file_size / (1024.0 * 1024.0);
+
+            printf(" %s (%.1f MB)\n", path.string().c_str(), megabytes);
+
+            auto cold = [&path]() { evict_from_file_cache(path); };
+            auto warm = []() {};
+
+            auto copy_whole_file = [&]()
+                {
+                    EntireFile file = load_file(path);
+                    sink += touch_pages(file);
+                    free_file(file);
+                };
+
+            auto map_whole_file = [&]()
+                {
+                    EntireFile file = map_file(path);
+                    sink += touch_pages(file);
+                    free_file(file);
+                };
+
+            auto import = [&]()
+                {
+                    ModelAsset asset = import_model(path);
+                    sink += asset.meshes.size();
+                };
+
+            // Throughput is reported in MB/s.
+            report("cold: load_file (malloc + fread)", measure_with_setup(3, cold, copy_whole_file), megabytes);
+            report("cold: map_file", measure_with_setup(3, cold, map_whole_file), megabytes);
+            report("cold: full import", measure_with_setup(3, cold, import), megabytes);
+
+            report("warm: load_file (malloc + fread)", measure_with_setup(5, warm, copy_whole_file), megabytes);
+            report("warm: map_file", measure_with_setup(5, warm, map_whole_file), megabytes);
+            report("warm: full import", measure_with_setup(5, warm, import), megabytes);
+
+            if (path.extension() == ".fbx")
+            {
+                auto serial_import = [&]()
+                    {
+                        ModelAsset asset = import_model(path, false);
+                        sink += asset.meshes.size();
+                    };
+
+                report("warm: full import (serial)", measure_with_setup(5, warm, serial_import), megabytes);
+            }
+        }
+
+        printf("  (checksum %llu)\n", (unsigned long long)sink);
+    }
+
+    struct FbxArrayBlob
+    {
+        const uint8* data;
+        uint32 compressed_size;
+        uint64 size;
+    };
+
+    // Walks the node records of a binary FBX file and collects all deflate compressed array properties.
+    static void collect_fbx_array_blobs(const EntireFile& file, uint64 offset, uint64 end, bool wide_records, std::vector<FbxArrayBlob>& out)
+    {
+        const uint64 record_header_size = wide_records ? 25 : 13;
+
+        auto read_uint = [&file](uint64 at, bool wide) -> uint64
+            {
+                uint64 value = 0;
+                memcpy(&value, file.content + at, wide ? 8 : 4);
+                return value;
+            };
+
+        while (offset + record_header_size <= end)
+        {
+            const uint64 end_offset = read_uint(offset, wide_records);
+            const uint64 num_properties = read_uint(offset + (wide_records ? 8 : 4), wide_records);
+            const uint64 property_list_size = read_uint(offset + (wide_records ? 16 : 8), wide_records);
+            const uint8 name_length = file.content[offset + record_header_size - 1];
+
+            // Null record terminates the list.
+            if (end_offset == 0 || end_offset <= offset || end_offset > end)
+            {
+                return;
+            }
+
+            uint64 property = offset + record_header_size + name_length;
+            const uint64 properties_end = property + property_list_size;
+            for (uint64 i = 0; i < num_properties && property < properties_end; ++i)
+            {
+                const char type = (char)file.content[property++];
+                switch (type)
+                {
+                    case 'C': property += 1; break;
+                    case 'Y': property += 2; break;
+                    case 'I': case 'F': property += 4; break;
+                    case 'D': case 'L': property += 8; break;
+                    case 'S': case 'R': property += 4 + read_uint(property, false); break;
+                    case 'f': case 'i': case 'd': case 'l': case 'b':
+                    {
+                        const uint64 num_elements = read_uint(property, false);
+                        const uint32 encoding = (uint32)read_uint(property + 4, false);
+                        const uint32 compressed_size = (uint32)read_uint(property + 8, false);
+                        const uint64 element_size = (type == 'b') ? 1 : (type == 'f' || type == 'i') ? 4 : 8;
+
+                        if (encoding == 1 && property + 12 + compressed_size <= properties_end)
+                        {
+                            out.push_back({ file.content + property + 12, compressed_size, num_elements * element_size });
+                        }
+                        property += 12 + compressed_size;
+                        break;
+                    }
+                    default: property = properties_end; break;
+                }
+            }
+
+            collect_fbx_array_blobs(file, properties_end, end_offset, wide_records, out);
+            offset = end_offset;
+        }
+    }
+
+    ERA_BENCHMARK(AssetIO, InflateFbxArrays)
+    {
+        std::vector<EntireFile> files;
+        std::vector<FbxArrayBlob> blobs;
+
+        for (const fs::path& path : get_model_files())
+        {
+            if (path.extension() != ".fbx")
+            {
+                continue;
+            }
+
+            EntireFile file = load_file(path);
+
+            // "Kaydara FBX Binary  \0", 2 unknown bytes, version.
+            if (file.size < 27 || memcmp(file.content, "Kaydara FBX Binary", 18) != 0)
+            {
+                free_file(file);
+                continue;
+            }
+
+            uint32 version = 0;
+            memcpy(&version, file.content + 23, sizeof(version));
+
+            collect_fbx_array_blobs(file, 27, file.size, version >= 7500, blobs);
+            files.push_back(file);
+        }
+
+        if (blobs.empty())
+        {
+            printf(" skipped, set ERA_BENCHMARK_MODEL_FILES to a ';' separated list of binary .fbx files\n");
+            return;
+        }
+
+        uint64 compressed_bytes = 0;
+        uint64 decompressed_bytes = 0;
+        uint64 largest_blob = 0;
+        for (const FbxArrayBlob& blob : blobs)
+        {
+            compressed_bytes += blob.compressed_size;
+            decompressed_bytes += blob.size;
+            largest_blob = max(largest_blob, blob.size);
+        }
+
+        printf(" %u compressed arrays, %.1f MB -> %.1f MB\n", (uint32)blobs.size(),
+            (double)compressed_bytes / (1024.0 * 1024.0), (double)decompressed_bytes / (1024.0 * 1024.0));
+
+        std::vector<uint8> output(largest_blob);
+        uint32 num_failed = 0;
+
+        auto inflate_all = [&]()
+            {
+                num_failed = 0;
+                for (const FbxArrayBlob& blob : blobs)
+                {
+                    if (decompress(blob.data, blob.compressed_size, output.data(), blob.size) != blob.size)
+                    {
+                        ++num_failed;
+                    }
+                }
+            };
+
+        // Throughput is reported in decompressed MB/s.
+        report("inflate", measure(10, inflate_all), (double)decompressed_bytes / (1024.0 * 1024.0));
+
+        if (num_failed > 0)
+        {
+            printf("  %u arrays failed to decompress\n", num_failed);
+        }
+
+        for (const EntireFile& file : files)
+        {
+            free_file(file);
+        }
+    }
+}
@@ -0,0 +1,206 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <asset/mesh_postprocessing.h>
+#include <core/job_system.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    // Unwelded quads of a jittered grid, in random order, the way importers hand them to per_material.
+    struct FaceSoup
+    {
+        std::vector<vec3> positions;
+        std::vector<vec2> uvs;
+        uint32 num_faces = 0;
+    };
+
+    static FaceSoup create_face_soup(uint32 quads_per_side, uint32 seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+
+        const uint32 side = quads_per_side + 1;
+        std::vector<float> heights(side * side);
+        for (float& h : heights)
+        {
+            h = jitter(rng);
+        }
+
+        std::vector<uint32> quads(quads_per_side * quads_per_side);
+        for (uint32 i = 0; i < (uint32)quads.size(); ++i)
+        {
+            quads[i] = i;
+        }
+        std::shuffle(quads.begin(), quads.end(), rng);
+
+        FaceSoup result;
+        result.num_faces = (uint32)quads.size();
+        result.positions.reserve(quads.size() * 4);
+        result.uvs.reserve(quads.size() * 4);
+
+        for (uint32 quad : quads)
+        {
+            const uint32 x = quad % quads_per_side;
+            const uint32 y = quad / quads_per_side;
+            const uint32 corners[4] = { y * side + x, y * side + x + 1, (y + 1) * side + x + 1, (y + 1) * side + x };
+
+            for (uint32 corner : corners)
+            {
+                const uint32 cx = corner % side;
+                const uint32 cy = corner / side;
+                result.positions.push_back(vec3((float)cx, heights[corner], (float)cy));
+                result.uvs.push_back(vec2((float)cx / quads_per_side, (float)cy / quads_per_side));
+            }
+        }
+        return result;
+    }
+
+    static SubmeshAsset weld(const FaceSoup& soup)
+    {
+        per_material material;
+        for (uint32 i = 0; i < soup.num_faces; ++i)
+        {
+            material.addTriangles(soup.positions, soup.uvs, {}, {}, {}, {}, i * 4, 4);
+        }
+
+        std::vector<SubmeshAsset> result;
+        material.flush(result);
+        return std::move(result[0]);
+    }
+
+    static uint64 get_num_triangles(const SubmeshAsset& submesh)
+    {
+        return submesh.triangles.size() + submesh.triangles32.size();
+    }
+
+    // Average cache miss ratio (transformed vertices per triangle) for a FIFO cache of 'cache_size' entries.
+    static double get_acmr(const SubmeshAsset& submesh, uint32 cache_size = 16)
+    {
+        std::vector<uint32> fifo(cache_size, UINT32_MAX);
+        uint32 head = 0;
+        uint64 misses = 0;
+
+        auto transform = [&](uint32 vertex)
+            {
+                if (std::find(fifo.begin(), fifo.end(), vertex) == fifo.end())
+                {
+                    fifo[head] = vertex;
+                    head = (head + 1) % cache_size;
+                    ++misses;
+                }
+            };
+
+        for (const indexed_triangle16& tri : submesh.triangles)
+        {
+            transform(tri.a); transform(tri.b); transform(tri.c);
+        }
+        for (const indexed_triangle32& tri : submesh.triangles32)
+        {
+            transform(tri.a); transform(tri.b); transform(tri.c);
+        }
+
+        const uint64 num_triangles = get_num_triangles(submesh);
+        return num_triangles ? (double)misses / (double)num_triangles : 0.0;
+    }
+
+    static void clear_generated(SubmeshAsset& submesh)
+    {
+        submesh.normals.clear();
+        submesh.tangents.clear();
+    }
+
+    ERA_BENCHMARK(MeshPostprocessing, OneMillionTriangles)
+    {
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        // 725^2 quads, just over 1M triangles. More than 65536 vertices, so the result uses 32-bit indices.
+        const FaceSoup soup = create_face_soup(725, 1);
+        const SubmeshAsset welded = weld(soup);
+        const double num_triangles = (double)get_num_triangles(welded);
+
+        printf(" %u vertices, %.0f triangles\n", (uint32)welded.positions.size(), num_triangles);
+
+        uint64 sink = 0;
+
+        report("weld (open addressing)", measure(3, [&]()
+            {
+                SubmeshAsset submesh = weld(soup);
+                sink += submesh.positions.size();
+            }), num_triangles);
+
+        std::vector<SubmeshAsset> submeshes;
+        auto reset = [&]()
+            {
+                submeshes.assign(1, welded);
+                clear_generated(submeshes[0]);
+            };
+
+        report("normals + tangents", measure_with_setup(5, reset, [&]()
+            {
+                generateNormalsAndTangents(submeshes, mesh_flag_default);
+            }), num_triangles);
+
+        report("vertex cache optimization", measure_with_setup(3, reset, [&]()
+            {
+                optimizeVertexCache(submeshes[0]);
+            }), num_triangles);
+
+        report("full postprocess", measure_with_setup(3, reset, [&]()
+            {
+                postprocessSubmeshes(submeshes, mesh_flag_default);
+            }), num_triangles);
+
+        printf("  ACMR (FIFO 16): %.3f before, %.3f after\n", get_acmr(welded), get_acmr(submeshes[0]));
+        printf("  (checksum %llu)\n", (unsigned long long)sink);
+    }
+
+    ERA_BENCHMARK(MeshPostprocessing, ManySubmeshes)
+    {
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        // Sixteen submeshes of 180^2 quads (~1M triangles in total), each small enough for 16-bit indices.
+        constexpr uint32 num_submeshes = 16;
+        std::vector<SubmeshAsset> welded;
+        for (uint32 i = 0; i < num_submeshes; ++i)
+        {
+            welded.push_back(weld(create_face_soup(180, i + 1)));
+        }
+
+        double num_triangles = 0.0;
+        for (const SubmeshAsset& submesh : welded)
+        {
+            num_triangles += (double)get_num_triangles(submesh);
+        }
+
+        printf(" %u submeshes, %.0f triangles\n", num_submeshes, num_triangles);
+
+        std::vector<SubmeshAsset> submeshes;
+        auto reset = [&]()
+            {
+                submeshes = welded;
+                for (SubmeshAsset& submesh : submeshes)
+                {
+                    clear_generated(submesh);
+                }
+            };
+
+        report("normals + tangents", measure_with_setup(5, reset, [&]()
+            {
+                generateNormalsAndTangents(submeshes, mesh_flag_default);
+            }), num_triangles);
+
+        report("full postprocess", measure_with_setup(3, reset, [&]()
+            {
+                postprocessSubmeshes(submeshes, mesh_flag_default);
+            }), num_triangles);
+    }
+}
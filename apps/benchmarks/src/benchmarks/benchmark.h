@@ -0,0 +1,102 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace era_engine::benchmarks
+{
+    using BenchmarkFunction = void (*)();
+
+    struct BenchmarkEntry
+    {
+        const char* group;
+        const char* name;
+        BenchmarkFunction function;
+    };
+
+    inline std::vector<BenchmarkEntry>& get_benchmarks()
+    {
+        static std::vector<BenchmarkEntry> benchmarks;
+        return benchmarks;
+    }
+
+    inline bool register_benchmark(const char* group, const char* name, BenchmarkFunction function)
+    {
+        get_benchmarks().push_back({ group, name, function });
+        return true;
+    }
+
+    struct BenchmarkStats
+    {
+        double min_ms = 0.0;
+        double median_ms = 0.0;
+        double mean_ms = 0.0;
+        uint32 iterations = 0;
+    };
+
+    // Runs one warm-up iteration and then 'iterations' timed ones. 'setup' runs before every iteration, outside of the timing.
+    template <typename Setup_, typename Func_>
+    BenchmarkStats measure_with_setup(uint32 iterations, Setup_&& setup, Func_&& func)
+    {
+        using clock = std::chrono::high_resolution_clock;
+
+        setup();
+        func();
+
+        std::vector<double> timings;
+        timings.reserve(iterations);
+
+        for (uint32 i = 0; i < iterations; ++i)
+        {
+            setup();
+
+            auto start = clock::now();
+            func();
+            auto end = clock::now();
+            timings.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        BenchmarkStats stats;
+        stats.iterations = iterations;
+        if (iterations > 0)
+        {
+            std::sort(timings.begin(), timings.end());
+            stats.min_ms = timings.front();
+            stats.median_ms = timings[timings.size() / 2];
+            for (double t : timings)
+            {
+                stats.mean_ms += t;
+            }
+            stats.mean_ms /= (double)iterations;
+        }
+        return stats;
+    }
+
+    // Runs one warm-up iteration and then 'iterations' timed ones.
+    template <typename Func_>
+    BenchmarkStats measure(uint32 iterations, Func_&& func)
+    {
+        return measure_with_setup(iterations, []() {}, func);
+    }
+
+    // Prints one result line. If 'items_per_iteration' is set, throughput is reported based on the median time.
+    inline void report(const char* label, const BenchmarkStats& stats, double items_per_iteration = 0.0)
+    {
+        printf("  %-48s min %10.3f ms | median %10.3f ms | mean %10.3f ms", label, stats.min_ms, stats.median_ms, stats.mean_ms);
+        if (items_per_iteration > 0.0 && stats.median_ms > 0.0)
+        {
+            printf(" | %12.0f items/s", items_per_iteration / (stats.median_ms * 1e-3));
+        }
+        printf("\n");
+    }
+}
+
+// Usage mirrors gtest's TEST(group, name).
+#define ERA_BENCHMARK(group_, name_) \
+    static void benchmark_##group_##_##name_(); \
+    static const bool benchmark_registered_##group_##_##name_ = ::era_engine::benchmarks::register_benchmark(#group_, #name_, &benchmark_##group_##_##name_); \
+    static void benchmark_##group_##_##name_()
@@ -0,0 +1,234 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <core/block_allocator.h>
+
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    // The previous BlockAllocator: best fit over a std::map by offset and a std::multimap by size.
+    // Kept here as the baseline, with the prev/next aliasing in free() fixed so that it coalesces correctly.
+    class MapBlockAllocator
+    {
+    public:
+        void initialize(uint64 capacity)
+        {
+            blocks_by_offset.clear();
+            blocks_by_size.clear();
+            available_size = capacity;
+            add_new_block(0, capacity);
+        }
+
+        uint64 allocate(uint64 requested_size)
+        {
+            auto smallest_block_it = blocks_by_size.lower_bound(requested_size);
+            if (smallest_block_it == blocks_by_size.end())
+            {
+                return UINT64_MAX;
+            }
+
+            const uint64 offset = smallest_block_it->second.offset_iterator->first;
+            const uint64 size = smallest_block_it->first;
+
+            blocks_by_offset.erase(smallest_block_it->second.offset_iterator);
+            blocks_by_size.erase(smallest_block_it);
+
+            if (size > requested_size)
+            {
+                add_new_block(offset + requested_size, size - requested_size);
+            }
+
+            available_size -= requested_size;
+            return offset;
+        }
+
+        void free(uint64 offset, uint64 size)
+        {
+            uint64 new_offset = offset;
+            uint64 new_size = size;
+
+            auto next_block_it = blocks_by_offset.upper_bound(offset);
+            if (next_block_it != blocks_by_offset.begin())
+            {
+                auto prev_block_it = std::prev(next_block_it);
+                const uint64 prev_size = prev_block_it->second.size_iterator->first;
+                if (prev_block_it->first + prev_size == offset)
+                {
+                    new_offset = prev_block_it->first;
+                    new_size += prev_size;
+                    blocks_by_size.erase(prev_block_it->second.size_iterator);
+                    blocks_by_offset.erase(prev_block_it);
+                }
+            }
+
+            if (next_block_it != blocks_by_offset.end() && offset + size == next_block_it->first)
+            {
+                new_size += next_block_it->second.size_iterator->first;
+                blocks_by_size.erase(next_block_it->second.size_iterator);
+                blocks_by_offset.erase(next_block_it);
+            }
+
+            add_new_block(new_offset, new_size);
+            available_size += size;
+        }
+
+        uint64 get_largest_free_block() const
+        {
+            return blocks_by_size.empty() ? 0 : blocks_by_size.rbegin()->first;
+        }
+
+        uint32 get_num_free_blocks() const
+        {
+            return (uint32)blocks_by_offset.size();
+        }
+
+        uint64 available_size = 0;
+
+    private:
+        struct OffsetValue;
+        struct SizeValue;
+
+        using BlockByOffsetMap = std::map<uint64, OffsetValue>;
+        using BlockBySizeMap = std::multimap<uint64, SizeValue>;
+
+        struct OffsetValue
+        {
+            BlockBySizeMap::iterator size_iterator;
+        };
+
+        struct SizeValue
+        {
+            BlockByOffsetMap::iterator offset_iterator;
+        };
+
+        void add_new_block(uint64 offset, uint64 size)
+        {
+            auto offset_it = blocks_by_offset.emplace(offset, OffsetValue()).first;
+            offset_it->second.size_iterator = blocks_by_size.emplace(size, SizeValue{ offset_it });
+        }
+
+        BlockByOffsetMap blocks_by_offset;
+        BlockBySizeMap blocks_by_size;
+    };
+
+    struct TraceOperation
+    {
+        uint32 slot;
+        uint64 size; // 0 -> free the slot.
+    };
+
+    static constexpr uint64 trace_capacity = 1ull << 22;
+    static constexpr uint32 trace_num_slots = 4096;
+    static constexpr uint32 trace_length = 1000000;
+
+    // Randomized alloc/free trace over a fixed number of live slots. Sizes are log-uniform between 1 and 4096,
+    // i.e. mostly small descriptor ranges with the occasional large buffer. About a quarter of the capacity stays in use.
+    static const std::vector<TraceOperation>& get_allocation_trace()
+    {
+        static std::vector<TraceOperation> trace;
+        if (trace.empty())
+        {
+            std::mt19937 rng(1234);
+            std::uniform_int_distribution<uint32> slot_distribution(0, trace_num_slots - 1);
+            std::uniform_real_distribution<double> log_size_distribution(0.0, 12.0);
+
+            std::vector<bool> live(trace_num_slots, false);
+            trace.reserve(trace_length);
+            for (uint32 i = 0; i < trace_length; ++i)
+            {
+                const uint32 slot = slot_distribution(rng);
+                if (live[slot])
+                {
+                    trace.push_back({ slot, 0 });
+                }
+                else
+                {
+                    trace.push_back({ slot, (uint64)std::exp2(log_size_distribution(rng)) });
+                }
+                live[slot] = !live[slot];
+            }
+        }
+        return trace;
+    }
+
+    struct TraceResult
+    {
+        uint32 failed_allocations = 0;
+        uint64 available_size = 0;
+        uint64 largest_free_block = 0;
+        uint32 num_free_blocks = 0;
+    };
+
+    template <typename Allocator_>
+    static TraceResult replay_trace(Allocator_& allocator)
+    {
+        const std::vector<TraceOperation>& trace = get_allocation_trace();
+
+        allocator.initialize(trace_capacity);
+
+        std::vector<uint64> offsets(trace_num_slots, UINT64_MAX);
+        std::vector<uint64> sizes(trace_num_slots, 0);
+
+        TraceResult result;
+        for (const TraceOperation& operation : trace)
+        {
+            if (operation.size == 0)
+            {
+                if (offsets[operation.slot] != UINT64_MAX)
+                {
+                    allocator.free(offsets[operation.slot], sizes[operation.slot]);
+                    offsets[operation.slot] = UINT64_MAX;
+                }
+            }
+            else
+            {
+                offsets[operation.slot] = allocator.allocate(operation.size);
+                sizes[operation.slot] = operation.size;
+                if (offsets[operation.slot] == UINT64_MAX)
+                {
+                    ++result.failed_allocations;
+                }
+            }
+        }
+
+        result.available_size = allocator.available_size;
+        result.largest_free_block = allocator.get_largest_free_block();
+        result.num_free_blocks = allocator.get_num_free_blocks();
+        return result;
+    }
+
+    static void print_fragmentation(const char* name, const TraceResult& result)
+    {
+        // 0 means all free space is one contiguous range.
+        const double fragmentation = (result.available_size > 0)
+            ? 1.0 - (double)result.largest_free_block / (double)result.available_size
+            : 0.0;
+
+        printf("  %-48s free %8llu | largest %8llu | %6u free ranges | fragmentation %.3f | %u failed allocations\n",
+            name, (unsigned long long)result.available_size, (unsigned long long)result.largest_free_block,
+            result.num_free_blocks, fragmentation, result.failed_allocations);
+    }
+
+    ERA_BENCHMARK(BlockAllocator, RandomTrace)
+    {
+        const double num_operations = (double)get_allocation_trace().size();
+
+        printf(" %u operations, %u live slots, capacity %llu\n", trace_length, trace_num_slots, (unsigned long long)trace_capacity);
+
+        MapBlockAllocator map_allocator;
+        BlockAllocator tlsf_allocator;
+
+        TraceResult map_result;
+        TraceResult tlsf_result;
+
+        report("std::map/multimap best fit", measure(5, [&]() { map_result = replay_trace(map_allocator); }), num_operations);
+        report("TLSF", measure(5, [&]() { tlsf_result = replay_trace(tlsf_allocator); }), num_operations);
+
+        print_fragmentation("std::map/multimap best fit", map_result);
+        print_fragmentation("TLSF", tlsf_result);
+    }
+}
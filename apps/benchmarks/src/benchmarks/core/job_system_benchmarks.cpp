@@ -0,0 +1,119 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <core/job_system.h>
+
+namespace era_engine::benchmarks
+{
+    static JobQueue shared_queue;
+    static JobQueue work_stealing_queue;
+
+    struct FanOutJobData
+    {
+        JobQueue* queue;
+        std::atomic<uint64>* sink;
+        uint32 fan_out;
+        uint32 depth;
+        uint32 work_per_leaf;
+    };
+
+    static void burn(uint32 work, std::atomic<uint64>* sink)
+    {
+        uint64 x = work;
+        for (uint32 i = 0; i < work; ++i)
+        {
+            x = x * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        sink->fetch_add(x & 1, std::memory_order_relaxed);
+    }
+
+    static void fan_out_job(FanOutJobData& data, JobHandle job)
+    {
+        if (data.depth == 0)
+        {
+            burn(data.work_per_leaf, data.sink);
+            return;
+        }
+
+        FanOutJobData child = data;
+        --child.depth;
+        for (uint32 i = 0; i < data.fan_out; ++i)
+        {
+            data.queue->createJob<FanOutJobData>(fan_out_job, child, job).submit_now();
+        }
+    }
+
+    // Root -> fan_out children -> fan_out^2 leaves, joined by a continuation that runs after the whole tree.
+    static void run_fan_out_fan_in(JobQueue& queue, uint32 fan_out, uint32 depth, uint32 work_per_leaf)
+    {
+        std::atomic<uint64> sink = 0;
+
+        FanOutJobData data = { &queue, &sink, fan_out, depth, work_per_leaf };
+        JobHandle root = queue.createJob<FanOutJobData>(fan_out_job, data);
+
+        JobHandle join = queue.createJob<FanOutJobData>([](FanOutJobData& data, JobHandle)
+            {
+                data.sink->fetch_add(1, std::memory_order_relaxed);
+            }, data);
+
+        root.submit_now();
+        join.submit_after(root);
+        join.wait_for_completion();
+    }
+
+    static void initialize_queues()
+    {
+        static bool initialized = false;
+        if (!initialized)
+        {
+            const uint32 num_threads = max(1u, get_hardware_thread_count() - 1);
+            shared_queue.initialize(num_threads, 1, ThreadPriority::Normal, L"Benchmark shared worker", JobQueueMode::Shared);
+            work_stealing_queue.initialize(num_threads, 1, ThreadPriority::Normal, L"Benchmark stealing worker", JobQueueMode::WorkStealing);
+            initialized = true;
+
+            printf("  %u worker threads per queue\n", num_threads);
+        }
+    }
+
+    ERA_BENCHMARK(JobSystem, FanOutFanIn)
+    {
+        initialize_queues();
+
+        struct Config
+        {
+            const char* name;
+            uint32 fan_out;
+            uint32 depth;
+            uint32 work_per_leaf;
+        };
+
+        const Config configs[] =
+        {
+            { "fine (32x32 leaves, 64 iterations)", 32, 2, 64 },
+            { "medium (32x32 leaves, 4k iterations)", 32, 2, 4096 },
+            { "coarse (16x16 leaves, 64k iterations)", 16, 2, 65536 },
+            { "wide (2048 leaves, 256 iterations)", 2048, 1, 256 },
+            { "burst (64x256 leaves, 64 iterations)", 64, 2, 64 },
+        };
+
+        for (const Config& config : configs)
+        {
+            double num_jobs = 1.0;
+            double level = 1.0;
+            for (uint32 i = 0; i < config.depth; ++i)
+            {
+                level *= config.fan_out;
+                num_jobs += level;
+            }
+
+            printf(" %s\n", config.name);
+
+            BenchmarkStats shared_stats = measure(50, [&]() { run_fan_out_fan_in(shared_queue, config.fan_out, config.depth, config.work_per_leaf); });
+            report("shared queue", shared_stats, num_jobs);
+
+            BenchmarkStats stealing_stats = measure(50, [&]() { run_fan_out_fan_in(work_stealing_queue, config.fan_out, config.depth, config.work_per_leaf); });
+            report("work stealing", stealing_stats, num_jobs);
+        }
+    }
+}
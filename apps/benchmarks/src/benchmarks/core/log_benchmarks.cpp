@@ -0,0 +1,164 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <core/log.h>
+
+#include <atomic>
+#include <cstdarg>
+#include <thread>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 log_messages_per_thread = 1000;
+    static constexpr uint32 log_iterations = 10;
+
+    // The previous logger: one global mutex, vsnprintf into a shared arena on the calling thread. Kept as the baseline.
+    class SynchronousLog
+    {
+    public:
+        SynchronousLog()
+        {
+            arena.resize(MB(64));
+        }
+
+        void log_message(MessageType type, const char* format, ...)
+        {
+            std::lock_guard lock{ mutex };
+            if (arena_offset + KB(1) > arena.size())
+            {
+                arena_offset = 0;
+                messages.clear();
+            }
+
+            char* buffer = arena.data() + arena_offset;
+
+            va_list args;
+            va_start(args, format);
+            int count_written = vsnprintf(buffer, KB(1), format, args);
+            va_end(args);
+
+            messages.push_back({ buffer, type });
+            arena_offset += count_written + 1;
+        }
+
+    private:
+        struct Message
+        {
+            const char* text;
+            MessageType type;
+        };
+
+        std::mutex mutex;
+        std::vector<char> arena;
+        uint64 arena_offset = 0;
+        std::vector<Message> messages;
+    };
+
+    // Formats and drops everything, so only the cost of the log thread itself competes with the callers.
+    class NullLogSink final : public LogSink
+    {
+    public:
+        void write(const LogRecord& record) override
+        {
+            written.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64> written = 0;
+    };
+
+    // Runs 'num_threads' threads that start together and each log 'log_messages_per_thread' messages. Returns the
+    // per call time on the calling threads, median and slowest thread, in nanoseconds.
+    template <typename Log_>
+    static std::pair<double, double> measure_log_calls(uint32 num_threads, Log_&& log)
+    {
+        using clock = std::chrono::high_resolution_clock;
+
+        std::vector<double> thread_ns(num_threads);
+        std::atomic<uint32> ready = 0;
+
+        std::vector<std::thread> threads;
+        for (uint32 thread_index = 0; thread_index < num_threads; ++thread_index)
+        {
+            threads.emplace_back([&, thread_index]()
+                {
+                    ready.fetch_add(1);
+                    while (ready.load() < num_threads)
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    auto start = clock::now();
+                    for (uint32 i = 0; i < log_messages_per_thread; ++i)
+                    {
+                        log(thread_index, i);
+                    }
+                    thread_ns[thread_index] = std::chrono::duration<double, std::nano>(clock::now() - start).count() / log_messages_per_thread;
+                });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::sort(thread_ns.begin(), thread_ns.end());
+        return { thread_ns[thread_ns.size() / 2], thread_ns.back() };
+    }
+
+    template <typename Log_, typename After_>
+    static void report_log_calls(const char* label, uint32 num_threads, Log_&& log, After_&& after_iteration)
+    {
+        std::vector<double> median_ns;
+        std::vector<double> slowest_ns;
+        for (uint32 iteration = 0; iteration < log_iterations + 1; ++iteration)
+        {
+            auto [median, slowest] = measure_log_calls(num_threads, log);
+            after_iteration();
+
+            // First iteration is the warm-up, it also registers the threads' rings.
+            if (iteration > 0)
+            {
+                median_ns.push_back(median);
+                slowest_ns.push_back(slowest);
+            }
+        }
+
+        std::sort(median_ns.begin(), median_ns.end());
+        std::sort(slowest_ns.begin(), slowest_ns.end());
+        printf("  %-48s median thread %8.1f ns/call | slowest thread %8.1f ns/call\n", label, median_ns[median_ns.size() / 2], slowest_ns[slowest_ns.size() / 2]);
+    }
+
+    ERA_BENCHMARK(Log, CallingThreadCost)
+    {
+        ref<NullLogSink> null_sink = make_ref<NullLogSink>();
+        clear_log_sinks();
+        add_log_sink(null_sink);
+
+        // Errors always block and LOG_MESSAGE could drop, blocking shows the cost without dropped messages.
+        set_log_overflow_policy(LogOverflowPolicy::BLOCK);
+
+        SynchronousLog synchronous_log;
+
+        for (uint32 num_threads : { 1u, 4u, 16u })
+        {
+            printf(" %u threads, %u messages per thread\n", num_threads, log_messages_per_thread);
+
+            report_log_calls("  mutex + vsnprintf", num_threads, [&](uint32 thread_index, uint32 i)
+                {
+                    synchronous_log.log_message(message_type_warning, "Physics> contact %u between '%s' and body %u, impulse %.3f",
+                        i, "Ragdoll_Pelvis", thread_index, 0.25f * i);
+                }, []() {});
+
+            report_log_calls("  async ring buffer", num_threads, [&](uint32 thread_index, uint32 i)
+                {
+                    log_message(message_type_warning, "Physics> contact %u between '%s' and body %u, impulse %.3f",
+                        i, "Ragdoll_Pelvis", thread_index, 0.25f * i);
+                }, []() { log_flush(); });
+        }
+
+        printf(" %llu records formatted, %llu dropped\n", (unsigned long long)null_sink->written.load(), (unsigned long long)get_num_dropped_log_messages());
+
+        set_log_overflow_policy(LogOverflowPolicy::DROP);
+    }
+}
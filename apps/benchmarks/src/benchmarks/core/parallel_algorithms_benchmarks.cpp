@@ -0,0 +1,139 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <core/job_system.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    // One queue per thread count: 0 (everything inline), 1, 2, 4, ... up to all hardware threads but the caller's.
+    // The caller helps in parallel_*, so 'n' workers means n + 1 threads doing work.
+    static std::vector<JobQueue*>& get_scaling_queues()
+    {
+        static std::vector<JobQueue*> queues;
+        if (queues.empty())
+        {
+            const uint32 max_workers = get_hardware_thread_count() - 1;
+
+            std::vector<uint32> worker_counts = { 0 };
+            for (uint32 count = 1; count < max_workers; count *= 2)
+            {
+                worker_counts.push_back(count);
+            }
+            if (max_workers > 0)
+            {
+                worker_counts.push_back(max_workers);
+            }
+
+            for (uint32 count : worker_counts)
+            {
+                // Workers never stop, so the queues live until the process exits.
+                JobQueue* queue = new JobQueue();
+                queue->initialize(count, 1, ThreadPriority::Normal, L"Benchmark scaling worker", JobQueueMode::WorkStealing);
+                queues.push_back(queue);
+            }
+        }
+        return queues;
+    }
+
+    template <typename Func_>
+    static void run_scaling(const char* name, uint32 iterations, double items, const Func_& func)
+    {
+        printf(" %s\n", name);
+
+        double single_threaded_ms = 0.0;
+        for (JobQueue* queue : get_scaling_queues())
+        {
+            BenchmarkStats stats = measure(iterations, [&]() { func(*queue); });
+
+            if (queue->get_num_threads() == 0)
+            {
+                single_threaded_ms = stats.median_ms;
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "%u threads (speedup %.2fx)", queue->get_num_threads() + 1,
+                (stats.median_ms > 0.0) ? single_threaded_ms / stats.median_ms : 0.0);
+            report(label, stats, items);
+        }
+    }
+
+    ERA_BENCHMARK(ParallelAlgorithms, ParallelFor)
+    {
+        constexpr uint32 count = 1 << 22;
+        std::vector<float> values(count, 1.0f);
+
+        run_scaling("parallel_for, 4M elements, light per-element work", 20, count, [&](JobQueue& queue)
+            {
+                parallel_for(0, count, 4096, [&](uint32 begin, uint32 end)
+                    {
+                        for (uint32 i = begin; i < end; ++i)
+                        {
+                            values[i] = values[i] * 0.999f + 0.001f;
+                        }
+                    }, queue);
+            });
+
+        run_scaling("parallel_for, 64k elements, heavy per-element work", 20, 65536, [&](JobQueue& queue)
+            {
+                parallel_for(0, 65536, 64, [&](uint32 begin, uint32 end)
+                    {
+                        for (uint32 i = begin; i < end; ++i)
+                        {
+                            float x = values[i];
+                            for (uint32 j = 0; j < 256; ++j)
+                            {
+                                x = x * 0.999f + 0.001f;
+                            }
+                            values[i] = x;
+                        }
+                    }, queue);
+            });
+    }
+
+    ERA_BENCHMARK(ParallelAlgorithms, ParallelReduce)
+    {
+        constexpr uint32 count = 1 << 24;
+        std::vector<float> values(count);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            values[i] = (float)(i & 1023) * 0.001f;
+        }
+
+        double result = 0.0;
+        run_scaling("parallel_reduce, sum of 16M floats", 20, count, [&](JobQueue& queue)
+            {
+                result = parallel_reduce(0, count, 16384, 0.0,
+                    [&](uint32 begin, uint32 end, double sum)
+                    {
+                        for (uint32 i = begin; i < end; ++i)
+                        {
+                            sum += values[i];
+                        }
+                        return sum;
+                    },
+                    [](double a, double b) { return a + b; }, queue);
+            });
+        printf("  (result %f)\n", result);
+    }
+
+    ERA_BENCHMARK(ParallelAlgorithms, ParallelSort)
+    {
+        constexpr uint32 count = 1 << 22;
+        std::vector<uint64> source(count);
+        std::mt19937_64 rng(42);
+        for (uint64& value : source)
+        {
+            value = rng();
+        }
+
+        std::vector<uint64> values;
+        run_scaling("parallel_sort, 4M random uint64 (includes copy)", 5, count, [&](JobQueue& queue)
+            {
+                values = source;
+                parallel_sort(values.begin(), values.end(), std::less<>{}, 16384, queue);
+            });
+    }
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <core/cpu_profiling.h>
+
+#include <atomic>
+#include <thread>
+
+#if ENABLE_CPU_PROFILING
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 profile_blocks_per_thread = 1000;
+    static constexpr uint32 profile_iterations = 10;
+
+    // The previous recorder: one shared index into global arrays, a second shared counter marking events as written and the
+    // OS performance counter as the clock. Kept as the baseline.
+    class SharedArrayProfiler
+    {
+    public:
+        SharedArrayProfiler()
+        {
+            events.resize(MAX_NUM_CPU_PROFILE_EVENTS);
+        }
+
+        void record(ProfileEventType type, const char* name)
+        {
+            uint32 event_index = index++;
+            ASSERT(event_index < MAX_NUM_CPU_PROFILE_EVENTS);
+
+            ProfileEvent* e = events.data() + event_index;
+            e->thread_id = get_thread_id_fast();
+            e->name = name;
+            e->type = type;
+            e->timestamp = get_os_timestamp();
+            completely_written.fetch_add(1, std::memory_order_release);
+        }
+
+        void reset()
+        {
+            index = 0;
+            completely_written = 0;
+        }
+
+    private:
+        static uint64 get_os_timestamp()
+        {
+#if defined(_WIN32)
+            LARGE_INTEGER counter;
+            QueryPerformanceCounter(&counter);
+            return (uint64)counter.QuadPart;
+#else
+            timespec time;
+            clock_gettime(CLOCK_MONOTONIC, &time);
+            return (uint64)time.tv_sec * 1000000000ull + (uint64)time.tv_nsec;
+#endif
+        }
+
+        std::vector<ProfileEvent> events;
+        std::atomic<uint32> index = 0;
+        std::atomic<uint32> completely_written = 0;
+    };
+
+    // Runs 'num_threads' threads that start together and each record 'profile_blocks_per_thread' blocks. Returns the
+    // per block (begin + end) time on the calling threads, median and slowest thread, in nanoseconds.
+    template <typename Record_>
+    static std::pair<double, double> measure_profile_blocks(uint32 num_threads, Record_&& record)
+    {
+        using clock = std::chrono::high_resolution_clock;
+
+        std::vector<double> thread_ns(num_threads);
+        std::atomic<uint32> ready = 0;
+
+        std::vector<std::thread> threads;
+        for (uint32 thread_index = 0; thread_index < num_threads; ++thread_index)
+        {
+            threads.emplace_back([&, thread_index]()
+                {
+                    ready.fetch_add(1);
+                    while (ready.load() < num_threads)
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    auto start = clock::now();
+                    for (uint32 i = 0; i < profile_blocks_per_thread; ++i)
+                    {
+                        record(profile_event_begin_block, "Benchmark block");
+                        record(profile_event_end_block, "Benchmark block");
+                    }
+                    thread_ns[thread_index] = std::chrono::duration<double, std::nano>(clock::now() - start).count() / profile_blocks_per_thread;
+                });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::sort(thread_ns.begin(), thread_ns.end());
+        return { thread_ns[thread_ns.size() / 2], thread_ns.back() };
+    }
+
+    template <typename Record_, typename After_>
+    static void report_profile_blocks(const char* label, uint32 num_threads, Record_&& record, After_&& after_iteration)
+    {
+        std::vector<double> median_ns;
+        std::vector<double> slowest_ns;
+        for (uint32 iteration = 0; iteration < profile_iterations + 1; ++iteration)
+        {
+            auto [median, slowest] = measure_profile_blocks(num_threads, record);
+            after_iteration();
+
+            // First iteration is the warm-up.
+            if (iteration > 0)
+            {
+                median_ns.push_back(median);
+                slowest_ns.push_back(slowest);
+            }
+        }
+
+        std::sort(median_ns.begin(), median_ns.end());
+        std::sort(slowest_ns.begin(), slowest_ns.end());
+        printf("  %-48s median thread %8.1f ns/block | slowest thread %8.1f ns/block\n", label, median_ns[median_ns.size() / 2], slowest_ns[slowest_ns.size() / 2]);
+    }
+
+    ERA_BENCHMARK(Profiling, RecordBlock)
+    {
+        SharedArrayProfiler shared_array_profiler;
+
+        const uint64 dropped_before = get_num_dropped_cpu_profile_events();
+
+        // 16 threads * 1000 blocks fit into one resolve, so nothing is carried over between iterations.
+        for (uint32 num_threads : { 1u, 4u, 16u })
+        {
+            printf(" %u threads, %u blocks per thread\n", num_threads, profile_blocks_per_thread);
+
+            report_profile_blocks("  shared index + performance counter", num_threads, [&](ProfileEventType type, const char* name)
+                {
+                    shared_array_profiler.record(type, name);
+                }, [&]() { shared_array_profiler.reset(); });
+
+            report_profile_blocks("  per-thread ring + rdtsc", num_threads, [](ProfileEventType type, const char* name)
+                {
+                    record_cpu_profile_event(type, name);
+                }, []()
+                {
+                    cpu_profiling_frame_end_marker();
+                    cpu_profiling_resolve_time_stamps();
+                });
+        }
+
+        printf(" %llu events dropped\n", (unsigned long long)(get_num_dropped_cpu_profile_events() - dropped_before));
+    }
+}
+
+#endif
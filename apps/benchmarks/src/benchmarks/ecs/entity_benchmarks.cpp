@@ -0,0 +1,80 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <ecs/world.h>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 num_entities = 1000000;
+    static constexpr uint32 num_children_per_parent = 16;
+
+    ERA_BENCHMARK(Entities, CreateReparentDestroy)
+    {
+        World* world = new World("EntityBenchmarkWorld");
+        world->init();
+
+        std::vector<Entity::Handle> handles;
+        handles.reserve(num_entities);
+
+        uint64 sink = 0;
+
+        printf(" %u entities, %u children per parent\n", num_entities, num_children_per_parent);
+
+        // Each iteration runs on a fresh set of entities, so creation measures slot reuse after the first round.
+        report("create", measure(3, [&]()
+            {
+                if (!handles.empty())
+                {
+                    for (auto iter = handles.rbegin(); iter != handles.rend(); ++iter)
+                    {
+                        world->destroy_entity(*iter, false);
+                    }
+                    handles.clear();
+                }
+
+                for (uint32 i = 0; i < num_entities; ++i)
+                {
+                    handles.push_back(world->create_entity().get_handle());
+                }
+            }), (double)num_entities);
+
+        report("reparent (root -> tree -> root)", measure(3, [&]()
+            {
+                for (uint32 i = 1; i < num_entities; ++i)
+                {
+                    world->get_entity(handles[i]).set_parent(handles[(i - 1) / num_children_per_parent]);
+                }
+                for (uint32 i = 1; i < num_entities; ++i)
+                {
+                    world->get_entity(handles[i]).set_parent(world->get_root_handle());
+                }
+            }), 2.0 * (double)(num_entities - 1));
+
+        report("get_entity", measure(10, [&]()
+            {
+                for (const Entity::Handle handle : handles)
+                {
+                    sink += (uint64)world->get_entity(handle).get_parent_handle();
+                }
+            }), (double)num_entities);
+
+        report("create + destroy", measure(3, [&]()
+            {
+                for (auto iter = handles.rbegin(); iter != handles.rend(); ++iter)
+                {
+                    world->destroy_entity(*iter, false);
+                }
+                handles.clear();
+
+                for (uint32 i = 0; i < num_entities; ++i)
+                {
+                    handles.push_back(world->create_entity().get_handle());
+                }
+            }), 2.0 * (double)num_entities);
+
+        printf("  (checksum %llu)\n", (unsigned long long)sink);
+
+        delete world;
+    }
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <ecs/world.h>
+#include <ecs/base_components/transform_component.h>
+#include <ecs/base_components/transform_hierarchy.h>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 hierarchy_depth = 8;
+    static constexpr uint32 num_chains = 100000 / hierarchy_depth;
+
+    struct TransformScene
+    {
+        World* world = nullptr;
+        std::vector<Entity> roots;
+        std::vector<Entity> entities;
+    };
+
+    // 100k entities as 12.5k chains of depth 8, roughly the shape of many small skeletons.
+    static TransformScene& get_transform_scene()
+    {
+        static TransformScene scene;
+        if (scene.world == nullptr)
+        {
+            scene.world = new World("TransformBenchmarkWorld");
+            scene.world->init();
+
+            scene.entities.reserve(num_chains * hierarchy_depth);
+            for (uint32 chain = 0; chain < num_chains; ++chain)
+            {
+                Entity parent = Entity::Null;
+                for (uint32 level = 0; level < hierarchy_depth; ++level)
+                {
+                    Entity entity = scene.world->create_entity();
+                    if (parent.is_valid())
+                    {
+                        entity.set_parent(parent.get_handle());
+                    }
+                    else
+                    {
+                        scene.roots.push_back(entity);
+                    }
+
+                    const trs local(vec3((float)chain, 1.0f, 0.5f), quat::identity, vec3(1.0f, 1.0f, 1.0f));
+                    entity.get_component<TransformComponent>()->set_local_transform(local);
+
+                    scene.entities.push_back(entity);
+                    parent = entity;
+                }
+            }
+        }
+        return scene;
+    }
+
+    static void dirty_all_roots(TransformScene& scene)
+    {
+        for (Entity& root : scene.roots)
+        {
+            TransformComponent* transform = root.get_component<TransformComponent>();
+            transform->set_local_transform(transform->get_local_transform());
+        }
+    }
+
+    static float read_all_world_transforms(TransformScene& scene)
+    {
+        float sum = 0.0f;
+        for (Entity& entity : scene.entities)
+        {
+            sum += entity.get_component<TransformComponent>()->get_world_transform().position.x;
+        }
+        return sum;
+    }
+
+    // What every read used to cost: collect all ancestors into a vector and recompose the whole chain.
+    static trs compose_uncached(World* world, Entity entity)
+    {
+        std::vector<const TransformComponent*> chain;
+        chain.push_back(entity.get_component<TransformComponent>());
+
+        Entity::Handle ancestor = entity.get_parent_handle();
+        while (ancestor != Entity::NullHandle && ancestor != world->get_root_handle())
+        {
+            Entity ancestor_entity = world->get_entity(ancestor);
+            chain.push_back(ancestor_entity.get_component<TransformComponent>());
+            ancestor = ancestor_entity.get_parent_handle();
+        }
+
+        trs result = trs::identity;
+        for (auto iter = chain.rbegin(); iter != chain.rend(); ++iter)
+        {
+            result = result * (*iter)->get_local_transform();
+        }
+        return result;
+    }
+
+    ERA_BENCHMARK(Transforms, WorldTransformReads)
+    {
+        TransformScene& scene = get_transform_scene();
+        const double count = (double)scene.entities.size();
+
+        float sink = 0.0f;
+
+        printf(" %u entities, depth %u\n", (uint32)scene.entities.size(), hierarchy_depth);
+
+        report("uncached ancestor walk per read", measure(10, [&]()
+            {
+                for (Entity& entity : scene.entities)
+                {
+                    sink += compose_uncached(scene.world, entity).position.x;
+                }
+            }), count);
+
+        report("cached reads, nothing dirty", measure(10, [&]()
+            {
+                sink += read_all_world_transforms(scene);
+            }), count);
+
+        report("lazy reads after dirtying every root", measure(10, [&]()
+            {
+                dirty_all_roots(scene);
+                sink += read_all_world_transforms(scene);
+            }), count);
+
+        TransformHierarchy hierarchy;
+
+        report("hierarchy pass after dirtying every root", measure(10, [&]()
+            {
+                dirty_all_roots(scene);
+                hierarchy.update_world_transforms(scene.world);
+            }), count);
+
+        report("hierarchy pass, nothing dirty", measure(10, [&]()
+            {
+                hierarchy.update_world_transforms(scene.world);
+            }), count);
+
+        printf("  (checksum %f)\n", sink);
+    }
+}
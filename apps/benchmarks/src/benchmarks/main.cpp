@@ -0,0 +1,32 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// Usage: benchmarks [filter]
+// Runs every registered benchmark whose "group.name" contains 'filter'.
+int main(int argc, char** argv)
+{
+    using namespace era_engine::benchmarks;
+
+    const char* filter = (argc > 1) ? argv[1] : nullptr;
+
+    for (const BenchmarkEntry& entry : get_benchmarks())
+    {
+        std::string full_name = std::string(entry.group) + "." + entry.name;
+        if (filter && full_name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        printf("[ RUN ] %s\n", full_name.c_str());
+        entry.function();
+        printf("[ END ] %s\n\n", full_name.c_str());
+    }
+
+    // Job queue workers are detached and parked forever, so don't run static destructors under them.
+    fflush(stdout);
+    std::quick_exit(0);
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <motion_matching/motion_matching_database.h>
+
+#include <animation/animation_clip.h>
+
+#include <core/job_system.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    // One hour of motion: 180 clips of 20 seconds, sampled at 30 Hz.
+    static constexpr uint32 bake_num_clips = 180;
+    static constexpr uint32 bake_samples_per_clip = 600;
+    static constexpr float bake_sample_rate = 30.0f;
+
+    // Positions and velocities of 6 joints and 3 trajectory points with a position and a direction in the ground plane.
+    static constexpr uint32 bake_num_features = 6 * 6 + 3 * 4;
+    static constexpr uint32 bake_search_dimension = 24;
+
+    // Features of real clips are driven by a few degrees of freedom (speed, turn rate, gait phase...), so every feature
+    // is a fixed mix of a few smooth latent signals plus noise.
+    static constexpr uint32 bake_num_latents = 8;
+
+    struct BakeBenchmarkData
+    {
+        std::vector<ref<animation::AnimationAssetClip>> clips;
+        std::vector<uint32> hashes;
+        std::unordered_map<const animation::AnimationAssetClip*, uint32> clip_seeds;
+
+        std::vector<float> latent_mix;
+    };
+
+    static BakeBenchmarkData create_bake_data()
+    {
+        BakeBenchmarkData data;
+
+        std::mt19937 rng(13);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+
+        for (uint32 clip = 0; clip < bake_num_clips; ++clip)
+        {
+            data.clips.push_back(make_ref<animation::AnimationAssetClip>());
+            data.hashes.push_back(0x9E3779B9u * (clip + 1));
+            data.clip_seeds.emplace(data.clips.back().get(), clip);
+        }
+
+        data.latent_mix.resize(bake_num_features * bake_num_latents);
+        for (float& value : data.latent_mix)
+        {
+            value = noise(rng);
+        }
+
+        return data;
+    }
+
+    static MotionMatchingDatabase::SampleExtractor create_sample_extractor(const BakeBenchmarkData& data)
+    {
+        return [&data](const animation::AnimationAssetClip& clip, float sample_rate, std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>>& out_samples)
+        {
+            std::mt19937 rng(data.clip_seeds.at(&clip));
+            std::normal_distribution<float> noise(0.0f, 1.0f);
+
+            float latents[bake_num_latents];
+            for (float& latent : latents)
+            {
+                latent = noise(rng);
+            }
+
+            out_samples.resize(bake_samples_per_clip);
+            for (uint32 index = 0; index < bake_samples_per_clip; ++index)
+            {
+                for (uint32 latent = 0; latent < bake_num_latents; ++latent)
+                {
+                    latents[latent] = 0.98f * latents[latent] + 0.2f * noise(rng);
+                }
+
+                std::shared_ptr<MotionMatchingDatabase::Sample> sample = std::make_shared<MotionMatchingDatabase::Sample>();
+                sample->anim_position = float(index) / sample_rate;
+                sample->features.resize(bake_num_features);
+                for (uint32 feature = 0; feature < bake_num_features; ++feature)
+                {
+                    float value = 0.05f * noise(rng);
+                    for (uint32 latent = 0; latent < bake_num_latents; ++latent)
+                    {
+                        value += data.latent_mix[feature * bake_num_latents + latent] * latents[latent];
+                    }
+                    sample->features[feature] = value;
+                }
+                out_samples[index] = std::move(sample);
+            }
+        };
+    }
+
+    ERA_BENCHMARK(MotionMatching, DatabaseBake)
+    {
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        const BakeBenchmarkData data = create_bake_data();
+        const MotionMatchingDatabase::SampleExtractor extract_samples = create_sample_extractor(data);
+
+        const uint32 num_samples = bake_num_clips * bake_samples_per_clip;
+        printf(" %u clips, %u samples (1 hour at %.0f Hz), %u features, %u search dimensions, %u threads\n",
+            bake_num_clips, num_samples, bake_sample_rate, bake_num_features, bake_search_dimension, high_priority_job_queue.get_num_threads() + 1);
+
+        const std::pair<const char*, KnnStructureType> knn_types[] = {
+            { "brute force", KnnStructureType::BRUTE_FORCE },
+            { "hnsw", KnnStructureType::HNSW },
+            { "pq", KnnStructureType::PRODUCT_QUANTIZATION }
+        };
+
+        for (const auto& [name, knn_type] : knn_types)
+        {
+            MotionMatchingDatabase database(knn_type);
+            database.sample_rate = bake_sample_rate;
+            database.search_dimension = bake_search_dimension;
+            database.weights.assign(bake_num_features, 1.0f);
+            database.animations = data.clips;
+            database.animations_hashes = data.hashes;
+
+            auto restore_clips = [&]()
+            {
+                database.animations = data.clips;
+                database.animations_hashes = data.hashes;
+            };
+
+            char label[64];
+
+            snprintf(label, sizeof(label), "  %s, full bake", name);
+            report(label, measure_with_setup(3, [&]()
+                {
+                    database.clip_samples_cache.clear();
+                }, [&]()
+                {
+                    database.bake(extract_samples);
+                }), num_samples);
+
+            // The last clip is new: it is the only one extracted.
+            snprintf(label, sizeof(label), "  %s, one clip added", name);
+            report(label, measure_with_setup(3, [&]()
+                {
+                    database.clip_samples_cache.erase(data.hashes.back());
+                }, [&]()
+                {
+                    database.bake(extract_samples);
+                }), num_samples);
+
+            snprintf(label, sizeof(label), "  %s, one clip removed", name);
+            report(label, measure_with_setup(3, [&]()
+                {
+                    restore_clips();
+                    database.bake(extract_samples);
+                }, [&]()
+                {
+                    database.animations.pop_back();
+                    database.animations_hashes.pop_back();
+                    database.bake(extract_samples);
+                }), num_samples - bake_samples_per_clip);
+        }
+    }
+}
@@ -0,0 +1,240 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <motion_matching/motion_matching_database.h>
+#include <motion_matching/motion_matching_knn_structure.h>
+#include <motion_matching/brute_force/brute_force_knn_structure.h>
+#include <motion_matching/hnsw/hnsw_knn_structure.h>
+#include <motion_matching/product_quantization/product_quantization_knn_structure.h>
+
+#include <core/job_system.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 knn_search_dimension = 24;
+    static constexpr uint32 knn_num_queries = 256;
+    static constexpr uint32 knn_k = 10;
+
+    // Characters searching in one frame.
+    static constexpr uint32 knn_batch_size = 500;
+
+    // Search features are PCA components, so later dimensions carry less variance. Consecutive rows are frames of the
+    // same clip and move smoothly, a new clip starts every 600 frames.
+    static ref<MotionMatchingDatabase> create_knn_database(uint32 num_rows, KnnStructureType knn_type, std::mt19937& rng)
+    {
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+
+        ref<MotionMatchingDatabase> database = make_ref<MotionMatchingDatabase>(knn_type);
+        database->search_dimension = knn_search_dimension;
+        database->search_features.resize(num_rows, knn_search_dimension);
+
+        float row[knn_search_dimension] = {};
+        for (uint32 index = 0; index < num_rows; ++index)
+        {
+            for (uint32 dimension = 0; dimension < knn_search_dimension; ++dimension)
+            {
+                const float scale = 1.0f / (1.0f + 0.3f * dimension);
+                if (index % 600 == 0)
+                {
+                    row[dimension] = 3.0f * scale * noise(rng);
+                }
+                else
+                {
+                    row[dimension] = 0.98f * row[dimension] + 0.15f * scale * noise(rng);
+                }
+            }
+            database->search_features.set_row(index, row);
+        }
+
+        return database;
+    }
+
+    // Queries are perturbed database rows, like a query built from the current pose and a slightly different trajectory.
+    static std::vector<std::vector<float>> create_knn_queries(const FeatureMatrix& features, std::mt19937& rng)
+    {
+        std::normal_distribution<float> noise(0.0f, 0.1f);
+        std::uniform_int_distribution<uint32> random_row(0, features.get_rows() - 1);
+
+        std::vector<std::vector<float>> queries(knn_num_queries);
+        for (std::vector<float>& query : queries)
+        {
+            const float* row = features.get_row(random_row(rng));
+            query.assign(row, row + features.get_cols());
+            for (float& value : query)
+            {
+                value += noise(rng);
+            }
+        }
+        return queries;
+    }
+
+    static double get_recall(const std::vector<std::vector<KnnCandidate>>& results, const std::vector<std::vector<KnnCandidate>>& ground_truth)
+    {
+        uint32 found = 0;
+        uint32 total = 0;
+        for (size_t query = 0; query < results.size(); ++query)
+        {
+            for (const KnnCandidate& expected : ground_truth[query])
+            {
+                for (const KnnCandidate& candidate : results[query])
+                {
+                    if (candidate.sample_index == expected.sample_index)
+                    {
+                        ++found;
+                        break;
+                    }
+                }
+            }
+            total += uint32(ground_truth[query].size());
+        }
+        return total > 0 ? double(found) / double(total) : 0.0;
+    }
+
+    static void report_knn(const char* label, KnnStructure& knn_structure, const MotionMatchingDatabase& database,
+        const std::vector<std::vector<float>>& queries, const std::vector<std::vector<KnnCandidate>>& ground_truth)
+    {
+        std::vector<std::vector<KnnCandidate>> results(queries.size());
+
+        const BenchmarkStats stats = measure(5, [&]()
+            {
+                for (size_t query = 0; query < queries.size(); ++query)
+                {
+                    knn_structure.search_knn(queries[query].data(), knn_k, database, results[query]);
+                }
+            });
+
+        char full_label[128];
+        snprintf(full_label, sizeof(full_label), "%s, recall@%u %.3f", label, knn_k, get_recall(results, ground_truth));
+        report(full_label, stats, double(queries.size()));
+    }
+
+    ERA_BENCHMARK(MotionMatching, KnnRecallVsLatency)
+    {
+        using clock = std::chrono::high_resolution_clock;
+
+        std::mt19937 rng(7);
+
+        for (uint32 num_rows : { 10000u, 100000u, 1000000u })
+        {
+            printf(" %u frames, %u search dimensions, %u queries per iteration\n", num_rows, knn_search_dimension, knn_num_queries);
+
+            ref<MotionMatchingDatabase> database = create_knn_database(num_rows, KnnStructureType::BRUTE_FORCE, rng);
+            const std::vector<std::vector<float>> queries = create_knn_queries(database->search_features, rng);
+
+            BruteForceKnnStructure brute_force;
+            brute_force.build_structure(*database);
+
+            std::vector<std::vector<KnnCandidate>> ground_truth(queries.size());
+            for (size_t query = 0; query < queries.size(); ++query)
+            {
+                brute_force.search_knn(queries[query].data(), knn_k, *database, ground_truth[query]);
+            }
+
+            report_knn("  brute force", brute_force, *database, queries, ground_truth);
+
+            {
+                HnswKnnStructure hnsw;
+
+                auto start = clock::now();
+                hnsw.build_structure(*database);
+                printf("   hnsw build %.0f ms\n", std::chrono::duration<double, std::milli>(clock::now() - start).count());
+
+                for (uint32 exploration_factor : { 10u, 32u, 128u })
+                {
+                    hnsw.search_exploration_factor = exploration_factor;
+
+                    char label[64];
+                    snprintf(label, sizeof(label), "  hnsw, ef %u", exploration_factor);
+                    report_knn(label, hnsw, *database, queries, ground_truth);
+                }
+            }
+
+            {
+                ProductQuantizationKnnStructure product_quantization;
+
+                auto start = clock::now();
+                product_quantization.build_structure(*database);
+                printf("   pq build %.0f ms\n", std::chrono::duration<double, std::milli>(clock::now() - start).count());
+
+                for (uint32 rerank_factor : { 2u, 8u, 32u })
+                {
+                    product_quantization.rerank_factor = rerank_factor;
+
+                    char label[64];
+                    snprintf(label, sizeof(label), "  pq, rerank %ux", rerank_factor);
+                    report_knn(label, product_quantization, *database, queries, ground_truth);
+                }
+            }
+        }
+    }
+
+    ERA_BENCHMARK(MotionMatching, KnnBatch)
+    {
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        std::mt19937 rng(11);
+
+        for (uint32 num_rows : { 10000u, 100000u })
+        {
+            printf(" %u frames, %u queries per batch, %u threads\n", num_rows, knn_batch_size, high_priority_job_queue.get_num_threads() + 1);
+
+            ref<MotionMatchingDatabase> database = create_knn_database(num_rows, KnnStructureType::BRUTE_FORCE, rng);
+
+            FeatureMatrix queries(knn_batch_size, knn_search_dimension);
+            {
+                const std::vector<std::vector<float>> random_queries = create_knn_queries(database->search_features, rng);
+                for (uint32 query = 0; query < knn_batch_size; ++query)
+                {
+                    queries.set_row(query, random_queries[query % random_queries.size()].data());
+                }
+            }
+
+            std::vector<KnnCandidate> candidates(knn_batch_size * knn_k);
+            std::vector<uint32> counts(knn_batch_size);
+            std::vector<KnnCandidate> single_candidates;
+
+            BruteForceKnnStructure brute_force;
+            brute_force.build_structure(*database);
+
+            HnswKnnStructure hnsw;
+            hnsw.search_exploration_factor = 32;
+            hnsw.build_structure(*database);
+
+            ProductQuantizationKnnStructure product_quantization;
+            product_quantization.build_structure(*database);
+
+            const std::pair<const char*, KnnStructure*> structures[] = {
+                { "brute force", &brute_force },
+                { "hnsw, ef 32", &hnsw },
+                { "pq, rerank 8x", &product_quantization }
+            };
+
+            for (const auto& [name, knn_structure] : structures)
+            {
+                char label[64];
+
+                snprintf(label, sizeof(label), "  %s, one query at a time", name);
+                report(label, measure(10, [&]()
+                    {
+                        for (uint32 query = 0; query < knn_batch_size; ++query)
+                        {
+                            knn_structure->search_knn(queries.get_row(query), knn_k, *database, single_candidates);
+                        }
+                    }), knn_batch_size);
+
+                snprintf(label, sizeof(label), "  %s, batch", name);
+                report(label, measure(10, [&]()
+                    {
+                        knn_structure->search_knn_batch(queries.get_data(), queries.get_stride(), knn_batch_size, knn_k, *database,
+                            candidates.data(), counts.data());
+                    }), knn_batch_size);
+            }
+        }
+    }
+}
@@ -0,0 +1,238 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <core/job_system.h>
+
+#include <rendering/render_command_buffer.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 num_benchmark_draws = 100000;
+    static constexpr uint32 num_benchmark_pipelines = 16;
+
+    // Roughly the size and shape of pbr_render_data: GPU addresses, views, submesh info and a material reference.
+    struct BenchmarkDraw
+    {
+        uint64 transform_ptr;
+        uint64 vertex_buffer[4];
+        uint64 index_buffer[2];
+        uint32 submesh[4];
+        uint32 num_instances;
+        ref<int> material;
+    };
+
+    static uint64 num_benchmark_draws_rendered = 0;
+
+    template <uint32 Index_>
+    struct BenchmarkPipeline
+    {
+        PIPELINE_SETUP_DECL {}
+        PIPELINE_RENDER_DECL(BenchmarkDraw) { num_benchmark_draws_rendered += data.num_instances; }
+    };
+
+    // The previous buffer: one key vector, one virtual wrapper per draw in an arena behind the global allocator lock,
+    // std::sort on the keys. Kept as the baseline.
+    class VirtualCommandBuffer
+    {
+    public:
+        VirtualCommandBuffer()
+        {
+            arena.initialize(0, GB(4));
+            keys.reserve(128);
+        }
+
+        template <typename pipeline_t>
+        void emplace_back(uint64 sort_key, const BenchmarkDraw& draw)
+        {
+            struct CommandWrapper : CommandWrapperBase
+            {
+                BenchmarkDraw command;
+            };
+
+            CommandWrapper* wrapper = arena.allocate<CommandWrapper>();
+            new (wrapper) CommandWrapper;
+
+            wrapper->setup = pipeline_t::setup;
+            wrapper->render = [](dx_command_list* cl, const mat4& view_proj, void* data)
+                {
+                    pipeline_t::render(cl, view_proj, ((CommandWrapper*)data)->command);
+                };
+            wrapper->command = draw;
+
+            keys.push_back({ sort_key, wrapper });
+        }
+
+        void sort()
+        {
+            std::sort(keys.begin(), keys.end(), [](const CommandKey& a, const CommandKey& b) { return a.key < b.key; });
+        }
+
+        void render()
+        {
+            for (const CommandKey& key : keys)
+            {
+                CommandWrapperBase* wrapper = (CommandWrapperBase*)key.data;
+                wrapper->render(nullptr, mat4::identity, key.data);
+            }
+        }
+
+        void clear()
+        {
+            for (const CommandKey& key : keys)
+            {
+                ((CommandWrapperBase*)key.data)->~CommandWrapperBase();
+            }
+
+            arena.reset();
+            keys.clear();
+        }
+
+    private:
+        struct CommandKey
+        {
+            uint64 key;
+            void* data;
+        };
+
+        struct CommandWrapperBase
+        {
+            pipeline_setup_func setup;
+            void (*render)(dx_command_list*, const mat4&, void*);
+
+            virtual ~CommandWrapperBase() {}
+        };
+
+        std::vector<CommandKey> keys;
+        Allocator arena;
+    };
+
+    struct BenchmarkScene
+    {
+        std::vector<BenchmarkDraw> draws;
+        std::vector<uint32> pipelines;
+    };
+
+    static BenchmarkScene create_benchmark_scene()
+    {
+        std::mt19937 rng(7);
+        ref<int> material = make_ref<int>(0);
+
+        BenchmarkScene scene;
+        scene.draws.resize(num_benchmark_draws);
+        scene.pipelines.resize(num_benchmark_draws);
+
+        for (uint32 i = 0; i < num_benchmark_draws; ++i)
+        {
+            BenchmarkDraw& draw = scene.draws[i];
+            draw.transform_ptr = (uint64)i * sizeof(mat4);
+            draw.num_instances = 1;
+            draw.material = material;
+
+            scene.pipelines[i] = rng() % num_benchmark_pipelines;
+        }
+        return scene;
+    }
+
+    // Keys are the setup function addresses, like in the render passes.
+    template <typename Record_, uint32... Indices_>
+    static void record_with_pipeline(uint32 pipeline, Record_&& record, std::integer_sequence<uint32, Indices_...>)
+    {
+        ((pipeline == Indices_ ? record(BenchmarkPipeline<Indices_>{}) : void()), ...);
+    }
+
+    template <typename Buffer_>
+    static void record_draw(Buffer_& buffer, const BenchmarkScene& scene, uint32 i)
+    {
+        record_with_pipeline(scene.pipelines[i], [&](auto pipeline)
+            {
+                using pipeline_t = decltype(pipeline);
+                buffer.template emplace_back<pipeline_t>((uint64)pipeline_t::setup, scene.draws[i]);
+            }, std::make_integer_sequence<uint32, num_benchmark_pipelines>{});
+    }
+
+    // Adapter, so that the new buffer records the same way as the baseline.
+    struct RadixCommandBuffer : default_render_command_buffer<uint64>
+    {
+        template <typename pipeline_t>
+        void emplace_back(uint64 sort_key, const BenchmarkDraw& draw)
+        {
+            default_render_command_buffer<uint64>::emplace_back<pipeline_t, BenchmarkDraw>(sort_key, draw);
+        }
+
+        void render()
+        {
+            for (const auto& dc : *this)
+            {
+                dc.render(nullptr, mat4::identity, dc.data);
+            }
+        }
+    };
+
+    ERA_BENCHMARK(RenderCommandBuffer, RecordAndSort100k)
+    {
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        const BenchmarkScene scene = create_benchmark_scene();
+        constexpr uint32 iterations = 20;
+
+        printf(" %u draws, %u pipelines, %u threads\n", num_benchmark_draws, num_benchmark_pipelines, high_priority_job_queue.get_num_threads() + 1);
+
+        VirtualCommandBuffer virtual_buffer;
+        RadixCommandBuffer radix_buffer;
+
+        auto record_serial = [&](auto& buffer)
+            {
+                for (uint32 i = 0; i < num_benchmark_draws; ++i)
+                {
+                    record_draw(buffer, scene, i);
+                }
+            };
+
+        auto record_parallel = [&](RadixCommandBuffer& buffer)
+            {
+                parallel_for(0, num_benchmark_draws, 1024, [&](uint32 begin, uint32 end)
+                    {
+                        for (uint32 i = begin; i < end; ++i)
+                        {
+                            record_draw(buffer, scene, i);
+                        }
+                    });
+            };
+
+        report("  record: virtual wrappers", measure_with_setup(iterations, [&]() { virtual_buffer.clear(); }, [&]() { record_serial(virtual_buffer); }), num_benchmark_draws);
+        report("  record: POD records", measure_with_setup(iterations, [&]() { radix_buffer.clear(); }, [&]() { record_serial(radix_buffer); }), num_benchmark_draws);
+        report("  record: POD records, parallel", measure_with_setup(iterations, [&]() { radix_buffer.clear(); }, [&]() { record_parallel(radix_buffer); }), num_benchmark_draws);
+
+        // Sorting an already sorted buffer would flatter std::sort, so the commands are recorded again in the setup.
+        report("  sort: std::sort", measure_with_setup(iterations, [&]() { virtual_buffer.clear(); record_serial(virtual_buffer); }, [&]() { virtual_buffer.sort(); }), num_benchmark_draws);
+        report("  sort: radix merge, serial recording", measure_with_setup(iterations, [&]() { radix_buffer.clear(); record_serial(radix_buffer); }, [&]() { radix_buffer.sort(); }), num_benchmark_draws);
+        report("  sort: radix merge, parallel recording", measure_with_setup(iterations, [&]() { radix_buffer.clear(); record_parallel(radix_buffer); }, [&]() { radix_buffer.sort(); }), num_benchmark_draws);
+
+        report("  frame: virtual wrappers", measure(iterations, [&]()
+            {
+                record_serial(virtual_buffer);
+                virtual_buffer.sort();
+                virtual_buffer.render();
+                virtual_buffer.clear();
+            }), num_benchmark_draws);
+
+        report("  frame: POD records, parallel + radix merge", measure(iterations, [&]()
+            {
+                record_parallel(radix_buffer);
+                radix_buffer.sort();
+                radix_buffer.render();
+                radix_buffer.clear();
+            }), num_benchmark_draws);
+
+        virtual_buffer.clear();
+        radix_buffer.clear();
+
+        printf(" %llu draws rendered\n", (unsigned long long)num_benchmark_draws_rendered);
+    }
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "benchmarks/benchmark.h"
+
+#include <core/job_system.h>
+#include <core/camera.h>
+
+#include <rendering/visibility.h>
+
+#include <random>
+
+namespace era_engine::benchmarks
+{
+    static constexpr uint32 num_visibility_objects = 100000;
+
+    struct VisibilityScene
+    {
+        bounding_box mesh_aabb;
+        std::vector<trs> transforms;
+        std::vector<bounding_box> world_aabbs;
+        std::vector<VisibilityView> views;
+    };
+
+    static bounding_box get_world_aabb(const bounding_box& aabb, const trs& transform)
+    {
+        bounding_box scaled = { aabb.minCorner * transform.scale, aabb.maxCorner * transform.scale };
+        return scaled.transformToAABB(transform.rotation, transform.position);
+    }
+
+    static camera_frustum_planes get_frustum(vec3 position, quat rotation, float far_plane)
+    {
+        render_camera camera;
+        camera.initializeIngame(position, rotation, deg2rad(70.f), 0.1f, far_plane);
+        camera.setViewport(1920, 1080);
+        camera.updateMatrices();
+        return camera.getWorldSpaceFrustumPlanes();
+    }
+
+    // Objects scattered over a 2km x 2km level. The camera stands in the middle, the sun cascades cover growing ranges in
+    // front of it and two point lights are close by.
+    static VisibilityScene create_visibility_scene()
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> horizontal(-1000.f, 1000.f);
+        std::uniform_real_distribution<float> vertical(0.f, 20.f);
+        std::uniform_real_distribution<float> angle(0.f, M_TAU);
+        std::uniform_real_distribution<float> scale(0.5f, 3.f);
+
+        VisibilityScene scene;
+        scene.mesh_aabb = bounding_box::fromMinMax(vec3(-1.f, 0.f, -1.f), vec3(1.f, 2.f, 1.f));
+
+        scene.transforms.resize(num_visibility_objects);
+        scene.world_aabbs.resize(num_visibility_objects);
+        for (uint32 i = 0; i < num_visibility_objects; ++i)
+        {
+            scene.transforms[i] = trs(vec3(horizontal(rng), vertical(rng), horizontal(rng)), quat(vec3(0.f, 1.f, 0.f), angle(rng)), vec3(scale(rng)));
+            scene.world_aabbs[i] = get_world_aabb(scene.mesh_aabb, scene.transforms[i]);
+        }
+
+        const quat forward = quat::identity;
+        const quat down = quat(vec3(1.f, 0.f, 0.f), deg2rad(-60.f));
+
+        scene.views.push_back(VisibilityView::from_frustum(get_frustum(vec3(0.f, 2.f, 0.f), forward, 1000.f)));
+        scene.views.push_back(VisibilityView::from_frustum(get_frustum(vec3(0.f, 50.f, 20.f), down, 100.f)));
+        scene.views.push_back(VisibilityView::from_frustum(get_frustum(vec3(0.f, 100.f, 60.f), down, 250.f)));
+        scene.views.push_back(VisibilityView::from_frustum(get_frustum(vec3(0.f, 200.f, 150.f), down, 500.f)));
+        scene.views.push_back(VisibilityView::from_frustum(get_frustum(vec3(0.f, 400.f, 300.f), down, 1000.f)));
+        scene.views.push_back(VisibilityView::from_sphere(bounding_sphere{ vec3(10.f, 3.f, -20.f), 15.f }));
+        scene.views.push_back(VisibilityView::from_sphere(bounding_sphere{ vec3(-30.f, 3.f, -50.f), 25.f }));
+        return scene;
+    }
+
+    // The previous path: every view tests every object's model-space AABB under its transform, one object at a time.
+    // Views run in parallel, like the passes did. Kept as the baseline.
+    static uint32 cull_per_object(const VisibilityScene& scene, std::vector<std::vector<uint32>>& visible)
+    {
+        visible.resize(scene.views.size());
+
+        parallel_for(0, (uint32)scene.views.size(), 1, [&](uint32 begin, uint32 end)
+            {
+                for (uint32 v = begin; v < end; ++v)
+                {
+                    const VisibilityView& view = scene.views[v];
+                    std::vector<uint32>& result = visible[v];
+                    result.clear();
+
+                    camera_frustum_planes frustum;
+                    for (uint32 i = 0; i < 6; ++i)
+                    {
+                        frustum.planes[i] = view.planes[i];
+                    }
+
+                    for (uint32 i = 0; i < num_visibility_objects; ++i)
+                    {
+                        const trs& transform = scene.transforms[i];
+
+                        bool is_visible;
+                        if (view.is_sphere)
+                        {
+                            bounding_sphere s = view.sphere;
+                            s.center = conjugate(transform.rotation) * (s.center - transform.position) + transform.position;
+                            bounding_box aabb = { scene.mesh_aabb.minCorner * transform.scale, scene.mesh_aabb.maxCorner * transform.scale };
+                            is_visible = aabb.contains(s.center) || sphereVsAABB(s, aabb);
+                        }
+                        else
+                        {
+                            is_visible = !frustum.cullModelSpaceAABB(scene.mesh_aabb, transform);
+                        }
+
+                        if (is_visible)
+                        {
+                            result.push_back(i);
+                        }
+                    }
+                }
+            });
+
+        uint32 num_visible = 0;
+        for (const std::vector<uint32>& result : visible)
+        {
+            num_visible += (uint32)result.size();
+        }
+        return num_visible;
+    }
+
+    ERA_BENCHMARK(Visibility, Cull100k)
+    {
+        if (high_priority_job_queue.get_num_threads() == 0)
+        {
+            initialize_job_system();
+        }
+
+        const VisibilityScene scene = create_visibility_scene();
+        constexpr uint32 iterations = 20;
+
+        std::vector<std::vector<uint32>> per_object_visible;
+        const uint32 per_object_num_visible = cull_per_object(scene, per_object_visible);
+
+        VisibilityBVH bvh;
+        VisibilityResult result;
+        bvh.build(scene.world_aabbs.data(), num_visibility_objects);
+        bvh.cull(scene.views.data(), (uint32)scene.views.size(), result);
+
+        printf(" %u objects, %u views, %u threads, %u nodes\n", num_visibility_objects, (uint32)scene.views.size(),
+            high_priority_job_queue.get_num_threads() + 1, bvh.get_num_nodes());
+        printf(" visible: %u per object, %u with world-space AABBs\n", per_object_num_visible, (uint32)result.visible_indices.size());
+
+        report("  cull: per object, model-space AABBs", measure(iterations, [&]()
+            {
+                cull_per_object(scene, per_object_visible);
+            }), num_visibility_objects);
+
+        report("  cull: BVH, all views in one traversal", measure(iterations, [&]()
+            {
+                bvh.cull(scene.views.data(), (uint32)scene.views.size(), result);
+            }), num_visibility_objects);
+
+        report("  build", measure(iterations, [&]()
+            {
+                bvh.build(scene.world_aabbs.data(), num_visibility_objects);
+            }), num_visibility_objects);
+
+        // One percent of the objects move a little every frame.
+        std::vector<bounding_box> moved_aabbs = scene.world_aabbs;
+        std::vector<uint32> moved_indices;
+        for (uint32 i = 0; i < num_visibility_objects; i += 100)
+        {
+            moved_indices.push_back(i);
+        }
+
+        const uint32 num_builds_before_refit = bvh.get_num_builds();
+
+        float offset = 0.f;
+        report("  refit: 1% of the objects moved", measure_with_setup(iterations, [&]()
+            {
+                offset += 0.1f;
+                for (uint32 i : moved_indices)
+                {
+                    moved_aabbs[i] = bounding_box::fromMinMax(scene.world_aabbs[i].minCorner + vec3(offset), scene.world_aabbs[i].maxCorner + vec3(offset));
+                }
+            }, [&]()
+            {
+                bvh.update(moved_aabbs.data(), moved_indices.data(), (uint32)moved_indices.size());
+            }), (uint32)moved_indices.size());
+
+        printf(" %u rebuilds while refitting\n", bvh.get_num_builds() - num_builds_before_refit);
+    }
+}
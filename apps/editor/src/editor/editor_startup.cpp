@@ -44,6 +44,7 @@ namespace era_engine
 		
 		game_world->add_tag("physics");
 		game_world->add_tag("render");
+		game_world->add_tag("animation");
 		game_world->add_tag("base");
 		game_world->add_tag("editor");
 
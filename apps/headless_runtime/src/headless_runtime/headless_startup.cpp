@@ -0,0 +1,308 @@
+#include "headless_runtime/headless_startup.h"
+
+#include <base/module_loader.h>
+
+#include <core/job_system.h>
+#include <core/frame_allocator.h>
+#include <core/cpu_profiling.h>
+
+#include <ecs/world.h>
+#include <ecs/world_system_scheduler.h>
+#include <ecs/base_components/transform_component.h>
+
+#include <physics/core/physics.h>
+#include <physics/body_component.h>
+#include <physics/shape_component.h>
+#include <physics/basic_objects.h>
+#include <physics/collisions_holder_root_component.h>
+
+#include <physics_module.h>
+#include <simple_motion_matching_module.h>
+
+#include <clara/clapa.hpp>
+
+#include <rttr/type>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+
+namespace era_engine
+{
+	struct HeadlessSettings
+	{
+		uint32 frames = 1000;
+		float dt = 1.0f / 60.0f;
+		double fixed_rate = 60.0;
+		uint32 bodies = 512;
+		std::string trace_path;
+		uint32 trace_frames = 0;
+	};
+
+	struct SystemTiming
+	{
+		std::string group;
+		double total_ms = 0.0;
+		double max_ms = 0.0;
+		uint32 calls = 0;
+		uint32 critical_calls = 0;
+	};
+
+	static constexpr physics::CollisionType headless_dynamics_collision = physics::CollisionType::COLLISION_1;
+
+	static bool parse_settings(int argc, char** argv, HeadlessSettings& settings)
+	{
+		using namespace clara;
+
+		bool show_help = false;
+
+		Parser cli;
+		cli += Help(show_help);
+		cli += Opt(settings.frames, "frames")["-f"]["--frames"]("Number of frames to run");
+		cli += Opt(settings.dt, "seconds")["--dt"]("Normal update step");
+		cli += Opt(settings.fixed_rate, "hz")["--fixed-rate"]("Fixed update rate");
+		cli += Opt(settings.bodies, "count")["-b"]["--bodies"]("Number of dynamic bodies in the test scene");
+		cli += Opt(settings.trace_path, "path")["--trace"]("Write a Chrome trace (chrome://tracing, ui.perfetto.dev) of the run to this file");
+		cli += Opt(settings.trace_frames, "frames")["--trace-frames"]("Only trace this many frames, 0 traces all");
+
+		auto result = cli.parse(Args(argc, argv));
+		if (!result)
+		{
+			std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+			return false;
+		}
+
+		if (show_help)
+		{
+			std::cout << cli << std::endl;
+			return false;
+		}
+
+		return settings.frames > 0 && settings.dt > 0.0f && settings.fixed_rate > 0.0;
+	}
+
+	// Ground plane and a grid of spheres dropped onto it, so the physics systems have contacts to solve.
+	static void create_test_scene(World* world, uint32 num_bodies)
+	{
+		using namespace physics;
+
+		CollisionsHolderRootComponent* collision_holder_rc = world->add_root_component<CollisionsHolderRootComponent>();
+		ASSERT(collision_holder_rc != nullptr);
+
+		collision_holder_rc->set_collision_filter(static_cast<uint32>(headless_dynamics_collision),
+			static_cast<uint32>(headless_dynamics_collision), true);
+		collision_holder_rc->set_collision_filter(static_cast<uint32>(CollisionType::TERRAIN),
+			static_cast<uint32>(headless_dynamics_collision), true);
+
+		Entity plane = world->create_entity("Platform");
+		plane.add_component<PlaneComponent>(CollisionType::TERRAIN, vec3(0.0f));
+
+		ref<PhysicsMaterial> material = PhysicsHolder::physics_ref->get_default_material();
+
+		const uint32 grid_size = std::max(1u, (uint32)ceil(sqrt((float)num_bodies)));
+		for (uint32 i = 0; i < num_bodies; ++i)
+		{
+			Entity sphere = world->create_entity("Sphere");
+
+			SphereShapeComponent* sphere_shape_component = sphere.add_component<SphereShapeComponent>();
+			sphere_shape_component->collision_type = headless_dynamics_collision;
+			sphere_shape_component->radius = 0.2f;
+			sphere_shape_component->material = material;
+
+			const vec3 position = vec3((float)(i % grid_size), 2.0f + 0.5f * (float)(i / (grid_size * grid_size)), (float)((i / grid_size) % grid_size));
+			sphere.get_component<TransformComponent>()->set_world_transform(trs{ position, quat::identity, vec3(1.0f) });
+
+			DynamicBodyComponent* dynamic_body_component = sphere.add_component<DynamicBodyComponent>();
+			dynamic_body_component->mass.get_for_write() = 1.0f;
+			dynamic_body_component->simulated.get_for_write() = true;
+			dynamic_body_component->use_gravity.get_for_write() = true;
+		}
+	}
+
+	// Only the systems of the world's tags are created: rendering and input systems need a device and a window.
+	// The scheduler skips systems which a module has created already.
+	static void initialize_world_systems(World* world)
+	{
+		std::vector<rttr::type> system_types;
+		for (const rttr::type& type : rttr::type::get_types())
+		{
+			rttr::variant tag = type.get_constructor({ rttr::type::get<World*>() }).get_metadata("Tag");
+			if (!tag.is_valid() || world->has_tag(tag.get_value<std::string>()))
+			{
+				system_types.push_back(type);
+			}
+		}
+
+		world->get_system_scheduler()->initialize_systems(rttr::array_range<rttr::type>(system_types.data(), system_types.size()));
+	}
+
+	static void accumulate_timings(const std::vector<UpdateGroupTiming>& group_timings, std::map<std::string, SystemTiming>& system_timings)
+	{
+		for (const UpdateGroupTiming& group_timing : group_timings)
+		{
+			for (const TaskTiming& task_timing : group_timing.tasks)
+			{
+				SystemTiming& timing = system_timings[task_timing.name];
+				timing.group = group_timing.group;
+				timing.total_ms += task_timing.duration_ms;
+				timing.max_ms = std::max(timing.max_ms, task_timing.duration_ms);
+				++timing.calls;
+				timing.critical_calls += task_timing.on_critical_path ? 1 : 0;
+			}
+		}
+	}
+
+	static void report_timings(const char* label, const std::map<std::string, SystemTiming>& system_timings, uint32 frames)
+	{
+		std::vector<std::pair<std::string, SystemTiming>> sorted(system_timings.begin(), system_timings.end());
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.total_ms > b.second.total_ms; });
+
+		printf(" %s\n", label);
+		printf("  %-56s %-28s %8s %10s %10s %10s %9s\n", "system", "group", "calls", "ms/frame", "ms/call", "max ms", "critical");
+		for (const auto& [name, timing] : sorted)
+		{
+			printf("  %-56s %-28s %8u %10.4f %10.4f %10.4f %8.0f%%\n",
+				name.c_str(),
+				timing.group.c_str(),
+				timing.calls,
+				timing.total_ms / frames,
+				timing.calls > 0 ? timing.total_ms / timing.calls : 0.0,
+				timing.max_ms,
+				timing.calls > 0 ? 100.0 * timing.critical_calls / timing.calls : 0.0);
+		}
+	}
+
+	void HeadlessStartup::start(int argc, char** argv)
+	{
+		using clock = std::chrono::high_resolution_clock;
+
+		HeadlessSettings settings;
+		if (!parse_settings(argc, argv, settings))
+		{
+			return;
+		}
+
+		initialize_job_system();
+
+		World* game_world = new World(World::GAMEPLAY_WORLD_NAME);
+		game_world->init();
+
+		game_world->add_tag("physics");
+		game_world->add_tag("animation");
+		game_world->add_tag("base");
+		game_world->add_tag("motion_matching");
+
+		WorldSystemScheduler* scheduler = game_world->get_system_scheduler();
+
+		// The fixed update is stepped below instead, in lockstep with the normal update.
+		scheduler->stop();
+		scheduler->set_fixed_update_rate(settings.fixed_rate);
+
+		// Modules don't touch the engine instance, there is none without a window.
+		{
+			ModuleLoader loader = ModuleLoader(nullptr);
+
+			PhysicsModule* physics_module = new PhysicsModule();
+			physics_module->initialize(nullptr);
+
+			SimpleMotionMatchingModule* simple_mm_module = new SimpleMotionMatchingModule();
+			simple_mm_module->initialize(nullptr);
+
+			loader.add_module(physics_module);
+			loader.add_module(simple_mm_module);
+
+			ASSERT(loader.status());
+		}
+
+		execute_main_thread_jobs();
+
+		initialize_world_systems(game_world);
+		scheduler->initialize_all_systems();
+
+		create_test_scene(game_world, settings.bodies);
+
+		bool tracing = false;
+		if (!settings.trace_path.empty())
+		{
+#if ENABLE_CPU_PROFILING
+			tracing = begin_cpu_profile_capture(settings.trace_path, settings.trace_frames);
+			if (!tracing)
+			{
+				std::cerr << "Could not open trace file '" << settings.trace_path << "'" << std::endl;
+			}
+#else
+			std::cerr << "--trace needs a build with ERA_ENABLE_CPU_PROFILING" << std::endl;
+#endif
+		}
+
+		printf("Headless run: %u frames, dt %.4f s, fixed rate %.1f Hz, %u bodies, %u threads\n",
+			settings.frames, settings.dt, settings.fixed_rate, settings.bodies, high_priority_job_queue.get_num_threads() + 1);
+
+		std::map<std::string, SystemTiming> normal_timings;
+		std::map<std::string, SystemTiming> fixed_timings;
+
+		std::vector<double> frame_times;
+		frame_times.reserve(settings.frames);
+
+		const float fixed_dt = game_world->get_fixed_update_dt();
+		float fixed_accumulator = 0.0f;
+		uint32 fixed_steps = 0;
+
+		const auto run_start = clock::now();
+
+		for (uint32 frame = 0; frame < settings.frames; ++frame)
+		{
+			const auto frame_start = clock::now();
+
+			frame_allocator.begin_frame();
+
+			scheduler->update_normal(settings.dt);
+			accumulate_timings(scheduler->get_normal_timings(), normal_timings);
+
+			fixed_accumulator += settings.dt;
+			while (fixed_accumulator >= fixed_dt)
+			{
+				scheduler->run_fixed_step(fixed_dt);
+				accumulate_timings(scheduler->get_fixed_timings(), fixed_timings);
+
+				fixed_accumulator -= fixed_dt;
+				++fixed_steps;
+			}
+
+			execute_main_thread_jobs();
+
+			frame_times.push_back(std::chrono::duration<double, std::milli>(clock::now() - frame_start).count());
+
+			if (tracing)
+			{
+				report_job_system_stats();
+				cpu_profiling_frame_end_marker();
+				cpu_profiling_resolve_time_stamps();
+			}
+		}
+
+		if (tracing)
+		{
+			end_cpu_profile_capture();
+			printf(" Trace written to '%s', %llu profile events dropped\n", settings.trace_path.c_str(), (unsigned long long)get_num_dropped_cpu_profile_events());
+		}
+
+		const double run_ms = std::chrono::duration<double, std::milli>(clock::now() - run_start).count();
+
+		std::sort(frame_times.begin(), frame_times.end());
+		printf(" %u frames, %u fixed steps in %.1f ms: frame min %.4f ms, median %.4f ms, mean %.4f ms, p99 %.4f ms, max %.4f ms\n",
+			settings.frames,
+			fixed_steps,
+			run_ms,
+			frame_times.front(),
+			frame_times[frame_times.size() / 2],
+			run_ms / settings.frames,
+			frame_times[std::min(frame_times.size() - 1, frame_times.size() * 99 / 100)],
+			frame_times.back());
+
+		report_timings("Normal update", normal_timings, settings.frames);
+		report_timings("Fixed update", fixed_timings, settings.frames);
+	}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+namespace era_engine
+{
+
+	// Ticks the gameplay world without a window, a device or ImGui: only the "base", "physics", "animation" and
+	// "motion_matching" systems are created, so rendering systems are never constructed. Frames run back to back with a
+	// fixed step and per-system timings are reported at the end, for CI and dedicated server performance runs.
+	class HeadlessStartup final
+	{
+	public:
+		HeadlessStartup() = default;
+		~HeadlessStartup() = default;
+
+		void start(int argc, char** argv);
+	};
+
+}
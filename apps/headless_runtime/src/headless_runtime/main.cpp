@@ -0,0 +1,27 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+#include <iostream>
+
+#include "headless_runtime/headless_startup.h"
+
+int main(int argc, char** argv)
+{
+	using namespace era_engine;
+
+	HeadlessStartup startup;
+
+	int result = EXIT_SUCCESS;
+
+	try
+	{
+		startup.start(argc, argv);
+	}
+	catch (const std::exception& ex)
+	{
+		std::cerr << "Runtime Error> " << ex.what() << "\n";
+		result = EXIT_FAILURE;
+	}
+
+	// Job queue workers are detached and parked forever, so don't run static destructors under them.
+	fflush(stdout);
+	std::quick_exit(result);
+}
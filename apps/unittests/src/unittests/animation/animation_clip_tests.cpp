@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include <animation/animation_clip.h>
+#include <animation/animation_clip_utils.h>
+#include <animation/skeleton.h>
+
+#include <sstream>
+
+// A chain of joints swinging smoothly around different axes, two seconds at 30 Hz.
+static era_engine::animation::ClipInfo create_test_clip_info(uint32 num_joints)
+{
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ClipInfo info;
+	info.sample_rate = 30.0f;
+	info.num_samples = 61;
+
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		TrackInfo& track = info.tracks.emplace_back();
+		track.joint_id = "joint_" + std::to_string(joint);
+		track.parent_index = joint == 0 ? INVALID_JOINT : joint - 1;
+
+		for (uint32 sample = 0; sample < info.num_samples; ++sample)
+		{
+			const float t = (float)sample / info.sample_rate;
+			const float angle = 0.5f * sinf(t * 3.0f + (float)joint);
+			const vec3 position = joint == 0 ? vec3(t, 0.0f, 0.5f * t) : vec3(0.0f, 0.25f, 0.0f);
+
+			track.joint_transforms.push_back(trs(position, euler_to_quat(vec3(angle, 0.5f * angle, 0.0f)), vec3(1.0f)));
+		}
+	}
+
+	CurveInfo& curve = info.curves.emplace_back();
+	curve.curve_id = "foot_lock";
+	for (uint32 sample = 0; sample < info.num_samples; ++sample)
+	{
+		curve.values.push_back((float)sample / (float)(info.num_samples - 1));
+	}
+
+	return info;
+}
+
+static void expect_poses_near(const era_engine::animation::SkeletonPose& expected, const era_engine::animation::SkeletonPose& actual)
+{
+	using namespace era_engine;
+
+	ASSERT_EQ(expected.size(), actual.size());
+	for (uint32 joint = 0; joint < expected.size(); ++joint)
+	{
+		const vec3 expected_position = expected.get_joint_translation(joint);
+		const vec3 actual_position = actual.get_joint_translation(joint);
+		EXPECT_NEAR(expected_position.x, actual_position.x, 2e-3f);
+		EXPECT_NEAR(expected_position.y, actual_position.y, 2e-3f);
+		EXPECT_NEAR(expected_position.z, actual_position.z, 2e-3f);
+
+		EXPECT_GT(fabsf(dot(expected.get_joint_rotation(joint), actual.get_joint_rotation(joint))), 0.9999f);
+	}
+}
+
+TEST(Animation_Clip, CompressedSamplingMatchesRaw) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	constexpr uint32 num_joints = 16;
+	const ClipInfo info = create_test_clip_info(num_joints);
+
+	ref<AnimationAssetClip> raw = AnimationAssetClipUtils::make_clip(info);
+	ref<AnimationAssetClip> compressed = AnimationAssetClipUtils::make_clip(info);
+
+	ASSERT_TRUE(compressed->compress());
+	EXPECT_TRUE(compressed->is_compressed());
+	EXPECT_FALSE(raw->is_compressed());
+
+	EXPECT_FLOAT_EQ(compressed->get_duration(), raw->get_duration());
+	EXPECT_EQ(compressed->get_num_samples_per_track(), raw->get_num_samples_per_track());
+	EXPECT_LT(compressed->get_memory_footprint(), raw->get_memory_footprint());
+
+	AnimationClipSamplingContext context;
+	for (float time = 0.0f; time <= raw->get_duration(); time += 0.0371f)
+	{
+		SkeletonPose expected(num_joints);
+		SkeletonPose actual(num_joints);
+
+		raw->sample_joints(time, expected);
+		compressed->sample_joints(context, time, actual, {});
+
+		expect_poses_near(expected, actual);
+
+		float expected_curve = 0.0f;
+		float actual_curve = 0.0f;
+		raw->sample_curve(time, 0, expected_curve);
+		compressed->sample_curve(time, 0, actual_curve);
+		EXPECT_NEAR(expected_curve, actual_curve, 2e-3f);
+	}
+}
+
+TEST(Animation_Clip, SamplingContextFollowsClip) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ref<AnimationAssetClip> first = AnimationAssetClipUtils::make_clip(create_test_clip_info(4));
+	ref<AnimationAssetClip> second = AnimationAssetClipUtils::make_clip(create_test_clip_info(8));
+	ASSERT_TRUE(first->compress());
+	ASSERT_TRUE(second->compress());
+
+	AnimationClipSamplingContext context;
+
+	SkeletonPose first_pose(4);
+	first->sample_joints(context, 0.5f, first_pose, {});
+
+	// The same context is re-bound when it is handed a different clip.
+	SkeletonPose shared_context_pose(8);
+	SkeletonPose fresh_context_pose(8);
+	second->sample_joints(context, 0.5f, shared_context_pose, {});
+	second->sample_joints(0.5f, fresh_context_pose);
+
+	expect_poses_near(fresh_context_pose, shared_context_pose);
+}
+
+TEST(Animation_Clip, JointMappingSkipsDisabledJoints) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ref<AnimationAssetClip> clip = AnimationAssetClipUtils::make_clip(create_test_clip_info(4));
+	ASSERT_TRUE(clip->compress());
+
+	// Track 1 is disabled, the others land in reverse order.
+	const std::vector<uint32> mapping = { 3, INVALID_JOINT, 1, 0 };
+
+	const vec3 marker(42.0f, 42.0f, 42.0f);
+	SkeletonPose pose(4);
+	pose.set_joint_translation(marker, 2);
+
+	SkeletonPose expected(4);
+	clip->sample_joints(1.0f, expected);
+
+	AnimationClipSamplingContext context;
+	clip->sample_joints(context, 1.0f, pose, mapping);
+
+	EXPECT_EQ(pose.get_joint_translation(2).x, marker.x);
+	EXPECT_NEAR(pose.get_joint_translation(3).x, expected.get_joint_translation(0).x, 1e-6f);
+	EXPECT_NEAR(pose.get_joint_translation(0).y, expected.get_joint_translation(3).y, 1e-6f);
+}
+
+TEST(Animation_Clip, SerializationStoresCompressedTracks) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	constexpr uint32 num_joints = 16;
+	ref<AnimationAssetClip> raw = AnimationAssetClipUtils::make_clip(create_test_clip_info(num_joints));
+
+	std::stringstream stream;
+	ASSERT_TRUE(raw->serialize(stream));
+
+	// Raw clips are compressed on the way out but stay raw themselves.
+	EXPECT_FALSE(raw->is_compressed());
+	EXPECT_LT(stream.str().size(), raw->get_memory_footprint());
+
+	AnimationAssetClip loaded;
+	ASSERT_TRUE(loaded.deserialize(stream));
+	EXPECT_TRUE(loaded.is_compressed());
+	EXPECT_EQ(loaded.get_joint_mapping(), raw->get_joint_mapping());
+	EXPECT_EQ(loaded.get_curve_mapping(), raw->get_curve_mapping());
+
+	SkeletonPose expected(num_joints);
+	SkeletonPose actual(num_joints);
+	raw->sample_joints(1.3f, expected);
+	loaded.sample_joints(1.3f, actual);
+	expect_poses_near(expected, actual);
+
+	// Corrupted compressed data is rejected instead of being sampled.
+	std::string corrupted = stream.str();
+	corrupted[corrupted.size() / 2] ^= 0x5A;
+	std::stringstream corrupted_stream(corrupted);
+
+	AnimationAssetClip rejected;
+	EXPECT_FALSE(rejected.deserialize(corrupted_stream));
+}
+
+TEST(Animation_Clip, CurvesCanBeEditedAfterCompression) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ref<AnimationAssetClip> clip = AnimationAssetClipUtils::make_clip(create_test_clip_info(4));
+	ASSERT_TRUE(clip->compress());
+
+	const uint32 num_samples = clip->get_num_samples_per_track();
+	clip->add_curve("constant", std::vector<float>(num_samples, 0.75f));
+	EXPECT_TRUE(clip->is_compressed());
+	ASSERT_EQ(clip->get_curve_mapping().size(), 2);
+
+	float value = 0.0f;
+	ASSERT_TRUE(clip->sample_curve(0.4f, "constant", value));
+	EXPECT_NEAR(value, 0.75f, 2e-3f);
+
+	clip->remove_curve("foot_lock");
+	ASSERT_EQ(clip->get_curve_mapping().size(), 1);
+	EXPECT_EQ(clip->get_curve_mapping().at("constant"), 0);
+
+	std::vector<float> values(1);
+	AnimationClipSamplingContext context;
+	clip->sample_curves(context, 1.2f, values);
+	EXPECT_NEAR(values[0], 0.75f, 2e-3f);
+}
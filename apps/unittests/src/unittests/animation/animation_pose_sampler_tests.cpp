@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <animation/animation_clip.h>
+#include <animation/animation_clip_utils.h>
+#include <animation/animation_pose_sampler.h>
+#include <animation/skeleton.h>
+
+// One track per listed joint name, one second at 30 Hz.
+static ref<era_engine::animation::AnimationAssetClip> create_named_clip(const std::vector<std::string>& joint_names)
+{
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ClipInfo info;
+	info.sample_rate = 30.0f;
+	info.num_samples = 31;
+
+	for (uint32 joint = 0; joint < (uint32)joint_names.size(); ++joint)
+	{
+		TrackInfo& track = info.tracks.emplace_back();
+		track.joint_id = joint_names[joint];
+		track.parent_index = joint == 0 ? INVALID_JOINT : joint - 1;
+
+		for (uint32 sample = 0; sample < info.num_samples; ++sample)
+		{
+			const float t = (float)sample / info.sample_rate;
+			track.joint_transforms.push_back(trs(vec3((float)joint, t, 0.0f), quat::identity, vec3(1.0f)));
+		}
+	}
+
+	return AnimationAssetClipUtils::make_clip(info);
+}
+
+static ref<era_engine::animation::Skeleton> create_named_skeleton(const std::vector<std::string>& joint_names)
+{
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ref<Skeleton> skeleton = make_ref<Skeleton>();
+	for (uint32 joint = 0; joint < (uint32)joint_names.size(); ++joint)
+	{
+		SkeletonJoint& skeleton_joint = skeleton->joints.emplace_back();
+		skeleton_joint.name = joint_names[joint];
+		skeleton_joint.parent_id = joint == 0 ? INVALID_JOINT : joint - 1;
+
+		skeleton->local_transforms.emplace_back(trs::identity);
+		skeleton->name_to_joint_id[skeleton_joint.name] = joint;
+	}
+	return skeleton;
+}
+
+TEST(Animation_PoseSampler, CachedMappingMatchesNameLookup) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ref<AnimationAssetClip> clip = create_named_clip({ "root", "spine", "head", "tail" });
+	ref<Skeleton> skeleton = create_named_skeleton({ "root", "head", "spine", "arm" });
+
+	std::vector<uint32> expected;
+	AnimationPoseSampler::build_joint_mapping(skeleton.get(), clip.get(), expected);
+
+	const std::vector<uint32> by_name = { 0, 2, 1, INVALID_JOINT };
+	EXPECT_EQ(expected, by_name);
+
+	JointMappingCache cache;
+	ref<const std::vector<uint32>> cached = cache.get_joint_mapping(skeleton, clip);
+	ASSERT_NE(cached, nullptr);
+	EXPECT_EQ(*cached, expected);
+
+	// Every further lookup for the pair shares the same mapping.
+	EXPECT_EQ(cache.get_joint_mapping(skeleton, clip), cached);
+	EXPECT_EQ(cache.size(), 1);
+
+	AnimationPoseSampler lookup_sampler;
+	lookup_sampler.init(skeleton.get(), clip);
+
+	AnimationPoseSampler cached_sampler;
+	cached_sampler.init(skeleton.get(), clip, *cached);
+
+	SkeletonPose expected_pose(4);
+	SkeletonPose cached_pose(4);
+	lookup_sampler.sample_pose(0.5f, expected_pose);
+	cached_sampler.sample_pose(0.5f, cached_pose);
+
+	for (uint32 joint = 0; joint < 4; ++joint)
+	{
+		EXPECT_EQ(expected_pose.get_joint_translation(joint).x, cached_pose.get_joint_translation(joint).x);
+		EXPECT_EQ(expected_pose.get_joint_translation(joint).y, cached_pose.get_joint_translation(joint).y);
+	}
+}
+
+TEST(Animation_PoseSampler, CacheDoesNotReuseMappingsOfDestroyedAssets) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	ref<Skeleton> skeleton = create_named_skeleton({ "a", "b" });
+
+	JointMappingCache cache;
+	for (uint32 i = 0; i < 200; ++i)
+	{
+		// A new clip may land on the address of the previous one, with different tracks.
+		ref<AnimationAssetClip> clip = (i % 2 == 0) ? create_named_clip({ "a", "b" }) : create_named_clip({ "b" });
+
+		std::vector<uint32> expected;
+		AnimationPoseSampler::build_joint_mapping(skeleton.get(), clip.get(), expected);
+
+		EXPECT_EQ(*cache.get_joint_mapping(skeleton, clip), expected);
+	}
+
+	// Entries of destroyed clips are dropped as the cache grows.
+	EXPECT_LE(cache.size(), 128);
+}
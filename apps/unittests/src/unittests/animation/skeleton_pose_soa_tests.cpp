@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include <animation/skeleton.h>
+#include <animation/skeleton_pose_soa.h>
+
+#include <random>
+
+static constexpr float soa_pose_tolerance = 1e-4f;
+
+static trs random_transform(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> angle(-M_PI, M_PI);
+	std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+	return trs(vec3(offset(rng), offset(rng), offset(rng)), euler_to_quat(vec3(angle(rng), angle(rng), angle(rng))), vec3(scale(rng), scale(rng), scale(rng)));
+}
+
+static std::vector<trs> random_transforms(uint32 size, uint32 seed)
+{
+	std::mt19937 rng(seed);
+
+	std::vector<trs> result(size);
+	for (trs& transform : result)
+	{
+		transform = random_transform(rng);
+	}
+	return result;
+}
+
+static era_engine::animation::SoaSkeletonPose make_soa_pose(const std::vector<trs>& transforms)
+{
+	era_engine::animation::SoaSkeletonPose pose((uint32)transforms.size());
+	for (uint32 joint = 0; joint < (uint32)transforms.size(); ++joint)
+	{
+		pose.set_joint_transform(transforms[joint], joint);
+	}
+	return pose;
+}
+
+// q and -q are the same rotation.
+static void expect_near(const trs& expected, const trs& actual)
+{
+	const float sign = dot(expected.rotation, actual.rotation) < 0.0f ? -1.0f : 1.0f;
+	EXPECT_NEAR(expected.rotation.x, sign * actual.rotation.x, soa_pose_tolerance);
+	EXPECT_NEAR(expected.rotation.y, sign * actual.rotation.y, soa_pose_tolerance);
+	EXPECT_NEAR(expected.rotation.z, sign * actual.rotation.z, soa_pose_tolerance);
+	EXPECT_NEAR(expected.rotation.w, sign * actual.rotation.w, soa_pose_tolerance);
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		EXPECT_NEAR(expected.position.data[i], actual.position.data[i], soa_pose_tolerance);
+		EXPECT_NEAR(expected.scale.data[i], actual.scale.data[i], soa_pose_tolerance);
+	}
+}
+
+static void expect_near(const mat4& expected, const mat4& actual)
+{
+	for (uint32 i = 0; i < 16; ++i)
+	{
+		EXPECT_NEAR(expected.m[i], actual.m[i], soa_pose_tolerance * 10.0f) << "element " << i;
+	}
+}
+
+TEST(Animation_SoaPose, BlendMatchesScalar) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	// Not a multiple of the lane count, so the last group is partially padding.
+	const uint32 num_joints = 37;
+	const std::vector<trs> from = random_transforms(num_joints, 1);
+	const std::vector<trs> to = random_transforms(num_joints, 2);
+
+	SoaSkeletonPose soa_from = make_soa_pose(from);
+	SoaSkeletonPose soa_to = make_soa_pose(to);
+	SoaSkeletonPose nlerp_result(num_joints);
+	SoaSkeletonPose slerp_result(num_joints);
+
+	for (float t : { 0.0f, 0.3f, 0.75f, 1.0f })
+	{
+		SoaPoseUtils::blend_nlerp(soa_from, soa_to, t, nlerp_result);
+		SoaPoseUtils::blend_slerp(soa_from, soa_to, t, slerp_result);
+
+		for (uint32 joint = 0; joint < num_joints; ++joint)
+		{
+			const trs expected_nlerp(lerp(from[joint].position, to[joint].position, t), nlerp_shortest(from[joint].rotation, to[joint].rotation, t),
+				lerp(from[joint].scale, to[joint].scale, t));
+			const trs expected_slerp(expected_nlerp.position, slerp_shortest_approx(from[joint].rotation, to[joint].rotation, t), expected_nlerp.scale);
+
+			expect_near(expected_nlerp, nlerp_result.get_joint_transform(joint));
+			expect_near(expected_slerp, slerp_result.get_joint_transform(joint));
+		}
+	}
+
+	// In place.
+	SoaPoseUtils::blend_nlerp(soa_from, soa_to, 0.5f, soa_from);
+	SoaPoseUtils::blend_nlerp(make_soa_pose(from), soa_to, 0.5f, nlerp_result);
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		expect_near(nlerp_result.get_joint_transform(joint), soa_from.get_joint_transform(joint));
+	}
+}
+
+TEST(Animation_SoaPose, MaskedAndAdditiveLayers) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	const uint32 num_joints = 21;
+	const std::vector<trs> base = random_transforms(num_joints, 3);
+	const std::vector<trs> layer = random_transforms(num_joints, 4);
+
+	std::vector<float> weights(num_joints);
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		weights[joint] = (float)(joint % 5) / 4.0f;
+	}
+
+	SoaSkeletonPose soa_base = make_soa_pose(base);
+	SoaSkeletonPose soa_layer = make_soa_pose(layer);
+
+	SoaSkeletonPose masked(num_joints);
+	SoaPoseUtils::blend_masked(soa_base, soa_layer, weights.data(), masked);
+
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		const float t = weights[joint];
+		const trs expected(lerp(base[joint].position, layer[joint].position, t), nlerp_shortest(base[joint].rotation, layer[joint].rotation, t),
+			lerp(base[joint].scale, layer[joint].scale, t));
+		expect_near(expected, masked.get_joint_transform(joint));
+	}
+
+	// The full additive difference brings the reference back to the original pose, a zero weight keeps the base.
+	SoaSkeletonPose additive(num_joints);
+	SoaPoseUtils::make_additive(soa_layer, soa_base, additive);
+
+	SoaSkeletonPose full(num_joints);
+	SoaSkeletonPose none(num_joints);
+	SoaPoseUtils::apply_additive(soa_base, additive, 1.0f, full);
+	SoaPoseUtils::apply_additive(soa_base, additive, 0.0f, none);
+
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		expect_near(layer[joint], full.get_joint_transform(joint));
+		expect_near(base[joint], none.get_joint_transform(joint));
+	}
+}
+
+TEST(Animation_SoaPose, SkinningMatchesScalar) {
+
+	using namespace era_engine;
+	using namespace era_engine::animation;
+
+	const uint32 num_joints = 53;
+	std::mt19937 rng(5);
+
+	// Random tree, with a second root and a long chain so that some groups end early.
+	Skeleton skeleton;
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		SkeletonJoint& skeleton_joint = skeleton.joints.emplace_back();
+		skeleton_joint.name = "joint_" + std::to_string(joint);
+		if (joint == 0 || joint == 30)
+		{
+			skeleton_joint.parent_id = INVALID_JOINT;
+		}
+		else if (joint > 40)
+		{
+			skeleton_joint.parent_id = joint - 1;
+		}
+		else
+		{
+			skeleton_joint.parent_id = std::uniform_int_distribution<uint32>(0, joint - 1)(rng);
+		}
+		skeleton_joint.inv_bind_transform = trs_to_mat4(random_transform(rng));
+		skeleton_joint.bind_transform = invert(skeleton_joint.inv_bind_transform);
+
+		skeleton.local_transforms.emplace_back(random_transform(rng));
+	}
+
+	const trs world_transform = random_transform(rng);
+
+	std::vector<trs> expected_globals(num_joints);
+	std::vector<mat4> expected_skinning(num_joints);
+	skeleton.get_skinning_matrices_from_local_transforms(expected_globals.data(), expected_skinning.data(), world_transform);
+
+	SoaSkeletonHierarchy hierarchy(skeleton);
+	EXPECT_EQ(hierarchy.size(), num_joints);
+
+	SoaSkeletonPose local_pose(num_joints);
+	local_pose.load(skeleton.local_transforms);
+
+	std::vector<trs> globals(num_joints);
+	std::vector<mat4> skinning(num_joints);
+	SoaPoseUtils::get_skinning_matrices(hierarchy, local_pose, globals.data(), skinning.data(), world_transform);
+
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		expect_near(expected_globals[joint], globals[joint]);
+		expect_near(expected_skinning[joint], skinning[joint]);
+	}
+
+	std::vector<mat4> local_matrices(num_joints);
+	SoaPoseUtils::get_local_matrices(local_pose, local_matrices.data());
+	for (uint32 joint = 0; joint < num_joints; ++joint)
+	{
+		expect_near(trs_to_mat4(skeleton.local_transforms[joint].get_transform()), local_matrices[joint]);
+	}
+}
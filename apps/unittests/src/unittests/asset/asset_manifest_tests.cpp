@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <asset/asset_manifest.h>
+#include <asset/bin.h>
+
+#include <fstream>
+
+static era_engine::AssetManifestEntry create_test_entry(uint32 mesh_flags)
+{
+	using namespace era_engine;
+
+	AssetManifestEntry entry;
+	entry.source_size = 123456;
+	entry.source_write_time = 1700000000123;
+	entry.content_hash = 0xDEADBEEFCAFEF00Dull;
+	entry.importer_version = model_importer_version;
+	entry.mesh_flags = mesh_flags;
+	return entry;
+}
+
+TEST(AssetManifest, RoundTrip)
+{
+	using namespace era_engine;
+
+	const fs::path path = fs::temp_directory_path() / "era_asset_manifest_round_trip.txt";
+
+	AssetManifest manifest;
+	manifest.set("assets/meshes/box.fbx", create_test_entry(1));
+	manifest.set("assets/meshes/with space/sponza atrium.fbx", create_test_entry(3));
+
+	ASSERT_TRUE(manifest.save(path));
+
+	fs::path temp_path = path;
+	temp_path += ".tmp";
+	ASSERT_FALSE(fs::exists(temp_path));
+
+	AssetManifest loaded;
+	loaded.load(path);
+
+	ASSERT_EQ(loaded.size(), 2u);
+
+	const AssetManifestEntry* entry = loaded.find("assets/meshes/with space/sponza atrium.fbx");
+	ASSERT_TRUE(entry != nullptr);
+
+	const AssetManifestEntry expected = create_test_entry(3);
+	ASSERT_EQ(entry->source_size, expected.source_size);
+	ASSERT_EQ(entry->source_write_time, expected.source_write_time);
+	ASSERT_EQ(entry->content_hash, expected.content_hash);
+	ASSERT_EQ(entry->importer_version, expected.importer_version);
+	ASSERT_EQ(entry->mesh_flags, expected.mesh_flags);
+
+	ASSERT_TRUE(loaded.find("assets/meshes/box.fbx") != nullptr);
+	ASSERT_TRUE(loaded.find("assets/meshes/missing.fbx") == nullptr);
+
+	fs::remove(path);
+}
+
+TEST(AssetManifest, MissingOrForeignFileIsEmpty)
+{
+	using namespace era_engine;
+
+	AssetManifest manifest;
+	manifest.set("stale", create_test_entry(1));
+	manifest.load(fs::temp_directory_path() / "era_asset_manifest_does_not_exist.txt");
+	ASSERT_EQ(manifest.size(), 0u);
+
+	const fs::path path = fs::temp_directory_path() / "era_asset_manifest_foreign.txt";
+	{
+		std::ofstream output(path, std::ios::trunc);
+		output << "some other file\n";
+		output << "0 2 1 10 10\tassets/meshes/box.fbx\n";
+	}
+
+	manifest.load(path);
+	ASSERT_EQ(manifest.size(), 0u);
+
+	fs::remove(path);
+}
+
+TEST(AssetManifest, Freshness)
+{
+	using namespace era_engine;
+
+	const std::string key = "assets/meshes/box.fbx";
+	const AssetManifestEntry entry = create_test_entry(1);
+
+	AssetManifest manifest;
+	ASSERT_FALSE(manifest.is_up_to_date(key, 1, entry.source_size, entry.source_write_time));
+	ASSERT_FALSE(manifest.is_unchanged(key, 1, entry.content_hash));
+
+	manifest.set(key, entry);
+
+	// Same fingerprint: skipped without reading the source.
+	ASSERT_TRUE(manifest.is_up_to_date(key, 1, entry.source_size, entry.source_write_time));
+	ASSERT_FALSE(manifest.is_up_to_date(key, 1, entry.source_size + 1, entry.source_write_time));
+	ASSERT_FALSE(manifest.is_up_to_date(key, 1, entry.source_size, entry.source_write_time + 1));
+
+	// Touched source: only the content hash decides.
+	ASSERT_TRUE(manifest.is_unchanged(key, 1, entry.content_hash));
+	ASSERT_FALSE(manifest.is_unchanged(key, 1, entry.content_hash + 1));
+
+	// Different mesh flags need a rebuild, whatever the source looks like.
+	ASSERT_FALSE(manifest.is_cache_current(key, 3));
+	ASSERT_FALSE(manifest.is_up_to_date(key, 3, entry.source_size, entry.source_write_time));
+	ASSERT_FALSE(manifest.is_unchanged(key, 3, entry.content_hash));
+
+	// So does a cache written by an older importer.
+	AssetManifestEntry old_entry = entry;
+	old_entry.importer_version = model_importer_version - 1;
+	manifest.set(key, old_entry);
+
+	ASSERT_FALSE(manifest.is_cache_current(key, 1));
+	ASSERT_FALSE(manifest.is_up_to_date(key, 1, entry.source_size, entry.source_write_time));
+	ASSERT_FALSE(manifest.is_unchanged(key, 1, entry.content_hash));
+}
@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+
+#include <asset/bin.h>
+#include <asset/io.h>
+#include <asset/model_asset.h>
+#include <core/hash.h>
+#include <rendering/pbr_material.h>
+
+static era_engine::ModelAsset create_test_model()
+{
+	using namespace era_engine;
+
+	ModelAsset result;
+	result.flags = 3;
+
+	MeshAsset& mesh = result.meshes.emplace_back();
+	mesh.name = "test_mesh";
+	mesh.skeleton_index = -1;
+
+	for (uint32 s = 0; s < 2; ++s)
+	{
+		SubmeshAsset& submesh = mesh.submeshes.emplace_back();
+		submesh.material_index = (int32)s;
+
+		constexpr uint32 num_vertices = 4096;
+		for (uint32 i = 0; i < num_vertices; ++i)
+		{
+			submesh.positions.push_back(vec3((float)(i % 64), (float)(i / 64), 0.0f));
+			submesh.normals.push_back(vec3(0.0f, 0.0f, 1.0f));
+			submesh.uvs.push_back(vec2((float)(i % 64) / 64.0f, (float)(i / 64) / 64.0f));
+			submesh.colors.push_back(0xFF00FF00 | i);
+		}
+		for (uint32 i = 0; i + 2 < num_vertices; ++i)
+		{
+			submesh.triangles.push_back({ (uint16)i, (uint16)(i + 1), (uint16)(i + 2) });
+		}
+	}
+
+	PbrMaterialDesc& material = result.materials.emplace_back();
+	material.albedo = "albedo.png";
+	material.roughness_override = 0.5f;
+
+	return result;
+}
+
+template <typename T>
+static void write_value(std::vector<uint8>& out, const T& value)
+{
+	const uint8* bytes = (const uint8*)&value;
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void write_file(const fs::path& path, const void* data, uint64 size)
+{
+	FILE* out = fopen(path.string().c_str(), "wb");
+	fwrite(data, 1, size, out);
+	fclose(out);
+}
+
+TEST(Asset_Bin, RoundTrip) {
+
+	using namespace era_engine;
+
+	const ModelAsset model = create_test_model();
+	const fs::path path = fs::temp_directory_path() / "era_bin_round_trip.bin";
+
+	for (bool compress : { false, true })
+	{
+		writeBIN(model, path, compress);
+		ModelAsset loaded = loadBIN(path);
+
+		EXPECT_EQ(loaded.flags, model.flags);
+		ASSERT_EQ(loaded.meshes.size(), 1);
+		ASSERT_EQ(loaded.materials.size(), 1);
+		EXPECT_EQ(loaded.meshes[0].name, model.meshes[0].name);
+		EXPECT_EQ(loaded.meshes[0].skeleton_index, -1);
+		EXPECT_EQ(loaded.materials[0].albedo, model.materials[0].albedo);
+		EXPECT_EQ(loaded.materials[0].roughness_override, 0.5f);
+
+		ASSERT_EQ(loaded.meshes[0].submeshes.size(), 2);
+		for (uint32 s = 0; s < 2; ++s)
+		{
+			const SubmeshAsset& expected = model.meshes[0].submeshes[s];
+			const SubmeshAsset& actual = loaded.meshes[0].submeshes[s];
+
+			EXPECT_EQ(actual.material_index, expected.material_index);
+			ASSERT_EQ(actual.positions.size(), expected.positions.size());
+			ASSERT_EQ(actual.uvs.size(), expected.uvs.size());
+			ASSERT_EQ(actual.colors.size(), expected.colors.size());
+			ASSERT_EQ(actual.triangles.size(), expected.triangles.size());
+			EXPECT_EQ(memcmp(actual.positions.data(), expected.positions.data(), expected.positions.size() * sizeof(vec3)), 0);
+			EXPECT_EQ(memcmp(actual.uvs.data(), expected.uvs.data(), expected.uvs.size() * sizeof(vec2)), 0);
+			EXPECT_EQ(memcmp(actual.colors.data(), expected.colors.data(), expected.colors.size() * sizeof(uint32)), 0);
+			EXPECT_EQ(memcmp(actual.triangles.data(), expected.triangles.data(), expected.triangles.size() * sizeof(indexed_triangle16)), 0);
+		}
+	}
+
+	fs::remove(path);
+}
+
+TEST(Asset_Bin, SelectsStreamsByMeshFlags) {
+
+	using namespace era_engine;
+
+	const fs::path path = fs::temp_directory_path() / "era_bin_streams.bin";
+	writeBIN(create_test_model(), path);
+
+	ModelAsset loaded = loadBIN(path, mesh_flag_load_normals);
+	ASSERT_EQ(loaded.meshes.size(), 1);
+
+	const SubmeshAsset& submesh = loaded.meshes[0].submeshes[0];
+	EXPECT_EQ(submesh.positions.size(), 4096);
+	EXPECT_EQ(submesh.normals.size(), 4096);
+	EXPECT_FALSE(submesh.triangles.empty());
+	EXPECT_TRUE(submesh.uvs.empty());
+	EXPECT_TRUE(submesh.colors.empty());
+
+	fs::remove(path);
+}
+
+TEST(Asset_Bin, RejectsCorruptedStream) {
+
+	using namespace era_engine;
+
+	const fs::path path = fs::temp_directory_path() / "era_bin_corrupted.bin";
+	writeBIN(create_test_model(), path);
+
+	EntireFile file = load_file(path);
+	ASSERT_NE(file.content, nullptr);
+
+	// The last stream ends the file, so this flips a byte of stream data.
+	file.content[file.size - 1] ^= 0xFF;
+
+	FILE* out = fopen(path.string().c_str(), "wb");
+	fwrite(file.content, 1, file.size, out);
+	fclose(out);
+	free_file(file);
+
+	ModelAsset loaded = loadBIN(path);
+	EXPECT_TRUE(loaded.meshes.empty());
+
+	fs::remove(path);
+}
+
+TEST(Asset_Bin, LoadsVersion1) {
+
+	using namespace era_engine;
+
+	// Laid out like the v1 writer did: header, then per mesh its header, name and per submesh a header followed by the
+	// arrays its flags announce and the triangles.
+	const vec3 positions[] = { vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f) };
+	const vec3 normals[] = { vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, 1.0f) };
+	const uint16 triangle[] = { 0, 1, 2 };
+	const char name[] = "v1_mesh";
+
+	std::vector<uint8> data;
+	write_value(data, BinaryHeader{ BIN_HEADER, 1 });
+	for (uint32 value : { 5u, 1u, 0u, 0u, 0u }) // Flags, meshes, materials, skeletons, animations.
+	{
+		write_value(data, value);
+	}
+
+	write_value(data, 1u); // Submeshes.
+	write_value(data, -1); // Skeleton index.
+	write_value(data, (uint32)(sizeof(name) - 1));
+	data.insert(data.end(), name, name + sizeof(name) - 1);
+
+	for (uint32 value : { 3u, 1u, 0u, (1u << 0) | (1u << 2) }) // Vertices, triangles, material index, positions and normals.
+	{
+		write_value(data, value);
+	}
+	write_value(data, positions);
+	write_value(data, normals);
+	write_value(data, triangle);
+
+	const fs::path path = fs::temp_directory_path() / "era_bin_version_1.bin";
+	write_file(path, data.data(), data.size());
+
+	ModelAsset loaded = loadBIN(path);
+
+	EXPECT_EQ(loaded.flags, 5u);
+	ASSERT_EQ(loaded.meshes.size(), 1u);
+	EXPECT_TRUE(loaded.materials.empty());
+	EXPECT_EQ(loaded.meshes[0].name, "v1_mesh");
+	EXPECT_EQ(loaded.meshes[0].skeleton_index, -1);
+
+	ASSERT_EQ(loaded.meshes[0].submeshes.size(), 1u);
+	const SubmeshAsset& submesh = loaded.meshes[0].submeshes[0];
+	EXPECT_EQ(submesh.material_index, 0);
+	ASSERT_EQ(submesh.positions.size(), 3u);
+	ASSERT_EQ(submesh.normals.size(), 3u);
+	ASSERT_EQ(submesh.triangles.size(), 1u);
+	EXPECT_TRUE(submesh.uvs.empty());
+	EXPECT_EQ(memcmp(submesh.positions.data(), positions, sizeof(positions)), 0);
+	EXPECT_EQ(memcmp(submesh.normals.data(), normals, sizeof(normals)), 0);
+	EXPECT_EQ(memcmp(submesh.triangles.data(), triangle, sizeof(triangle)), 0);
+
+	fs::remove(path);
+}
+
+TEST(Asset_Bin, RejectsDuplicateStreams) {
+
+	using namespace era_engine;
+
+	const fs::path path = fs::temp_directory_path() / "era_bin_duplicate_stream.bin";
+	writeBIN(create_test_model(), path, false);
+
+	EntireFile file = load_file(path);
+	ASSERT_NE(file.content, nullptr);
+
+	// Offsets into bin_header_v2 and the size of a bin_stream_entry.
+	constexpr uint64 num_streams_field = 28;
+	constexpr uint64 metadata_offset_field = 32;
+	constexpr uint64 stream_table_offset_field = 48;
+	constexpr uint64 checksum_field = 56;
+	constexpr uint64 stream_entry_size = 48;
+
+	uint64 metadata_offset, metadata_size, stream_table_offset;
+	uint32 num_streams;
+	memcpy(&metadata_offset, file.content + metadata_offset_field, sizeof(uint64));
+	memcpy(&metadata_size, file.content + metadata_offset_field + sizeof(uint64), sizeof(uint64));
+	memcpy(&stream_table_offset, file.content + stream_table_offset_field, sizeof(uint64));
+	memcpy(&num_streams, file.content + num_streams_field, sizeof(uint32));
+	ASSERT_GE(num_streams, 2u);
+
+	// The second stream becomes another copy of the first (positions of the first submesh). The checksum is fixed up, so
+	// that only the table validation can catch it.
+	uint8* table = file.content + stream_table_offset;
+	memcpy(table + stream_entry_size, table, stream_entry_size);
+
+	const uint64 checksum = hash_bytes(table, stream_entry_size * num_streams, hash_bytes(file.content + metadata_offset, metadata_size));
+	memcpy(file.content + checksum_field, &checksum, sizeof(uint64));
+
+	write_file(path, file.content, file.size);
+	free_file(file);
+
+	ModelAsset loaded = loadBIN(path);
+	EXPECT_TRUE(loaded.meshes.empty());
+
+	fs::remove(path);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <asset/deflate.h>
+
+// zlib output for make_test_data(), once with fixed and once with dynamic Huffman codes.
+static const uint8 fixed_huffman_stream[] =
+{
+	0x78, 0x01, 0x4B, 0x4C, 0x4C, 0x4C, 0x4A, 0x4E, 0x49, 0xCB, 0xC8, 0xCA, 0xC9, 0x2F, 0x2A, 0x4D, 0x4A, 0xCB, 0xCA, 0x2B,
+	0x4E, 0x4C, 0xCB, 0x29, 0x4A, 0x4C, 0xCF, 0x2B, 0x4D, 0xCD, 0x2D, 0x4D, 0xCB, 0x2B, 0xCF, 0x2C, 0x4A, 0xCD, 0x4F, 0xCA,
+	0x29, 0xCF, 0x2E, 0xCB, 0x2E, 0xCF, 0x49, 0xCC, 0x4B, 0x29, 0xCC, 0x28, 0xCB, 0x4D, 0x29, 0xCE, 0x4E, 0x2E, 0xCE, 0x49,
+	0x2D, 0xCD, 0xCF, 0x4C, 0x2E, 0x2D, 0xC8, 0x4E, 0x4B, 0x2A, 0x2D, 0xCC, 0xCB, 0xCE, 0x48, 0x4D, 0x4E, 0x2C, 0x2B, 0x2D,
+	0x29, 0x2E, 0x02, 0x82, 0xE2, 0x92, 0xD2, 0xB2, 0xC4, 0xE4, 0xD4, 0x8C, 0xEC, 0xBC, 0x42, 0xA0, 0x89, 0xD9, 0x05, 0xA5,
+	0xC9, 0x99, 0xF9, 0xA5, 0xA9, 0x39, 0xC5, 0xC9, 0xD9, 0xC5, 0x29, 0xB9, 0x65, 0x19, 0x85, 0x29, 0x79, 0x89, 0x50, 0x03,
+	0x93, 0xF2, 0x53, 0x8B, 0x32, 0xCB, 0xF3, 0xD2, 0x4A, 0x73, 0x53, 0x4B, 0xF3, 0xD2, 0x13, 0x8B, 0x72, 0xD2, 0x12, 0x8B,
+	0xF3, 0xB2, 0x80, 0x26, 0x16, 0xE5, 0xE7, 0x64, 0x65, 0xA4, 0xA5, 0x24, 0x27, 0x25, 0x82, 0xC0, 0xA8, 0x03, 0x47, 0x1D,
+	0x38, 0xEA, 0x40, 0xDA, 0x38, 0x10, 0x00, 0x7F, 0xED, 0xAE, 0x30,
+};
+
+static const uint8 dynamic_huffman_stream[] =
+{
+	0x78, 0xDA, 0xED, 0xCE, 0xD1, 0x11, 0xC4, 0x20, 0x08, 0x00, 0xD1, 0x5A, 0x11, 0x21, 0x2A, 0x04, 0xA3, 0x04, 0x6D, 0xFF,
+	0x72, 0x33, 0xD7, 0xC2, 0xFD, 0x65, 0x0B, 0xD8, 0x79, 0x00, 0x90, 0x30, 0x73, 0x69, 0xDA, 0x67, 0x24, 0x6E, 0xE6, 0xC0,
+	0x3A, 0xE1, 0xB0, 0xA0, 0x33, 0xD8, 0x76, 0x9D, 0xD4, 0x93, 0x6E, 0x59, 0xB2, 0x15, 0x2C, 0x8F, 0xB2, 0xCE, 0xEC, 0x82,
+	0xAE, 0x14, 0xBD, 0x62, 0x5C, 0xC2, 0x29, 0x86, 0x49, 0x21, 0x84, 0x15, 0xB7, 0xCF, 0x27, 0xBF, 0x63, 0x01, 0x52, 0x11,
+	0x1B, 0xCF, 0x51, 0xAE, 0xC0, 0xDA, 0x83, 0xD4, 0x51, 0x3C, 0x9F, 0xAB, 0x8C, 0x6C, 0xF0, 0x1B, 0xA6, 0x4E, 0xB3, 0x6E,
+	0xE3, 0x38, 0x29, 0xEC, 0x80, 0xA9, 0x0C, 0x6E, 0xED, 0x39, 0xCE, 0xAE, 0xAD, 0x70, 0xC6, 0x04, 0xDF, 0x5E, 0xE0, 0x0B,
+	0x7C, 0x81, 0xFF, 0x01, 0x7E, 0x00, 0x7F, 0xED, 0xAE, 0x30,
+};
+
+static std::vector<uint8> make_test_data()
+{
+	std::vector<uint8> result(1024);
+	for (uint32 i = 0; i < 1024; ++i)
+	{
+		result[i] = (uint8)((i * i / 7) % 23 + 'a');
+	}
+	return result;
+}
+
+TEST(Asset_Deflate, FixedHuffman) {
+
+	using namespace era_engine;
+
+	const std::vector<uint8> expected = make_test_data();
+	std::vector<uint8> output(expected.size());
+
+	EXPECT_EQ(decompress(fixed_huffman_stream, sizeof(fixed_huffman_stream), output.data(), output.size()), expected.size());
+	EXPECT_EQ(output, expected);
+}
+
+TEST(Asset_Deflate, DynamicHuffman) {
+
+	using namespace era_engine;
+
+	const std::vector<uint8> expected = make_test_data();
+	std::vector<uint8> output(expected.size());
+
+	EXPECT_EQ(decompress(dynamic_huffman_stream, sizeof(dynamic_huffman_stream), output.data(), output.size()), expected.size());
+	EXPECT_EQ(output, expected);
+}
+
+TEST(Asset_Deflate, StoredBlock) {
+
+	using namespace era_engine;
+
+	// Final stored block with LEN = 5, NLEN = ~5.
+	const uint8 stream[] = { 0x78, 0x01, 0x01, 0x05, 0x00, 0xFA, 0xFF, 'h', 'e', 'l', 'l', 'o' };
+
+	uint8 output[5] = {};
+	EXPECT_EQ(decompress(stream, sizeof(stream), output, sizeof(output)), 5);
+	EXPECT_EQ(memcmp(output, "hello", 5), 0);
+}
+
+TEST(Asset_Deflate, RejectsMalformedInput) {
+
+	using namespace era_engine;
+
+	const std::vector<uint8> expected = make_test_data();
+	std::vector<uint8> output(expected.size());
+
+	// Output buffer one byte too small.
+	EXPECT_EQ(decompress(dynamic_huffman_stream, sizeof(dynamic_huffman_stream), output.data(), output.size() - 1), inflate_error);
+
+	// Truncated input.
+	EXPECT_EQ(decompress(dynamic_huffman_stream, sizeof(dynamic_huffman_stream) / 2, output.data(), output.size()), inflate_error);
+
+	// Not a zlib header.
+	const uint8 bad_header[] = { 0x12, 0x34, 0x00, 0x00 };
+	EXPECT_EQ(decompress(bad_header, sizeof(bad_header), output.data(), output.size()), inflate_error);
+
+	// Reserved block type 3.
+	const uint8 bad_block_type[] = { 0x78, 0x01, 0x07, 0x00 };
+	EXPECT_EQ(decompress(bad_block_type, sizeof(bad_block_type), output.data(), output.size()), inflate_error);
+
+	// Corrupted data must never read or write out of bounds. The result itself is undefined.
+	std::vector<uint8> corrupted(std::begin(dynamic_huffman_stream), std::end(dynamic_huffman_stream));
+	for (uint32 i = 2; i < (uint32)corrupted.size(); ++i)
+	{
+		corrupted[i] ^= 0x5A;
+		decompress(corrupted.data(), corrupted.size(), output.data(), output.size());
+		corrupted[i] ^= 0x5A;
+	}
+}
@@ -0,0 +1,788 @@
+#include <gtest/gtest.h>
+
+#include <asset/bin.h>
+#include <asset/io.h>
+#include <asset/model_asset.h>
+#include <rendering/pbr_material.h>
+
+#include "unittests/test_utils.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+	// Minimal binary FBX (7.4) writer, just enough for the parts of the format the importer reads.
+	class FbxWriter
+	{
+	public:
+		FbxWriter()
+		{
+			const char magic[] = "Kaydara FBX Binary  ";
+			data.insert(data.end(), magic, magic + sizeof(magic));
+			data.push_back(0x1A);
+			data.push_back(0x00);
+			write<uint32>(7400);
+		}
+
+		void begin_node(const char* name)
+		{
+			if (!open_nodes.empty())
+			{
+				end_property_list(open_nodes.back());
+				open_nodes.back().has_children = true;
+			}
+
+			OpenNode& node = open_nodes.emplace_back();
+			node.offset = data.size();
+			write<uint32>(0); // End offset.
+			write<uint32>(0); // Number of properties.
+			write<uint32>(0); // Property list length.
+			data.push_back((uint8)strlen(name));
+			data.insert(data.end(), name, name + strlen(name));
+			node.property_list_begin = data.size();
+		}
+
+		void end_node()
+		{
+			OpenNode& node = open_nodes.back();
+			end_property_list(node);
+			if (node.has_children)
+			{
+				write_null_record();
+			}
+			patch<uint32>(node.offset, (uint32)data.size());
+			open_nodes.pop_back();
+		}
+
+		void property(int32 value) { begin_property('I'); write(value); }
+		void property(int64 value) { begin_property('L'); write(value); }
+		void property(double value) { begin_property('D'); write(value); }
+
+		void property(const std::string& value)
+		{
+			begin_property('S');
+			write<uint32>((uint32)value.size());
+			data.insert(data.end(), value.begin(), value.end());
+		}
+
+		void property(const char* value) { property(std::string(value)); }
+
+		template <typename T>
+		void array_property(char type, const std::vector<T>& values, bool compress = false)
+		{
+			begin_property(type);
+			std::vector<uint8> bytes((const uint8*)values.data(), (const uint8*)(values.data() + values.size()));
+			if (compress)
+			{
+				bytes = zlib_store(bytes);
+			}
+			write<uint32>((uint32)values.size());
+			write<uint32>(compress ? 1 : 0);
+			write<uint32>((uint32)bytes.size());
+			data.insert(data.end(), bytes.begin(), bytes.end());
+		}
+
+		template <typename... Args_>
+		void leaf(const char* name, const Args_&... args)
+		{
+			begin_node(name);
+			(property(args), ...);
+			end_node();
+		}
+
+		std::vector<uint8> finish()
+		{
+			write_null_record();
+			return data;
+		}
+
+	private:
+		struct OpenNode
+		{
+			size_t offset = 0;
+			size_t property_list_begin = 0;
+			uint32 num_properties = 0;
+			bool property_list_done = false;
+			bool has_children = false;
+		};
+
+		template <typename T>
+		void write(T value)
+		{
+			data.insert(data.end(), (const uint8*)&value, (const uint8*)&value + sizeof(T));
+		}
+
+		template <typename T>
+		void patch(size_t offset, T value)
+		{
+			memcpy(data.data() + offset, &value, sizeof(T));
+		}
+
+		void begin_property(char type)
+		{
+			OpenNode& node = open_nodes.back();
+			patch<uint32>(node.offset + 4, ++node.num_properties);
+			data.push_back((uint8)type);
+		}
+
+		void end_property_list(OpenNode& node)
+		{
+			if (!node.property_list_done)
+			{
+				patch<uint32>(node.offset + 8, (uint32)(data.size() - node.property_list_begin));
+				node.property_list_done = true;
+			}
+		}
+
+		void write_null_record()
+		{
+			data.insert(data.end(), 13, 0);
+		}
+
+		std::vector<uint8> zlib_store(const std::vector<uint8>& bytes)
+		{
+			std::vector<uint8> result = { 0x78, 0x01 };
+			size_t offset = 0;
+			do
+			{
+				uint16 length = (uint16)std::min<size_t>(bytes.size() - offset, 0xFFFF);
+				result.push_back((offset + length == bytes.size()) ? 1 : 0);
+				result.push_back((uint8)length);
+				result.push_back((uint8)(length >> 8));
+				result.push_back((uint8)~length);
+				result.push_back((uint8)(~length >> 8));
+				result.insert(result.end(), bytes.begin() + offset, bytes.begin() + offset + length);
+				offset += length;
+			} while (offset < bytes.size());
+
+			uint32 a = 1, b = 0;
+			for (uint8 byte : bytes)
+			{
+				a = (a + byte) % 65521;
+				b = (b + a) % 65521;
+			}
+			uint32 adler = (b << 16) | a;
+			result.push_back((uint8)(adler >> 24));
+			result.push_back((uint8)(adler >> 16));
+			result.push_back((uint8)(adler >> 8));
+			result.push_back((uint8)adler);
+			return result;
+		}
+
+		std::vector<uint8> data;
+		std::vector<OpenNode> open_nodes;
+	};
+}
+
+// Shape of the generated file, shared with the reference the import is checked against.
+static constexpr uint32 test_num_joints = 3;
+static constexpr uint32 test_num_keys = 24;
+static constexpr int64 test_duration = 46186158000; // One second in FBX time.
+
+// Quad grids of varying size.
+static uint32 get_test_grid_size(uint32 mesh)
+{
+	return 8 + 4 * (mesh % 5);
+}
+
+static vec3 get_test_grid_vertex(uint32 mesh, uint32 x, uint32 y)
+{
+	return vec3((float)x, (float)y, (float)((x * y + mesh) % 3));
+}
+
+// Curves of different lengths, so that resampling has to interpolate.
+static uint32 get_test_curve_key_count(uint32 curve_node, uint32 axis)
+{
+	return test_num_keys - (curve_node + axis) % 4;
+}
+
+static int64 get_test_curve_key_time(uint32 curve_node, uint32 axis, uint32 key)
+{
+	return test_duration * key / (get_test_curve_key_count(curve_node, axis) - 1);
+}
+
+static float get_test_curve_key_value(uint32 curve_node, uint32 axis, uint32 key)
+{
+	return (float)(curve_node * 10 + axis) + sinf((float)key * 0.3f) * 45.0f;
+}
+
+static std::vector<uint8> create_test_fbx(uint32 num_meshes)
+{
+	using namespace era_engine;
+
+	constexpr int64 material_id = 100;
+	constexpr int64 first_mesh_model_id = 1000;
+	constexpr int64 first_geometry_id = 2000;
+	constexpr int64 first_joint_id = 3000;
+	constexpr int64 skin_id = 4000;
+	constexpr int64 first_cluster_id = 4100;
+	constexpr int64 stack_id = 5000;
+	constexpr int64 layer_id = 5100;
+	constexpr int64 first_curve_node_id = 5200;
+	constexpr int64 first_curve_id = 6000;
+
+	constexpr uint32 num_joints = test_num_joints;
+	constexpr int64 duration = test_duration;
+
+	FbxWriter fbx;
+
+	fbx.begin_node("GlobalSettings");
+	fbx.begin_node("Properties70");
+	fbx.leaf("P", "UpAxis", "int", "Integer", "", (int32)1);
+	fbx.end_node();
+	fbx.end_node();
+
+	fbx.begin_node("Definitions");
+	const std::pair<const char*, int32> object_types[] =
+	{
+		{ "Model", (int32)(num_meshes + num_joints) }, { "Geometry", (int32)num_meshes }, { "Material", 1 }, { "Deformer", 1 + num_joints },
+		{ "AnimationStack", 1 }, { "AnimationLayer", 1 }, { "AnimationCurveNode", 2 * num_joints }, { "AnimationCurve", 6 * num_joints },
+	};
+	for (auto [type, count] : object_types)
+	{
+		fbx.begin_node("ObjectType");
+		fbx.property(type);
+		fbx.leaf("Count", count);
+		fbx.end_node();
+	}
+	fbx.end_node();
+
+	fbx.begin_node("Objects");
+
+	fbx.begin_node("Material");
+	fbx.property(material_id);
+	fbx.property("Material::test");
+	fbx.property("");
+	fbx.begin_node("Properties70");
+	fbx.leaf("P", "DiffuseColor", "Color", "", "A", 0.5, 0.25, 1.0);
+	fbx.end_node();
+	fbx.end_node();
+
+	for (uint32 m = 0; m < num_meshes; ++m)
+	{
+		std::string name = "mesh_" + std::to_string(m);
+
+		fbx.begin_node("Model");
+		fbx.property(first_mesh_model_id + m);
+		fbx.property("Model::" + name);
+		fbx.property("Mesh");
+		fbx.begin_node("Properties70");
+		fbx.leaf("P", "Lcl Translation", "Lcl Translation", "", "A", (double)m, 0.0, 0.0);
+		fbx.end_node();
+		fbx.end_node();
+
+		const uint32 grid = get_test_grid_size(m);
+
+		std::vector<double> vertices;
+		for (uint32 y = 0; y <= grid; ++y)
+		{
+			for (uint32 x = 0; x <= grid; ++x)
+			{
+				const vec3 vertex = get_test_grid_vertex(m, x, y);
+				vertices.insert(vertices.end(), { (double)vertex.x, (double)vertex.y, (double)vertex.z });
+			}
+		}
+
+		std::vector<int32> indices;
+		std::vector<double> normals;
+		std::vector<int32> uv_indices;
+		for (uint32 y = 0; y < grid; ++y)
+		{
+			for (uint32 x = 0; x < grid; ++x)
+			{
+				int32 corner = (int32)(y * (grid + 1) + x);
+				indices.insert(indices.end(), { corner, corner + 1, corner + (int32)grid + 2, ~(corner + (int32)grid + 1) });
+				for (uint32 i = 0; i < 4; ++i)
+				{
+					normals.insert(normals.end(), { 0.0, 0.0, 1.0 });
+					uv_indices.push_back((int32)i);
+				}
+			}
+		}
+
+		fbx.begin_node("Geometry");
+		fbx.property(first_geometry_id + m);
+		fbx.property("Geometry::" + name);
+		fbx.property("Mesh");
+		fbx.begin_node("Vertices");
+		fbx.array_property('d', vertices);
+		fbx.end_node();
+		fbx.begin_node("PolygonVertexIndex");
+		fbx.array_property('i', indices, m % 2 == 1);
+		fbx.end_node();
+		fbx.begin_node("LayerElementNormal");
+		fbx.leaf("MappingInformationType", "ByPolygonVertex");
+		fbx.leaf("ReferenceInformationType", "Direct");
+		fbx.begin_node("Normals");
+		fbx.array_property('d', normals, m % 2 == 0);
+		fbx.end_node();
+		fbx.end_node();
+		fbx.begin_node("LayerElementUV");
+		fbx.leaf("MappingInformationType", "ByPolygonVertex");
+		fbx.leaf("ReferenceInformationType", "IndexToDirect");
+		fbx.begin_node("UV");
+		fbx.array_property('d', std::vector<double>{ 0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 0.0, 1.0 });
+		fbx.end_node();
+		fbx.begin_node("UVIndex");
+		fbx.array_property('i', uv_indices);
+		fbx.end_node();
+		fbx.end_node();
+		fbx.begin_node("LayerElementMaterial");
+		fbx.leaf("MappingInformationType", "AllSame");
+		fbx.leaf("ReferenceInformationType", "IndexToDirect");
+		fbx.begin_node("Materials");
+		fbx.array_property('i', std::vector<int32>{ 0 });
+		fbx.end_node();
+		fbx.end_node();
+		fbx.end_node();
+	}
+
+	fbx.begin_node("Deformer");
+	fbx.property(skin_id);
+	fbx.property("Deformer::skin");
+	fbx.property("Skin");
+	fbx.end_node();
+
+	for (uint32 j = 0; j < num_joints; ++j)
+	{
+		fbx.begin_node("Model");
+		fbx.property(first_joint_id + j);
+		fbx.property("Model::joint_" + std::to_string(j));
+		fbx.property("LimbNode");
+		fbx.end_node();
+
+		std::vector<int32> cluster_indices;
+		std::vector<double> weights;
+		for (int32 i = (int32)j; i < 81; i += 2)
+		{
+			cluster_indices.push_back(i);
+			weights.push_back(0.25 + 0.25 * j);
+		}
+
+		std::vector<double> transform(16, 0.0);
+		transform[0] = transform[5] = transform[10] = transform[15] = 1.0;
+		transform[12] = -(double)j;
+
+		fbx.begin_node("Deformer");
+		fbx.property(first_cluster_id + j);
+		fbx.property("SubDeformer::cluster_" + std::to_string(j));
+		fbx.property("Cluster");
+		fbx.begin_node("Indexes");
+		fbx.array_property('i', cluster_indices);
+		fbx.end_node();
+		fbx.begin_node("Weights");
+		fbx.array_property('d', weights);
+		fbx.end_node();
+		fbx.begin_node("Transform");
+		fbx.array_property('d', transform);
+		fbx.end_node();
+		fbx.end_node();
+	}
+
+	fbx.begin_node("AnimationStack");
+	fbx.property(stack_id);
+	fbx.property("AnimStack::take");
+	fbx.property("");
+	fbx.begin_node("Properties70");
+	fbx.leaf("P", "LocalStop", "KTime", "Time", "", duration);
+	fbx.end_node();
+	fbx.end_node();
+
+	fbx.begin_node("AnimationLayer");
+	fbx.property(layer_id);
+	fbx.property("AnimLayer::base");
+	fbx.property("");
+	fbx.end_node();
+
+	for (uint32 c = 0; c < 2 * num_joints; ++c)
+	{
+		fbx.begin_node("AnimationCurveNode");
+		fbx.property(first_curve_node_id + c);
+		fbx.property((c % 2 == 0) ? "AnimCurveNode::T" : "AnimCurveNode::R");
+		fbx.property("");
+		fbx.begin_node("Properties70");
+		fbx.leaf("P", "d|X", "Number", "", "A", 0.0);
+		fbx.leaf("P", "d|Y", "Number", "", "A", 0.0);
+		fbx.leaf("P", "d|Z", "Number", "", "A", 0.0);
+		fbx.end_node();
+		fbx.end_node();
+
+		for (uint32 axis = 0; axis < 3; ++axis)
+		{
+			const uint32 count = get_test_curve_key_count(c, axis);
+
+			std::vector<int64> times;
+			std::vector<float> values;
+			for (uint32 k = 0; k < count; ++k)
+			{
+				times.push_back(get_test_curve_key_time(c, axis, k));
+				values.push_back(get_test_curve_key_value(c, axis, k));
+			}
+
+			fbx.begin_node("AnimationCurve");
+			fbx.property(first_curve_id + 3 * c + axis);
+			fbx.property("AnimCurve::");
+			fbx.property("");
+			fbx.leaf("Default", 0.0);
+			fbx.begin_node("KeyTime");
+			fbx.array_property('l', times, axis == 1);
+			fbx.end_node();
+			fbx.begin_node("KeyValueFloat");
+			fbx.array_property('f', values, axis == 2);
+			fbx.end_node();
+			fbx.end_node();
+		}
+	}
+
+	fbx.end_node();
+
+	fbx.begin_node("Connections");
+	auto connect = [&fbx](int64 a, int64 b, const char* slot = nullptr)
+	{
+		fbx.begin_node("C");
+		fbx.property(slot ? "OP" : "OO");
+		fbx.property(a);
+		fbx.property(b);
+		if (slot)
+		{
+			fbx.property(slot);
+		}
+		fbx.end_node();
+	};
+
+	for (uint32 m = 0; m < num_meshes; ++m)
+	{
+		connect(first_mesh_model_id + m, 0);
+		connect(first_geometry_id + m, first_mesh_model_id + m);
+		connect(material_id, first_mesh_model_id + m);
+	}
+
+	connect(skin_id, first_geometry_id);
+	for (uint32 j = 0; j < num_joints; ++j)
+	{
+		connect(first_joint_id + j, (j == 0) ? 0 : first_joint_id + j - 1);
+		connect(first_cluster_id + j, skin_id);
+		connect(first_joint_id + j, first_cluster_id + j);
+	}
+
+	connect(layer_id, stack_id);
+	const char* axis_slots[] = { "d|X", "d|Y", "d|Z" };
+	for (uint32 c = 0; c < 2 * num_joints; ++c)
+	{
+		connect(first_curve_node_id + c, layer_id);
+		connect(first_curve_node_id + c, first_joint_id + c / 2, (c % 2 == 0) ? "Lcl Translation" : "Lcl Rotation");
+		for (uint32 axis = 0; axis < 3; ++axis)
+		{
+			connect(first_curve_id + 3 * c + axis, first_curve_node_id + c, axis_slots[axis]);
+		}
+	}
+	fbx.end_node();
+
+	return fbx.finish();
+}
+
+static void write_file(const fs::path& path, const std::vector<uint8>& data)
+{
+	FILE* out = fopen(path.string().c_str(), "wb");
+	fwrite(data.data(), 1, data.size(), out);
+	fclose(out);
+}
+
+static std::vector<uint8> read_file(const fs::path& path)
+{
+	era_engine::EntireFile file = era_engine::load_file(path);
+	std::vector<uint8> result(file.content, file.content + file.size);
+	era_engine::free_file(file);
+	return result;
+}
+
+// Reference for what the baseline serial importer produces from the generated file, derived from the source data instead of
+// from the importer. Triangles are compared as attribute triples, so welding and vertex cache order do not matter.
+// mesh_flag_load_colors shares its bit with mesh_creation_flags_sm_to_m, so with the default flags positions and
+// translations are converted from centimeters to meters.
+using test_corner = std::array<float, 16>; // Position, uv, normal, skin indices, skin weights.
+using test_triangle = std::array<test_corner, 3>;
+
+static float to_meters(float value)
+{
+	return (float)((double)value / 100.0);
+}
+
+static test_corner make_test_corner(vec3 position, vec2 uv, vec3 normal, const era_engine::animation::SkinningWeights& skin)
+{
+	return {
+		position.x, position.y, position.z, uv.x, uv.y, normal.x, normal.y, normal.z,
+		(float)skin.skin_indices[0], (float)skin.skin_indices[1], (float)skin.skin_indices[2], (float)skin.skin_indices[3],
+		(float)skin.skin_weights[0], (float)skin.skin_weights[1], (float)skin.skin_weights[2], (float)skin.skin_weights[3],
+	};
+}
+
+// Rotates the smallest corner to the front, which keeps the winding.
+static test_triangle normalize_triangle(test_triangle triangle)
+{
+	while (triangle[0] > triangle[1] || triangle[0] > triangle[2])
+	{
+		triangle = { triangle[1], triangle[2], triangle[0] };
+	}
+	return triangle;
+}
+
+// Only the first mesh is skinned. Joint j influences every second control point from j on, heavier joints first.
+static era_engine::animation::SkinningWeights get_reference_skin(uint32 mesh, uint32 control_point)
+{
+	era_engine::animation::SkinningWeights skin = {};
+	if (mesh != 0)
+	{
+		return skin;
+	}
+
+	uint32 slot = 0;
+	for (int32 j = (int32)test_num_joints - 1; j >= 0; --j)
+	{
+		if (control_point >= (uint32)j && (control_point - j) % 2 == 0)
+		{
+			skin.skin_indices[slot] = (uint8)j;
+			skin.skin_weights[slot] = (uint8)((0.25f + 0.25f * j) * 255.f);
+			++slot;
+		}
+	}
+	return skin;
+}
+
+static std::vector<test_triangle> get_reference_triangles(uint32 mesh)
+{
+	using namespace era_engine;
+
+	const uint32 grid = get_test_grid_size(mesh);
+	const vec2 uvs[] = { vec2(0.f, 1.f), vec2(1.f, 1.f), vec2(1.f, 0.f), vec2(0.f, 0.f) }; // Flipped vertically.
+
+	std::vector<test_triangle> result;
+	for (uint32 y = 0; y < grid; ++y)
+	{
+		for (uint32 x = 0; x < grid; ++x)
+		{
+			const uint32 quad_x[] = { x, x + 1, x + 1, x };
+			const uint32 quad_y[] = { y, y, y + 1, y + 1 };
+
+			test_corner corners[4];
+			for (uint32 i = 0; i < 4; ++i)
+			{
+				vec3 position = get_test_grid_vertex(mesh, quad_x[i], quad_y[i]);
+				position = vec3(to_meters(position.x), to_meters(position.y), to_meters(position.z));
+				const uint32 control_point = quad_y[i] * (grid + 1) + quad_x[i];
+				corners[i] = make_test_corner(position, uvs[i], vec3(0.f, 0.f, 1.f), get_reference_skin(mesh, control_point));
+			}
+
+			// Polygons are triangulated as a fan.
+			result.push_back(normalize_triangle({ corners[0], corners[1], corners[2] }));
+			result.push_back(normalize_triangle({ corners[0], corners[2], corners[3] }));
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+static std::vector<test_triangle> get_imported_triangles(const era_engine::MeshAsset& mesh)
+{
+	using namespace era_engine;
+
+	std::vector<test_triangle> result;
+	for (const SubmeshAsset& submesh : mesh.submeshes)
+	{
+		auto get_corner = [&submesh](uint32 index)
+		{
+			const animation::SkinningWeights skin = !submesh.skin.empty() ? submesh.skin[index] : animation::SkinningWeights{};
+			return make_test_corner(submesh.positions[index], submesh.uvs[index], submesh.normals[index], skin);
+		};
+
+		for (uint32 i = 0; i < submesh.get_num_triangles(); ++i)
+		{
+			const indexed_triangle32 triangle = submesh.get_triangle(i);
+			result.push_back(normalize_triangle({ get_corner(triangle.a), get_corner(triangle.b), get_corner(triangle.c) }));
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// Linear interpolation between the source keys, clamped at both ends.
+static float sample_reference_curve(uint32 curve_node, uint32 axis, int64 time)
+{
+	const uint32 count = get_test_curve_key_count(curve_node, axis);
+	if (time <= 0)
+	{
+		return get_test_curve_key_value(curve_node, axis, 0);
+	}
+	if (time >= get_test_curve_key_time(curve_node, axis, count - 1))
+	{
+		return get_test_curve_key_value(curve_node, axis, count - 1);
+	}
+
+	uint32 key = 0;
+	while (time >= get_test_curve_key_time(curve_node, axis, key + 1))
+	{
+		++key;
+	}
+
+	const int64 time0 = get_test_curve_key_time(curve_node, axis, key);
+	const int64 time1 = get_test_curve_key_time(curve_node, axis, key + 1);
+	const float t = (float)(time - time0) / (float)(time1 - time0);
+	return lerp(get_test_curve_key_value(curve_node, axis, key), get_test_curve_key_value(curve_node, axis, key + 1), t);
+}
+
+// Keys are resampled uniformly, as many as the longest of the three curves has.
+static uint32 get_reference_keyframe_count(uint32 curve_node)
+{
+	return std::max({ get_test_curve_key_count(curve_node, 0), get_test_curve_key_count(curve_node, 1), get_test_curve_key_count(curve_node, 2) });
+}
+
+static void expect_matches_reference(const era_engine::ModelAsset& model, uint32 num_meshes)
+{
+	using namespace era_engine;
+
+	ASSERT_EQ(model.meshes.size(), num_meshes);
+	for (uint32 m = 0; m < num_meshes; ++m)
+	{
+		const MeshAsset& mesh = model.meshes[m];
+		EXPECT_EQ(mesh.name, "Model::mesh_" + std::to_string(m));
+		EXPECT_EQ(mesh.skeleton_index, (m == 0) ? 0 : -1);
+		for (const SubmeshAsset& submesh : mesh.submeshes)
+		{
+			EXPECT_EQ(submesh.material_index, 0);
+		}
+		EXPECT_TRUE(get_imported_triangles(mesh) == get_reference_triangles(m)) << "Mesh " << m;
+	}
+
+	ASSERT_EQ(model.skeletons.size(), 1u);
+	const SkeletonAsset& skeleton = model.skeletons[0];
+	ASSERT_EQ(skeleton.joints.size(), test_num_joints);
+	for (uint32 j = 0; j < test_num_joints; ++j)
+	{
+		const animation::SkeletonJoint& joint = skeleton.joints[j];
+		EXPECT_EQ(joint.name, "Model::joint_" + std::to_string(j));
+		EXPECT_EQ(skeleton.name_to_joint_id.at(joint.name), j);
+		EXPECT_EQ(joint.parent_id, (j == 0) ? INVALID_JOINT : j - 1);
+
+		const trs inv_bind = mat4_to_trs(joint.inv_bind_transform);
+		EXPECT_NEAR(inv_bind.position.x, to_meters(-(float)j), 1e-6f);
+		EXPECT_NEAR(inv_bind.position.y, 0.f, 1e-6f);
+		EXPECT_NEAR(inv_bind.position.z, 0.f, 1e-6f);
+	}
+
+	ASSERT_EQ(model.animations.size(), 1u);
+	const AnimationAsset& animation = model.animations[0];
+	EXPECT_FLOAT_EQ(animation.duration, 1.f);
+	ASSERT_EQ(animation.joints.size(), test_num_joints);
+
+	for (uint32 j = 0; j < test_num_joints; ++j)
+	{
+		const animation::AnimationJoint& joint = animation.joints.at("Model::joint_" + std::to_string(j));
+
+		const uint32 position_node = 2 * j;
+		const uint32 num_position_keyframes = get_reference_keyframe_count(position_node);
+		ASSERT_EQ(joint.num_position_keyframes, num_position_keyframes);
+		for (uint32 k = 0; k < num_position_keyframes; ++k)
+		{
+			const int64 time = test_duration / (num_position_keyframes - 1) * k;
+			const uint32 index = joint.first_position_keyframe + k;
+			EXPECT_FLOAT_EQ(animation.position_timestamps[index], (float)((double)time / (double)test_duration));
+
+			const vec3 position = animation.position_keyframes[index];
+			EXPECT_NEAR(position.x, to_meters(sample_reference_curve(position_node, 0, time)), 1e-5f);
+			EXPECT_NEAR(position.y, to_meters(sample_reference_curve(position_node, 1, time)), 1e-5f);
+			EXPECT_NEAR(position.z, to_meters(sample_reference_curve(position_node, 2, time)), 1e-5f);
+		}
+
+		const uint32 rotation_node = 2 * j + 1;
+		const uint32 num_rotation_keyframes = get_reference_keyframe_count(rotation_node);
+		ASSERT_EQ(joint.num_rotation_keyframes, num_rotation_keyframes);
+		for (uint32 k = 0; k < num_rotation_keyframes; ++k)
+		{
+			const int64 time = test_duration / (num_rotation_keyframes - 1) * k;
+			const uint32 index = joint.first_rotation_keyframe + k;
+			EXPECT_FLOAT_EQ(animation.rotation_timestamps[index], (float)((double)time / (double)test_duration));
+
+			// Euler angles in degrees, default XYZ order.
+			const quat x(vec3(1.f, 0.f, 0.f), deg2rad(sample_reference_curve(rotation_node, 0, time)));
+			const quat y(vec3(0.f, 1.f, 0.f), deg2rad(sample_reference_curve(rotation_node, 1, time)));
+			const quat z(vec3(0.f, 0.f, 1.f), deg2rad(sample_reference_curve(rotation_node, 2, time)));
+			const quat expected = z * y * x;
+
+			const quat rotation = animation.rotation_keyframes[index];
+			const float sign = (dot(rotation.v4, expected.v4) < 0.f) ? -1.f : 1.f;
+			EXPECT_NEAR(rotation.x * sign, expected.x, 1e-5f);
+			EXPECT_NEAR(rotation.y * sign, expected.y, 1e-5f);
+			EXPECT_NEAR(rotation.z * sign, expected.z, 1e-5f);
+			EXPECT_NEAR(rotation.w * sign, expected.w, 1e-5f);
+		}
+
+		EXPECT_EQ(joint.num_scale_keyframes, 0u);
+	}
+}
+
+TEST(Asset_Fbx, ImportMatchesReference)
+{
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	constexpr uint32 num_meshes = 24;
+
+	const fs::path fbx_path = fs::temp_directory_path() / "era_fbx_reference.fbx";
+	write_file(fbx_path, create_test_fbx(num_meshes));
+
+	{
+		SCOPED_TRACE("Serial");
+		expect_matches_reference(loadFBX(fbx_path, mesh_flag_default, false), num_meshes);
+	}
+	{
+		SCOPED_TRACE("Parallel");
+		expect_matches_reference(loadFBX(fbx_path, mesh_flag_default, true), num_meshes);
+	}
+
+	fs::remove(fbx_path);
+}
+
+TEST(Asset_Fbx, ParallelImportMatchesSerial) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	constexpr uint32 num_meshes = 24;
+
+	const fs::path fbx_path = fs::temp_directory_path() / "era_fbx_parallel.fbx";
+	const fs::path serial_path = fs::temp_directory_path() / "era_fbx_serial.bin";
+	const fs::path parallel_path = fs::temp_directory_path() / "era_fbx_parallel.bin";
+
+	write_file(fbx_path, create_test_fbx(num_meshes));
+
+	ModelAsset serial = loadFBX(fbx_path, mesh_flag_default, false);
+	ASSERT_EQ(serial.meshes.size(), num_meshes);
+	ASSERT_EQ(serial.skeletons.size(), 1);
+	ASSERT_EQ(serial.animations.size(), 1);
+	EXPECT_EQ(serial.meshes[0].skeleton_index, 0);
+	EXPECT_EQ(serial.skeletons[0].joints.size(), 3);
+	EXPECT_EQ(serial.animations[0].joints.size(), 3);
+
+	writeBIN(serial, serial_path, false);
+	const std::vector<uint8> expected = read_file(serial_path);
+
+	// A few rounds, since ordering bugs depend on scheduling.
+	for (uint32 round = 0; round < 4; ++round)
+	{
+		ModelAsset parallel = loadFBX(fbx_path, mesh_flag_default, true);
+		writeBIN(parallel, parallel_path, false);
+
+		const std::vector<uint8> actual = read_file(parallel_path);
+		ASSERT_EQ(actual.size(), expected.size());
+		EXPECT_EQ(memcmp(actual.data(), expected.data(), expected.size()), 0);
+	}
+
+	fs::remove(fbx_path);
+	fs::remove(serial_path);
+	fs::remove(parallel_path);
+}
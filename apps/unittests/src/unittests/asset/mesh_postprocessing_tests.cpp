@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <asset/mesh_postprocessing.h>
+
+#include "unittests/test_utils.h"
+
+#include <algorithm>
+#include <array>
+
+// Quads of a grid with 'quads_per_side'^2 cells, one entry per face corner (unwelded), optionally in a scrambled order.
+static era_engine::SubmeshAsset weld_grid(uint32 quads_per_side, bool scramble)
+{
+	using namespace era_engine;
+
+	const uint32 side = quads_per_side + 1;
+	const uint32 num_quads = quads_per_side * quads_per_side;
+
+	std::vector<vec3> positions;
+	std::vector<vec2> uvs;
+	for (uint32 i = 0; i < num_quads; ++i)
+	{
+		// 7919 is prime, so this visits every quad exactly once.
+		const uint32 quad = scramble ? (uint32)(((uint64)i * 7919) % num_quads) : i;
+		const uint32 x = quad % quads_per_side;
+		const uint32 y = quad / quads_per_side;
+		const uint32 corners[4] = { y * side + x, y * side + x + 1, (y + 1) * side + x + 1, (y + 1) * side + x };
+
+		for (uint32 corner : corners)
+		{
+			positions.push_back(vec3((float)(corner % side), (float)(corner / side), 0.0f));
+			uvs.push_back(vec2((float)(corner % side) / quads_per_side, (float)(corner / side) / quads_per_side));
+		}
+	}
+
+	per_material material;
+	for (uint32 i = 0; i < num_quads; ++i)
+	{
+		material.addTriangles(positions, uvs, {}, {}, {}, {}, i * 4, 4);
+	}
+
+	std::vector<SubmeshAsset> result;
+	material.flush(result);
+	return std::move(result[0]);
+}
+
+static std::vector<std::array<float, 9>> get_sorted_triangles(const era_engine::SubmeshAsset& submesh)
+{
+	using namespace era_engine;
+
+	std::vector<std::array<float, 9>> result;
+	auto add = [&](uint32 a, uint32 b, uint32 c)
+	{
+		const vec3 pa = submesh.positions[a];
+		const vec3 pb = submesh.positions[b];
+		const vec3 pc = submesh.positions[c];
+		result.push_back({ pa.x, pa.y, pa.z, pb.x, pb.y, pb.z, pc.x, pc.y, pc.z });
+	};
+
+	for (const indexed_triangle16& tri : submesh.triangles)
+	{
+		add(tri.a, tri.b, tri.c);
+	}
+	for (const indexed_triangle32& tri : submesh.triangles32)
+	{
+		add(tri.a, tri.b, tri.c);
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+TEST(Asset_MeshPostprocessing, WeldsSharedVertices) {
+
+	using namespace era_engine;
+
+	const SubmeshAsset submesh = weld_grid(100, true);
+
+	EXPECT_EQ(submesh.positions.size(), 101 * 101);
+	EXPECT_EQ(submesh.uvs.size(), 101 * 101);
+	EXPECT_EQ(submesh.triangles.size(), 2 * 100 * 100);
+	EXPECT_TRUE(submesh.triangles32.empty());
+}
+
+TEST(Asset_MeshPostprocessing, SwitchesTo32BitIndices) {
+
+	using namespace era_engine;
+
+	// 301^2 vertices don't fit into 16-bit indices. The submesh is kept whole instead of being split.
+	const SubmeshAsset submesh = weld_grid(300, true);
+
+	ASSERT_EQ(submesh.positions.size(), 301 * 301);
+	EXPECT_TRUE(submesh.triangles.empty());
+	ASSERT_EQ(submesh.triangles32.size(), 2 * 300 * 300);
+
+	for (const indexed_triangle32& tri : submesh.triangles32)
+	{
+		ASSERT_LT(max(tri.a, max(tri.b, tri.c)), (uint32)submesh.positions.size());
+	}
+}
+
+TEST(Asset_MeshPostprocessing, GeneratesNormalsAndTangents) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	std::vector<SubmeshAsset> submeshes = { weld_grid(64, true), weld_grid(300, true) };
+	generateNormalsAndTangents(submeshes, mesh_flag_gen_tangents);
+
+	for (const SubmeshAsset& submesh : submeshes)
+	{
+		ASSERT_EQ(submesh.normals.size(), submesh.positions.size());
+		ASSERT_EQ(submesh.tangents.size(), submesh.positions.size());
+
+		// The grid lies in the xy plane with u along x.
+		for (uint32 i = 0; i < (uint32)submesh.positions.size(); ++i)
+		{
+			EXPECT_NEAR(submesh.normals[i].z, 1.0f, 1e-5f);
+			EXPECT_NEAR(submesh.tangents[i].x, 1.0f, 1e-5f);
+		}
+	}
+}
+
+TEST(Asset_MeshPostprocessing, VertexCacheOptimizationKeepsTriangles) {
+
+	using namespace era_engine;
+
+	for (uint32 quads_per_side : { 1, 50, 300 })
+	{
+		SubmeshAsset submesh = weld_grid(quads_per_side, true);
+		const auto expected = get_sorted_triangles(submesh);
+
+		optimizeVertexCache(submesh);
+
+		EXPECT_EQ(get_sorted_triangles(submesh), expected);
+
+		// Vertices are numbered in order of first use.
+		std::vector<uint32> indices;
+		for (const indexed_triangle16& tri : submesh.triangles)
+		{
+			indices.insert(indices.end(), { tri.a, tri.b, tri.c });
+		}
+		for (const indexed_triangle32& tri : submesh.triangles32)
+		{
+			indices.insert(indices.end(), { tri.a, tri.b, tri.c });
+		}
+
+		uint32 next_vertex = 0;
+		for (uint32 index : indices)
+		{
+			ASSERT_LE(index, next_vertex);
+			next_vertex = max(next_vertex, index + 1);
+		}
+	}
+}
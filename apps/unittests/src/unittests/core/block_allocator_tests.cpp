@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <core/block_allocator.h>
+
+#include <random>
+
+TEST(Core_BlockAllocator, SplitAndCoalesce) {
+
+	using namespace era_engine;
+
+	BlockAllocator allocator;
+	allocator.initialize(1000);
+
+	const uint64_t a = allocator.allocate(100);
+	const uint64_t b = allocator.allocate(200);
+	const uint64_t c = allocator.allocate(300);
+	ASSERT_NE(a, UINT64_MAX);
+	ASSERT_NE(b, UINT64_MAX);
+	ASSERT_NE(c, UINT64_MAX);
+	EXPECT_EQ(allocator.available_size, 400);
+
+	EXPECT_EQ(allocator.allocate(500), UINT64_MAX);
+
+	// Free the middle range last, so that it has to merge with both neighbours.
+	allocator.free(a, 100);
+	allocator.free(c, 300);
+	allocator.free(b, 200);
+
+	EXPECT_EQ(allocator.available_size, 1000);
+	EXPECT_EQ(allocator.get_num_free_blocks(), 1);
+	EXPECT_EQ(allocator.get_largest_free_block(), 1000);
+
+	// The whole range fits again, even though 1000 is not at the start of its size class.
+	EXPECT_EQ(allocator.allocate(1000), 0);
+	EXPECT_EQ(allocator.available_size, 0);
+}
+
+TEST(Core_BlockAllocator, RandomTraceKeepsRangesDisjoint) {
+
+	using namespace era_engine;
+
+	constexpr uint64_t capacity = 1 << 16;
+
+	BlockAllocator allocator;
+	allocator.initialize(capacity);
+
+	struct Range
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	std::vector<Range> live;
+	std::vector<uint8_t> owner(capacity, 0);
+
+	std::mt19937 rng(42);
+	for (uint32_t i = 0; i < 20000; ++i)
+	{
+		if (!live.empty() && (rng() % 2 == 0))
+		{
+			const size_t index = rng() % live.size();
+			const Range range = live[index];
+			live[index] = live.back();
+			live.pop_back();
+
+			std::fill(owner.begin() + range.offset, owner.begin() + range.offset + range.size, 0);
+			allocator.free(range.offset, range.size);
+		}
+		else
+		{
+			const uint64_t size = 1 + rng() % 512;
+			const uint64_t offset = allocator.allocate(size);
+			if (offset == UINT64_MAX)
+			{
+				EXPECT_LT(allocator.get_largest_free_block(), size);
+				continue;
+			}
+
+			ASSERT_LE(offset + size, capacity);
+			for (uint64_t j = offset; j < offset + size; ++j)
+			{
+				ASSERT_EQ(owner[j], 0);
+				owner[j] = 1;
+			}
+			live.push_back({ offset, size });
+		}
+	}
+
+	for (const Range& range : live)
+	{
+		allocator.free(range.offset, range.size);
+	}
+
+	EXPECT_EQ(allocator.available_size, capacity);
+	EXPECT_EQ(allocator.get_num_free_blocks(), 1);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <core/frame_allocator.h>
+
+#include <thread>
+
+TEST(Core_FrameAllocator, RewindsOnNextFrame) {
+
+	using namespace era_engine;
+
+	FrameAllocator allocator(MB(64), KB(64));
+
+	uint8* first = (uint8*)allocator.allocate(100);
+	uint8* second = (uint8*)allocator.allocate(100);
+	ASSERT_NE(first, nullptr);
+	EXPECT_GE(second, first + 100);
+	EXPECT_EQ((uint64)second % 16, 0);
+
+	memset(first, 0xAB, 100);
+	memset(second, 0xCD, 100);
+
+	allocator.begin_frame();
+
+	// Same thread, new frame -> the arena starts over.
+	uint8* next_frame = (uint8*)allocator.allocate(100);
+	EXPECT_EQ(next_frame, first);
+
+	std::vector<FrameArenaStats> stats = allocator.get_stats();
+	ASSERT_EQ(stats.size(), 1);
+	EXPECT_GE(stats[0].peak, 200);
+	EXPECT_GE(stats[0].used, 100);
+	EXPECT_LT(stats[0].used, 200);
+}
+
+TEST(Core_FrameAllocator, DoubleBufferedSurvivesOneFrame) {
+
+	using namespace era_engine;
+
+	FrameAllocator allocator(MB(64), KB(64));
+
+	uint32* values = allocator.allocate<uint32>(16, FrameLifetime::TwoFrames);
+	for (uint32 i = 0; i < 16; ++i)
+	{
+		values[i] = i;
+	}
+
+	allocator.begin_frame();
+	uint32* other_buffer = allocator.allocate<uint32>(16, FrameLifetime::TwoFrames);
+	memset(other_buffer, 0, 16 * sizeof(uint32));
+
+	for (uint32 i = 0; i < 16; ++i)
+	{
+		EXPECT_EQ(values[i], i);
+	}
+
+	allocator.begin_frame();
+	uint32* reused = allocator.allocate<uint32>(16, FrameLifetime::TwoFrames);
+	EXPECT_EQ(reused, values);
+}
+
+TEST(Core_FrameAllocator, ThreadsGetTheirOwnArenas) {
+
+	using namespace era_engine;
+
+	FrameAllocator allocator(MB(64), KB(64));
+
+	constexpr uint32 num_threads = 4;
+	constexpr uint32 num_allocations = 1000;
+
+	std::vector<std::thread> threads;
+	for (uint32 t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([&allocator, t]()
+			{
+				for (uint32 i = 0; i < num_allocations; ++i)
+				{
+					uint32* value = allocator.allocate<uint32>();
+					*value = t;
+					EXPECT_EQ(*value, t);
+				}
+			});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	std::vector<FrameArenaStats> stats = allocator.get_stats();
+	ASSERT_EQ(stats.size(), num_threads);
+	for (const FrameArenaStats& thread_stats : stats)
+	{
+		EXPECT_GE(thread_stats.used, num_allocations * sizeof(uint32));
+	}
+}
+
+TEST(Core_FrameAllocator, MemoryResource) {
+
+	using namespace era_engine;
+
+	FrameAllocator allocator(MB(64), KB(64));
+	FrameMemoryResource resource(allocator);
+
+	std::pmr::vector<uint64> values(&resource);
+	for (uint64 i = 0; i < 10000; ++i)
+	{
+		values.push_back(i);
+	}
+
+	EXPECT_EQ(values.size(), 10000);
+	EXPECT_EQ(values[9999], 9999);
+
+	FrameMemoryResource same(allocator);
+	FrameMemoryResource other(allocator, FrameLifetime::TwoFrames);
+	EXPECT_TRUE(resource.is_equal(same));
+	EXPECT_FALSE(resource.is_equal(other));
+}
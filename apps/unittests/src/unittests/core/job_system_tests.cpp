@@ -0,0 +1,320 @@
+#include <gtest/gtest.h>
+
+#include <core/job_system.h>
+#include <core/cpu_profiling.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace
+{
+	struct CounterJobData
+	{
+		std::atomic<uint32>* counter;
+	};
+}
+
+TEST(Core_JobSystem, BurstAboveInitialCapacity) {
+
+	using namespace era_engine;
+
+	// No worker threads: everything runs on the calling thread inside wait_for_completion.
+	static JobQueue queue;
+	queue.initialize(0, 0, ThreadPriority::Normal, nullptr);
+
+	std::atomic<uint32> counter = 0;
+	constexpr uint32 num_jobs = 10000;
+
+	JobHandle root = queue.createJob<CounterJobData>([](CounterJobData& data, JobHandle) {}, { &counter });
+
+	// Create everything before submitting anything, so that all jobs are in flight at the same time.
+	std::vector<JobHandle> children;
+	for (uint32 i = 0; i < num_jobs; ++i)
+	{
+		children.push_back(queue.createJob<CounterJobData>([](CounterJobData& data, JobHandle)
+			{
+				data.counter->fetch_add(1);
+			}, { &counter }, root));
+	}
+
+	for (JobHandle& child : children)
+	{
+		child.submit_now();
+	}
+
+	root.submit_now();
+	root.wait_for_completion();
+
+	ASSERT_EQ(counter.load(), num_jobs);
+
+	JobQueue::JobQueueStats stats = queue.get_stats();
+	ASSERT_EQ(stats.in_flight_jobs, 0u);
+	ASSERT_GE(stats.peak_in_flight_jobs, num_jobs + 1);
+	ASSERT_GE(stats.allocated_slots, num_jobs + 1);
+}
+
+TEST(Core_JobSystem, StaleHandleWaitReturns) {
+
+	using namespace era_engine;
+
+	static JobQueue queue;
+	queue.initialize(0, 0, ThreadPriority::Normal, nullptr);
+
+	std::atomic<uint32> counter = 0;
+
+	JobHandle first = queue.createJob<CounterJobData>([](CounterJobData& data, JobHandle)
+		{
+			data.counter->fetch_add(1);
+		}, { &counter });
+	first.submit_now();
+	first.wait_for_completion();
+
+	// The next job reuses the slot of the first one. A wait on the old handle must not wait for the new job.
+	JobHandle second = queue.createJob<CounterJobData>([](CounterJobData& data, JobHandle)
+		{
+			data.counter->fetch_add(1);
+		}, { &counter });
+
+	ASSERT_EQ(first.index, second.index);
+	ASSERT_NE(first.generation, second.generation);
+
+	first.wait_for_completion();
+	ASSERT_EQ(counter.load(), 1u);
+	ASSERT_EQ(queue.get_stats().stale_waits, 1u);
+
+	second.submit_now();
+	second.wait_for_completion();
+	ASSERT_EQ(counter.load(), 2u);
+}
+
+TEST(Core_JobSystem, ContinuationAfterFinishedJob) {
+
+	using namespace era_engine;
+
+	static JobQueue queue;
+	queue.initialize(0, 0, ThreadPriority::Normal, nullptr);
+
+	std::atomic<uint32> counter = 0;
+
+	JobHandle first = queue.createJob<CounterJobData>([](CounterJobData& data, JobHandle)
+		{
+			data.counter->fetch_add(1);
+		}, { &counter });
+	first.submit_now();
+	first.wait_for_completion();
+
+	JobHandle second = queue.createJob<CounterJobData>([](CounterJobData& data, JobHandle)
+		{
+			data.counter->fetch_add(10);
+		}, { &counter });
+	second.submit_after(first);
+	second.wait_for_completion();
+
+	ASSERT_EQ(counter.load(), 11u);
+}
+
+namespace
+{
+	era_engine::JobQueue& get_parallel_test_queue()
+	{
+		using namespace era_engine;
+
+		// Workers are detached and never stop, so the queue is intentionally leaked instead of destroyed under them.
+		static JobQueue* queue = nullptr;
+		if (!queue)
+		{
+			queue = new JobQueue();
+			queue->initialize(3, 1, ThreadPriority::Normal, L"Test worker", JobQueueMode::WorkStealing);
+		}
+		return *queue;
+	}
+}
+
+TEST(Core_JobSystem, ParallelForCoversRangeOnce) {
+
+	using namespace era_engine;
+
+	constexpr uint32 count = 100000;
+	std::vector<std::atomic<uint32>> visits(count);
+
+	parallel_for(0, count, 64, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				visits[i].fetch_add(1);
+			}
+		}, get_parallel_test_queue());
+
+	for (uint32 i = 0; i < count; ++i)
+	{
+		ASSERT_EQ(visits[i].load(), 1u);
+	}
+}
+
+TEST(Core_JobSystem, ParallelForSmallRangeRunsInline) {
+
+	using namespace era_engine;
+
+	const std::thread::id caller = std::this_thread::get_id();
+	bool inline_call = false;
+
+	parallel_for(10, 20, 64, [&](uint32 begin, uint32 end)
+		{
+			inline_call = (std::this_thread::get_id() == caller) && begin == 10 && end == 20;
+		}, get_parallel_test_queue());
+
+	ASSERT_TRUE(inline_call);
+}
+
+TEST(Core_JobSystem, ParallelReduceSum) {
+
+	using namespace era_engine;
+
+	constexpr uint32 count = 1000000;
+
+	uint64 sum = parallel_reduce(0, count, 1024, (uint64)0,
+		[](uint32 begin, uint32 end, uint64 value)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				value += i;
+			}
+			return value;
+		},
+		[](uint64 a, uint64 b) { return a + b; },
+		get_parallel_test_queue());
+
+	ASSERT_EQ(sum, (uint64)count * (count - 1) / 2);
+}
+
+TEST(Core_JobSystem, ParallelSort) {
+
+	using namespace era_engine;
+
+	std::mt19937 rng(1234);
+	std::vector<uint32> values(200003);
+	for (uint32& value : values)
+	{
+		value = rng();
+	}
+
+	std::vector<uint32> expected = values;
+	std::sort(expected.begin(), expected.end());
+
+	parallel_sort(values.begin(), values.end(), std::less<>{}, 1024, get_parallel_test_queue());
+
+	ASSERT_EQ(values, expected);
+}
+
+#if ENABLE_CPU_PROFILING
+
+namespace
+{
+	// Value of a field in one line of the trace, which has one event per line.
+	std::string get_trace_field(const std::string& line, const char* name)
+	{
+		const std::string key = std::string("\"") + name + "\":";
+		size_t begin = line.find(key);
+		if (begin == std::string::npos)
+		{
+			return {};
+		}
+		begin += key.size();
+
+		if (line[begin] == '"')
+		{
+			return line.substr(begin + 1, line.find('"', begin + 1) - begin - 1);
+		}
+		return line.substr(begin, line.find_first_of(",}", begin) - begin);
+	}
+}
+
+TEST(Core_JobSystem, ContinuationFlowsAreBoundToSlices) {
+
+	using namespace era_engine;
+
+	JobQueue& queue = get_parallel_test_queue();
+
+	// Everything recorded by earlier tests goes out before the capture starts.
+	cpu_profiling_resolve_time_stamps();
+
+	const fs::path path = fs::temp_directory_path() / "era_job_flow_trace.json";
+	ASSERT_TRUE(begin_cpu_profile_capture(path));
+
+	std::atomic<uint32> counter = 0;
+	auto add = [](CounterJobData& data, JobHandle)
+		{
+			data.counter->fetch_add(1);
+		};
+
+	JobHandle first = queue.createJob<CounterJobData>(add, { &counter });
+	JobHandle second = queue.createJob<CounterJobData>(add, { &counter });
+	JobHandle third = queue.createJob<CounterJobData>(add, { &counter });
+	second.submit_after(first);
+	third.submit_after(second);
+	first.submit_now();
+	third.wait_for_completion();
+
+	ASSERT_EQ(counter.load(), 3u);
+
+	cpu_profiling_resolve_time_stamps();
+	end_cpu_profile_capture();
+
+	std::ifstream trace(path);
+	ASSERT_TRUE(trace.is_open());
+
+	struct FlowEnds
+	{
+		uint32 num_begins = 0;
+		uint32 num_ends = 0;
+	};
+
+	std::map<std::string, int32> open_slices_per_thread;
+	std::map<std::string, FlowEnds> flows;
+
+	std::string line;
+	while (std::getline(trace, line))
+	{
+		const std::string phase = get_trace_field(line, "ph");
+		const std::string thread = get_trace_field(line, "tid");
+
+		if (phase == "B")
+		{
+			++open_slices_per_thread[thread];
+		}
+		else if (phase == "E")
+		{
+			--open_slices_per_thread[thread];
+		}
+		else if (phase == "s" || phase == "f")
+		{
+			// Outside of a slice, viewers drop the flow.
+			ASSERT_GT(open_slices_per_thread[thread], 0) << line;
+
+			FlowEnds& flow = flows[get_trace_field(line, "id")];
+			if (phase == "s")
+			{
+				++flow.num_begins;
+			}
+			else
+			{
+				ASSERT_EQ(get_trace_field(line, "bp"), "e") << line;
+				++flow.num_ends;
+			}
+		}
+	}
+
+	// One flow from the first job to the second and one from the second to the third.
+	ASSERT_EQ(flows.size(), 2u);
+	for (const auto& [id, flow] : flows)
+	{
+		ASSERT_EQ(flow.num_begins, 1u) << id;
+		ASSERT_EQ(flow.num_ends, 1u) << id;
+	}
+
+	trace.close();
+	fs::remove(path);
+}
+
+#endif
@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+
+#include <core/log.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using namespace era_engine;
+
+	// Collects what the log thread formatted. Optionally holds the log thread inside write() until released, so the
+	// rings fill up deterministically.
+	class CaptureLogSink final : public LogSink
+	{
+	public:
+		void write(const LogRecord& record) override
+		{
+			std::unique_lock lock{ mutex };
+			texts.push_back(record.text);
+			types.push_back(record.type);
+
+			if (hold)
+			{
+				held = true;
+				condition.notify_all();
+				condition.wait(lock, [this]() { return !hold; });
+			}
+		}
+
+		void wait_until_held()
+		{
+			std::unique_lock lock{ mutex };
+			condition.wait(lock, [this]() { return held; });
+		}
+
+		void release()
+		{
+			std::lock_guard lock{ mutex };
+			hold = false;
+			condition.notify_all();
+		}
+
+		std::vector<std::string> get_texts()
+		{
+			std::lock_guard lock{ mutex };
+			return texts;
+		}
+
+		std::vector<MessageType> get_types()
+		{
+			std::lock_guard lock{ mutex };
+			return types;
+		}
+
+		bool hold = false;
+
+	private:
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool held = false;
+
+		std::vector<std::string> texts;
+		std::vector<MessageType> types;
+	};
+
+	class Core_Log : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			clear_log_sinks();
+			sink = make_ref<CaptureLogSink>();
+			add_log_sink(sink);
+		}
+
+		void TearDown() override
+		{
+			set_log_overflow_policy(LogOverflowPolicy::DROP);
+			clear_log_sinks();
+			add_log_sink(make_ref<ConsoleLogSink>());
+		}
+
+		ref<CaptureLogSink> sink;
+	};
+}
+
+TEST(Core_LogRecord, Packing)
+{
+	using namespace era_engine;
+	using namespace era_engine::log_internal;
+
+	const char* text = "abc";
+	const wchar_t* wide_text = L"abc";
+	const char* null_text = nullptr;
+
+	ASSERT_EQ(get_encoded_size(42), 1u + sizeof(uint64));
+	ASSERT_EQ(get_encoded_size(1.5f), 1u + sizeof(uint64));
+	ASSERT_EQ(get_encoded_size(text), 1u + sizeof(uint32) + 4u * sizeof(char));
+	ASSERT_EQ(get_encoded_size(wide_text), 1u + sizeof(uint32) + 4u * sizeof(wchar_t));
+	ASSERT_EQ(get_encoded_size(null_text), 1u + sizeof(uint64));
+
+	uint8 buffer[64];
+
+	uint8* end = encode_argument(buffer, (uint16)7);
+	ASSERT_EQ((size_t)(end - buffer), 1u + sizeof(uint64));
+	ASSERT_EQ(buffer[0], log_argument_uint);
+
+	encode_argument(buffer, -3);
+	ASSERT_EQ(buffer[0], log_argument_int);
+	int64 int_value;
+	memcpy(&int_value, buffer + 1, sizeof(int_value));
+	ASSERT_EQ(int_value, -3);
+
+	encode_argument(buffer, 0.25f);
+	ASSERT_EQ(buffer[0], log_argument_double);
+	double double_value;
+	memcpy(&double_value, buffer + 1, sizeof(double_value));
+	ASSERT_EQ(double_value, 0.25);
+
+	end = encode_argument(buffer, text);
+	ASSERT_EQ((uint32)(end - buffer), get_encoded_size(text));
+	ASSERT_EQ(buffer[0], log_argument_string);
+	uint32 count;
+	memcpy(&count, buffer + 1, sizeof(count));
+	ASSERT_EQ(count, 4u);
+	ASSERT_STREQ((const char*)(buffer + 1 + sizeof(count)), "abc");
+
+	end = encode_argument(buffer, null_text);
+	ASSERT_EQ((uint32)(end - buffer), get_encoded_size(null_text));
+	ASSERT_EQ(buffer[0], log_argument_pointer);
+
+	// Long strings are cut, terminator included.
+	const std::string long_text(LOG_MAX_STRING_LENGTH * 2, 'x');
+	ASSERT_EQ(get_encoded_size(long_text.c_str()), 1u + sizeof(uint32) + LOG_MAX_STRING_LENGTH);
+}
+
+TEST_F(Core_Log, Formatting)
+{
+	using namespace era_engine;
+
+	const char* null_text = nullptr;
+	const wchar_t* wide_text = L"wide";
+
+	log_message(message_type_normal, "plain");
+	log_message(message_type_normal, "%d %u %x %s", -5, 7u, 255, "text");
+	log_message(message_type_normal, "[%*d] [%-*d] [%.*f]", 5, 42, 4, 7, 2, 3.14159);
+	log_message(message_type_normal, "%ws and %ls", wide_text, wide_text);
+	log_message(message_type_normal, "null: %s", null_text);
+	log_message(message_type_normal, "%d%% of %s", 100, "everything");
+	log_message(message_type_normal, "%llu %lld %zu", (uint64)1 << 40, (int64)-1, (size_t)9);
+	log_message(message_type_normal, "%d %s", "not a number", 3);
+	log_message(message_type_normal, "missing %d %s", 1);
+	log_message_internal(message_type_warning, "file.cpp", "function", 12, "warning %5.1f", 2.5);
+	log_message(message_type_error, "error %c", 'e');
+	log_flush();
+
+	const std::vector<std::string> texts = sink->get_texts();
+	const std::vector<MessageType> types = sink->get_types();
+	ASSERT_EQ(texts.size(), 11u);
+
+	ASSERT_EQ(texts[0], "plain");
+	ASSERT_EQ(texts[1], "-5 7 ff text");
+	ASSERT_EQ(texts[2], "[   42] [7   ] [3.14]");
+	ASSERT_EQ(texts[3], "wide and wide");
+	ASSERT_EQ(texts[4], "null: (null)");
+	ASSERT_EQ(texts[5], "100% of everything");
+	ASSERT_EQ(texts[6], "1099511627776 -1 9");
+	ASSERT_EQ(texts[7], "(invalid) (invalid)");
+	ASSERT_EQ(texts[8], "missing 1 %s");
+	ASSERT_EQ(texts[9], "warning   2.5");
+	ASSERT_EQ(texts[10], "error e");
+
+	ASSERT_EQ(types[9], message_type_warning);
+	ASSERT_EQ(types[10], message_type_error);
+}
+
+TEST_F(Core_Log, KeepsOrderAcrossThreads)
+{
+	using namespace era_engine;
+
+	constexpr uint32 num_threads = 4;
+	constexpr uint32 num_messages = 200;
+
+	std::vector<std::thread> threads;
+	for (uint32 t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([t]()
+		{
+			for (uint32 i = 0; i < num_messages; ++i)
+			{
+				log_message(message_type_normal, "%u %u", t, i);
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	log_flush();
+
+	const std::vector<std::string> texts = sink->get_texts();
+	ASSERT_EQ(texts.size(), num_threads * num_messages);
+
+	// Records of one thread come out in the order they were logged.
+	uint32 next[num_threads] = {};
+	for (const std::string& text : texts)
+	{
+		uint32 t, i;
+		ASSERT_EQ(sscanf(text.c_str(), "%u %u", &t, &i), 2);
+		ASSERT_LT(t, num_threads);
+		ASSERT_EQ(i, next[t]++);
+	}
+}
+
+TEST_F(Core_Log, DropsWhenRingIsFull)
+{
+	using namespace era_engine;
+
+	const uint64 dropped_before = get_num_dropped_log_messages();
+
+	// Keep the log thread busy inside the sink, nobody empties the ring while it's flooded.
+	sink->hold = true;
+	log_message(message_type_normal, "gate");
+	sink->wait_until_held();
+
+	const std::string text(500, 'x');
+	constexpr uint32 num_messages = 1000; // ~500 KB, several times the ring.
+	for (uint32 i = 0; i < num_messages; ++i)
+	{
+		log_message(message_type_normal, "%s", text.c_str());
+	}
+
+	const uint64 dropped = get_num_dropped_log_messages() - dropped_before;
+
+	sink->release();
+	log_flush();
+
+	ASSERT_GT(dropped, 0u);
+	ASSERT_LT(dropped, (uint64)num_messages);
+
+	const std::vector<std::string> texts = sink->get_texts();
+	const std::vector<MessageType> types = sink->get_types();
+
+	uint32 num_delivered = 0;
+	uint32 num_drop_warnings = 0;
+	for (uint32 i = 0; i < texts.size(); ++i)
+	{
+		num_delivered += (texts[i] == text);
+		num_drop_warnings += (types[i] == message_type_warning && texts[i].find("messages dropped") != std::string::npos);
+	}
+
+	ASSERT_EQ(num_delivered + dropped, num_messages);
+	ASSERT_GE(num_drop_warnings, 1u);
+	ASSERT_EQ(get_num_dropped_log_messages() - dropped_before, dropped);
+}
+
+TEST_F(Core_Log, BlockPolicyKeepsEverything)
+{
+	using namespace era_engine;
+
+	set_log_overflow_policy(LogOverflowPolicy::BLOCK);
+	const uint64 dropped_before = get_num_dropped_log_messages();
+
+	sink->hold = true;
+	log_message(message_type_normal, "gate");
+	sink->wait_until_held();
+
+	const std::string text(500, 'y');
+	constexpr uint32 num_messages = 1000;
+
+	// Blocks once the ring is full, until the sink lets the log thread go on.
+	std::thread writer([&text]()
+	{
+		for (uint32 i = 0; i < num_messages; ++i)
+		{
+			log_message(message_type_normal, "%s", text.c_str());
+		}
+	});
+
+	sink->release();
+	writer.join();
+	log_flush();
+
+	const std::vector<std::string> texts = sink->get_texts();
+
+	uint32 num_delivered = 0;
+	for (const std::string& delivered : texts)
+	{
+		num_delivered += (delivered == text);
+	}
+
+	ASSERT_EQ(num_delivered, num_messages);
+	ASSERT_EQ(get_num_dropped_log_messages(), dropped_before);
+}
@@ -2,6 +2,7 @@
 
 #include <ecs/world.h>
 #include <ecs/base_components/base_components.h>
+#include <ecs/base_components/transform_hierarchy.h>
 #include <core/ecs/tags_component.h>
 
 TEST(ECS_Components, TagsComponent) {
@@ -54,4 +55,53 @@ TEST(ECS_Components, ChildComponent) {
 
 	delete runtime_world;
 
-}
\ No newline at end of file
+}
+
+TEST(ECS_Components, TransformHierarchy) {
+
+	using namespace era_engine;
+
+	World* runtime_world = new World(World::GAMEPLAY_WORLD_NAME);
+	runtime_world->init();
+
+	Entity parent = runtime_world->create_entity();
+	Entity child = runtime_world->create_entity();
+	Entity grandchild = runtime_world->create_entity();
+	child.set_parent(parent.get_handle());
+	grandchild.set_parent(child.get_handle());
+
+	TransformComponent* parent_transform = parent.get_component<TransformComponent>();
+	TransformComponent* child_transform = child.get_component<TransformComponent>();
+	TransformComponent* grandchild_transform = grandchild.get_component<TransformComponent>();
+
+	child_transform->set_local_transform(trs(vec3(0.0f, 1.0f, 0.0f), quat::identity));
+	grandchild_transform->set_local_transform(trs(vec3(0.0f, 0.0f, 1.0f), quat::identity));
+
+	EXPECT_FLOAT_EQ(grandchild_transform->get_world_position().y, 1.0f);
+	EXPECT_FALSE(grandchild_transform->is_world_transform_dirty());
+
+	// Moving an ancestor invalidates the whole subtree.
+	const uint32 version = grandchild_transform->get_world_transform_version();
+	parent_transform->set_local_transform(trs(vec3(2.0f, 0.0f, 0.0f), quat::identity));
+
+	EXPECT_TRUE(child_transform->is_world_transform_dirty());
+	EXPECT_TRUE(grandchild_transform->is_world_transform_dirty());
+
+	// The batched pass produces the same result as lazy reads.
+	TransformHierarchy::update(runtime_world);
+
+	EXPECT_FALSE(grandchild_transform->is_world_transform_dirty());
+	EXPECT_GT(grandchild_transform->get_world_transform_version(), version);
+	EXPECT_FLOAT_EQ(grandchild_transform->get_world_position().x, 2.0f);
+	EXPECT_FLOAT_EQ(grandchild_transform->get_world_position().y, 1.0f);
+	EXPECT_FLOAT_EQ(grandchild_transform->get_world_position().z, 1.0f);
+
+	// Children follow a world space change of their parent.
+	child_transform->set_world_position(vec3(0.0f, 5.0f, 0.0f));
+
+	EXPECT_FLOAT_EQ(child_transform->get_local_transform().position.x, -2.0f);
+	EXPECT_FLOAT_EQ(grandchild_transform->get_world_position().y, 5.0f);
+	EXPECT_FLOAT_EQ(grandchild_transform->get_world_position().z, 1.0f);
+
+	delete runtime_world;
+}
@@ -0,0 +1,507 @@
+#include <gtest/gtest.h>
+
+#include <ecs/world.h>
+#include <ecs/system.h>
+#include <ecs/update_groups.h>
+#include <ecs/world_system_scheduler.h>
+
+#include "unittests/test_utils.h"
+
+#include <rttr/registration>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace era_engine
+{
+	static constexpr const char* scheduler_test_tag = "scheduler_test";
+
+	// Names of the tasks in the order they started.
+	struct SchedulerTestLog
+	{
+		void record(const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(sync);
+			order.push_back(name);
+		}
+
+		uint32 index_of(const std::string& name) const
+		{
+			return (uint32)(std::find(order.begin(), order.end(), name) - order.begin());
+		}
+
+		std::mutex sync;
+		std::vector<std::string> order;
+	};
+
+	static SchedulerTestLog scheduler_test_log;
+
+	class SchedulerOrderTestSystem final : public System
+	{
+	public:
+		SchedulerOrderTestSystem(World* _world) : System(_world) {}
+
+		void first(float dt) { run("first"); }
+		void second(float dt) { run("second"); }
+		void third(float dt) { run("third"); }
+		void independent(float dt) { run("independent"); }
+
+		ERA_VIRTUAL_REFLECT(System)
+
+	private:
+		void run(const char* name)
+		{
+			scheduler_test_log.record(name);
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+	};
+
+	class SchedulerAccessTestSystem final : public System
+	{
+	public:
+		SchedulerAccessTestSystem(World* _world) : System(_world) {}
+
+		void write_transforms(float dt) {}
+		void read_transforms(float dt) {}
+		void read_transforms_too(float dt) {}
+		void undeclared_first(float dt) {}
+		void undeclared_second(float dt) {}
+
+		ERA_VIRTUAL_REFLECT(System)
+	};
+
+	class SchedulerTimingTestSystem final : public System
+	{
+	public:
+		SchedulerTimingTestSystem(World* _world) : System(_world) {}
+
+		void long_first(float dt) { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+		void long_second(float dt) { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+		void short_task(float dt) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }
+
+		ERA_VIRTUAL_REFLECT(System)
+	};
+
+	class SchedulerTagTestSystem final : public System
+	{
+	public:
+		SchedulerTagTestSystem(World* _world) : System(_world) {}
+
+		void before_render(float dt) { scheduler_test_log.record("before_render"); }
+
+		ERA_VIRTUAL_REFLECT(System)
+	};
+
+	class SchedulerRenderTestSystem final : public System
+	{
+	public:
+		SchedulerRenderTestSystem(World* _world) : System(_world) {}
+
+		void render(float dt) { scheduler_test_log.record("render"); }
+
+		ERA_VIRTUAL_REFLECT(System)
+	};
+
+	// Counts tasks which ran on a worker of the other update's queue.
+	struct SchedulerQueueTestLog
+	{
+		std::atomic<uint32> fixed_tasks_on_normal_workers = 0;
+		std::atomic<uint32> normal_tasks_on_fixed_workers = 0;
+		std::atomic<uint32> num_tasks = 0;
+	};
+
+	static SchedulerQueueTestLog scheduler_queue_test_log;
+
+	class SchedulerQueueTestSystem final : public System
+	{
+	public:
+		SchedulerQueueTestSystem(World* _world) : System(_world) {}
+
+		void fixed_first(float dt) { record_fixed(); }
+		void fixed_second(float dt) { record_fixed(); }
+		void normal_first(float dt) { record_normal(); }
+		void normal_second(float dt) { record_normal(); }
+
+		ERA_VIRTUAL_REFLECT(System)
+
+	private:
+		void record_fixed()
+		{
+			scheduler_queue_test_log.fixed_tasks_on_normal_workers += (high_priority_job_queue.get_current_worker_index() != -1);
+			++scheduler_queue_test_log.num_tasks;
+		}
+
+		void record_normal()
+		{
+			scheduler_queue_test_log.normal_tasks_on_fixed_workers += (fixed_update_job_queue.get_current_worker_index() != -1);
+			++scheduler_queue_test_log.num_tasks;
+		}
+	};
+
+	RTTR_REGISTRATION
+	{
+		using namespace rttr;
+
+		const UpdateGroup& concurrent = update_types::GAMEPLAY_NORMAL_CONCURRENT;
+
+		registration::class_<SchedulerOrderTestSystem>("SchedulerOrderTestSystem")
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string(scheduler_test_tag)))
+			.method("first", &SchedulerOrderTestSystem::first)(metadata("update_group", concurrent))
+			.method("second", &SchedulerOrderTestSystem::second)(metadata("update_group", concurrent),
+				metadata("After", std::vector<std::string>{"SchedulerOrderTestSystem::first"}))
+			.method("third", &SchedulerOrderTestSystem::third)(metadata("update_group", concurrent),
+				metadata("After", std::vector<std::string>{"SchedulerOrderTestSystem::second"}))
+			.method("independent", &SchedulerOrderTestSystem::independent)(metadata("update_group", concurrent));
+
+		registration::class_<SchedulerAccessTestSystem>("SchedulerAccessTestSystem")
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string(scheduler_test_tag)))
+			.method("write_transforms", &SchedulerAccessTestSystem::write_transforms)(metadata("update_group", concurrent),
+				metadata("Writes", std::vector<std::string>{"TransformComponent"}))
+			.method("read_transforms", &SchedulerAccessTestSystem::read_transforms)(metadata("update_group", concurrent),
+				metadata("Reads", std::vector<std::string>{"TransformComponent"}))
+			.method("read_transforms_too", &SchedulerAccessTestSystem::read_transforms_too)(metadata("update_group", concurrent),
+				metadata("Reads", std::vector<std::string>{"TransformComponent"}))
+			.method("undeclared_first", &SchedulerAccessTestSystem::undeclared_first)(metadata("update_group", concurrent))
+			.method("undeclared_second", &SchedulerAccessTestSystem::undeclared_second)(metadata("update_group", concurrent));
+
+		registration::class_<SchedulerTimingTestSystem>("SchedulerTimingTestSystem")
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string(scheduler_test_tag)))
+			.method("long_first", &SchedulerTimingTestSystem::long_first)(metadata("update_group", concurrent))
+			.method("long_second", &SchedulerTimingTestSystem::long_second)(metadata("update_group", concurrent),
+				metadata("After", std::vector<std::string>{"SchedulerTimingTestSystem::long_first"}))
+			.method("short_task", &SchedulerTimingTestSystem::short_task)(metadata("update_group", concurrent));
+
+		registration::class_<SchedulerQueueTestSystem>("SchedulerQueueTestSystem")
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string(scheduler_test_tag)))
+			.method("fixed_first", &SchedulerQueueTestSystem::fixed_first)(metadata("update_group", update_types::GAMEPLAY_AFTER_PHYSICS_CONCURRENT))
+			.method("fixed_second", &SchedulerQueueTestSystem::fixed_second)(metadata("update_group", update_types::GAMEPLAY_AFTER_PHYSICS_CONCURRENT))
+			.method("normal_first", &SchedulerQueueTestSystem::normal_first)(metadata("update_group", concurrent))
+			.method("normal_second", &SchedulerQueueTestSystem::normal_second)(metadata("update_group", concurrent));
+
+		registration::class_<SchedulerTagTestSystem>("SchedulerTagTestSystem")
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string(scheduler_test_tag)))
+			.method("before_render", &SchedulerTagTestSystem::before_render)(metadata("update_group", update_types::BEFORE_RENDER),
+				metadata("After", std::vector<std::string>{"SchedulerMissingTestSystem::update"}),
+				metadata("Before", std::vector<std::string>{"SchedulerRenderTestSystem::render"}));
+
+		registration::class_<SchedulerRenderTestSystem>("SchedulerRenderTestSystem")
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string("render")))
+			.method("render", &SchedulerRenderTestSystem::render)(metadata("update_group", update_types::BEFORE_RENDER));
+	}
+}
+
+namespace
+{
+	using namespace era_engine;
+
+	// Exposes the graphs, which are only built lazily on the next update otherwise.
+	class InspectableScheduler final : public WorldSystemScheduler
+	{
+	public:
+		using WorldSystemScheduler::WorldSystemScheduler;
+		using WorldSystemScheduler::TaskGraph;
+		using WorldSystemScheduler::build_task_graphs;
+	};
+
+	World* create_scheduler_test_world(const char* name)
+	{
+		World* world = new World(name);
+		world->init();
+		world->add_tag(scheduler_test_tag);
+		return world;
+	}
+
+	template <typename System_>
+	void initialize_test_system(WorldSystemScheduler* scheduler)
+	{
+		const rttr::type types[] = { rttr::type::get<System_>() };
+		scheduler->initialize_systems(rttr::array_range<rttr::type>(types, 1));
+		scheduler->initialize_all_systems();
+	}
+
+	const InspectableScheduler::TaskGraph* find_graph(const std::vector<ref<InspectableScheduler::TaskGraph>>& graphs, const char* group)
+	{
+		for (const ref<InspectableScheduler::TaskGraph>& graph : graphs)
+		{
+			if (graph->group == group)
+			{
+				return graph.get();
+			}
+		}
+		return nullptr;
+	}
+
+	uint32 find_node(const InspectableScheduler::TaskGraph& graph, const std::string& name)
+	{
+		for (uint32 i = 0; i < (uint32)graph.nodes.size(); ++i)
+		{
+			if (graph.nodes[i]->name == name)
+			{
+				return i;
+			}
+		}
+		return (uint32)graph.nodes.size();
+	}
+
+	bool depends_on(const InspectableScheduler::TaskGraph& graph, const std::string& dependent, const std::string& dependency)
+	{
+		const std::vector<uint32>& dependencies = graph.nodes[find_node(graph, dependent)]->dependencies;
+		return std::find(dependencies.begin(), dependencies.end(), find_node(graph, dependency)) != dependencies.end();
+	}
+
+	bool ordered(const InspectableScheduler::TaskGraph& graph, const std::string& a, const std::string& b)
+	{
+		return depends_on(graph, a, b) || depends_on(graph, b, a);
+	}
+
+	const UpdateGroupTiming* find_timing(const std::vector<UpdateGroupTiming>& timings, const char* group)
+	{
+		for (const UpdateGroupTiming& timing : timings)
+		{
+			if (timing.group == group)
+			{
+				return &timing;
+			}
+		}
+		return nullptr;
+	}
+
+	const TaskTiming* find_task_timing(const UpdateGroupTiming& timing, const std::string& name)
+	{
+		for (const TaskTiming& task : timing.tasks)
+		{
+			if (task.name == name)
+			{
+				return &task;
+			}
+		}
+		return nullptr;
+	}
+}
+
+TEST(ECS_WorldSystemScheduler, BuildsGroupGraph) {
+
+	using namespace era_engine;
+
+	World* world = create_scheduler_test_world("SchedulerGraphWorld");
+
+	{
+		InspectableScheduler scheduler(world);
+		scheduler.stop();
+
+		initialize_test_system<SchedulerOrderTestSystem>(&scheduler);
+
+		const std::vector<ref<InspectableScheduler::TaskGraph>> graphs = scheduler.build_task_graphs(UpdateType::NORMAL);
+		ASSERT_EQ(graphs.size(), 1u);
+
+		const InspectableScheduler::TaskGraph* graph = find_graph(graphs, update_types::GAMEPLAY_NORMAL_CONCURRENT.name);
+		ASSERT_NE(graph, nullptr);
+		ASSERT_FALSE(graph->main_thread);
+		ASSERT_EQ(graph->nodes.size(), 4u);
+
+		const uint32 first = find_node(*graph, "SchedulerOrderTestSystem::first");
+		const uint32 second = find_node(*graph, "SchedulerOrderTestSystem::second");
+		const uint32 third = find_node(*graph, "SchedulerOrderTestSystem::third");
+		const uint32 independent = find_node(*graph, "SchedulerOrderTestSystem::independent");
+		ASSERT_LT(first, 4u);
+		ASSERT_LT(second, 4u);
+		ASSERT_LT(third, 4u);
+		ASSERT_LT(independent, 4u);
+
+		// Nodes are stored in topological order.
+		EXPECT_LT(first, second);
+		EXPECT_LT(second, third);
+
+		EXPECT_TRUE(depends_on(*graph, "SchedulerOrderTestSystem::second", "SchedulerOrderTestSystem::first"));
+		EXPECT_TRUE(depends_on(*graph, "SchedulerOrderTestSystem::third", "SchedulerOrderTestSystem::second"));
+		EXPECT_FALSE(depends_on(*graph, "SchedulerOrderTestSystem::third", "SchedulerOrderTestSystem::first"));
+
+		EXPECT_TRUE(graph->nodes[independent]->dependencies.empty());
+		EXPECT_TRUE(graph->nodes[independent]->dependents.empty());
+
+		std::vector<uint32> roots = graph->roots;
+		std::sort(roots.begin(), roots.end());
+		std::vector<uint32> expected_roots = { first, independent };
+		std::sort(expected_roots.begin(), expected_roots.end());
+		EXPECT_EQ(roots, expected_roots);
+	}
+
+	delete world;
+}
+
+TEST(ECS_WorldSystemScheduler, OrdersConflictingAccessOnly) {
+
+	using namespace era_engine;
+
+	World* world = create_scheduler_test_world("SchedulerAccessWorld");
+
+	{
+		InspectableScheduler scheduler(world);
+		scheduler.stop();
+
+		initialize_test_system<SchedulerAccessTestSystem>(&scheduler);
+
+		const std::vector<ref<InspectableScheduler::TaskGraph>> graphs = scheduler.build_task_graphs(UpdateType::NORMAL);
+		const InspectableScheduler::TaskGraph* graph = find_graph(graphs, update_types::GAMEPLAY_NORMAL_CONCURRENT.name);
+		ASSERT_NE(graph, nullptr);
+		ASSERT_EQ(graph->nodes.size(), 5u);
+
+		// Writers are ordered against everything touching the same component, readers are not ordered against each other.
+		EXPECT_TRUE(ordered(*graph, "SchedulerAccessTestSystem::write_transforms", "SchedulerAccessTestSystem::read_transforms"));
+		EXPECT_TRUE(ordered(*graph, "SchedulerAccessTestSystem::write_transforms", "SchedulerAccessTestSystem::read_transforms_too"));
+		EXPECT_FALSE(ordered(*graph, "SchedulerAccessTestSystem::read_transforms", "SchedulerAccessTestSystem::read_transforms_too"));
+
+		// Tasks without a declaration conflict with nothing.
+		for (const char* name : { "SchedulerAccessTestSystem::undeclared_first", "SchedulerAccessTestSystem::undeclared_second" })
+		{
+			const uint32 node = find_node(*graph, name);
+			ASSERT_LT(node, 5u);
+			EXPECT_TRUE(graph->nodes[node]->dependencies.empty()) << name;
+			EXPECT_TRUE(graph->nodes[node]->dependents.empty()) << name;
+		}
+	}
+
+	delete world;
+}
+
+TEST(ECS_WorldSystemScheduler, RunsDependenciesInOrder) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	World* world = create_scheduler_test_world("SchedulerOrderWorld");
+	WorldSystemScheduler* scheduler = world->get_system_scheduler();
+	scheduler->stop();
+
+	initialize_test_system<SchedulerOrderTestSystem>(scheduler);
+
+	scheduler_test_log.order.clear();
+	scheduler->update_normal(1.0f / 60.0f);
+
+	ASSERT_EQ(scheduler_test_log.order.size(), 4u);
+	EXPECT_LT(scheduler_test_log.index_of("first"), scheduler_test_log.index_of("second"));
+	EXPECT_LT(scheduler_test_log.index_of("second"), scheduler_test_log.index_of("third"));
+	EXPECT_LT(scheduler_test_log.index_of("independent"), 4u);
+
+	const std::vector<UpdateGroupTiming> timings = scheduler->get_normal_timings();
+	const UpdateGroupTiming* timing = find_timing(timings, update_types::GAMEPLAY_NORMAL_CONCURRENT.name);
+	ASSERT_NE(timing, nullptr);
+	ASSERT_EQ(timing->tasks.size(), 4u);
+
+	const TaskTiming* first = find_task_timing(*timing, "SchedulerOrderTestSystem::first");
+	const TaskTiming* second = find_task_timing(*timing, "SchedulerOrderTestSystem::second");
+	const TaskTiming* third = find_task_timing(*timing, "SchedulerOrderTestSystem::third");
+	ASSERT_TRUE(first != nullptr && second != nullptr && third != nullptr);
+
+	EXPECT_GE(second->start_ms + 1e-6, first->start_ms + first->duration_ms);
+	EXPECT_GE(third->start_ms + 1e-6, second->start_ms + second->duration_ms);
+
+	delete world;
+}
+
+TEST(ECS_WorldSystemScheduler, ReportsCriticalPath) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	World* world = create_scheduler_test_world("SchedulerTimingWorld");
+	WorldSystemScheduler* scheduler = world->get_system_scheduler();
+	scheduler->stop();
+
+	initialize_test_system<SchedulerTimingTestSystem>(scheduler);
+
+	scheduler->update_normal(1.0f / 60.0f);
+
+	const std::vector<UpdateGroupTiming> timings = scheduler->get_normal_timings();
+	const UpdateGroupTiming* timing = find_timing(timings, update_types::GAMEPLAY_NORMAL_CONCURRENT.name);
+	ASSERT_NE(timing, nullptr);
+
+	const TaskTiming* long_first = find_task_timing(*timing, "SchedulerTimingTestSystem::long_first");
+	const TaskTiming* long_second = find_task_timing(*timing, "SchedulerTimingTestSystem::long_second");
+	const TaskTiming* short_task = find_task_timing(*timing, "SchedulerTimingTestSystem::short_task");
+	ASSERT_TRUE(long_first != nullptr && long_second != nullptr && short_task != nullptr);
+
+	// The chain of both long tasks is the longest path, whatever the short task measured.
+	EXPECT_TRUE(long_first->on_critical_path);
+	EXPECT_TRUE(long_second->on_critical_path);
+	EXPECT_FALSE(short_task->on_critical_path);
+
+	EXPECT_NEAR(timing->critical_path_ms, long_first->duration_ms + long_second->duration_ms, 1e-6);
+	EXPECT_GE(timing->critical_path_ms, 40.0);
+	EXPECT_GE(timing->duration_ms + 1e-6, timing->critical_path_ms);
+
+	delete world;
+}
+
+TEST(ECS_WorldSystemScheduler, RunsFixedGraphsOnTheirOwnQueue) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	World* world = create_scheduler_test_world("SchedulerQueueWorld");
+	WorldSystemScheduler* scheduler = world->get_system_scheduler();
+	scheduler->stop();
+
+	initialize_test_system<SchedulerQueueTestSystem>(scheduler);
+
+	// Workers of the high priority queue are running, but the fixed update never hands its tasks to them.
+	for (uint32 i = 0; i < 10; ++i)
+	{
+		scheduler->update_fixed(1.0f / 60.0f);
+		scheduler->update_normal(1.0f / 60.0f);
+	}
+
+	EXPECT_EQ(scheduler_queue_test_log.num_tasks.load(), 40u);
+	EXPECT_EQ(scheduler_queue_test_log.fixed_tasks_on_normal_workers.load(), 0u);
+	EXPECT_EQ(scheduler_queue_test_log.normal_tasks_on_fixed_workers.load(), 0u);
+
+	delete world;
+}
+
+TEST(ECS_WorldSystemScheduler, RunsMixedTagGroupWithLeadingTag) {
+
+	using namespace era_engine;
+
+	World* world = create_scheduler_test_world("SchedulerMixedTagWorld");
+	world->add_tag("base");
+
+	WorldSystemScheduler* scheduler = world->get_system_scheduler();
+	scheduler->stop();
+
+	// TransformSystem runs before CameraSystem::update, which is not registered here.
+	const rttr::type types[] = {
+		rttr::type::get<SchedulerTagTestSystem>(),
+		rttr::type::get<SchedulerRenderTestSystem>(),
+		rttr::type::get_by_name("TransformSystem")
+	};
+	ASSERT_TRUE(types[2].is_valid());
+
+	scheduler->initialize_systems(rttr::array_range<rttr::type>(types, 3));
+	scheduler->initialize_all_systems();
+
+	// The group's leading task has a tag of the world, so the whole group runs, the "render" task included.
+	scheduler_test_log.order.clear();
+	scheduler->update_normal(1.0f / 60.0f);
+	EXPECT_EQ(scheduler_test_log.order, (std::vector<std::string>{ "before_render", "render" }));
+
+	// None of the group's tags left: the group doesn't run.
+	world->remove_tag(scheduler_test_tag);
+
+	scheduler_test_log.order.clear();
+	scheduler->update_normal(1.0f / 60.0f);
+	EXPECT_TRUE(scheduler_test_log.order.empty());
+
+	// Any tag of the group enables it again.
+	world->add_tag("render");
+
+	scheduler_test_log.order.clear();
+	scheduler->update_normal(1.0f / 60.0f);
+	EXPECT_EQ(scheduler_test_log.order, (std::vector<std::string>{ "before_render", "render" }));
+
+	delete world;
+}
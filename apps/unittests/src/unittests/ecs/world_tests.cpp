@@ -3,6 +3,8 @@
 #include <ecs/base_components/base_components.h>
 #include <ecs/world.h>
 
+#include <algorithm>
+
 TEST(ECS_World, Initialization) {
 
 	using namespace era_engine;
@@ -40,4 +42,115 @@ TEST(ECS_World, AddEntity) {
 
 	delete runtime_world;
 
-}
\ No newline at end of file
+}
+
+TEST(ECS_World, DestroyEntityKeepsChilds) {
+
+	using namespace era_engine;
+
+	World* runtime_world = new World("GameWorld");
+	runtime_world->init();
+
+	Entity parent = runtime_world->create_entity("Parent");
+	Entity child = runtime_world->create_entity("Child");
+	child.set_parent(parent.get_handle());
+
+	const Entity::Handle parent_handle = parent.get_handle();
+	const Entity::Handle child_handle = child.get_handle();
+
+	runtime_world->destroy_entity(parent_handle, false);
+
+	ASSERT_TRUE(runtime_world->size() == 2);
+
+	Entity kept_child = runtime_world->get_entity(child_handle);
+	ASSERT_TRUE(kept_child.is_valid());
+	ASSERT_TRUE(kept_child.get_parent_handle() == runtime_world->get_root_handle());
+	ASSERT_TRUE(EntityContainer::get_childs(runtime_world, parent_handle).empty());
+
+	const std::vector<Entity::Handle> root_childs = EntityContainer::get_childs(runtime_world, runtime_world->get_root_handle());
+	ASSERT_TRUE(std::find(root_childs.begin(), root_childs.end(), child_handle) != root_childs.end());
+
+	delete runtime_world;
+}
+
+TEST(ECS_EntityDataPool, RejectsStaleHandlesAfterSlotReuse) {
+
+	using namespace era_engine;
+
+	entt::registry registry;
+	EntityDataPool pool;
+
+	const Entity::Handle first = registry.create();
+	Entity::EcsData* first_data = pool.emplace(first, Entity::NullHandle, nullptr, &registry);
+
+	ASSERT_TRUE(pool.size() == 1);
+	ASSERT_TRUE(pool.find(first) == first_data);
+
+	pool.erase(first);
+	registry.destroy(first);
+
+	ASSERT_TRUE(pool.size() == 0);
+	ASSERT_TRUE(pool.find(first) == nullptr);
+
+	// entt hands out the freed entity index again with a new version, which lands in the same slot.
+	const Entity::Handle second = registry.create();
+	ASSERT_TRUE(entt::to_entity(second) == entt::to_entity(first));
+	ASSERT_TRUE(second != first);
+
+	Entity::EcsData* second_data = pool.emplace(second, Entity::NullHandle, nullptr, &registry);
+
+	ASSERT_TRUE(second_data == first_data);
+	ASSERT_TRUE(pool.size() == 1);
+	ASSERT_TRUE(pool.find(second) == second_data);
+	ASSERT_TRUE(pool.find(first) == nullptr);
+	ASSERT_FALSE(pool.contains(first));
+	ASSERT_TRUE(pool.contains(second));
+}
+
+TEST(ECS_EntityDataPool, StaleEntityPtr) {
+
+	using namespace era_engine;
+
+	World* runtime_world = new World("GameWorld");
+	runtime_world->init();
+
+	Entity entity = runtime_world->create_entity("Entity");
+	EntityPtr ptr(entity);
+	ASSERT_FALSE(ptr.is_empty());
+
+	runtime_world->destroy_entity(entity);
+	ASSERT_TRUE(ptr.is_empty());
+
+	// The new entity reuses the slot of the destroyed one, but the old reference must not resolve to it.
+	Entity reused = runtime_world->create_entity("Reused");
+	ASSERT_TRUE(entt::to_entity(reused.get_handle()) == entt::to_entity(ptr.get_handle()));
+	ASSERT_TRUE(ptr.is_empty());
+	ASSERT_FALSE(runtime_world->get_entity(ptr.get_handle()).is_valid());
+
+	delete runtime_world;
+}
+
+TEST(ECS_EntityDataPool, StaleEntity) {
+
+	using namespace era_engine;
+
+	World* runtime_world = new World("GameWorld");
+	runtime_world->init();
+
+	Entity entity = runtime_world->create_entity("Entity");
+	const Entity::Handle handle = entity.get_handle();
+
+	runtime_world->destroy_entity(handle);
+	ASSERT_FALSE(entity.is_valid());
+
+	// The new entity lands in the same pool slot, which the stale Entity still points to.
+	Entity reused = runtime_world->create_entity("Reused");
+	ASSERT_TRUE(entt::to_entity(reused.get_handle()) == entt::to_entity(handle));
+	ASSERT_TRUE(reused.is_valid());
+
+	ASSERT_FALSE(entity.is_valid());
+	ASSERT_TRUE(entity.get_handle() == handle);
+	ASSERT_TRUE(entity != reused);
+
+	delete runtime_world;
+}
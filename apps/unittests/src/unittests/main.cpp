@@ -2,9 +2,16 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <cstdlib>
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
 
-	return RUN_ALL_TESTS();
+	int result = RUN_ALL_TESTS();
+
+	// Job queue workers (started by some tests) are detached and parked forever, so don't run static destructors under them.
+	fflush(stdout);
+	std::quick_exit(result);
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <motion_matching/motion_matching_database.h>
+#include <motion_matching/motion_matching_knn_structure.h>
+#include <motion_matching/brute_force/brute_force_knn_structure.h>
+#include <motion_matching/product_quantization/product_quantization_knn_structure.h>
+
+#include <random>
+
+static void fill_random_features(era_engine::MotionMatchingDatabase& database, uint32 rows, uint32 cols, uint32 seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+	database.search_dimension = cols;
+	database.search_features.resize(rows, cols);
+
+	std::vector<float> row(cols);
+	for (uint32 index = 0; index < rows; ++index)
+	{
+		for (float& feature : row)
+		{
+			feature = value(rng);
+		}
+		database.search_features.set_row(index, row.data());
+	}
+}
+
+static float naive_distance_sqr(const float* lhs, const float* rhs, uint32 size)
+{
+	float result = 0.0f;
+	for (uint32 index = 0; index < size; ++index)
+	{
+		result += (lhs[index] - rhs[index]) * (lhs[index] - rhs[index]);
+	}
+	return result;
+}
+
+TEST(MotionMatching_FeatureMatrix, RowsArePaddedAndAligned)
+{
+	using namespace era_engine;
+
+	FeatureMatrix matrix;
+	matrix.resize(3, 13);
+
+	EXPECT_EQ(matrix.get_stride(), 16u);
+
+	const float row[13] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f };
+	matrix.set_row(1, row);
+
+	for (uint32 index = 0; index < 3; ++index)
+	{
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(matrix.get_row(index)) % 32, 0u);
+	}
+	EXPECT_EQ(matrix.get_row(1)[12], 13.0f);
+	EXPECT_EQ(matrix.get_row(1)[13], 0.0f);
+	EXPECT_EQ(matrix.get_row(2)[0], 0.0f);
+}
+
+TEST(MotionMatching_KnnStructure, BruteForceMatchesNaiveSearch)
+{
+	using namespace era_engine;
+
+	MotionMatchingDatabase database(KnnStructureType::BRUTE_FORCE);
+	fill_random_features(database, 2000, 21, 3);
+
+	const float* query = database.search_features.get_row(123);
+
+	std::vector<std::pair<float, uint32>> expected;
+	for (uint32 row = 0; row < database.search_features.get_rows(); ++row)
+	{
+		expected.emplace_back(naive_distance_sqr(query, database.search_features.get_row(row), 21), row);
+	}
+	std::sort(expected.begin(), expected.end());
+
+	std::vector<KnnCandidate> candidates;
+	database.knn_structure->build_structure(database);
+	database.knn_structure->search_knn(query, 16, database, candidates);
+
+	ASSERT_EQ(candidates.size(), 16u);
+	EXPECT_EQ(candidates.front().sample_index, 123u);
+	for (uint32 index = 0; index < 16; ++index)
+	{
+		EXPECT_NEAR(candidates[index].distance_sqr, expected[index].first, 1e-4f);
+	}
+}
+
+TEST(MotionMatching_KnnStructure, ProductQuantizationFindsExactRow)
+{
+	using namespace era_engine;
+
+	MotionMatchingDatabase database(KnnStructureType::PRODUCT_QUANTIZATION);
+	fill_random_features(database, 5000, 16, 5);
+
+	database.knn_structure->build_structure(database);
+
+	std::vector<KnnCandidate> candidates;
+	for (uint32 row : { 0u, 1234u, 4999u })
+	{
+		database.knn_structure->search_knn(database.search_features.get_row(row), 5, database, candidates);
+
+		ASSERT_FALSE(candidates.empty());
+		EXPECT_EQ(candidates.front().sample_index, row);
+		EXPECT_NEAR(candidates.front().distance_sqr, 0.0f, 1e-5f);
+	}
+}
+
+TEST(MotionMatching_KnnStructure, BatchMatchesSingleSearches)
+{
+	using namespace era_engine;
+
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+	constexpr uint32 num_queries = 37;
+	constexpr uint32 max_candidates = 8;
+
+	for (KnnStructureType knn_type : { KnnStructureType::BRUTE_FORCE, KnnStructureType::PRODUCT_QUANTIZATION })
+	{
+		MotionMatchingDatabase database(knn_type);
+		fill_random_features(database, 6000, 13, 7);
+		database.knn_structure->build_structure(database);
+
+		FeatureMatrix queries(num_queries, 13);
+		for (uint32 query = 0; query < num_queries; ++query)
+		{
+			for (uint32 feature = 0; feature < 13; ++feature)
+			{
+				queries.get_row(query)[feature] = value(rng);
+			}
+		}
+
+		std::vector<KnnCandidate> batch_candidates(num_queries * max_candidates);
+		std::vector<uint32> batch_counts(num_queries);
+		database.knn_structure->search_knn_batch(queries.get_data(), queries.get_stride(), num_queries, max_candidates, database,
+			batch_candidates.data(), batch_counts.data());
+
+		std::vector<KnnCandidate> candidates;
+		for (uint32 query = 0; query < num_queries; ++query)
+		{
+			database.knn_structure->search_knn(queries.get_row(query), max_candidates, database, candidates);
+
+			ASSERT_EQ(batch_counts[query], uint32(candidates.size()));
+			for (uint32 index = 0; index < batch_counts[query]; ++index)
+			{
+				EXPECT_EQ(batch_candidates[query * max_candidates + index].sample_index, candidates[index].sample_index);
+				EXPECT_NEAR(batch_candidates[query * max_candidates + index].distance_sqr, candidates[index].distance_sqr, 1e-4f);
+			}
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <motion_matching/motion_matching_database.h>
+#include <motion_matching/motion_matching_knn_structure.h>
+
+#include <animation/animation_clip.h>
+
+#include <random>
+
+TEST(MotionMatching_Database, IncrementalBakeMatchesFullBake)
+{
+	using namespace era_engine;
+
+	constexpr uint32 num_features = 6;
+	constexpr uint32 samples_per_clip = 50;
+
+	std::vector<ref<animation::AnimationAssetClip>> clips;
+	std::vector<uint32> hashes;
+	for (uint32 clip = 0; clip < 4; ++clip)
+	{
+		clips.push_back(make_ref<animation::AnimationAssetClip>());
+		hashes.push_back(100 + clip);
+	}
+
+	std::atomic<uint32> num_extracted = 0;
+	const MotionMatchingDatabase::SampleExtractor extract_samples = [&](const animation::AnimationAssetClip& clip, float sample_rate,
+		std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>>& out_samples)
+	{
+		++num_extracted;
+
+		const uint32 clip_index = uint32(std::find_if(clips.begin(), clips.end(), [&](const auto& other) { return other.get() == &clip; }) - clips.begin());
+
+		std::mt19937 rng(clip_index);
+		std::normal_distribution<float> value(0.0f, 1.0f);
+
+		for (uint32 index = 0; index < samples_per_clip; ++index)
+		{
+			std::shared_ptr<MotionMatchingDatabase::Sample> sample = std::make_shared<MotionMatchingDatabase::Sample>();
+			sample->anim_position = float(index) / sample_rate;
+			for (uint32 feature = 0; feature < num_features; ++feature)
+			{
+				sample->features.push_back(value(rng) * float(num_features - feature));
+			}
+			out_samples.push_back(std::move(sample));
+		}
+	};
+
+	auto create_database = [&]()
+	{
+		ref<MotionMatchingDatabase> database = make_ref<MotionMatchingDatabase>(KnnStructureType::BRUTE_FORCE);
+		database->search_dimension = 3;
+		database->weights.assign(num_features, 1.0f);
+		return database;
+	};
+
+	ref<MotionMatchingDatabase> incremental = create_database();
+	incremental->animations = { clips[0], clips[1], clips[2] };
+	incremental->animations_hashes = { hashes[0], hashes[1], hashes[2] };
+	incremental->bake(extract_samples);
+	EXPECT_EQ(num_extracted, 3u);
+
+	incremental->animations.push_back(clips[3]);
+	incremental->animations_hashes.push_back(hashes[3]);
+	incremental->bake(extract_samples);
+	EXPECT_EQ(num_extracted, 4u);
+
+	incremental->animations.erase(incremental->animations.begin() + 1);
+	incremental->animations_hashes.erase(incremental->animations_hashes.begin() + 1);
+	incremental->bake(extract_samples);
+	EXPECT_EQ(num_extracted, 4u);
+	EXPECT_EQ(incremental->clip_samples_cache.size(), 3u);
+
+	ref<MotionMatchingDatabase> full = create_database();
+	full->animations = { clips[0], clips[2], clips[3] };
+	full->animations_hashes = { hashes[0], hashes[2], hashes[3] };
+	full->bake(extract_samples);
+
+	ASSERT_EQ(incremental->samples.size(), full->samples.size());
+	ASSERT_EQ(incremental->search_features.get_rows(), full->search_features.get_rows());
+
+	for (uint32 row = 0; row < uint32(full->samples.size()); ++row)
+	{
+		EXPECT_EQ(incremental->samples[row]->anim_index, full->samples[row]->anim_index);
+		EXPECT_EQ(incremental->samples[row]->features, full->samples[row]->features);
+
+		for (uint32 component = 0; component < full->search_dimension; ++component)
+		{
+			EXPECT_NEAR(incremental->search_features.get_row(row)[component], full->search_features.get_row(row)[component], 1e-4f);
+		}
+	}
+
+	// Search features are the principal components, largest variance first.
+	std::vector<double> variances(full->search_dimension, 0.0);
+	for (uint32 row = 0; row < full->search_features.get_rows(); ++row)
+	{
+		for (uint32 component = 0; component < full->search_dimension; ++component)
+		{
+			variances[component] += full->search_features.get_row(row)[component] * full->search_features.get_row(row)[component];
+		}
+	}
+	EXPECT_GT(variances[0], variances[1]);
+	EXPECT_GT(variances[1], variances[2]);
+}
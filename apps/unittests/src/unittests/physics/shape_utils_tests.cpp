@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <asset/model_asset.h>
+
+#include <physics/core/physics.h>
+#include <physics/shape_utils.h>
+
+namespace
+{
+	using namespace era_engine;
+
+	// Unit cube whose corners sit behind more than 65535 unused vertices, so the submesh needs 32-bit indices.
+	SubmeshAsset create_large_cube()
+	{
+		constexpr uint32 num_filler_vertices = 70000;
+
+		SubmeshAsset submesh;
+		submesh.positions.resize(num_filler_vertices, vec3(0.5f, 0.5f, 0.5f));
+
+		const uint32 first = (uint32)submesh.positions.size();
+		for (uint32 i = 0; i < 8; ++i)
+		{
+			submesh.positions.push_back(vec3((float)(i & 1), (float)((i >> 1) & 1), (float)((i >> 2) & 1)));
+		}
+
+		// Counter-clockwise seen from outside.
+		const uint32 faces[12][3] = {
+			{ 0, 2, 1 }, { 1, 2, 3 }, // -z
+			{ 4, 5, 6 }, { 5, 7, 6 }, // +z
+			{ 0, 1, 4 }, { 1, 5, 4 }, // -y
+			{ 2, 6, 3 }, { 3, 6, 7 }, // +y
+			{ 0, 4, 2 }, { 2, 4, 6 }, // -x
+			{ 1, 3, 5 }, { 3, 7, 5 }, // +x
+		};
+		for (const uint32* face : faces)
+		{
+			submesh.triangles32.push_back({ first + face[0], first + face[1], first + face[2] });
+		}
+
+		return submesh;
+	}
+}
+
+TEST(Physics_ShapeUtils, VolumeOfMeshWith32BitIndices) {
+
+	using namespace era_engine;
+	using namespace era_engine::physics;
+
+	ref<SubmeshAsset> submesh = make_ref<SubmeshAsset>(create_large_cube());
+	ASSERT_GT(submesh->positions.size(), 65535u);
+	ASSERT_TRUE(submesh->triangles.empty());
+
+	EXPECT_NEAR(ShapeUtils::volume_of_mesh(submesh), 1.0f, 1e-5f);
+}
+
+TEST(Physics_ShapeUtils, CooksMeshWith32BitIndices) {
+
+	using namespace era_engine;
+	using namespace era_engine::physics;
+
+	if (!PhysicsHolder::physics_ref)
+	{
+		PhysicsDescriptor descriptor;
+		descriptor.enable_pvd = false;
+		PhysicsHolder::physics_ref = make_ref<Physics>(descriptor);
+	}
+
+	MeshAsset asset;
+	asset.submeshes.push_back(create_large_cube());
+
+	physx::PxTriangleMesh* mesh = ShapeUtils::build_triangle_mesh(&asset, vec3(2.0f));
+	ASSERT_NE(mesh, nullptr);
+	EXPECT_EQ(mesh->getNbTriangles(), 12u);
+
+	const physx::PxBounds3 bounds = mesh->getLocalBounds();
+	EXPECT_NEAR(bounds.minimum.x, 0.0f, 1e-5f);
+	EXPECT_NEAR(bounds.maximum.x, 2.0f, 1e-5f);
+
+	mesh->release();
+}
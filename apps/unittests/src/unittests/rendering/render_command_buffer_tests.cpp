@@ -0,0 +1,345 @@
+#include <gtest/gtest.h>
+
+#include <core/job_system.h>
+
+#include <rendering/render_command_buffer.h>
+
+#include "unittests/test_utils.h"
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	using namespace era_engine;
+
+	struct TestCommand
+	{
+		uint64 key;
+		uint32 id;
+	};
+
+	struct FloatTestCommand
+	{
+		float key;
+	};
+
+	// Counts live instances, so clear() can be checked for running destructors.
+	struct CountedCommand
+	{
+		CountedCommand(std::atomic<int32>* _counter) : counter(_counter) { counter->fetch_add(1); }
+		~CountedCommand() { counter->fetch_sub(1); }
+
+		std::atomic<int32>* counter;
+	};
+
+	std::vector<TestCommand> rendered_commands;
+	std::vector<float> rendered_float_keys;
+	uint32 num_rendered_counted_commands = 0;
+
+	struct TestPipelineA
+	{
+		PIPELINE_SETUP_DECL {}
+		PIPELINE_RENDER_DECL(TestCommand) { rendered_commands.push_back(data); }
+	};
+
+	struct TestPipelineB
+	{
+		PIPELINE_SETUP_DECL {}
+		PIPELINE_RENDER_DECL(TestCommand) { rendered_commands.push_back(data); }
+	};
+
+	struct FloatTestPipeline
+	{
+		PIPELINE_SETUP_DECL {}
+		PIPELINE_RENDER_DECL(FloatTestCommand) { rendered_float_keys.push_back(data.key); }
+	};
+
+	struct CountedPipeline
+	{
+		PIPELINE_SETUP_DECL {}
+		PIPELINE_RENDER_DECL(CountedCommand) { ++num_rendered_counted_commands; }
+	};
+
+	struct RecordTestCommandsData
+	{
+		default_render_command_buffer<uint64>* buffer;
+		const uint64* keys;
+		uint32 first_id;
+		uint32 count;
+	};
+
+	template <typename Buffer_>
+	void render_all(const Buffer_& buffer)
+	{
+		for (const auto& dc : buffer)
+		{
+			dc.render(nullptr, mat4::identity, dc.data);
+		}
+	}
+}
+
+TEST(Rendering_RenderCommandBuffer, SortsByKeyAndKeepsRecordingOrderOfEqualKeys) {
+
+	using namespace era_engine;
+
+	default_render_command_buffer<uint64> buffer;
+
+	// Few distinct keys, so that there are many ties, spread over all bytes so that every radix pass runs.
+	std::mt19937_64 rng(42);
+	uint64 distinct_keys[16];
+	for (uint64& key : distinct_keys)
+	{
+		key = rng();
+	}
+
+	constexpr uint32 num_commands = 5000;
+	for (uint32 i = 0; i < num_commands; ++i)
+	{
+		const uint64 key = distinct_keys[rng() % 16];
+		if (i % 2 == 0)
+		{
+			buffer.emplace_back<TestPipelineA, TestCommand>(key, TestCommand{ key, i });
+		}
+		else
+		{
+			buffer.push_back<TestPipelineB>(key, TestCommand{ key, i });
+		}
+	}
+
+	ASSERT_EQ(buffer.size(), num_commands);
+
+	buffer.sort();
+
+	rendered_commands.clear();
+	for (const auto& dc : buffer)
+	{
+		const TestCommand* command = (const TestCommand*)dc.data;
+		EXPECT_EQ(dc.setup, (command->id % 2 == 0) ? (pipeline_setup_func)TestPipelineA::setup : (pipeline_setup_func)TestPipelineB::setup);
+
+		dc.render(nullptr, mat4::identity, dc.data);
+	}
+
+	ASSERT_EQ(rendered_commands.size(), num_commands);
+	for (uint32 i = 1; i < num_commands; ++i)
+	{
+		const TestCommand& previous = rendered_commands[i - 1];
+		const TestCommand& current = rendered_commands[i];
+
+		ASSERT_LE(previous.key, current.key);
+		if (previous.key == current.key)
+		{
+			ASSERT_LT(previous.id, current.id);
+		}
+	}
+
+	buffer.clear();
+	EXPECT_EQ(buffer.size(), 0);
+	EXPECT_TRUE(buffer.begin() == buffer.end());
+}
+
+TEST(Rendering_RenderCommandBuffer, SortsFloatKeys) {
+
+	using namespace era_engine;
+
+	default_render_command_buffer<float> buffer;
+
+	const float keys[] = { 3.5f, -0.0f, -2.0f, 1e-30f, 0.0f, -1e30f, 100.0f, -3.5f, 2.0f, -1e-30f };
+	for (float key : keys)
+	{
+		buffer.emplace_back<FloatTestPipeline, FloatTestCommand>(key, FloatTestCommand{ key });
+	}
+
+	buffer.sort();
+
+	rendered_float_keys.clear();
+	render_all(buffer);
+
+	ASSERT_EQ(rendered_float_keys.size(), std::size(keys));
+	EXPECT_TRUE(std::is_sorted(rendered_float_keys.begin(), rendered_float_keys.end()));
+	EXPECT_EQ(rendered_float_keys.front(), -1e30f);
+	EXPECT_EQ(rendered_float_keys.back(), 100.0f);
+}
+
+TEST(Rendering_RenderCommandBuffer, UnsortedBufferIteratesInRecordingOrder) {
+
+	using namespace era_engine;
+
+	default_render_command_buffer<uint64> buffer;
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		buffer.emplace_back<TestPipelineA, TestCommand>(100 - i, TestCommand{ 100 - i, i });
+	}
+
+	rendered_commands.clear();
+	render_all(buffer);
+
+	ASSERT_EQ(rendered_commands.size(), 100);
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		EXPECT_EQ(rendered_commands[i].id, i);
+	}
+}
+
+TEST(Rendering_RenderCommandBuffer, ClearRunsDestructors) {
+
+	using namespace era_engine;
+
+	std::atomic<int32> live_commands = 0;
+
+	{
+		default_render_command_buffer<uint64> buffer;
+		for (uint32 i = 0; i < 10; ++i)
+		{
+			buffer.emplace_back<CountedPipeline, CountedCommand>(i, &live_commands);
+		}
+		EXPECT_EQ(live_commands.load(), 10);
+
+		buffer.sort();
+		num_rendered_counted_commands = 0;
+		render_all(buffer);
+		EXPECT_EQ(num_rendered_counted_commands, 10);
+
+		buffer.clear();
+		EXPECT_EQ(live_commands.load(), 0);
+
+		// Destroying the buffer cleans up whatever was recorded since the last clear.
+		buffer.emplace_back<CountedPipeline, CountedCommand>(0, &live_commands);
+		EXPECT_EQ(live_commands.load(), 1);
+	}
+
+	EXPECT_EQ(live_commands.load(), 0);
+}
+
+TEST(Rendering_RenderCommandBuffer, MergesCommandsRecordedOnWorkers) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	default_render_command_buffer<uint64> buffer;
+
+	constexpr uint32 num_commands = 100000;
+	for (uint32 frame = 0; frame < 3; ++frame)
+	{
+		parallel_for(0, num_commands, 256, [&](uint32 begin, uint32 end)
+			{
+				for (uint32 i = begin; i < end; ++i)
+				{
+					// Multiplicative hash, so that keys are scattered over the range and over the threads.
+					const uint64 key = (i * 2654435761ull) & 0xFFFFFFFFull;
+					buffer.emplace_back<TestPipelineA, TestCommand>(key, TestCommand{ key, i });
+				}
+			});
+
+		ASSERT_EQ(buffer.size(), num_commands);
+
+		buffer.sort();
+
+		rendered_commands.clear();
+		render_all(buffer);
+
+		ASSERT_EQ(rendered_commands.size(), num_commands);
+
+		std::vector<bool> seen(num_commands, false);
+		for (uint32 i = 0; i < num_commands; ++i)
+		{
+			const TestCommand& command = rendered_commands[i];
+			ASSERT_LT(command.id, num_commands);
+			EXPECT_FALSE(seen[command.id]);
+			seen[command.id] = true;
+
+			if (i > 0)
+			{
+				ASSERT_LE(rendered_commands[i - 1].key, command.key);
+			}
+		}
+
+		buffer.clear();
+	}
+}
+
+TEST(Rendering_RenderCommandBuffer, EqualKeysKeepPushOrderAcrossWorkers) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	constexpr uint32 num_tasks = 32;
+	constexpr uint32 num_commands_per_task = 64;
+	constexpr uint32 num_commands = num_tasks * num_commands_per_task;
+
+	// Few distinct keys, like the transparent pass which records everything with the same depth key.
+	std::mt19937_64 rng(7);
+	std::vector<uint64> keys(num_commands);
+	for (uint64& key : keys)
+	{
+		key = (rng() % 4) << 40;
+	}
+
+	std::vector<uint32> expected_sorted(num_commands);
+	for (uint32 i = 0; i < num_commands; ++i)
+	{
+		expected_sorted[i] = i;
+	}
+	std::stable_sort(expected_sorted.begin(), expected_sorted.end(), [&keys](uint32 a, uint32 b) { return keys[a] < keys[b]; });
+
+	default_render_command_buffer<uint64> buffer;
+	default_render_command_buffer<uint64> equal_keys_buffer;
+
+	// The same tasks, one after the other, land on whichever worker (or the waiting thread) picks them up.
+	for (uint32 frame = 0; frame < 8; ++frame)
+	{
+		for (uint32 task = 0; task < num_tasks; ++task)
+		{
+			for (default_render_command_buffer<uint64>* target : { &buffer, &equal_keys_buffer })
+			{
+				const uint64* task_keys = (target == &buffer) ? keys.data() : nullptr;
+
+				JobHandle job = high_priority_job_queue.createJob<RecordTestCommandsData>([](RecordTestCommandsData& data, JobHandle)
+					{
+						for (uint32 i = 0; i < data.count; ++i)
+						{
+							const uint32 id = data.first_id + i;
+							const uint64 key = data.keys ? data.keys[id] : 0;
+							data.buffer->emplace_back<TestPipelineA, TestCommand>(key, TestCommand{ key, id });
+						}
+					}, { target, task_keys, task * num_commands_per_task, num_commands_per_task });
+				job.submit_now();
+				job.wait_for_completion();
+			}
+		}
+
+		buffer.sort();
+
+		rendered_commands.clear();
+		render_all(buffer);
+
+		ASSERT_EQ(rendered_commands.size(), num_commands);
+		for (uint32 i = 0; i < num_commands; ++i)
+		{
+			ASSERT_EQ(rendered_commands[i].id, expected_sorted[i]);
+		}
+
+		// All keys equal: iterating without sorting merges, and sort() only merges too.
+		for (bool sort : { false, true })
+		{
+			if (sort)
+			{
+				equal_keys_buffer.sort();
+			}
+
+			rendered_commands.clear();
+			render_all(equal_keys_buffer);
+
+			ASSERT_EQ(rendered_commands.size(), num_commands);
+			for (uint32 i = 0; i < num_commands; ++i)
+			{
+				ASSERT_EQ(rendered_commands[i].id, i);
+			}
+		}
+
+		buffer.clear();
+		equal_keys_buffer.clear();
+	}
+}
@@ -0,0 +1,307 @@
+#include <gtest/gtest.h>
+
+#include <rendering/visibility.h>
+
+#include "unittests/test_utils.h"
+
+#include <random>
+
+namespace
+{
+	using namespace era_engine;
+
+	bounding_box random_box(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position(-500.f, 500.f);
+		std::uniform_real_distribution<float> size(0.1f, 20.f);
+
+		const vec3 center(position(rng), position(rng), position(rng));
+		const vec3 radius(size(rng), size(rng), size(rng));
+		return bounding_box::fromMinMax(center - radius, center + radius);
+	}
+
+	// Six planes around a random point, each facing inwards. Not a real camera frustum, but a convex region that the
+	// culling has to treat the same way.
+	camera_frustum_planes random_frustum(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position(-300.f, 300.f);
+		std::uniform_real_distribution<float> direction(-1.f, 1.f);
+		std::uniform_real_distribution<float> distance(20.f, 400.f);
+
+		const vec3 inside(position(rng), position(rng), position(rng));
+
+		camera_frustum_planes frustum;
+		for (uint32 i = 0; i < 6; ++i)
+		{
+			vec3 normal(direction(rng), direction(rng), direction(rng));
+			normal = normal * (1.f / max(length(normal), 0.01f));
+			frustum.planes[i] = vec4(normal, distance(rng) - dot(normal, inside));
+		}
+		return frustum;
+	}
+
+	// Reference for sphere views: distance from the center to the closest point of the box, in the same order of operations.
+	bool sphere_sees_box(const bounding_sphere& sphere, const bounding_box& aabb)
+	{
+		float distance_sq = 0.f;
+		for (uint32 axis = 0; axis < 3; ++axis)
+		{
+			const float d = max(max(aabb.minCorner.data[axis] - sphere.center.data[axis], sphere.center.data[axis] - aabb.maxCorner.data[axis]), 0.f);
+			distance_sq = distance_sq + d * d;
+		}
+		return !(distance_sq > sphere.radius * sphere.radius);
+	}
+
+	bool view_sees_box(const VisibilityView& view, const bounding_box& aabb)
+	{
+		if (view.is_sphere)
+		{
+			return sphere_sees_box(view.sphere, aabb);
+		}
+
+		camera_frustum_planes frustum;
+		for (uint32 i = 0; i < 6; ++i)
+		{
+			frustum.planes[i] = view.planes[i];
+		}
+		return !frustum.cullWorldSpaceAABB(aabb);
+	}
+
+	void expect_same_as_per_object_culling(const std::vector<bounding_box>& aabbs, const std::vector<VisibilityView>& views, const VisibilityResult& result)
+	{
+		ASSERT_EQ(result.view_offsets.size(), views.size() + 1);
+
+		for (uint32 v = 0; v < (uint32)views.size(); ++v)
+		{
+			std::vector<uint32> expected;
+			for (uint32 i = 0; i < (uint32)aabbs.size(); ++i)
+			{
+				if (view_sees_box(views[v], aabbs[i]))
+				{
+					expected.push_back(i);
+				}
+			}
+
+			const std::vector<uint32> visible(result.get_visible_indices(v), result.get_visible_indices(v) + result.get_num_visible(v));
+			EXPECT_EQ(visible, expected) << "View " << v;
+		}
+	}
+
+	std::vector<VisibilityView> random_views(std::mt19937& rng, uint32 num_frustums, uint32 num_spheres)
+	{
+		std::uniform_real_distribution<float> position(-300.f, 300.f);
+		std::uniform_real_distribution<float> radius(10.f, 150.f);
+
+		std::vector<VisibilityView> views;
+		for (uint32 i = 0; i < num_frustums; ++i)
+		{
+			views.push_back(VisibilityView::from_frustum(random_frustum(rng)));
+		}
+		for (uint32 i = 0; i < num_spheres; ++i)
+		{
+			views.push_back(VisibilityView::from_sphere(bounding_sphere{ vec3(position(rng), position(rng), position(rng)), radius(rng) }));
+		}
+		return views;
+	}
+}
+
+TEST(Rendering_Visibility, MatchesPerObjectCulling) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	std::mt19937 rng(17);
+
+	std::vector<bounding_box> aabbs(20000);
+	for (bounding_box& aabb : aabbs)
+	{
+		aabb = random_box(rng);
+	}
+
+	// Camera, sun cascades, spot lights and point lights.
+	const std::vector<VisibilityView> views = random_views(rng, 12, 6);
+
+	VisibilityBVH bvh;
+	bvh.build(aabbs.data(), (uint32)aabbs.size());
+
+	VisibilityResult result;
+	bvh.cull(views.data(), (uint32)views.size(), result);
+
+	expect_same_as_per_object_culling(aabbs, views, result);
+
+	uint32 num_visible = 0;
+	for (uint32 v = 0; v < (uint32)views.size(); ++v)
+	{
+		num_visible += result.get_num_visible(v);
+	}
+	EXPECT_GT(num_visible, 0u);
+}
+
+TEST(Rendering_Visibility, RefitsAndRebuildsMovedObjects) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	std::mt19937 rng(5);
+
+	std::vector<bounding_box> aabbs(5000);
+	for (bounding_box& aabb : aabbs)
+	{
+		aabb = random_box(rng);
+	}
+
+	const std::vector<VisibilityView> views = random_views(rng, 4, 2);
+
+	VisibilityBVH bvh;
+	bvh.build(aabbs.data(), (uint32)aabbs.size());
+	ASSERT_EQ(bvh.get_num_builds(), 1u);
+
+	VisibilityResult result;
+
+	// Few objects move far: the tree is refit. Repeat until refitting has loosened it enough to be rebuilt.
+	std::uniform_int_distribution<uint32> object(0, (uint32)aabbs.size() - 1);
+	for (uint32 frame = 0; frame < 200 && bvh.get_num_builds() == 1; ++frame)
+	{
+		std::vector<uint32> changed;
+		for (uint32 i = 0; i < 50; ++i)
+		{
+			const uint32 index = object(rng);
+			aabbs[index] = random_box(rng);
+			changed.push_back(index);
+		}
+
+		bvh.update(aabbs.data(), changed.data(), (uint32)changed.size());
+
+		bvh.cull(views.data(), (uint32)views.size(), result);
+		expect_same_as_per_object_culling(aabbs, views, result);
+	}
+	EXPECT_EQ(bvh.get_num_builds(), 2u);
+
+	// Most objects move: the tree is rebuilt right away.
+	std::vector<uint32> all(aabbs.size());
+	for (uint32 i = 0; i < (uint32)aabbs.size(); ++i)
+	{
+		aabbs[i] = random_box(rng);
+		all[i] = i;
+	}
+
+	bvh.update(aabbs.data(), all.data(), (uint32)all.size());
+	EXPECT_EQ(bvh.get_num_builds(), 3u);
+
+	bvh.cull(views.data(), (uint32)views.size(), result);
+	expect_same_as_per_object_culling(aabbs, views, result);
+}
+
+TEST(Rendering_Visibility, EmptyAndUnboundedObjects) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	std::mt19937 rng(3);
+
+	std::vector<bounding_box> aabbs(100);
+	for (bounding_box& aabb : aabbs)
+	{
+		aabb = random_box(rng);
+	}
+	aabbs[10] = bounding_box::negativeInfinity();
+	aabbs[20] = bounding_box::everything();
+
+	const std::vector<VisibilityView> views = random_views(rng, 3, 3);
+
+	VisibilityBVH bvh;
+	bvh.build(aabbs.data(), (uint32)aabbs.size());
+
+	VisibilityResult result;
+	bvh.cull(views.data(), (uint32)views.size(), result);
+
+	for (uint32 v = 0; v < (uint32)views.size(); ++v)
+	{
+		const uint32* begin = result.get_visible_indices(v);
+		const uint32* end = begin + result.get_num_visible(v);
+		EXPECT_EQ(std::find(begin, end, 10u), end);
+		EXPECT_NE(std::find(begin, end, 20u), end);
+	}
+
+	// Hiding and showing objects is an update like any other.
+	std::swap(aabbs[10], aabbs[20]);
+	const uint32 changed[] = { 10, 20 };
+	bvh.update(aabbs.data(), changed, 2);
+
+	bvh.cull(views.data(), (uint32)views.size(), result);
+	expect_same_as_per_object_culling(aabbs, views, result);
+
+	// No objects.
+	bvh.build(nullptr, 0);
+	bvh.cull(views.data(), (uint32)views.size(), result);
+	for (uint32 v = 0; v < (uint32)views.size(); ++v)
+	{
+		EXPECT_EQ(result.get_num_visible(v), 0u);
+	}
+}
+
+TEST(Rendering_Visibility, EmptyObjectsDoNotLoosenBounds) {
+
+	using namespace era_engine;
+
+	unittests::initialize_test_workers();
+
+	std::mt19937 rng(4);
+
+	// Enough objects for several levels, every fifth one hidden.
+	std::vector<bounding_box> aabbs(1000);
+	for (uint32 i = 0; i < (uint32)aabbs.size(); ++i)
+	{
+		aabbs[i] = (i % 5 == 0) ? bounding_box::negativeInfinity() : random_box(rng);
+	}
+
+	auto get_expected_bounds = [&aabbs]()
+	{
+		bounding_box result = bounding_box::negativeInfinity();
+		for (const bounding_box& aabb : aabbs)
+		{
+			if (aabb.minCorner.x <= aabb.maxCorner.x)
+			{
+				result.grow(aabb.minCorner);
+				result.grow(aabb.maxCorner);
+			}
+		}
+		return result;
+	};
+
+	auto expect_bounds = [](const bounding_box& actual, const bounding_box& expected)
+	{
+		EXPECT_EQ(actual.minCorner.x, expected.minCorner.x);
+		EXPECT_EQ(actual.minCorner.y, expected.minCorner.y);
+		EXPECT_EQ(actual.minCorner.z, expected.minCorner.z);
+		EXPECT_EQ(actual.maxCorner.x, expected.maxCorner.x);
+		EXPECT_EQ(actual.maxCorner.y, expected.maxCorner.y);
+		EXPECT_EQ(actual.maxCorner.z, expected.maxCorner.z);
+	};
+
+	VisibilityBVH bvh;
+	bvh.build(aabbs.data(), (uint32)aabbs.size());
+	ASSERT_GT(bvh.get_num_nodes(), 1u);
+	expect_bounds(bvh.get_bounds(), get_expected_bounds());
+
+	// Hiding objects through a refit keeps the ancestors tight as well.
+	std::vector<uint32> changed;
+	for (uint32 i = 1; i < (uint32)aabbs.size(); i += 7)
+	{
+		aabbs[i] = bounding_box::negativeInfinity();
+		changed.push_back(i);
+	}
+	const uint32 num_builds = bvh.get_num_builds();
+	bvh.update(aabbs.data(), changed.data(), (uint32)changed.size());
+	EXPECT_EQ(bvh.get_num_builds(), num_builds);
+	expect_bounds(bvh.get_bounds(), get_expected_bounds());
+
+	// Only hidden objects: nothing to bound.
+	std::vector<bounding_box> hidden(20, bounding_box::negativeInfinity());
+	bvh.build(hidden.data(), (uint32)hidden.size());
+	const bounding_box bounds = bvh.get_bounds();
+	EXPECT_GT(bounds.minCorner.x, bounds.maxCorner.x);
+}
@@ -0,0 +1,18 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include <core/job_system.h>
+
+namespace era_engine::unittests
+{
+	// Starts the workers of the high priority queue the first time a test needs them. Without workers, parallel_for and jobs
+	// run inline on the calling thread, which would leave the parallel paths untested.
+	inline void initialize_test_workers()
+	{
+		if (high_priority_job_queue.get_num_threads() == 0)
+		{
+			high_priority_job_queue.initialize(3, 1, ThreadPriority::Normal, L"Unit test worker", JobQueueMode::WorkStealing);
+		}
+	}
+}
@@ -1,18 +1,26 @@
 set(CMAKE_CXX_STANDARD 20)
 set(CMAKE_MODULE_PATH ${CMAKE_CURRENT_SOURCE_DIR}/cmake)
 
-set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} /MP /arch:AVX2 /Zi /Gy /GF /EHsc")
-
-set(ENGINE_DEFAULT_LIBS
-d3d12.lib
-uxtheme.lib
-D3Dcompiler.lib
-DXGI.lib
-dxguid.lib
-dxcompiler.lib
-XAudio2.lib
-Ws2_32.lib
-)
+option(ERA_ENABLE_CPU_PROFILING "Build the built-in CPU profiler (profiler window and trace captures)" OFF)
+
+if(MSVC)
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} /MP /arch:AVX2 /Zi /Gy /GF /EHsc")
+else()
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -mavx2 -mfma -g")
+endif()
+
+if(WIN32)
+    set(ENGINE_DEFAULT_LIBS
+    d3d12.lib
+    uxtheme.lib
+    D3Dcompiler.lib
+    DXGI.lib
+    dxguid.lib
+    dxcompiler.lib
+    XAudio2.lib
+    Ws2_32.lib
+    )
+endif()
 
 function(assign_source_group)
     foreach(_source IN ITEMS ${ARGN})
@@ -31,7 +39,7 @@ function(era_default_linkage name)
     target_compile_definitions(${name} PRIVATE _UNICODE
         UNICODE
         _CRT_SECURE_NO_WARNINGS
-        ENABLE_CPU_PROFILING=0
+        ENABLE_CPU_PROFILING=$<BOOL:${ERA_ENABLE_CPU_PROFILING}>
         ENABLE_MESSAGE_LOG=1
         ENGINE_PATH=L"${ERA_ENGINE_PATH}"
         SHADER_BIN_DIR=L"${ERA_ENGINE_PATH}/modules/shaders/bin/Release/"
@@ -59,7 +67,9 @@ function(era_default_linkage name)
 
     assign_source_group(${SOURCES_${name}} ${HEADERS_${name}})
 
-    target_compile_options(${name} PRIVATE /wd4305 /wd4244 /wd4267 /wd4099 /wd4005 /wd4804 /wd4312)
+    if(MSVC)
+        target_compile_options(${name} PRIVATE /wd4305 /wd4244 /wd4267 /wd4099 /wd4005 /wd4804 /wd4312)
+    endif()
 endfunction()
 
 function(declare_module name)
@@ -111,7 +121,11 @@ function(era_begin name target_type)
         message("Failed to create target with ${target_type} type!")
     endif()
 
-    add_definitions(/FI"${ERA_ENGINE_PATH}/resources/common/era_common.h")
+    if(MSVC)
+        add_definitions(/FI"${ERA_ENGINE_PATH}/resources/common/era_common.h")
+    else()
+        add_definitions(-include "${ERA_ENGINE_PATH}/resources/common/era_common.h")
+    endif()
 endfunction()
 
 function(require_module target module)
@@ -140,6 +154,29 @@ function(require_thirdparty_module target module)
     set_property(TARGET ${target} APPEND PROPERTY DEPENDENCIES ${module})
 endfunction()
 
+# Modules the target needs at runtime: its own dependencies and, recursively, theirs. A module that is only used
+# through another module does not have to be linked, but its binary still has to sit next to the executable.
+function(era_collect_runtime_dependencies name out_var)
+    get_property(pending TARGET ${name} PROPERTY DEPENDENCIES)
+    set(result "")
+
+    while(pending)
+        list(GET pending 0 dependency)
+        list(REMOVE_AT pending 0)
+        if(NOT dependency IN_LIST result)
+            list(APPEND result ${dependency})
+
+            get_property(dependency_type TARGET ${dependency} PROPERTY TARGET_TYPE)
+            if(dependency_type STREQUAL "MODULE")
+                get_property(module_dependencies TARGET ${dependency} PROPERTY DEPENDENCIES)
+                list(APPEND pending ${module_dependencies})
+            endif()
+        endif()
+    endwhile()
+
+    set(${out_var} ${result} PARENT_SCOPE)
+endfunction()
+
 function(era_end name)
     get_property(target_type TARGET ${name} PROPERTY TARGET_TYPE)
     message("-- End processing target ${name} with type: ${target_type}.")
@@ -168,7 +205,8 @@ function(era_end name)
     target_link_libraries(${name} ${target_dependencies})
     message("${name} deps: ${target_dependencies}")
 
-    foreach(dependency ${target_dependencies})
+    era_collect_runtime_dependencies(${name} runtime_dependencies)
+    foreach(dependency ${runtime_dependencies})
         get_property(dependency_type TARGET ${dependency} PROPERTY TARGET_TYPE)
         if(dependency_type STREQUAL "MODULE")
             set(DEP_BUILD_PATH ${ERA_ENGINE_PATH}/_build/modules/${dependency}/$<CONFIGURATION>/${dependency}.dll)
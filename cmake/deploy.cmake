@@ -2,10 +2,9 @@ function(era_add_deploy_target app)
     set(deploy_target_name deploy_modules_to_${app})
     add_custom_target(${deploy_target_name} ALL)
 
-    get_property(target_dependencies TARGET ${app} PROPERTY DEPENDENCIES)
-    list(REMOVE_DUPLICATES target_dependencies)
+    era_collect_runtime_dependencies(${app} runtime_dependencies)
 
-    foreach(dependency ${target_dependencies})
+    foreach(dependency ${runtime_dependencies})
         get_property(dependency_type TARGET ${dependency} PROPERTY TARGET_TYPE)
         if(dependency_type STREQUAL "MODULE")
             add_custom_command(TARGET ${deploy_target_name} POST_BUILD
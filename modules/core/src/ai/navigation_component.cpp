@@ -42,7 +42,7 @@ namespace era_engine::ai
 		using namespace rttr;
 		rttr::registration::class_<NavigationComponent>("NavigationComponent")
 			.constructor<>()
-			.constructor<ref<Entity::EcsData>, NavigationComponent::NavType>()
+			.constructor<Entity::EcsData*, NavigationComponent::NavType>()
 			.property("destination", &NavigationComponent::destination)
 			.property("type", &NavigationComponent::type);
 	}
@@ -85,7 +85,7 @@ namespace era_engine::ai
 		nav_coroutine = navigate(vec2((unsigned int)from.x, (unsigned int)from.z), vec2((unsigned int)to.x, (unsigned int)to.z));
 	}
 
-	NavigationComponent::NavigationComponent(ref<Entity::EcsData> _data, NavType _type)
+	NavigationComponent::NavigationComponent(Entity::EcsData* _data, NavType _type)
 		: Component(_data), type(_type)
 	{
 	}
@@ -27,7 +27,7 @@ namespace era_engine::ai
 		};
 
 		NavigationComponent() = default;
-		NavigationComponent(ref<Entity::EcsData> _data, NavType _type);
+		NavigationComponent(Entity::EcsData* _data, NavType _type);
 		virtual ~NavigationComponent();
 
 		void process_path();
@@ -11,6 +11,7 @@
 
 #include "ai/state_machine.h"
 
+#include "animation/animation_pose_sampler.h"
 #include "animation/skeleton.h"
 #include "animation/skeleton_component.h"
 
@@ -192,7 +193,7 @@ namespace era_engine::animation
 	class ERA_CORE_API AnimationComponent : public Component
 	{
 	public:
-		AnimationComponent(ref<Entity::EcsData> _data);
+		AnimationComponent(Entity::EcsData* _data);
 		~AnimationComponent() override;
 
 		ERA_VIRTUAL_REFLECT(Component)
@@ -207,6 +208,9 @@ namespace era_engine::animation
 		bool update_skeleton = true;
 		bool loop = false;
 
+		// Re-initialized whenever the clip or the skeleton changes, so its joint mapping and decompression state carry over between frames.
+		AnimationPoseSampler sampler;
+
 		// Render data
 		dx_vertex_buffer_group_view current_vertex_buffer;
 		dx_vertex_buffer_group_view prev_frame_vertex_buffer;
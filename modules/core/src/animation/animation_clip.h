@@ -4,6 +4,7 @@
 
 #include "asset/game_asset.h"
 
+#include <acl/compression/compression_level.h>
 #include <acl/compression/track_array.h>
 #include <acl/core/compressed_tracks.h>
 #include <acl/decompression/decompress.h>
@@ -20,6 +21,36 @@ namespace era_engine::animation
 		AnimationAllocator() = default;
 	};
 
+	// A zero threshold keeps the per-track value the raw clip was built with (see TrackInfo and CurveInfo).
+	struct ERA_CORE_API AnimationCompressionSettings final
+	{
+		acl::compression_level8 level = acl::compression_level8::automatic;
+
+		// Maximum joint error, measured on a virtual vertex 'joint_shell_distance' away from the joint.
+		float joint_precision = 0.0f;
+		float joint_shell_distance = 0.0f;
+
+		float curve_precision = 0.0f;
+	};
+
+	// Decompression state for one playing instance of a compressed clip. Keep it alive and reuse it every frame,
+	// it is only re-bound when the sampled clip changes. Copies start unbound.
+	class ERA_CORE_API AnimationClipSamplingContext final
+	{
+	public:
+		AnimationClipSamplingContext() = default;
+		AnimationClipSamplingContext(const AnimationClipSamplingContext& other);
+		AnimationClipSamplingContext& operator=(const AnimationClipSamplingContext& other);
+
+		void reset();
+
+	private:
+		acl::decompression_context<acl::default_transform_decompression_settings> joints;
+		acl::decompression_context<acl::default_scalar_decompression_settings> curves;
+
+		friend class AnimationAssetClip;
+	};
+
 	class ERA_CORE_API AnimationAssetClip final : public GameAsset
 	{
 	public:
@@ -32,12 +63,20 @@ namespace era_engine::animation
 
 		bool is_valid() const;
 
+		// Replaces the raw tracks with their ACL compressed form. Serialized clips are always stored compressed.
+		bool compress(const AnimationCompressionSettings& settings = {});
+		bool is_compressed() const;
+
+		// Bytes held by the joint and curve tracks, raw or compressed.
+		size_t get_memory_footprint() const;
+
 		float get_duration() const;
 
 		bool sample_joint(float sample_time, std::string_view joint_name, const JointTransform& bind_transform, JointTransform& out_transform) const;
 		bool sample_joint(float sample_time, uint32 joint_index, const JointTransform& bind_transform, JointTransform& out_transform) const;
 		bool sample_joints(float sample_time, SkeletonPose& out_pose) const;
 		bool sample_joints(float sample_time, const SkeletonPose& default_pose, SkeletonPose& out_pose, const std::vector<uint32>& custom_joint_name_mapping) const;
+		bool sample_joints(AnimationClipSamplingContext& context, float sample_time, SkeletonPose& out_pose, const std::vector<uint32>& custom_joint_name_mapping) const;
 
 		float get_sample_rate() const;
 		uint32 get_num_samples_per_track() const;
@@ -45,6 +84,7 @@ namespace era_engine::animation
 		bool sample_curve(float sample_time, std::string_view curve_name, float& out_curve_value) const;
 		void sample_curve(float sample_time, uint32 curve_index, float& out_curve_value) const;
 		void sample_curves(float sample_time, std::vector<float>& out_curve_values) const;
+		void sample_curves(AnimationClipSamplingContext& context, float sample_time, std::vector<float>& out_curve_values) const;
 
 		void add_curve(const std::string& name, const std::vector<float>& values);
 		void remove_curve(const std::string& name);
@@ -58,12 +98,20 @@ namespace era_engine::animation
 		bool deserialize(std::istream& is) override;
 
 	private:
+		void release_compressed_tracks();
+
 		std::unordered_map<std::string, uint32> joint_name_mapping;
 		std::unordered_map<std::string, uint32> curve_name_mapping;
 
 		acl::track_array_qvvf joints;
 		acl::track_array_float1f curves;
 
+		// Owned, allocated from 'allocator'. When set, the matching raw track array is empty.
+		acl::compressed_tracks* compressed_joints = nullptr;
+		acl::compressed_tracks* compressed_curves = nullptr;
+
+		AnimationCompressionSettings compression_settings;
+
 		std::unique_ptr<AnimationAllocator> allocator;
 
 		friend class AnimationAssetClipUtils;
@@ -5,6 +5,8 @@
 #include "animation/animation_clip.h"
 #include "animation/skeleton.h"
 
+#include <mutex>
+
 namespace era_engine::animation
 {
 	class ERA_CORE_API AnimationPoseSampler final
@@ -13,6 +15,9 @@ namespace era_engine::animation
 		AnimationPoseSampler() = default;
 
 		void init(const Skeleton* _skeleton, std::shared_ptr<AnimationAssetClip> _animation);
+
+		// Skips the name lookups, '_joint_mapping' has to come from build_joint_mapping (or JointMappingCache) for this pair.
+		void init(const Skeleton* _skeleton, std::shared_ptr<AnimationAssetClip> _animation, const std::vector<uint32>& _joint_mapping);
 		void reset();
 
 		bool is_valid() const;
@@ -21,16 +26,58 @@ namespace era_engine::animation
 		std::shared_ptr<AnimationAssetClip> get_animation() const;
 		const Skeleton* get_skeleton() const;
 
-		bool sample_pose(float sample_time, SkeletonPose& target) const;
+		// Reuses the decompression context across calls, keep the sampler alive while the clip plays.
+		bool sample_pose(float sample_time, SkeletonPose& target);
 
-		void sample_curves(float sample_time, std::vector<float>& target) const;
+		void sample_curves(float sample_time, std::vector<float>& target);
 
 		void set_joint_enabled(const std::string& joint_name, bool enabled);
 
+		// Clip track index -> skeleton joint index, INVALID_JOINT for tracks the skeleton doesn't have.
+		static void build_joint_mapping(const Skeleton* skeleton, const AnimationAssetClip* animation, std::vector<uint32>& out_joint_mapping);
+
 	private:
 		const Skeleton* skeleton = nullptr;
 		std::shared_ptr<AnimationAssetClip> animation;
 
 		std::vector<uint32> joint_mapping;
+
+		AnimationClipSamplingContext sampling_context;
+	};
+
+	// Joint mappings only depend on joint and track names, so they are built once per (skeleton, clip) pair and shared
+	// by every sampler that plays the clip on that skeleton. Entries don't keep their assets alive. Thread safe.
+	class ERA_CORE_API JointMappingCache final
+	{
+	public:
+		JointMappingCache() = default;
+		JointMappingCache(const JointMappingCache&) = delete;
+		JointMappingCache& operator=(const JointMappingCache&) = delete;
+
+		ref<const std::vector<uint32>> get_joint_mapping(const ref<Skeleton>& skeleton, const ref<AnimationAssetClip>& animation);
+
+		void clear();
+		uint32 size() const;
+
+	private:
+		using Key = std::pair<const Skeleton*, const AnimationAssetClip*>;
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		struct Entry
+		{
+			weakref<Skeleton> skeleton;
+			weakref<AnimationAssetClip> animation;
+			ref<const std::vector<uint32>> joint_mapping;
+		};
+
+		void remove_expired_entries();
+
+		mutable std::mutex mutex;
+		std::unordered_map<Key, Entry, KeyHash> entries;
+		size_t next_cleanup_size = 64;
 	};
-}
\ No newline at end of file
+}
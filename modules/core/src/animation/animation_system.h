@@ -4,12 +4,17 @@
 
 namespace era_engine
 {
-	struct Allocator;
-	class RendererHolderRootComponent;
+	class MeshComponent;
 }
 
 namespace era_engine::animation
 {
+	class AnimationComponent;
+	class SkeletonComponent;
+	class JointMappingCache;
+
+	// Samples animations and updates skeletons. Skinning is only done in worlds with the "render" tag, other worlds
+	// (headless runtime, dedicated server) just get the global joint transforms.
 	class AnimationSystem final : public System
 	{
 	public:
@@ -21,7 +26,20 @@ namespace era_engine::animation
 
 		ERA_VIRTUAL_REFLECT(System)
 	private:
-		ref<Allocator> allocator = nullptr;
-		RendererHolderRootComponent* renderer_holder_rc = nullptr;
+		struct AnimatedEntity
+		{
+			AnimationComponent* animation_component = nullptr;
+			const MeshComponent* mesh_component = nullptr; // Null when not skinning.
+			const SkeletonComponent* skeleton_component = nullptr;
+			uint32 order = 0;
+		};
+
+		void update_entity(const AnimatedEntity& entity, float dt);
+
+		ref<JointMappingCache> joint_mapping_cache = nullptr;
+
+		// Reused between frames. Entities sharing a skeleton are adjacent and form one run, which is updated by one worker.
+		std::vector<AnimatedEntity> animated_entities;
+		std::vector<uint32> run_offsets;
 	};
 }
\ No newline at end of file
@@ -525,10 +525,10 @@ namespace era_engine::animation
 	{
 		using namespace rttr;
 		registration::class_<AnimationComponent>("AnimationComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	AnimationComponent::AnimationComponent(ref<Entity::EcsData> _data)
+	AnimationComponent::AnimationComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
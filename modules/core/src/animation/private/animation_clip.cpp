@@ -7,17 +7,17 @@
 #include "core/serialization/binary_serializer.h"
 #include "core/log.h"
 
+#include <acl/compression/compress.h>
+#include <acl/compression/convert.h>
+#include <acl/compression/transform_error_metrics.h>
 #include <acl/io/clip_reader.h>
-#include <acl/io/clip_writer.h>
 
 #include <rtm/math.h>
 #include <rtm/quatf.h>
 #include <rtm/scalarf.h>
 #include <rtm/vector4f.h>
 
-#include <sjson/writer.h>
-
-#include <sstream>
+#include <type_traits>
 
 namespace era_engine::animation
 {
@@ -82,56 +82,16 @@ namespace era_engine::animation
         return { quat_to_quatf(t.rotation), vec3_to_vector4f(t.position), vec3_to_vector4f(t.scale) };
     }
 
-    class StringStream : public sjson::StreamWriter
-    {
-    public:
-        void write(const void* buffer, size_t buffer_size) override
-        {
-            ss.write(reinterpret_cast<const char*>(buffer), buffer_size);
-        }
-
-        std::stringstream ss;
-    };
-
     namespace acl_animation_clip_details
     {
+        // Sub-tracks ACL stripped as default are written through the base class defaults (identity, unit scale),
+        // which is what raw tracks are authored against.
         class JointTransformSamplingWriter : public acl::track_writer
         {
         public:
-            JointTransformSamplingWriter(const JointTransform& _bind_transform, JointTransform& _joint_transform)
-                : bind_transform(_bind_transform)
-                , joint_transform(_joint_transform)
-            {
-            }
-
-            static constexpr acl::default_sub_track_mode get_default_rotation_mode()
-            {
-                return acl::default_sub_track_mode::constant;
-            }
-
-            static constexpr acl::default_sub_track_mode get_default_translation_mode()
-            {
-                return acl::default_sub_track_mode::constant;
-            }
-
-            static constexpr acl::default_sub_track_mode get_default_scale_mode()
-            {
-                return acl::default_sub_track_mode::constant;
-            }
-
-            rtm::quatf RTM_SIMD_CALL get_constant_default_rotation() const
+            JointTransformSamplingWriter(JointTransform& _joint_transform)
+                : joint_transform(_joint_transform)
             {
-                return quat_to_quatf(bind_transform.get_rotation());
-            }
-
-            rtm::vector4f RTM_SIMD_CALL get_constant_default_translation() const
-            {
-                return vec3_to_vector4f(bind_transform.get_translation());
-            }
-
-            rtm::vector4f RTM_SIMD_CALL get_constant_default_scale() const
-            {
-                return vec3_to_vector4f(vec3(bind_transform.get_scale()));
             }
 
             void RTM_SIMD_CALL write_rotation(uint32_t track_index, rtm::quatf_arg0 rotation)
@@ -152,73 +112,33 @@ namespace era_engine::animation
             }
 
         private:
-            const JointTransform& bind_transform;
             JointTransform& joint_transform;
         };
 
         class PoseSamplingWriter : public acl::track_writer
         {
         public:
-            PoseSamplingWriter(const SkeletonPose& _bind_pose, SkeletonPose& _pose, const std::vector<uint32>& _mapping, const std::vector<uint32>& _mapping2 = empty_mapping)
+            PoseSamplingWriter(SkeletonPose& _pose, const std::vector<uint32>& _mapping)
                 : acl::track_writer()
-                , bind_pose(_bind_pose)
                 , pose(_pose)
                 , mapping(_mapping)
-                , support_mapping(_mapping2)
-            {
-            }
-
-            static const std::vector<uint32> empty_mapping;
-
-            static constexpr acl::default_sub_track_mode get_default_rotation_mode()
-            {
-                return acl::default_sub_track_mode::variable;
-            }
-
-            static constexpr acl::default_sub_track_mode get_default_translation_mode()
             {
-                return acl::default_sub_track_mode::variable;
             }
 
-            static constexpr acl::default_sub_track_mode get_default_scale_mode()
+            // Lets the compressed path skip decoding tracks that have no joint to write to.
+            bool skip_track_rotation(uint32_t track_index) const
             {
-                return acl::default_sub_track_mode::variable;
-            }
-
-            rtm::quatf RTM_SIMD_CALL get_variable_default_rotation(uint32_t track_index) const
-            {
-                uint32 joint_index = map_track_to_joint(track_index);
-                if (joint_index == INVALID_JOINT)
-                {
-                    return rtm::quatf();
-                }
-
-                ASSERT(joint_index < bind_pose.size());
-                return quat_to_quatf(bind_pose.get_joint_transform(joint_index).get_rotation());
+                return map_track_to_joint(track_index) == INVALID_JOINT;
             }
 
-            rtm::vector4f RTM_SIMD_CALL get_variable_default_translation(uint32_t track_index) const
+            bool skip_track_translation(uint32_t track_index) const
             {
-                uint32 joint_index = map_track_to_joint(track_index);
-                if (joint_index == INVALID_JOINT)
-                {
-                    return rtm::vector4f();
-                }
-
-                ASSERT(joint_index < bind_pose.size());
-                return vec3_to_vector4f(bind_pose.get_joint_transform(joint_index).get_translation());
+                return map_track_to_joint(track_index) == INVALID_JOINT;
             }
 
-            rtm::vector4f RTM_SIMD_CALL get_variable_default_scale(uint32_t track_index) const
+            bool skip_track_scale(uint32_t track_index) const
             {
-                uint32 joint_index = map_track_to_joint(track_index);
-                if (joint_index == INVALID_JOINT)
-                {
-                    return rtm::vector4f();
-                }
-
-                ASSERT(joint_index < bind_pose.size());
-                return vec3_to_vector4f(vec3(bind_pose.get_joint_transform(joint_index).get_scale()));
+                return map_track_to_joint(track_index) == INVALID_JOINT;
             }
 
             void RTM_SIMD_CALL write_rotation(uint32_t track_index, rtm::quatf_arg0 rotation)
@@ -262,30 +182,19 @@ namespace era_engine::animation
         private:
             uint32 map_track_to_joint(uint32 track_index) const
             {
-                auto remaped_track_index = track_index;
-                if (remaped_track_index < support_mapping.size())
+                if (track_index < mapping.size())
                 {
-                    remaped_track_index = support_mapping[remaped_track_index];
+                    return mapping[track_index];
                 }
 
-                if (remaped_track_index < mapping.size())
-                {
-                    return mapping[remaped_track_index];
-                }
-
-                return remaped_track_index;
+                return track_index;
             }
 
-            const SkeletonPose& bind_pose;
-
             SkeletonPose& pose;
 
             const std::vector<uint32>& mapping;
-            const std::vector<uint32>& support_mapping;
         };
 
-        const std::vector<uint32> PoseSamplingWriter::empty_mapping;
-
         class CurveSamplingWriter : public acl::track_writer
         {
         public:
@@ -319,6 +228,148 @@ namespace era_engine::animation
         private:
             std::vector<float>& values;
         };
+
+        // Thresholds are overridden on references to the raw samples, so the clip itself is left untouched.
+        template <typename TrackArray_>
+        static acl::compressed_tracks* compress_track_array(acl::iallocator& allocator, const TrackArray_& raw_tracks,
+            const acl::compression_settings& acl_settings, float precision, float shell_distance)
+        {
+            if (raw_tracks.is_empty())
+            {
+                return nullptr;
+            }
+
+            TrackArray_ tracks(allocator, raw_tracks.get_num_tracks());
+            for (uint32 track_index = 0; track_index < raw_tracks.get_num_tracks(); ++track_index)
+            {
+                tracks[track_index] = raw_tracks[track_index].get_ref();
+
+                auto& description = tracks[track_index].get_description();
+                if (precision > 0.0f)
+                {
+                    description.precision = precision;
+                }
+                if constexpr (std::is_same_v<TrackArray_, acl::track_array_qvvf>)
+                {
+                    if (shell_distance > 0.0f)
+                    {
+                        description.shell_distance = shell_distance;
+                    }
+                }
+            }
+
+            acl::output_stats stats;
+            acl::compressed_tracks* result = nullptr;
+
+            const acl::error_result error = acl::compress_track_list(allocator, tracks, acl_settings, result, stats);
+            if (error.any())
+            {
+                LOG_ERROR("Animation> Failed to compress clip tracks: %s", error.c_str());
+                return nullptr;
+            }
+
+            return result;
+        }
+
+        static acl::compressed_tracks* compress_joints(acl::iallocator& allocator, const acl::track_array_qvvf& joints, const AnimationCompressionSettings& settings)
+        {
+            static acl::qvvf_transform_error_metric error_metric;
+
+            acl::compression_settings acl_settings = acl::get_default_compression_settings();
+            acl_settings.level = settings.level;
+            acl_settings.error_metric = &error_metric;
+
+            return compress_track_array(allocator, joints, acl_settings, settings.joint_precision, settings.joint_shell_distance);
+        }
+
+        static acl::compressed_tracks* compress_curves(acl::iallocator& allocator, const acl::track_array_float1f& curves, const AnimationCompressionSettings& settings)
+        {
+            acl::compression_settings acl_settings = acl::get_default_compression_settings();
+
+            // Kept so add_curve() and remove_curve() can convert compressed curves back to raw ones.
+            acl_settings.metadata.include_track_descriptions = true;
+
+            return compress_track_array(allocator, curves, acl_settings, settings.curve_precision, 0.0f);
+        }
+
+        static void free_compressed_tracks(acl::iallocator& allocator, acl::compressed_tracks*& tracks)
+        {
+            if (tracks != nullptr)
+            {
+                allocator.deallocate(tracks, tracks->get_size());
+                tracks = nullptr;
+            }
+        }
+
+        // Copies a serialized buffer into properly aligned memory and validates it, including its hash.
+        static bool load_compressed_tracks(acl::iallocator& allocator, const BinaryData& data, acl::track_type8 expected_type, acl::compressed_tracks*& out_tracks)
+        {
+            out_tracks = nullptr;
+
+            if (data.size() == 0)
+            {
+                return true;
+            }
+
+            if (data.size() < sizeof(acl::compressed_tracks) + sizeof(acl::acl_impl::tracks_header))
+            {
+                return false;
+            }
+
+            void* buffer = allocator.allocate(data.size(), alignof(acl::compressed_tracks));
+            std::memcpy(buffer, data.data(), data.size());
+
+            acl::compressed_tracks* tracks = static_cast<acl::compressed_tracks*>(buffer);
+            if (tracks->get_size() != data.size() ||
+                tracks->is_valid(true).any() ||
+                tracks->get_track_type() != expected_type)
+            {
+                allocator.deallocate(buffer, data.size());
+                return false;
+            }
+
+            out_tracks = tracks;
+            return true;
+        }
+
+        static BinaryData get_compressed_data(const acl::compressed_tracks* tracks)
+        {
+            if (tracks == nullptr)
+            {
+                return BinaryData();
+            }
+            return BinaryData(reinterpret_cast<const uint8*>(tracks), tracks->get_size());
+        }
+
+        static bool convert_curves_to_raw(acl::iallocator& allocator, const acl::compressed_tracks& compressed_curves, acl::track_array_float1f& out_curves)
+        {
+            acl::track_array raw_curves;
+            const acl::error_result error = acl::convert_track_list(allocator, compressed_curves, raw_curves);
+            if (error.any())
+            {
+                LOG_ERROR("Animation> Failed to decompress clip curves: %s", error.c_str());
+                return false;
+            }
+
+            out_curves = std::move(*acl::track_array_cast<acl::track_array_float1f>(&raw_curves));
+            return true;
+        }
+    }
+
+    AnimationClipSamplingContext::AnimationClipSamplingContext(const AnimationClipSamplingContext& other)
+    {
+    }
+
+    AnimationClipSamplingContext& AnimationClipSamplingContext::operator=(const AnimationClipSamplingContext& other)
+    {
+        reset();
+        return *this;
+    }
+
+    void AnimationClipSamplingContext::reset()
+    {
+        joints.reset();
+        curves.reset();
     }
 
 	AnimationAssetClip::AnimationAssetClip()
@@ -331,6 +382,9 @@ namespace era_engine::animation
 	AnimationAssetClip::AnimationAssetClip(AnimationAssetClip&& other) noexcept
         : joint_name_mapping(std::move(other.joint_name_mapping))
         , curve_name_mapping(std::move(other.curve_name_mapping))
+        , compressed_joints(std::exchange(other.compressed_joints, nullptr))
+        , compressed_curves(std::exchange(other.compressed_curves, nullptr))
+        , compression_settings(other.compression_settings)
         , allocator(std::move(other.allocator))
 	{
         joints = std::move(other.joints);
@@ -341,8 +395,13 @@ namespace era_engine::animation
 	{
         if (this != &other)
         {
+            release_compressed_tracks();
+
             joints = std::move(other.joints);
             curves = std::move(other.curves);
+            compressed_joints = std::exchange(other.compressed_joints, nullptr);
+            compressed_curves = std::exchange(other.compressed_curves, nullptr);
+            compression_settings = other.compression_settings;
             joint_name_mapping = std::move(other.joint_name_mapping);
             curve_name_mapping = std::move(other.curve_name_mapping);
             allocator = std::move(other.allocator);
@@ -352,17 +411,99 @@ namespace era_engine::animation
 
 	AnimationAssetClip::~AnimationAssetClip()
 	{
+        release_compressed_tracks();
         joints = acl::track_array_qvvf();
         curves = acl::track_array_float1f();
 	}
 
+    void AnimationAssetClip::release_compressed_tracks()
+    {
+        if (allocator != nullptr)
+        {
+            acl_animation_clip_details::free_compressed_tracks(*allocator, compressed_joints);
+            acl_animation_clip_details::free_compressed_tracks(*allocator, compressed_curves);
+        }
+    }
+
 	bool AnimationAssetClip::is_valid() const
 	{
 		return true;
 	}
 
+    bool AnimationAssetClip::compress(const AnimationCompressionSettings& settings)
+    {
+        acl::compressed_tracks* new_joints = nullptr;
+        acl::compressed_tracks* new_curves = nullptr;
+
+        if (compressed_joints == nullptr && !joints.is_empty())
+        {
+            new_joints = acl_animation_clip_details::compress_joints(*allocator, joints, settings);
+        }
+        if (compressed_curves == nullptr && !curves.is_empty())
+        {
+            new_curves = acl_animation_clip_details::compress_curves(*allocator, curves, settings);
+        }
+
+        if ((new_joints == nullptr && !joints.is_empty()) ||
+            (new_curves == nullptr && !curves.is_empty()))
+        {
+            acl_animation_clip_details::free_compressed_tracks(*allocator, new_joints);
+            acl_animation_clip_details::free_compressed_tracks(*allocator, new_curves);
+            return false;
+        }
+
+        compression_settings = settings;
+
+        if (new_joints != nullptr)
+        {
+            compressed_joints = new_joints;
+            joints = acl::track_array_qvvf();
+        }
+        if (new_curves != nullptr)
+        {
+            compressed_curves = new_curves;
+            curves = acl::track_array_float1f();
+        }
+
+        return true;
+    }
+
+    bool AnimationAssetClip::is_compressed() const
+    {
+        return compressed_joints != nullptr || compressed_curves != nullptr;
+    }
+
+    size_t AnimationAssetClip::get_memory_footprint() const
+    {
+        size_t result = 0;
+
+        if (compressed_joints != nullptr)
+        {
+            result += compressed_joints->get_size();
+        }
+        else
+        {
+            result += size_t(joints.get_num_tracks()) * joints.get_num_samples_per_track() * sizeof(rtm::qvvf);
+        }
+
+        if (compressed_curves != nullptr)
+        {
+            result += compressed_curves->get_size();
+        }
+        else
+        {
+            result += size_t(curves.get_num_tracks()) * curves.get_num_samples_per_track() * sizeof(float);
+        }
+
+        return result;
+    }
+
 	float AnimationAssetClip::get_duration() const
 	{
+        if (compressed_joints != nullptr)
+        {
+            return compressed_joints->get_finite_duration();
+        }
 		return joints.get_finite_duration();
 	}
 
@@ -379,37 +520,75 @@ namespace era_engine::animation
 
 	bool AnimationAssetClip::sample_joint(float sample_time, uint32 joint_index, const JointTransform& bind_transform, JointTransform& out_transform) const
 	{
-        ASSERT(joint_index < joints.get_num_tracks());
-        acl_animation_clip_details::JointTransformSamplingWriter sampling_writer(bind_transform, out_transform);
-        joints.sample_track(joint_index, sample_time, acl::sample_rounding_policy::none, sampling_writer);
+        acl_animation_clip_details::JointTransformSamplingWriter sampling_writer(out_transform);
+
+        if (compressed_joints != nullptr)
+        {
+            ASSERT(joint_index < compressed_joints->get_num_tracks());
+
+            acl::decompression_context<acl::default_transform_decompression_settings> context;
+            context.initialize(*compressed_joints);
+            context.seek(sample_time, acl::sample_rounding_policy::none);
+            context.decompress_track(joint_index, sampling_writer);
+        }
+        else
+        {
+            ASSERT(joint_index < joints.get_num_tracks());
+            joints.sample_track(joint_index, sample_time, acl::sample_rounding_policy::none, sampling_writer);
+        }
 
         return true;
     }
 
 	bool AnimationAssetClip::sample_joints(float sample_time, SkeletonPose& out_pose) const
 	{
-        std::vector<uint32> dummy;
-        acl_animation_clip_details::PoseSamplingWriter sampling_writer(SkeletonPose(out_pose), out_pose, dummy);
-        joints.sample_tracks(sample_time, acl::sample_rounding_policy::none, sampling_writer);
-
-        return true;
+        AnimationClipSamplingContext context;
+        return sample_joints(context, sample_time, out_pose, {});
     }
 
     bool AnimationAssetClip::sample_joints(float sample_time, const SkeletonPose& default_pose, SkeletonPose& out_pose, const std::vector<uint32>& custom_joint_name_mapping) const
     {
-        acl_animation_clip_details::PoseSamplingWriter sampling_writer(default_pose, out_pose, custom_joint_name_mapping);
-        joints.sample_tracks(sample_time, acl::sample_rounding_policy::none, sampling_writer);
+        AnimationClipSamplingContext context;
+        return sample_joints(context, sample_time, out_pose, custom_joint_name_mapping);
+    }
+
+    bool AnimationAssetClip::sample_joints(AnimationClipSamplingContext& context, float sample_time, SkeletonPose& out_pose, const std::vector<uint32>& custom_joint_name_mapping) const
+    {
+        acl_animation_clip_details::PoseSamplingWriter sampling_writer(out_pose, custom_joint_name_mapping);
+
+        if (compressed_joints != nullptr)
+        {
+            if (!context.joints.is_bound_to(*compressed_joints))
+            {
+                context.joints.initialize(*compressed_joints);
+            }
+
+            context.joints.seek(sample_time, acl::sample_rounding_policy::none);
+            context.joints.decompress_tracks(sampling_writer);
+        }
+        else
+        {
+            joints.sample_tracks(sample_time, acl::sample_rounding_policy::none, sampling_writer);
+        }
 
         return true;
     }
 
 	float AnimationAssetClip::get_sample_rate() const
 	{
+        if (compressed_joints != nullptr)
+        {
+            return compressed_joints->get_sample_rate();
+        }
 		return joints.get_sample_rate();
 	}
 
 	uint32 AnimationAssetClip::get_num_samples_per_track() const
 	{
+        if (compressed_joints != nullptr)
+        {
+            return compressed_joints->get_num_samples_per_track();
+        }
 		return joints.get_num_samples_per_track();
 	}
 
@@ -428,20 +607,65 @@ namespace era_engine::animation
 
 	void AnimationAssetClip::sample_curve(float sample_time, uint32 curve_index, float& out_curve_value) const
 	{
-        ASSERT(curve_index < curves.get_num_tracks());
         acl_animation_clip_details::CurveSamplingWriter sampling_writer(out_curve_value);
-        curves.sample_track(curve_index, sample_time, acl::sample_rounding_policy::none, sampling_writer);
+
+        if (compressed_curves != nullptr)
+        {
+            ASSERT(curve_index < compressed_curves->get_num_tracks());
+
+            acl::decompression_context<acl::default_scalar_decompression_settings> context;
+            context.initialize(*compressed_curves);
+            context.seek(sample_time, acl::sample_rounding_policy::none);
+            context.decompress_track(curve_index, sampling_writer);
+        }
+        else
+        {
+            ASSERT(curve_index < curves.get_num_tracks());
+            curves.sample_track(curve_index, sample_time, acl::sample_rounding_policy::none, sampling_writer);
+        }
 	}
 
 	void AnimationAssetClip::sample_curves(float sample_time, std::vector<float>& out_curve_values) const
 	{
-        ASSERT(out_curve_values.size() == curves.get_num_tracks());
-        acl_animation_clip_details::CurvesSamplingWriter sampling_writer(out_curve_values);
-        curves.sample_tracks(sample_time, acl::sample_rounding_policy::none, sampling_writer);
+        AnimationClipSamplingContext context;
+        sample_curves(context, sample_time, out_curve_values);
 	}
 
+    void AnimationAssetClip::sample_curves(AnimationClipSamplingContext& context, float sample_time, std::vector<float>& out_curve_values) const
+    {
+        acl_animation_clip_details::CurvesSamplingWriter sampling_writer(out_curve_values);
+
+        if (compressed_curves != nullptr)
+        {
+            ASSERT(out_curve_values.size() == compressed_curves->get_num_tracks());
+
+            if (!context.curves.is_bound_to(*compressed_curves))
+            {
+                context.curves.initialize(*compressed_curves);
+            }
+
+            context.curves.seek(sample_time, acl::sample_rounding_policy::none);
+            context.curves.decompress_tracks(sampling_writer);
+        }
+        else
+        {
+            ASSERT(out_curve_values.size() == curves.get_num_tracks());
+            curves.sample_tracks(sample_time, acl::sample_rounding_policy::none, sampling_writer);
+        }
+    }
+
 	void AnimationAssetClip::add_curve(const std::string& name, const std::vector<float>& values)
 	{
+        const bool was_compressed = is_compressed();
+        if (compressed_curves != nullptr)
+        {
+            if (!acl_animation_clip_details::convert_curves_to_raw(*allocator, *compressed_curves, curves))
+            {
+                return;
+            }
+            acl_animation_clip_details::free_compressed_tracks(*allocator, compressed_curves);
+        }
+
         if (get_curve_mapping().count(name) == 0)
         {
             std::unordered_map<std::string, uint32> curve_name_mapping_copy = get_curve_mapping();
@@ -490,6 +714,15 @@ namespace era_engine::animation
 
             curves[curve_index] = std::move(float1_track);
         }
+
+        if (was_compressed)
+        {
+            compressed_curves = acl_animation_clip_details::compress_curves(*allocator, curves, compression_settings);
+            if (compressed_curves != nullptr)
+            {
+                curves = acl::track_array_float1f();
+            }
+        }
 	}
 
 	void AnimationAssetClip::remove_curve(const std::string& name)
@@ -497,11 +730,29 @@ namespace era_engine::animation
         auto it = get_curve_mapping().find(name);
         if (it != get_curve_mapping().end())
         {
+            const bool was_compressed = is_compressed();
+            if (compressed_curves != nullptr)
+            {
+                if (!acl_animation_clip_details::convert_curves_to_raw(*allocator, *compressed_curves, curves))
+                {
+                    return;
+                }
+                acl_animation_clip_details::free_compressed_tracks(*allocator, compressed_curves);
+            }
+
             uint32 curve_index = it->second;
 
             acl::track_array_float1f new_curves(*this->allocator, curves.get_num_tracks() - 1);
 
+            // Compressed curves don't keep their names, so the mapping is shifted instead of rebuilt from the tracks.
             std::unordered_map<std::string, uint32> new_curve_mapping;
+            for (const auto& [curve_name, index] : get_curve_mapping())
+            {
+                if (index != curve_index)
+                {
+                    new_curve_mapping[curve_name] = index > curve_index ? index - 1 : index;
+                }
+            }
 
             uint32 new_index = 0;
             for (uint32 index = 0; index < curves.get_num_tracks(); ++index)
@@ -511,13 +762,21 @@ namespace era_engine::animation
                     new_curves[new_index] = std::move(curves[index]);
                     acl::track_desc_scalarf& descr = new_curves[new_index].get_description();
                     descr.output_index = new_index;
-                    new_curve_mapping[std::string(new_curves[new_index].get_name().c_str())] = new_index;
                     ++new_index;
                 }
             }
 
             curve_name_mapping = std::move(new_curve_mapping);
             curves = std::move(new_curves);
+
+            if (was_compressed && !curves.is_empty())
+            {
+                compressed_curves = acl_animation_clip_details::compress_curves(*allocator, curves, compression_settings);
+                if (compressed_curves != nullptr)
+                {
+                    curves = acl::track_array_float1f();
+                }
+            }
         }
 	}
 
@@ -536,6 +795,10 @@ namespace era_engine::animation
         return std::string(".eanm");
     }
 
+    // Leads the compressed layout. Older files start with the joint name mapping and store raw tracks as sjson.
+    static constexpr uint32 compressed_clip_format_tag = 0x434E4145; // "EANC"
+    static constexpr uint32 compressed_clip_format_version = 1;
+
     struct AnimationSerializationData
     {
         std::unordered_map<std::string, uint32> joint_name_mapping;
@@ -547,47 +810,56 @@ namespace era_engine::animation
         ERA_BINARY_SERIALIZE(joint_name_mapping, curve_name_mapping, tracks, curves)
     };
 
-    bool AnimationAssetClip::serialize(std::ostream& os) const
+    struct CompressedAnimationSerializationData
     {
-        AnimationSerializationData data;
+        uint32 format_tag = compressed_clip_format_tag;
+        uint32 format_version = compressed_clip_format_version;
 
-        BinaryDataArchive tracks_data;
-        BinaryDataArchive curves_data;
+        std::unordered_map<std::string, uint32> joint_name_mapping;
+        std::unordered_map<std::string, uint32> curve_name_mapping;
 
-        {
-            StringStream tracks_stream;
-            sjson::Writer writer(tracks_stream);
-            acl::acl_impl::write_sjson_header(joints, writer);
-            acl::acl_impl::write_sjson_tracks(joints, writer);
+        BinaryData joints;
+        BinaryData curves;
 
-            const std::string& content = tracks_stream.ss.str();
+        ERA_BINARY_SERIALIZE(format_tag, format_version, joint_name_mapping, curve_name_mapping, joints, curves)
+    };
 
-            tracks_data.fill(reinterpret_cast<const uint8*>(content.data()), content.size());
-        }
+    bool AnimationAssetClip::serialize(std::ostream& os) const
+    {
+        // Raw clips are compressed on the way out, the clip itself stays raw.
+        acl::compressed_tracks* temporary_joints = nullptr;
+        acl::compressed_tracks* temporary_curves = nullptr;
 
-        if (!curves.is_empty())
+        if (compressed_joints == nullptr)
         {
-            StringStream curve_stream;
-            sjson::Writer writer(curve_stream);
-            acl::acl_impl::write_sjson_header(curves, writer);
-            acl::acl_impl::write_sjson_tracks(curves, writer);
-
-            const std::string& content = curve_stream.ss.str();
-
-            curves_data.fill(reinterpret_cast<const uint8*>(content.data()), content.size());
+            temporary_joints = acl_animation_clip_details::compress_joints(*allocator, joints, compression_settings);
+            if (temporary_joints == nullptr && !joints.is_empty())
+            {
+                return false;
+            }
         }
 
-        const std::unordered_map<std::string, uint32>& clip_curve_name_mapping = get_curve_mapping();
-        const std::unordered_map<std::string, uint32>& clip_joint_name_mapping = get_joint_mapping();
-
-        data.curve_name_mapping.insert(std::begin(clip_curve_name_mapping), std::end(clip_curve_name_mapping));
-        data.joint_name_mapping.insert(std::begin(clip_joint_name_mapping), std::end(clip_joint_name_mapping));
+        if (compressed_curves == nullptr)
+        {
+            temporary_curves = acl_animation_clip_details::compress_curves(*allocator, curves, compression_settings);
+            if (temporary_curves == nullptr && !curves.is_empty())
+            {
+                acl_animation_clip_details::free_compressed_tracks(*allocator, temporary_joints);
+                return false;
+            }
+        }
 
-        data.tracks = BinaryData(tracks_data);
-        data.curves = BinaryData(curves_data);
+        CompressedAnimationSerializationData data;
+        data.joint_name_mapping = get_joint_mapping();
+        data.curve_name_mapping = get_curve_mapping();
+        data.joints = acl_animation_clip_details::get_compressed_data(compressed_joints != nullptr ? compressed_joints : temporary_joints);
+        data.curves = acl_animation_clip_details::get_compressed_data(compressed_curves != nullptr ? compressed_curves : temporary_curves);
 
         const BinaryDataArchive& serialized_data = BinarySerializer::serialize(data);
 
+        acl_animation_clip_details::free_compressed_tracks(*allocator, temporary_joints);
+        acl_animation_clip_details::free_compressed_tracks(*allocator, temporary_curves);
+
         try
         {
             if (!IO::write_value(os, serialized_data))
@@ -613,6 +885,38 @@ namespace era_engine::animation
 			return false;
 		}
 
+        release_compressed_tracks();
+        joints = acl::track_array_qvvf();
+        curves = acl::track_array_float1f();
+
+        uint32 format_tag = 0;
+        if (serialized_data.size() >= sizeof(format_tag))
+        {
+            std::memcpy(&format_tag, BinaryData(serialized_data).data(), sizeof(format_tag));
+        }
+
+        if (format_tag == compressed_clip_format_tag)
+        {
+            CompressedAnimationSerializationData data{};
+            if (BinarySerializer::deserialize(BinaryData(serialized_data), data) != serialized_data.size() ||
+                data.format_version != compressed_clip_format_version)
+            {
+                return false;
+            }
+
+            if (!acl_animation_clip_details::load_compressed_tracks(*allocator, data.joints, acl::track_type8::qvvf, compressed_joints) ||
+                !acl_animation_clip_details::load_compressed_tracks(*allocator, data.curves, acl::track_type8::float1f, compressed_curves))
+            {
+                release_compressed_tracks();
+                return false;
+            }
+
+            joint_name_mapping = std::move(data.joint_name_mapping);
+            curve_name_mapping = std::move(data.curve_name_mapping);
+
+            return true;
+        }
+
 		AnimationSerializationData data{};
         if (BinarySerializer::deserialize(BinaryData(serialized_data), data) != serialized_data.size())
         {
@@ -642,6 +946,9 @@ namespace era_engine::animation
             curves = std::move(*acl::track_array_cast<acl::track_array_float1f>(&raw_curves_data.track_list));
         }
 
+        // Clips saved before compression was introduced are compressed on load. If that fails, they keep playing raw.
+        compress(compression_settings);
+
         return true;
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,7 @@
 #include "animation/animation_pose_sampler.h"
 
+#include "core/hash.h"
+
 namespace era_engine::animation
 {
 	void AnimationPoseSampler::init(const Skeleton* _skeleton, std::shared_ptr<AnimationAssetClip> _animation)
@@ -9,26 +11,46 @@ namespace era_engine::animation
 
 		skeleton = _skeleton;
 		animation = _animation;
+		sampling_context.reset();
+
+		build_joint_mapping(skeleton, animation.get(), joint_mapping);
+	}
+
+	void AnimationPoseSampler::init(const Skeleton* _skeleton, std::shared_ptr<AnimationAssetClip> _animation, const std::vector<uint32>& _joint_mapping)
+	{
+		ASSERT(_skeleton != nullptr);
+		ASSERT(_animation != nullptr);
+		ASSERT(_joint_mapping.size() == _animation->get_joint_mapping().size());
+
+		skeleton = _skeleton;
+		animation = _animation;
+		sampling_context.reset();
+
+		// Keeps the capacity, samplers switching between clips of the same rig don't allocate.
+		joint_mapping.assign(_joint_mapping.begin(), _joint_mapping.end());
+	}
+
+	void AnimationPoseSampler::build_joint_mapping(const Skeleton* skeleton, const AnimationAssetClip* animation, std::vector<uint32>& out_joint_mapping)
+	{
+		out_joint_mapping.clear();
 
-		if (skeleton == nullptr)
+		if (skeleton == nullptr || animation == nullptr)
 		{
-			joint_mapping.clear();
+			return;
 		}
-		else
-		{
-			const std::unordered_map<std::string, uint32>& mapping = animation->get_joint_mapping();
 
-			joint_mapping.resize(mapping.size(), INVALID_JOINT);
+		const std::unordered_map<std::string, uint32>& mapping = animation->get_joint_mapping();
 
-			for (uint32 joint_index = 0; joint_index < skeleton->joints.size(); ++joint_index)
-			{
-				const std::string& joint_uuid = skeleton->joints[joint_index].name;
+		out_joint_mapping.resize(mapping.size(), INVALID_JOINT);
+
+		for (uint32 joint_index = 0; joint_index < skeleton->joints.size(); ++joint_index)
+		{
+			const std::string& joint_uuid = skeleton->joints[joint_index].name;
 
-				auto iter = mapping.find(joint_uuid);
-				if (iter != mapping.end())
-				{
-					joint_mapping[iter->second] = joint_index;
-				}
+			auto iter = mapping.find(joint_uuid);
+			if (iter != mapping.end())
+			{
+				out_joint_mapping[iter->second] = joint_index;
 			}
 		}
 	}
@@ -38,17 +60,18 @@ namespace era_engine::animation
 		skeleton = nullptr;
 		animation.reset();
 		joint_mapping.clear();
+		sampling_context.reset();
 	}
 
-	bool AnimationPoseSampler::sample_pose(float sample_time, SkeletonPose& target) const
+	bool AnimationPoseSampler::sample_pose(float sample_time, SkeletonPose& target)
 	{
-		return animation->sample_joints(sample_time, skeleton->get_default_pose(), target, joint_mapping);
+		return animation->sample_joints(sampling_context, sample_time, target, joint_mapping);
 	}
 
-	void AnimationPoseSampler::sample_curves(float sample_time, std::vector<float>& target) const
+	void AnimationPoseSampler::sample_curves(float sample_time, std::vector<float>& target)
 	{
 		target.resize(animation->get_curve_mapping().size());
-		animation->sample_curves(sample_time, target);
+		animation->sample_curves(sampling_context, sample_time, target);
 	}
 
 	void AnimationPoseSampler::set_joint_enabled(const std::string& joint_name, bool enabled)
@@ -90,4 +113,72 @@ namespace era_engine::animation
 	{
 		return animation->get_duration();
 	}
+
+	size_t JointMappingCache::KeyHash::operator()(const Key& key) const
+	{
+		size_t seed = 0;
+		hash_combine(seed, key.first);
+		hash_combine(seed, key.second);
+		return seed;
+	}
+
+	ref<const std::vector<uint32>> JointMappingCache::get_joint_mapping(const ref<Skeleton>& skeleton, const ref<AnimationAssetClip>& animation)
+	{
+		ASSERT(skeleton != nullptr);
+		ASSERT(animation != nullptr);
+
+		const Key key = { skeleton.get(), animation.get() };
+
+		std::lock_guard lock{ mutex };
+
+		auto iter = entries.find(key);
+		if (iter != entries.end())
+		{
+			// An expired entry means the address now belongs to a different asset.
+			const Entry& entry = iter->second;
+			if (entry.skeleton.lock() == skeleton && entry.animation.lock() == animation)
+			{
+				return entry.joint_mapping;
+			}
+		}
+
+		if (entries.size() >= next_cleanup_size)
+		{
+			remove_expired_entries();
+			next_cleanup_size = max(next_cleanup_size, entries.size() * 2);
+		}
+
+		ref<std::vector<uint32>> joint_mapping = make_ref<std::vector<uint32>>();
+		AnimationPoseSampler::build_joint_mapping(skeleton.get(), animation.get(), *joint_mapping);
+
+		entries[key] = Entry{ skeleton, animation, joint_mapping };
+		return joint_mapping;
+	}
+
+	void JointMappingCache::clear()
+	{
+		std::lock_guard lock{ mutex };
+		entries.clear();
+	}
+
+	uint32 JointMappingCache::size() const
+	{
+		std::lock_guard lock{ mutex };
+		return (uint32)entries.size();
+	}
+
+	void JointMappingCache::remove_expired_entries()
+	{
+		for (auto iter = entries.begin(); iter != entries.end();)
+		{
+			if (iter->second.skeleton.expired() || iter->second.animation.expired())
+			{
+				iter = entries.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+	}
 }
\ No newline at end of file
@@ -3,10 +3,9 @@
 #include "animation/skinning.h"
 #include "animation/animation_pose_sampler.h"
 
-#include "rendering/ecs/renderer_holder_root_component.h"
-
 #include "core/cpu_profiling.h"
-#include "core/memory.h"
+#include "core/frame_allocator.h"
+#include "core/job_system.h"
 
 #include "engine/engine.h"
 
@@ -17,97 +16,163 @@
 #include <rttr/policy.h>
 #include <rttr/registration>
 
+#include <algorithm>
+
 namespace era_engine::animation
 {
+	// Entity runs per job. Sampling and skinning one character takes a few microseconds.
+	static constexpr uint32 animation_update_grain = 16;
 
 	RTTR_REGISTRATION
 	{
 		using namespace rttr;
 
 		registration::class_<AnimationSystem>("AnimationSystem")
-			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string("render")))
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string("animation")))
 			.method("update", &AnimationSystem::update)(metadata("update_group", update_types::GAMEPLAY_NORMAL));
 	}
 
-		AnimationSystem::AnimationSystem(World* _world)
+	AnimationSystem::AnimationSystem(World* _world)
 		: System(_world)
 	{
-		renderer_holder_rc = world->add_root_component<RendererHolderRootComponent>();
-		ASSERT(renderer_holder_rc != nullptr);
 	}
 
 	AnimationSystem::~AnimationSystem()
 	{
-		allocator->reset();
 	}
 
 	void AnimationSystem::init()
 	{
-		allocator = make_ref<Allocator>();
+		joint_mapping_cache = make_ref<JointMappingCache>();
 	}
 
 	void AnimationSystem::update(float dt)
 	{
 		ZoneScopedN("AnimationSystem::render");
 
-		MemoryMarker marker = allocator->get_marker();
-		for (auto [entity_handle, animation_component, mesh_component, skeleton_component, transform_component] :
-			world->group(components_group<AnimationComponent, MeshComponent, SkeletonComponent, TransformComponent>).each())
+		animated_entities.clear();
+		if (world->has_tag("render"))
+		{
+			for (auto [entity_handle, animation_component, mesh_component, skeleton_component, transform_component] :
+				world->group(components_group<AnimationComponent, MeshComponent, SkeletonComponent, TransformComponent>).each())
+			{
+				animated_entities.push_back({ &animation_component, &mesh_component, &skeleton_component, (uint32)animated_entities.size() });
+			}
+		}
+		else
+		{
+			for (auto [entity_handle, animation_component, skeleton_component, transform_component] :
+				world->group(components_group<AnimationComponent, SkeletonComponent, TransformComponent>).each())
+			{
+				animated_entities.push_back({ &animation_component, nullptr, &skeleton_component, (uint32)animated_entities.size() });
+			}
+		}
+
+		// Entities that share a skeleton write to it (apply_pose) and read it back, so they stay on one thread, in their original order.
+		std::sort(animated_entities.begin(), animated_entities.end(), [](const AnimatedEntity& a, const AnimatedEntity& b)
+			{
+				const Skeleton* skeleton_a = a.skeleton_component->skeleton.get();
+				const Skeleton* skeleton_b = b.skeleton_component->skeleton.get();
+				return (skeleton_a != skeleton_b) ? (skeleton_a < skeleton_b) : (a.order < b.order);
+			});
+
+		run_offsets.clear();
+		for (uint32 i = 0; i < (uint32)animated_entities.size(); ++i)
 		{
-			const dx_mesh& dxMesh = mesh_component.mesh->mesh;
-			ref<Skeleton> skeleton = skeleton_component.skeleton;
+			if (i == 0 || animated_entities[i].skeleton_component->skeleton != animated_entities[i - 1].skeleton_component->skeleton)
+			{
+				run_offsets.push_back(i);
+			}
+		}
+		run_offsets.push_back((uint32)animated_entities.size());
+
+		parallel_for(0, (uint32)run_offsets.size() - 1, animation_update_grain, [this, dt](uint32 begin, uint32 end)
+			{
+				for (uint32 i = run_offsets[begin]; i < run_offsets[end]; ++i)
+				{
+					update_entity(animated_entities[i], dt);
+				}
+			});
+	}
+
+	void AnimationSystem::update_entity(const AnimatedEntity& entity, float dt)
+	{
+		AnimationComponent& animation_component = *entity.animation_component;
+		const ref<Skeleton>& skeleton = entity.skeleton_component->skeleton;
+
+		const uint32 num_joints = (uint32)skeleton->joints.size();
+
+		animation_component.current_global_transforms = nullptr;
 
-			animation_component.current_global_transforms = nullptr;
+		mat4* skinning_matrices = nullptr;
+		if (entity.mesh_component != nullptr)
+		{
+			const dx_mesh& dxMesh = entity.mesh_component->mesh->mesh;
 
-			auto [vb, skinning_matrices] = skinObject(dxMesh.vertexBuffer, dxMesh.vertexBuffer.positions->elementCount, (uint32)skeleton->joints.size());
+			auto [vb, matrices] = skinObject(dxMesh.vertexBuffer, dxMesh.vertexBuffer.positions->elementCount, num_joints);
+			skinning_matrices = matrices;
 
 			animation_component.prev_frame_vertex_buffer = animation_component.current_vertex_buffer;
 			animation_component.current_vertex_buffer = vb;
+		}
 
-			if (animation_component.current_animation != nullptr &&
-				animation_component.current_animation->is_valid() &&
-				animation_component.play)
+		if (animation_component.current_animation != nullptr &&
+			animation_component.current_animation->is_valid() &&
+			animation_component.play)
+		{
+			const float anim_duration = animation_component.current_animation->get_duration();
+
+			if (animation_component.current_anim_position < anim_duration)
 			{
-				const float anim_duration = animation_component.current_animation->get_duration();
+				AnimationPoseSampler& sampler = animation_component.sampler;
+				if (sampler.get_animation() != animation_component.current_animation ||
+					sampler.get_skeleton() != skeleton.get())
+				{
+					ref<const std::vector<uint32>> joint_mapping = joint_mapping_cache->get_joint_mapping(skeleton, animation_component.current_animation);
+					sampler.init(skeleton.get(), animation_component.current_animation, *joint_mapping);
+				}
+
+				// Sampled in place, joints the clip doesn't animate keep their identity transform from the first frame.
+				SkeletonPose& result_pose = animation_component.current_animation_pose;
+				if (result_pose.size() != num_joints)
+				{
+					result_pose = SkeletonPose(num_joints);
+				}
 
-				if (animation_component.current_anim_position < anim_duration)
+				sampler.sample_pose(animation_component.current_anim_position, result_pose);
+				if (result_pose.is_valid() && animation_component.update_skeleton)
 				{
-					AnimationPoseSampler sampler;
-					sampler.init(skeleton.get(), animation_component.current_animation);
-
-					SkeletonPose result_pose = SkeletonPose(skeleton->joints.size());
-					sampler.sample_pose(animation_component.current_anim_position, result_pose);
-					if (result_pose.is_valid())
-					{
-						if (animation_component.update_skeleton)
-						{
-							skeleton->apply_pose(result_pose);
-						}
-						animation_component.current_animation_pose = result_pose;
-					}
+					skeleton->apply_pose(result_pose);
 				}
+			}
 
-				animation_component.current_anim_position += dt;
+			animation_component.current_anim_position += dt;
 
-				if (animation_component.current_anim_position >= anim_duration)
+			if (animation_component.current_anim_position >= anim_duration)
+			{
+				if (animation_component.loop)
 				{
-					if (animation_component.loop)
-					{
-						animation_component.current_anim_position = fmod(animation_component.current_anim_position, anim_duration);
-					}
-					else
-					{
-						animation_component.current_anim_position = anim_duration;
-					}
+					animation_component.current_anim_position = fmod(animation_component.current_anim_position, anim_duration);
+				}
+				else
+				{
+					animation_component.current_anim_position = anim_duration;
 				}
 			}
+		}
 
-			trs* global_transforms = allocator->allocate<trs>((uint32)skeleton->joints.size());
+		// Comes from the calling worker's arena and stays valid through the next frame, so readers don't race the next update.
+		trs* global_transforms = frame_allocator.allocate<trs>(num_joints, FrameLifetime::TwoFrames);
 
+		if (skinning_matrices != nullptr)
+		{
 			skeleton->get_skinning_matrices_from_local_transforms(global_transforms, skinning_matrices, trs::identity);
-
-			animation_component.current_global_transforms = global_transforms;
 		}
-		allocator->reset_to_marker(marker);
+		else
+		{
+			skeleton->get_global_transforms_from_local_transforms(global_transforms, trs::identity);
+		}
+
+		animation_component.current_global_transforms = global_transforms;
 	}
 }
\ No newline at end of file
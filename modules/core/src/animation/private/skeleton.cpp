@@ -183,6 +183,27 @@ namespace era_engine::animation
 		}
 	}
 
+	void Skeleton::get_global_transforms_from_local_transforms(trs* out_global_transforms, const trs& world_transform) const
+	{
+		uint32 num_joints = (uint32)joints.size();
+
+		for (uint32 i = 0; i < num_joints; ++i)
+		{
+			const SkeletonJoint& joint = joints[i];
+			const JointTransform& joint_transform = local_transforms[i];
+
+			if (joint.parent_id != INVALID_JOINT && joint.parent_id < joints.size())
+			{
+				ASSERT(i > joint.parent_id); // Parent already processed
+				out_global_transforms[i] = out_global_transforms[joint.parent_id] * joint_transform.get_transform();
+			}
+			else
+			{
+				out_global_transforms[i] = world_transform * joint_transform.get_transform();
+			}
+		}
+	}
+
 	void Skeleton::get_skinning_matrices_from_local_transforms(mat4* out_skinning_matrices, const trs& world_transform) const
 	{
 		uint32 num_joints = (uint32)joints.size();
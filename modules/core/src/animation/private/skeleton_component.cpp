@@ -10,10 +10,10 @@ namespace era_engine::animation
 	{
 		using namespace rttr;
 		registration::class_<SkeletonComponent>("SkeletonComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	SkeletonComponent::SkeletonComponent(ref<Entity::EcsData> _data)
+	SkeletonComponent::SkeletonComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
@@ -0,0 +1,669 @@
+#include "animation/skeleton_pose_soa.h"
+
+#include "core/math_simd.h"
+
+namespace era_engine::animation
+{
+#if defined(SIMD_AVX_2)
+	typedef w8_float pose_float;
+	typedef __m256i pose_indices;
+#else
+	typedef w4_float pose_float;
+	typedef __m128i pose_indices;
+#endif
+
+	typedef wN_vec3<pose_float> pose_vec3;
+	typedef wN_quat<pose_float> pose_quat;
+	typedef wN_mat4<pose_float> pose_mat4;
+
+	static constexpr uint32 pose_lanes = sizeof(pose_float) / sizeof(float);
+	static_assert(SOA_POSE_LANES % pose_lanes == 0);
+
+	static const float identity_stream_values[soa_pose_stream_count] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f };
+
+	struct pose_trs
+	{
+		pose_quat rotation;
+		pose_vec3 position;
+		pose_vec3 scale;
+	};
+
+	static uint32 get_padded_size(uint32 size)
+	{
+		return (size + SOA_POSE_LANES - 1) / SOA_POSE_LANES * SOA_POSE_LANES;
+	}
+
+	static pose_indices load_indices(const int32* indices)
+	{
+#if defined(SIMD_AVX_2)
+		return _mm256_loadu_si256((const __m256i*)indices);
+#else
+		return _mm_loadu_si128((const __m128i*)indices);
+#endif
+	}
+
+	static pose_trs load_trs(const float* streams, uint32 stride, uint32 offset)
+	{
+		const float* base = streams + offset;
+
+		pose_trs result;
+		result.position = pose_vec3(pose_float(base + soa_pose_position_x * stride), pose_float(base + soa_pose_position_y * stride), pose_float(base + soa_pose_position_z * stride));
+		result.rotation = pose_quat(pose_float(base + soa_pose_rotation_x * stride), pose_float(base + soa_pose_rotation_y * stride),
+			pose_float(base + soa_pose_rotation_z * stride), pose_float(base + soa_pose_rotation_w * stride));
+		result.scale = pose_vec3(pose_float(base + soa_pose_scale_x * stride), pose_float(base + soa_pose_scale_y * stride), pose_float(base + soa_pose_scale_z * stride));
+		return result;
+	}
+
+	static pose_trs gather_trs(const float* streams, uint32 stride, pose_indices indices)
+	{
+		pose_trs result;
+		result.position = pose_vec3(pose_float(streams + soa_pose_position_x * stride, indices), pose_float(streams + soa_pose_position_y * stride, indices),
+			pose_float(streams + soa_pose_position_z * stride, indices));
+		result.rotation = pose_quat(pose_float(streams + soa_pose_rotation_x * stride, indices), pose_float(streams + soa_pose_rotation_y * stride, indices),
+			pose_float(streams + soa_pose_rotation_z * stride, indices), pose_float(streams + soa_pose_rotation_w * stride, indices));
+		result.scale = pose_vec3(pose_float(streams + soa_pose_scale_x * stride, indices), pose_float(streams + soa_pose_scale_y * stride, indices),
+			pose_float(streams + soa_pose_scale_z * stride, indices));
+		return result;
+	}
+
+	static void store_trs(const pose_trs& transform, float* streams, uint32 stride, uint32 offset)
+	{
+		float* base = streams + offset;
+
+		transform.position.x.store(base + soa_pose_position_x * stride);
+		transform.position.y.store(base + soa_pose_position_y * stride);
+		transform.position.z.store(base + soa_pose_position_z * stride);
+		transform.rotation.x.store(base + soa_pose_rotation_x * stride);
+		transform.rotation.y.store(base + soa_pose_rotation_y * stride);
+		transform.rotation.z.store(base + soa_pose_rotation_z * stride);
+		transform.rotation.w.store(base + soa_pose_rotation_w * stride);
+		transform.scale.x.store(base + soa_pose_scale_x * stride);
+		transform.scale.y.store(base + soa_pose_scale_y * stride);
+		transform.scale.z.store(base + soa_pose_scale_z * stride);
+	}
+
+	static pose_vec3 lerp(const pose_vec3& from, const pose_vec3& to, pose_float t)
+	{
+		return fmadd(to - from, pose_vec3(t), from);
+	}
+
+	static pose_quat normalize_precise(const pose_quat& q)
+	{
+		// rsqrt only has 12 bits of precision, which is visible after a few blends.
+		const pose_float inv_length = pose_float(1.f) / sqrt(dot(q.v4, q.v4));
+		return pose_quat(q.x * inv_length, q.y * inv_length, q.z * inv_length, q.w * inv_length);
+	}
+
+	// Negates 'q' in the lanes where 'sign' has its sign bit set.
+	static pose_quat flip_sign(const pose_quat& q, pose_float sign)
+	{
+		const pose_float sign_bit = sign & pose_float(-0.f);
+		return pose_quat(q.x ^ sign_bit, q.y ^ sign_bit, q.z ^ sign_bit, q.w ^ sign_bit);
+	}
+
+	static pose_quat nlerp_shortest(const pose_quat& from, const pose_quat& to, pose_float t)
+	{
+		const pose_quat to_near = flip_sign(to, dot(from.v4, to.v4));
+		return normalize_precise(pose_quat(lerp(from.x, to_near.x, t), lerp(from.y, to_near.y, t), lerp(from.z, to_near.z, t), lerp(from.w, to_near.w, t)));
+	}
+
+	// Same polynomial as slerp_shortest_approx.
+	static pose_quat slerp_shortest_approx(const pose_quat& from, const pose_quat& to, pose_float t)
+	{
+		const pose_float d = abs(dot(from.v4, to.v4));
+		const pose_float a = fmadd(d, fmadd(d, fmadd(d, pose_float(-1.43519f), pose_float(3.55645f)), pose_float(-3.2452f)), pose_float(1.0904f));
+		const pose_float b = fmadd(d, fmadd(d, pose_float(0.215638f), pose_float(-1.06021f)), pose_float(0.848013f));
+
+		const pose_float centered = t - pose_float(0.5f);
+		const pose_float k = fmadd(a * centered, centered, b);
+		const pose_float corrected_t = fmadd(t * centered * (t - pose_float(1.f)), k, t);
+
+		return nlerp_shortest(from, to, corrected_t);
+	}
+
+	static pose_vec3 rotate(const pose_quat& q, const pose_vec3& v)
+	{
+		const pose_vec3 axis(q.x, q.y, q.z);
+		const pose_vec3 t = cross(axis, v) * pose_float(2.f);
+		return v + t * q.w + cross(axis, t);
+	}
+
+	static pose_trs multiply(const pose_trs& a, const pose_trs& b)
+	{
+		pose_trs result;
+		result.rotation = a.rotation * b.rotation;
+		result.position = rotate(a.rotation, a.scale * b.position) + a.position;
+		result.scale = a.scale * b.scale;
+		return result;
+	}
+
+	// Same as create_model_matrix.
+	static pose_mat4 to_mat4(const pose_trs& transform)
+	{
+		const pose_quat& r = transform.rotation;
+		const pose_vec3& s = transform.scale;
+
+		const pose_float x2 = r.x + r.x;
+		const pose_float y2 = r.y + r.y;
+		const pose_float z2 = r.z + r.z;
+
+		const pose_float xx2 = r.x * x2;
+		const pose_float yy2 = r.y * y2;
+		const pose_float zz2 = r.z * z2;
+		const pose_float yz2 = r.y * z2;
+		const pose_float wx2 = r.w * x2;
+		const pose_float xy2 = r.x * y2;
+		const pose_float wz2 = r.w * z2;
+		const pose_float xz2 = r.x * z2;
+		const pose_float wy2 = r.w * y2;
+
+		const pose_float one(1.f);
+		const pose_float zero = pose_float::zero();
+
+		pose_mat4 result;
+		result.m00 = (one - (yy2 + zz2)) * s.x;
+		result.m10 = (xy2 + wz2) * s.x;
+		result.m20 = (xz2 - wy2) * s.x;
+		result.m30 = zero;
+
+		result.m01 = (xy2 - wz2) * s.y;
+		result.m11 = (one - (xx2 + zz2)) * s.y;
+		result.m21 = (yz2 + wx2) * s.y;
+		result.m31 = zero;
+
+		result.m02 = (xz2 + wy2) * s.z;
+		result.m12 = (yz2 - wx2) * s.z;
+		result.m22 = (one - (xx2 + yy2)) * s.z;
+		result.m32 = zero;
+
+		result.m03 = transform.position.x;
+		result.m13 = transform.position.y;
+		result.m23 = transform.position.z;
+		result.m33 = one;
+		return result;
+	}
+
+#if defined(SIMD_AVX_2)
+	static void transpose8x8(__m256* rows)
+	{
+		const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+		const __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+		const __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+		const __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+		const __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+		const __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+		const __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+		const __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+		const __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+		rows[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+		rows[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+		rows[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+		rows[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+		rows[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+		rows[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+		rows[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+		rows[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+	}
+#endif
+
+	// Writes lane i to out_matrices[joints[i]], lanes with INVALID_JOINT are skipped.
+	static void store_matrices(const pose_mat4& matrices, const uint32* joints, mat4* out_matrices)
+	{
+#if defined(SIMD_AVX_2)
+		// Both halves of mat4::m (column major) become one row of a transpose each.
+		__m256 low[8];
+		__m256 high[8];
+		for (uint32 i = 0; i < 8; ++i)
+		{
+			low[i] = matrices.m[i].f;
+			high[i] = matrices.m[i + 8].f;
+		}
+		transpose8x8(low);
+		transpose8x8(high);
+
+		for (uint32 lane = 0; lane < pose_lanes; ++lane)
+		{
+			if (joints[lane] != INVALID_JOINT)
+			{
+				float* out = out_matrices[joints[lane]].m;
+				_mm256_storeu_ps(out, low[lane]);
+				_mm256_storeu_ps(out + 8, high[lane]);
+			}
+		}
+#else
+		alignas(16) float lanes[16][pose_lanes];
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			matrices.m[i].store(lanes[i]);
+		}
+
+		for (uint32 lane = 0; lane < pose_lanes; ++lane)
+		{
+			if (joints[lane] != INVALID_JOINT)
+			{
+				for (uint32 i = 0; i < 16; ++i)
+				{
+					out_matrices[joints[lane]].m[i] = lanes[i][lane];
+				}
+			}
+		}
+#endif
+	}
+
+	static void store_transforms(const pose_trs& transforms, const uint32* joints, trs* out_transforms)
+	{
+		alignas(32) float lanes[soa_pose_stream_count][pose_lanes];
+		store_trs(transforms, &lanes[0][0], pose_lanes, 0);
+
+		for (uint32 lane = 0; lane < pose_lanes; ++lane)
+		{
+			if (joints[lane] != INVALID_JOINT)
+			{
+				trs& out = out_transforms[joints[lane]];
+				out.position = vec3(lanes[soa_pose_position_x][lane], lanes[soa_pose_position_y][lane], lanes[soa_pose_position_z][lane]);
+				out.rotation = quat(lanes[soa_pose_rotation_x][lane], lanes[soa_pose_rotation_y][lane], lanes[soa_pose_rotation_z][lane], lanes[soa_pose_rotation_w][lane]);
+				out.scale = vec3(lanes[soa_pose_scale_x][lane], lanes[soa_pose_scale_y][lane], lanes[soa_pose_scale_z][lane]);
+			}
+		}
+	}
+
+	// Per joint weights of one group, the part past the end of the pose reads as zero.
+	static pose_float load_weights(const float* joint_weights, uint32 offset, uint32 joints_size)
+	{
+		if (offset + pose_lanes <= joints_size)
+		{
+			return pose_float(joint_weights + offset);
+		}
+
+		alignas(32) float weights[pose_lanes] = {};
+		for (uint32 i = offset; i < joints_size; ++i)
+		{
+			weights[i - offset] = joint_weights[i];
+		}
+		return pose_float(weights);
+	}
+
+	SoaSkeletonPose::SoaSkeletonPose(uint32 joints_size)
+	{
+		resize(joints_size);
+	}
+
+	void SoaSkeletonPose::resize(uint32 _joints_size)
+	{
+		joints_size = _joints_size;
+		padded_joints_size = get_padded_size(joints_size);
+
+		streams.resize(soa_pose_stream_count * padded_joints_size);
+		for (uint32 stream = 0; stream < soa_pose_stream_count; ++stream)
+		{
+			float* begin = streams.data() + stream * padded_joints_size;
+			std::fill(begin, begin + padded_joints_size, identity_stream_values[stream]);
+		}
+	}
+
+	uint32 SoaSkeletonPose::size() const
+	{
+		return joints_size;
+	}
+
+	uint32 SoaSkeletonPose::padded_size() const
+	{
+		return padded_joints_size;
+	}
+
+	void SoaSkeletonPose::set_joint_transform(const trs& transform, uint32 joint_id)
+	{
+		ASSERT(joint_id < joints_size);
+
+		float* base = streams.data() + joint_id;
+		base[soa_pose_position_x * padded_joints_size] = transform.position.x;
+		base[soa_pose_position_y * padded_joints_size] = transform.position.y;
+		base[soa_pose_position_z * padded_joints_size] = transform.position.z;
+		base[soa_pose_rotation_x * padded_joints_size] = transform.rotation.x;
+		base[soa_pose_rotation_y * padded_joints_size] = transform.rotation.y;
+		base[soa_pose_rotation_z * padded_joints_size] = transform.rotation.z;
+		base[soa_pose_rotation_w * padded_joints_size] = transform.rotation.w;
+		base[soa_pose_scale_x * padded_joints_size] = transform.scale.x;
+		base[soa_pose_scale_y * padded_joints_size] = transform.scale.y;
+		base[soa_pose_scale_z * padded_joints_size] = transform.scale.z;
+	}
+
+	trs SoaSkeletonPose::get_joint_transform(uint32 joint_id) const
+	{
+		ASSERT(joint_id < joints_size);
+
+		const float* base = streams.data() + joint_id;
+
+		trs result;
+		result.position = vec3(base[soa_pose_position_x * padded_joints_size], base[soa_pose_position_y * padded_joints_size], base[soa_pose_position_z * padded_joints_size]);
+		result.rotation = quat(base[soa_pose_rotation_x * padded_joints_size], base[soa_pose_rotation_y * padded_joints_size],
+			base[soa_pose_rotation_z * padded_joints_size], base[soa_pose_rotation_w * padded_joints_size]);
+		result.scale = vec3(base[soa_pose_scale_x * padded_joints_size], base[soa_pose_scale_y * padded_joints_size], base[soa_pose_scale_z * padded_joints_size]);
+		return result;
+	}
+
+	void SoaSkeletonPose::load(const SkeletonPose& pose)
+	{
+		ASSERT(pose.size() == joints_size);
+		for (uint32 joint_id = 0; joint_id < joints_size; ++joint_id)
+		{
+			set_joint_transform(pose.get_joint_transform(joint_id).get_transform(), joint_id);
+		}
+	}
+
+	void SoaSkeletonPose::load(const std::vector<JointTransform>& transforms)
+	{
+		ASSERT(transforms.size() == joints_size);
+		for (uint32 joint_id = 0; joint_id < joints_size; ++joint_id)
+		{
+			set_joint_transform(transforms[joint_id].get_transform(), joint_id);
+		}
+	}
+
+	void SoaSkeletonPose::store(SkeletonPose& out_pose) const
+	{
+		ASSERT(out_pose.size() == joints_size);
+		for (uint32 joint_id = 0; joint_id < joints_size; ++joint_id)
+		{
+			out_pose.set_joint_transform(JointTransform(get_joint_transform(joint_id)), joint_id);
+		}
+	}
+
+	void SoaSkeletonPose::store(trs* out_transforms) const
+	{
+		for (uint32 joint_id = 0; joint_id < joints_size; ++joint_id)
+		{
+			out_transforms[joint_id] = get_joint_transform(joint_id);
+		}
+	}
+
+	float* SoaSkeletonPose::get_stream(soa_pose_stream stream)
+	{
+		ASSERT(stream < soa_pose_stream_count);
+		return streams.data() + stream * padded_joints_size;
+	}
+
+	const float* SoaSkeletonPose::get_stream(soa_pose_stream stream) const
+	{
+		ASSERT(stream < soa_pose_stream_count);
+		return streams.data() + stream * padded_joints_size;
+	}
+
+	SoaSkeletonHierarchy::SoaSkeletonHierarchy(const Skeleton& skeleton)
+	{
+		build(skeleton);
+	}
+
+	void SoaSkeletonHierarchy::build(const Skeleton& skeleton)
+	{
+		joints_size = (uint32)skeleton.joints.size();
+
+		// Depth first, as parents always come before their children.
+		std::vector<uint32> depths(joints_size, 0);
+		uint32 max_depth = 0;
+		for (uint32 joint_id = 0; joint_id < joints_size; ++joint_id)
+		{
+			const uint32 parent_id = skeleton.joints[joint_id].parent_id;
+			if (parent_id != INVALID_JOINT && parent_id < joints_size)
+			{
+				ASSERT(joint_id > parent_id); // Parent already processed.
+				depths[joint_id] = depths[parent_id] + 1;
+				max_depth = max(max_depth, depths[joint_id]);
+			}
+		}
+
+		// Stable counting sort by depth.
+		std::vector<uint32> depth_offsets(max_depth + 2, 0);
+		for (uint32 depth : depths)
+		{
+			++depth_offsets[depth + 1];
+		}
+		for (uint32 depth = 1; depth < (uint32)depth_offsets.size(); ++depth)
+		{
+			depth_offsets[depth] += depth_offsets[depth - 1];
+		}
+
+		std::vector<uint32> sorted_joints(joints_size);
+		for (uint32 joint_id = 0; joint_id < joints_size; ++joint_id)
+		{
+			sorted_joints[depth_offsets[depths[joint_id]]++] = joint_id;
+		}
+
+		// Greedy packing: a group is closed early only when a joint's parent is part of it.
+		std::vector<uint32> joint_slots(joints_size, INVALID_JOINT);
+
+		slot_joints.clear();
+		uint32 group_begin = 0;
+		for (uint32 joint_id : sorted_joints)
+		{
+			const uint32 parent_id = skeleton.joints[joint_id].parent_id;
+			const bool parent_in_group = parent_id != INVALID_JOINT && parent_id < joints_size && joint_slots[parent_id] >= group_begin;
+
+			if (parent_in_group || (uint32)slot_joints.size() == group_begin + SOA_POSE_LANES)
+			{
+				slot_joints.resize(group_begin + SOA_POSE_LANES, INVALID_JOINT);
+				group_begin += SOA_POSE_LANES;
+			}
+
+			joint_slots[joint_id] = (uint32)slot_joints.size();
+			slot_joints.push_back(joint_id);
+		}
+		slot_joints.resize(get_padded_size((uint32)slot_joints.size()), INVALID_JOINT);
+
+		num_slots = (uint32)slot_joints.size();
+
+		slot_gather_indices.resize(num_slots);
+		slot_parents.resize(num_slots);
+		inv_bind_streams.assign(16 * num_slots, 0.0f);
+
+		for (uint32 slot = 0; slot < num_slots; ++slot)
+		{
+			const uint32 joint_id = slot_joints[slot];
+			if (joint_id == INVALID_JOINT)
+			{
+				slot_gather_indices[slot] = 0;
+				slot_parents[slot] = (int32)num_slots;
+				continue;
+			}
+
+			const SkeletonJoint& joint = skeleton.joints[joint_id];
+
+			slot_gather_indices[slot] = (int32)joint_id;
+			slot_parents[slot] = (joint.parent_id != INVALID_JOINT && joint.parent_id < joints_size) ? (int32)joint_slots[joint.parent_id] : (int32)num_slots;
+
+			for (uint32 i = 0; i < 16; ++i)
+			{
+				inv_bind_streams[i * num_slots + slot] = joint.inv_bind_transform.m[i];
+			}
+		}
+	}
+
+	uint32 SoaSkeletonHierarchy::size() const
+	{
+		return joints_size;
+	}
+
+	float SoaSkeletonHierarchy::get_padding_ratio() const
+	{
+		return num_slots ? (float)(num_slots - joints_size) / (float)num_slots : 0.0f;
+	}
+
+	void SoaPoseUtils::blend_nlerp(const SoaSkeletonPose& from, const SoaSkeletonPose& to, float t, SoaSkeletonPose& out)
+	{
+		ASSERT(from.size() == to.size() && from.size() == out.size());
+
+		const uint32 stride = out.padded_size();
+		const pose_float weight(clamp01(t));
+
+		for (uint32 offset = 0; offset < stride; offset += pose_lanes)
+		{
+			const pose_trs a = load_trs(from.streams.data(), stride, offset);
+			const pose_trs b = load_trs(to.streams.data(), stride, offset);
+
+			pose_trs result;
+			result.position = lerp(a.position, b.position, weight);
+			result.rotation = nlerp_shortest(a.rotation, b.rotation, weight);
+			result.scale = lerp(a.scale, b.scale, weight);
+			store_trs(result, out.streams.data(), stride, offset);
+		}
+	}
+
+	void SoaPoseUtils::blend_slerp(const SoaSkeletonPose& from, const SoaSkeletonPose& to, float t, SoaSkeletonPose& out)
+	{
+		ASSERT(from.size() == to.size() && from.size() == out.size());
+
+		const uint32 stride = out.padded_size();
+		const pose_float weight(clamp01(t));
+
+		for (uint32 offset = 0; offset < stride; offset += pose_lanes)
+		{
+			const pose_trs a = load_trs(from.streams.data(), stride, offset);
+			const pose_trs b = load_trs(to.streams.data(), stride, offset);
+
+			pose_trs result;
+			result.position = lerp(a.position, b.position, weight);
+			result.rotation = slerp_shortest_approx(a.rotation, b.rotation, weight);
+			result.scale = lerp(a.scale, b.scale, weight);
+			store_trs(result, out.streams.data(), stride, offset);
+		}
+	}
+
+	void SoaPoseUtils::blend_masked(const SoaSkeletonPose& from, const SoaSkeletonPose& to, const float* joint_weights, SoaSkeletonPose& out)
+	{
+		ASSERT(from.size() == to.size() && from.size() == out.size());
+		ASSERT(joint_weights != nullptr);
+
+		const uint32 stride = out.padded_size();
+
+		for (uint32 offset = 0; offset < stride; offset += pose_lanes)
+		{
+			const pose_float weight = clamp01(load_weights(joint_weights, offset, out.size()));
+
+			const pose_trs a = load_trs(from.streams.data(), stride, offset);
+			const pose_trs b = load_trs(to.streams.data(), stride, offset);
+
+			pose_trs result;
+			result.position = lerp(a.position, b.position, weight);
+			result.rotation = nlerp_shortest(a.rotation, b.rotation, weight);
+			result.scale = lerp(a.scale, b.scale, weight);
+			store_trs(result, out.streams.data(), stride, offset);
+		}
+	}
+
+	void SoaPoseUtils::make_additive(const SoaSkeletonPose& pose, const SoaSkeletonPose& reference, SoaSkeletonPose& out_additive)
+	{
+		ASSERT(pose.size() == reference.size() && pose.size() == out_additive.size());
+
+		const uint32 stride = out_additive.padded_size();
+
+		for (uint32 offset = 0; offset < stride; offset += pose_lanes)
+		{
+			const pose_trs p = load_trs(pose.streams.data(), stride, offset);
+			const pose_trs r = load_trs(reference.streams.data(), stride, offset);
+
+			pose_trs result;
+			result.position = p.position - r.position;
+			result.rotation = conjugate(r.rotation) * p.rotation;
+			result.scale = p.scale / r.scale;
+			store_trs(result, out_additive.streams.data(), stride, offset);
+		}
+	}
+
+	void SoaPoseUtils::apply_additive(const SoaSkeletonPose& base, const SoaSkeletonPose& additive, float weight, SoaSkeletonPose& out,
+		const float* joint_weights)
+	{
+		ASSERT(base.size() == additive.size() && base.size() == out.size());
+
+		const uint32 stride = out.padded_size();
+		const pose_quat identity = pose_quat::identity();
+		const pose_vec3 one(pose_float(1.f));
+
+		for (uint32 offset = 0; offset < stride; offset += pose_lanes)
+		{
+			pose_float w(weight);
+			if (joint_weights)
+			{
+				w = w * load_weights(joint_weights, offset, out.size());
+			}
+
+			const pose_trs b = load_trs(base.streams.data(), stride, offset);
+			const pose_trs a = load_trs(additive.streams.data(), stride, offset);
+
+			pose_trs result;
+			result.position = fmadd(a.position, pose_vec3(w), b.position);
+			result.rotation = b.rotation * nlerp_shortest(identity, a.rotation, w);
+			result.scale = b.scale * lerp(one, a.scale, w);
+			store_trs(result, out.streams.data(), stride, offset);
+		}
+	}
+
+	void SoaPoseUtils::get_local_matrices(const SoaSkeletonPose& pose, mat4* out_matrices)
+	{
+		const uint32 stride = pose.padded_size();
+
+		uint32 joints[pose_lanes];
+		for (uint32 offset = 0; offset < stride; offset += pose_lanes)
+		{
+			for (uint32 lane = 0; lane < pose_lanes; ++lane)
+			{
+				joints[lane] = (offset + lane < pose.size()) ? offset + lane : INVALID_JOINT;
+			}
+
+			store_matrices(to_mat4(load_trs(pose.streams.data(), stride, offset)), joints, out_matrices);
+		}
+	}
+
+	void SoaPoseUtils::get_skinning_matrices(const SoaSkeletonHierarchy& hierarchy, const SoaSkeletonPose& local_pose,
+		trs* out_global_transforms, mat4* out_skinning_matrices, const trs& world_transform)
+	{
+		ASSERT(hierarchy.size() == local_pose.size());
+
+		const uint32 num_slots = hierarchy.num_slots;
+		const uint32 local_stride = local_pose.padded_size();
+
+		// Model space transforms in slot order, plus one group holding the world transform that the roots read.
+		const uint32 model_stride = num_slots + SOA_POSE_LANES;
+		float* model_streams = (float*)alloca(sizeof(float) * soa_pose_stream_count * model_stride);
+
+		const float world_values[soa_pose_stream_count] = {
+			world_transform.position.x, world_transform.position.y, world_transform.position.z,
+			world_transform.rotation.x, world_transform.rotation.y, world_transform.rotation.z, world_transform.rotation.w,
+			world_transform.scale.x, world_transform.scale.y, world_transform.scale.z };
+		for (uint32 stream = 0; stream < soa_pose_stream_count; ++stream)
+		{
+			model_streams[stream * model_stride + num_slots] = world_values[stream];
+		}
+
+		for (uint32 offset = 0; offset < num_slots; offset += pose_lanes)
+		{
+			const pose_trs local = gather_trs(local_pose.streams.data(), local_stride, load_indices(hierarchy.slot_gather_indices.data() + offset));
+			const pose_trs parent = gather_trs(model_streams, model_stride, load_indices(hierarchy.slot_parents.data() + offset));
+
+			const pose_trs global = multiply(parent, local);
+			store_trs(global, model_streams, model_stride, offset);
+
+			pose_mat4 inv_bind;
+			for (uint32 i = 0; i < 16; ++i)
+			{
+				inv_bind.m[i] = pose_float(hierarchy.inv_bind_streams.data() + i * num_slots + offset);
+			}
+
+			const uint32* joints = hierarchy.slot_joints.data() + offset;
+			store_matrices(to_mat4(global) * inv_bind, joints, out_skinning_matrices);
+
+			if (out_global_transforms)
+			{
+				store_transforms(global, joints, out_global_transforms);
+			}
+		}
+	}
+}
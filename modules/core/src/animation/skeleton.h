@@ -140,6 +140,7 @@ namespace era_engine::animation
 		void analyze_joints(const vec3* positions, const void* others, uint32 other_stride, uint32 num_vertices);
 
 		void blend_local_transforms(const trs* local_transforms1, const trs* local_transforms2, float t, trs* out_blended_local_transforms) const;
+		void get_global_transforms_from_local_transforms(trs* out_global_transforms, const trs& world_transform = trs::identity) const;
 		void get_skinning_matrices_from_local_transforms(mat4* out_skinning_matrices, const trs& world_transform = trs::identity) const;
 		void get_skinning_matrices_from_local_transforms(trs* out_global_transforms, mat4* out_skinning_matrices, const trs& world_transform = trs::identity) const;
 		void get_skinning_matrices_from_global_transforms(const trs* global_transforms, mat4* out_skinning_matrices) const;
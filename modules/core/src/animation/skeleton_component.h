@@ -13,7 +13,7 @@ namespace era_engine::animation
 	class ERA_CORE_API SkeletonComponent : public Component
 	{
 	public:
-		SkeletonComponent(ref<Entity::EcsData> _data);
+		SkeletonComponent(Entity::EcsData* _data);
 		~SkeletonComponent() override;
 
 		SkeletonPose get_current_pose() const;
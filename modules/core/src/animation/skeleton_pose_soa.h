@@ -0,0 +1,118 @@
+#pragma once
+
+#include "core_api.h"
+
+#include "animation/skeleton.h"
+
+namespace era_engine::animation
+{
+	// Joints are processed in groups of this many, all SoA buffers are padded to a multiple of it.
+	static constexpr uint32 SOA_POSE_LANES = 8;
+
+	enum soa_pose_stream
+	{
+		soa_pose_position_x, soa_pose_position_y, soa_pose_position_z,
+		soa_pose_rotation_x, soa_pose_rotation_y, soa_pose_rotation_z, soa_pose_rotation_w,
+		soa_pose_scale_x, soa_pose_scale_y, soa_pose_scale_z,
+
+		soa_pose_stream_count,
+	};
+
+	// Local joint transforms as ten float streams (position xyz, rotation xyzw, scale xyz) instead of an array of trs.
+	// Padding joints hold the identity transform, so kernels never need a scalar tail.
+	class ERA_CORE_API SoaSkeletonPose
+	{
+	public:
+		SoaSkeletonPose() = default;
+		SoaSkeletonPose(uint32 joints_size);
+
+		void resize(uint32 joints_size);
+
+		uint32 size() const;
+		uint32 padded_size() const;
+
+		void set_joint_transform(const trs& transform, uint32 joint_id);
+		trs get_joint_transform(uint32 joint_id) const;
+
+		// Conversion from and to the array-of-structures representations. Sizes have to match.
+		void load(const SkeletonPose& pose);
+		void load(const std::vector<JointTransform>& transforms);
+		void store(SkeletonPose& out_pose) const;
+		void store(trs* out_transforms) const;
+
+		// padded_size() floats of one component.
+		float* get_stream(soa_pose_stream stream);
+		const float* get_stream(soa_pose_stream stream) const;
+
+	private:
+		std::vector<float> streams;
+
+		uint32 joints_size = 0;
+		uint32 padded_joints_size = 0;
+
+		friend class SoaPoseUtils;
+	};
+
+	// Order in which the SIMD hierarchy walk visits the joints of a skeleton. Joints are sorted by depth and packed into
+	// groups of SOA_POSE_LANES that never contain a joint together with its parent, so every group only reads parents
+	// computed by earlier groups. Built once per skeleton, it doesn't depend on the pose.
+	class ERA_CORE_API SoaSkeletonHierarchy
+	{
+	public:
+		SoaSkeletonHierarchy() = default;
+		SoaSkeletonHierarchy(const Skeleton& skeleton);
+
+		void build(const Skeleton& skeleton);
+
+		uint32 size() const;
+
+		// Group lanes that don't hold a joint, as a share of all lanes.
+		float get_padding_ratio() const;
+
+	private:
+		uint32 joints_size = 0;
+		uint32 num_slots = 0;
+
+		// Per slot (group * SOA_POSE_LANES + lane). Padding slots have INVALID_JOINT as joint and read joint 0.
+		std::vector<uint32> slot_joints;
+		std::vector<int32> slot_gather_indices;
+
+		// Slot of the parent, roots read the world transform from slot 'num_slots'.
+		std::vector<int32> slot_parents;
+
+		// Inverse bind matrices in slot order, 16 streams of 'num_slots' floats.
+		std::vector<float> inv_bind_streams;
+
+		friend class SoaPoseUtils;
+	};
+
+	// 8-wide pose kernels. All of them work in place, so 'out' may alias an input.
+	class ERA_CORE_API SoaPoseUtils final
+	{
+		SoaPoseUtils() = delete;
+
+	public:
+		// Blends rotations along the shorter arc. nlerp is enough for close poses, slerp keeps the angular velocity constant
+		// (it uses the polynomial approximation from slerp_shortest_approx).
+		static void blend_nlerp(const SoaSkeletonPose& from, const SoaSkeletonPose& to, float t, SoaSkeletonPose& out);
+		static void blend_slerp(const SoaSkeletonPose& from, const SoaSkeletonPose& to, float t, SoaSkeletonPose& out);
+
+		// Like blend_nlerp with one weight per joint ('joint_weights' has size() entries).
+		static void blend_masked(const SoaSkeletonPose& from, const SoaSkeletonPose& to, const float* joint_weights, SoaSkeletonPose& out);
+
+		// Difference of 'pose' to 'reference', such that apply_additive(reference, difference, 1) gives 'pose' back.
+		static void make_additive(const SoaSkeletonPose& pose, const SoaSkeletonPose& reference, SoaSkeletonPose& out_additive);
+
+		// Layers 'additive' on top of 'base', scaled by 'weight' (and the optional per joint weights).
+		static void apply_additive(const SoaSkeletonPose& base, const SoaSkeletonPose& additive, float weight, SoaSkeletonPose& out,
+			const float* joint_weights = nullptr);
+
+		// trs_to_mat4 for every joint of the pose.
+		static void get_local_matrices(const SoaSkeletonPose& pose, mat4* out_matrices);
+
+		// Same results as Skeleton::get_skinning_matrices_from_local_transforms, up to floating point rounding.
+		// 'out_global_transforms' may be null.
+		static void get_skinning_matrices(const SoaSkeletonHierarchy& hierarchy, const SoaSkeletonPose& local_pose,
+			trs* out_global_transforms, mat4* out_skinning_matrices, const trs& world_transform = trs::identity);
+	};
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include "core_api.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace era_engine
+{
+	struct AssetManifestEntry
+	{
+		// Cheap fingerprint of the source file. If it matches, the asset is skipped without reading the file.
+		uint64 source_size = 0;
+		int64 source_write_time = 0;
+
+		// What the cached BIN was built from. Only these decide whether the asset has to be recompiled.
+		uint64 content_hash = 0;
+		uint32 importer_version = 0;
+		uint32 mesh_flags = 0;
+	};
+
+	// Maps source paths (as passed to get_model_cache_path) to what their cached BIN was built from.
+	// Stored as one tab separated line per asset, so the file stays diffable. Used by the assets compiler.
+	class ERA_CORE_API AssetManifest
+	{
+	public:
+		// A missing or unreadable manifest just means everything gets rebuilt.
+		void load(const fs::path& path);
+
+		// Writes to a temporary file first and renames it, so an interrupted run never leaves a truncated manifest.
+		bool save(const fs::path& path) const;
+
+		const AssetManifestEntry* find(const std::string& key) const;
+		void set(const std::string& key, const AssetManifestEntry& entry);
+
+		// Whether the cache of 'key' was built by the current importer with these mesh flags. Otherwise it has to be rebuilt,
+		// whatever the source looks like.
+		bool is_cache_current(const std::string& key, uint32 mesh_flags) const;
+
+		// Current cache of a source with the same size and write time. Such sources are skipped without being read.
+		bool is_up_to_date(const std::string& key, uint32 mesh_flags, uint64 source_size, int64 source_write_time) const;
+
+		// Current cache of a source with the same content, e.g. one that was only touched.
+		bool is_unchanged(const std::string& key, uint32 mesh_flags, uint64 content_hash) const;
+
+		uint64 size() const { return entries.size(); }
+
+	private:
+		std::unordered_map<std::string, AssetManifestEntry> entries;
+	};
+}
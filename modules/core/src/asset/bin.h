@@ -6,9 +6,17 @@ namespace era_engine
 {
 	struct ModelAsset;
 
-	ERA_CORE_API void writeBIN(const ModelAsset& asset, const fs::path& path);
+	// Bump whenever the output of loadFBX/loadOBJ or writeBIN changes, so the assets_compiler rebuilds its cache.
+	static constexpr uint32 model_importer_version = 2;
 
-	ERA_CORE_API ModelAsset loadFBX(const fs::path& path, uint32 flags);
+	// Writes the current (v2) format. Vertex and index streams are compressed individually if that pays off.
+	ERA_CORE_API void writeBIN(const ModelAsset& asset, const fs::path& path, bool compress = true);
+
+	// With 'parallel' set, node parsing, object decoding, mesh finishing and animation resampling run on the high priority job queue.
+	// The result is identical to the serial import.
+	ERA_CORE_API ModelAsset loadFBX(const fs::path& path, uint32 flags, bool parallel = true);
 	ERA_CORE_API ModelAsset loadOBJ(const fs::path& path, uint32 flags);
-	ERA_CORE_API ModelAsset loadBIN(const fs::path& path);
+	
+	// Loads v1 and v2 files. For v2 only the streams selected by 'mesh_flags' (mesh_flag_load_*) are decoded, in parallel.
+	ERA_CORE_API ModelAsset loadBIN(const fs::path& path, uint32 mesh_flags = UINT32_MAX);
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include "core_api.h"
+
+namespace era_engine
+{
+	// LZ4-style byte-oriented LZ77 block codec for asset streams. Fast to decode, moderate ratio.
+	// The format is self-contained (no frame, no dictionary): the caller stores compressed and uncompressed sizes.
+
+	NODISCARD inline uint64 lz_compress_bound(uint64 size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	// Returns the compressed size. 'output' needs room for lz_compress_bound(size) bytes.
+	ERA_CORE_API uint64 lz_compress(const uint8* input, uint64 size, uint8* output);
+
+	// Bounds-checked against both buffers. Returns false on malformed input or if the result isn't exactly 'size' bytes.
+	ERA_CORE_API bool lz_decompress(const uint8* input, uint64 compressed_size, uint8* output, uint64 size);
+
+	// Byte transposition for arrays of 'width'-byte lanes (e.g. 4 for float streams): all first bytes, then all second bytes...
+	// Similar bytes end up next to each other, which makes float data much more compressible. Sizes must be a multiple of 'width'.
+	ERA_CORE_API void shuffle_bytes(const uint8* input, uint64 size, uint32 width, uint8* output);
+	ERA_CORE_API void unshuffle_bytes(const uint8* input, uint64 size, uint32 width, uint8* output);
+}
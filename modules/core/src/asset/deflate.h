@@ -2,7 +2,14 @@
 
 #pragma once
 
+#include "core_api.h"
+
 namespace era_engine
 {
-	uint64 decompress(uint8* data, uint64 compressed_size, uint8* output);
-}
\ No newline at end of file
+	static constexpr uint64 inflate_error = UINT64_MAX;
+
+	// Inflates a zlib stream (e.g. FBX array properties) into 'output'.
+	// Returns the number of bytes written, or inflate_error if the stream is malformed, truncated or doesn't fit into 'output_size' bytes.
+	// Reads and writes never leave the given buffers, whatever the input.
+	ERA_CORE_API uint64 decompress(const uint8* data, uint64 compressed_size, uint8* output, uint64 output_size);
+}
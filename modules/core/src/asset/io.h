@@ -6,15 +6,16 @@
 
 #include <istream>
 #include <ostream>
+#include <span>
 
 namespace era_engine
 {
 	struct ERA_CORE_API EntireFile
 	{
 		template <typename T>
-		T* consume(uint32 count = 1)
+		T* consume(uint64 count = 1)
 		{
-			uint32 readSize = sizeof(T) * count;
+			uint64 readSize = sizeof(T) * count;
 			if (readSize > size - read_offset)
 			{
 				return 0;
@@ -25,14 +26,39 @@ namespace era_engine
 			return result;
 		}
 
-		uint8* content;
-		uint64 size;
-		uint64 read_offset;
+		// Same as consume(), but as a view. For mapped files this points straight into the mapping.
+		template <typename T>
+		std::span<const T> consume_span(uint64 count)
+		{
+			const T* result = consume<T>(count);
+			return result ? std::span<const T>(result, count) : std::span<const T>();
+		}
+
+		uint8* content = nullptr;
+		uint64 size = 0;
+		uint64 read_offset = 0;
+
+		// Set if 'content' is a read-only view of the file (see map_file) instead of a heap copy.
+		bool is_mapped = false;
 	};
 
-	EntireFile load_file(const fs::path& path);
+	enum class FileAccessHint : uint8
+	{
+		// Parsed front to back: read ahead aggressively and start paging the whole file in right away.
+		Sequential,
+
+		// Only parts of the file are touched (e.g. via a table of contents): no read-ahead.
+		Random,
+	};
+
+	// Copies the whole file into heap memory.
+	ERA_CORE_API EntireFile load_file(const fs::path& path);
+
+	// Maps the file read-only, so nothing is copied and pages are only read when touched.
+	// The contents must not be written to and are not null terminated past 'size'. Falls back to load_file if mapping fails.
+	ERA_CORE_API EntireFile map_file(const fs::path& path, FileAccessHint hint = FileAccessHint::Sequential);
 
-	void free_file(const EntireFile& file);
+	ERA_CORE_API void free_file(const EntireFile& file);
 
 	struct ERA_CORE_API sized_string
 	{
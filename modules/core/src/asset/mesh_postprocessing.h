@@ -53,29 +53,65 @@ namespace std
 
 namespace era_engine
 {
+	// Open addressing (linear probing) map from full vertices to their index in the submesh being built.
+	// Unlike std::unordered_map it doesn't allocate per entry and compares hashes before touching the vertices.
+	struct ERA_CORE_API vertex_weld_table
+	{
+		struct find_result
+		{
+			uint32 index;
+			bool inserted;
+		};
+
+		// Returns the index of 'vertex'. If it isn't known yet, it gets the next free index (the current size).
+		find_result find_or_insert(const full_vertex& vertex);
+
+		void clear();
+		uint32 size() const { return (uint32)vertices.size(); }
+
+	private:
+		struct slot
+		{
+			uint32 hash;
+			uint32 index; // UINT32_MAX if empty.
+		};
+
+		void grow();
+
+		std::vector<slot> slots;
+		std::vector<full_vertex> vertices;
+	};
+
 	struct ERA_CORE_API per_material
 	{
+		// Triangulates the face as a fan and welds its vertices with the ones already in 'sub'.
+		// Switches 'sub' to 32-bit indices once it has more vertices than 16-bit indices can address.
 		void addTriangles(const std::vector<vec3>& positions, const std::vector<vec2>& uvs, const std::vector<vec3>& normals,
 			const std::vector<vec3>& tangents, const std::vector<uint32>& colors, const std::vector<animation::SkinningWeights>& skins,
-			int32 firstIndex, int32 faceSize, std::vector<SubmeshAsset>& outSubmeshes);
+			int32 firstIndex, int32 faceSize);
 
 		void flush(std::vector<SubmeshAsset>& outSubmeshes);
 
-		std::unordered_map<full_vertex, uint16> vertexToIndex;
+		vertex_weld_table vertexToIndex;
 		SubmeshAsset sub;
 
 	private:
-		struct add_vertex_result
-		{
-			uint16 index;
-			bool success;
-		};
-
-		add_vertex_result addVertex(const std::vector<vec3>& positions, const std::vector<vec2>& uvs, const std::vector<vec3>& normals,
+		uint32 addVertex(const std::vector<vec3>& positions, const std::vector<vec2>& uvs, const std::vector<vec3>& normals,
 			const std::vector<vec3>& tangents, const std::vector<uint32>& colors, const std::vector<animation::SkinningWeights>& skins,
 			int32 index);
+
+		void pushTriangle(uint32 a, uint32 b, uint32 c);
 	};
 
+	// Generates missing normals and tangents (see mesh_flag_gen_*). Submeshes are processed in parallel on the high priority job queue,
+	// large ones are split further. Per vertex sums are gathered through a vertex to triangle adjacency, so no two jobs write the same vertex.
 	ERA_CORE_API void generateNormalsAndTangents(std::vector<SubmeshAsset>& submeshes, uint32 flags);
 	ERA_CORE_API void generateNormalsAndTangents(ref<SubmeshAsset> submesh, uint32 flags);
-}
\ No newline at end of file
+
+	// Reorders triangles for the post transform vertex cache (Forsyth's linear speed algorithm) and then vertices by first use.
+	// The mesh itself is unchanged, only the order of its triangles and vertices.
+	ERA_CORE_API void optimizeVertexCache(SubmeshAsset& submesh);
+
+	// Import time processing of freshly welded submeshes: generateNormalsAndTangents and optimizeVertexCache, in parallel per submesh.
+	ERA_CORE_API void postprocessSubmeshes(std::vector<SubmeshAsset>& submeshes, uint32 flags);
+}
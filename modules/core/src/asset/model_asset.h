@@ -45,7 +45,25 @@ namespace era_engine
 		std::vector<uint32> colors;
 		std::vector<animation::SkinningWeights> skin;
 
+		// At most one of these is filled. 32-bit indices are only used if the submesh has more than 65536 vertices.
 		std::vector<indexed_triangle16> triangles;
+		std::vector<indexed_triangle32> triangles32;
+
+		// Read from whichever of the two index arrays is filled.
+		uint32 get_num_triangles() const
+		{
+			return (uint32)(triangles.size() + triangles32.size());
+		}
+
+		indexed_triangle32 get_triangle(uint32 index) const
+		{
+			if (!triangles32.empty())
+			{
+				return triangles32[index];
+			}
+			const indexed_triangle16& triangle = triangles[index];
+			return indexed_triangle32{ triangle.a, triangle.b, triangle.c };
+		}
 	};
 
 	struct ERA_CORE_API MeshAsset
@@ -83,6 +101,9 @@ namespace era_engine
 		mesh_flag_load_colors | mesh_flag_load_skin,
 	};
 
+	// Where load_3d_model_from_file and the assets_compiler keep the BIN version of 'path'. Absolute paths are mapped into the cache as well.
+	ERA_CORE_API fs::path get_model_cache_path(const fs::path& path, uint32 mesh_flags);
+
 	ERA_CORE_API ModelAsset load_3d_model_from_file(const fs::path& path, uint32 mesh_flags = mesh_flag_default);
 
 	inline bool is_mesh_extension(const fs::path& extension)
@@ -0,0 +1,135 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "asset/asset_manifest.h"
+#include "asset/bin.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace era_engine
+{
+	static constexpr const char* manifest_header = "era_asset_manifest 1";
+
+	void AssetManifest::load(const fs::path& path)
+	{
+		entries.clear();
+
+		std::ifstream input(path);
+		if (!input)
+		{
+			return;
+		}
+
+		std::string line;
+		if (!std::getline(input, line) || line != manifest_header)
+		{
+			return;
+		}
+
+		while (std::getline(input, line))
+		{
+			// The key comes last, so paths containing spaces survive.
+			std::istringstream stream(line);
+
+			AssetManifestEntry entry;
+			stream >> std::hex >> entry.content_hash >> std::dec
+				>> entry.importer_version >> entry.mesh_flags
+				>> entry.source_size >> entry.source_write_time;
+
+			if (!stream || stream.get() != '\t')
+			{
+				continue;
+			}
+
+			std::string key;
+			std::getline(stream, key);
+			if (!key.empty())
+			{
+				entries[key] = entry;
+			}
+		}
+	}
+
+	bool AssetManifest::save(const fs::path& path) const
+	{
+		std::vector<const std::pair<const std::string, AssetManifestEntry>*> sorted;
+		sorted.reserve(entries.size());
+		for (const auto& it : entries)
+		{
+			sorted.push_back(&it);
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+		fs::path temp_path = path;
+		temp_path += ".tmp";
+
+		if (path.has_parent_path())
+		{
+			fs::create_directories(path.parent_path());
+		}
+
+		{
+			std::ofstream output(temp_path, std::ios::trunc);
+			if (!output)
+			{
+				return false;
+			}
+
+			output << manifest_header << '\n';
+			for (const auto* it : sorted)
+			{
+				const AssetManifestEntry& entry = it->second;
+				output << std::hex << entry.content_hash << std::dec
+					<< ' ' << entry.importer_version << ' ' << entry.mesh_flags
+					<< ' ' << entry.source_size << ' ' << entry.source_write_time
+					<< '\t' << it->first << '\n';
+			}
+
+			if (!output.flush())
+			{
+				return false;
+			}
+		}
+
+		std::error_code error;
+		fs::rename(temp_path, path, error);
+		return !error;
+	}
+
+	const AssetManifestEntry* AssetManifest::find(const std::string& key) const
+	{
+		auto it = entries.find(key);
+		return it != entries.end() ? &it->second : nullptr;
+	}
+
+	void AssetManifest::set(const std::string& key, const AssetManifestEntry& entry)
+	{
+		entries[key] = entry;
+	}
+
+	bool AssetManifest::is_cache_current(const std::string& key, uint32 mesh_flags) const
+	{
+		const AssetManifestEntry* entry = find(key);
+		return entry != nullptr
+			&& entry->importer_version == model_importer_version
+			&& entry->mesh_flags == mesh_flags;
+	}
+
+	bool AssetManifest::is_up_to_date(const std::string& key, uint32 mesh_flags, uint64 source_size, int64 source_write_time) const
+	{
+		if (!is_cache_current(key, mesh_flags))
+		{
+			return false;
+		}
+
+		const AssetManifestEntry* entry = find(key);
+		return entry->source_size == source_size && entry->source_write_time == source_write_time;
+	}
+
+	bool AssetManifest::is_unchanged(const std::string& key, uint32 mesh_flags, uint64 content_hash) const
+	{
+		return is_cache_current(key, mesh_flags) && find(key)->content_hash == content_hash;
+	}
+}
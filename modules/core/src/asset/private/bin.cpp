@@ -5,11 +5,19 @@
 #include "asset/model_asset.h"
 #include "asset/asset.h"
 #include "asset/io.h"
+#include "asset/block_compression.h"
 
 #include "core/cpu_profiling.h"
+#include "core/job_system.h"
+#include "core/hash.h"
+#include "core/log.h"
+#include "core/memory.h"
 
 #include "rendering/pbr_material.h"
 
+#include <algorithm>
+#include <tuple>
+
 //#define PROFILE(name) CPU_PRINT_PROFILE_BLOCK(name)
 #define PROFILE(name) 
 
@@ -74,21 +82,120 @@ namespace era_engine
 		uint32 nameLength;
 	};
 
+	// Version 2 layout, every section starts at a multiple of bin_section_alignment:
+	//   bin_header_v2
+	//   metadata:      per mesh bin_mesh_header, name and bin_submesh_headers, then materials, skeletons and animations as in v1
+	//   stream table:  bin_stream_entry[numStreams]
+	//   stream data:   one block per vertex/index stream, optionally compressed
+	// Streams can be located, skipped and decoded independently of each other.
+	static constexpr uint32 bin_version_1 = 1;
+	static constexpr uint32 bin_version_2 = 2;
+
+	static constexpr uint64 bin_section_alignment = 64;
+
+	struct bin_header_v2
+	{
+		BinaryHeader header;
+		uint32 flags;
+		uint32 numMeshes;
+		uint32 numMaterials;
+		uint32 numSkeletons;
+		uint32 numAnimations;
+		uint32 numStreams;
+
+		uint64 metadataOffset;
+		uint64 metadataSize;
+		uint64 streamTableOffset;
+
+		// Over metadata and stream table. Every stream has its own checksum.
+		uint64 checksum;
+	};
+
+	enum bin_stream_type : uint16
+	{
+		bin_stream_positions,
+		bin_stream_uvs,
+		bin_stream_normals,
+		bin_stream_tangents,
+		bin_stream_colors,
+		bin_stream_skin,
+		bin_stream_triangles,
+		bin_stream_triangles32,
+
+		bin_stream_count,
+	};
+
+	enum bin_compression : uint8
+	{
+		bin_compression_none,
+		bin_compression_lz,
+	};
+
+	struct bin_stream_entry
+	{
+		uint32 meshIndex;
+		uint32 submeshIndex;
+		uint16 type;
+		uint8 compression;
+
+		// Lane width of the byte shuffle applied before compression. 1 means not shuffled.
+		uint8 shuffleWidth;
+		uint32 reserved;
+
+		uint64 offset;
+		uint64 storedSize;
+		uint64 size;
+
+		// Of the decoded data.
+		uint64 checksum;
+	};
+
+	// Streams smaller than this, or that don't shrink by at least 1/8, are stored uncompressed.
+	static constexpr uint64 bin_min_compression_size = 256;
+
+	struct bin_buffer
+	{
+		void write(const void* ptr, uint64 size, uint64 count)
+		{
+			const uint8* bytes = (const uint8*)ptr;
+			data.insert(data.end(), bytes, bytes + size * count);
+		}
+
+		void align(uint64 alignment)
+		{
+			data.resize(align_to((uint64)data.size(), alignment), 0);
+		}
+
+		std::vector<uint8> data;
+	};
+
 	template <typename T>
-	static void writeArray(const std::vector<T>& in, FILE* file)
+	static void writeArray(const std::vector<T>& in, bin_buffer& out)
 	{
-		fwrite(in.data(), sizeof(T), in.size(), file);
+		out.write(in.data(), sizeof(T), in.size());
 	}
 
-	static void writeMesh(const MeshAsset& mesh, FILE* file)
+	static uint32 getSubmeshFlags(const SubmeshAsset& in)
+	{
+		uint32 flags = 0;
+		if (!in.positions.empty()) { flags |= bin_submesh_flag_positions; }
+		if (!in.uvs.empty()) { flags |= bin_submesh_flag_uvs; }
+		if (!in.normals.empty()) { flags |= bin_submesh_flag_normals; }
+		if (!in.tangents.empty()) { flags |= bin_submesh_flag_tangents; }
+		if (!in.colors.empty()) { flags |= bin_submesh_flag_colors; }
+		if (!in.skin.empty()) { flags |= bin_submesh_flag_skin; }
+		return flags;
+	}
+
+	static void writeMeshDescription(const MeshAsset& mesh, bin_buffer& out)
 	{
 		bin_mesh_header header;
 		header.skeletonIndex = mesh.skeleton_index;
 		header.numSubmeshes = (uint32)mesh.submeshes.size();
 		header.nameLength = (uint32)mesh.name.length();
 
-		fwrite(&header, sizeof(header), 1, file);
-		fwrite(mesh.name.c_str(), sizeof(char), header.nameLength, file);
+		out.write(&header, sizeof(header), 1);
+		out.write(mesh.name.c_str(), sizeof(char), header.nameLength);
 
 		for (uint32 i = 0; i < header.numSubmeshes; ++i)
 		{
@@ -97,29 +204,76 @@ namespace era_engine
 			bin_submesh_header subHeader;
 			subHeader.materialIndex = in.material_index;
 			subHeader.numVertices = (uint32)in.positions.size();
-			subHeader.numTriangles = (uint32)in.triangles.size();
-
-			subHeader.flags = 0;
-			if (!in.positions.empty()) { subHeader.flags |= bin_submesh_flag_positions; }
-			if (!in.uvs.empty()) { subHeader.flags |= bin_submesh_flag_uvs; }
-			if (!in.normals.empty()) { subHeader.flags |= bin_submesh_flag_normals; }
-			if (!in.tangents.empty()) { subHeader.flags |= bin_submesh_flag_tangents; }
-			if (!in.colors.empty()) { subHeader.flags |= bin_submesh_flag_colors; }
-			if (!in.skin.empty()) { subHeader.flags |= bin_submesh_flag_skin; }
-
-			fwrite(&subHeader, sizeof(bin_submesh_header), 1, file);
-
-			if (!in.positions.empty()) { writeArray(in.positions, file); }
-			if (!in.uvs.empty()) { writeArray(in.uvs, file); }
-			if (!in.normals.empty()) { writeArray(in.normals, file); }
-			if (!in.tangents.empty()) { writeArray(in.tangents, file); }
-			if (!in.colors.empty()) { writeArray(in.colors, file); }
-			if (!in.skin.empty()) { writeArray(in.skin, file); }
-			writeArray(in.triangles, file);
+			subHeader.numTriangles = in.get_num_triangles();
+			subHeader.flags = getSubmeshFlags(in);
+
+			out.write(&subHeader, sizeof(bin_submesh_header), 1);
 		}
 	}
 
-	static void writeMaterial(const PbrMaterialDesc& material, FILE* file)
+	struct bin_stream_source
+	{
+		bin_stream_entry entry;
+		const uint8* data;
+
+		std::vector<uint8> stored;
+	};
+
+	template <typename T>
+	static void addStream(std::vector<bin_stream_source>& streams, uint32 meshIndex, uint32 submeshIndex, bin_stream_type type,
+		const std::vector<T>& data, uint8 shuffleWidth)
+	{
+		if (data.empty())
+		{
+			return;
+		}
+
+		bin_stream_source& source = streams.emplace_back();
+		source.entry = {};
+		source.entry.meshIndex = meshIndex;
+		source.entry.submeshIndex = submeshIndex;
+		source.entry.type = type;
+		source.entry.shuffleWidth = shuffleWidth;
+		source.entry.size = sizeof(T) * data.size();
+		source.data = (const uint8*)data.data();
+	}
+
+	static void encodeStream(bin_stream_source& source, bool compress)
+	{
+		bin_stream_entry& entry = source.entry;
+		entry.checksum = hash_bytes(source.data, entry.size);
+
+		if (compress && entry.size >= bin_min_compression_size)
+		{
+			const uint8* input = source.data;
+
+			std::vector<uint8> shuffled;
+			if (entry.shuffleWidth > 1)
+			{
+				shuffled.resize(entry.size);
+				shuffle_bytes(source.data, entry.size, entry.shuffleWidth, shuffled.data());
+				input = shuffled.data();
+			}
+
+			source.stored.resize(lz_compress_bound(entry.size));
+			const uint64 compressedSize = lz_compress(input, entry.size, source.stored.data());
+
+			if (compressedSize < entry.size - entry.size / 8)
+			{
+				source.stored.resize(compressedSize);
+				entry.compression = bin_compression_lz;
+				entry.storedSize = compressedSize;
+				return;
+			}
+		}
+
+		source.stored.clear();
+		entry.compression = bin_compression_none;
+		entry.shuffleWidth = 1;
+		entry.storedSize = entry.size;
+	}
+
+	static void writeMaterial(const PbrMaterialDesc& material, bin_buffer& out)
 	{
 		std::string albedo = material.albedo.string();
 		std::string normal = material.normal.string();
@@ -132,47 +286,47 @@ namespace era_engine
 		header.roughnessPathLength = (uint32)roughness.length();
 		header.metallicPathLength = (uint32)metallic.length();
 
-		fwrite(&header, sizeof(header), 1, file);
-		fwrite(albedo.c_str(), sizeof(char), header.albedoPathLength, file);
-		fwrite(normal.c_str(), sizeof(char), header.normalPathLength, file);
-		fwrite(roughness.c_str(), sizeof(char), header.roughnessPathLength, file);
-		fwrite(metallic.c_str(), sizeof(char), header.metallicPathLength, file);
-
-		fwrite(&material.albedo_flags, sizeof(uint32), 1, file);
-		fwrite(&material.normal_flags, sizeof(uint32), 1, file);
-		fwrite(&material.roughness_flags, sizeof(uint32), 1, file);
-		fwrite(&material.metallic_flags, sizeof(uint32), 1, file);
-
-		fwrite(&material.emission, sizeof(vec4), 1, file);
-		fwrite(&material.albedo_tint, sizeof(vec4), 1, file);
-		fwrite(&material.roughness_override, sizeof(float), 1, file);
-		fwrite(&material.metallic_override, sizeof(float), 1, file);
-		fwrite(&material.shader, sizeof(PbrMaterialShader), 1, file);
-		fwrite(&material.uv_scale, sizeof(float), 1, file);
-		fwrite(&material.translucency, sizeof(float), 1, file);
+		out.write(&header, sizeof(header), 1);
+		out.write(albedo.c_str(), sizeof(char), header.albedoPathLength);
+		out.write(normal.c_str(), sizeof(char), header.normalPathLength);
+		out.write(roughness.c_str(), sizeof(char), header.roughnessPathLength);
+		out.write(metallic.c_str(), sizeof(char), header.metallicPathLength);
+
+		out.write(&material.albedo_flags, sizeof(uint32), 1);
+		out.write(&material.normal_flags, sizeof(uint32), 1);
+		out.write(&material.roughness_flags, sizeof(uint32), 1);
+		out.write(&material.metallic_flags, sizeof(uint32), 1);
+
+		out.write(&material.emission, sizeof(vec4), 1);
+		out.write(&material.albedo_tint, sizeof(vec4), 1);
+		out.write(&material.roughness_override, sizeof(float), 1);
+		out.write(&material.metallic_override, sizeof(float), 1);
+		out.write(&material.shader, sizeof(PbrMaterialShader), 1);
+		out.write(&material.uv_scale, sizeof(float), 1);
+		out.write(&material.translucency, sizeof(float), 1);
 	}
 
-	static void writeSkeleton(const SkeletonAsset& skeleton, FILE* file)
+	static void writeSkeleton(const SkeletonAsset& skeleton, bin_buffer& out)
 	{
 		bin_skeleton_header header;
 		header.numJoints = (uint32)skeleton.joints.size();
 
-		fwrite(&header, sizeof(header), 1, file);
+		out.write(&header, sizeof(header), 1);
 
 		for (uint32 i = 0; i < header.numJoints; ++i)
 		{
 			uint32 nameLength = (uint32)skeleton.joints[i].name.length();
-			fwrite(&nameLength, sizeof(uint32), 1, file);
-			fwrite(skeleton.joints[i].name.c_str(), sizeof(char), nameLength, file);
-			fwrite(&skeleton.joints[i].limb_type, sizeof(era_engine::animation::LimbType), 1, file);
-			fwrite(&skeleton.joints[i].ik, sizeof(bool), 1, file);
-			fwrite(&skeleton.joints[i].inv_bind_transform, sizeof(mat4), 1, file);
-			fwrite(&skeleton.joints[i].bind_transform, sizeof(mat4), 1, file);
-			fwrite(&skeleton.joints[i].parent_id, sizeof(uint32), 1, file);
+			out.write(&nameLength, sizeof(uint32), 1);
+			out.write(skeleton.joints[i].name.c_str(), sizeof(char), nameLength);
+			out.write(&skeleton.joints[i].limb_type, sizeof(era_engine::animation::LimbType), 1);
+			out.write(&skeleton.joints[i].ik, sizeof(bool), 1);
+			out.write(&skeleton.joints[i].inv_bind_transform, sizeof(mat4), 1);
+			out.write(&skeleton.joints[i].bind_transform, sizeof(mat4), 1);
+			out.write(&skeleton.joints[i].parent_id, sizeof(uint32), 1);
 		}
 	}
 
-	static void writeAnimation(const AnimationAsset& animation, FILE* file)
+	static void writeAnimation(const AnimationAsset& animation, bin_buffer& out)
 	{
 		bin_animation_header header;
 		header.duration = animation.duration;
@@ -182,65 +336,128 @@ namespace era_engine
 		header.numScaleKeyframes = (uint32)animation.scale_keyframes.size();
 		header.nameLength = (uint32)animation.name.length();
 
-		fwrite(&header, sizeof(header), 1, file);
-		fwrite(animation.name.c_str(), sizeof(char), header.nameLength, file);
+		out.write(&header, sizeof(header), 1);
+		out.write(animation.name.c_str(), sizeof(char), header.nameLength);
 
 		for (auto& [name, joint] : animation.joints)
 		{
 			uint32 nameLength = (uint32)name.length();
-			fwrite(&nameLength, sizeof(uint32), 1, file);
-			fwrite(name.c_str(), sizeof(char), nameLength, file);
+			out.write(&nameLength, sizeof(uint32), 1);
+			out.write(name.c_str(), sizeof(char), nameLength);
 
-			fwrite(&joint, sizeof(animation::AnimationJoint), 1, file);
+			out.write(&joint, sizeof(animation::AnimationJoint), 1);
 		}
 
-		writeArray(animation.position_timestamps, file);
-		writeArray(animation.rotation_timestamps, file);
-		writeArray(animation.scale_timestamps, file);
-		writeArray(animation.position_keyframes, file);
-		writeArray(animation.rotation_keyframes, file);
-		writeArray(animation.scale_keyframes, file);
+		writeArray(animation.position_timestamps, out);
+		writeArray(animation.rotation_timestamps, out);
+		writeArray(animation.scale_timestamps, out);
+		writeArray(animation.position_keyframes, out);
+		writeArray(animation.rotation_keyframes, out);
+		writeArray(animation.scale_keyframes, out);
 	}
 
-	void writeBIN(const ModelAsset& asset, const fs::path& path)
+	void writeBIN(const ModelAsset& asset, const fs::path& path, bool compress)
 	{
-		FILE* file = fopen(path.string().c_str(), "wb");
+		bin_buffer metadata;
+		for (const MeshAsset& mesh : asset.meshes)
+		{
+			writeMeshDescription(mesh, metadata);
+		}
+		for (const PbrMaterialDesc& material : asset.materials)
+		{
+			writeMaterial(material, metadata);
+		}
+		for (const SkeletonAsset& skeleton : asset.skeletons)
+		{
+			writeSkeleton(skeleton, metadata);
+		}
+		for (const AnimationAsset& animation : asset.animations)
+		{
+			writeAnimation(animation, metadata);
+		}
 
-		bin_header header;
+		std::vector<bin_stream_source> streams;
+		for (uint32 meshIndex = 0; meshIndex < (uint32)asset.meshes.size(); ++meshIndex)
+		{
+			const MeshAsset& mesh = asset.meshes[meshIndex];
+			for (uint32 submeshIndex = 0; submeshIndex < (uint32)mesh.submeshes.size(); ++submeshIndex)
+			{
+				const SubmeshAsset& in = mesh.submeshes[submeshIndex];
+				addStream(streams, meshIndex, submeshIndex, bin_stream_positions, in.positions, sizeof(float));
+				addStream(streams, meshIndex, submeshIndex, bin_stream_uvs, in.uvs, sizeof(float));
+				addStream(streams, meshIndex, submeshIndex, bin_stream_normals, in.normals, sizeof(float));
+				addStream(streams, meshIndex, submeshIndex, bin_stream_tangents, in.tangents, sizeof(float));
+				addStream(streams, meshIndex, submeshIndex, bin_stream_colors, in.colors, sizeof(uint32));
+				addStream(streams, meshIndex, submeshIndex, bin_stream_skin, in.skin, sizeof(animation::SkinningWeights));
+				addStream(streams, meshIndex, submeshIndex, bin_stream_triangles, in.triangles, sizeof(uint16));
+				addStream(streams, meshIndex, submeshIndex, bin_stream_triangles32, in.triangles32, sizeof(uint32));
+			}
+		}
+
+		parallel_for(0, (uint32)streams.size(), 1, [&streams, compress](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				encodeStream(streams[i], compress);
+			}
+		});
+
+		bin_header_v2 header = {};
+		header.header.version = bin_version_2;
 		header.flags = asset.flags;
 		header.numMeshes = (uint32)asset.meshes.size();
 		header.numMaterials = (uint32)asset.materials.size();
 		header.numSkeletons = (uint32)asset.skeletons.size();
 		header.numAnimations = (uint32)asset.animations.size();
+		header.numStreams = (uint32)streams.size();
 
-		fwrite(&header, sizeof(header), 1, file);
+		header.metadataOffset = align_to((uint64)sizeof(bin_header_v2), bin_section_alignment);
+		header.metadataSize = metadata.data.size();
+		header.streamTableOffset = align_to(header.metadataOffset + header.metadataSize, bin_section_alignment);
 
-		for (uint32 i = 0; i < header.numMeshes; ++i)
-		{
-			writeMesh(asset.meshes[i], file);
-		}
-		for (uint32 i = 0; i < header.numMaterials; ++i)
+		uint64 offset = align_to(header.streamTableOffset + (uint64)(sizeof(bin_stream_entry) * streams.size()), bin_section_alignment);
+
+		std::vector<bin_stream_entry> table;
+		table.reserve(streams.size());
+		for (bin_stream_source& source : streams)
 		{
-			writeMaterial(asset.materials[i], file);
+			source.entry.offset = offset;
+			offset = align_to(offset + source.entry.storedSize, bin_section_alignment);
+			table.push_back(source.entry);
 		}
-		for (uint32 i = 0; i < header.numSkeletons; ++i)
+
+		header.checksum = hash_bytes(table.data(), sizeof(bin_stream_entry) * table.size(), hash_bytes(metadata.data.data(), metadata.data.size()));
+
+		bin_buffer out;
+		out.data.reserve(offset);
+		out.write(&header, sizeof(header), 1);
+		out.align(bin_section_alignment);
+		out.write(metadata.data.data(), 1, metadata.data.size());
+		out.align(bin_section_alignment);
+		out.write(table.data(), sizeof(bin_stream_entry), table.size());
+		for (const bin_stream_source& source : streams)
 		{
-			writeSkeleton(asset.skeletons[i], file);
+			out.align(bin_section_alignment);
+			ASSERT(out.data.size() == source.entry.offset);
+			out.write(source.stored.empty() ? source.data : source.stored.data(), 1, source.entry.storedSize);
 		}
-		for (uint32 i = 0; i < header.numAnimations; ++i)
+
+		FILE* file = fopen(path.string().c_str(), "wb");
+		if (!file)
 		{
-			writeAnimation(asset.animations[i], file);
+			LOG_ERROR("Cannot write '%s'", path.string().c_str());
+			return;
 		}
-
+		fwrite(out.data.data(), 1, out.data.size(), file);
 		fclose(file);
 	}
 
 	template <typename T>
 	static void readArray(EntireFile& file, std::vector<T>& out, uint32 count)
 	{
-		out.resize(count);
-		T* ptr = file.consume<T>(count);
-		memcpy(out.data(), ptr, sizeof(T) * count);
+		// Streams are stored exactly as laid out in memory, so this is the only copy out of the mapping.
+		std::span<const T> data = file.consume_span<T>(count);
+		out.assign(data.begin(), data.end());
 	}
 
 	static MeshAsset readMesh(EntireFile& file)
@@ -359,20 +576,12 @@ namespace era_engine
 		return result;
 	}
 
-	ModelAsset loadBIN(const fs::path& path)
+	static ModelAsset loadBINVersion1(EntireFile& file)
 	{
-		PROFILE("Loading BIN");
-
-		EntireFile file = load_file(path);
-
 		bin_header* header = file.consume<bin_header>();
-		if (header->header.header != BIN_HEADER)
-		{
-			free_file(file);
-			return {};
-		}
 
 		ModelAsset result;
+		result.flags = header->flags;
 		result.meshes.resize(header->numMeshes);
 		result.materials.resize(header->numMaterials);
 		result.skeletons.resize(header->numSkeletons);
@@ -395,8 +604,294 @@ namespace era_engine
 			result.animations[i] = readAnimation(file);
 		}
 
+		return result;
+	}
+
+	static MeshAsset readMeshDescription(EntireFile& file, std::vector<bin_submesh_header>& outSubmeshHeaders)
+	{
+		bin_mesh_header* header = file.consume<bin_mesh_header>();
+		char* name = file.consume<char>(header->nameLength);
+
+		MeshAsset result;
+		result.name = std::string(name, header->nameLength);
+		result.submeshes.resize(header->numSubmeshes);
+		result.skeleton_index = header->skeletonIndex;
+
+		for (uint32 i = 0; i < header->numSubmeshes; ++i)
+		{
+			bin_submesh_header* subHeader = file.consume<bin_submesh_header>();
+			result.submeshes[i].material_index = subHeader->materialIndex;
+			outSubmeshHeaders.push_back(*subHeader);
+		}
+
+		return result;
+	}
+
+	static bool isStreamRequested(uint16 type, uint32 meshFlags)
+	{
+		switch (type)
+		{
+		case bin_stream_uvs: return meshFlags & mesh_flag_load_uvs;
+		case bin_stream_normals: return meshFlags & mesh_flag_load_normals;
+		case bin_stream_tangents: return meshFlags & mesh_flag_load_tangents;
+		case bin_stream_colors: return meshFlags & mesh_flag_load_colors;
+		case bin_stream_skin: return meshFlags & mesh_flag_load_skin;
+		default: return true;
+		}
+	}
+
+	template <typename T>
+	static uint8* resizeStream(std::vector<T>& out, uint64 size)
+	{
+		if (size % sizeof(T) != 0)
+		{
+			return nullptr;
+		}
+		out.resize(size / sizeof(T));
+		return (uint8*)out.data();
+	}
+
+	static uint8* prepareStream(SubmeshAsset& submesh, uint16 type, uint64 size)
+	{
+		switch (type)
+		{
+		case bin_stream_positions: return resizeStream(submesh.positions, size);
+		case bin_stream_uvs: return resizeStream(submesh.uvs, size);
+		case bin_stream_normals: return resizeStream(submesh.normals, size);
+		case bin_stream_tangents: return resizeStream(submesh.tangents, size);
+		case bin_stream_colors: return resizeStream(submesh.colors, size);
+		case bin_stream_skin: return resizeStream(submesh.skin, size);
+		case bin_stream_triangles: return resizeStream(submesh.triangles, size);
+		case bin_stream_triangles32: return resizeStream(submesh.triangles32, size);
+		default: return nullptr;
+		}
+	}
+
+	static bool decodeStream(const EntireFile& file, const bin_stream_entry& entry, uint8* output)
+	{
+		if (entry.offset > file.size || entry.storedSize > file.size - entry.offset)
+		{
+			return false;
+		}
+
+		const uint8* stored = file.content + entry.offset;
+
+		if (entry.compression == bin_compression_none)
+		{
+			if (entry.storedSize != entry.size)
+			{
+				return false;
+			}
+			memcpy(output, stored, entry.size);
+		}
+		else if (entry.compression == bin_compression_lz)
+		{
+			if (entry.shuffleWidth > 1)
+			{
+				std::vector<uint8> shuffled(entry.size);
+				if (!lz_decompress(stored, entry.storedSize, shuffled.data(), entry.size))
+				{
+					return false;
+				}
+				unshuffle_bytes(shuffled.data(), entry.size, entry.shuffleWidth, output);
+			}
+			else if (!lz_decompress(stored, entry.storedSize, output, entry.size))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		return hash_bytes(output, entry.size) == entry.checksum;
+	}
+
+	// Checked before any stream is prepared: the destinations are sized up front and then written by the decode jobs, so
+	// a second entry for the same (mesh, submesh, type) would resize an array that a job is writing into.
+	// Every stream also has to lie inside the file behind the stream table, without overlapping another one.
+	static bool validateStreamTable(const EntireFile& file, const bin_header_v2& header, const bin_stream_entry* table, const ModelAsset& model)
+	{
+		const uint64 dataOffset = header.streamTableOffset + sizeof(bin_stream_entry) * header.numStreams;
+
+		std::vector<const bin_stream_entry*> entries(header.numStreams);
+		for (uint32 i = 0; i < header.numStreams; ++i)
+		{
+			const bin_stream_entry& entry = table[i];
+			if (entry.meshIndex >= (uint32)model.meshes.size()
+				|| entry.submeshIndex >= (uint32)model.meshes[entry.meshIndex].submeshes.size()
+				|| entry.type >= bin_stream_count)
+			{
+				return false;
+			}
+
+			if (entry.offset < dataOffset || entry.offset > file.size || entry.storedSize > file.size - entry.offset)
+			{
+				return false;
+			}
+
+			entries[i] = &entry;
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const bin_stream_entry* a, const bin_stream_entry* b)
+		{
+			return std::tie(a->meshIndex, a->submeshIndex, a->type) < std::tie(b->meshIndex, b->submeshIndex, b->type);
+		});
+		for (uint32 i = 1; i < header.numStreams; ++i)
+		{
+			if (std::tie(entries[i - 1]->meshIndex, entries[i - 1]->submeshIndex, entries[i - 1]->type)
+				== std::tie(entries[i]->meshIndex, entries[i]->submeshIndex, entries[i]->type))
+			{
+				return false;
+			}
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const bin_stream_entry* a, const bin_stream_entry* b)
+		{
+			return a->offset < b->offset;
+		});
+		for (uint32 i = 1; i < header.numStreams; ++i)
+		{
+			if (entries[i - 1]->offset + entries[i - 1]->storedSize > entries[i]->offset)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static ModelAsset loadBINVersion2(EntireFile& file, uint32 meshFlags)
+	{
+		const bin_header_v2* header = file.consume<bin_header_v2>();
+		if (!header
+			|| header->metadataOffset > file.size || header->metadataSize > file.size - header->metadataOffset
+			|| header->streamTableOffset > file.size
+			|| header->numStreams > (file.size - header->streamTableOffset) / sizeof(bin_stream_entry))
+		{
+			return {};
+		}
+
+		const bin_stream_entry* table = (const bin_stream_entry*)(file.content + header->streamTableOffset);
+		const uint64 metadataChecksum = hash_bytes(file.content + header->metadataOffset, header->metadataSize);
+		if (hash_bytes(table, sizeof(bin_stream_entry) * header->numStreams, metadataChecksum) != header->checksum)
+		{
+			return {};
+		}
+
+		// Metadata is small, so it is parsed serially with the v1 readers.
+		EntireFile metadata = { file.content + header->metadataOffset, header->metadataSize };
+
+		ModelAsset result;
+		result.flags = header->flags;
+		result.meshes.resize(header->numMeshes);
+		result.materials.resize(header->numMaterials);
+		result.skeletons.resize(header->numSkeletons);
+		result.animations.resize(header->numAnimations);
+
+		std::vector<bin_submesh_header> submeshHeaders;
+		for (uint32 i = 0; i < header->numMeshes; ++i)
+		{
+			result.meshes[i] = readMeshDescription(metadata, submeshHeaders);
+		}
+		for (uint32 i = 0; i < header->numMaterials; ++i)
+		{
+			result.materials[i] = readMaterial(metadata);
+		}
+		for (uint32 i = 0; i < header->numSkeletons; ++i)
+		{
+			result.skeletons[i] = readSkeleton(metadata);
+		}
+		for (uint32 i = 0; i < header->numAnimations; ++i)
+		{
+			result.animations[i] = readAnimation(metadata);
+		}
+
+		if (!validateStreamTable(file, *header, table, result))
+		{
+			return {};
+		}
+
+		struct DecodeTask
+		{
+			const bin_stream_entry* entry;
+			uint8* output;
+		};
+
+		// All destinations are allocated up front, so that the jobs only write into disjoint, already sized arrays.
+		std::vector<DecodeTask> tasks;
+		tasks.reserve(header->numStreams);
+		for (uint32 i = 0; i < header->numStreams; ++i)
+		{
+			const bin_stream_entry& entry = table[i];
+			if (!isStreamRequested(entry.type, meshFlags))
+			{
+				continue;
+			}
+
+			uint8* output = prepareStream(result.meshes[entry.meshIndex].submeshes[entry.submeshIndex], entry.type, entry.size);
+			if (!output && entry.size > 0)
+			{
+				return {};
+			}
+			tasks.push_back({ &entry, output });
+		}
+
+		std::atomic<bool> failed = false;
+		parallel_for(0, (uint32)tasks.size(), 1, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				if (!decodeStream(file, *tasks[i].entry, tasks[i].output))
+				{
+					failed = true;
+				}
+			}
+		});
+
+		if (failed)
+		{
+			return {};
+		}
+
+		return result;
+	}
+
+	ModelAsset loadBIN(const fs::path& path, uint32 mesh_flags)
+	{
+		PROFILE("Loading BIN");
+
+		EntireFile file = map_file(path);
+
+		const BinaryHeader* binaryHeader = (const BinaryHeader*)file.content;
+		if (file.size < sizeof(bin_header) || binaryHeader->header != BIN_HEADER)
+		{
+			free_file(file);
+			return {};
+		}
+
+		ModelAsset result;
+		if (binaryHeader->version == bin_version_1)
+		{
+			// v1 has no stream table, everything is read.
+			result = loadBINVersion1(file);
+		}
+		else if (binaryHeader->version == bin_version_2)
+		{
+			result = loadBINVersion2(file, mesh_flags);
+			if (result.meshes.empty() && result.materials.empty() && result.skeletons.empty() && result.animations.empty())
+			{
+				LOG_ERROR("BIN file '%s' is corrupted", path.string().c_str());
+			}
+		}
+		else
+		{
+			LOG_ERROR("BIN file '%s' has unsupported version %u", path.string().c_str(), binaryHeader->version);
+		}
+
 		free_file(file);
 
 		return result;
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "asset/block_compression.h"
+
+namespace era_engine
+{
+	// Sequence layout: token (4 bit literal length | 4 bit match length - min_match), [literal length extension],
+	// literals, 16 bit match offset, [match length extension]. Length nibbles of 15 continue in bytes of 255.
+	// The last sequence has literals only.
+	static constexpr uint32 min_match = 4;
+	static constexpr uint32 hash_log2 = 14;
+	static constexpr uint64 max_offset = 65535;
+
+	// Matches never start in the last bytes, so that the match finder can always read 4 bytes ahead.
+	static constexpr uint64 last_literals = 8;
+
+	static uint32 read_uint32(const uint8* ptr)
+	{
+		uint32 result;
+		memcpy(&result, ptr, sizeof(result));
+		return result;
+	}
+
+	static uint32 hash_sequence(uint32 sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - hash_log2);
+	}
+
+	static uint8* write_length(uint8* output, uint64 length)
+	{
+		while (length >= 255)
+		{
+			*output++ = 255;
+			length -= 255;
+		}
+		*output++ = (uint8)length;
+		return output;
+	}
+
+	static uint8* write_sequence(uint8* output, const uint8* literals, uint64 literal_length, uint64 offset, uint64 match_length)
+	{
+		uint8* token = output++;
+
+		const uint64 match_code = (match_length >= min_match) ? match_length - min_match : 0;
+		*token = (uint8)((min<uint64>(literal_length, 15) << 4) | min<uint64>(match_code, 15));
+
+		if (literal_length >= 15)
+		{
+			output = write_length(output, literal_length - 15);
+		}
+
+		memcpy(output, literals, literal_length);
+		output += literal_length;
+
+		if (match_length >= min_match)
+		{
+			*output++ = (uint8)(offset & 0xFF);
+			*output++ = (uint8)(offset >> 8);
+
+			if (match_code >= 15)
+			{
+				output = write_length(output, match_code - 15);
+			}
+		}
+
+		return output;
+	}
+
+	uint64 lz_compress(const uint8* input, uint64 size, uint8* output)
+	{
+		uint8* output_begin = output;
+
+		std::vector<uint64> table(1ull << hash_log2, UINT64_MAX);
+
+		uint64 anchor = 0;
+		uint64 position = 0;
+
+		if (size > last_literals + min_match)
+		{
+			const uint64 match_limit = size - last_literals;
+
+			while (position < match_limit)
+			{
+				const uint32 sequence = read_uint32(input + position);
+				const uint32 hash = hash_sequence(sequence);
+
+				const uint64 candidate = table[hash];
+				table[hash] = position;
+
+				if (candidate == UINT64_MAX || position - candidate > max_offset || read_uint32(input + candidate) != sequence)
+				{
+					++position;
+					continue;
+				}
+
+				uint64 match_length = min_match;
+				while (position + match_length < match_limit && input[candidate + match_length] == input[position + match_length])
+				{
+					++match_length;
+				}
+
+				output = write_sequence(output, input + anchor, position - anchor, position - candidate, match_length);
+
+				position += match_length;
+				anchor = position;
+			}
+		}
+
+		output = write_sequence(output, input + anchor, size - anchor, 0, 0);
+
+		return (uint64)(output - output_begin);
+	}
+
+	static bool read_length(const uint8*& input, const uint8* input_end, uint64& length)
+	{
+		uint8 byte;
+		do
+		{
+			if (input >= input_end)
+			{
+				return false;
+			}
+			byte = *input++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+
+	bool lz_decompress(const uint8* input, uint64 compressed_size, uint8* output, uint64 size)
+	{
+		const uint8* input_end = input + compressed_size;
+		uint8* output_begin = output;
+		uint8* output_end = output + size;
+
+		while (input < input_end)
+		{
+			const uint8 token = *input++;
+
+			uint64 literal_length = token >> 4;
+			if (literal_length == 15 && !read_length(input, input_end, literal_length))
+			{
+				return false;
+			}
+
+			if (literal_length > (uint64)(input_end - input) || literal_length > (uint64)(output_end - output))
+			{
+				return false;
+			}
+
+			memcpy(output, input, literal_length);
+			input += literal_length;
+			output += literal_length;
+
+			if (input == input_end)
+			{
+				// Last sequence.
+				break;
+			}
+
+			if (input_end - input < 2)
+			{
+				return false;
+			}
+
+			const uint64 offset = (uint64)input[0] | ((uint64)input[1] << 8);
+			input += 2;
+
+			uint64 match_length = token & 0xF;
+			if (match_length == 15 && !read_length(input, input_end, match_length))
+			{
+				return false;
+			}
+			match_length += min_match;
+
+			if (offset == 0 || offset > (uint64)(output - output_begin) || match_length > (uint64)(output_end - output))
+			{
+				return false;
+			}
+
+			const uint8* match = output - offset;
+			if (offset >= match_length)
+			{
+				memcpy(output, match, match_length);
+				output += match_length;
+			}
+			else
+			{
+				// Overlapping match, repeats the last 'offset' bytes.
+				for (uint64 i = 0; i < match_length; ++i)
+				{
+					*output++ = match[i];
+				}
+			}
+		}
+
+		return output == output_end;
+	}
+
+	void shuffle_bytes(const uint8* input, uint64 size, uint32 width, uint8* output)
+	{
+		const uint64 count = size / width;
+		for (uint32 byte = 0; byte < width; ++byte)
+		{
+			uint8* lane = output + byte * count;
+			for (uint64 i = 0; i < count; ++i)
+			{
+				lane[i] = input[i * width + byte];
+			}
+		}
+	}
+
+	void unshuffle_bytes(const uint8* input, uint64 size, uint32 width, uint8* output)
+	{
+		const uint64 count = size / width;
+		for (uint32 byte = 0; byte < width; ++byte)
+		{
+			const uint8* lane = input + byte * count;
+			for (uint64 i = 0; i < count; ++i)
+			{
+				output[i * width + byte] = lane[i];
+			}
+		}
+	}
+}
@@ -2,328 +2,671 @@
 
 #include "asset/deflate.h"
 
+#include <array>
+
 namespace era_engine
 {
-	struct BitStream
+	// Table-driven inflate (RFC 1950/1951).
+	// Bits are buffered 64 at a time and refilled without branching on the bit count. Huffman codes are resolved with
+	// one lookup in a root table, or two if the code is longer than the root table's index (then the root entry points
+	// to a subtable). Matches are copied with wide stores.
+	// The fast loop only runs while there is enough slack in both buffers that no single symbol can leave them. Close to
+	// the ends the same decoding runs with per symbol bounds checks. All malformed input is reported as inflate_error.
+
+	struct DecodeEntry
 	{
-		template <typename T>
-		T* consume(uint32 count = 1)
-		{
-			T* result = (T*)(data + read_offset);
-			read_offset += sizeof(T) * count;
-			ASSERT(read_offset <= size);
-			return result;
-		}
+		// Literal byte, base length/distance, precode symbol or subtable start.
+		uint16 value;
 
-		uint32 peek_bits(uint32 _bit_count)
-		{
-			ASSERT(_bit_count <= 32);
+		// Bits consumed by the code in this table level.
+		uint8 code_length;
+
+		// entry_* flags or'ed with the number of extra bits (for subtable pointers: number of subtable index bits).
+		uint8 flags;
+	};
+
+	enum decode_entry_flags : uint8
+	{
+		entry_extra_bits_mask = 0x0F,
+
+		entry_invalid = 0x10,
+		entry_subtable = 0x20,
+		entry_end_of_block = 0x40,
+		entry_literal = 0x80,
+	};
+
+	static constexpr uint32 max_code_length = 15;
+
+	static constexpr uint32 num_litlen_symbols = 288;
+	static constexpr uint32 num_distance_symbols = 32;
+	static constexpr uint32 num_precode_symbols = 19;
+
+	static constexpr uint32 litlen_table_bits = 10;
+	static constexpr uint32 distance_table_bits = 8;
+	static constexpr uint32 precode_table_bits = 7;
+
+	// Root table plus subtables. zlib's 'enough' utility gives 1334 and 402 entries as the worst case for these root sizes.
+	static constexpr uint32 litlen_table_capacity = 2048;
+	static constexpr uint32 distance_table_capacity = 1024;
+	static constexpr uint32 precode_table_capacity = 1 << precode_table_bits;
 
-			uint32 result = 0;
+	// Longest match (258) plus the overshoot of the 16 byte wide copies.
+	static constexpr uint64 fast_output_margin = 258 + 16;
 
-			while ((this->bit_count < _bit_count))
+	static constexpr uint16 length_base[] =
+	{
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+
+	static constexpr uint8 length_extra_bits[] =
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+
+	static constexpr uint16 distance_base[] =
+	{
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+		4097, 6145, 8193, 12289, 16385, 24577
+	};
+
+	static constexpr uint8 distance_extra_bits[] =
+	{
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	static constexpr uint8 precode_order[num_precode_symbols] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// What each symbol decodes to, without the code length. Copied into the decode tables.
+	static constexpr std::array<DecodeEntry, num_litlen_symbols> litlen_symbols = []()
+	{
+		std::array<DecodeEntry, num_litlen_symbols> result = {};
+		for (uint32 i = 0; i < num_litlen_symbols; ++i)
+		{
+			if (i < 256)
 			{
-				uint32 byte = *consume<uint8>();
-				this->bit_buffer |= (byte << this->bit_count);
-				this->bit_count += 8;
+				result[i] = { (uint16)i, 0, entry_literal };
 			}
+			else if (i == 256)
+			{
+				result[i] = { 0, 0, entry_end_of_block };
+			}
+			else if (i < 286)
+			{
+				result[i] = { length_base[i - 257], 0, length_extra_bits[i - 257] };
+			}
+			else
+			{
+				result[i] = { 0, 0, entry_invalid };
+			}
+		}
+		return result;
+	}();
 
-			result = this->bit_buffer & ((1 << _bit_count) - 1);
-
-			return result;
+	static constexpr std::array<DecodeEntry, num_distance_symbols> distance_symbols = []()
+	{
+		std::array<DecodeEntry, num_distance_symbols> result = {};
+		for (uint32 i = 0; i < num_distance_symbols; ++i)
+		{
+			result[i] = (i < 30) ? DecodeEntry{ distance_base[i], 0, distance_extra_bits[i] } : DecodeEntry{ 0, 0, entry_invalid };
 		}
+		return result;
+	}();
 
-		void discard_bits(uint32 _bit_count)
+	static constexpr std::array<DecodeEntry, num_precode_symbols> precode_symbols = []()
+	{
+		std::array<DecodeEntry, num_precode_symbols> result = {};
+		for (uint32 i = 0; i < num_precode_symbols; ++i)
 		{
-			bit_count -= _bit_count;
-			bit_buffer >>= _bit_count;
+			result[i] = { (uint16)i, 0, 0 };
 		}
+		return result;
+	}();
 
-		uint32 consume_bits(uint32 _bit_count)
+	struct BitReader
+	{
+		// At least 8 readable bytes, so refill_fast() may be used.
+		bool can_refill_fast() const
 		{
-			uint32 result = peek_bits(_bit_count);
-			discard_bits(_bit_count);
-			return result;
+			return end - next >= 8;
 		}
 
-		void flush_byte()
+		// Tops the buffer up to 56..63 bits with one unaligned load. Only whole bytes are taken over, the rest of the
+		// loaded word is shifted out and read again next time.
+		void refill_fast()
 		{
-			uint32 flushCount = (bit_count % 8);
-			consume_bits(flushCount);
+			uint64 word;
+			memcpy(&word, next, sizeof(word));
+			bit_buffer |= word << bit_count;
+			next += (63 - bit_count) >> 3;
+			bit_count |= 56;
 		}
 
-		uint64 bytes_remaining() const
+		// Same as refill_fast(), but byte by byte near the end of the input. Past the end zeros are shifted in, which
+		// is caught by has_overrun() once they are actually consumed.
+		void refill()
 		{
-			return size - read_offset;
+			if (can_refill_fast())
+			{
+				refill_fast();
+				return;
+			}
+
+			while (bit_count <= 56)
+			{
+				if (next < end)
+				{
+					bit_buffer |= (uint64)*next++ << bit_count;
+				}
+				else
+				{
+					++overrun_bytes;
+				}
+				bit_count += 8;
+			}
 		}
 
-		uint8* data;
-		uint64 size;
-		uint64 read_offset;
+		uint32 peek(uint32 count) const
+		{
+			return (uint32)(bit_buffer & ((1ull << count) - 1));
+		}
 
-		uint32 bit_count;
-		uint32 bit_buffer;
-	};
+		void discard(uint32 count)
+		{
+			bit_buffer >>= count;
+			bit_count -= count;
+		}
 
-	inline constexpr uint32 reverse_bits(uint32 value, uint32 bit_count)
-	{
-		uint32 result = 0;
+		uint32 consume(uint32 count)
+		{
+			uint32 result = peek(count);
+			discard(count);
+			return result;
+		}
 
-		for (uint32 i = 0; i <= (bit_count / 2); ++i)
+		// More bits consumed than the input has.
+		bool has_overrun() const
 		{
-			uint32 inv = (bit_count - (i + 1));
-			result |= ((value >> i) & 0x1) << inv;
-			result |= ((value >> inv) & 0x1) << i;
+			return overrun_bytes * 8 > bit_count;
 		}
 
-		return result;
-	}
+		const uint8* next;
+		const uint8* end;
 
-	struct HuffmanEntry
-	{
-		uint16 symbol;
-		uint16 code_length;
+		uint64 bit_buffer = 0;
+		uint32 bit_count = 0;
+		uint32 overrun_bytes = 0;
 	};
 
-	struct HuffmanTable
+	static uint32 reverse_bits(uint32 value, uint32 bit_count)
 	{
-		uint32 max_code_length_in_bits;
-		std::vector<HuffmanEntry> entries;
+		value = ((value & 0x5555) << 1) | ((value >> 1) & 0x5555);
+		value = ((value & 0x3333) << 2) | ((value >> 2) & 0x3333);
+		value = ((value & 0x0F0F) << 4) | ((value >> 4) & 0x0F0F);
+		value = ((value & 0x00FF) << 8) | ((value >> 8) & 0x00FF);
+		return value >> (16 - bit_count);
+	}
 
-		void initialize(uint32 _max_code_length_in_bits, uint32* symbol_lengths, uint32 num_symbols, uint32 symbol_offset = 0)
+	// Builds the decode table for a canonical Huffman code given by its code lengths. Returns false if the code is
+	// over-subscribed or doesn't fit into 'capacity'. Incomplete codes are accepted, their unused entries decode as invalid.
+	static bool build_decode_table(DecodeEntry* table, uint32 capacity, uint32 table_bits,
+		const uint8* code_lengths, uint32 num_symbols, const DecodeEntry* symbols)
+	{
+		uint32 count[max_code_length + 1] = {};
+		for (uint32 i = 0; i < num_symbols; ++i)
 		{
-			ASSERT(_max_code_length_in_bits <= 16);
+			++count[code_lengths[i]];
+		}
+		count[0] = 0;
 
-			max_code_length_in_bits = _max_code_length_in_bits;
-			uint32 entryCount = (1 << max_code_length_in_bits);
-			entries.resize(entryCount);
+		int32 left = 1;
+		for (uint32 len = 1; len <= max_code_length; ++len)
+		{
+			left = (left << 1) - (int32)count[len];
+			if (left < 0)
+			{
+				return false;
+			}
+		}
 
-			uint32 bl_count[16] = {};
-			for (uint32 i = 0; i < num_symbols; ++i)
+		uint32 offsets[max_code_length + 2] = {};
+		for (uint32 len = 1; len <= max_code_length; ++len)
+		{
+			offsets[len + 1] = offsets[len] + count[len];
+		}
+
+		// Symbols ordered by code length, then by value, i.e. in canonical code order.
+		uint16 sorted[num_litlen_symbols];
+		for (uint32 i = 0; i < num_symbols; ++i)
+		{
+			if (code_lengths[i])
 			{
-				uint32 count = symbol_lengths[i];
-				ASSERT(count < arraysize(bl_count));
-				++bl_count[count];
+				sorted[offsets[code_lengths[i]]++] = (uint16)i;
 			}
+		}
+		const uint32 num_codes = offsets[max_code_length + 1];
+
+		const uint32 root_size = 1 << table_bits;
+		for (uint32 i = 0; i < root_size; ++i)
+		{
+			table[i] = { 0, 0, entry_invalid };
+		}
 
-			uint32 next_code[16];
-			next_code[0] = 0;
-			bl_count[0] = 0;
-			for (uint32 bits = 1; bits < 16; ++bits)
+		// Subtable size per root entry: enough index bits for the longest code sharing that prefix.
+		uint8 subtable_bits[1 << litlen_table_bits] = {};
+		{
+			uint32 code = 0;
+			uint32 len = 0;
+			for (uint32 i = 0; i < num_codes; ++i)
 			{
-				next_code[bits] = ((next_code[bits - 1] + bl_count[bits - 1]) << 1);
+				const uint32 symbol_len = code_lengths[sorted[i]];
+				code <<= symbol_len - len;
+				len = symbol_len;
+
+				if (len > table_bits)
+				{
+					const uint32 root_index = reverse_bits(code >> (len - table_bits), table_bits);
+					subtable_bits[root_index] = (uint8)max(subtable_bits[root_index], (uint8)(len - table_bits));
+				}
+				++code;
 			}
+		}
+
+		uint32 table_end = root_size;
+		uint32 code = 0;
+		uint32 len = 0;
+		for (uint32 i = 0; i < num_codes; ++i)
+		{
+			const uint32 symbol_len = code_lengths[sorted[i]];
+			code <<= symbol_len - len;
+			len = symbol_len;
 
-			for (uint32 n = 0; n < num_symbols; ++n)
+			DecodeEntry entry = symbols[sorted[i]];
+
+			if (len <= table_bits)
 			{
-				uint32 len = symbol_lengths[n];
-				if (len)
+				entry.code_length = (uint8)len;
+				for (uint32 index = reverse_bits(code, len); index < root_size; index += 1 << len)
 				{
-					uint32 code = next_code[len]++;
+					table[index] = entry;
+				}
+			}
+			else
+			{
+				const uint32 root_index = reverse_bits(code >> (len - table_bits), table_bits);
+				const uint32 sub_bits = subtable_bits[root_index];
 
-					uint32 num_garbage_bits = max_code_length_in_bits - len;
-					uint32 num_entries = (1 << num_garbage_bits);
+				if (!(table[root_index].flags & entry_subtable))
+				{
+					if (table_end + (1 << sub_bits) > capacity)
+					{
+						return false;
+					}
 
-					for (uint32 i = 0; i < num_entries; ++i)
+					table[root_index] = { (uint16)table_end, (uint8)table_bits, (uint8)(entry_subtable | sub_bits) };
+					for (uint32 index = 0; index < (1u << sub_bits); ++index)
 					{
-						uint32 base = (code << num_garbage_bits) | i;
-						uint32 index = reverse_bits(base, max_code_length_in_bits);
+						table[table_end + index] = { 0, 0, entry_invalid };
+					}
+					table_end += 1 << sub_bits;
+				}
 
-						HuffmanEntry& entry = entries[index];
+				const uint32 sub_len = len - table_bits;
+				const uint32 sub_code = code & ((1 << sub_len) - 1);
+				DecodeEntry* subtable = table + table[root_index].value;
 
-						uint32 symbol = n + symbol_offset;
-						entry.code_length = (uint16)len;
-						entry.symbol = (uint16)symbol;
-					}
+				entry.code_length = (uint8)sub_len;
+				for (uint32 index = reverse_bits(sub_code, sub_len); index < (1u << sub_bits); index += 1 << sub_len)
+				{
+					subtable[index] = entry;
 				}
 			}
+			++code;
 		}
 
-		uint32 decode(BitStream& stream)
+		return true;
+	}
+
+	// Needs at least max_code_length buffered bits.
+	static inline DecodeEntry decode_symbol(BitReader& bits, const DecodeEntry* table, uint32 table_bits)
+	{
+		DecodeEntry entry = table[bits.peek(table_bits)];
+		if (entry.flags & entry_subtable)
 		{
-			uint32 index = stream.peek_bits(max_code_length_in_bits);
-			HuffmanEntry entry = entries[index];
-			stream.discard_bits(entry.code_length);
-			return entry.symbol;
+			bits.discard(entry.code_length);
+			entry = table[entry.value + bits.peek(entry.flags & entry_extra_bits_mask)];
 		}
-	};
+		bits.discard(entry.code_length);
+		return entry;
+	}
 
-	static HuffmanEntry length_extra[] =
+	// May write up to 15 bytes past 'output + length'.
+	static inline void copy_match_wide(uint8* output, uint32 distance, uint32 length)
 	{
-		{3, 0}, {4, 0}, {5, 0}, {6, 0}, {7, 0}, {8, 0}, {9, 0}, {10, 0}, {11, 1}, {13, 1}, {15, 1}, {17, 1}, {19, 2},
-		{23, 2}, {27, 2}, {31, 2}, {35, 3}, {43, 3}, {51, 3}, {59, 3}, {67, 4}, {83, 4}, {99, 4}, {115, 4}, {131, 5},
-		{163, 5}, {195, 5}, {227, 5}, {258, 0}
-	};
+		const uint8* source = output - distance;
+		uint8* end = output + length;
+
+		if (distance >= 16)
+		{
+			do
+			{
+				memcpy(output, source, 16);
+				output += 16;
+				source += 16;
+			} while (output < end);
+		}
+		else if (distance >= 8)
+		{
+			do
+			{
+				memcpy(output, source, 8);
+				output += 8;
+				source += 8;
+			} while (output < end);
+		}
+		else if (distance == 1)
+		{
+			memset(output, *source, length);
+		}
+		else
+		{
+			do
+			{
+				*output++ = *source++;
+			} while (output < end);
+		}
+	}
 
-	static HuffmanEntry dist_extra[] =
+	struct InflateTables
 	{
-		{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 1}, {7, 1}, {9, 2}, {13, 2}, {17, 3}, {25, 3}, {33, 4}, {49, 4}, {65, 5},
-		{97, 5}, {129, 6}, {193, 6}, {257, 7}, {385, 7}, {513, 8}, {769, 8}, {1025, 9}, {1537, 9}, {2049, 10}, {3073, 10},
-		{4097, 11}, {6145, 11}, {8193, 12}, {12289, 12}, {16385, 13}, {24577, 13}
+		DecodeEntry litlen[litlen_table_capacity];
+		DecodeEntry distance[distance_table_capacity];
 	};
 
+	static const InflateTables& get_fixed_tables()
+	{
+		static const InflateTables tables = []()
+		{
+			uint8 code_lengths[num_litlen_symbols + num_distance_symbols];
+			memset(code_lengths, 8, 144);
+			memset(code_lengths + 144, 9, 256 - 144);
+			memset(code_lengths + 256, 7, 280 - 256);
+			memset(code_lengths + 280, 8, num_litlen_symbols - 280);
+			memset(code_lengths + num_litlen_symbols, 5, num_distance_symbols);
+
+			InflateTables result;
+			build_decode_table(result.litlen, litlen_table_capacity, litlen_table_bits,
+				code_lengths, num_litlen_symbols, litlen_symbols.data());
+			build_decode_table(result.distance, distance_table_capacity, distance_table_bits,
+				code_lengths + num_litlen_symbols, num_distance_symbols, distance_symbols.data());
+			return result;
+		}();
+		return tables;
+	}
 
-	uint64 decompress(uint8* data, uint64 compressed_size, uint8* output)
+	static bool read_dynamic_tables(BitReader& bits, InflateTables& tables)
 	{
-		BitStream stream = { data, compressed_size };
+		bits.refill();
+		const uint32 num_litlen = bits.consume(5) + 257;
+		const uint32 num_distance = bits.consume(5) + 1;
+		const uint32 num_precode = bits.consume(4) + 4;
 
-		uint32 zlibHeader0 = *stream.consume<uint8>();
-		uint32 zlibHeader1 = *stream.consume<uint8>();
-		uint32 counter = (((zlibHeader0 * 256 + zlibHeader1) % 31 != 0) || (zlibHeader1 & 32) || ((zlibHeader0 & 15) != 8));
-		ASSERT(counter == 0);
+		if (num_litlen > 286 || num_distance > 30)
+		{
+			return false;
+		}
 
-		uint8* output_start = output;
+		uint8 precode_lengths[num_precode_symbols] = {};
+		for (uint32 i = 0; i < num_precode; ++i)
+		{
+			bits.refill();
+			precode_lengths[precode_order[i]] = (uint8)bits.consume(3);
+		}
 
-		uint32 BFINAL = 0;
-		while (BFINAL == 0)
+		DecodeEntry precode_table[precode_table_capacity];
+		if (!build_decode_table(precode_table, precode_table_capacity, precode_table_bits,
+			precode_lengths, num_precode_symbols, precode_symbols.data()))
 		{
-			BFINAL = stream.consume_bits(1);
-			uint32 BTYPE = stream.consume_bits(2);
+			return false;
+		}
 
-			ASSERT(BTYPE != 3);
+		uint8 code_lengths[num_litlen_symbols + num_distance_symbols] = {};
+		const uint32 num_code_lengths = num_litlen + num_distance;
 
-			if (BTYPE == 0)
+		uint32 out_index = 0;
+		while (out_index < num_code_lengths)
+		{
+			bits.refill();
+
+			DecodeEntry entry = decode_symbol(bits, precode_table, precode_table_bits);
+			if (entry.flags & entry_invalid)
 			{
-				// No compression
-				stream.flush_byte();
+				return false;
+			}
 
-				uint16 LEN = (uint16)stream.consume_bits(16);
-				uint16 NLEN = (uint16)stream.consume_bits(16);
-				ASSERT((uint16)LEN == (uint16)~NLEN);
+			if (entry.value < 16)
+			{
+				code_lengths[out_index++] = (uint8)entry.value;
+				continue;
+			}
 
-				while (LEN)
+			uint8 value = 0;
+			uint32 repeat = 0;
+			if (entry.value == 16)
+			{
+				if (out_index == 0)
 				{
-					uint16 useLEN = LEN;
-					useLEN = (uint16)min((uint64)useLEN, stream.bytes_remaining());
-
-					uint8* source = stream.consume<uint8>(useLEN);
-					uint16 copy_count = useLEN;
-					while (copy_count--)
-					{
-						*output++ = *source++;
-					}
-
-					LEN -= useLEN;
+					return false;
 				}
+				value = code_lengths[out_index - 1];
+				repeat = bits.consume(2) + 3;
+			}
+			else if (entry.value == 17)
+			{
+				repeat = bits.consume(3) + 3;
 			}
 			else
 			{
-				uint32 litlen_dist[512];
+				repeat = bits.consume(7) + 11;
+			}
 
-				uint32 HLIT = 0;
-				uint32 HDIST = 0;
-				if (BTYPE == 2)
-				{
-					// Compressed with dynamic Huffman codes.
-					HLIT = stream.consume_bits(5) + 257;
-					HDIST = stream.consume_bits(5) + 1;
-					uint32 HCLEN = stream.consume_bits(4) + 4;
+			if (repeat > num_code_lengths - out_index)
+			{
+				return false;
+			}
+			memset(code_lengths + out_index, value, repeat);
+			out_index += repeat;
+		}
 
-					uint32 HCLENSwizzle[] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
-					ASSERT(HCLEN <= arraysize(HCLENSwizzle));
-					uint32 HCLENTable[arraysize(HCLENSwizzle)] = {};
+		// A block without end-of-block code can't be terminated.
+		if (code_lengths[256] == 0)
+		{
+			return false;
+		}
 
-					for (uint32 i = 0; i < HCLEN; ++i)
-					{
-						HCLENTable[HCLENSwizzle[i]] = stream.consume_bits(3);
-					}
+		return build_decode_table(tables.litlen, litlen_table_capacity, litlen_table_bits,
+				code_lengths, num_litlen, litlen_symbols.data())
+			&& build_decode_table(tables.distance, distance_table_capacity, distance_table_bits,
+				code_lengths + num_litlen, num_distance, distance_symbols.data());
+	}
 
-					HuffmanTable dict_table;
-					dict_table.initialize(7, HCLENTable, arraysize(HCLENSwizzle));
+	static bool inflate_huffman_block(BitReader& bits, const InflateTables& tables, uint8* output_begin, uint8*& output, uint8* output_end)
+	{
+		uint8* out = output;
 
-					uint32 out_index = 0;
-					while (out_index < HLIT + HDIST)
-					{
-						uint32 len = dict_table.decode(stream);
-						uint32 value = 0;
-						uint32 repeat = 1;
-						if (len < 16)
-						{
-							value = len;
-						}
-						else if (len == 16)
-						{
-							repeat = stream.consume_bits(2) + 3;
-							ASSERT(out_index > 0);
-							value = litlen_dist[out_index - 1];
-						}
-						else if (len == 17)
-						{
-							repeat = stream.consume_bits(3) + 3;
-						}
-						else if (len == 18)
-						{
-							repeat = stream.consume_bits(7) + 11;
-						}
-
-						for (uint32 r = 0; r < repeat; ++r)
-						{
-							litlen_dist[out_index++] = value;
-						}
-					}
-					ASSERT(out_index == HLIT + HDIST);
-				}
-				else if (BTYPE == 1)
-				{
-					HLIT = 288;
-					HDIST = 32;
+		// After a refill at least 56 bits are buffered. A length/distance pair takes at most 15 + 5 + 15 + 13 = 48.
+		while (bits.can_refill_fast() && (uint64)(output_end - out) >= fast_output_margin)
+		{
+			bits.refill_fast();
 
-					uint32 bit_counts[][2] = { {143, 8}, {255, 9}, {279, 7}, {287, 8}, {319, 5} };
+			DecodeEntry entry = decode_symbol(bits, tables.litlen, litlen_table_bits);
+			if (entry.flags & entry_literal)
+			{
+				*out++ = (uint8)entry.value;
+				continue;
+			}
+			if (entry.flags & (entry_end_of_block | entry_invalid))
+			{
+				output = out;
+				return !(entry.flags & entry_invalid);
+			}
 
-					uint32 out_index = 0;
-					for (uint32 i = 0; i < arraysize(bit_counts); ++i)
-					{
-						uint32 last_value = bit_counts[i][0];
-						uint32 bit_count = bit_counts[i][1];
-						while (out_index <= last_value)
-						{
-							litlen_dist[out_index++] = bit_count;
-						}
-					}
-				}
+			const uint32 length = entry.value + bits.consume(entry.flags & entry_extra_bits_mask);
+
+			DecodeEntry distance_entry = decode_symbol(bits, tables.distance, distance_table_bits);
+			if (distance_entry.flags & entry_invalid)
+			{
+				return false;
+			}
 
-				HuffmanTable lit_len_table;
-				lit_len_table.initialize(15, litlen_dist, HLIT);
+			const uint32 distance = distance_entry.value + bits.consume(distance_entry.flags & entry_extra_bits_mask);
+			if (distance > (uint64)(out - output_begin))
+			{
+				return false;
+			}
 
-				HuffmanTable dist_table;
-				dist_table.initialize(15, litlen_dist + HLIT, HDIST);
+			copy_match_wide(out, distance, length);
+			out += length;
+		}
+
+		// Close to the end of either buffer.
+		while (true)
+		{
+			bits.refill();
+			if (bits.has_overrun())
+			{
+				return false;
+			}
 
-				while (true)
+			DecodeEntry entry = decode_symbol(bits, tables.litlen, litlen_table_bits);
+			if (entry.flags & entry_literal)
+			{
+				if (out == output_end)
 				{
-					uint32 lit_len = lit_len_table.decode(stream);
-					if (lit_len <= 255)
-					{
-						*output++ = lit_len;
-					}
-					else if (lit_len >= 257)
-					{
-						HuffmanEntry len_entry = length_extra[lit_len - 257];
-						uint32 len = len_entry.symbol;
-						if (len_entry.code_length)
-						{
-							len += stream.consume_bits(len_entry.code_length);
-						}
-
-						uint32 dist_index = dist_table.decode(stream);
-						HuffmanEntry dist_entry = dist_extra[dist_index];
-						uint32 dist = dist_entry.symbol;
-						if (dist_entry.code_length)
-						{
-							dist += stream.consume_bits(dist_entry.code_length);
-						}
-
-						uint8* input = output - dist;
-						for (uint32 r = 0; r < len; ++r)
-						{
-							*output++ = *input++;
-						}
-					}
-					else
-						break;
+					return false;
 				}
+				*out++ = (uint8)entry.value;
+				continue;
+			}
+			if (entry.flags & (entry_end_of_block | entry_invalid))
+			{
+				output = out;
+				return !(entry.flags & entry_invalid);
+			}
+
+			const uint32 length = entry.value + bits.consume(entry.flags & entry_extra_bits_mask);
+
+			DecodeEntry distance_entry = decode_symbol(bits, tables.distance, distance_table_bits);
+			if (distance_entry.flags & entry_invalid)
+			{
+				return false;
+			}
+
+			const uint32 distance = distance_entry.value + bits.consume(distance_entry.flags & entry_extra_bits_mask);
+			if (distance > (uint64)(out - output_begin) || length > (uint64)(output_end - out))
+			{
+				return false;
+			}
+
+			const uint8* source = out - distance;
+			for (uint32 i = 0; i < length; ++i)
+			{
+				out[i] = source[i];
+			}
+			out += length;
+		}
+	}
+
+	static bool inflate_stored_block(BitReader& bits, uint8*& output, uint8* output_end)
+	{
+		bits.discard(bits.bit_count & 7);
+		bits.refill();
+
+		const uint32 length = bits.consume(16);
+		const uint32 inverted_length = bits.consume(16);
+		if (length != (~inverted_length & 0xFFFF))
+		{
+			return false;
+		}
+
+		// Hand the whole bytes still in the bit buffer back to the input.
+		const uint32 buffered_bytes = bits.bit_count >> 3;
+		if (buffered_bytes < bits.overrun_bytes)
+		{
+			return false;
+		}
+		bits.next -= buffered_bytes - bits.overrun_bytes;
+		bits.bit_buffer = 0;
+		bits.bit_count = 0;
+		bits.overrun_bytes = 0;
+
+		if (length > (uint64)(bits.end - bits.next) || length > (uint64)(output_end - output))
+		{
+			return false;
+		}
+
+		if (length > 0)
+		{
+			memcpy(output, bits.next, length);
+		}
+		bits.next += length;
+		output += length;
+		return true;
+	}
+
+	uint64 decompress(const uint8* data, uint64 compressed_size, uint8* output, uint64 output_size)
+	{
+		if (compressed_size < 2)
+		{
+			return inflate_error;
+		}
+
+		// zlib header: deflate method, no preset dictionary.
+		const uint32 cmf = data[0];
+		const uint32 flg = data[1];
+		if ((cmf * 256 + flg) % 31 != 0 || (cmf & 15) != 8 || (flg & 32))
+		{
+			return inflate_error;
+		}
+
+		BitReader bits;
+		bits.next = data + 2;
+		bits.end = data + compressed_size;
+
+		uint8* out = output;
+		uint8* output_end = output + output_size;
+
+		// Dynamic tables are rebuilt per block, so they live on the stack.
+		InflateTables dynamic_tables;
+
+		uint32 is_final = 0;
+		while (!is_final)
+		{
+			bits.refill();
+			is_final = bits.consume(1);
+			const uint32 type = bits.consume(2);
+
+			bool success = false;
+			if (type == 0)
+			{
+				success = inflate_stored_block(bits, out, output_end);
+			}
+			else if (type == 1)
+			{
+				success = inflate_huffman_block(bits, get_fixed_tables(), output, out, output_end);
+			}
+			else if (type == 2)
+			{
+				success = read_dynamic_tables(bits, dynamic_tables)
+					&& inflate_huffman_block(bits, dynamic_tables, output, out, output_end);
+			}
+
+			if (!success || bits.has_overrun())
+			{
+				return inflate_error;
 			}
 		}
 
-		return output - output_start;
+		// The Adler-32 trailer is not checked.
+		return (uint64)(out - output);
 	}
-}
\ No newline at end of file
+}
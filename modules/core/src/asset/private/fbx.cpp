@@ -9,6 +9,8 @@
 #include "core/cpu_profiling.h"
 #include "core/color.h"
 #include "core/yaml.h" 
+#include "core/log.h"
+#include "core/job_system.h"
 
 #include "geometry/mesh.h"
 
@@ -422,66 +424,251 @@ namespace era_engine
 		return node;
 	}
 
+	// Appends the node (without its children) and its properties. The record header has already been consumed.
+	static uint32 pushNode(const fbx_node_record_header_64& header, EntireFile& file, std::vector<fbx_node>& outNodes, std::vector<fbx_property>& outProperties, uint32 parent)
+	{
+		uint32 nodeNameLength = header.nameLength;
+		char* nodeName = file.consume<char>(nodeNameLength);
+
+		fbx_node node;
+		node.name = { nodeName, nodeNameLength };
+		node.parent = parent;
+		node.level = outNodes[parent].level + 1;
+		node.next = -1;
+		node.firstChild = -1;
+		node.lastChild = -1;
+		node.numChildren = 0;
+		node.firstProperty = (uint32)outProperties.size();
+		node.numProperties = (uint32)header.numProperties;
+
+		uint32 nodeIndex = (uint32)outNodes.size();
+		if (parent != -1)
+		{
+			if (outNodes[parent].firstChild == -1)
+			{
+				outNodes[parent].firstChild = nodeIndex;
+			}
+			else
+			{
+				outNodes[outNodes[parent].lastChild].next = nodeIndex;
+			}
+			outNodes[parent].lastChild = nodeIndex;
+			++outNodes[parent].numChildren;
+		}
+
+		node.numProperties = parseProperties(file, outProperties, (uint32)header.numProperties);
+
+		outNodes.push_back(node);
+
+		return nodeIndex;
+	}
+
+	static void parseNodes(uint32 version, EntireFile& file, std::vector<fbx_node>& outNodes, std::vector<fbx_property>& outProperties, uint32 level, uint32 parent);
+
+	static void parseNode(uint32 version, const fbx_node_record_header_64& header, EntireFile& file, std::vector<fbx_node>& outNodes, std::vector<fbx_property>& outProperties,
+		uint32 level, uint32 parent)
+	{
+		uint32 nodeIndex = pushNode(header, file, outNodes, outProperties, parent);
+
+		uint64 sizeLeft = header.endOffset - file.read_offset;
+		if (sizeLeft > 0)
+		{
+			parseNodes(version, file, outNodes, outProperties, level + 1, nodeIndex);
+			sizeLeft = header.endOffset - file.read_offset;
+		}
+
+		ASSERT(sizeLeft == 0);
+	}
+
 	static void parseNodes(uint32 version, EntireFile& file, std::vector<fbx_node>& outNodes, std::vector<fbx_property>& outProperties, uint32 level, uint32 parent)
 	{
 		fbx_node_record_header_64 currentNode = readNodeRecordHeader(version, file);
 		while (currentNode.endOffset != 0)
 		{
-			uint32 nodeNameLength = currentNode.nameLength;
-			char* nodeName = file.consume<char>(nodeNameLength);
+			parseNode(version, currentNode, file, outNodes, outProperties, level, parent);
+			currentNode = readNodeRecordHeader(version, file);
+		}
+	}
 
-			fbx_node node;
-			node.name = { nodeName, nodeNameLength };
-			node.parent = parent;
-			node.level = outNodes[parent].level + 1;
-			node.next = -1;
-			node.firstChild = -1;
-			node.lastChild = -1;
-			node.numChildren = 0;
-			node.firstProperty = (uint32)outProperties.size();
-			node.numProperties = (uint32)currentNode.numProperties;
+	// A run of sibling records [begin, end), parsed on its own into local node and property arrays. Local node 0 stands in for the parent.
+	struct fbx_node_chunk
+	{
+		uint64 begin;
+		uint64 end;
 
-			uint32 nodeIndex = (uint32)outNodes.size();
-			if (parent != -1)
+		std::vector<fbx_node> nodes;
+		std::vector<fbx_property> properties;
+	};
+
+	struct fbx_top_level_record
+	{
+		fbx_node_record_header_64 header;
+		uint64 headerEnd;
+		uint32 firstChunk;
+		uint32 numChunks;
+	};
+
+	// Same result as parseNodes(version, file, outNodes, outProperties, 0, 0), but the children of the top-level records (most notably 'Objects' and 'Connections')
+	// are parsed in parallel. A first pass only hops from record header to record header to find the chunk boundaries. Returns false (without touching
+	// the output) if the record offsets don't add up, so that the caller can fall back to the serial parser.
+	static bool parseNodesParallel(uint32 version, EntireFile& file, std::vector<fbx_node>& outNodes, std::vector<fbx_property>& outProperties)
+	{
+		constexpr uint64 targetChunkSize = 64 * 1024;
+		const uint64 nullRecordSize = (version >= 7500) ? sizeof(fbx_node_record_header_64) : sizeof(fbx_node_record_header_32);
+
+		std::vector<fbx_top_level_record> records;
+		std::vector<fbx_node_chunk> chunks;
+
+		EntireFile index = file;
+		while (true)
+		{
+			if (index.size - index.read_offset < nullRecordSize)
 			{
-				if (outNodes[parent].firstChild == -1)
+				return false;
+			}
+
+			fbx_top_level_record record = {};
+			record.header = readNodeRecordHeader(version, index);
+			if (record.header.endOffset == 0)
+			{
+				break;
+			}
+
+			record.headerEnd = index.read_offset;
+			record.firstChunk = (uint32)chunks.size();
+
+			uint64 childrenBegin = record.headerEnd + record.header.nameLength + record.header.propertyListLength;
+			uint64 end = record.header.endOffset;
+			if (end > index.size || childrenBegin > end)
+			{
+				return false;
+			}
+
+			if (childrenBegin < end)
+			{
+				// Children are terminated by a null record.
+				if (end - childrenBegin < nullRecordSize)
 				{
-					outNodes[parent].firstChild = nodeIndex;
+					return false;
 				}
-				else
+				uint64 childrenEnd = end - nullRecordSize;
+
+				uint64 chunkBegin = childrenBegin;
+				index.read_offset = childrenBegin;
+				while (index.read_offset < childrenEnd)
 				{
-					outNodes[outNodes[parent].lastChild].next = nodeIndex;
+					uint64 childEnd = readNodeRecordHeader(version, index).endOffset;
+					if (childEnd <= index.read_offset || childEnd > childrenEnd)
+					{
+						return false;
+					}
+					index.read_offset = childEnd;
+
+					if (childEnd - chunkBegin >= targetChunkSize || childEnd == childrenEnd)
+					{
+						fbx_node_chunk& chunk = chunks.emplace_back();
+						chunk.begin = chunkBegin;
+						chunk.end = childEnd;
+						chunkBegin = childEnd;
+					}
 				}
-				outNodes[parent].lastChild = nodeIndex;
-				++outNodes[parent].numChildren;
 			}
 
-			node.numProperties = parseProperties(file, outProperties, (uint32)currentNode.numProperties);
+			record.numChunks = (uint32)chunks.size() - record.firstChunk;
+			records.push_back(record);
 
-			outNodes.push_back(node);
+			index.read_offset = end;
+		}
+		uint64 endOfNodes = index.read_offset;
 
-			uint64 sizeLeft = currentNode.endOffset - file.read_offset;
-			if (sizeLeft > 0)
+		parallel_for(0, (uint32)chunks.size(), 1, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
 			{
-				parseNodes(version, file, outNodes, outProperties, level + 1, nodeIndex);
-				sizeLeft = currentNode.endOffset - file.read_offset;
+				fbx_node_chunk& chunk = chunks[i];
+
+				// Level 0, as in the children of a top-level record end up at level 1.
+				fbx_node root = {};
+				root.parent = -1;
+				root.next = -1;
+				root.firstChild = -1;
+				root.lastChild = -1;
+				chunk.nodes.push_back(root);
+
+				EntireFile view = file;
+				view.read_offset = chunk.begin;
+				while (view.read_offset < chunk.end)
+				{
+					fbx_node_record_header_64 header = readNodeRecordHeader(version, view);
+					parseNode(version, header, view, chunk.nodes, chunk.properties, 1, 0);
+				}
 			}
+		});
 
-			ASSERT(sizeLeft == 0);
-			currentNode = readNodeRecordHeader(version, file);
+		// Splice everything together in file order, which gives exactly the indices of the serial parser.
+		for (const fbx_top_level_record& record : records)
+		{
+			EntireFile view = file;
+			view.read_offset = record.headerEnd;
+			uint32 parent = pushNode(record.header, view, outNodes, outProperties, 0);
+
+			for (uint32 i = record.firstChunk; i < record.firstChunk + record.numChunks; ++i)
+			{
+				fbx_node_chunk& chunk = chunks[i];
+
+				// Local node i > 0 becomes outNodes[nodeBase + i].
+				uint32 nodeBase = (uint32)outNodes.size() - 1;
+				uint32 propertyBase = (uint32)outProperties.size();
+
+				auto remap = [nodeBase](uint32 local) { return (local == -1) ? local : local + nodeBase; };
+
+				for (uint32 j = 1; j < (uint32)chunk.nodes.size(); ++j)
+				{
+					fbx_node node = chunk.nodes[j];
+					node.parent = (node.parent == 0) ? parent : remap(node.parent);
+					node.next = remap(node.next);
+					node.firstChild = remap(node.firstChild);
+					node.lastChild = remap(node.lastChild);
+					node.firstProperty += propertyBase;
+					outNodes.push_back(node);
+				}
+				outProperties.insert(outProperties.end(), chunk.properties.begin(), chunk.properties.end());
+
+				const fbx_node& root = chunk.nodes[0];
+				if (outNodes[parent].firstChild == -1)
+				{
+					outNodes[parent].firstChild = remap(root.firstChild);
+				}
+				else
+				{
+					outNodes[outNodes[parent].lastChild].next = remap(root.firstChild);
+				}
+				outNodes[parent].lastChild = remap(root.lastChild);
+				outNodes[parent].numChildren += root.numChildren;
+			}
 		}
+
+		file.read_offset = endOfNodes;
+		return true;
 	}
 
-	static uint64 readArray(const fbx_property& prop, uint8* out)
+	static uint64 readArray(const fbx_property& prop, uint8* out, uint64 outSize)
 	{
 		if (prop.encoding == 0)
 		{
-			memcpy(out, prop.data, prop.encodedLength);
-			return prop.encodedLength;
+			uint64 size = min<uint64>(prop.encodedLength, outSize);
+			memcpy(out, prop.data, size);
+			return size;
 		}
 		else
 		{
-			uint64 decompressedBytes = decompress(prop.data, prop.encodedLength, out);
+			uint64 decompressedBytes = decompress(prop.data, prop.encodedLength, out, outSize);
+			if (decompressedBytes == inflate_error)
+			{
+				LOG_ERROR("FBX: Corrupted array property");
+				memset(out, 0, outSize);
+				return 0;
+			}
 			return decompressedBytes;
 		}
 	}
@@ -493,7 +680,7 @@ namespace era_engine
 		std::vector<int32> result;
 		result.resize(prop.numElements);
 
-		uint64 readBytes = readArray(prop, (uint8*)result.data());
+		uint64 readBytes = readArray(prop, (uint8*)result.data(), result.size() * sizeof(result[0]));
 		ASSERT(readBytes == prop.numElements * sizeof(int32));
 
 		return result;
@@ -506,7 +693,7 @@ namespace era_engine
 		std::vector<double> result;
 		result.resize(prop.numElements);
 
-		uint64 readBytes = readArray(prop, (uint8*)result.data());
+		uint64 readBytes = readArray(prop, (uint8*)result.data(), result.size() * sizeof(result[0]));
 		ASSERT(readBytes == prop.numElements * sizeof(double));
 
 		return result;
@@ -1453,16 +1640,23 @@ namespace era_engine
 		return result;
 	}
 
+	// Number of keys of an AnimationCurve object, so that its keys can be given a range in the shared key arrays before reading it.
+	static uint32 countAnimationCurveKeys(const fbx_node& node, const std::vector<fbx_node>& nodes, const std::vector<fbx_property>& properties)
+	{
+		const fbx_node* keyTimeNode = node.findChild(nodes, "KeyTime");
+		const fbx_property* prop = keyTimeNode ? keyTimeNode->getFirstProperty(properties) : 0;
+		return prop ? prop->numElements : 0;
+	}
+
+	// Reads the keys into times[first, first + count) and values[first, first + count).
 	static fbx_animation_curve readAnimationCurve(const fbx_node& node, const std::vector<fbx_node>& nodes, const std::vector<fbx_property>& properties,
-		std::vector<int64>& times, std::vector<float>& values)
+		int64* times, float* values, uint32 first, uint32 count)
 	{
 		auto [id, name] = readObjectIDAndName(node, properties);
 		fbx_animation_curve result = {};
 		result.id = id;
 		result.name = name;
 
-		uint32 first = (uint32)times.size();
-
 		for (const fbx_node& child : fbx_node_iterator{ &node, nodes })
 		{
 			if (child.name == "Default")
@@ -1474,18 +1668,15 @@ namespace era_engine
 				const fbx_property& prop = *child.getFirstProperty(properties);
 				ASSERT(prop.type == fbx_property_type_int64);
 
-				uint32 count = prop.numElements;
-				times.resize(times.size() + count);
-				readArray(prop, (uint8*)(times.data() + first));
+				readArray(prop, (uint8*)(times + first), count * sizeof(int64));
 			}
 			else if (child.name == "KeyValueFloat")
 			{
 				const fbx_property& prop = *child.getFirstProperty(properties);
 				ASSERT(prop.type == fbx_property_type_float);
+				ASSERT(prop.numElements == count);
 
-				uint32 count = prop.numElements;
-				values.resize(values.size() + count);
-				readArray(prop, (uint8*)(values.data() + first));
+				readArray(prop, (uint8*)(values + first), count * sizeof(float));
 			}
 			else if (child.name == "KeyAttrFlags")
 			{
@@ -1493,15 +1684,24 @@ namespace era_engine
 			}
 		}
 
-		ASSERT(times.size() == values.size());
-
-		uint32 count = (uint32)times.size() - first;
 		result.first = first;
 		result.count = count;
 
 		return result;
 	}
 
+	static fbx_animation_curve readAnimationCurve(const fbx_node& node, const std::vector<fbx_node>& nodes, const std::vector<fbx_property>& properties,
+		std::vector<int64>& times, std::vector<float>& values)
+	{
+		uint32 first = (uint32)times.size();
+		uint32 count = countAnimationCurveKeys(node, nodes, properties);
+
+		times.resize(first + count);
+		values.resize(first + count);
+
+		return readAnimationCurve(node, nodes, properties, times.data(), values.data(), first, count);
+	}
+
 	struct fbx_animation_joint
 	{
 		union
@@ -1775,7 +1975,8 @@ namespace era_engine
 		}
 	}
 
-	static void finishMesh(fbx_mesh& mesh, uint32 flags, std::unordered_map<int64, fbx_skeleton>& skeletons)
+	// Meshes are finished in parallel, so 'skeletons' must already contain the skeleton of every skinned mesh.
+	static void finishMesh(fbx_mesh& mesh, uint32 flags, const std::unordered_map<int64, fbx_skeleton>& skeletons)
 	{
 		// Assign materials and skinning weights, remove duplicate vertices and triangulate.
 
@@ -1784,7 +1985,7 @@ namespace era_engine
 			PROFILE("Assigning skinning weights");
 
 			mesh.skin.resize(mesh.positions.size(), {});
-			fbx_skeleton& skeleton = skeletons[mesh.skeletonID];
+			const fbx_skeleton& skeleton = skeletons.at(mesh.skeletonID);
 
 			for (uint32 jointID = 0; jointID < (uint32)skeleton.joints.size(); ++jointID)
 			{
@@ -1853,18 +2054,18 @@ namespace era_engine
 				per_material& perMat = materialToMesh[material];
 				perMat.sub.material_index = material;
 
-				perMat.addTriangles(mesh.positions, mesh.uvs, mesh.normals, mesh.tangents, mesh.colors, mesh.skin, firstIndex, faceSize, mesh.submeshes);
+				perMat.addTriangles(mesh.positions, mesh.uvs, mesh.normals, mesh.tangents, mesh.colors, mesh.skin, firstIndex, faceSize);
 
 				firstIndex += faceSize;
 			}
 		}
 
-		for (auto [i, perMat] : materialToMesh)
+		for (auto& [i, perMat] : materialToMesh)
 		{
 			perMat.flush(mesh.submeshes);
 		}
 
-		generateNormalsAndTangents(mesh.submeshes, flags);
+		postprocessSubmeshes(mesh.submeshes, flags);
 	}
 
 	static float sampleAnimationCurve(fbx_animation_curve* curve, int64 time, const std::vector<int64>& animationTimes, const std::vector<float>& animationValues)
@@ -1987,6 +2188,228 @@ namespace era_engine
 		return { (uint32)outValues.size(), 0 };
 	}
 
+	static fbx_object_type getObjectType(sized_string nodeName)
+	{
+		if (nodeName == "Model") { return fbx_object_type_model; }
+		else if (nodeName == "Geometry") { return fbx_object_type_mesh; }
+		else if (nodeName == "Material") { return fbx_object_type_material; }
+		else if (nodeName == "Texture") { return fbx_object_type_texture; }
+		else if (nodeName == "Deformer") { return fbx_object_type_deformer; }
+		else if (nodeName == "AnimationStack") { return fbx_object_type_animation_stack; }
+		else if (nodeName == "AnimationLayer") { return fbx_object_type_animation_layer; }
+		else if (nodeName == "AnimationCurveNode") { return fbx_object_type_animation_curve_node; }
+		else if (nodeName == "AnimationCurve") { return fbx_object_type_animation_curve; }
+		return fbx_object_type_none;
+	}
+
+	static void readObjects(const fbx_node* objectsNode, const std::vector<fbx_node>& nodes, const std::vector<fbx_property>& properties, uint32 flags,
+		fbx_object_lut& lut, std::vector<int64>& animationTimes, std::vector<float>& animationValues)
+	{
+		for (const fbx_node& objectNode : fbx_node_iterator{ objectsNode, nodes })
+		{
+			if (objectNode.name == "Model")
+			{
+				lut.push(readModel(objectNode, nodes, properties));
+			}
+			if (objectNode.name == "Geometry")
+			{
+				lut.push(readMesh(objectNode, nodes, properties, flags));
+			}
+			else if (objectNode.name == "Material")
+			{
+				lut.push(readMaterial(objectNode, nodes, properties));
+			}
+			else if (objectNode.name == "Texture")
+			{
+				lut.push(readTexture(objectNode, nodes, properties));
+			}
+			else if (objectNode.name == "Deformer")
+			{
+				lut.push(readDeformer(objectNode, nodes, properties));
+			}
+			else if (objectNode.name == "AnimationStack")
+			{
+				lut.push(readAnimationStack(objectNode, nodes, properties));
+			}
+			else if (objectNode.name == "AnimationLayer")
+			{
+				lut.push(readAnimationLayer(objectNode, nodes, properties));
+			}
+			else if (objectNode.name == "AnimationCurveNode")
+			{
+				lut.push(readAnimationCurveNode(objectNode, nodes, properties));
+			}
+			else if (objectNode.name == "AnimationCurve")
+			{
+				lut.push(readAnimationCurve(objectNode, nodes, properties, animationTimes, animationValues));
+			}
+		}
+	}
+
+	// Reads the children of the 'Objects' node into the LUT, decoding the objects (and their compressed arrays) in parallel.
+	// Objects are decoded into per type arrays and pushed in file order afterwards, and every animation curve gets its key range up front,
+	// so the LUT and the key arrays end up exactly as with readObjects.
+	static void readObjectsParallel(const fbx_node* objectsNode, const std::vector<fbx_node>& nodes, const std::vector<fbx_property>& properties, uint32 flags,
+		fbx_object_lut& lut, std::vector<int64>& animationTimes, std::vector<float>& animationValues)
+	{
+		struct fbx_object_entry
+		{
+			const fbx_node* node;
+			fbx_object_type type;
+			uint32 index;
+		};
+
+		std::vector<fbx_object_entry> objects;
+		objects.reserve(objectsNode->numChildren);
+
+		uint32 numObjects[fbx_object_type_animation_curve + 1] = {};
+		std::vector<offset_count> curveKeys;
+		uint32 numKeys = (uint32)animationTimes.size();
+
+		for (const fbx_node& objectNode : fbx_node_iterator{ objectsNode, nodes })
+		{
+			fbx_object_type type = getObjectType(objectNode.name);
+			if (type == fbx_object_type_none)
+			{
+				continue;
+			}
+
+			objects.push_back({ &objectNode, type, numObjects[type]++ });
+
+			if (type == fbx_object_type_animation_curve)
+			{
+				uint32 count = countAnimationCurveKeys(objectNode, nodes, properties);
+				curveKeys.push_back({ numKeys, count });
+				numKeys += count;
+			}
+		}
+
+		animationTimes.resize(numKeys);
+		animationValues.resize(numKeys);
+
+		std::vector<fbx_model> models(numObjects[fbx_object_type_model]);
+		std::vector<fbx_mesh> meshes(numObjects[fbx_object_type_mesh]);
+		std::vector<fbx_material> materials(numObjects[fbx_object_type_material]);
+		std::vector<fbx_texture> textures(numObjects[fbx_object_type_texture]);
+		std::vector<fbx_deformer> deformers(numObjects[fbx_object_type_deformer]);
+		std::vector<fbx_animation_stack> animationStacks(numObjects[fbx_object_type_animation_stack]);
+		std::vector<fbx_animation_layer> animationLayers(numObjects[fbx_object_type_animation_layer]);
+		std::vector<fbx_animation_curve_node> animationCurveNodes(numObjects[fbx_object_type_animation_curve_node]);
+		std::vector<fbx_animation_curve> animationCurves(numObjects[fbx_object_type_animation_curve]);
+
+		// Geometry first, so that the most expensive objects don't end up at the tail of the loop.
+		std::vector<const fbx_object_entry*> decodeOrder;
+		decodeOrder.reserve(objects.size());
+		for (const fbx_object_entry& object : objects)
+		{
+			if (object.type == fbx_object_type_mesh)
+			{
+				decodeOrder.push_back(&object);
+			}
+		}
+		for (const fbx_object_entry& object : objects)
+		{
+			if (object.type != fbx_object_type_mesh)
+			{
+				decodeOrder.push_back(&object);
+			}
+		}
+
+		parallel_for(0, (uint32)decodeOrder.size(), 1, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				const fbx_object_entry& object = *decodeOrder[i];
+				const fbx_node& node = *object.node;
+
+				switch (object.type)
+				{
+				case fbx_object_type_model: models[object.index] = readModel(node, nodes, properties); break;
+				case fbx_object_type_mesh: meshes[object.index] = readMesh(node, nodes, properties, flags); break;
+				case fbx_object_type_material: materials[object.index] = readMaterial(node, nodes, properties); break;
+				case fbx_object_type_texture: textures[object.index] = readTexture(node, nodes, properties); break;
+				case fbx_object_type_deformer: deformers[object.index] = readDeformer(node, nodes, properties); break;
+				case fbx_object_type_animation_stack: animationStacks[object.index] = readAnimationStack(node, nodes, properties); break;
+				case fbx_object_type_animation_layer: animationLayers[object.index] = readAnimationLayer(node, nodes, properties); break;
+				case fbx_object_type_animation_curve_node: animationCurveNodes[object.index] = readAnimationCurveNode(node, nodes, properties); break;
+				case fbx_object_type_animation_curve:
+				{
+					offset_count keys = curveKeys[object.index];
+					animationCurves[object.index] = readAnimationCurve(node, nodes, properties, animationTimes.data(), animationValues.data(), keys.offset, keys.count);
+				} break;
+				default: ASSERT(false); break;
+				}
+			}
+		});
+
+		for (const fbx_object_entry& object : objects)
+		{
+			switch (object.type)
+			{
+			case fbx_object_type_model: lut.push(std::move(models[object.index])); break;
+			case fbx_object_type_mesh: lut.push(std::move(meshes[object.index])); break;
+			case fbx_object_type_material: lut.push(std::move(materials[object.index])); break;
+			case fbx_object_type_texture: lut.push(std::move(textures[object.index])); break;
+			case fbx_object_type_deformer: lut.push(std::move(deformers[object.index])); break;
+			case fbx_object_type_animation_stack: lut.push(std::move(animationStacks[object.index])); break;
+			case fbx_object_type_animation_layer: lut.push(std::move(animationLayers[object.index])); break;
+			case fbx_object_type_animation_curve_node: lut.push(std::move(animationCurveNodes[object.index])); break;
+			case fbx_object_type_animation_curve: lut.push(std::move(animationCurves[object.index])); break;
+			default: ASSERT(false); break;
+			}
+		}
+	}
+
+	// Resampled keyframes of one animated joint. Offsets are relative to the arrays in here.
+	struct fbx_joint_keyframes
+	{
+		offset_count position;
+		offset_count rotation;
+		offset_count scale;
+
+		std::vector<vec3> positionKeyframes;
+		std::vector<float> positionTimestamps;
+		std::vector<quat> rotationKeyframes;
+		std::vector<float> rotationTimestamps;
+		std::vector<vec3> scaleKeyframes;
+		std::vector<float> scaleTimestamps;
+	};
+
+	static fbx_joint_keyframes sampleJointKeyframes(const fbx_animation_joint& joint, int64 duration, const std::vector<int64>& animationTimes, const std::vector<float>& animationValues,
+		rotation_order rotationOrder, uint32 flags)
+	{
+		fbx_joint_keyframes result = {};
+
+		if (joint.curveNodes[0])
+		{
+			result.position = transferAnimationCurve(joint.curveNodes[0], result.positionKeyframes, result.positionTimestamps, duration,
+				animationTimes, animationValues, flags & mesh_creation_flags_sm_to_m);
+		}
+
+		if (joint.curveNodes[1])
+		{
+			result.rotation = transferAnimationCurve(joint.curveNodes[1], result.rotationKeyframes, result.rotationTimestamps, duration,
+				animationTimes, animationValues, rotationOrder, flags);
+		}
+
+		if (joint.curveNodes[2])
+		{
+			result.scale = transferAnimationCurve(joint.curveNodes[2], result.scaleKeyframes, result.scaleTimestamps, duration,
+				animationTimes, animationValues);
+		}
+
+		return result;
+	}
+
+	template <typename T>
+	static uint32 appendKeyframes(std::vector<T>& outValues, std::vector<float>& outTimes, const std::vector<T>& values, const std::vector<float>& times, offset_count range)
+	{
+		uint32 offset = (uint32)outValues.size();
+		outValues.insert(outValues.end(), values.begin(), values.end());
+		outTimes.insert(outTimes.end(), times.begin(), times.end());
+		return offset + range.offset;
+	}
+
 	static const fbx_node* findNode(const std::vector<fbx_node>& nodes, std::initializer_list<sized_string> names)
 	{
 		uint32 currentNode = nodes[0].firstChild;
@@ -2014,11 +2437,11 @@ namespace era_engine
 		return 0;
 	}
 
-	ModelAsset loadFBX(const fs::path& path, uint32 flags)
+	ModelAsset loadFBX(const fs::path& path, uint32 flags, bool parallel)
 	{
 		std::string pathStr = path.string();
 		const char* s = pathStr.c_str();
-		EntireFile file = load_file(path);
+		EntireFile file = map_file(path);
 		if (file.size < sizeof(fbx_header))
 		{
 			printf("File '%s' is smaller than FBX header.\n", s);
@@ -2050,7 +2473,10 @@ namespace era_engine
 
 		{
 			PROFILE("Parse FBX nodes");
-			parseNodes(version, file, nodes, properties, 0, 0);
+			if (!parallel || !parseNodesParallel(version, file, nodes, properties))
+			{
+				parseNodes(version, file, nodes, properties, 0, 0);
+			}
 		}
 
 #if 0
@@ -2079,44 +2505,13 @@ namespace era_engine
 			objectLUT.idToObject.reserve(objectsNode->numChildren + 1);
 			objectLUT.idToObject[0] = { fbx_object_type_global, 0 };
 
-			for (const fbx_node& objectNode : fbx_node_iterator{ objectsNode, nodes })
+			if (parallel)
 			{
-				if (objectNode.name == "Model")
-				{
-					objectLUT.push(readModel(objectNode, nodes, properties));
-				}
-				if (objectNode.name == "Geometry")
-				{
-					objectLUT.push(readMesh(objectNode, nodes, properties, flags));
-				}
-				else if (objectNode.name == "Material")
-				{
-					objectLUT.push(readMaterial(objectNode, nodes, properties));
-				}
-				else if (objectNode.name == "Texture")
-				{
-					objectLUT.push(readTexture(objectNode, nodes, properties));
-				}
-				else if (objectNode.name == "Deformer")
-				{
-					objectLUT.push(readDeformer(objectNode, nodes, properties));
-				}
-				else if (objectNode.name == "AnimationStack")
-				{
-					objectLUT.push(readAnimationStack(objectNode, nodes, properties));
-				}
-				else if (objectNode.name == "AnimationLayer")
-				{
-					objectLUT.push(readAnimationLayer(objectNode, nodes, properties));
-				}
-				else if (objectNode.name == "AnimationCurveNode")
-				{
-					objectLUT.push(readAnimationCurveNode(objectNode, nodes, properties));
-				}
-				else if (objectNode.name == "AnimationCurve")
-				{
-					objectLUT.push(readAnimationCurve(objectNode, nodes, properties, animationTimes, animationValues));
-				}
+				readObjectsParallel(objectsNode, nodes, properties, flags, objectLUT, animationTimes, animationValues);
+			}
+			else
+			{
+				readObjects(objectsNode, nodes, properties, flags, objectLUT, animationTimes, animationValues);
 			}
 		}
 
@@ -2127,9 +2522,31 @@ namespace era_engine
 
 		{
 			PROFILE("Finishing FBX meshes");
+
+			// Skinned meshes without joints still get an (empty) skeleton.
 			for (fbx_mesh& mesh : objectLUT.meshes)
 			{
-				finishMesh(mesh, flags, objectLUT.skeletons);
+				if (mesh.skeletonID && flags & mesh_flag_load_skin)
+				{
+					objectLUT.skeletons[mesh.skeletonID];
+				}
+			}
+
+			auto finishMeshes = [&](uint32 begin, uint32 end)
+			{
+				for (uint32 i = begin; i < end; ++i)
+				{
+					finishMesh(objectLUT.meshes[i], flags, objectLUT.skeletons);
+				}
+			};
+
+			if (parallel)
+			{
+				parallel_for(0, (uint32)objectLUT.meshes.size(), 1, finishMeshes);
+			}
+			else
+			{
+				finishMeshes(0, (uint32)objectLUT.meshes.size());
 			}
 		}
 
@@ -2213,6 +2630,37 @@ namespace era_engine
 			result.skeletons.push_back(std::move(out));
 		}
 
+		// Joints are resampled independently of each other and then appended in the same order as the serial loop would.
+		std::vector<std::pair<const fbx_animation*, const fbx_animation_joint*>> animatedJoints;
+		for (const fbx_animation& animation : objectLUT.animations)
+		{
+			for (auto& [id, j] : animation.joints)
+			{
+				animatedJoints.push_back({ &animation, &j });
+			}
+		}
+
+		std::vector<fbx_joint_keyframes> jointKeyframes(animatedJoints.size());
+
+		auto sampleJoints = [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				auto [animation, j] = animatedJoints[i];
+				jointKeyframes[i] = sampleJointKeyframes(*j, animation->duration, animationTimes, animationValues, definitions.defaultRotationOrder, flags);
+			}
+		};
+
+		if (parallel)
+		{
+			parallel_for(0, (uint32)animatedJoints.size(), 1, sampleJoints);
+		}
+		else
+		{
+			sampleJoints(0, (uint32)animatedJoints.size());
+		}
+
+		uint32 animatedJointIndex = 0;
 		for (fbx_animation& animation : objectLUT.animations)
 		{
 			uint32 numJoints = (uint32)animation.joints.size();
@@ -2235,28 +2683,27 @@ namespace era_engine
 					animation::AnimationJoint& joint = out.joints[name];
 					joint.is_animated = true;
 
+					const fbx_joint_keyframes& keyframes = jointKeyframes[animatedJointIndex++];
+
 					if (j.curveNodes[0])
 					{
-						offset_count position = transferAnimationCurve(j.curveNodes[0], out.position_keyframes, out.position_timestamps, animation.duration,
-							animationTimes, animationValues, flags & mesh_creation_flags_sm_to_m);
-						joint.first_position_keyframe = position.offset;
-						joint.num_position_keyframes = position.count;
+						joint.first_position_keyframe = appendKeyframes(out.position_keyframes, out.position_timestamps,
+							keyframes.positionKeyframes, keyframes.positionTimestamps, keyframes.position);
+						joint.num_position_keyframes = keyframes.position.count;
 					}
 
 					if (j.curveNodes[1])
 					{
-						offset_count rotation = transferAnimationCurve(j.curveNodes[1], out.rotation_keyframes, out.rotation_timestamps, animation.duration,
-							animationTimes, animationValues, definitions.defaultRotationOrder, flags);
-						joint.first_rotation_keyframe = rotation.offset;
-						joint.num_rotation_keyframes = rotation.count;
+						joint.first_rotation_keyframe = appendKeyframes(out.rotation_keyframes, out.rotation_timestamps,
+							keyframes.rotationKeyframes, keyframes.rotationTimestamps, keyframes.rotation);
+						joint.num_rotation_keyframes = keyframes.rotation.count;
 					}
 
 					if (j.curveNodes[2])
 					{
-						offset_count scale = transferAnimationCurve(j.curveNodes[2], out.scale_keyframes, out.scale_timestamps, animation.duration,
-							animationTimes, animationValues);
-						joint.first_scale_keyframe = scale.offset;
-						joint.num_scale_keyframes = scale.count;
+						joint.first_scale_keyframe = appendKeyframes(out.scale_keyframes, out.scale_timestamps,
+							keyframes.scaleKeyframes, keyframes.scaleTimestamps, keyframes.scale);
+						joint.num_scale_keyframes = keyframes.scale.count;
 					}
 				}
 
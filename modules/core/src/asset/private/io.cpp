@@ -1,5 +1,12 @@
 #include "asset/io.h"
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace era_engine
 {
 	EntireFile load_file(const fs::path& path)
@@ -10,10 +17,15 @@ namespace era_engine
 			return {};
 		}
 
-		fseek(file, 0, SEEK_END);
-		uint32 file_size = ftell(file);
+#if defined(_WIN32)
+		_fseeki64(file, 0, SEEK_END);
+		const uint64 file_size = (uint64)_ftelli64(file);
+#else
+		fseeko(file, 0, SEEK_END);
+		const uint64 file_size = (uint64)ftello(file);
+#endif
 
-		if (file_size == 0)
+		if (file_size == 0 || file_size == (uint64)-1)
 		{
 			fclose(file);
 			return {};
@@ -21,14 +33,126 @@ namespace era_engine
 
 		fseek(file, 0, SEEK_SET);
 		uint8* buffer = (uint8*)malloc(file_size);
-		fread(buffer, file_size, 1, file);
+		if (!buffer || fread(buffer, file_size, 1, file) != 1)
+		{
+			free(buffer);
+			fclose(file);
+			return {};
+		}
 		fclose(file);
 
 		return { buffer, file_size };
 	}
 
+#if defined(_WIN32)
+
+	EntireFile map_file(const fs::path& path, FileAccessHint hint)
+	{
+		const DWORD flags = (hint == FileAccessHint::Sequential) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return {};
+		}
+
+		LARGE_INTEGER file_size = {};
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return {};
+		}
+
+		HANDLE mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+		CloseHandle(file);
+		if (!mapping)
+		{
+			return load_file(path);
+		}
+
+		// The view keeps the mapping alive.
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!view)
+		{
+			return load_file(path);
+		}
+
+		if (hint == FileAccessHint::Sequential)
+		{
+			WIN32_MEMORY_RANGE_ENTRY range = { view, (SIZE_T)file_size.QuadPart };
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+
+		EntireFile result = { (uint8*)view, (uint64)file_size.QuadPart };
+		result.is_mapped = true;
+		return result;
+	}
+
+	void free_file(const EntireFile& file)
+	{
+		if (file.is_mapped)
+		{
+			UnmapViewOfFile(file.content);
+		}
+		else
+		{
+			free(file.content);
+		}
+	}
+
+#else
+
+	EntireFile map_file(const fs::path& path, FileAccessHint hint)
+	{
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return {};
+		}
+
+		struct stat file_stat = {};
+		if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+		{
+			close(fd);
+			return {};
+		}
+
+		const uint64 file_size = (uint64)file_stat.st_size;
+
+		// The mapping keeps the file alive.
+		void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED)
+		{
+			return load_file(path);
+		}
+
+		if (hint == FileAccessHint::Sequential)
+		{
+			madvise(view, file_size, MADV_SEQUENTIAL);
+			madvise(view, file_size, MADV_WILLNEED);
+		}
+		else
+		{
+			madvise(view, file_size, MADV_RANDOM);
+		}
+
+		EntireFile result = { (uint8*)view, file_size };
+		result.is_mapped = true;
+		return result;
+	}
+
 	void free_file(const EntireFile& file)
 	{
-		free(file.content);
+		if (file.is_mapped)
+		{
+			munmap(file.content, file.size);
+		}
+		else
+		{
+			free(file.content);
+		}
 	}
+
+#endif
 }
@@ -3,214 +3,648 @@
 #include "asset/mesh_postprocessing.h"
 
 #include "core/cpu_profiling.h"
+#include "core/job_system.h"
+#include "core/math_simd.h"
 
 namespace era_engine
 {
-	void generateNormalsAndTangents(std::vector<SubmeshAsset>& submeshes, uint32 flags)
+	// Triangles or vertices per job. Smaller submeshes are processed by a single job.
+	static constexpr uint32 mesh_postprocessing_grain = 4096;
+
+	// Simulated FIFO-ish LRU cache size for the vertex cache optimization. Larger than any real post transform cache,
+	// which is what Forsyth recommends, since the result then degrades gracefully on smaller ones.
+	static constexpr uint32 vertex_cache_size = 32;
+
+	// The triangles using vertex v are triangles[offsets[v]] to triangles[offsets[v + 1] - 1], in ascending order.
+	struct vertex_triangle_adjacency
 	{
-		if (flags & mesh_flag_gen_tangents)
+		std::vector<uint32> offsets;
+		std::vector<uint32> triangles;
+	};
+
+	template <typename triangle_t>
+	static void buildVertexTriangleAdjacency(const std::vector<triangle_t>& triangles, uint32 numVertices, vertex_triangle_adjacency& out)
+	{
+		const uint32 numTriangles = (uint32)triangles.size();
+
+		out.offsets.assign(numVertices + 1, 0);
+		for (const triangle_t& tri : triangles)
 		{
-			flags |= mesh_flag_gen_normals;
+			++out.offsets[tri.a + 1];
+			++out.offsets[tri.b + 1];
+			++out.offsets[tri.c + 1];
+		}
+		for (uint32 v = 0; v < numVertices; ++v)
+		{
+			out.offsets[v + 1] += out.offsets[v];
 		}
 
-		for (SubmeshAsset& sub : submeshes)
+		std::vector<uint32> cursor(out.offsets.begin(), out.offsets.end() - 1);
+		out.triangles.resize(out.offsets[numVertices]);
+		for (uint32 t = 0; t < numTriangles; ++t)
 		{
-			if (sub.normals.empty() && flags & mesh_flag_gen_normals)
+			const triangle_t& tri = triangles[t];
+			out.triangles[cursor[tri.a]++] = t;
+			out.triangles[cursor[tri.b]++] = t;
+			out.triangles[cursor[tri.c]++] = t;
+		}
+	}
+
+	// Per triangle vectors, stored as SoA so that eight of them can be written at once.
+	struct face_vectors
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+
+		void resize(uint32 count) { x.resize(count); y.resize(count); z.resize(count); }
+		void store(uint32 index, vec3 v) { x[index] = v.x; y[index] = v.y; z[index] = v.z; }
+
+		// Sums the vectors of all triangles using 'vertex'. Triangles are visited in ascending order, so the result
+		// is the same as with the serial scatter this replaces.
+		vec3 gather(const vertex_triangle_adjacency& adjacency, uint32 vertex) const
+		{
+			vec3 result(0.f);
+			for (uint32 i = adjacency.offsets[vertex], end = adjacency.offsets[vertex + 1]; i < end; ++i)
 			{
-				printf("Generating normals\n");
-				CPU_PRINT_PROFILE_BLOCK("Generating normals");
+				const uint32 t = adjacency.triangles[i];
+				result += vec3(x[t], y[t], z[t]);
+			}
+			return result;
+		}
+	};
 
-				sub.normals.resize(sub.positions.size(), vec3(0.f));
-				for (indexed_triangle16 tri : sub.triangles)
-				{
-					vec3 a = sub.positions[tri.a];
-					vec3 b = sub.positions[tri.b];
-					vec3 c = sub.positions[tri.c];
-
-					vec3 n = cross(b - a, c - a);
-					sub.normals[tri.a] += n;
-					sub.normals[tri.b] += n;
-					sub.normals[tri.c] += n;
-				}
-				for (vec3& n : sub.normals)
+	static vec3 faceNormal(vec3 a, vec3 b, vec3 c)
+	{
+		return cross(b - a, c - a);
+	}
+
+	static vec3 faceTangent(vec3 a, vec3 b, vec3 c, vec2 h, vec2 k, vec2 l)
+	{
+		vec3 d = b - a;
+		vec3 e = c - a;
+
+		vec2 f = k - h;
+		vec2 g = l - h;
+
+		float invDet = 1.f / (f.x * g.y - f.y * g.x);
+
+		vec3 t;
+		t.x = g.y * d.x - f.y * e.x;
+		t.y = g.y * d.y - f.y * e.y;
+		t.z = g.y * d.z - f.y * e.z;
+		return t * invDet;
+	}
+
+#if defined(SIMD_AVX_2)
+	// Offsets (in floats) of the corners of eight consecutive triangles in an array of 'stride' floats per vertex.
+	template <typename triangle_t>
+	static void loadCornerOffsets(const triangle_t* triangles, int32 stride, __m256i& a, __m256i& b, __m256i& c)
+	{
+		alignas(32) int32 offsetsA[8];
+		alignas(32) int32 offsetsB[8];
+		alignas(32) int32 offsetsC[8];
+		for (uint32 i = 0; i < 8; ++i)
+		{
+			offsetsA[i] = (int32)triangles[i].a * stride;
+			offsetsB[i] = (int32)triangles[i].b * stride;
+			offsetsC[i] = (int32)triangles[i].c * stride;
+		}
+		a = _mm256_load_si256((const __m256i*)offsetsA);
+		b = _mm256_load_si256((const __m256i*)offsetsB);
+		c = _mm256_load_si256((const __m256i*)offsetsC);
+	}
+
+	static w8_vec3 gatherVec3(const float* base, __m256i offsets)
+	{
+		return w8_vec3(w8_float(base, offsets), w8_float(base + 1, offsets), w8_float(base + 2, offsets));
+	}
+
+	static w8_vec2 gatherVec2(const float* base, __m256i offsets)
+	{
+		return w8_vec2(w8_float(base, offsets), w8_float(base + 1, offsets));
+	}
+#endif
+
+	template <typename triangle_t>
+	static void computeFaceNormals(const SubmeshAsset& sub, const std::vector<triangle_t>& triangles, uint32 begin, uint32 end, face_vectors& out)
+	{
+		uint32 t = begin;
+
+#if defined(SIMD_AVX_2)
+		const float* positions = (const float*)sub.positions.data();
+		for (; t + 8 <= end; t += 8)
+		{
+			__m256i a, b, c;
+			loadCornerOffsets(triangles.data() + t, 3, a, b, c);
+
+			w8_vec3 pa = gatherVec3(positions, a);
+			w8_vec3 n = cross(gatherVec3(positions, b) - pa, gatherVec3(positions, c) - pa);
+
+			n.x.store(out.x.data() + t);
+			n.y.store(out.y.data() + t);
+			n.z.store(out.z.data() + t);
+		}
+#endif
+
+		for (; t < end; ++t)
+		{
+			const triangle_t& tri = triangles[t];
+			out.store(t, faceNormal(sub.positions[tri.a], sub.positions[tri.b], sub.positions[tri.c]));
+		}
+	}
+
+	template <typename triangle_t>
+	static void computeFaceTangents(const SubmeshAsset& sub, const std::vector<triangle_t>& triangles, uint32 begin, uint32 end, face_vectors& out)
+	{
+		uint32 t = begin;
+
+#if defined(SIMD_AVX_2)
+		const float* positions = (const float*)sub.positions.data();
+		const float* uvs = (const float*)sub.uvs.data();
+		for (; t + 8 <= end; t += 8)
+		{
+			__m256i a, b, c;
+			loadCornerOffsets(triangles.data() + t, 3, a, b, c);
+
+			w8_vec3 pa = gatherVec3(positions, a);
+			w8_vec3 d = gatherVec3(positions, b) - pa;
+			w8_vec3 e = gatherVec3(positions, c) - pa;
+
+			loadCornerOffsets(triangles.data() + t, 2, a, b, c);
+
+			w8_vec2 ua = gatherVec2(uvs, a);
+			w8_vec2 f = gatherVec2(uvs, b) - ua;
+			w8_vec2 g = gatherVec2(uvs, c) - ua;
+
+			w8_float invDet = w8_float(1.f) / (f.x * g.y - f.y * g.x);
+			w8_vec3 tangent = (d * g.y - e * f.y) * invDet;
+
+			tangent.x.store(out.x.data() + t);
+			tangent.y.store(out.y.data() + t);
+			tangent.z.store(out.z.data() + t);
+		}
+#endif
+
+		for (; t < end; ++t)
+		{
+			const triangle_t& tri = triangles[t];
+			out.store(t, faceTangent(sub.positions[tri.a], sub.positions[tri.b], sub.positions[tri.c], sub.uvs[tri.a], sub.uvs[tri.b], sub.uvs[tri.c]));
+		}
+	}
+
+	template <typename triangle_t>
+	static void generateSubmeshNormalsAndTangents(SubmeshAsset& sub, const std::vector<triangle_t>& triangles, uint32 flags)
+	{
+		const bool generateNormals = sub.normals.empty() && (flags & mesh_flag_gen_normals);
+		const bool generateTangents = sub.tangents.empty() && (flags & mesh_flag_gen_tangents);
+		if (!generateNormals && !generateTangents)
+		{
+			return;
+		}
+
+		CPU_PROFILE_BLOCK("Generating normals and tangents");
+
+		const uint32 numVertices = (uint32)sub.positions.size();
+		const uint32 numTriangles = (uint32)triangles.size();
+
+		vertex_triangle_adjacency adjacency;
+		face_vectors faces;
+		if (generateNormals || !sub.uvs.empty())
+		{
+			buildVertexTriangleAdjacency(triangles, numVertices, adjacency);
+			faces.resize(numTriangles);
+		}
+
+		if (generateNormals)
+		{
+			sub.normals.resize(numVertices);
+
+			parallel_for(0, numTriangles, mesh_postprocessing_grain, [&](uint32 begin, uint32 end)
+			{
+				computeFaceNormals(sub, triangles, begin, end, faces);
+			});
+
+			parallel_for(0, numVertices, mesh_postprocessing_grain, [&](uint32 begin, uint32 end)
+			{
+				for (uint32 v = begin; v < end; ++v)
 				{
-					n = normalize(n);
+					sub.normals[v] = normalize(faces.gather(adjacency, v));
 				}
-			}
+			});
+		}
+
+		if (generateTangents)
+		{
+			sub.tangents.resize(numVertices);
 
-			if (sub.tangents.empty() && flags & mesh_flag_gen_tangents)
+			if (!sub.uvs.empty())
 			{
-				printf("Generating tangents\n");
-				CPU_PRINT_PROFILE_BLOCK("Generating tangents");
+				parallel_for(0, numTriangles, mesh_postprocessing_grain, [&](uint32 begin, uint32 end)
+				{
+					computeFaceTangents(sub, triangles, begin, end, faces);
+				});
 
-				sub.tangents.resize(sub.positions.size(), vec3(0.f));
-				if (!sub.uvs.empty())
+				parallel_for(0, numVertices, mesh_postprocessing_grain, [&](uint32 begin, uint32 end)
 				{
-					for (indexed_triangle16 tri : sub.triangles)
+					for (uint32 v = begin; v < end; ++v)
 					{
-						vec3 a = sub.positions[tri.a];
-						vec3 b = sub.positions[tri.b];
-						vec3 c = sub.positions[tri.c];
-
-						vec2 h = sub.uvs[tri.a];
-						vec2 k = sub.uvs[tri.b];
-						vec2 l = sub.uvs[tri.c];
-
-						vec3 d = b - a;
-						vec3 e = c - a;
-
-						vec2 f = k - h;
-						vec2 g = l - h;
-
-						float invDet = 1.f / (f.x * g.y - f.y * g.x);
-
-						vec3 t;
-						t.x = g.y * d.x - f.y * e.x;
-						t.y = g.y * d.y - f.y * e.y;
-						t.z = g.y * d.z - f.y * e.z;
-						t *= invDet;
-						sub.tangents[tri.a] += t;
-						sub.tangents[tri.b] += t;
-						sub.tangents[tri.c] += t;
-					}
-					for (uint32 i = 0; i < (uint32)sub.positions.size(); ++i)
-					{
-						vec3 t = sub.tangents[i];
-						vec3 n = sub.normals[i];
+						vec3 t = faces.gather(adjacency, v);
+						vec3 n = sub.normals[v];
 
 						vec3 b = cross(t, n);
 						t = cross(n, b);
 
-						sub.tangents[i] = normalize(t);
+						sub.tangents[v] = normalize(t);
 					}
-				}
-				else
+				});
+			}
+			else
+			{
+				// Mesh has no UVs, so the tangents are suboptimal.
+				parallel_for(0, numVertices, mesh_postprocessing_grain, [&](uint32 begin, uint32 end)
 				{
-					printf("Mesh has no UVs. Generating suboptimal tangents.\n");
-					for (uint32 i = 0; i < (uint32)sub.positions.size(); ++i)
+					for (uint32 v = begin; v < end; ++v)
 					{
-						sub.tangents[i] = get_tangent(sub.normals[i]);
+						sub.tangents[v] = get_tangent(sub.normals[v]);
 					}
-				}
+				});
 			}
 		}
 	}
 
-	void generateNormalsAndTangents(ref<SubmeshAsset> submesh, uint32 flags)
+	static uint32 getGenerationFlags(uint32 flags)
 	{
+		// Tangents are orthogonalized against the normals, so they can't be generated without them.
 		if (flags & mesh_flag_gen_tangents)
 		{
 			flags |= mesh_flag_gen_normals;
 		}
+		return flags;
+	}
+
+	static void generateSubmeshNormalsAndTangents(SubmeshAsset& sub, uint32 flags)
+	{
+		if (!sub.triangles32.empty())
+		{
+			generateSubmeshNormalsAndTangents(sub, sub.triangles32, flags);
+		}
+		else
+		{
+			generateSubmeshNormalsAndTangents(sub, sub.triangles, flags);
+		}
+	}
+
+	void generateNormalsAndTangents(std::vector<SubmeshAsset>& submeshes, uint32 flags)
+	{
+		flags = getGenerationFlags(flags);
+
+		parallel_for(0, (uint32)submeshes.size(), 1, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				generateSubmeshNormalsAndTangents(submeshes[i], flags);
+			}
+		});
+	}
+
+	void generateNormalsAndTangents(ref<SubmeshAsset> submesh, uint32 flags)
+	{
+		generateSubmeshNormalsAndTangents(*submesh, getGenerationFlags(flags));
+	}
 
-		if (submesh->normals.empty() && flags & mesh_flag_gen_normals)
+	// Scores from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation".
+	struct vertex_cache_scores
+	{
+		static constexpr uint32 max_valence = 64;
+
+		float cache[vertex_cache_size];
+		float valence[max_valence];
+
+		vertex_cache_scores()
 		{
-			printf("Generating normals\n");
-			CPU_PRINT_PROFILE_BLOCK("Generating normals");
+			const float cacheDecayPower = 1.5f;
+			const float lastTriangleScore = 0.75f;
+			const float valenceBoostScale = 2.f;
+			const float valenceBoostPower = 0.5f;
+
+			for (uint32 i = 0; i < vertex_cache_size; ++i)
+			{
+				// The three vertices of the last triangle get a fixed score, so that the next triangle doesn't just reuse its edges.
+				cache[i] = (i < 3)
+					? lastTriangleScore
+					: powf(1.f - (float)(i - 3) / (float)(vertex_cache_size - 3), cacheDecayPower);
+			}
+
+			valence[0] = 0.f;
+			for (uint32 i = 1; i < max_valence; ++i)
+			{
+				// Boosts vertices with few remaining triangles, so that lone triangles don't get left behind.
+				valence[i] = valenceBoostScale * powf((float)i, -valenceBoostPower);
+			}
+		}
 
-			submesh->normals.resize(submesh->positions.size(), vec3(0.f));
-			for (indexed_triangle16 tri : submesh->triangles)
+		float get(int32 cachePosition, uint32 numActiveTriangles) const
+		{
+			if (numActiveTriangles == 0)
 			{
-				vec3 a = submesh->positions[tri.a];
-				vec3 b = submesh->positions[tri.b];
-				vec3 c = submesh->positions[tri.c];
-
-				vec3 n = cross(b - a, c - a);
-				submesh->normals[tri.a] += n;
-				submesh->normals[tri.b] += n;
-				submesh->normals[tri.c] += n;
+				return -1.f;
 			}
-			for (vec3& n : submesh->normals)
+
+			float score = (cachePosition >= 0) ? cache[cachePosition] : 0.f;
+			score += (numActiveTriangles < max_valence)
+				? valence[numActiveTriangles]
+				: 2.f * powf((float)numActiveTriangles, -0.5f);
+			return score;
+		}
+	};
+
+	template <typename triangle_t>
+	static std::vector<uint32> getVertexCacheTriangleOrder(const std::vector<triangle_t>& triangles, uint32 numVertices)
+	{
+		static const vertex_cache_scores scores;
+
+		const uint32 numTriangles = (uint32)triangles.size();
+
+		vertex_triangle_adjacency adjacency;
+		buildVertexTriangleAdjacency(triangles, numVertices, adjacency);
+
+		// The first numActiveTriangles[v] entries of v's adjacency are the triangles which have not been emitted yet.
+		std::vector<uint32> numActiveTriangles(numVertices);
+		std::vector<int32> cachePosition(numVertices, -1);
+		std::vector<float> vertexScore(numVertices);
+		for (uint32 v = 0; v < numVertices; ++v)
+		{
+			numActiveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+			vertexScore[v] = scores.get(-1, numActiveTriangles[v]);
+		}
+
+		std::vector<float> triangleScore(numTriangles);
+		std::vector<uint8> emitted(numTriangles, 0);
+		uint32 bestTriangle = UINT32_MAX;
+		float bestScore = -1.f;
+		for (uint32 t = 0; t < numTriangles; ++t)
+		{
+			const triangle_t& tri = triangles[t];
+			triangleScore[t] = vertexScore[tri.a] + vertexScore[tri.b] + vertexScore[tri.c];
+			if (triangleScore[t] > bestScore)
 			{
-				n = normalize(n);
+				bestScore = triangleScore[t];
+				bestTriangle = t;
 			}
 		}
 
-		if (submesh->tangents.empty() && flags & mesh_flag_gen_tangents)
+		std::vector<uint32> order;
+		order.reserve(numTriangles);
+
+		uint32 cache[vertex_cache_size + 3];
+		uint32 cacheCount = 0;
+		uint32 nextUnemitted = 0;
+
+		while (order.size() < numTriangles)
 		{
-			printf("Generating tangents\n");
-			CPU_PRINT_PROFILE_BLOCK("Generating tangents");
+			if (bestTriangle == UINT32_MAX)
+			{
+				// Nothing in the cache has triangles left, continue with any remaining one.
+				while (emitted[nextUnemitted])
+				{
+					++nextUnemitted;
+				}
+				bestTriangle = nextUnemitted;
+			}
 
-			submesh->tangents.resize(submesh->positions.size(), vec3(0.f));
-			if (!submesh->uvs.empty())
+			const triangle_t& tri = triangles[bestTriangle];
+			const uint32 corners[3] = { tri.a, tri.b, tri.c };
+
+			emitted[bestTriangle] = 1;
+			order.push_back(bestTriangle);
+
+			for (uint32 corner : corners)
 			{
-				for (indexed_triangle16 tri : submesh->triangles)
+				uint32* active = adjacency.triangles.data() + adjacency.offsets[corner];
+				uint32& count = numActiveTriangles[corner];
+				for (uint32 i = 0; i < count; ++i)
 				{
-					vec3 a = submesh->positions[tri.a];
-					vec3 b = submesh->positions[tri.b];
-					vec3 c = submesh->positions[tri.c];
-
-					vec2 h = submesh->uvs[tri.a];
-					vec2 k = submesh->uvs[tri.b];
-					vec2 l = submesh->uvs[tri.c];
-
-					vec3 d = b - a;
-					vec3 e = c - a;
-
-					vec2 f = k - h;
-					vec2 g = l - h;
-
-					float invDet = 1.f / (f.x * g.y - f.y * g.x);
-
-					vec3 t;
-					t.x = g.y * d.x - f.y * e.x;
-					t.y = g.y * d.y - f.y * e.y;
-					t.z = g.y * d.z - f.y * e.z;
-					t *= invDet;
-					submesh->tangents[tri.a] += t;
-					submesh->tangents[tri.b] += t;
-					submesh->tangents[tri.c] += t;
+					if (active[i] == bestTriangle)
+					{
+						active[i] = active[--count];
+						active[count] = bestTriangle;
+						break;
+					}
 				}
+			}
 
-				for (uint32 i = 0; i < (uint32)submesh->positions.size(); ++i)
+			// The triangle's vertices move to the front, everything else shifts back. The last three may fall out.
+			uint32 newCache[vertex_cache_size + 3];
+			uint32 newCacheCount = 0;
+			for (uint32 corner : corners)
+			{
+				if (std::find(newCache, newCache + newCacheCount, corner) == newCache + newCacheCount)
 				{
-					vec3 t = submesh->tangents[i];
-					vec3 n = submesh->normals[i];
+					newCache[newCacheCount++] = corner;
+				}
+			}
+			for (uint32 i = 0; i < cacheCount; ++i)
+			{
+				const uint32 v = cache[i];
+				if (v != corners[0] && v != corners[1] && v != corners[2])
+				{
+					newCache[newCacheCount++] = v;
+				}
+			}
 
-					vec3 b = cross(t, n);
-					t = cross(n, b);
+			for (uint32 i = 0; i < newCacheCount; ++i)
+			{
+				const uint32 v = newCache[i];
+				cachePosition[v] = (i < vertex_cache_size) ? (int32)i : -1;
+				vertexScore[v] = scores.get(cachePosition[v], numActiveTriangles[v]);
+			}
 
-					submesh->tangents[i] = normalize(t);
+			// Only triangles touching the cache changed their score, so the next triangle is picked from those.
+			bestTriangle = UINT32_MAX;
+			bestScore = -1.f;
+			for (uint32 i = 0; i < newCacheCount; ++i)
+			{
+				const uint32 v = newCache[i];
+				const uint32* active = adjacency.triangles.data() + adjacency.offsets[v];
+				for (uint32 j = 0; j < numActiveTriangles[v]; ++j)
+				{
+					const uint32 t = active[j];
+					const triangle_t& other = triangles[t];
+					triangleScore[t] = vertexScore[other.a] + vertexScore[other.b] + vertexScore[other.c];
+					if (triangleScore[t] > bestScore)
+					{
+						bestScore = triangleScore[t];
+						bestTriangle = t;
+					}
 				}
 			}
-			else
+
+			cacheCount = min(newCacheCount, vertex_cache_size);
+			std::copy(newCache, newCache + cacheCount, cache);
+		}
+
+		return order;
+	}
+
+	template <typename T>
+	static void remapVertexAttribute(std::vector<T>& attribute, const std::vector<uint32>& remap)
+	{
+		if (attribute.empty())
+		{
+			return;
+		}
+
+		std::vector<T> result(attribute.size());
+		for (uint32 v = 0; v < (uint32)attribute.size(); ++v)
+		{
+			result[remap[v]] = attribute[v];
+		}
+		attribute = std::move(result);
+	}
+
+	template <typename triangle_t>
+	static void optimizeVertexCache(SubmeshAsset& sub, std::vector<triangle_t>& triangles)
+	{
+		const uint32 numVertices = (uint32)sub.positions.size();
+		const std::vector<uint32> order = getVertexCacheTriangleOrder(triangles, numVertices);
+
+		// Vertices are renumbered in order of first use, so that vertex fetches walk through memory front to back.
+		// Unreferenced vertices keep their relative order at the end.
+		std::vector<uint32> remap(numVertices, UINT32_MAX);
+		uint32 nextVertex = 0;
+
+		std::vector<triangle_t> result(triangles.size());
+		for (uint32 i = 0; i < (uint32)order.size(); ++i)
+		{
+			const triangle_t& tri = triangles[order[i]];
+			uint32 corners[3] = { tri.a, tri.b, tri.c };
+			for (uint32& corner : corners)
 			{
-				printf("Mesh has no UVs. Generating suboptimal tangents.\n");
-				for (uint32 i = 0; i < (uint32)submesh->positions.size(); ++i)
+				if (remap[corner] == UINT32_MAX)
 				{
-					submesh->tangents[i] = get_tangent(submesh->normals[i]);
+					remap[corner] = nextVertex++;
 				}
+				corner = remap[corner];
 			}
+			result[i] = { (decltype(tri.a))corners[0], (decltype(tri.a))corners[1], (decltype(tri.a))corners[2] };
 		}
+		for (uint32 v = 0; v < numVertices; ++v)
+		{
+			if (remap[v] == UINT32_MAX)
+			{
+				remap[v] = nextVertex++;
+			}
+		}
+
+		triangles = std::move(result);
+
+		remapVertexAttribute(sub.positions, remap);
+		remapVertexAttribute(sub.uvs, remap);
+		remapVertexAttribute(sub.normals, remap);
+		remapVertexAttribute(sub.tangents, remap);
+		remapVertexAttribute(sub.colors, remap);
+		remapVertexAttribute(sub.skin, remap);
 	}
 
-	void per_material::addTriangles(const std::vector<vec3>& positions, const std::vector<vec2>& uvs, const std::vector<vec3>& normals, const std::vector<vec3>& tangents, const std::vector<uint32>& colors, const std::vector<era_engine::animation::SkinningWeights>& skins, int32 firstIndex, int32 faceSize, std::vector<SubmeshAsset>& outSubmeshes)
+	void optimizeVertexCache(SubmeshAsset& submesh)
 	{
-		if (faceSize < 3)
-			return;
+		CPU_PROFILE_BLOCK("Optimizing vertex cache");
 
-		int32 aIndex = firstIndex++;
-		int32 bIndex = firstIndex++;
-		add_vertex_result a = addVertex(positions, uvs, normals, tangents, colors, skins, aIndex);
-		add_vertex_result b = addVertex(positions, uvs, normals, tangents, colors, skins, bIndex);
-		for (int32 i = 2; i < faceSize; ++i)
+		if (!submesh.triangles32.empty())
 		{
-			int32 cIndex = firstIndex++;
-			add_vertex_result c = addVertex(positions, uvs, normals, tangents, colors, skins, cIndex);
+			optimizeVertexCache(submesh, submesh.triangles32);
+		}
+		else if (!submesh.triangles.empty())
+		{
+			optimizeVertexCache(submesh, submesh.triangles);
+		}
+	}
 
-			if (!(a.success && b.success && c.success))
+	void postprocessSubmeshes(std::vector<SubmeshAsset>& submeshes, uint32 flags)
+	{
+		flags = getGenerationFlags(flags);
+
+		parallel_for(0, (uint32)submeshes.size(), 1, [&](uint32 begin, uint32 end)
+		{
+			for (uint32 i = begin; i < end; ++i)
 			{
-				flush(outSubmeshes);
-				a = addVertex(positions, uvs, normals, tangents, colors, skins, aIndex);
-				b = addVertex(positions, uvs, normals, tangents, colors, skins, bIndex);
-				c = addVertex(positions, uvs, normals, tangents, colors, skins, cIndex);
-				printf("Too many vertices for 16-bit indices. Splitting mesh!\n");
+				// Reordering first means the normal and tangent passes already see the cache friendly layout.
+				optimizeVertexCache(submeshes[i]);
+				generateSubmeshNormalsAndTangents(submeshes[i], flags);
 			}
+		});
+	}
+
+	vertex_weld_table::find_result vertex_weld_table::find_or_insert(const full_vertex& vertex)
+	{
+		// Kept at most half full, so probe sequences stay short.
+		if ((vertices.size() + 1) * 2 > slots.size())
+		{
+			grow();
+		}
 
-			sub.triangles.push_back(indexed_triangle16{ a.index, b.index, c.index });
+		const uint64 fullHash = hash_bytes(&vertex, sizeof(full_vertex));
+		const uint32 hash = (uint32)(fullHash ^ (fullHash >> 32));
+		const uint32 mask = (uint32)slots.size() - 1;
 
+		for (uint32 i = hash & mask;; i = (i + 1) & mask)
+		{
+			slot& s = slots[i];
+			if (s.index == UINT32_MAX)
+			{
+				s = { hash, (uint32)vertices.size() };
+				vertices.push_back(vertex);
+				return { s.index, true };
+			}
+			if (s.hash == hash && vertices[s.index] == vertex)
+			{
+				return { s.index, false };
+			}
+		}
+	}
+
+	void vertex_weld_table::clear()
+	{
+		slots.clear();
+		vertices.clear();
+	}
+
+	void vertex_weld_table::grow()
+	{
+		std::vector<slot> oldSlots = std::move(slots);
+
+		slots.assign(max<uint64>(oldSlots.size() * 2, 1024), slot{ 0, UINT32_MAX });
+		const uint32 mask = (uint32)slots.size() - 1;
+
+		for (const slot& s : oldSlots)
+		{
+			if (s.index == UINT32_MAX)
+			{
+				continue;
+			}
+
+			uint32 i = s.hash & mask;
+			while (slots[i].index != UINT32_MAX)
+			{
+				i = (i + 1) & mask;
+			}
+			slots[i] = s;
+		}
+	}
+
+	void per_material::addTriangles(const std::vector<vec3>& positions, const std::vector<vec2>& uvs, const std::vector<vec3>& normals, const std::vector<vec3>& tangents, const std::vector<uint32>& colors, const std::vector<era_engine::animation::SkinningWeights>& skins, int32 firstIndex, int32 faceSize)
+	{
+		if (faceSize < 3)
+			return;
+
+		uint32 a = addVertex(positions, uvs, normals, tangents, colors, skins, firstIndex++);
+		uint32 b = addVertex(positions, uvs, normals, tangents, colors, skins, firstIndex++);
+		for (int32 i = 2; i < faceSize; ++i)
+		{
+			uint32 c = addVertex(positions, uvs, normals, tangents, colors, skins, firstIndex++);
+			pushTriangle(a, b, c);
 			b = c;
-			bIndex = cIndex;
 		}
 	}
 
@@ -223,7 +657,7 @@ namespace era_engine
 		}
 	}
 
-	per_material::add_vertex_result per_material::addVertex(const std::vector<vec3>& positions, const std::vector<vec2>& uvs, const std::vector<vec3>& normals, const std::vector<vec3>& tangents, const std::vector<uint32>& colors, const std::vector<era_engine::animation::SkinningWeights>& skins, int32 index)
+	uint32 per_material::addVertex(const std::vector<vec3>& positions, const std::vector<vec2>& uvs, const std::vector<vec3>& normals, const std::vector<vec3>& tangents, const std::vector<uint32>& colors, const std::vector<era_engine::animation::SkinningWeights>& skins, int32 index)
 	{
 		vec3 position = positions[index];
 		vec2 uv = !uvs.empty() ? uvs[index] : vec2(0.f, 0.f);
@@ -233,27 +667,39 @@ namespace era_engine
 		animation::SkinningWeights skin = !skins.empty() ? skins[index] : animation::SkinningWeights{};
 
 		full_vertex vertex = { position, uv, normal, tangent, color, skin, };
-		auto it = vertexToIndex.find(vertex);
-		if (it == vertexToIndex.end())
+		vertex_weld_table::find_result result = vertexToIndex.find_or_insert(vertex);
+		if (result.inserted)
 		{
-			uint32 vertexIndex = (uint32)sub.positions.size();
-			if (vertexIndex > UINT16_MAX)
-			{
-				return { 0, false };
-			}
-
-			vertexToIndex.insert({ vertex, (uint16)vertexIndex });
-
 			sub.positions.push_back(position);
 			if (!uvs.empty()) { sub.uvs.push_back(uv); }
 			if (!normals.empty()) { sub.normals.push_back(normal); }
 			if (!tangents.empty()) { sub.tangents.push_back(tangent); }
 			if (!colors.empty()) { sub.colors.push_back(color); }
 			if (!skins.empty()) { sub.skin.push_back(skin); }
+		}
+		return result.index;
+	}
 
-			return { (uint16)vertexIndex, true };
+	void per_material::pushTriangle(uint32 a, uint32 b, uint32 c)
+	{
+		if (sub.triangles32.empty() && max(a, max(b, c)) <= UINT16_MAX)
+		{
+			sub.triangles.push_back(indexed_triangle16{ (uint16)a, (uint16)b, (uint16)c });
+			return;
 		}
-		else
-			return { it->second, true };
+
+		if (!sub.triangles.empty())
+		{
+			// First index which doesn't fit into 16 bits. Everything so far is converted, instead of splitting the mesh.
+			sub.triangles32.reserve(sub.triangles.size() * 2);
+			for (const indexed_triangle16& tri : sub.triangles)
+			{
+				sub.triangles32.push_back(indexed_triangle32{ tri.a, tri.b, tri.c });
+			}
+			sub.triangles.clear();
+			sub.triangles.shrink_to_fit();
+		}
+
+		sub.triangles32.push_back(indexed_triangle32{ a, b, c });
 	}
-}
\ No newline at end of file
+}
@@ -8,6 +8,13 @@
 
 namespace era_engine
 {
+	fs::path get_model_cache_path(const fs::path& path, uint32 mesh_flags)
+	{
+		fs::path cached_filename = path.relative_path();
+		cached_filename.replace_extension("." + std::to_string(mesh_flags) + ".cache.bin");
+		return L"asset_cache" / cached_filename;
+	}
+
 	ModelAsset load_3d_model_from_file(const fs::path& path, uint32 meshFlags)
 	{
 		if (!fs::exists(path))
@@ -19,9 +26,7 @@ namespace era_engine
 
 		std::string extension = path.extension().string();
 
-		fs::path cachedFilename = path;
-		cachedFilename.replace_extension("." + std::to_string(meshFlags) + ".cache.bin");
-		fs::path cacheFilepath = L"asset_cache" / cachedFilename;
+		fs::path cacheFilepath = get_model_cache_path(path, meshFlags);
 
 		if (fs::exists(cacheFilepath))
 		{
@@ -30,7 +35,7 @@ namespace era_engine
 
 			if (lastCacheWriteTime > lastOriginalWriteTime)
 			{
-				return loadBIN(cacheFilepath);
+				return loadBIN(cacheFilepath, meshFlags);
 			}
 		}
 
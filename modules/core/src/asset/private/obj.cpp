@@ -432,7 +432,7 @@ namespace era_engine
 					per_material& per_mat = material_to_mesh[current_material_index];
 					per_mat.sub.material_index = current_material_index;
 
-					per_mat.addTriangles(position_cache, uv_cache, normal_cache, {}, {}, {}, 0, face_size, submeshes);
+					per_mat.addTriangles(position_cache, uv_cache, normal_cache, {}, {}, {}, 0, face_size);
 
 					position_cache.clear();
 					uv_cache.clear();
@@ -457,7 +457,7 @@ namespace era_engine
 		}
 
 		free_file(file);
-		generateNormalsAndTangents(submeshes, flags);
+		postprocessSubmeshes(submeshes, flags);
 
 		ModelAsset result;
 		result.flags = flags;
@@ -4,44 +4,73 @@
 
 namespace era_engine
 {
+	// Two-level segregated fit (TLSF) range allocator. Hands out offsets into an externally owned range (descriptor heaps,
+	// buffers), so all bookkeeping lives in pooled nodes next to it instead of in block headers.
+	// Free ranges are binned by size class (first level: power of two, second level: 32 linear steps in between) with one
+	// bitmap per level, which makes finding a fitting range, splitting and coalescing on free O(1).
 	class ERA_CORE_API BlockAllocator
 	{
 	public:
 		void initialize(uint64_t capacity);
 
-		// Returns the offset
+		// Returns the offset or UINT64_MAX if no free range is large enough.
 		uint64_t allocate(uint64_t requested_size);
 		void free(uint64_t offset, uint64_t size);
 
-		uint64_t available_size;
+		uint64_t get_largest_free_block() const;
+		uint32_t get_num_free_blocks() const { return num_free_blocks; }
+
+		uint64_t available_size = 0;
 
 	private:
-		struct OffsetValue;
-		struct SizeValue;
+		static constexpr uint32_t sl_count_log2 = 5;
+		static constexpr uint32_t sl_count = 1u << sl_count_log2;
+		static constexpr uint64_t small_block_size = sl_count;
+		static constexpr uint32_t fl_count = 64 - sl_count_log2 + 1;
 
-		// Referencing each-other
-		using BlockByOffsetMap = std::map<uint64_t, OffsetValue>;
-		using BlockBySizeMap = std::multimap<uint64_t, SizeValue>;
+		static constexpr uint32_t null_node = UINT32_MAX;
+		static constexpr uint64_t empty_key = UINT64_MAX;
 
-		struct OffsetValue
+		struct Node
 		{
-			OffsetValue() = default;
-			OffsetValue(const BlockBySizeMap::iterator& _size_iterator) : size_iterator(_size_iterator) {}
-			uint64_t get_size() const { return size_iterator->first; }
-			BlockBySizeMap::iterator size_iterator;
-		};
+			uint64_t offset = 0;
+			uint64_t size = 0;
 
-		struct SizeValue
-		{
-			SizeValue() = default;
-			SizeValue(const BlockByOffsetMap::iterator& _offset_iterator) : offset_iterator(_offset_iterator) {}
-			uint64_t get_offset() const { return offset_iterator->first; }
-			BlockByOffsetMap::iterator offset_iterator;
+			uint32_t prev_physical = null_node;
+			uint32_t next_physical = null_node;
+
+			// Links in the free list of the node's size class while free, links in the unused node list otherwise.
+			uint32_t prev_free = null_node;
+			uint32_t next_free = null_node;
+
+			bool is_free = false;
 		};
 
-		void add_new_block(uint64_t offset, uint64_t size);
+		static void mapping_insert(uint64_t size, uint32_t& fl, uint32_t& sl);
+		static void mapping_search(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+		uint32_t create_node(uint64_t offset, uint64_t size);
+		void release_node(uint32_t node_index);
+
+		void insert_free_node(uint32_t node_index);
+		void remove_free_node(uint32_t node_index);
+		uint32_t find_free_node(uint64_t size) const;
+
+		// Allocated offset -> node. Open addressing, so free() doesn't allocate either.
+		void insert_allocated(uint64_t offset, uint32_t node_index);
+		uint32_t remove_allocated(uint64_t offset);
+		void grow_allocated_table();
+
+		uint64_t fl_bitmap = 0;
+		uint32_t sl_bitmaps[fl_count] = {};
+		uint32_t free_lists[fl_count][sl_count];
+
+		std::vector<Node> nodes;
+		uint32_t first_unused_node = null_node;
+		uint32_t num_free_blocks = 0;
 
-		BlockByOffsetMap blocks_by_offset;
-		BlockBySizeMap blocks_by_size;
+		std::vector<uint64_t> allocated_keys;
+		std::vector<uint32_t> allocated_nodes;
+		uint32_t num_allocated = 0;
 	};
-}
\ No newline at end of file
+}
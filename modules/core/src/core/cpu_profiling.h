@@ -9,6 +9,12 @@
 
 #include <tracy/Tracy.hpp>
 
+#include <ctime>
+
+#if !defined(_WIN32) && defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
 namespace era_engine
 {
 	extern bool cpu_profiler_window_open;
@@ -28,35 +34,14 @@ namespace era_engine
 #define MAX_NUM_CPU_PROFILE_EVENTS (MAX_NUM_CPU_PROFILE_BLOCKS * 2)
 #define MAX_NUM_CPU_PROFILE_STATS 512
 
-// 1 bit for array index, 1 free bit, 20 bits for events, 10 bits for stats.
-#define _CPU_PROFILE_GET_ARRAY_INDEX(v) ((v) >> 31)
-#define _CPU_PROFILE_GET_EVENT_INDEX(v) ((v) & 0xFFFFF)
-#define _CPU_PROFILE_GET_STAT_INDEX(v)	(((v) >> 20) & 0x3FF)
-
-#define recordProfileEvent(type_, name_) \
-	uint32 array_and_event_index = cpu_profile_index++; \
-	uint32 event_index = _CPU_PROFILE_GET_EVENT_INDEX(array_and_event_index); \
-	uint32 array_index = _CPU_PROFILE_GET_ARRAY_INDEX(array_and_event_index); \
-	ASSERT(event_index < MAX_NUM_CPU_PROFILE_EVENTS); \
-	era_engine::ProfileEvent* e = cpu_profile_events[array_index] + event_index; \
-	e->thread_id = get_thread_id_fast(); \
-	e->name = name_; \
-	e->type = type_; \
-	QueryPerformanceCounter((LARGE_INTEGER*)&e->timestamp); \
-	cpu_profile_completely_written[array_index].fetch_add(1, std::memory_order_release); // Mark this event as written. Release means that the compiler may not reorder the previous writes after this.
-
-#define _CPU_PROFILE_STAT(label_value, value, member, value_type) \
-	uint32 array_and_stat_index = cpu_profile_index.fetch_add(1 << 20); \
-	uint32 stat_index = _CPU_PROFILE_GET_STAT_INDEX(array_and_stat_index); \
-	uint32 array_index = _CPU_PROFILE_GET_ARRAY_INDEX(array_and_stat_index); \
-	ASSERT(stat_index < MAX_NUM_CPU_PROFILE_STATS); \
-	era_engine::ProfileStat* stat_ = cpu_profile_stats[array_index] + stat_index; \
-	stat_->label = label_value; \
-	stat_->member = value; \
-	stat_->type = value_type; \
-	cpu_profile_completely_written[array_index].fetch_add(1, std::memory_order_release); // Mark this stat as written. Release means that the compiler may not reorder the previous writes after this.
-
-//#undef recordProfileEvent
+// Capacities of the per-thread rings. Powers of two.
+#define MAX_NUM_CPU_PROFILE_THREAD_EVENTS 16384
+#define MAX_NUM_CPU_PROFILE_THREAD_STATS 256
+
+#define recordProfileEvent(type_, name_) era_engine::record_cpu_profile_event(type_, name_)
+
+#define CPU_PROFILE_FLOW_BEGIN(id) era_engine::record_cpu_profile_flow(era_engine::profile_event_flow_begin, id)
+#define CPU_PROFILE_FLOW_END(id) era_engine::record_cpu_profile_flow(era_engine::profile_event_flow_end, id)
 
 #define _CPU_PRINT_PROFILE_BLOCK_(counter, name) era_engine::CpuPrintProfileBlockRecorder COMPOSITE_VARNAME(__PROFILE_BLOCK, counter)(name)
 #define CPU_PRINT_PROFILE_BLOCK(name) _CPU_PRINT_PROFILE_BLOCK_(__COUNTER__, name)
@@ -88,12 +73,174 @@ namespace era_engine
 			const char* string_value;
 		};
 		ProfileStatType type;
+		uint64 timestamp;
+	};
+
+	// Ticks of the calibrated CPU clock: the TSC on x64 (invariant on every CPU we run on), CLOCK_MONOTONIC in
+	// nanoseconds elsewhere. Convert with get_cpu_profile_clock_frequency().
+	inline uint64 get_cpu_profile_timestamp()
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		return __rdtsc();
+#elif defined(_WIN32)
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return (uint64)counter.QuadPart;
+#else
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return (uint64)time.tv_sec * 1000000000ull + (uint64)time.tv_nsec;
+#endif
+	}
+
+	// Ticks per second. The TSC rate is measured against the steady clock on the first call.
+	ERA_CORE_API uint64 get_cpu_profile_clock_frequency();
+
+	inline double cpu_profile_ticks_to_nanoseconds(uint64 ticks)
+	{
+		return (double)ticks * 1e9 / (double)get_cpu_profile_clock_frequency();
+	}
+
+	// Every thread records into its own single producer/single consumer rings, which are drained by
+	// cpu_profiling_resolve_time_stamps(). Recording only touches the calling thread's buffer, there is no shared counter.
+	// Space for the end events of all open blocks is always kept free, so a full ring drops whole blocks (with everything
+	// nested in them) and never leaves a block open.
+	struct alignas(64) CpuProfileThreadBuffer
+	{
+		// Owning thread only.
+		uint32 thread_id;
+		uint32 num_open_blocks = 0;
+		uint32 num_dropped_open_blocks = 0;
+
+		alignas(64) std::atomic<uint32> event_head = 0;
+		std::atomic<uint32> stat_head = 0;
+		std::atomic<uint32> num_dropped = 0; // Only written by the owner, so no read-modify-write needed.
+
+		alignas(64) std::atomic<uint32> event_tail = 0;
+		std::atomic<uint32> stat_tail = 0;
+		std::atomic<bool> retired = false;
+
+		char thread_name[64];
+
+		ProfileEvent events[MAX_NUM_CPU_PROFILE_THREAD_EVENTS];
+		ProfileStat stats[MAX_NUM_CPU_PROFILE_THREAD_STATS];
+
+		void count_dropped()
+		{
+			num_dropped.store(num_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		// Returns the next free event, or nullptr if fewer than 'reserved' events would be left after it.
+		ProfileEvent* allocate_event(uint32 reserved)
+		{
+			const uint32 head = event_head.load(std::memory_order_relaxed);
+			if (head - event_tail.load(std::memory_order_acquire) + reserved >= MAX_NUM_CPU_PROFILE_THREAD_EVENTS)
+			{
+				count_dropped();
+				return nullptr;
+			}
+			return events + (head & (MAX_NUM_CPU_PROFILE_THREAD_EVENTS - 1));
+		}
+
+		void publish_event(ProfileEvent* e, ProfileEventType type)
+		{
+			e->thread_id = thread_id;
+			e->type = type;
+			e->timestamp = get_cpu_profile_timestamp();
+
+			// Release means that the resolving thread sees the event completely written once it sees the new head.
+			event_head.store(event_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		void record(ProfileEventType type, const char* name)
+		{
+			if (type == profile_event_begin_block)
+			{
+				if (num_dropped_open_blocks > 0)
+				{
+					// Nested in a dropped block.
+					++num_dropped_open_blocks;
+					count_dropped();
+					return;
+				}
+
+				ProfileEvent* e = allocate_event(num_open_blocks + 1);
+				if (e == nullptr)
+				{
+					++num_dropped_open_blocks;
+					return;
+				}
+
+				e->name = name;
+				publish_event(e, type);
+				++num_open_blocks;
+			}
+			else if (type == profile_event_end_block && num_dropped_open_blocks > 0)
+			{
+				--num_dropped_open_blocks;
+				count_dropped();
+			}
+			else
+			{
+				num_open_blocks -= (type == profile_event_end_block && num_open_blocks > 0) ? 1 : 0;
+
+				if (ProfileEvent* e = allocate_event((type == profile_event_end_block) ? 0 : num_open_blocks))
+				{
+					e->name = name;
+					publish_event(e, type);
+				}
+			}
+		}
+
+		void record_flow(ProfileEventType type, uint64 id)
+		{
+			if (ProfileEvent* e = allocate_event(num_open_blocks))
+			{
+				e->flow_id = id;
+				publish_event(e, type);
+			}
+		}
+
+		void record_stat(const ProfileStat& stat)
+		{
+			const uint32 head = stat_head.load(std::memory_order_relaxed);
+			if (head - stat_tail.load(std::memory_order_acquire) >= MAX_NUM_CPU_PROFILE_THREAD_STATS)
+			{
+				count_dropped();
+				return;
+			}
+
+			stats[head & (MAX_NUM_CPU_PROFILE_THREAD_STATS - 1)] = stat;
+			stat_head.store(head + 1, std::memory_order_release);
+		}
 	};
 
-	ERA_CORE_API extern std::atomic<uint32> cpu_profile_index;
-	ERA_CORE_API extern std::atomic<uint32> cpu_profile_completely_written[2];
-	ERA_CORE_API extern ProfileEvent cpu_profile_events[2][MAX_NUM_CPU_PROFILE_EVENTS];
-	ERA_CORE_API extern ProfileStat cpu_profile_stats[2][MAX_NUM_CPU_PROFILE_STATS];
+	// Creates and registers the calling thread's buffer. It is freed by the resolve after the thread has exited.
+	ERA_CORE_API CpuProfileThreadBuffer* acquire_cpu_profile_thread_buffer();
+
+	// Cached per module, thread_local variables can't be exported. All modules get the same buffer for a thread.
+	inline thread_local CpuProfileThreadBuffer* cpu_profile_thread_buffer = nullptr;
+
+	inline CpuProfileThreadBuffer* get_cpu_profile_thread_buffer()
+	{
+		if (cpu_profile_thread_buffer == nullptr)
+		{
+			cpu_profile_thread_buffer = acquire_cpu_profile_thread_buffer();
+		}
+		return cpu_profile_thread_buffer;
+	}
+
+	inline void record_cpu_profile_event(ProfileEventType type, const char* name)
+	{
+		get_cpu_profile_thread_buffer()->record(type, name);
+	}
+
+	// Links the end of some work on one thread to the start of its follow-up on any thread (e.g. a job and its continuation).
+	// Both ends must use the same id and be recorded inside a CPU_PROFILE_BLOCK, trace viewers drop flows outside of slices.
+	inline void record_cpu_profile_flow(ProfileEventType type, uint64 id)
+	{
+		get_cpu_profile_thread_buffer()->record_flow(type, id);
+	}
 
 	struct ERA_CORE_API CpuProfileBlockRecorder
 	{
@@ -116,33 +263,51 @@ namespace era_engine
 		recordProfileEvent(profile_event_frame_marker, 0);
 	}
 
-	inline void CPU_PROFILE_STAT(const char* label, bool value) { _CPU_PROFILE_STAT(label, value, bool_value, profile_stat_type_bool); }
-	inline void CPU_PROFILE_STAT(const char* label, int32 value) { _CPU_PROFILE_STAT(label, value, int32_value, profile_stat_type_int32); }
-	inline void CPU_PROFILE_STAT(const char* label, uint32 value) { _CPU_PROFILE_STAT(label, value, uint32_value, profile_stat_type_uint32); }
-	inline void CPU_PROFILE_STAT(const char* label, int64 value) { _CPU_PROFILE_STAT(label, value, int64_value, profile_stat_type_int64); }
-	inline void CPU_PROFILE_STAT(const char* label, uint64 value) { _CPU_PROFILE_STAT(label, value, uint64_value, profile_stat_type_uint64); }
-	inline void CPU_PROFILE_STAT(const char* label, float value) { _CPU_PROFILE_STAT(label, value, float_value, profile_stat_type_float); }
-	inline void CPU_PROFILE_STAT(const char* label, const char* value) { _CPU_PROFILE_STAT(label, value, string_value, profile_stat_type_string); }
+	template <typename T_>
+	inline void record_cpu_profile_stat(const char* label, T_ value, T_ ProfileStat::* member, ProfileStatType type)
+	{
+		ProfileStat stat;
+		stat.label = label;
+		stat.*member = value;
+		stat.type = type;
+		stat.timestamp = get_cpu_profile_timestamp();
+		get_cpu_profile_thread_buffer()->record_stat(stat);
+	}
+
+	inline void CPU_PROFILE_STAT(const char* label, bool value) { record_cpu_profile_stat(label, value, &ProfileStat::bool_value, profile_stat_type_bool); }
+	inline void CPU_PROFILE_STAT(const char* label, int32 value) { record_cpu_profile_stat(label, value, &ProfileStat::int32_value, profile_stat_type_int32); }
+	inline void CPU_PROFILE_STAT(const char* label, uint32 value) { record_cpu_profile_stat(label, value, &ProfileStat::uint32_value, profile_stat_type_uint32); }
+	inline void CPU_PROFILE_STAT(const char* label, int64 value) { record_cpu_profile_stat(label, value, &ProfileStat::int64_value, profile_stat_type_int64); }
+	inline void CPU_PROFILE_STAT(const char* label, uint64 value) { record_cpu_profile_stat(label, value, &ProfileStat::uint64_value, profile_stat_type_uint64); }
+	inline void CPU_PROFILE_STAT(const char* label, float value) { record_cpu_profile_stat(label, value, &ProfileStat::float_value, profile_stat_type_float); }
+	inline void CPU_PROFILE_STAT(const char* label, const char* value) { record_cpu_profile_stat(label, value, &ProfileStat::string_value, profile_stat_type_string); }
 
+	// Drains all thread buffers, builds the frames for the profiler window and writes them to the active capture.
 	ERA_CORE_API void cpu_profiling_resolve_time_stamps();
 
+	// Streams every frame resolved from now on to 'path' in the Chrome trace event format (JSON array), which loads in
+	// chrome://tracing and ui.perfetto.dev. Blocks become slices, stats counters and flows arrows between threads.
+	// Stops by itself after 'num_frames' frames if that is not 0. Returns false if the file can't be opened.
+	ERA_CORE_API bool begin_cpu_profile_capture(const fs::path& path, uint32 num_frames = 0);
+	ERA_CORE_API void end_cpu_profile_capture();
+	ERA_CORE_API bool is_cpu_profile_capture_active();
+
+	// Events and stats dropped because a thread's ring was full, since startup.
+	ERA_CORE_API uint64 get_num_dropped_cpu_profile_events();
+
 	struct ERA_CORE_API CpuPrintProfileBlockRecorder
 	{
 		CpuPrintProfileBlockRecorder(const char* name)
 			: name(name)
 		{
-			QueryPerformanceCounter((LARGE_INTEGER*)&start);
+			start = get_cpu_profile_timestamp();
 		}
 
 		~CpuPrintProfileBlockRecorder()
 		{
-			uint64 end;
-			QueryPerformanceCounter((LARGE_INTEGER*)&end);
+			uint64 end = get_cpu_profile_timestamp();
 
-			uint64 clock_frequency;
-			QueryPerformanceFrequency((LARGE_INTEGER*)&clock_frequency);
-
-			float duration = (float)(end - start) / clock_frequency * 1000.f;
+			float duration = (float)(cpu_profile_ticks_to_nanoseconds(end - start) * 1e-6);
 			std::cout << "Profile block '" << name << "' took " << duration << "ms.\n";
 		}
 
@@ -156,9 +321,17 @@ namespace era_engine
 #define CPU_PROFILE_BLOCK(...)
 #define CPU_PROFILE_STAT(...)
 
+#define CPU_PROFILE_FLOW_BEGIN(...)
+#define CPU_PROFILE_FLOW_END(...)
+
 #define cpu_profiling_frame_end_marker(...)
 #define cpu_profiling_resolve_time_stamps(...)
 
+#define begin_cpu_profile_capture(...) false
+#define end_cpu_profile_capture(...)
+#define is_cpu_profile_capture_active(...) false
+#define get_num_dropped_cpu_profile_events(...) 0
+
 #define CPU_PRINT_PROFILE_BLOCK(...)
 
 #endif
\ No newline at end of file
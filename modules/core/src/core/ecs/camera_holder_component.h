@@ -20,7 +20,7 @@ namespace era_engine
 		};
 
 		CameraHolderComponent() = default;
-		CameraHolderComponent(ref<Entity::EcsData> _data);
+		CameraHolderComponent(Entity::EcsData* _data);
 
 		~CameraHolderComponent() override;
 
@@ -14,7 +14,7 @@ namespace era_engine
 	{
 	public:
 		InputReceiverComponent() = default;
-		InputReceiverComponent(ref<Entity::EcsData> _data);
+		InputReceiverComponent(Entity::EcsData* _data);
 
 		~InputReceiverComponent() override;
 
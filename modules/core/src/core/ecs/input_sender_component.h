@@ -15,7 +15,7 @@ namespace era_engine
 	{
 	public:
 		InputSenderComponent() = default;
-		InputSenderComponent(ref<Entity::EcsData> _data);
+		InputSenderComponent(Entity::EcsData* _data);
 
 		~InputSenderComponent() override;
 
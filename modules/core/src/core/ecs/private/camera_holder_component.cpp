@@ -9,11 +9,11 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<CameraHolderComponent>("CameraHolderComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
 
-	CameraHolderComponent::CameraHolderComponent(ref<Entity::EcsData> _data)
+	CameraHolderComponent::CameraHolderComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		type = ATTACHED_TO_TRS;
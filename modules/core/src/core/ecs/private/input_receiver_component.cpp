@@ -9,11 +9,11 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<InputReceiverComponent>("InputReceiverComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
 
-	InputReceiverComponent::InputReceiverComponent(ref<Entity::EcsData> _data)
+	InputReceiverComponent::InputReceiverComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
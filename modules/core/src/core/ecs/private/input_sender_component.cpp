@@ -10,11 +10,11 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<InputSenderComponent>("InputSenderComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
 
-	InputSenderComponent::InputSenderComponent(ref<Entity::EcsData> _data)
+	InputSenderComponent::InputSenderComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
@@ -24,7 +24,7 @@ namespace era_engine
 		using namespace rttr;
 
 		registration::class_<InputSystem>("InputSystem")
-			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string("base")))
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string("render")))
 			.method("update", &InputSystem::update)(metadata("update_group", update_types::INPUT));
 	}
 
@@ -9,11 +9,11 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<TagsComponent>("TagsComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
 
-	TagsComponent::TagsComponent(ref<Entity::EcsData> _data)
+	TagsComponent::TagsComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
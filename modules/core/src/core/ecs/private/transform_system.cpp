@@ -0,0 +1,42 @@
+#include "core/ecs/private/transform_system.h"
+#include "core/cpu_profiling.h"
+
+#include "ecs/base_components/transform_hierarchy.h"
+#include "ecs/update_groups.h"
+
+#include <rttr/policy.h>
+#include <rttr/registration>
+
+namespace era_engine
+{
+	RTTR_REGISTRATION
+	{
+		using namespace rttr;
+
+		registration::class_<TransformSystem>("TransformSystem")
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string("base")))
+			.method("update", &TransformSystem::update)(metadata("update_group", update_types::BEFORE_RENDER),
+				metadata("Before", std::vector<std::string>{"CameraSystem::update"}));
+	}
+
+	TransformSystem::TransformSystem(World* _world)
+		: System(_world)
+	{
+	}
+
+	TransformSystem::~TransformSystem()
+	{
+	}
+
+	void TransformSystem::init()
+	{
+	}
+
+	void TransformSystem::update(float dt)
+	{
+		ZoneScopedN("TransformSystem::update");
+
+		// Refresh all dirty world transforms once per frame, so render-side reads don't walk the hierarchy.
+		TransformHierarchy::update(world);
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ecs/system.h"
+
+namespace era_engine
+{
+
+	class TransformSystem final : public System
+	{
+	public:
+		TransformSystem(World* _world);
+		~TransformSystem();
+
+		void init() override;
+		void update(float dt) override;
+
+		ERA_VIRTUAL_REFLECT(System)
+	};
+}
@@ -13,7 +13,7 @@ namespace era_engine
 	{
 	public:
 		TagsComponent() = default;
-		TagsComponent(ref<Entity::EcsData> _data);
+		TagsComponent(Entity::EcsData* _data);
 
 		~TagsComponent() override;
 
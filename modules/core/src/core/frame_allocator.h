@@ -0,0 +1,103 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include "core_api.h"
+
+#include "core/memory.h"
+
+#include <atomic>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace era_engine
+{
+	enum class FrameLifetime : uint8
+	{
+		// Valid until the end of the frame it was allocated in.
+		SingleFrame,
+
+		// Valid until the end of the frame after the one it was allocated in.
+		TwoFrames,
+	};
+
+	struct FrameArenaStats
+	{
+		uint32 thread_id = 0;
+
+		uint64 used = 0;
+		uint64 peak = 0;
+
+		uint64 double_buffered_used = 0;
+		uint64 double_buffered_peak = 0;
+
+		uint64 committed = 0;
+	};
+
+	// Per-thread bump arenas for temporary data, built on the reserve-and-commit Allocator.
+	// Every thread that allocates gets its own set of arenas on first use, so allocations never take a lock or touch
+	// another thread's cache lines. begin_frame() only advances the frame counter: each arena notices the new frame on its
+	// owner's next allocation and rewinds itself. This keeps the reset race-free even while workers are still running.
+	// Work that may cross a frame boundary (e.g. low priority jobs) has to use FrameLifetime::TwoFrames or regular memory.
+	class ERA_CORE_API FrameAllocator final
+	{
+	public:
+		FrameAllocator(uint64 _reserve_size_per_arena = GB(1), uint64 _minimum_block_size = KB(64));
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator& operator=(const FrameAllocator&) = delete;
+		~FrameAllocator();
+
+		NODISCARD void* allocate(uint64 size, uint64 alignment = 16, FrameLifetime lifetime = FrameLifetime::SingleFrame);
+
+		template <typename T>
+		NODISCARD T* allocate(uint32 count = 1, FrameLifetime lifetime = FrameLifetime::SingleFrame)
+		{
+			return (T*)allocate(sizeof(T) * count, alignof(T), lifetime);
+		}
+
+		// Call once per frame from the main thread.
+		void begin_frame();
+
+		NODISCARD uint64 get_frame_id() const;
+
+		// One entry per thread that has allocated from this allocator so far.
+		NODISCARD std::vector<FrameArenaStats> get_stats() const;
+
+	private:
+		struct ThreadArenas;
+
+		ThreadArenas* get_thread_arenas();
+
+		const uint64 id;
+		const uint64 reserve_size_per_arena;
+		const uint64 minimum_block_size;
+
+		std::atomic<uint64> frame_id = 1;
+
+		// Only locked when a thread allocates for the first time and for statistics.
+		mutable std::mutex arenas_mutex;
+		std::vector<ThreadArenas*> arenas;
+	};
+
+	// std::pmr adapter, e.g. std::pmr::vector<int> values(&frame_memory_resource). Deallocation is a no-op.
+	class ERA_CORE_API FrameMemoryResource final : public std::pmr::memory_resource
+	{
+	public:
+		FrameMemoryResource(FrameAllocator& _allocator, FrameLifetime _lifetime = FrameLifetime::SingleFrame);
+
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		FrameAllocator& allocator;
+		FrameLifetime lifetime;
+	};
+
+	ERA_CORE_API extern FrameAllocator frame_allocator;
+	ERA_CORE_API extern FrameMemoryResource frame_memory_resource;
+	ERA_CORE_API extern FrameMemoryResource double_buffered_frame_memory_resource;
+
+	ERA_CORE_API void report_frame_allocator_stats();
+}
@@ -12,6 +12,50 @@ inline void hash_combine(size_t& seed, const T& v)
 	seed ^= std::hash<T>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
 
+// MurmurHash64A. Used as a checksum for binary data, not for hash tables keyed by small values.
+inline uint64 hash_bytes(const void* data, uint64 size, uint64 seed = 0)
+{
+	const uint64 m = 0xc6a4a7935bd1e995ull;
+	const int r = 47;
+
+	uint64 h = seed ^ (size * m);
+
+	const uint8* bytes = (const uint8*)data;
+	const uint64 num_blocks = size / 8;
+
+	for (uint64 i = 0; i < num_blocks; ++i)
+	{
+		uint64 k;
+		memcpy(&k, bytes + i * 8, sizeof(k));
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
+	}
+
+	const uint8* tail = bytes + num_blocks * 8;
+	switch (size & 7)
+	{
+	case 7: h ^= (uint64)tail[6] << 48; [[fallthrough]];
+	case 6: h ^= (uint64)tail[5] << 40; [[fallthrough]];
+	case 5: h ^= (uint64)tail[4] << 32; [[fallthrough]];
+	case 4: h ^= (uint64)tail[3] << 24; [[fallthrough]];
+	case 3: h ^= (uint64)tail[2] << 16; [[fallthrough]];
+	case 2: h ^= (uint64)tail[1] << 8; [[fallthrough]];
+	case 1: h ^= (uint64)tail[0];
+		h *= m;
+	};
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
+}
+
 namespace std
 {
 	template<>
@@ -4,6 +4,9 @@
 
 #include "core_api.h"
 
+#include "core/threading.h"
+#include "core/work_stealing_deque.h"
+
 #include <concurrentqueue/concurrentqueue.h>
 
 namespace era_engine
@@ -15,49 +18,76 @@ namespace era_engine
         void wait_for_completion();
 
         int32 index = -1;
+
+        // Slots are recycled, the generation tells a handle to a finished job apart from the slot's current occupant.
+        uint32 generation = 0;
         struct JobQueue* queue;
     };
 
     template <typename Data_>
     using JobFunction = void (*)(Data_&, JobHandle);
 
-    struct JobQueue
+    enum class JobQueueMode : uint8
+    {
+        // All jobs go through one shared MPMC queue. Cheap for a few coarse jobs (asset loading etc.).
+        Shared,
+
+        // Every worker owns a Chase-Lev deque. Jobs submitted from a worker are pushed to its own deque and popped LIFO,
+        // idle workers steal FIFO from the others. Jobs submitted from outside go through the shared queue.
+        // Idle workers spin for a while before they park, and submitters only signal if somebody is parked.
+        WorkStealing,
+    };
+
+    struct ERA_CORE_API JobQueue
     {
         struct JobQueueEntry
         {
             void (*function)(void*, void*, JobHandle);
             void* templated_function;
 
-            std::atomic<int32> num_unfinished_jobs;
-            int32 parent;
+            // Generation in the upper 32 bits, number of unfinished jobs (this one + children + continuation guard) in the lower.
+            // Packed so that a handle can check "same job and still running" and take a reference in one CAS.
+            std::atomic<uint64> state;
             JobHandle continuation;
+            int32 parent;
+            uint32 is_continuation; // Set when the job is submitted by another job finishing. Only used by the profiler.
 
-            static constexpr uint64 SIZE = sizeof(function) + sizeof(templated_function) + sizeof(num_unfinished_jobs) + sizeof(parent) + sizeof(continuation);
+            static constexpr uint64 SIZE = sizeof(function) + sizeof(templated_function) + sizeof(state) + sizeof(continuation) + sizeof(parent) + sizeof(is_continuation);
             static constexpr uint64 DATA_SIZE = (3 * 64) - SIZE;
 
             uint8 data[DATA_SIZE];
         };
 
+        struct JobQueueStats
+        {
+            uint32 in_flight_jobs;
+            uint32 peak_in_flight_jobs;
+            uint32 allocated_slots;
+            uint32 stale_waits;
+        };
+
         template<typename T_>
         using ValidJobDataType = std::enable_if_t<sizeof(T_) <= JobQueueEntry::DATA_SIZE, bool>;
 
         static_assert(sizeof(JobQueueEntry) % 64 == 0);
 
-        void initialize(uint32 num_threads, uint32 thread_offset, int thread_priority, const wchar* description);
+        void initialize(uint32 num_threads, uint32 thread_offset, ThreadPriority thread_priority, const wchar* description, JobQueueMode mode = JobQueueMode::Shared);
 
         template <typename Data_,
             ValidJobDataType<Data_> = true>
         JobHandle createJob(JobFunction<Data_> function, const Data_& data, JobHandle parent = {})
         {
             int32 handle = allocate_job();
-            auto& job = all_jobs[handle];
-            job.num_unfinished_jobs = 1;
+            auto& job = get_job(handle);
+            const uint32 generation = get_generation(job.state.load(std::memory_order_relaxed));
+            job.state.store(((uint64)generation << 32) | 1, std::memory_order_relaxed);
             job.parent = parent.index;
             job.continuation.index = -1;
+            job.is_continuation = 0;
 
             if (parent.index != -1)
             {
-                ++all_jobs[parent.index].num_unfinished_jobs;
+                add_reference(parent);
             }
 
             job.templated_function = function;
@@ -73,42 +103,119 @@ namespace era_engine
 
             new(job.data) Data_(data);
 
-            return JobHandle{ handle, this };
+            return JobHandle{ handle, generation, this };
         }
 
         void wait_for_completion();
 
+        // Peak is tracked since the last reset_peak_in_flight_jobs().
+        JobQueueStats get_stats() const;
+        void reset_peak_in_flight_jobs();
+
+        JobQueueMode get_mode() const { return mode; }
+        uint32 get_num_threads() const { return num_threads; }
+
+        // Index of the calling thread among this queue's workers, -1 if the calling thread is not one of them.
+        int32 get_current_worker_index() const;
+
+        // True if the calling thread already has queued jobs that it (or a thief) can pick up next.
+        // For worker threads in work stealing mode this looks at their own deque, otherwise at the shared queue.
+        bool has_local_work() const;
+
     private:
         friend struct JobHandle;
 
-        void add_continuation(int32 first, JobHandle second);
+        void add_continuation(JobHandle first, JobHandle second);
+        void add_reference(JobHandle handle);
         void submit(int32 handle);
-        void wait_for_completion(int32 handle);
+        void wait_for_completion(JobHandle handle);
+
+        // Unique among all jobs in flight in all queues, links a job to its continuation in profiler captures.
+        uint64 get_flow_id(int32 handle, uint32 generation) const;
 
         int32 allocate_job();
+        int32 pop_free_slot();
+        void push_free_slots(int32 first, int32 last);
+        int32 grow();
+        void release_job(int32 handle);
         void finish_job(int32 handle);
         bool execute_next_job();
+        bool pop_job(int32& handle);
+        bool steal_job(int32& handle);
+        bool has_pending_jobs() const;
+        void wake_worker();
         void thread_func(int32 thread_index);
 
+        static constexpr uint32 spin_count_before_sleep = 2048;
+
+        struct alignas(64) Worker
+        {
+            WorkStealingDeque<int32> deque;
+        };
+
         moodycamel::ConcurrentQueue<int32> queue;
         std::atomic<uint32> running_jobs = 0;
 
-        static constexpr uint32 capacity = 4096;
-        static constexpr uint32 index_mask = capacity - 1;
+        JobQueueMode mode = JobQueueMode::Shared;
+        uint32 num_threads = 0;
+        std::unique_ptr<Worker[]> workers;
+        std::atomic<uint32> num_sleeping_workers = 0;
 
-        JobQueueEntry all_jobs[capacity];
-        std::atomic<uint32> next_free_job = 0;
+        // Job slots live in chunks that are allocated on demand and never move, so a slot index stays valid forever.
+        // Free slots are kept in a lock-free stack. The head is tagged with a counter against ABA.
+        static constexpr uint32 chunk_shift = 10;
+        static constexpr uint32 chunk_size = 1 << chunk_shift;
+        static constexpr uint32 chunk_mask = chunk_size - 1;
+        static constexpr uint32 max_num_chunks = 256;
+        static constexpr uint32 invalid_slot = 0xFFFFFFFF;
+
+        static constexpr uint32 initial_queue_capacity = 4096;
+
+        struct JobChunk
+        {
+            JobQueueEntry entries[chunk_size];
+            std::atomic<int32> next_free[chunk_size];
+        };
+
+        static uint32 get_generation(uint64 state) { return (uint32)(state >> 32); }
+        static uint32 get_unfinished_count(uint64 state) { return (uint32)state; }
+
+        JobQueueEntry& get_job(int32 handle) const
+        {
+            return chunks[handle >> chunk_shift].load(std::memory_order_acquire)->entries[handle & chunk_mask];
+        }
+
+        std::atomic<int32>& get_next_free(int32 handle) const
+        {
+            return chunks[handle >> chunk_shift].load(std::memory_order_acquire)->next_free[handle & chunk_mask];
+        }
+
+        std::atomic<JobChunk*> chunks[max_num_chunks] = {};
+        std::atomic<uint32> num_chunks = 0;
+        std::atomic<uint64> free_list_head = invalid_slot;
+        std::mutex grow_mutex;
+
+        std::atomic<uint32> in_flight_jobs = 0;
+        std::atomic<uint32> peak_in_flight_jobs = 0;
+        std::atomic<uint32> stale_waits = 0;
 
         std::condition_variable wake_condition;
         std::mutex wake_mutex;
     };
 
-    extern JobQueue high_priority_job_queue;
-    extern JobQueue low_priority_job_queue;
-    extern JobQueue main_thread_job_queue;
+    ERA_CORE_API extern JobQueue high_priority_job_queue;
+    ERA_CORE_API extern JobQueue low_priority_job_queue;
+
+    // Runs the fixed update graphs. Kept apart from the high priority queue, because waiting on a queue helps with any of
+    // its jobs: the fixed update thread would otherwise pick up frame work and the main thread fixed update work.
+    ERA_CORE_API extern JobQueue fixed_update_job_queue;
+    ERA_CORE_API extern JobQueue main_thread_job_queue;
+
+    ERA_CORE_API void initialize_job_system();
+    ERA_CORE_API void execute_main_thread_jobs();
 
-    void initialize_job_system();
-    void execute_main_thread_jobs();
+    // Publishes in-flight/peak job counts of all queues to the profiler and resets the peaks. Call once per frame.
+    ERA_CORE_API void report_job_system_stats();
 
     struct DefaultJob
     {
@@ -122,4 +229,26 @@ namespace era_engine
         std::function<void(Data&)> job_func;
     };
     ERA_CORE_API JobHandle schedule_low_priority_job(const DefaultJob& job, JobHandle parent_job = {});
-}
\ No newline at end of file
+
+    // Data parallel helpers. The range is split lazily: a job only splits off the upper half of its range when its
+    // worker has nothing queued locally (so idle workers have something to steal), otherwise it keeps processing
+    // 'grain' sized chunks itself. Ranges up to 'grain' and queues without worker threads run inline on the caller.
+    // All helpers block until the whole range is processed and the calling thread helps out in the meantime.
+
+    // func(uint32 begin, uint32 end) is called for disjoint chunks covering [first, last). Must be callable as const.
+    template <typename Func_>
+    void parallel_for(uint32 first, uint32 last, uint32 grain, const Func_& func, JobQueue& queue = high_priority_job_queue);
+
+    // func(uint32 begin, uint32 end, T_ value) -> T_ accumulates a chunk into 'value' (which starts out as 'identity').
+    // Chunk results are combined into one buffer per worker (plus a locked one for non-worker threads) and the buffers
+    // are combined at the end, so combine(T_, T_) -> T_ must be associative and commutative.
+    template <typename T_, typename Func_, typename Combine_>
+    T_ parallel_reduce(uint32 first, uint32 last, uint32 grain, const T_& identity, const Func_& func, const Combine_& combine, JobQueue& queue = high_priority_job_queue);
+
+    // Sorts blocks of at least 'grain' elements in parallel and then merges them pairwise in parallel rounds.
+    // Not stable. The value type has to be default constructible and movable.
+    template <typename Iter_, typename Compare_ = std::less<>>
+    void parallel_sort(Iter_ first, Iter_ last, Compare_ comp = {}, uint32 grain = 4096, JobQueue& queue = high_priority_job_queue);
+}
+
+#include "core/private/job_system_impl.h"
\ No newline at end of file
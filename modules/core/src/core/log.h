@@ -29,13 +29,90 @@ namespace era_engine
 #endif
 
 #include "core_api.h"
+#include "core/log_internal.h"
+
+#include <cstdio>
 
 #include "ecs/system.h"
 
 namespace era_engine
 {
-	ERA_CORE_API void log_message_internal(MessageType type, const char* file, const char* function, uint32 line, const char* format, ...);
-	ERA_CORE_API void log_message(MessageType type, const char* format, ...);
+	// Logging only packs the format pointer and the arguments into a per thread ring buffer. The log thread formats the
+	// records in timestamp order and hands them to the sinks (console, file and the in-editor console by default).
+	// Formats must outlive the record (LOG_* pass string literals), strings are copied.
+	template <typename... Args_>
+	inline void log_message_internal(MessageType type, const char* file, const char* function, uint32 line, const char* format, Args_... args)
+	{
+		log_internal::write_log_record(type, file, function, line, format, args...);
+	}
+
+	template <typename... Args_>
+	inline void log_message(MessageType type, const char* format, Args_... args)
+	{
+		log_internal::write_log_record(type, nullptr, nullptr, 0, format, args...);
+	}
+
+	// What a full ring buffer does to normal messages and warnings. Errors always wait for space.
+	enum class LogOverflowPolicy : uint8
+	{
+		DROP,
+		BLOCK,
+	};
+
+	struct LogRecord
+	{
+		MessageType type;
+		double time; // Seconds since the logger started.
+		uint32 thread_index; // Order in which threads logged for the first time.
+		const char* text;
+		const char* file; // Null for log_message().
+		const char* function;
+		uint32 line;
+	};
+
+	// Called on the log thread only (or the thread flushing), one record at a time.
+	class ERA_CORE_API LogSink
+	{
+	public:
+		virtual ~LogSink();
+
+		virtual void write(const LogRecord& record) = 0;
+		virtual void flush();
+	};
+
+	class ERA_CORE_API FileLogSink final : public LogSink
+	{
+	public:
+		FileLogSink(const char* path);
+		~FileLogSink() override;
+
+		void write(const LogRecord& record) override;
+		void flush() override;
+
+	private:
+		FILE* file = nullptr;
+	};
+
+	class ERA_CORE_API ConsoleLogSink final : public LogSink
+	{
+	public:
+		void write(const LogRecord& record) override;
+		void flush() override;
+	};
+
+	ERA_CORE_API void add_log_sink(const ref<LogSink>& sink);
+
+	// Removes all sinks, including the default ones. Records logged before are formatted and written first.
+	ERA_CORE_API void clear_log_sinks();
+
+	ERA_CORE_API void set_log_overflow_policy(LogOverflowPolicy policy);
+
+	// Messages dropped because their ring was full, since the start.
+	ERA_CORE_API uint64 get_num_dropped_log_messages();
+
+	// Formats everything logged so far on the calling thread and flushes the sinks. Also runs at exit, on std::terminate
+	// and on unhandled exceptions.
+	ERA_CORE_API void log_flush();
 
 	class ERA_CORE_API LogSystem final : public System
 	{
@@ -0,0 +1,185 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include "core_api.h"
+
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <type_traits>
+
+namespace era_engine
+{
+	enum MessageType : uint8_t;
+}
+
+namespace era_engine::log_internal
+{
+	// Records are written by the calling thread into its own ring buffer and formatted later by the log thread.
+	// Layout: LogRecordHeader, then 'num_args' arguments, each a LogArgumentType byte and its payload:
+	// 8 bytes for numbers and pointers, uint32 length (including the terminator) and the characters for strings.
+	enum LogArgumentType : uint8
+	{
+		log_argument_int,
+		log_argument_uint,
+		log_argument_double,
+		log_argument_pointer,
+		log_argument_string,
+		log_argument_wide_string,
+	};
+
+	struct LogRecordHeader
+	{
+		uint32 size; // Whole record, rounded up to LOG_RECORD_ALIGNMENT. 0 marks the unused end of the ring.
+		MessageType type;
+		uint8 num_args;
+		uint32 line;
+		int64 timestamp;
+		const char* format; // Must outlive the record, LOG_* macros pass string literals.
+		const char* file;
+		const char* function;
+	};
+
+	inline constexpr uint32 LOG_RECORD_ALIGNMENT = 8;
+
+	// Longer strings are truncated, like the 1 KB formatting buffer of the synchronous logger.
+	inline constexpr uint32 LOG_MAX_STRING_LENGTH = 1024;
+
+	inline int64 get_log_timestamp()
+	{
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+	}
+
+	// Returns the space for a record of 'size' bytes in the calling thread's ring, or nullptr if it was dropped.
+	ERA_CORE_API uint8* begin_log_record(MessageType type, uint32 size);
+	ERA_CORE_API void end_log_record(uint32 size);
+
+	template <typename T_>
+	inline constexpr bool is_log_string_v = std::is_same_v<T_, const char*> || std::is_same_v<T_, char*>;
+
+	template <typename T_>
+	inline constexpr bool is_log_wide_string_v = std::is_same_v<T_, const wchar_t*> || std::is_same_v<T_, wchar_t*>;
+
+	template <typename Char_>
+	inline uint32 get_string_length(const Char_* value)
+	{
+		uint32 length = 0;
+		while (length < LOG_MAX_STRING_LENGTH - 1 && value[length] != 0)
+		{
+			++length;
+		}
+		return length;
+	}
+
+	// Null strings are stored as null pointers, so they print as "(null)".
+	template <typename T_>
+	inline uint32 get_encoded_size(const T_& value)
+	{
+		if constexpr (is_log_string_v<T_>)
+		{
+			return (value != nullptr) ? (1 + sizeof(uint32) + (get_string_length(value) + 1) * sizeof(char)) : (1 + sizeof(uint64));
+		}
+		else if constexpr (is_log_wide_string_v<T_>)
+		{
+			return (value != nullptr) ? (1 + sizeof(uint32) + (get_string_length(value) + 1) * sizeof(wchar_t)) : (1 + sizeof(uint64));
+		}
+		else
+		{
+			return 1 + sizeof(uint64);
+		}
+	}
+
+	template <typename T_>
+	inline uint8* encode_scalar(uint8* cursor, LogArgumentType type, T_ value)
+	{
+		static_assert(sizeof(T_) == sizeof(uint64));
+
+		*cursor++ = type;
+		memcpy(cursor, &value, sizeof(value));
+		return cursor + sizeof(value);
+	}
+
+	template <typename Char_>
+	inline uint8* encode_string(uint8* cursor, LogArgumentType type, const Char_* value)
+	{
+		if (value == nullptr)
+		{
+			return encode_scalar(cursor, log_argument_pointer, (uint64)0);
+		}
+
+		const uint32 length = get_string_length(value);
+		const uint32 count = length + 1;
+
+		*cursor++ = type;
+		memcpy(cursor, &count, sizeof(count));
+		cursor += sizeof(count);
+
+		if (length > 0)
+		{
+			memcpy(cursor, value, length * sizeof(Char_));
+		}
+		memset(cursor + length * sizeof(Char_), 0, sizeof(Char_));
+
+		return cursor + count * sizeof(Char_);
+	}
+
+	template <typename T_>
+	inline uint8* encode_argument(uint8* cursor, const T_& value)
+	{
+		if constexpr (is_log_string_v<T_>)
+		{
+			return encode_string(cursor, log_argument_string, value);
+		}
+		else if constexpr (is_log_wide_string_v<T_>)
+		{
+			return encode_string(cursor, log_argument_wide_string, value);
+		}
+		else if constexpr (std::is_floating_point_v<T_>)
+		{
+			return encode_scalar(cursor, log_argument_double, (double)value);
+		}
+		else if constexpr (std::is_pointer_v<T_> || std::is_null_pointer_v<T_>)
+		{
+			return encode_scalar(cursor, log_argument_pointer, (uint64)(uintptr_t)value);
+		}
+		else if constexpr (std::is_enum_v<T_>)
+		{
+			return encode_scalar(cursor, log_argument_int, (int64)value);
+		}
+		else if constexpr (std::is_integral_v<T_> && std::is_unsigned_v<T_>)
+		{
+			return encode_scalar(cursor, log_argument_uint, (uint64)value);
+		}
+		else
+		{
+			static_assert(std::is_integral_v<T_>, "Log arguments must be numbers, enums, pointers or C strings.");
+			return encode_scalar(cursor, log_argument_int, (int64)value);
+		}
+	}
+
+	template <typename... Args_>
+	inline void write_log_record(MessageType type, const char* file, const char* function, uint32 line, const char* format, const Args_&... args)
+	{
+		static_assert(sizeof...(Args_) < 256, "Too many log arguments.");
+
+		const int64 timestamp = get_log_timestamp();
+
+		const uint32 unaligned_size = (uint32)sizeof(LogRecordHeader) + (0 + ... + get_encoded_size(args));
+		const uint32 size = (unaligned_size + LOG_RECORD_ALIGNMENT - 1) & ~(LOG_RECORD_ALIGNMENT - 1);
+
+		uint8* record = begin_log_record(type, size);
+		if (record == nullptr)
+		{
+			return;
+		}
+
+		const LogRecordHeader header = { size, type, (uint8)sizeof...(Args_), line, timestamp, format, file, function };
+		memcpy(record, &header, sizeof(header));
+
+		uint8* cursor = record + sizeof(header);
+		((cursor = encode_argument(cursor, args)), ...);
+
+		end_log_record(size);
+	}
+}
@@ -122,6 +122,9 @@ namespace era_engine
 	protected:
 		void ensure_free_size_internal(uint64 size);
 
+		// Bump allocation without taking the lock. For allocators that are only ever touched by one thread.
+		uint8* allocate_internal(uint64 size, uint64 alignment);
+
 		uint8* memory = 0;
 		uint64 committed_memory = 0;
 
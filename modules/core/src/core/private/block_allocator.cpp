@@ -1,117 +1,366 @@
 #include "core/block_allocator.h"
 
+#include <bit>
+
 namespace era_engine
 {
 	void BlockAllocator::initialize(uint64_t capacity)
 	{
+		fl_bitmap = 0;
+		memset(sl_bitmaps, 0, sizeof(sl_bitmaps));
+		memset(free_lists, 0xFF, sizeof(free_lists));
+
+		nodes.clear();
+		first_unused_node = null_node;
+		num_free_blocks = 0;
+
+		allocated_keys.assign(64, empty_key);
+		allocated_nodes.assign(64, null_node);
+		num_allocated = 0;
+
 		available_size = capacity;
-		add_new_block(0, capacity);
+		if (capacity > 0)
+		{
+			insert_free_node(create_node(0, capacity));
+		}
 	}
 
 	uint64_t BlockAllocator::allocate(uint64_t requested_size)
 	{
-		auto smallest_block_it = blocks_by_size.lower_bound(requested_size);
-		if (smallest_block_it == blocks_by_size.end())
+		if (requested_size == 0)
 		{
 			return UINT64_MAX;
 		}
 
-		SizeValue size_value = smallest_block_it->second;
-
-		uint64_t offset = size_value.get_offset();
-		uint64_t size = smallest_block_it->first;
+		const uint32_t node_index = find_free_node(requested_size);
+		if (node_index == null_node)
+		{
+			return UINT64_MAX;
+		}
 
-		uint64_t new_offset = offset + requested_size;
-		uint64_t new_size = size - requested_size;
+		remove_free_node(node_index);
 
-		blocks_by_size.erase(smallest_block_it);
-		blocks_by_offset.erase(size_value.offset_iterator);
+		const uint64_t offset = nodes[node_index].offset;
+		const uint64_t remaining_size = nodes[node_index].size - requested_size;
 
-		if (new_size > 0)
+		if (remaining_size > 0)
 		{
-			add_new_block(new_offset, new_size);
+			// Offset                              Offset + requested_size
+			// |                                   |
+			// |<-------- requested_size --------->|<-------- remaining_size -------->|
+			//
+			const uint32_t remainder_index = create_node(offset + requested_size, remaining_size);
+
+			Node& node = nodes[node_index];
+			Node& remainder = nodes[remainder_index];
+
+			remainder.prev_physical = node_index;
+			remainder.next_physical = node.next_physical;
+			if (node.next_physical != null_node)
+			{
+				nodes[node.next_physical].prev_physical = remainder_index;
+			}
+			node.next_physical = remainder_index;
+			node.size = requested_size;
+
+			insert_free_node(remainder_index);
 		}
 
+		insert_allocated(offset, node_index);
+
 		available_size -= requested_size;
 		return offset;
 	}
 
 	void BlockAllocator::free(uint64_t offset, uint64_t size)
 	{
-		auto next_block_it = blocks_by_offset.upper_bound(offset);
-		auto& prev_block_it = next_block_it;
-		if (prev_block_it != blocks_by_offset.begin())
+		uint32_t node_index = remove_allocated(offset);
+		ASSERT(node_index != null_node);
+		ASSERT(nodes[node_index].size == size);
+
+		// PrevBlock.Offset           Offset               NextBlock.Offset
+		// |                          |                    |
+		// |<-----PrevBlock.Size----->|<------Size-------->|<-----NextBlock.Size----->|
+		//
+		// Free physical neighbours are merged right away, so two free ranges are never adjacent.
+		const uint32_t prev_index = nodes[node_index].prev_physical;
+		if (prev_index != null_node && nodes[prev_index].is_free)
+		{
+			remove_free_node(prev_index);
+
+			Node& prev = nodes[prev_index];
+			prev.size += nodes[node_index].size;
+			prev.next_physical = nodes[node_index].next_physical;
+			if (prev.next_physical != null_node)
+			{
+				nodes[prev.next_physical].prev_physical = prev_index;
+			}
+
+			release_node(node_index);
+			node_index = prev_index;
+		}
+
+		const uint32_t next_index = nodes[node_index].next_physical;
+		if (next_index != null_node && nodes[next_index].is_free)
 		{
-			--prev_block_it;
+			remove_free_node(next_index);
+
+			Node& node = nodes[node_index];
+			node.size += nodes[next_index].size;
+			node.next_physical = nodes[next_index].next_physical;
+			if (node.next_physical != null_node)
+			{
+				nodes[node.next_physical].prev_physical = node_index;
+			}
+
+			release_node(next_index);
+		}
+
+		insert_free_node(node_index);
+
+		available_size += size;
+	}
+
+	uint64_t BlockAllocator::get_largest_free_block() const
+	{
+		if (fl_bitmap == 0)
+		{
+			return 0;
+		}
+
+		const uint32_t fl = 63 - std::countl_zero(fl_bitmap);
+		const uint32_t sl = 31 - std::countl_zero(sl_bitmaps[fl]);
+
+		// Sizes within one class differ, so the last class has to be searched.
+		uint64_t result = 0;
+		for (uint32_t node_index = free_lists[fl][sl]; node_index != null_node; node_index = nodes[node_index].next_free)
+		{
+			result = max(result, nodes[node_index].size);
+		}
+		return result;
+	}
+
+	void BlockAllocator::mapping_insert(uint64_t size, uint32_t& fl, uint32_t& sl)
+	{
+		if (size < small_block_size)
+		{
+			fl = 0;
+			sl = (uint32_t)size;
 		}
 		else
 		{
-			prev_block_it = blocks_by_offset.end();
+			const uint32_t msb = 63 - std::countl_zero(size);
+			fl = msb - sl_count_log2 + 1;
+			sl = (uint32_t)(size >> (msb - sl_count_log2)) ^ sl_count;
 		}
+	}
 
-		uint64 new_offset = 0, new_size = 0;
-		if (prev_block_it != blocks_by_offset.end() && offset == prev_block_it->first + prev_block_it->second.get_size())
+	void BlockAllocator::mapping_search(uint64_t size, uint32_t& fl, uint32_t& sl)
+	{
+		// Round up to the next size class, so that every range in the resulting class is large enough.
+		if (size >= small_block_size)
 		{
-			// PrevBlock.Offset           Offset
-			// |                          |
-			// |<-----PrevBlock.Size----->|<------Size-------->|
-			//
-			new_size = prev_block_it->second.get_size() + size;
-			new_offset = prev_block_it->first;
+			const uint32_t msb = 63 - std::countl_zero(size);
+			const uint64_t round = (1ull << (msb - sl_count_log2)) - 1;
+			if (size <= UINT64_MAX - round)
+			{
+				size += round;
+			}
+		}
+		mapping_insert(size, fl, sl);
+	}
 
-			if (next_block_it != blocks_by_offset.end() && offset + size == next_block_it->first)
+	uint32_t BlockAllocator::find_free_node(uint64_t size) const
+	{
+		uint32_t fl, sl;
+		mapping_search(size, fl, sl);
+
+		uint32_t sl_map = (fl < fl_count) ? (sl_bitmaps[fl] & (~0u << sl)) : 0;
+		if (sl_map == 0)
+		{
+			const uint64_t fl_map = (fl + 1 < 64) ? (fl_bitmap & (~0ull << (fl + 1))) : 0;
+			if (fl_map != 0)
 			{
-				// PrevBlock.Offset           Offset               NextBlock.Offset
-				// |                          |                    |
-				// |<-----PrevBlock.Size----->|<------Size-------->|<-----NextBlock.Size----->|
-				//
-				new_size += next_block_it->second.get_size();
-				blocks_by_size.erase(prev_block_it->second.size_iterator);
-				blocks_by_size.erase(prev_block_it->second.size_iterator);
-				// Delete the range of two blocks
-				++next_block_it;
-				blocks_by_offset.erase(prev_block_it, next_block_it);
+				fl = std::countr_zero(fl_map);
+				sl_map = sl_bitmaps[fl];
 			}
-			else
+		}
+
+		if (sl_map != 0)
+		{
+			sl = std::countr_zero(sl_map);
+			return free_lists[fl][sl];
+		}
+
+		// Rounding up skips the class the request itself falls into. It may still contain a range that fits,
+		// which matters when the heap is nearly full.
+		mapping_insert(size, fl, sl);
+		for (uint32_t node_index = free_lists[fl][sl]; node_index != null_node; node_index = nodes[node_index].next_free)
+		{
+			if (nodes[node_index].size >= size)
 			{
-				// PrevBlock.Offset           Offset                       NextBlock.Offset
-				// |                          |                            |
-				// |<-----PrevBlock.Size----->|<------Size-------->| ~ ~ ~ |<-----NextBlock.Size----->|
-				//
-				blocks_by_size.erase(prev_block_it->second.size_iterator);
-				blocks_by_offset.erase(prev_block_it);
+				return node_index;
 			}
 		}
-		else if (next_block_it != blocks_by_offset.end() && offset + size == next_block_it->first)
+		return null_node;
+	}
+
+	uint32_t BlockAllocator::create_node(uint64_t offset, uint64_t size)
+	{
+		uint32_t node_index = first_unused_node;
+		if (node_index != null_node)
+		{
+			first_unused_node = nodes[node_index].next_free;
+			nodes[node_index] = Node{};
+		}
+		else
 		{
-			// PrevBlock.Offset                   Offset               NextBlock.Offset
-			// |                                  |                    |
-			// |<-----PrevBlock.Size----->| ~ ~ ~ |<------Size-------->|<-----NextBlock.Size----->|
-			//
-			new_size = size + next_block_it->second.get_size();
-			new_offset = offset;
-			blocks_by_size.erase(next_block_it->second.size_iterator);
-			blocks_by_offset.erase(next_block_it);
+			node_index = (uint32_t)nodes.size();
+			nodes.emplace_back();
+		}
+
+		nodes[node_index].offset = offset;
+		nodes[node_index].size = size;
+		return node_index;
+	}
+
+	void BlockAllocator::release_node(uint32_t node_index)
+	{
+		nodes[node_index].next_free = first_unused_node;
+		first_unused_node = node_index;
+	}
+
+	void BlockAllocator::insert_free_node(uint32_t node_index)
+	{
+		uint32_t fl, sl;
+		mapping_insert(nodes[node_index].size, fl, sl);
+
+		Node& node = nodes[node_index];
+		node.is_free = true;
+		node.prev_free = null_node;
+		node.next_free = free_lists[fl][sl];
+		if (node.next_free != null_node)
+		{
+			nodes[node.next_free].prev_free = node_index;
+		}
+		free_lists[fl][sl] = node_index;
+
+		fl_bitmap |= 1ull << fl;
+		sl_bitmaps[fl] |= 1u << sl;
+
+		++num_free_blocks;
+	}
+
+	void BlockAllocator::remove_free_node(uint32_t node_index)
+	{
+		uint32_t fl, sl;
+		mapping_insert(nodes[node_index].size, fl, sl);
+
+		Node& node = nodes[node_index];
+		if (node.prev_free != null_node)
+		{
+			nodes[node.prev_free].next_free = node.next_free;
 		}
 		else
 		{
-			// PrevBlock.Offset                   Offset                       NextBlock.Offset
-			// |                                  |                            |
-			// |<-----PrevBlock.Size----->| ~ ~ ~ |<------Size-------->| ~ ~ ~ |<-----NextBlock.Size----->|
-			//
-			new_size = size;
-			new_offset = offset;
+			free_lists[fl][sl] = node.next_free;
+		}
+
+		if (node.next_free != null_node)
+		{
+			nodes[node.next_free].prev_free = node.prev_free;
 		}
 
-		add_new_block(new_offset, new_size);
+		node.is_free = false;
+		node.prev_free = null_node;
+		node.next_free = null_node;
 
-		available_size += size;
+		if (free_lists[fl][sl] == null_node)
+		{
+			sl_bitmaps[fl] &= ~(1u << sl);
+			if (sl_bitmaps[fl] == 0)
+			{
+				fl_bitmap &= ~(1ull << fl);
+			}
+		}
+
+		--num_free_blocks;
 	}
 
-	void BlockAllocator::add_new_block(uint64_t offset, uint64_t size)
+	static uint64_t hash_offset(uint64_t offset, uint64_t mask)
 	{
-		auto new_block_it = blocks_by_offset.emplace(offset, OffsetValue());
-		auto order_it = blocks_by_size.emplace(size, new_block_it.first);
-		new_block_it.first->second.size_iterator = order_it;
+		return (offset * 0x9E3779B97F4A7C15ull >> 32) & mask;
+	}
+
+	void BlockAllocator::insert_allocated(uint64_t offset, uint32_t node_index)
+	{
+		if ((num_allocated + 1) * 2 > allocated_keys.size())
+		{
+			grow_allocated_table();
+		}
+
+		const uint64_t mask = allocated_keys.size() - 1;
+		uint64_t slot = hash_offset(offset, mask);
+		while (allocated_keys[slot] != empty_key)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		allocated_keys[slot] = offset;
+		allocated_nodes[slot] = node_index;
+		++num_allocated;
+	}
+
+	uint32_t BlockAllocator::remove_allocated(uint64_t offset)
+	{
+		const uint64_t mask = allocated_keys.size() - 1;
+		uint64_t slot = hash_offset(offset, mask);
+		while (allocated_keys[slot] != offset)
+		{
+			if (allocated_keys[slot] == empty_key)
+			{
+				return null_node;
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		const uint32_t node_index = allocated_nodes[slot];
+
+		// Backward shift deletion: move following entries of the probe chain into the hole, so no tombstones are needed.
+		uint64_t hole = slot;
+		for (uint64_t next = (hole + 1) & mask; allocated_keys[next] != empty_key; next = (next + 1) & mask)
+		{
+			const uint64_t home = hash_offset(allocated_keys[next], mask);
+			if (((next - home) & mask) >= ((next - hole) & mask))
+			{
+				allocated_keys[hole] = allocated_keys[next];
+				allocated_nodes[hole] = allocated_nodes[next];
+				hole = next;
+			}
+		}
+
+		allocated_keys[hole] = empty_key;
+		allocated_nodes[hole] = null_node;
+		--num_allocated;
+
+		return node_index;
+	}
+
+	void BlockAllocator::grow_allocated_table()
+	{
+		std::vector<uint64_t> old_keys = std::move(allocated_keys);
+		std::vector<uint32_t> old_nodes = std::move(allocated_nodes);
+
+		allocated_keys.assign(max<size_t>(old_keys.size() * 2, 64), empty_key);
+		allocated_nodes.assign(allocated_keys.size(), null_node);
+		num_allocated = 0;
+
+		for (size_t i = 0; i < old_keys.size(); ++i)
+		{
+			if (old_keys[i] != empty_key)
+			{
+				insert_allocated(old_keys[i], old_nodes[i]);
+			}
+		}
 	}
-}
\ No newline at end of file
+}
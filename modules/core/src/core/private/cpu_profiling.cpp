@@ -5,7 +5,8 @@
 #include "core/cpu_profiling.h"
 #include "core/imgui.h"
 
-//#include "dx/dx_context.h"
+#include <algorithm>
+#include <chrono>
 
 namespace era_engine
 {
@@ -19,11 +20,6 @@ namespace era_engine
 
 namespace era_engine
 {
-	std::atomic<uint32> cpu_profile_index;
-	std::atomic<uint32> cpu_profile_completely_written[2];
-	ProfileEvent cpu_profile_events[2][MAX_NUM_CPU_PROFILE_EVENTS];
-	ProfileStat cpu_profile_stats[2][MAX_NUM_CPU_PROFILE_STATS];
-
 	struct CpuProfileFrame : ProfileFrame
 	{
 		uint16 first_top_level_block_per_thread[MAX_NUM_CPU_PROFILE_THREADS];
@@ -35,8 +31,21 @@ namespace era_engine
 		uint32 num_stats;
 	};
 
+	// Chrome trace event output of a running capture.
+	struct CpuProfileCapture
+	{
+		FILE* file = nullptr;
+		bool first_event = true;
+
+		uint64 start_timestamp = 0;
+		uint32 remaining_frames = 0; // 0 means unlimited.
+
+		std::vector<uint32> named_threads;
+	};
+
 	static uint32 profile_threads[MAX_NUM_CPU_PROFILE_THREADS];
 	static char profile_thread_names[MAX_NUM_CPU_PROFILE_THREADS][64];
+	static bool profile_thread_exited[MAX_NUM_CPU_PROFILE_THREADS];
 	static uint32 num_threads;
 
 	static CpuProfileFrame profile_frames[MAX_NUM_CPU_PROFILE_FRAMES];
@@ -46,11 +55,101 @@ namespace era_engine
 	static uint32 dummy_frame_write_index;
 
 	static bool pause_recording;
+	static uint64 resolved_frame_id;
 
 	static uint16 stack[MAX_NUM_CPU_PROFILE_THREADS][1024];
 	static uint32 depth[MAX_NUM_CPU_PROFILE_THREADS];
 
-	static uint32 map_thread_id_to_index(uint32 thread_id)
+	// Events and stats drained from the thread buffers in one resolve.
+	static ProfileEvent collected_events[MAX_NUM_CPU_PROFILE_EVENTS];
+	static ProfileStat collected_stats[MAX_NUM_CPU_PROFILE_STATS];
+
+	static std::mutex thread_buffers_mutex;
+	static std::vector<CpuProfileThreadBuffer*> thread_buffers;
+	static uint64 num_dropped_from_retired_buffers;
+
+	// Threads whose buffers were freed in this resolve. Their slots are reused after their last events are handled.
+	static std::vector<uint32> exited_thread_ids;
+
+	static CpuProfileCapture capture;
+
+	// Marks the thread's buffer as retired when the thread exits. The resolve frees it once it is drained.
+	struct CpuProfileThreadBufferOwner
+	{
+		CpuProfileThreadBuffer* buffer = nullptr;
+
+		~CpuProfileThreadBufferOwner()
+		{
+			if (buffer)
+			{
+				buffer->retired.store(true, std::memory_order_release);
+			}
+		}
+	};
+
+	static thread_local CpuProfileThreadBufferOwner thread_buffer_owner;
+
+	uint64 get_cpu_profile_clock_frequency()
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		static const uint64 frequency = []()
+		{
+			using clock = std::chrono::steady_clock;
+
+			const clock::time_point start_time = clock::now();
+			const uint64 start_ticks = get_cpu_profile_timestamp();
+
+			while (clock::now() - start_time < std::chrono::milliseconds(20))
+			{
+			}
+
+			const uint64 end_ticks = get_cpu_profile_timestamp();
+			const double seconds = std::chrono::duration<double>(clock::now() - start_time).count();
+
+			return (uint64)((double)(end_ticks - start_ticks) / seconds);
+		}();
+		return frequency;
+#elif defined(_WIN32)
+		static const uint64 frequency = []()
+		{
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency(&frequency);
+			return (uint64)frequency.QuadPart;
+		}();
+		return frequency;
+#else
+		return 1000000000ull;
+#endif
+	}
+
+	CpuProfileThreadBuffer* acquire_cpu_profile_thread_buffer()
+	{
+		if (thread_buffer_owner.buffer == nullptr)
+		{
+			CpuProfileThreadBuffer* buffer = new CpuProfileThreadBuffer();
+			buffer->thread_id = get_thread_id_fast();
+			get_current_thread_name(buffer->thread_name, sizeof(buffer->thread_name));
+
+			std::lock_guard lock{ thread_buffers_mutex };
+			thread_buffers.push_back(buffer);
+			thread_buffer_owner.buffer = buffer;
+		}
+		return thread_buffer_owner.buffer;
+	}
+
+	uint64 get_num_dropped_cpu_profile_events()
+	{
+		std::lock_guard lock{ thread_buffers_mutex };
+
+		uint64 result = num_dropped_from_retired_buffers;
+		for (CpuProfileThreadBuffer* buffer : thread_buffers)
+		{
+			result += buffer->num_dropped.load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	static uint32 map_thread_id_to_index(uint32 thread_id, const char* thread_name = nullptr)
 	{
 		for (uint32 i = 0; i < num_threads; ++i)
 		{
@@ -60,24 +159,238 @@ namespace era_engine
 			}
 		}
 
-		HANDLE handle = OpenThread(THREAD_ALL_ACCESS, false, thread_id);
-		ASSERT(handle);
-		WCHAR* description = nullptr;
-		checkResult(GetThreadDescription(handle, &description));
-		CloseHandle(handle);
+		if (!thread_name || !thread_name[0])
+		{
+			thread_name = "Main thread";
+		}
 
-		if (!description || !description[0])
+		uint32 index = num_threads;
+		for (uint32 i = 0; i < num_threads; ++i)
 		{
-			description = (WCHAR*)L"Main thread";
+			if (profile_thread_exited[i] && depth[i] == 0)
+			{
+				index = i;
+				break;
+			}
+		}
+
+		if (index == num_threads)
+		{
+			ASSERT(num_threads < MAX_NUM_CPU_PROFILE_THREADS);
+			++num_threads;
 		}
 
-		ASSERT(num_threads < MAX_NUM_CPU_PROFILE_THREADS);
-		uint32 index = num_threads++;
 		profile_threads[index] = thread_id;
-		snprintf(profile_thread_names[index], sizeof(profile_thread_names[index]), "Thread %u (%ws)", thread_id, description);
+		profile_thread_exited[index] = false;
+		snprintf(profile_thread_names[index], sizeof(profile_thread_names[index]), "Thread %u (%s)", thread_id, thread_name);
 		return index;
 	}
 
+	// Moves everything the threads have published so far into 'collected_events' and 'collected_stats'. Events that don't
+	// fit stay in their rings for the next resolve.
+	static void collect_thread_buffers(uint32& num_events, uint32& num_stats)
+	{
+		num_events = 0;
+		num_stats = 0;
+
+		std::lock_guard lock{ thread_buffers_mutex };
+
+		for (auto it = thread_buffers.begin(); it != thread_buffers.end();)
+		{
+			CpuProfileThreadBuffer* buffer = *it;
+
+			// Read before the heads, so that everything a retired thread published is drained below.
+			const bool retired = buffer->retired.load(std::memory_order_acquire);
+
+			const uint32 event_head = buffer->event_head.load(std::memory_order_acquire);
+			uint32 event_tail = buffer->event_tail.load(std::memory_order_relaxed);
+			if (event_head != event_tail)
+			{
+				map_thread_id_to_index(buffer->thread_id, buffer->thread_name);
+			}
+			for (; event_tail != event_head && num_events < MAX_NUM_CPU_PROFILE_EVENTS; ++event_tail)
+			{
+				collected_events[num_events++] = buffer->events[event_tail & (MAX_NUM_CPU_PROFILE_THREAD_EVENTS - 1)];
+			}
+			buffer->event_tail.store(event_tail, std::memory_order_release);
+
+			const uint32 stat_head = buffer->stat_head.load(std::memory_order_acquire);
+			uint32 stat_tail = buffer->stat_tail.load(std::memory_order_relaxed);
+			for (; stat_tail != stat_head && num_stats < MAX_NUM_CPU_PROFILE_STATS; ++stat_tail)
+			{
+				collected_stats[num_stats++] = buffer->stats[stat_tail & (MAX_NUM_CPU_PROFILE_THREAD_STATS - 1)];
+			}
+			buffer->stat_tail.store(stat_tail, std::memory_order_release);
+
+			if (retired && event_tail == event_head && stat_tail == stat_head)
+			{
+				exited_thread_ids.push_back(buffer->thread_id);
+				num_dropped_from_retired_buffers += buffer->num_dropped.load(std::memory_order_relaxed);
+				delete buffer;
+				it = thread_buffers.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	static void write_json_string(FILE* file, const char* string)
+	{
+		fputc('"', file);
+		for (const char* c = string; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fputc('\\', file);
+				fputc(*c, file);
+			}
+			else if ((uint8)*c < 0x20)
+			{
+				fprintf(file, "\\u%04x", (uint32)(uint8)*c);
+			}
+			else
+			{
+				fputc(*c, file);
+			}
+		}
+		fputc('"', file);
+	}
+
+	// Starts a new trace event, the caller writes the fields after "ph".
+	static void begin_trace_event(const char* phase, uint64 timestamp, uint32 thread_id)
+	{
+		fputs(capture.first_event ? "\n" : ",\n", capture.file);
+		capture.first_event = false;
+
+		// Microseconds with nanosecond precision. Events from before the capture started (blocks that were already open) are clamped to it.
+		const uint64 ticks = (timestamp > capture.start_timestamp) ? (timestamp - capture.start_timestamp) : 0;
+		fprintf(capture.file, "{\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", phase, thread_id, cpu_profile_ticks_to_nanoseconds(ticks) * 1e-3);
+	}
+
+	static void write_capture(const ProfileEvent* events, uint32 num_events, const ProfileStat* stats, uint32 num_stats)
+	{
+		for (uint32 i = 0; i < num_events; ++i)
+		{
+			const ProfileEvent& e = events[i];
+
+			if (std::find(capture.named_threads.begin(), capture.named_threads.end(), e.thread_id) == capture.named_threads.end())
+			{
+				capture.named_threads.push_back(e.thread_id);
+
+				begin_trace_event("M", capture.start_timestamp, e.thread_id);
+				fputs(",\"name\":\"thread_name\",\"args\":{\"name\":", capture.file);
+				write_json_string(capture.file, profile_thread_names[map_thread_id_to_index(e.thread_id)]);
+				fputs("}}", capture.file);
+			}
+
+			switch (e.type)
+			{
+			case profile_event_begin_block:
+			case profile_event_end_block:
+			{
+				begin_trace_event((e.type == profile_event_begin_block) ? "B" : "E", e.timestamp, e.thread_id);
+				fputs(",\"name\":", capture.file);
+				write_json_string(capture.file, e.name);
+				fputs("}", capture.file);
+			} break;
+
+			case profile_event_frame_marker:
+			{
+				begin_trace_event("i", e.timestamp, e.thread_id);
+				fputs(",\"s\":\"g\",\"name\":\"Frame end\"}", capture.file);
+
+				if (capture.remaining_frames != 0 && --capture.remaining_frames == 0)
+				{
+					end_cpu_profile_capture();
+					return;
+				}
+			} break;
+
+			case profile_event_flow_begin:
+			case profile_event_flow_end:
+			{
+				// Ids are written as strings, JSON numbers lose precision above 2^53. Both ends are recorded inside a slice (the job's
+				// block) and bind to it, "bp":"e" keeps the end from binding to the next slice instead.
+				begin_trace_event((e.type == profile_event_flow_begin) ? "s" : "f", e.timestamp, e.thread_id);
+				fprintf(capture.file, ",\"cat\":\"flow\",\"name\":\"Continuation\",\"id\":\"0x%llx\"%s}", (unsigned long long)e.flow_id,
+					(e.type == profile_event_flow_end) ? ",\"bp\":\"e\"" : "");
+			} break;
+			}
+		}
+
+		for (uint32 i = 0; i < num_stats; ++i)
+		{
+			const ProfileStat& stat = stats[i];
+
+			double value;
+			switch (stat.type)
+			{
+			case profile_stat_type_bool: value = stat.bool_value ? 1.0 : 0.0; break;
+			case profile_stat_type_int32: value = (double)stat.int32_value; break;
+			case profile_stat_type_uint32: value = (double)stat.uint32_value; break;
+			case profile_stat_type_int64: value = (double)stat.int64_value; break;
+			case profile_stat_type_uint64: value = (double)stat.uint64_value; break;
+			case profile_stat_type_float: value = (double)stat.float_value; break;
+			default: continue; // Strings have no counter representation.
+			}
+
+			begin_trace_event("C", stat.timestamp, 0);
+			fputs(",\"name\":", capture.file);
+			write_json_string(capture.file, stat.label);
+			fprintf(capture.file, ",\"args\":{\"value\":%.9g}}", value);
+		}
+	}
+
+	bool begin_cpu_profile_capture(const fs::path& path, uint32 num_frames)
+	{
+		end_cpu_profile_capture();
+
+		std::error_code error;
+		fs::create_directories(path.parent_path(), error);
+
+#if defined(_WIN32)
+		FILE* file = _wfopen(path.c_str(), L"w");
+#else
+		FILE* file = fopen(path.c_str(), "w");
+#endif
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		// Chrome trace JSON array format. Trace viewers also accept the array without its closing bracket, so a capture of
+		// a crashed run is still readable.
+		fputs("[", file);
+
+		capture.file = file;
+		capture.first_event = true;
+		capture.start_timestamp = get_cpu_profile_timestamp();
+		capture.remaining_frames = num_frames;
+		capture.named_threads.clear();
+
+		begin_trace_event("M", capture.start_timestamp, 0);
+		fputs(",\"name\":\"process_name\",\"args\":{\"name\":\"Era Engine\"}}", capture.file);
+
+		return true;
+	}
+
+	void end_cpu_profile_capture()
+	{
+		if (capture.file != nullptr)
+		{
+			fputs("\n]\n", capture.file);
+			fclose(capture.file);
+			capture.file = nullptr;
+		}
+	}
+
+	bool is_cpu_profile_capture_active()
+	{
+		return capture.file != nullptr;
+	}
+
 	static void initialize_new_frame(CpuProfileFrame& old_frame, CpuProfileFrame& new_frame)
 	{
 		for (uint32 thread = 0; thread < MAX_NUM_CPU_PROFILE_THREADS; ++thread)
@@ -100,17 +413,12 @@ namespace era_engine
 	{
 		uint32 current_frame = profile_frame_write_index;
 
-		uint32 array_index = _CPU_PROFILE_GET_ARRAY_INDEX(cpu_profile_index); // We are only interested in the most significant bit here, so don't worry about thread safety.
-		uint32 current_index = cpu_profile_index.exchange((1 - array_index) << 31); // Swap array and get current event count.
-
-		ProfileEvent* events = cpu_profile_events[array_index];
-		uint32 num_events = _CPU_PROFILE_GET_EVENT_INDEX(current_index);
-		auto stats = cpu_profile_stats[array_index];
-		uint32 num_stats = _CPU_PROFILE_GET_STAT_INDEX(current_index);
-		uint32 num_writes = num_events + num_stats;
+		uint32 num_events;
+		uint32 num_stats;
+		collect_thread_buffers(num_events, num_stats);
 
-		while (num_writes > cpu_profile_completely_written[array_index]) {} // Wait until all events and stats have been written completely.
-		cpu_profile_completely_written[array_index] = 0;
+		ProfileEvent* events = collected_events;
+		ProfileStat* stats = collected_stats;
 
 		static bool initialized_stack = false;
 
@@ -127,7 +435,7 @@ namespace era_engine
 			initialized_stack = true;
 		}
 
-		CPU_PROFILE_BLOCK("CPU Profiling"); // Important: Must be after array swap!
+		CPU_PROFILE_BLOCK("CPU Profiling"); // Recorded into the next resolve, the buffers are drained already.
 
 		{
 			CPU_PROFILE_BLOCK("Collate profile events from last frame");
@@ -137,6 +445,11 @@ namespace era_engine
 					return a.timestamp < b.timestamp;
 				});
 
+			if (capture.file != nullptr)
+			{
+				CPU_PROFILE_BLOCK("Write profile capture");
+				write_capture(events, num_events, stats, num_stats);
+			}
 
 			CpuProfileFrame* frame = !pause_recording ? (profile_frames + profile_frame_write_index) : (dummy_frames + dummy_frame_write_index);
 
@@ -151,8 +464,7 @@ namespace era_engine
 				uint64 frame_end_timestamp = 0;
 				if (handle_profile_event(events, i, num_events, stack[thread_index], depth[thread_index], frame->profile_block_pool, frame->total_num_profile_blocks, frame_end_timestamp, false))
 				{
-					static uint64 clock_frequency;
-					static bool performance_frequency_queried = QueryPerformanceFrequency((LARGE_INTEGER*)&clock_frequency);
+					const uint64 clock_frequency = get_cpu_profile_clock_frequency();
 
 					CpuProfileFrame* previous_frame;
 					if (!pause_recording)
@@ -169,7 +481,7 @@ namespace era_engine
 					frame->start_clock = (previous_frame->end_clock == 0) ? frame_end_timestamp : previous_frame->end_clock;
 					frame->end_clock = frame_end_timestamp;
 
-					frame->global_frame_id = dxContext.frameID;
+					frame->global_frame_id = resolved_frame_id++;
 
 					frame->duration = (float)(frame->end_clock - frame->start_clock) / clock_frequency * 1000.f;
 
@@ -224,6 +536,18 @@ namespace era_engine
 				}
 
 			}
+
+			for (uint32 thread_id : exited_thread_ids)
+			{
+				for (uint32 i = 0; i < num_threads; ++i)
+				{
+					if (profile_threads[i] == thread_id)
+					{
+						profile_thread_exited[i] = true;
+					}
+				}
+			}
+			exited_thread_ids.clear();
 		}
 
 		if (cpu_profiler_window_open)
@@ -0,0 +1,221 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "core/frame_allocator.h"
+#include "core/threading.h"
+#include "core/cpu_profiling.h"
+
+namespace era_engine
+{
+	namespace
+	{
+		// Owned by exactly one thread. Only the atomics are read from other threads (statistics).
+		struct FrameArena : Allocator
+		{
+			FrameArena(uint64 _minimum_block_size, uint64 _reserve_size)
+				: Allocator(_minimum_block_size, _reserve_size)
+			{
+			}
+
+			void* allocate_in_frame(uint64 size, uint64 alignment, uint64 frame)
+			{
+				if (last_frame != frame)
+				{
+					peak.store(max(peak.load(std::memory_order_relaxed), current), std::memory_order_relaxed);
+					reset_to_marker(MemoryMarker{ 0 });
+					last_frame = frame;
+				}
+
+				uint8* result = allocate_internal(size, alignment);
+
+				used.store(current, std::memory_order_relaxed);
+				committed.store(committed_memory, std::memory_order_relaxed);
+				used_in_frame.store(frame, std::memory_order_relaxed);
+
+				return result;
+			}
+
+			// Memory of a frame that is over counts as free, even if the arena hasn't been rewound yet.
+			uint64 get_used(uint64 first_live_frame) const
+			{
+				return (used_in_frame.load(std::memory_order_relaxed) >= first_live_frame) ? used.load(std::memory_order_relaxed) : 0;
+			}
+
+			uint64 get_peak() const
+			{
+				return max(peak.load(std::memory_order_relaxed), used.load(std::memory_order_relaxed));
+			}
+
+			uint64 last_frame = 0;
+
+			std::atomic<uint64> used = 0;
+			std::atomic<uint64> peak = 0;
+			std::atomic<uint64> committed = 0;
+			std::atomic<uint64> used_in_frame = 0;
+		};
+	}
+
+	struct FrameAllocator::ThreadArenas
+	{
+		ThreadArenas(uint32 _thread_id, uint64 minimum_block_size, uint64 reserve_size)
+			: thread_id(_thread_id),
+			  single_frame(minimum_block_size, reserve_size),
+			  double_buffered{ { minimum_block_size, reserve_size }, { minimum_block_size, reserve_size } }
+		{
+		}
+
+		uint32 thread_id;
+
+		FrameArena single_frame;
+
+		// Indexed by frame & 1. A buffer is rewound when it comes around again two frames later.
+		FrameArena double_buffered[2];
+	};
+
+	static std::atomic<uint64> next_frame_allocator_id = 1;
+
+	FrameAllocator::FrameAllocator(uint64 _reserve_size_per_arena, uint64 _minimum_block_size)
+		: id(next_frame_allocator_id++),
+		  reserve_size_per_arena(_reserve_size_per_arena),
+		  minimum_block_size(_minimum_block_size)
+	{
+	}
+
+	FrameAllocator::~FrameAllocator()
+	{
+		for (ThreadArenas* thread_arenas : arenas)
+		{
+			delete thread_arenas;
+		}
+	}
+
+	FrameAllocator::ThreadArenas* FrameAllocator::get_thread_arenas()
+	{
+		struct CacheEntry
+		{
+			uint64 allocator_id;
+			ThreadArenas* arenas;
+		};
+
+		// Usually there is exactly one frame allocator, so this stays a one-element search.
+		static thread_local std::vector<CacheEntry> cache;
+
+		for (const CacheEntry& entry : cache)
+		{
+			if (entry.allocator_id == id)
+			{
+				return entry.arenas;
+			}
+		}
+
+		// Arenas of exited threads aren't reused. Worker threads live as long as the engine, so this doesn't add up.
+		ThreadArenas* thread_arenas = new ThreadArenas(get_thread_id_fast(), minimum_block_size, reserve_size_per_arena);
+		{
+			std::lock_guard lock{ arenas_mutex };
+			arenas.push_back(thread_arenas);
+		}
+
+		cache.push_back({ id, thread_arenas });
+		return thread_arenas;
+	}
+
+	void* FrameAllocator::allocate(uint64 size, uint64 alignment, FrameLifetime lifetime)
+	{
+		if (size == 0)
+		{
+			return nullptr;
+		}
+
+		ThreadArenas* thread_arenas = get_thread_arenas();
+		const uint64 frame = frame_id.load(std::memory_order_acquire);
+
+		if (lifetime == FrameLifetime::SingleFrame)
+		{
+			return thread_arenas->single_frame.allocate_in_frame(size, alignment, frame);
+		}
+		return thread_arenas->double_buffered[frame & 1].allocate_in_frame(size, alignment, frame);
+	}
+
+	void FrameAllocator::begin_frame()
+	{
+		frame_id.fetch_add(1, std::memory_order_release);
+	}
+
+	uint64 FrameAllocator::get_frame_id() const
+	{
+		return frame_id.load(std::memory_order_acquire);
+	}
+
+	std::vector<FrameArenaStats> FrameAllocator::get_stats() const
+	{
+		const uint64 frame = get_frame_id();
+
+		std::lock_guard lock{ arenas_mutex };
+
+		std::vector<FrameArenaStats> result;
+		result.reserve(arenas.size());
+
+		for (const ThreadArenas* thread_arenas : arenas)
+		{
+			const FrameArena& single_frame = thread_arenas->single_frame;
+			const FrameArena(&double_buffered)[2] = thread_arenas->double_buffered;
+
+			FrameArenaStats& stats = result.emplace_back();
+			stats.thread_id = thread_arenas->thread_id;
+
+			stats.used = single_frame.get_used(frame);
+			stats.peak = single_frame.get_peak();
+
+			stats.double_buffered_used = double_buffered[0].get_used(frame - 1) + double_buffered[1].get_used(frame - 1);
+			stats.double_buffered_peak = max(double_buffered[0].get_peak(), double_buffered[1].get_peak());
+
+			stats.committed = single_frame.committed.load(std::memory_order_relaxed)
+				+ double_buffered[0].committed.load(std::memory_order_relaxed)
+				+ double_buffered[1].committed.load(std::memory_order_relaxed);
+		}
+
+		return result;
+	}
+
+	FrameMemoryResource::FrameMemoryResource(FrameAllocator& _allocator, FrameLifetime _lifetime)
+		: allocator(_allocator), lifetime(_lifetime)
+	{
+	}
+
+	void* FrameMemoryResource::do_allocate(size_t bytes, size_t alignment)
+	{
+		// std::pmr containers expect a valid pointer even for empty requests.
+		return allocator.allocate(max<uint64>(bytes, 1), alignment, lifetime);
+	}
+
+	void FrameMemoryResource::do_deallocate(void* ptr, size_t bytes, size_t alignment)
+	{
+	}
+
+	bool FrameMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+	{
+		const FrameMemoryResource* other_resource = dynamic_cast<const FrameMemoryResource*>(&other);
+		return other_resource != nullptr && &other_resource->allocator == &allocator && other_resource->lifetime == lifetime;
+	}
+
+	FrameAllocator frame_allocator;
+	FrameMemoryResource frame_memory_resource(frame_allocator, FrameLifetime::SingleFrame);
+	FrameMemoryResource double_buffered_frame_memory_resource(frame_allocator, FrameLifetime::TwoFrames);
+
+	void report_frame_allocator_stats()
+	{
+		uint64 used = 0;
+		uint64 peak = 0;
+		uint64 committed = 0;
+
+		for (const FrameArenaStats& stats : frame_allocator.get_stats())
+		{
+			used += stats.used + stats.double_buffered_used;
+			peak = max(peak, max(stats.peak, stats.double_buffered_peak));
+			committed += stats.committed;
+		}
+
+		CPU_PROFILE_STAT("Frame arenas used (KB)", BYTE_TO_KB(used));
+		CPU_PROFILE_STAT("Frame arena peak, largest thread (KB)", BYTE_TO_KB(peak));
+		CPU_PROFILE_STAT("Frame arenas committed (KB)", BYTE_TO_KB(committed));
+	}
+}
@@ -1,60 +1,123 @@
 // Copyright (c) 2023-present Eldar Muradov. All rights reserved.
 
 #include "core/job_system.h"
+#include "core/threading.h"
+#include "core/cpu_profiling.h"
 #include "core/math.h"
 #include "core/imgui.h"
 
 namespace era_engine
 {
-    void JobQueue::initialize(uint32 num_threads, uint32 thread_offset, int thread_priority, const wchar* description)
+    // Set on worker threads, so that submits from inside a job can go to the worker's own deque.
+    static thread_local JobQueue* current_worker_queue = nullptr;
+    static thread_local int32 current_worker_index = -1;
+    static thread_local uint32 steal_random_state = 0;
+
+    void JobQueue::initialize(uint32 num_threads, uint32 thread_offset, ThreadPriority thread_priority, const wchar* description, JobQueueMode mode)
     {
-        queue = moodycamel::ConcurrentQueue<int32>(capacity);
+        queue = moodycamel::ConcurrentQueue<int32>(initial_queue_capacity);
 
-        for (uint32 i = 0; i < num_threads; ++i)
+        this->mode = mode;
+        this->num_threads = num_threads;
+
+        if (mode == JobQueueMode::WorkStealing && num_threads > 0)
         {
-            std::thread thread([this, i]() { thread_func(i); });
+            workers = std::make_unique<Worker[]>(num_threads);
+        }
 
-            HANDLE handle = (HANDLE)thread.native_handle();
-            SetThreadPriority(handle, thread_priority);
+        for (uint32 i = 0; i < num_threads; ++i)
+        {
+            // Named from inside, so the name is there before the thread's first profile event. The priority is set from
+            // inside as well, some platforms can only change it for the calling thread.
+            std::thread thread([this, i, description, thread_priority]()
+                {
+                    set_thread_name(get_current_native_thread(), description);
+                    set_thread_priority(get_current_native_thread(), thread_priority);
+                    thread_func(i);
+                });
 
-            uint64 affinityMask = 1ull << (i + thread_offset);
-            SetThreadAffinityMask(handle, affinityMask);
-            SetThreadDescription(handle, description);
+            NativeThreadHandle handle = thread.native_handle();
+            set_thread_affinity(handle, i + thread_offset);
 
             thread.detach();
         }
     }
 
-    void JobQueue::add_continuation(int32 first, JobHandle second)
+    void JobQueue::add_continuation(JobHandle first, JobHandle second)
     {
-        JobQueueEntry& first_job = all_jobs[first];
-        //ASSERT(firstJob.continuation.index == -1);
+        JobQueueEntry& first_job = get_job(first.index);
 
-        int32 unfinished = first_job.num_unfinished_jobs++;
-        if (unfinished == 0)
-        {
-            // First job was finished before adding continuation -> just submit second.
-            second.queue->submit(second.index);
-        }
-        else
+        uint64 state = first_job.state.load();
+        while (true)
         {
-            // First job hadn't finished before -> add second as continuation and then finish first (which decrements numUnfinished again).
-            first_job.continuation = second;
-            finish_job(first);
+            if (get_generation(state) != first.generation || get_unfinished_count(state) == 0)
+            {
+                // First job was finished (and maybe already recycled) before adding continuation -> just submit second.
+                second.queue->submit(second.index);
+                return;
+            }
+
+            if (first_job.state.compare_exchange_weak(state, state + 1))
+            {
+                break;
+            }
         }
+
+        // First job hadn't finished before -> add second as continuation and then finish first (which decrements the counter again).
+        second.queue->get_job(second.index).is_continuation = 1;
+        first_job.continuation = second;
+
+        // If the first job finished in the meantime, the flow to the continuation starts here and needs a slice to bind to.
+        CPU_PROFILE_BLOCK("Add continuation");
+        finish_job(first.index);
+    }
+
+    void JobQueue::add_reference(JobHandle handle)
+    {
+        uint64 previous = get_job(handle.index).state.fetch_add(1);
+
+        // Children must be created while the parent is still running (or not yet submitted).
+        ASSERT(get_generation(previous) == handle.generation && get_unfinished_count(previous) > 0);
     }
 
     void JobQueue::submit(int32 handle)
     {
         if (handle != -1)
         {
+            // Count before publishing, otherwise a fast worker can finish the job before the increment.
+            ++running_jobs;
+
+            if (mode == JobQueueMode::WorkStealing
+                && current_worker_queue == this
+                && workers[current_worker_index].deque.push(handle))
+            {
+                wake_worker();
+                return;
+            }
+
             while (!queue.try_enqueue(handle))
             {
                 execute_next_job();
             }
 
-            ++running_jobs;
+            wake_worker();
+        }
+    }
+
+    void JobQueue::wake_worker()
+    {
+        if (mode == JobQueueMode::Shared)
+        {
+            wake_condition.notify_one();
+            return;
+        }
 
+        // Workers register as sleeping under the mutex before re-checking for work, so either they see our job
+        // or we see them sleeping. Most of the time everybody is spinning or busy and this is just one load.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (num_sleeping_workers.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
             wake_condition.notify_one();
         }
     }
@@ -67,14 +130,33 @@ namespace era_engine
         }
     }
 
-    void JobQueue::wait_for_completion(int32 handle)
+    void JobQueue::wait_for_completion(JobHandle handle)
     {
-        if (handle != -1)
+        if (handle.index != -1)
         {
-            JobQueueEntry& job = all_jobs[handle];
+            JobQueueEntry& job = get_job(handle.index);
+
+            if (get_generation(job.state.load()) != handle.generation)
+            {
+                // The job had finished and its slot was recycled before we got here. Nothing to wait for, but worth knowing about.
+                ++stale_waits;
+                return;
+            }
 
-            while (job.num_unfinished_jobs > 0)
+            while (true)
             {
+                // Finishing a job bumps the generation of its slot right away.
+                uint64 state = job.state.load();
+                if (get_generation(state) != handle.generation)
+                {
+                    break;
+                }
+
+                if (get_unfinished_count(state) == 0)
+                {
+                    break;
+                }
+
                 execute_next_job();
             }
         }
@@ -82,26 +164,156 @@ namespace era_engine
 
     int32 JobQueue::allocate_job()
     {
-        return (int32)(next_free_job++ & index_mask);
+        int32 handle = pop_free_slot();
+        while (handle == -1)
+        {
+            handle = grow();
+            if (handle == -1)
+            {
+                // All chunks are in use. Help out until somebody releases a slot.
+                if (!execute_next_job())
+                {
+                    std::this_thread::yield();
+                }
+                handle = pop_free_slot();
+            }
+        }
+
+        uint32 in_flight = ++in_flight_jobs;
+        uint32 peak = peak_in_flight_jobs.load(std::memory_order_relaxed);
+        while (in_flight > peak && !peak_in_flight_jobs.compare_exchange_weak(peak, in_flight, std::memory_order_relaxed))
+        {
+        }
+
+        return handle;
+    }
+
+    int32 JobQueue::pop_free_slot()
+    {
+        uint64 head = free_list_head.load(std::memory_order_acquire);
+        while (true)
+        {
+            uint32 index = (uint32)head;
+            if (index == invalid_slot)
+            {
+                return -1;
+            }
+
+            // May read the link of a slot that was just popped by somebody else. The tag makes the CAS fail in that case.
+            int32 next = get_next_free(index).load(std::memory_order_relaxed);
+            uint64 new_head = (((head >> 32) + 1) << 32) | (uint32)next;
+            if (free_list_head.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return (int32)index;
+            }
+        }
+    }
+
+    void JobQueue::push_free_slots(int32 first, int32 last)
+    {
+        uint64 head = free_list_head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            get_next_free(last).store((int32)(uint32)head, std::memory_order_relaxed);
+            uint64 new_head = (((head >> 32) + 1) << 32) | (uint32)first;
+            if (free_list_head.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+    }
+
+    int32 JobQueue::grow()
+    {
+        std::lock_guard<std::mutex> lock(grow_mutex);
+
+        // Somebody else might have grown (or released slots) while we were waiting for the lock.
+        int32 handle = pop_free_slot();
+        if (handle != -1)
+        {
+            return handle;
+        }
+
+        uint32 chunk_index = num_chunks.load(std::memory_order_relaxed);
+        if (chunk_index == max_num_chunks)
+        {
+            return -1;
+        }
+
+        JobChunk* chunk = new JobChunk();
+        for (uint32 i = 0; i < chunk_size; ++i)
+        {
+            chunk->entries[i].state.store(0, std::memory_order_relaxed);
+            chunk->next_free[i].store((int32)((chunk_index << chunk_shift) + i + 1), std::memory_order_relaxed);
+        }
+
+        chunks[chunk_index].store(chunk, std::memory_order_release);
+        num_chunks.store(chunk_index + 1, std::memory_order_release);
+
+        // Keep the first slot for ourselves, the rest goes to the free list.
+        const int32 first = (int32)(chunk_index << chunk_shift);
+        push_free_slots(first + 1, first + (int32)chunk_mask);
+
+        return first;
+    }
+
+    void JobQueue::release_job(int32 handle)
+    {
+        JobQueueEntry& job = get_job(handle);
+
+        // Bumping the generation invalidates all outstanding handles to this job.
+        const uint32 generation = get_generation(job.state.load(std::memory_order_relaxed));
+        job.state.store((uint64)(generation + 1) << 32, std::memory_order_release);
+
+        push_free_slots(handle, handle);
+        --in_flight_jobs;
+    }
+
+    uint64 JobQueue::get_flow_id(int32 handle, uint32 generation) const
+    {
+        // Slots never move and user space addresses fit into 48 bits, the generation tells reuses of a slot apart.
+        return (uint64)(uintptr_t)&get_job(handle) | ((uint64)(generation & 0xFFFF) << 48);
+    }
+
+    JobQueue::JobQueueStats JobQueue::get_stats() const
+    {
+        JobQueueStats stats;
+        stats.in_flight_jobs = in_flight_jobs.load(std::memory_order_relaxed);
+        stats.peak_in_flight_jobs = peak_in_flight_jobs.load(std::memory_order_relaxed);
+        stats.allocated_slots = num_chunks.load(std::memory_order_relaxed) * chunk_size;
+        stats.stale_waits = stale_waits.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void JobQueue::reset_peak_in_flight_jobs()
+    {
+        peak_in_flight_jobs.store(in_flight_jobs.load(std::memory_order_relaxed), std::memory_order_relaxed);
     }
 
     void JobQueue::finish_job(int32 handle)
     {
-        JobQueueEntry& job = all_jobs[handle];
-        int32 num_unfinished_jobs = --job.num_unfinished_jobs;
-        ASSERT(num_unfinished_jobs >= 0);
-        if (num_unfinished_jobs == 0)
+        JobQueueEntry& job = get_job(handle);
+        uint64 state = --job.state;
+        ASSERT(get_unfinished_count(state) != 0xFFFFFFFF);
+        if (get_unfinished_count(state) == 0)
         {
             --running_jobs;
 
-            if (job.parent != -1)
+            const int32 parent = job.parent;
+            const JobHandle continuation = job.continuation;
+
+            // Nobody can take a new reference to a finished job, so the slot can go back to the pool right away.
+            release_job(handle);
+
+            if (parent != -1)
             {
-                finish_job(job.parent);
+                finish_job(parent);
             }
 
-            if (job.continuation.index != -1)
+            if (continuation.index != -1)
             {
-                job.continuation.queue->submit(job.continuation.index);
+                CPU_PROFILE_FLOW_BEGIN(continuation.queue->get_flow_id(continuation.index, continuation.generation));
+                continuation.queue->submit(continuation.index);
             }
         }
     }
@@ -109,10 +321,21 @@ namespace era_engine
     bool JobQueue::execute_next_job()
     {
         int32 handle = -1;
-        if (queue.try_dequeue(handle))
+        if (pop_job(handle))
         {
-            JobQueueEntry& job = all_jobs[handle];
-            job.function(job.templated_function, job.data, { handle, this });
+            JobQueueEntry& job = get_job(handle);
+            const uint32 generation = get_generation(job.state.load(std::memory_order_relaxed));
+
+            // Trace viewers drop flow events outside of a slice. Both the end of the flow into this job and the begin of the
+            // flow to its continuation (in finish_job) are recorded inside this block.
+            CPU_PROFILE_BLOCK("Job");
+
+            if (job.is_continuation)
+            {
+                CPU_PROFILE_FLOW_END(get_flow_id(handle, generation));
+            }
+
+            job.function(job.templated_function, job.data, { handle, generation, this });
 
             finish_job(handle);
 
@@ -122,15 +345,144 @@ namespace era_engine
         return false;
     }
 
+    bool JobQueue::pop_job(int32& handle)
+    {
+        if (mode == JobQueueMode::Shared)
+        {
+            return queue.try_dequeue(handle);
+        }
+
+        if (current_worker_queue == this && workers[current_worker_index].deque.pop(handle))
+        {
+            return true;
+        }
+
+        if (queue.try_dequeue(handle))
+        {
+            return true;
+        }
+
+        return steal_job(handle);
+    }
+
+    bool JobQueue::steal_job(int32& handle)
+    {
+        if (num_threads == 0)
+        {
+            return false;
+        }
+
+        if (steal_random_state == 0)
+        {
+            steal_random_state = (uint32)std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1u;
+        }
+
+        // Xorshift32. Start at a random victim so that thieves don't all hammer the same deque.
+        steal_random_state ^= steal_random_state << 13;
+        steal_random_state ^= steal_random_state >> 17;
+        steal_random_state ^= steal_random_state << 5;
+
+        const uint32 start = steal_random_state % num_threads;
+        for (uint32 i = 0; i < num_threads; ++i)
+        {
+            const uint32 victim = (start + i) % num_threads;
+            if (current_worker_queue == this && victim == (uint32)current_worker_index)
+            {
+                continue;
+            }
+
+            if (workers[victim].deque.steal(handle))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    int32 JobQueue::get_current_worker_index() const
+    {
+        return (current_worker_queue == this) ? current_worker_index : -1;
+    }
+
+    bool JobQueue::has_local_work() const
+    {
+        if (mode == JobQueueMode::WorkStealing && current_worker_queue == this)
+        {
+            return !workers[current_worker_index].deque.empty();
+        }
+        return queue.size_approx() > 0;
+    }
+
+    bool JobQueue::has_pending_jobs() const
+    {
+        if (queue.size_approx() > 0)
+        {
+            return true;
+        }
+
+        if (mode == JobQueueMode::WorkStealing)
+        {
+            for (uint32 i = 0; i < num_threads; ++i)
+            {
+                if (!workers[i].deque.empty())
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
     void JobQueue::thread_func(int32 thread_index)
     {
+        if (mode == JobQueueMode::Shared)
+        {
+            while (true)
+            {
+                if (!execute_next_job())
+                {
+                    std::unique_lock<std::mutex> lock(wake_mutex);
+                    wake_condition.wait(lock);
+                }
+            }
+        }
+
+        current_worker_queue = this;
+        current_worker_index = thread_index;
+
         while (true)
         {
-            if (!execute_next_job())
+            if (execute_next_job())
+            {
+                continue;
+            }
+
+            bool found_job = false;
+            for (uint32 spin = 0; spin < spin_count_before_sleep; ++spin)
+            {
+                cpu_pause();
+                if (execute_next_job())
+                {
+                    found_job = true;
+                    break;
+                }
+            }
+
+            if (found_job)
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            ++num_sleeping_workers;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!has_pending_jobs())
             {
-                std::unique_lock<std::mutex> lock(wake_mutex);
                 wake_condition.wait(lock);
             }
+            --num_sleeping_workers;
         }
     }
 
@@ -141,28 +493,42 @@ namespace era_engine
 
     void JobHandle::submit_after(JobHandle before)
     {
-        before.queue->add_continuation(before.index, *this);
+        before.queue->add_continuation(before, *this);
     }
 
     void JobHandle::wait_for_completion()
     {
-        queue->wait_for_completion(index);
+        if (queue)
+        {
+            queue->wait_for_completion(*this);
+        }
     }
 
     JobQueue high_priority_job_queue;
     JobQueue low_priority_job_queue;
+    JobQueue fixed_update_job_queue;
     JobQueue main_thread_job_queue;
 
     void initialize_job_system()
     {
-        HANDLE handle = GetCurrentThread();
-        SetThreadAffinityMask(handle, 1);
-        SetThreadPriority(handle, THREAD_PRIORITY_HIGHEST);
-        CloseHandle(handle);
-
-        high_priority_job_queue.initialize(2, 1, THREAD_PRIORITY_NORMAL, L"High priority worker");
-        low_priority_job_queue.initialize(2, 3, THREAD_PRIORITY_BELOW_NORMAL, L"Low priority worker");
-        main_thread_job_queue.initialize(0, 0, 0, 0);
+        NativeThreadHandle handle = get_current_native_thread();
+        set_thread_affinity(handle, 0);
+        set_thread_priority(handle, ThreadPriority::Highest);
+
+        // Core 0 is the main thread, the last two are for low priority work and everything in between runs data parallel work.
+        const uint32 num_low_priority_threads = 2;
+        const uint32 num_hardware_threads = get_hardware_thread_count();
+        const uint32 num_high_priority_threads = (num_hardware_threads > 1 + num_low_priority_threads + 2)
+            ? num_hardware_threads - 1 - num_low_priority_threads
+            : 2;
+
+        high_priority_job_queue.initialize(num_high_priority_threads, 1, ThreadPriority::Normal, L"High priority worker", JobQueueMode::WorkStealing);
+        low_priority_job_queue.initialize(num_low_priority_threads, 1 + num_high_priority_threads, ThreadPriority::BelowNormal, L"Low priority worker");
+
+        // The fixed update runs at a low rate, its workers share the first cores with the high priority workers.
+        const uint32 num_fixed_update_threads = 2;
+        fixed_update_job_queue.initialize(num_fixed_update_threads, 1, ThreadPriority::Normal, L"Fixed update worker", JobQueueMode::WorkStealing);
+        main_thread_job_queue.initialize(0, 0, ThreadPriority::Normal, 0);
     }
 
     void execute_main_thread_jobs()
@@ -170,6 +536,31 @@ namespace era_engine
         main_thread_job_queue.wait_for_completion();
     }
 
+    void report_job_system_stats()
+    {
+        JobQueue::JobQueueStats high_priority_stats = high_priority_job_queue.get_stats();
+        JobQueue::JobQueueStats low_priority_stats = low_priority_job_queue.get_stats();
+        JobQueue::JobQueueStats main_thread_stats = main_thread_job_queue.get_stats();
+        JobQueue::JobQueueStats fixed_update_stats = fixed_update_job_queue.get_stats();
+
+        CPU_PROFILE_STAT("High priority jobs in flight (peak)", high_priority_stats.peak_in_flight_jobs);
+        CPU_PROFILE_STAT("Low priority jobs in flight (peak)", low_priority_stats.peak_in_flight_jobs);
+        CPU_PROFILE_STAT("Main thread jobs in flight (peak)", main_thread_stats.peak_in_flight_jobs);
+        CPU_PROFILE_STAT("Fixed update jobs in flight (peak)", fixed_update_stats.peak_in_flight_jobs);
+        CPU_PROFILE_STAT("Job slots allocated", high_priority_stats.allocated_slots + low_priority_stats.allocated_slots + main_thread_stats.allocated_slots
+            + fixed_update_stats.allocated_slots);
+
+        TracyPlot("High priority jobs in flight (peak)", (int64_t)high_priority_stats.peak_in_flight_jobs);
+        TracyPlot("Low priority jobs in flight (peak)", (int64_t)low_priority_stats.peak_in_flight_jobs);
+        TracyPlot("Main thread jobs in flight (peak)", (int64_t)main_thread_stats.peak_in_flight_jobs);
+        TracyPlot("Fixed update jobs in flight (peak)", (int64_t)fixed_update_stats.peak_in_flight_jobs);
+
+        high_priority_job_queue.reset_peak_in_flight_jobs();
+        low_priority_job_queue.reset_peak_in_flight_jobs();
+        main_thread_job_queue.reset_peak_in_flight_jobs();
+        fixed_update_job_queue.reset_peak_in_flight_jobs();
+    }
+
     JobHandle schedule_low_priority_job(const DefaultJob& data, JobHandle parent_job/* = {}*/)
     {
         JobHandle job = low_priority_job_queue.createJob<DefaultJob>([](DefaultJob& job_data, JobHandle job)
@@ -0,0 +1,229 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include "core/job_system.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace era_engine
+{
+    namespace detail
+    {
+        struct EmptyJobData
+        {
+        };
+
+        template <typename Func_>
+        struct ParallelForJobData
+        {
+            const Func_* func;
+            JobQueue* queue;
+            uint32 begin;
+            uint32 end;
+            uint32 grain;
+        };
+
+        template <typename Func_>
+        void parallel_for_job(ParallelForJobData<Func_>& data, JobHandle job);
+
+        template <typename Func_>
+        void parallel_for_range(JobQueue& queue, const Func_& func, uint32 begin, uint32 end, uint32 grain, JobHandle parent)
+        {
+            while (end - begin > grain)
+            {
+                if (queue.has_local_work())
+                {
+                    // Somebody can still steal from us -> no need to create more jobs yet.
+                    func(begin, begin + grain);
+                    begin += grain;
+                    continue;
+                }
+
+                const uint32 middle = begin + (end - begin) / 2;
+
+                ParallelForJobData<Func_> data = { &func, &queue, middle, end, grain };
+                queue.createJob<ParallelForJobData<Func_>>(parallel_for_job<Func_>, data, parent).submit_now();
+
+                end = middle;
+            }
+
+            func(begin, end);
+        }
+
+        template <typename Func_>
+        void parallel_for_job(ParallelForJobData<Func_>& data, JobHandle job)
+        {
+            parallel_for_range(*data.queue, *data.func, data.begin, data.end, data.grain, job);
+        }
+
+        template <typename T_>
+        struct ReductionBuffer
+        {
+            struct alignas(64) Slot
+            {
+                T_ value;
+            };
+
+            ReductionBuffer(uint32 num_workers, const T_& identity)
+                : worker_slots(num_workers, Slot{ identity }), external_slot{ identity }
+            {
+            }
+
+            // Workers own their slot. A worker can only re-enter here between chunks (e.g. while it waits inside 'func'),
+            // never in the middle of a combine, so no synchronization is needed.
+            template <typename Combine_>
+            void accumulate(int32 worker_index, const T_& value, const Combine_& combine)
+            {
+                if (worker_index >= 0)
+                {
+                    Slot& slot = worker_slots[worker_index];
+                    slot.value = combine(slot.value, value);
+                }
+                else
+                {
+                    std::lock_guard<std::mutex> lock(external_mutex);
+                    external_slot.value = combine(external_slot.value, value);
+                }
+            }
+
+            template <typename Combine_>
+            T_ combine_all(const Combine_& combine) const
+            {
+                T_ result = external_slot.value;
+                for (const Slot& slot : worker_slots)
+                {
+                    result = combine(result, slot.value);
+                }
+                return result;
+            }
+
+            std::vector<Slot> worker_slots;
+            Slot external_slot;
+            std::mutex external_mutex;
+        };
+    }
+
+    template <typename Func_>
+    void parallel_for(uint32 first, uint32 last, uint32 grain, const Func_& func, JobQueue& queue)
+    {
+        if (last <= first)
+        {
+            return;
+        }
+
+        grain = max(grain, 1u);
+
+        if (last - first <= grain || queue.get_num_threads() == 0)
+        {
+            func(first, last);
+            return;
+        }
+
+        // The root is only there to collect the split-off jobs. It gets submitted after the caller's share is done.
+        JobHandle root = queue.createJob<detail::EmptyJobData>([](detail::EmptyJobData&, JobHandle) {}, {});
+
+        detail::parallel_for_range(queue, func, first, last, grain, root);
+
+        root.submit_now();
+        root.wait_for_completion();
+    }
+
+    template <typename T_, typename Func_, typename Combine_>
+    T_ parallel_reduce(uint32 first, uint32 last, uint32 grain, const T_& identity, const Func_& func, const Combine_& combine, JobQueue& queue)
+    {
+        if (last <= first)
+        {
+            return identity;
+        }
+
+        if (last - first <= max(grain, 1u) || queue.get_num_threads() == 0)
+        {
+            return func(first, last, identity);
+        }
+
+        detail::ReductionBuffer<T_> buffer(queue.get_num_threads(), identity);
+
+        parallel_for(first, last, grain, [&](uint32 begin, uint32 end)
+            {
+                T_ partial = func(begin, end, identity);
+                buffer.accumulate(queue.get_current_worker_index(), partial, combine);
+            }, queue);
+
+        return buffer.combine_all(combine);
+    }
+
+    template <typename Iter_, typename Compare_>
+    void parallel_sort(Iter_ first, Iter_ last, Compare_ comp, uint32 grain, JobQueue& queue)
+    {
+        using value_type = typename std::iterator_traits<Iter_>::value_type;
+
+        const uint32 count = (uint32)std::distance(first, last);
+        grain = max(grain, 2u);
+
+        if (count <= grain || queue.get_num_threads() == 0)
+        {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        // A few blocks per thread, so that uneven blocks still balance out.
+        const uint32 max_num_blocks = (queue.get_num_threads() + 1) * 4;
+        const uint32 num_blocks = min((count + grain - 1) / grain, max_num_blocks);
+        const uint32 block_size = (count + num_blocks - 1) / num_blocks;
+
+        parallel_for(0, num_blocks, 1, [&](uint32 begin, uint32 end)
+            {
+                for (uint32 block = begin; block < end; ++block)
+                {
+                    const uint32 block_begin = block * block_size;
+                    const uint32 block_end = min(block_begin + block_size, count);
+                    std::sort(first + block_begin, first + block_end, comp);
+                }
+            }, queue);
+
+        std::vector<value_type> buffer(count);
+
+        auto merge_round = [&](auto source, auto destination, uint32 width)
+            {
+                const uint32 num_pairs = (count + 2 * width - 1) / (2 * width);
+                parallel_for(0, num_pairs, 1, [&](uint32 begin, uint32 end)
+                    {
+                        for (uint32 pair = begin; pair < end; ++pair)
+                        {
+                            const uint32 low = pair * 2 * width;
+                            const uint32 middle = min(low + width, count);
+                            const uint32 high = min(low + 2 * width, count);
+
+                            std::merge(
+                                std::make_move_iterator(source + low), std::make_move_iterator(source + middle),
+                                std::make_move_iterator(source + middle), std::make_move_iterator(source + high),
+                                destination + low, comp);
+                        }
+                    }, queue);
+            };
+
+        bool result_in_buffer = false;
+        for (uint32 width = block_size; width < count; width *= 2)
+        {
+            if (result_in_buffer)
+            {
+                merge_round(buffer.begin(), first, width);
+            }
+            else
+            {
+                merge_round(first, buffer.begin(), width);
+            }
+            result_in_buffer = !result_in_buffer;
+        }
+
+        if (result_in_buffer)
+        {
+            parallel_for(0, count, grain, [&](uint32 begin, uint32 end)
+                {
+                    std::move(buffer.begin() + begin, buffer.begin() + end, first + begin);
+                }, queue);
+        }
+    }
+}
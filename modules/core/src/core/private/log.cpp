@@ -3,12 +3,18 @@
 #include "core/log.h"
 #include "core/imgui.h"
 #include "core/memory.h"
+#include "core/threading.h"
 
 #include "ecs/update_groups.h"
 
 #include <rttr/policy.h>
 #include <rttr/registration>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <thread>
+
 namespace era_engine
 {
 	bool log_window_open = true;
@@ -20,9 +26,76 @@ namespace era_engine
 
 namespace era_engine
 {
-	struct LogMessage
+	using log_internal::LogRecordHeader;
+	using log_internal::LogArgumentType;
+
+	// Per thread. A burst of ~1500 typical records fits before the overflow policy kicks in.
+	static constexpr uint32 log_ring_capacity = KB(128);
+
+	// Bigger records (hundreds of long strings) are dropped, they would stall the ring.
+	static constexpr uint32 log_max_record_size = log_ring_capacity / 4;
+
+	// How long the log thread sleeps when there is nothing to format. Blocked writers and log_flush() wake it earlier.
+	static constexpr auto log_thread_idle_wait = std::chrono::milliseconds(2);
+
+	// How long shutdown and crash flushes wait for the log thread to finish a pass before giving up.
+	static constexpr auto log_shutdown_flush_timeout = std::chrono::milliseconds(200);
+
+	// Single producer, single consumer: written by its thread, read by whoever holds LogBackend::consumer_mutex.
+	// 'head' and 'tail' are byte offsets that only grow, the ring position is offset % log_ring_capacity.
+	struct LogRing
+	{
+		alignas(64) std::atomic<uint64> head = 0;
+		uint64 cached_tail = 0; // Producer's copy of 'tail', refreshed when the ring looks full.
+
+		alignas(64) std::atomic<uint64> tail = 0;
+
+		alignas(64) std::atomic<uint64> dropped = 0;
+		std::atomic<bool> retired = false; // The thread exited, the ring is freed once it's drained.
+
+		uint32 thread_index = 0;
+		uint8* data = nullptr;
+	};
+
+	struct LogThreadState
+	{
+		~LogThreadState()
+		{
+			if (ring != nullptr)
+			{
+				ring->retired.store(true, std::memory_order_release);
+				ring = nullptr;
+			}
+		}
+
+		LogRing* ring = nullptr;
+	};
+
+	struct LogBackend
+	{
+		std::mutex registry_mutex;
+		std::vector<LogRing*> rings;
+		uint32 next_thread_index = 0;
+
+		// Held while records are formatted. Guards the sinks and everything the consumer side touches.
+		std::timed_mutex consumer_mutex;
+		std::atomic<std::thread::id> consumer_owner;
+		std::vector<ref<LogSink>> sinks;
+		std::vector<LogRing*> drain_rings;
+
+		std::mutex wake_mutex;
+		std::condition_variable wake_condition;
+		std::atomic<bool> wake_requested = false;
+
+		std::atomic<LogOverflowPolicy> overflow_policy = LogOverflowPolicy::DROP;
+		std::atomic<uint64> total_dropped = 0;
+
+		int64 start_timestamp = 0;
+	};
+
+	struct EditorLogMessage
 	{
-		const char* text;
+		std::string text;
 		MessageType type;
 		float lifetime;
 		const char* file;
@@ -37,48 +110,729 @@ namespace era_engine
 		ImVec4(1.f, 0.f, 0.f, 1.f),
 	};
 
-	static Allocator arena;
-	static std::vector<LogMessage> messages;
-	static std::mutex mutex;
+	static const char* prefix_per_type[] =
+	{
+		"",
+		"Warning> ",
+		"Error> ",
+	};
+
+	// Shared by the log thread (EditorLogSink) and LogSystem on the main thread only. Never holds more than
+	// MAX_NB_MESSAGES, worlds without LogSystem (headless, no "render" tag) never trim it otherwise.
+	static std::vector<EditorLogMessage> messages;
+	static std::mutex messages_mutex;
 
 	static inline bool set_scroll_to_bottom = false;
 
-	void log_message_internal(MessageType type, const char* file, const char* function, uint32 line, const char* format, ...)
+	static thread_local LogThreadState log_thread_state;
+
+	static LogBackend& get_log_backend();
+	static void flush_log_for_shutdown();
+
+	class EditorLogSink final : public LogSink
+	{
+	public:
+		void write(const LogRecord& record) override
+		{
+			std::lock_guard lock{ messages_mutex };
+			if (messages.size() >= MAX_NB_MESSAGES)
+			{
+				messages.erase(messages.begin());
+			}
+			messages.push_back({ record.text, record.type, 5.f, record.file, record.function, record.line });
+
+			set_scroll_to_bottom = true;
+		}
+	};
+
+	LogSink::~LogSink()
+	{
+	}
+
+	void LogSink::flush()
+	{
+	}
+
+	FileLogSink::FileLogSink(const char* path)
+	{
+		std::error_code error;
+		fs::create_directories(fs::path(path).parent_path(), error);
+
+		file = fopen(path, "w");
+	}
+
+	FileLogSink::~FileLogSink()
+	{
+		if (file != nullptr)
+		{
+			fclose(file);
+		}
+	}
+
+	void FileLogSink::write(const LogRecord& record)
+	{
+		if (file == nullptr)
+		{
+			return;
+		}
+
+		if (record.file != nullptr)
+		{
+			fprintf(file, "[%10.3f] [%2u] %s%s (%s [%u])\n", record.time, record.thread_index, prefix_per_type[record.type], record.text, record.function, record.line);
+		}
+		else
+		{
+			fprintf(file, "[%10.3f] [%2u] %s%s\n", record.time, record.thread_index, prefix_per_type[record.type], record.text);
+		}
+	}
+
+	void FileLogSink::flush()
+	{
+		if (file != nullptr)
+		{
+			fflush(file);
+		}
+	}
+
+	void ConsoleLogSink::write(const LogRecord& record)
+	{
+		FILE* stream = (record.type == message_type_error) ? stderr : stdout;
+		fprintf(stream, "[%10.3f] %s%s\n", record.time, prefix_per_type[record.type], record.text);
+	}
+
+	void ConsoleLogSink::flush()
+	{
+		fflush(stdout);
+		fflush(stderr);
+	}
+
+	static void wake_log_thread(LogBackend& backend)
+	{
+		if (!backend.wake_requested.exchange(true))
+		{
+			backend.wake_condition.notify_one();
+		}
+	}
+
+	static LogRing* register_log_thread(LogBackend& backend)
+	{
+		LogRing* ring = new LogRing();
+		ring->data = new uint8[log_ring_capacity];
+
+		std::lock_guard lock{ backend.registry_mutex };
+		ring->thread_index = backend.next_thread_index++;
+		backend.rings.push_back(ring);
+
+		return ring;
+	}
+
+	namespace log_internal
+	{
+		uint8* begin_log_record(MessageType type, uint32 size)
+		{
+			LogRing* ring = log_thread_state.ring;
+			if (ring == nullptr)
+			{
+				ring = log_thread_state.ring = register_log_thread(get_log_backend());
+			}
+
+			if (size > log_max_record_size)
+			{
+				ring->dropped.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			uint64 head = ring->head.load(std::memory_order_relaxed);
+			const uint32 offset = (uint32)(head % log_ring_capacity);
+
+			// A record never wraps around, the end of the ring is skipped instead.
+			const uint32 skipped = (offset + size > log_ring_capacity) ? (log_ring_capacity - offset) : 0;
+
+			while (head + skipped + size - ring->cached_tail > log_ring_capacity)
+			{
+				ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+				if (head + skipped + size - ring->cached_tail <= log_ring_capacity)
+				{
+					break;
+				}
+
+				LogBackend& backend = get_log_backend();
+				if (type != message_type_error && backend.overflow_policy.load(std::memory_order_relaxed) == LogOverflowPolicy::DROP)
+				{
+					ring->dropped.fetch_add(1, std::memory_order_relaxed);
+					return nullptr;
+				}
+
+				wake_log_thread(backend);
+				std::this_thread::yield();
+			}
+
+			if (skipped > 0)
+			{
+				const uint32 end_marker = 0;
+				memcpy(ring->data + offset, &end_marker, sizeof(end_marker));
+
+				head += skipped;
+				ring->head.store(head, std::memory_order_release);
+
+				return ring->data;
+			}
+
+			return ring->data + offset;
+		}
+
+		void end_log_record(uint32 size)
+		{
+			LogRing* ring = log_thread_state.ring;
+			ring->head.store(ring->head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+		}
+	}
+
+	struct LogArgument
+	{
+		LogArgumentType type;
+		uint64 bits;
+		const void* string;
+	};
+
+	static bool read_log_argument(const uint8*& cursor, uint32& remaining, LogArgument& argument)
+	{
+		if (remaining == 0)
+		{
+			return false;
+		}
+		--remaining;
+
+		argument.type = (LogArgumentType)*cursor++;
+		argument.bits = 0;
+		argument.string = nullptr;
+
+		if (argument.type == log_internal::log_argument_string || argument.type == log_internal::log_argument_wide_string)
+		{
+			uint32 count;
+			memcpy(&count, cursor, sizeof(count));
+			cursor += sizeof(count);
+
+			argument.string = cursor;
+			cursor += count * (argument.type == log_internal::log_argument_string ? sizeof(char) : sizeof(wchar_t));
+		}
+		else
+		{
+			memcpy(&argument.bits, cursor, sizeof(argument.bits));
+			cursor += sizeof(argument.bits);
+		}
+		return true;
+	}
+
+	static int64 get_int_value(const LogArgument& argument)
+	{
+		if (argument.type == log_internal::log_argument_double)
+		{
+			double value;
+			memcpy(&value, &argument.bits, sizeof(value));
+			return (int64)value;
+		}
+		return (int64)argument.bits;
+	}
+
+	static double get_double_value(const LogArgument& argument)
+	{
+		if (argument.type == log_internal::log_argument_double)
+		{
+			double value;
+			memcpy(&value, &argument.bits, sizeof(value));
+			return value;
+		}
+		return (argument.type == log_internal::log_argument_int) ? (double)(int64)argument.bits : (double)argument.bits;
+	}
+
+	// printf on packed arguments: every conversion is handed to snprintf on its own, with the length modifier replaced
+	// by the one matching the stored type. Arguments that don't fit their conversion print as "(invalid)".
+	static void format_log_record(const LogRecordHeader& header, const uint8* arguments, char* out, uint32 out_size)
+	{
+		char* dst = out;
+		char* const end = out + out_size - 1;
+
+		uint32 remaining = header.num_args;
+		const char* format = header.format;
+
+		auto append = [&](const char* text, size_t length)
+		{
+			length = std::min(length, (size_t)(end - dst));
+			memcpy(dst, text, length);
+			dst += length;
+		};
+
+		auto advance = [&](int written)
+		{
+			if (written > 0)
+			{
+				dst += std::min((size_t)written, (size_t)(end - dst));
+			}
+		};
+
+		while (*format != 0 && dst < end)
+		{
+			if (*format != '%')
+			{
+				*dst++ = *format++;
+				continue;
+			}
+
+			if (format[1] == '%')
+			{
+				*dst++ = '%';
+				format += 2;
+				continue;
+			}
+
+			const char* spec_start = format;
+			const char* p = format + 1;
+
+			char spec[48];
+			uint32 spec_length = 0;
+			spec[spec_length++] = '%';
+
+			while (*p != 0 && strchr("-+ #0", *p) != nullptr && spec_length < 8)
+			{
+				spec[spec_length++] = *p++;
+			}
+
+			// Width and precision, '*' takes them from the arguments.
+			for (uint32 part = 0; part < 2; ++part)
+			{
+				if (part == 1)
+				{
+					if (*p != '.')
+					{
+						break;
+					}
+					spec[spec_length++] = *p++;
+				}
+
+				if (*p == '*')
+				{
+					LogArgument argument;
+					if (read_log_argument(arguments, remaining, argument))
+					{
+						spec_length += snprintf(spec + spec_length, 12, "%d", (int)get_int_value(argument));
+					}
+					++p;
+				}
+				else
+				{
+					while (*p >= '0' && *p <= '9' && spec_length < 32)
+					{
+						spec[spec_length++] = *p++;
+					}
+				}
+			}
+
+			// Length modifiers are dropped, the stored argument type decides ('%ws' and '%ls' print wide strings as well).
+			while (*p != 0 && strchr("hljztLqwI", *p) != nullptr)
+			{
+				if (*p == 'I' && ((p[1] == '3' && p[2] == '2') || (p[1] == '6' && p[2] == '4')))
+				{
+					p += 2;
+				}
+				++p;
+			}
+
+			const char conversion = *p;
+			if (conversion == 0)
+			{
+				append(spec_start, strlen(spec_start));
+				break;
+			}
+			format = p + 1;
+
+			LogArgument argument;
+			if (!read_log_argument(arguments, remaining, argument))
+			{
+				append(spec_start, format - spec_start);
+				continue;
+			}
+
+			const bool is_string = (argument.type == log_internal::log_argument_string || argument.type == log_internal::log_argument_wide_string);
+			const int available = (int)(end - dst) + 1;
+
+			switch (conversion)
+			{
+				case 'd':
+				case 'i':
+				case 'u':
+				case 'o':
+				case 'x':
+				case 'X':
+				{
+					if (is_string)
+					{
+						append("(invalid)", 9);
+						break;
+					}
+					spec[spec_length++] = 'l';
+					spec[spec_length++] = 'l';
+					spec[spec_length++] = conversion;
+					spec[spec_length] = 0;
+					if (conversion == 'd' || conversion == 'i')
+					{
+						advance(snprintf(dst, available, spec, (long long)get_int_value(argument)));
+					}
+					else
+					{
+						advance(snprintf(dst, available, spec, (unsigned long long)get_int_value(argument)));
+					}
+					break;
+				}
+				case 'f':
+				case 'F':
+				case 'e':
+				case 'E':
+				case 'g':
+				case 'G':
+				case 'a':
+				case 'A':
+				{
+					if (is_string)
+					{
+						append("(invalid)", 9);
+						break;
+					}
+					spec[spec_length++] = conversion;
+					spec[spec_length] = 0;
+					advance(snprintf(dst, available, spec, get_double_value(argument)));
+					break;
+				}
+				case 'c':
+				{
+					spec[spec_length++] = 'c';
+					spec[spec_length] = 0;
+					advance(snprintf(dst, available, spec, is_string ? '?' : (int)get_int_value(argument)));
+					break;
+				}
+				case 's':
+				case 'S':
+				{
+					if (argument.type == log_internal::log_argument_string)
+					{
+						spec[spec_length++] = 's';
+						spec[spec_length] = 0;
+						advance(snprintf(dst, available, spec, (const char*)argument.string));
+					}
+					else if (argument.type == log_internal::log_argument_wide_string)
+					{
+						spec[spec_length++] = 'l';
+						spec[spec_length++] = 's';
+						spec[spec_length] = 0;
+						advance(snprintf(dst, available, spec, (const wchar_t*)argument.string));
+					}
+					else if (argument.type == log_internal::log_argument_pointer && argument.bits == 0)
+					{
+						append("(null)", 6);
+					}
+					else
+					{
+						append("(invalid)", 9);
+					}
+					break;
+				}
+				case 'p':
+				{
+					spec[spec_length++] = 'p';
+					spec[spec_length] = 0;
+					advance(snprintf(dst, available, spec, is_string ? argument.string : (const void*)(uintptr_t)argument.bits));
+					break;
+				}
+				case 'n':
+				{
+					break;
+				}
+				default:
+				{
+					append(spec_start, format - spec_start);
+					break;
+				}
+			}
+		}
+
+		*dst = 0;
+	}
+
+	static void write_to_sinks(LogBackend& backend, const LogRecord& record)
 	{
-		std::lock_guard lock{ mutex };
-		arena.ensure_free_size(1024);
+		for (const ref<LogSink>& sink : backend.sinks)
+		{
+			sink->write(record);
+		}
+	}
 
-		char* buffer = (char*)arena.get_current();
+	static double get_log_time(const LogBackend& backend, int64 timestamp)
+	{
+		using period = std::chrono::steady_clock::period;
+		return (double)(timestamp - backend.start_timestamp) * (double)period::num / (double)period::den;
+	}
 
-		va_list args;
-		va_start(args, format);
-		int count_written = vsnprintf(buffer, 1024, format, args);
-		va_end(args);
+	// Finds the oldest unread record of a ring, skipping end markers. Consumer side only.
+	static bool peek_log_record(LogRing& ring, LogRecordHeader& header)
+	{
+		uint64 tail = ring.tail.load(std::memory_order_relaxed);
+		const uint64 head = ring.head.load(std::memory_order_acquire);
 
-		messages.push_back({ buffer, type, 5.f, file, function, line });
+		while (tail != head)
+		{
+			const uint32 offset = (uint32)(tail % log_ring_capacity);
 
-		set_scroll_to_bottom = true;
+			uint32 size;
+			memcpy(&size, ring.data + offset, sizeof(size));
+			if (size != 0)
+			{
+				memcpy(&header, ring.data + offset, sizeof(header));
+				return true;
+			}
 
-		arena.set_current_to(buffer + count_written + 1);
+			tail += log_ring_capacity - offset;
+			ring.tail.store(tail, std::memory_order_release);
+		}
+		return false;
 	}
 
-	void log_message(MessageType type, const char* format, ...)
+	// Formats all committed records, oldest first across threads, and hands them to the sinks.
+	// Needs consumer_mutex. Returns whether anything was written.
+	static bool drain_log_rings(LogBackend& backend)
 	{
-		std::lock_guard lock{ mutex };
-		arena.ensure_free_size(KB(1));
+		{
+			std::lock_guard lock{ backend.registry_mutex };
+			backend.drain_rings = backend.rings;
+		}
 
-		char* buffer = (char*)arena.get_current();
+		char text[KB(1)];
+		bool written = false;
 
-		va_list args;
-		va_start(args, format);
-		int count_written = vsnprintf(buffer, KB(1), format, args);
-		va_end(args);
+		while (true)
+		{
+			LogRing* oldest_ring = nullptr;
+			LogRecordHeader oldest_header;
 
-		messages.push_back({ buffer, type, 5.f, nullptr, nullptr, 0 });
+			for (LogRing* ring : backend.drain_rings)
+			{
+				LogRecordHeader header;
+				if (peek_log_record(*ring, header) && (oldest_ring == nullptr || header.timestamp < oldest_header.timestamp))
+				{
+					oldest_ring = ring;
+					oldest_header = header;
+				}
+			}
+
+			if (oldest_ring == nullptr)
+			{
+				break;
+			}
 
-		set_scroll_to_bottom = true;
+			const uint64 tail = oldest_ring->tail.load(std::memory_order_relaxed);
+			const uint8* record = oldest_ring->data + tail % log_ring_capacity;
+
+			format_log_record(oldest_header, record + sizeof(LogRecordHeader), text, sizeof(text));
+
+			LogRecord log_record = {
+				oldest_header.type,
+				get_log_time(backend, oldest_header.timestamp),
+				oldest_ring->thread_index,
+				text,
+				oldest_header.file,
+				oldest_header.function,
+				oldest_header.line };
+			write_to_sinks(backend, log_record);
+
+			oldest_ring->tail.store(tail + oldest_header.size, std::memory_order_release);
+			written = true;
+		}
+
+		const int64 now = log_internal::get_log_timestamp();
+		for (LogRing* ring : backend.drain_rings)
+		{
+			const uint64 dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+			if (dropped > 0)
+			{
+				backend.total_dropped.fetch_add(dropped, std::memory_order_relaxed);
+
+				snprintf(text, sizeof(text), "Log> %llu messages dropped, the ring buffer of thread %u was full", (unsigned long long)dropped, ring->thread_index);
+				write_to_sinks(backend, { message_type_warning, get_log_time(backend, now), ring->thread_index, text, nullptr, nullptr, 0 });
+				written = true;
+			}
+		}
 
-		arena.set_current_to(buffer + count_written + 1);
+		{
+			std::lock_guard lock{ backend.registry_mutex };
+			for (auto it = backend.rings.begin(); it != backend.rings.end();)
+			{
+				LogRing* ring = *it;
+				if (ring->retired.load(std::memory_order_acquire)
+					&& ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed)
+					&& ring->dropped.load(std::memory_order_relaxed) == 0)
+				{
+					delete[] ring->data;
+					delete ring;
+					it = backend.rings.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		if (written)
+		{
+			for (const ref<LogSink>& sink : backend.sinks)
+			{
+				sink->flush();
+			}
+		}
+
+		return written;
+	}
+
+	static bool drain_log_rings_locked(LogBackend& backend)
+	{
+		backend.consumer_owner = std::this_thread::get_id();
+		const bool written = drain_log_rings(backend);
+		backend.consumer_owner = std::thread::id();
+		return written;
+	}
+
+	static void log_thread_loop(LogBackend& backend)
+	{
+		set_thread_name(get_current_native_thread(), L"Log thread");
+
+		while (true)
+		{
+			bool written;
+			{
+				std::lock_guard lock{ backend.consumer_mutex };
+				written = drain_log_rings_locked(backend);
+			}
+
+			if (!written)
+			{
+				std::unique_lock lock{ backend.wake_mutex };
+				backend.wake_condition.wait_for(lock, log_thread_idle_wait, [&backend]() { return backend.wake_requested.load(); });
+				backend.wake_requested = false;
+			}
+		}
+	}
+
+	static std::terminate_handler previous_terminate_handler = nullptr;
+
+	static void log_terminate_handler()
+	{
+		flush_log_for_shutdown();
+
+		if (previous_terminate_handler != nullptr)
+		{
+			previous_terminate_handler();
+		}
+		std::abort();
+	}
+
+#if defined(_WIN32)
+	static LPTOP_LEVEL_EXCEPTION_FILTER previous_exception_filter = nullptr;
+
+	static LONG WINAPI log_exception_filter(EXCEPTION_POINTERS* exception_info)
+	{
+		flush_log_for_shutdown();
+
+		return (previous_exception_filter != nullptr) ? previous_exception_filter(exception_info) : EXCEPTION_CONTINUE_SEARCH;
+	}
+#endif
+
+	static LogBackend* create_log_backend()
+	{
+		LogBackend* backend = new LogBackend();
+		backend->start_timestamp = log_internal::get_log_timestamp();
+
+		backend->sinks.push_back(make_ref<ConsoleLogSink>());
+		backend->sinks.push_back(make_ref<FileLogSink>("logs/log.txt"));
+		backend->sinks.push_back(make_ref<EditorLogSink>());
+
+		// Detached: the backend is never destroyed, so late messages from static destructors and crash handlers still land.
+		std::thread(log_thread_loop, std::ref(*backend)).detach();
+
+		previous_terminate_handler = std::set_terminate(log_terminate_handler);
+#if defined(_WIN32)
+		previous_exception_filter = SetUnhandledExceptionFilter(log_exception_filter);
+#endif
+		std::atexit(flush_log_for_shutdown);
+		std::at_quick_exit(flush_log_for_shutdown);
+
+		return backend;
+	}
+
+	static LogBackend& get_log_backend()
+	{
+		static LogBackend* backend = create_log_backend();
+		return *backend;
+	}
+
+	// At exit and on crashes the log thread may be gone (or be the crashing thread) while holding the consumer lock,
+	// so this only waits for a bounded time.
+	static void flush_log_for_shutdown()
+	{
+		LogBackend& backend = get_log_backend();
+		if (backend.consumer_owner.load() == std::this_thread::get_id())
+		{
+			return;
+		}
+
+		if (backend.consumer_mutex.try_lock_for(log_shutdown_flush_timeout))
+		{
+			drain_log_rings_locked(backend);
+			backend.consumer_mutex.unlock();
+		}
+	}
+
+	void add_log_sink(const ref<LogSink>& sink)
+	{
+		LogBackend& backend = get_log_backend();
+
+		std::lock_guard lock{ backend.consumer_mutex };
+		backend.sinks.push_back(sink);
+	}
+
+	void clear_log_sinks()
+	{
+		LogBackend& backend = get_log_backend();
+
+		std::lock_guard lock{ backend.consumer_mutex };
+		drain_log_rings_locked(backend);
+		backend.sinks.clear();
+	}
+
+	void set_log_overflow_policy(LogOverflowPolicy policy)
+	{
+		get_log_backend().overflow_policy = policy;
+	}
+
+	uint64 get_num_dropped_log_messages()
+	{
+		LogBackend& backend = get_log_backend();
+
+		uint64 dropped = backend.total_dropped.load(std::memory_order_relaxed);
+
+		std::lock_guard lock{ backend.registry_mutex };
+		for (const LogRing* ring : backend.rings)
+		{
+			dropped += ring->dropped.load(std::memory_order_relaxed);
+		}
+		return dropped;
+	}
+
+	void log_flush()
+	{
+		LogBackend& backend = get_log_backend();
+		ASSERT(backend.consumer_owner.load() != std::this_thread::get_id()); // Sinks must not log.
+
+		std::lock_guard lock{ backend.consumer_mutex };
+		drain_log_rings_locked(backend);
 	}
 
 	RTTR_REGISTRATION
@@ -86,14 +840,13 @@ namespace era_engine
 		using namespace rttr;
 
 		registration::class_<LogSystem>("LogSystem")
-			.constructor<World*>()(policy::ctor::as_raw_ptr)
+			.constructor<World*>()(policy::ctor::as_raw_ptr, metadata("Tag", std::string("render")))
 			.method("update", &System::update)(metadata("update_group", update_types::GAMEPLAY_NORMAL));
 	}
 
 	LogSystem::LogSystem(World* _world)
 		: System(_world)
 	{
-		arena.initialize(0, MB(128));
 	}
 
 	LogSystem::~LogSystem()
@@ -108,6 +861,8 @@ namespace era_engine
 	{
 		dt = min(dt, 1.0f); // If the app hangs, we don't want all the messages to go missing.
 
+		std::lock_guard lock{ messages_mutex };
+
 		ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 10.f);
 		ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.f, 0.1f));
 		ImGui::SetNextWindowSize(ImVec2(0.f, 0.f)); // Auto-resize to content.
@@ -146,11 +901,11 @@ namespace era_engine
 					auto& msg = messages[i];
 					if (msg.file)
 					{
-						ImGui::TextColored(color_per_type[msg.type], "%s (%s [%u])", msg.text, msg.function, msg.line);
+						ImGui::TextColored(color_per_type[msg.type], "%s (%s [%u])", msg.text.c_str(), msg.function, msg.line);
 					}
 					else
 					{
-						ImGui::TextColored(color_per_type[msg.type], "%s", msg.text);
+						ImGui::TextColored(color_per_type[msg.type], "%s", msg.text.c_str());
 					}
 				}
 
@@ -162,12 +917,6 @@ namespace era_engine
 			}
 			ImGui::End();
 		}
-
-		if (messages.size() > MAX_NB_MESSAGES)
-		{
-			messages.clear();
-			arena.reset();
-		}
 	}
 }
 
@@ -79,22 +79,7 @@ namespace era_engine
 		uint8* result = nullptr;
 		{
 			std::lock_guard lock{ mutex };
-			uint64 mask = alignment - 1;
-			uint64 misalignment = current & mask;
-			uint64 adjustment = (misalignment == 0) ? 0 : (alignment - misalignment);
-			current += adjustment;
-
-			size_left_current -= adjustment;
-			size_left_total -= adjustment;
-
-			ASSERT(size_left_total >= size);
-
-			ensure_free_size_internal(size);
-
-			result = memory + current;
-			current += size;
-			size_left_current -= size;
-			size_left_total -= size;
+			result = allocate_internal(size, alignment);
 		}
 
 		if (clearToZero && result)
@@ -105,6 +90,27 @@ namespace era_engine
 		return result;
 	}
 
+	uint8* Allocator::allocate_internal(uint64 size, uint64 alignment)
+	{
+		uint64 mask = alignment - 1;
+		uint64 misalignment = current & mask;
+		uint64 adjustment = (misalignment == 0) ? 0 : (alignment - misalignment);
+
+		// Commit for padding and payload together, the padding alone may already cross the committed range.
+		const uint64 total_size = adjustment + size;
+
+		ASSERT(size_left_total >= total_size);
+
+		ensure_free_size_internal(total_size);
+
+		uint8* result = memory + current + adjustment;
+		current += total_size;
+		size_left_current -= total_size;
+		size_left_total -= total_size;
+
+		return result;
+	}
+
 	void Allocator::reset(bool free_memory)
 	{
 		if (memory && free_memory)
@@ -0,0 +1,163 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "core/threading.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace era_engine
+{
+#if defined(_WIN32)
+
+	static int get_native_thread_priority(ThreadPriority priority)
+	{
+		switch (priority)
+		{
+		case ThreadPriority::Lowest: return THREAD_PRIORITY_LOWEST;
+		case ThreadPriority::BelowNormal: return THREAD_PRIORITY_BELOW_NORMAL;
+		case ThreadPriority::AboveNormal: return THREAD_PRIORITY_ABOVE_NORMAL;
+		case ThreadPriority::Highest: return THREAD_PRIORITY_HIGHEST;
+		default: return THREAD_PRIORITY_NORMAL;
+		}
+	}
+
+	uint32 get_hardware_thread_count()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return max(1u, (uint32)info.dwNumberOfProcessors);
+	}
+
+	NativeThreadHandle get_current_native_thread()
+	{
+		return (NativeThreadHandle)GetCurrentThread();
+	}
+
+	void set_thread_priority(NativeThreadHandle thread, ThreadPriority priority)
+	{
+		SetThreadPriority((HANDLE)thread, get_native_thread_priority(priority));
+	}
+
+	void set_thread_affinity(NativeThreadHandle thread, uint32 core_index)
+	{
+		if (core_index >= 64)
+		{
+			return;
+		}
+		SetThreadAffinityMask((HANDLE)thread, 1ull << core_index);
+	}
+
+	void set_thread_name(NativeThreadHandle thread, const wchar* name)
+	{
+		if (name)
+		{
+			SetThreadDescription((HANDLE)thread, name);
+		}
+	}
+
+	void get_current_thread_name(char* buffer, uint32 buffer_size)
+	{
+		buffer[0] = 0;
+
+		WCHAR* description = nullptr;
+		if (SUCCEEDED(GetThreadDescription(GetCurrentThread(), &description)) && description)
+		{
+			snprintf(buffer, buffer_size, "%ws", description);
+			LocalFree(description);
+		}
+	}
+
+#else
+
+	uint32 get_thread_id_fast()
+	{
+		static thread_local uint32 thread_id = (uint32)syscall(SYS_gettid);
+		return thread_id;
+	}
+
+	uint32 get_hardware_thread_count()
+	{
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		return count > 0 ? (uint32)count : 1u;
+	}
+
+	NativeThreadHandle get_current_native_thread()
+	{
+		return pthread_self();
+	}
+
+	static int get_nice_value(ThreadPriority priority)
+	{
+		switch (priority)
+		{
+		case ThreadPriority::Lowest: return 10;
+		case ThreadPriority::BelowNormal: return 5;
+		case ThreadPriority::AboveNormal: return -5;
+		case ThreadPriority::Highest: return -10;
+		default: return 0;
+		}
+	}
+
+	void set_thread_priority(NativeThreadHandle thread, ThreadPriority priority)
+	{
+		// Everything stays on SCHED_OTHER. A realtime policy would let the busy-waiting main thread starve workers pinned
+		// to the same core, so priorities are nice values instead. Linux only applies those per thread id, which is only
+		// known for the calling thread, so other threads keep their nice value (set it from inside the thread).
+		// Raising above normal requires CAP_SYS_NICE, so failures are ignored.
+		sched_param param = {};
+		pthread_setschedparam(thread, SCHED_OTHER, &param);
+
+		if (pthread_equal(thread, pthread_self()))
+		{
+			setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), get_nice_value(priority));
+		}
+	}
+
+	void set_thread_affinity(NativeThreadHandle thread, uint32 core_index)
+	{
+		if (core_index >= CPU_SETSIZE || core_index >= get_hardware_thread_count())
+		{
+			return;
+		}
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(core_index, &set);
+		pthread_setaffinity_np(thread, sizeof(set), &set);
+	}
+
+	void set_thread_name(NativeThreadHandle thread, const wchar* name)
+	{
+		if (!name)
+		{
+			return;
+		}
+
+		// pthread names are limited to 16 bytes including the terminator.
+		char buffer[16];
+		uint32 length = 0;
+		for (; name[length] && length < sizeof(buffer) - 1; ++length)
+		{
+			buffer[length] = (name[length] < 128) ? (char)name[length] : '?';
+		}
+		buffer[length] = 0;
+
+		pthread_setname_np(thread, buffer);
+	}
+
+	void get_current_thread_name(char* buffer, uint32 buffer_size)
+	{
+		buffer[0] = 0;
+		if (buffer_size >= 16)
+		{
+			pthread_getname_np(pthread_self(), buffer, buffer_size);
+		}
+	}
+
+#endif
+}
@@ -13,6 +13,8 @@ namespace era_engine
 		profile_event_frame_marker,
 		profile_event_begin_block,
 		profile_event_end_block,
+		profile_event_flow_begin,
+		profile_event_flow_end,
 
 		profile_event_count
 	};
@@ -22,7 +24,11 @@ namespace era_engine
 		ProfileEventType type;
 		uint16 cl_type; // For gpu profiler.
 		uint32 thread_id;
-		const char* name;
+		union
+		{
+			const char* name;
+			uint64 flow_id; // For flow events.
+		};
 		uint64 timestamp;
 	};
 }
@@ -1,9 +1,19 @@
 #pragma once
 
+#include "core_api.h"
+
 #include <functional>
+#include <thread>
+
+#if defined(_WIN32)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
 
 namespace era_engine
 {
+#if defined(_WIN32)
 	// All functions return the value before the operation.
 	inline uint32 atomic_add(volatile uint32& a, uint32 b) { return InterlockedAdd((volatile LONG*)&a, b) - b; }
 	inline uint64 atomic_add(volatile uint64& a, uint64 b) { return InterlockedAdd64((volatile LONG64*)&a, b) - b; }
@@ -23,4 +33,49 @@ namespace era_engine
 		uint32 thread_id = *(uint32*)(thread_local_storage + 0x48);
 		return thread_id;
 	}
-}
\ No newline at end of file
+#else
+	// All functions return the value before the operation.
+	inline uint32 atomic_add(volatile uint32& a, uint32 b) { return __atomic_fetch_add(&a, b, __ATOMIC_SEQ_CST); }
+	inline uint64 atomic_add(volatile uint64& a, uint64 b) { return __atomic_fetch_add(&a, b, __ATOMIC_SEQ_CST); }
+	inline uint32 atomic_increment(volatile uint32& a) { return __atomic_fetch_add(&a, 1u, __ATOMIC_SEQ_CST); }
+	inline uint64 atomic_increment(volatile uint64& a) { return __atomic_fetch_add(&a, 1ull, __ATOMIC_SEQ_CST); }
+	inline uint32 atomic_decrement(volatile uint32& a) { return __atomic_fetch_sub(&a, 1u, __ATOMIC_SEQ_CST); }
+	inline uint64 atomic_decrement(volatile uint64& a) { return __atomic_fetch_sub(&a, 1ull, __ATOMIC_SEQ_CST); }
+	inline uint32 atomic_compare_exchange(volatile uint32& destination, uint32 exchange, uint32 compare) { __atomic_compare_exchange_n(&destination, &compare, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); return compare; }
+	inline uint64 atomic_compare_exchange(volatile uint64& destination, uint64 exchange, uint64 compare) { __atomic_compare_exchange_n(&destination, &compare, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); return compare; }
+	inline uint32 atomic_exchange(volatile uint32& destination, uint32 exchange) { return __atomic_exchange_n(&destination, exchange, __ATOMIC_SEQ_CST); }
+	inline uint64 atomic_exchange(volatile uint64& destination, uint64 exchange) { return __atomic_exchange_n(&destination, exchange, __ATOMIC_SEQ_CST); }
+
+	ERA_CORE_API uint32 get_thread_id_fast();
+#endif
+
+	// Spin-wait hint. Tells the core that we are busy-waiting, which saves power and frees resources for the sibling hyper-thread.
+	inline void cpu_pause()
+	{
+		_mm_pause();
+	}
+
+	enum class ThreadPriority : uint8
+	{
+		Lowest,
+		BelowNormal,
+		Normal,
+		AboveNormal,
+		Highest,
+	};
+
+	using NativeThreadHandle = std::thread::native_handle_type;
+
+	// Portable thread setup. On Windows these map to SetThreadPriority/SetThreadAffinityMask/SetThreadDescription,
+	// on POSIX to pthread scheduling, pthread_setaffinity_np and pthread_setname_np. All of them are best-effort:
+	// a platform that doesn't support an operation (or a process without the required rights) silently keeps the defaults.
+	ERA_CORE_API uint32 get_hardware_thread_count();
+	ERA_CORE_API NativeThreadHandle get_current_native_thread();
+
+	ERA_CORE_API void set_thread_priority(NativeThreadHandle thread, ThreadPriority priority);
+	ERA_CORE_API void set_thread_affinity(NativeThreadHandle thread, uint32 core_index);
+	ERA_CORE_API void set_thread_name(NativeThreadHandle thread, const wchar* name);
+
+	// Writes the calling thread's name to 'buffer', an empty string if it has none.
+	ERA_CORE_API void get_current_thread_name(char* buffer, uint32 buffer_size);
+}
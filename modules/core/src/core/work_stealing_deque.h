@@ -0,0 +1,93 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+
+namespace era_engine
+{
+    // Bounded Chase-Lev deque (see "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013).
+    // The owning thread pushes and pops at the bottom (LIFO), any other thread steals from the top (FIFO).
+    // push() fails instead of growing when the deque is full, the caller is expected to fall back to a shared queue.
+    template <typename T_, uint32 capacity_ = 4096>
+    class WorkStealingDeque
+    {
+        static_assert((capacity_ & (capacity_ - 1)) == 0, "Capacity must be a power of two.");
+        static_assert(std::is_trivially_copyable_v<T_>);
+
+    public:
+        static constexpr uint32 capacity = capacity_;
+
+        // Owner thread only.
+        bool push(T_ value)
+        {
+            const int64 b = bottom.load(std::memory_order_relaxed);
+            const int64 t = top.load(std::memory_order_acquire);
+            if (b - t >= (int64)capacity)
+            {
+                return false;
+            }
+
+            buffer[b & index_mask].store(value, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Owner thread only.
+        bool pop(T_& out)
+        {
+            const int64 b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64 t = top.load(std::memory_order_relaxed);
+
+            if (t > b)
+            {
+                // Empty.
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            out = buffer[b & index_mask].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // Last element -> race against thieves.
+                const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+            return true;
+        }
+
+        // Any thread.
+        bool steal(T_& out)
+        {
+            int64 t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64 b = bottom.load(std::memory_order_acquire);
+
+            if (t >= b)
+            {
+                return false;
+            }
+
+            out = buffer[t & index_mask].load(std::memory_order_relaxed);
+            return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        // Approximate, only used as a hint for sleeping decisions.
+        bool empty() const
+        {
+            return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr int64 index_mask = capacity - 1;
+
+        alignas(64) std::atomic<int64> top = 0;
+        alignas(64) std::atomic<int64> bottom = 0;
+        alignas(64) std::atomic<T_> buffer[capacity];
+    };
+}
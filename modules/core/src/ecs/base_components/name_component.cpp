@@ -9,11 +9,11 @@ namespace era_engine
 	{
 		using namespace rttr;
 		rttr::registration::class_<NameComponent>("NameComponent")
-			.constructor<ref<Entity::EcsData>, const char*>()
+			.constructor<Entity::EcsData*, const char*>()
 			.property("name", &NameComponent::name);
 	}
 
-	NameComponent::NameComponent(ref<Entity::EcsData> _data, const char* n) : Component(_data)
+	NameComponent::NameComponent(Entity::EcsData* _data, const char* n) : Component(_data)
 	{
 		strncpy(name, n, sizeof(name));
 		name[sizeof(name) - 1] = 0;
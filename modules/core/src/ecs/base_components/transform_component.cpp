@@ -16,26 +16,26 @@ namespace era_engine
 			);
 
 		registration::class_<TransformComponent>("TransformComponent")
-			.constructor<ref<Entity::EcsData>, const trs&>()
-			.constructor<ref<Entity::EcsData>, const trs&, TransformComponent::TransformType>()
-			.constructor<ref<Entity::EcsData>, const vec3&, const quat&, const vec3&, TransformComponent::TransformType>()
+			.constructor<Entity::EcsData*, const trs&>()
+			.constructor<Entity::EcsData*, const trs&, TransformComponent::TransformType>()
+			.constructor<Entity::EcsData*, const vec3&, const quat&, const vec3&, TransformComponent::TransformType>()
 			.property("transform", &TransformComponent::get_world_transform, &TransformComponent::set_world_transform)
 			.property("local_transform", &TransformComponent::get_local_transform, &TransformComponent::set_local_transform)
 			.property("type", &TransformComponent::type);
 	}
 
-	TransformComponent::TransformComponent(ref<Entity::EcsData> _data, const trs& t)
-		: Component(_data), transform(t)
+	TransformComponent::TransformComponent(Entity::EcsData* _data, const trs& t)
+		: Component(_data), local_transform(t), transform(t)
 	{
 	}
 
-	TransformComponent::TransformComponent(ref<Entity::EcsData> _data, const trs& t, TransformType _type)
-		: Component(_data), transform(t), type(_type)
+	TransformComponent::TransformComponent(Entity::EcsData* _data, const trs& t, TransformType _type)
+		: Component(_data), type(_type), local_transform(t), transform(t)
 	{
 	}
 
-	TransformComponent::TransformComponent(ref<Entity::EcsData> _data, const vec3& position, const quat& rotation, const vec3& scale, TransformType _type)
-		: Component(_data), transform(position, rotation, scale), type(_type)
+	TransformComponent::TransformComponent(Entity::EcsData* _data, const vec3& position, const quat& rotation, const vec3& scale, TransformType _type)
+		: Component(_data), type(_type), local_transform(position, rotation, scale), transform(position, rotation, scale)
 	{
 	}
 
@@ -51,6 +51,8 @@ namespace era_engine
 	void TransformComponent::set_local_transform(const trs& new_local_transform)
 	{
 		local_transform = new_local_transform;
+
+		mark_world_transform_dirty();
 	}
 
 	const trs& TransformComponent::get_world_transform() const
@@ -76,6 +78,8 @@ namespace era_engine
 
 	void TransformComponent::set_world_position(const vec3& new_world_position)
 	{
+		on_world_transform_requested();
+
 		transform.position = new_world_position;
 
 		on_world_transform_changed();
@@ -90,57 +94,94 @@ namespace era_engine
 
 	void TransformComponent::set_world_rotation(const quat& new_world_rotation)
 	{
+		on_world_transform_requested();
+
 		transform.rotation = new_world_rotation;
 
 		on_world_transform_changed();
 	}
 
-	void TransformComponent::on_world_transform_changed()
+	uint32 TransformComponent::get_world_transform_version() const
 	{
-		const Entity::Handle parent_handle = get_entity().get_parent_handle();
+		return world_transform_version;
+	}
 
-		if (parent_handle != Entity::NullHandle)
-		{
-			TransformComponent* parent_transform = get_world()->get_entity(parent_handle).get_component<TransformComponent>();
-			local_transform = invert(parent_transform->get_world_transform()) * transform;
-		}
-		else
-		{
-			local_transform = transform;
-		}
+	bool TransformComponent::is_world_transform_dirty() const
+	{
+		return world_transform_dirty;
 	}
 
-	void TransformComponent::on_world_transform_requested() const
+	void TransformComponent::mark_world_transform_dirty()
 	{
-		std::vector<const TransformComponent*> transforms_to_consider;
-		transforms_to_consider.emplace_back(this);
+		if (world_transform_dirty)
+		{
+			// Descendants are already dirty as well.
+			return;
+		}
 
-		World* world = get_world();
+		world_transform_dirty = true;
+		mark_childs_dirty();
+	}
 
-		Entity root_entity = world->get_root_entity();
+	void TransformComponent::mark_childs_dirty()
+	{
+		entt::registry& registry = *component_data->native_registry;
 
-		Entity::Handle ancestor = get_entity().get_parent_handle();
-		while (ancestor != Entity::NullHandle && ancestor != root_entity.get_handle())
+		EntityContainer::for_each_child(component_data->world, component_data->entity_handle, [&registry](Entity::Handle child)
 		{
-			Entity ancestor_entity = world->get_entity(ancestor);
-			TransformComponent* ancestor_transform_component = ancestor_entity.get_component<TransformComponent>();
-			if (ancestor_transform_component != nullptr)
+			if (TransformComponent* child_transform = registry.try_get<TransformComponent>(child))
 			{
-				transforms_to_consider.emplace_back(ancestor_transform_component);
+				child_transform->mark_world_transform_dirty();
 			}
+		});
+	}
 
-			ancestor = ancestor_entity.get_parent_handle();
+	const TransformComponent* TransformComponent::get_parent_transform() const
+	{
+		const Entity::Handle parent_handle = component_data->parent_handle;
+		if (parent_handle == Entity::NullHandle || parent_handle == get_world()->get_root_handle())
+		{
+			return nullptr;
 		}
 
-		trs transform_accumulator = trs::identity;
+		return component_data->native_registry->try_get<TransformComponent>(parent_handle);
+	}
 
-		for (auto iter = transforms_to_consider.rbegin(); iter != transforms_to_consider.rend(); ++iter)
+	void TransformComponent::on_world_transform_changed()
+	{
+		if (const TransformComponent* parent_transform = get_parent_transform())
 		{
-			const TransformComponent* current_transform_component = *iter;
+			local_transform = invert(parent_transform->get_world_transform()) * transform;
+		}
+		else
+		{
+			local_transform = transform;
+		}
+
+		world_transform_dirty = false;
+		++world_transform_version;
 
-			transform_accumulator = transform_accumulator * current_transform_component->local_transform;
+		mark_childs_dirty();
+	}
 
-			current_transform_component->transform = transform_accumulator;
+	void TransformComponent::on_world_transform_requested() const
+	{
+		if (!world_transform_dirty)
+		{
+			return;
 		}
+
+		// Parents are resolved first. A clean parent stops the recursion, so this is O(number of dirty ancestors).
+		if (const TransformComponent* parent_transform = get_parent_transform())
+		{
+			transform = parent_transform->get_world_transform() * local_transform;
+		}
+		else
+		{
+			transform = local_transform;
+		}
+
+		world_transform_dirty = false;
+		++world_transform_version;
 	}
 }
\ No newline at end of file
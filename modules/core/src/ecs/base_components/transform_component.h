@@ -20,9 +20,9 @@ namespace era_engine
 
 	public:
 		TransformComponent() = default;
-		TransformComponent(ref<Entity::EcsData> _data, const trs& t = trs::identity);
-		TransformComponent(ref<Entity::EcsData> _data, const trs& t, TransformType _type);
-		TransformComponent(ref<Entity::EcsData> _data, const vec3& position, const quat& rotation, const vec3& scale = vec3(1.f, 1.f, 1.f), TransformType _type = DYNAMIC);
+		TransformComponent(Entity::EcsData* _data, const trs& t = trs::identity);
+		TransformComponent(Entity::EcsData* _data, const trs& t, TransformType _type);
+		TransformComponent(Entity::EcsData* _data, const vec3& position, const quat& rotation, const vec3& scale = vec3(1.f, 1.f, 1.f), TransformType _type = DYNAMIC);
 
 		~TransformComponent() override;
 
@@ -38,19 +38,36 @@ namespace era_engine
 		const quat& get_world_rotation() const;
 		void set_world_rotation(const quat& new_world_rotation);
 
+		// Incremented every time the cached world transform changes. Can be used to skip work on unchanged transforms.
+		uint32 get_world_transform_version() const;
+		bool is_world_transform_dirty() const;
+
+		// Marks this transform and all of its descendants as outdated. Called on local changes and re-parenting.
+		void mark_world_transform_dirty();
+
 		ERA_VIRTUAL_REFLECT(Component)
 
 	private:
 		void on_world_transform_requested() const;
 		void on_world_transform_changed();
 
+		void mark_childs_dirty();
+
+		const TransformComponent* get_parent_transform() const;
+
 	public:
 		TransformType type = DYNAMIC;
 
 	private:
 		trs local_transform = trs::identity; // In Parent space.
 		mutable trs transform = trs::identity; // In World space.
+
+		// Invariant: if a transform is dirty, so are all of its descendants.
+		mutable bool world_transform_dirty = true;
+		mutable uint32 world_transform_version = 0;
+
 		friend class EntityContainer;
+		friend class TransformHierarchy;
 	};
 
 }
\ No newline at end of file
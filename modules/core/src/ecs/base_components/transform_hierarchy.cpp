@@ -0,0 +1,135 @@
+#include "ecs/base_components/transform_hierarchy.h"
+#include "ecs/base_components/transform_component.h"
+#include "ecs/world.h"
+
+#include "core/cpu_profiling.h"
+
+namespace era_engine
+{
+
+	void TransformHierarchy::update(World* world)
+	{
+		TransformHierarchy& hierarchy = world->create_or_get_context_variable<TransformHierarchy>();
+		hierarchy.update_world_transforms(world);
+	}
+
+	void TransformHierarchy::update_world_transforms(World* world)
+	{
+		ZoneScopedN("TransformHierarchy::update_world_transforms");
+
+		entt::registry& registry = world->get_registry();
+		auto& storage = registry.storage<TransformComponent>();
+
+		if (cached_hierarchy_version != world->get_hierarchy_version() || cached_transform_count != storage.size())
+		{
+			rebuild(world);
+		}
+
+		const uint32 count = (uint32)ordered_handles.size();
+		for (uint32 i = 0; i < count; ++i)
+		{
+			TransformComponent& transform = storage.get(ordered_handles[i]);
+
+			if (transform.world_transform_dirty)
+			{
+				// Parents come first in the order, so their world transform is already final.
+				const int32 parent_index = parent_indices[i];
+				transform.transform = (parent_index >= 0) ? world_transforms[parent_index] * transform.local_transform : transform.local_transform;
+				transform.world_transform_dirty = false;
+				++transform.world_transform_version;
+			}
+
+			world_transforms[i] = transform.transform;
+		}
+	}
+
+	uint32 TransformHierarchy::size() const
+	{
+		return (uint32)ordered_handles.size();
+	}
+
+	void TransformHierarchy::rebuild(World* world)
+	{
+		ZoneScopedN("TransformHierarchy::rebuild");
+
+		entt::registry& registry = world->get_registry();
+		auto& storage = registry.storage<TransformComponent>();
+
+		cached_hierarchy_version = world->get_hierarchy_version();
+		cached_transform_count = storage.size();
+
+		std::vector<Entity::Handle> handles;
+		handles.reserve(storage.size());
+
+		std::unordered_map<Entity::Handle, int32> handle_to_index;
+		handle_to_index.reserve(storage.size());
+
+		for (auto [handle, transform] : registry.view<TransformComponent>().each())
+		{
+			handle_to_index.emplace(handle, (int32)handles.size());
+			handles.push_back(handle);
+		}
+
+		const int32 count = (int32)handles.size();
+
+		std::vector<int32> parents(count, -1);
+		for (int32 i = 0; i < count; ++i)
+		{
+			const TransformComponent& transform = storage.get(handles[i]);
+			if (const TransformComponent* parent_transform = transform.get_parent_transform())
+			{
+				parents[i] = handle_to_index.at(parent_transform->get_handle());
+			}
+		}
+
+		std::vector<int32> depths(count, -1);
+		int32 max_depth = 0;
+		for (int32 i = 0; i < count; ++i)
+		{
+			// Walk up to the first ancestor with a known depth, then assign depths on the way back down.
+			int32 current = i;
+			int32 steps = 0;
+			while (current != -1 && depths[current] == -1)
+			{
+				current = parents[current];
+				++steps;
+			}
+
+			int32 depth = (current == -1) ? steps - 1 : depths[current] + steps;
+			max_depth = max(max_depth, depth);
+
+			for (int32 node = i; node != current; node = parents[node])
+			{
+				depths[node] = depth--;
+			}
+		}
+
+		// Counting sort by depth gives a stable parent-before-child order.
+		std::vector<int32> offsets(max_depth + 2, 0);
+		for (int32 i = 0; i < count; ++i)
+		{
+			++offsets[depths[i] + 1];
+		}
+		for (int32 depth = 1; depth < (int32)offsets.size(); ++depth)
+		{
+			offsets[depth] += offsets[depth - 1];
+		}
+
+		std::vector<int32> new_index(count);
+		ordered_handles.resize(count);
+		for (int32 i = 0; i < count; ++i)
+		{
+			const int32 index = offsets[depths[i]]++;
+			new_index[i] = index;
+			ordered_handles[index] = handles[i];
+		}
+
+		parent_indices.resize(count);
+		for (int32 i = 0; i < count; ++i)
+		{
+			parent_indices[new_index[i]] = (parents[i] != -1) ? new_index[parents[i]] : -1;
+		}
+
+		world_transforms.resize(count);
+	}
+}
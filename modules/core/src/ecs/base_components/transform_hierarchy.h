@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core_api.h"
+
+#include "core/math.h"
+
+#include "ecs/entity.h"
+
+namespace era_engine
+{
+	class World;
+
+	// Batched world transform update. Keeps the transforms of a world in parent-before-child order,
+	// so a single linear pass refreshes every dirty world transform and later reads are just cache hits.
+	// The order is rebuilt lazily when the hierarchy or the set of transforms changes.
+	class ERA_CORE_API TransformHierarchy final
+	{
+	public:
+		static void update(World* world);
+
+		void update_world_transforms(World* world);
+
+		uint32 size() const;
+
+	private:
+		void rebuild(World* world);
+
+		std::vector<Entity::Handle> ordered_handles;
+		std::vector<int32> parent_indices; // Index into 'ordered_handles', -1 for top-level transforms.
+		std::vector<trs> world_transforms;
+
+		uint64 cached_hierarchy_version = UINT64_MAX;
+		size_t cached_transform_count = 0;
+	};
+}
@@ -11,10 +11,10 @@ namespace era_engine
 		using namespace rttr;
 		registration::class_<Component>("Component")
 			.constructor<>()
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	Component::Component(ref<Entity::EcsData> _data) noexcept
+	Component::Component(Entity::EcsData* _data) noexcept
 		: component_data(_data)
 	{
 	}
@@ -26,7 +26,7 @@ namespace era_engine
 
 	Component::Component(Component&& _component) noexcept
 	{
-		component_data = std::move(_component.component_data);
+		component_data = std::exchange(_component.component_data, nullptr);
 	}
 
 	Component::~Component()
@@ -46,7 +46,7 @@ namespace era_engine
 	{
 		if (this != &_component)
 		{
-			component_data = std::move(_component.component_data);
+			component_data = std::exchange(_component.component_data, nullptr);
 		}
 		return *this;
 	}
@@ -67,7 +67,7 @@ namespace era_engine
 	}
 
 	ComponentDataPtr::ComponentDataPtr(const Component* _component)
-		: component_weak_data(_component->component_data)
+		: component_entity(_component->get_entity())
 	{
 	}
 
@@ -13,7 +13,7 @@ namespace era_engine
 	{
 	public:
 		Component() = default;
-		Component(ref<Entity::EcsData> _data) noexcept;
+		Component(Entity::EcsData* _data) noexcept;
 		Component(const Component& _component) noexcept;
 		Component(Component&& _component) noexcept;
 		virtual ~Component();
@@ -30,7 +30,7 @@ namespace era_engine
 		ERA_REFLECT
 
 	protected:
-		ref<Entity::EcsData> component_data = nullptr;
+		Entity::EcsData* component_data = nullptr;
 
 		friend class ComponentDataPtr;
 	};
@@ -42,7 +42,7 @@ namespace era_engine
 		ComponentDataPtr(const Component* _component);
 
 	private:
-		weakref<Entity::EcsData> component_weak_data;
+		EntityPtr component_entity;
 	};
 
 	class ERA_CORE_API ComponentPtr
@@ -18,22 +18,23 @@ namespace era_engine
 
 		registration::class_<Entity>("Entity")
 			.constructor<>()
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
 	Entity::Entity(const Entity& _entity) noexcept
-		: internal_data(_entity.internal_data)
+		: internal_data(_entity.internal_data), handle(_entity.handle)
 	{
 	}
 
 	Entity::Entity(Entity&& _entity) noexcept
 	{
-		internal_data = std::move(_entity.internal_data);
+		internal_data = std::exchange(_entity.internal_data, nullptr);
+		handle = std::exchange(_entity.handle, Entity::NullHandle);
 	}
 
 
-	Entity::Entity(ref<EcsData> _data)
-		: internal_data(_data)
+	Entity::Entity(EcsData* _data)
+		: internal_data(_data), handle(_data != nullptr ? _data->entity_handle : Entity::NullHandle)
 	{
 	}
 
@@ -44,18 +45,20 @@ namespace era_engine
 	Entity& Entity::operator=(const Entity& _entity)  noexcept
 	{
 		internal_data = _entity.internal_data;
+		handle = _entity.handle;
 		return *this;
 	}
 
 	Entity& Entity::operator=(Entity&& _entity) noexcept
 	{
-		internal_data = std::move(_entity.internal_data);
+		internal_data = std::exchange(_entity.internal_data, nullptr);
+		handle = std::exchange(_entity.handle, Entity::NullHandle);
 		return *this;
 	}
 
 	bool Entity::operator==(const Entity& _other) const
 	{
-		return internal_data == _other.internal_data;
+		return internal_data == _other.internal_data && handle == _other.handle;
 	}
 
 	bool Entity::operator!=(const Entity& _other) const
@@ -71,20 +74,23 @@ namespace era_engine
 	bool Entity::is_valid() const noexcept
 	{
 		return internal_data != nullptr &&
-			   internal_data->entity_handle != Entity::NullHandle &&
+			   handle != Entity::NullHandle &&
+			   internal_data->entity_handle == handle &&
 			   internal_data->world != nullptr;
 	}
 
-	weakref<Entity::EcsData> Entity::get_data_weakref() const
-	{
-		return weakref<EcsData>(internal_data);
-	}
-
 	void Entity::set_parent(Entity::Handle parent_handle)
 	{
 		EntityContainer::erase_pair(get_world(), internal_data->parent_handle, internal_data->entity_handle);
 		EntityContainer::emplace_pair(get_world(), parent_handle, internal_data->entity_handle);
 		internal_data->parent_handle = parent_handle;
+
+		++get_world()->hierarchy_version;
+
+		if (TransformComponent* transform = get_component_if_exists<TransformComponent>())
+		{
+			transform->mark_world_transform_dirty();
+		}
 	}
 
 	World* Entity::get_world() const
@@ -94,7 +100,7 @@ namespace era_engine
 
 	Entity::Handle Entity::get_handle() const
 	{
-		return internal_data->entity_handle;
+		return handle;
 	}
 
 	Entity::Handle Entity::get_parent_handle() const
@@ -108,104 +114,74 @@ namespace era_engine
 	{
 		std::lock_guard _lock(container_sync);
 
-		if (container.find(parent) == container.end())
-		{
-			container.emplace(std::make_pair(parent, EntityNode()));
-		}
-
-		container.at(parent).childs.push_back(child);
+		world->world_data->entity_datas.link_child(parent, child);
 	}
 
 	void EntityContainer::erase(World* world, Entity::Handle parent)
 	{
-		std::lock_guard _lock(container_sync);
-
-		if (container.find(parent) == container.end())
+		// set_parent() locks the container itself, so only the child list is gathered under the lock.
+		std::vector<Entity::Handle> childs;
 		{
-			return;
+			std::lock_guard _lock(container_sync);
+			childs = get_childs(world, parent);
 		}
 
-		auto& childs = container.at(parent).childs;
-		auto iter = childs.begin();
-		const auto& end = childs.end();
-
-		for (; iter != end; ++iter)
+		const Entity::Handle root_handle = world->get_root_entity().get_handle();
+		for (const Entity::Handle child : childs)
 		{
-			Entity child = world->get_entity(*iter);
-			child.set_parent(world->get_root_entity().get_handle());
+			world->get_entity(child).set_parent(root_handle);
 		}
-
-		container.erase(parent);
 	}
 
 	void EntityContainer::erase_pair(World* world, Entity::Handle parent, Entity::Handle child)
 	{
 		std::lock_guard _lock(container_sync);
 
-		if (container.find(parent) == container.end())
-		{
-			return;
-		}
-
-		auto& childs = container.at(parent).childs;
-		auto iter = childs.begin();
-		const auto& end = childs.end();
-
-		for (; iter != end; ++iter)
-		{
-			if (*iter == child)
-			{
-				childs.erase(iter);
-				break;
-			}
-		}
+		world->world_data->entity_datas.unlink_child(parent, child);
 	}
 
 	std::vector<Entity::Handle> EntityContainer::get_childs(World* world, Entity::Handle parent)
 	{
-		if (container.find(parent) == container.end())
+		std::vector<Entity::Handle> result;
+		result.reserve(world->world_data->entity_datas.get_num_childs(parent));
+
+		for_each_child(world, parent, [&result](Entity::Handle child)
 		{
-			return std::vector<Entity::Handle>();
-		}
+			result.push_back(child);
+		});
 
-		return container.at(parent).childs;
+		return result;
 	}
 
 	std::vector<Entity> EntityContainer::get_entity_childs(World* world, Entity::Handle parent)
 	{
-		if (container.find(parent) == container.end())
-		{
-			return std::vector<Entity>();
-		}
-
 		std::vector<Entity> result;
-		result.reserve(container.at(parent).childs.size());
+		result.reserve(world->world_data->entity_datas.get_num_childs(parent));
 
-		for (const Entity::Handle handle : container.at(parent).childs)
+		for_each_child(world, parent, [world, &result](Entity::Handle child)
 		{
-			result.emplace_back(world->get_entity(handle));
-		}
+			result.emplace_back(world->get_entity(child));
+		});
 
 		return result;
 	}
 
-	EntityPtr::EntityPtr(Entity entity)
-		: data(entity.get_data_weakref())
-	{
-
-	}
-	EntityPtr::EntityPtr(const weakref<Entity::EcsData>& entity_data)
-		: data(entity_data)
+	EntityPtr::EntityPtr(const Entity& entity)
 	{
+		if (entity.is_valid())
+		{
+			world = entity.get_world();
+			handle = entity.get_handle();
+		}
 	}
 
 	Entity EntityPtr::get() const
 	{
-		if (std::shared_ptr<Entity::EcsData> internal_data = data.lock())
+		if (world == nullptr)
 		{
-			return Entity(internal_data);
+			return Entity::Null;
 		}
-		return Entity::Null;
+		return world->get_entity(handle);
 	}
 
 	bool EntityPtr::operator==(const EntityPtr& _other) const
@@ -218,14 +194,14 @@ namespace era_engine
 		return !(*this == _other);
 	}
 
-	const weakref<Entity::EcsData>& EntityPtr::get_data() const
+	Entity::Handle EntityPtr::get_handle() const
 	{
-		return data;
+		return handle;
 	}
 
 	bool EntityPtr::is_empty() const
 	{
-		return data.lock() == nullptr;
+		return !get().is_valid();
 	}
 
 }
\ No newline at end of file
@@ -46,7 +46,7 @@ namespace era_engine
 		Entity() = default;
 		Entity(const Entity& _entity) noexcept;
 		Entity(Entity&& _entity) noexcept;
-		Entity(ref<EcsData> _data);
+		Entity(EcsData* _data);
 		~Entity() noexcept;
 
 		Entity& operator=(const Entity& _entity)  noexcept;
@@ -115,45 +115,43 @@ namespace era_engine
 			return internal_data->native_registry->try_get<Component_>(internal_data->entity_handle);
 		}
 
-		weakref<Entity::EcsData> get_data_weakref() const;
-
 		void set_parent(Entity::Handle parent_handle);
 
 	private:
-		ref<EcsData> internal_data = nullptr;
+		// Non-owning, points into the world's EntityDataPool. Use EntityPtr to keep a reference across frames.
+		EcsData* internal_data = nullptr;
+
+		// Handle at the time this Entity was created. The pool slot is reused for a new entity with the same index, so
+		// is_valid() compares it against the slot's current handle.
+		Entity::Handle handle = Entity::NullHandle;
 
 		friend class World;
 		friend struct eeditor;
 	};
 
+	// Weak, generation-checked entity reference. get() returns Entity::Null once the entity is destroyed,
+	// even if its handle index has been recycled for a new entity.
 	class ERA_CORE_API EntityPtr
 	{
 	public:
 		EntityPtr() = default;
-		EntityPtr(Entity entity);
-		EntityPtr(const weakref<Entity::EcsData>& entity_data);
+		EntityPtr(const Entity& entity);
 
 		bool operator==(const EntityPtr& _other) const;
 		bool operator!=(const EntityPtr& _other) const;
 
 		Entity get() const;
 
-		const weakref<Entity::EcsData>& get_data() const;
+		Entity::Handle get_handle() const;
 
 		bool is_empty() const;
 
 	private:
-		weakref<Entity::EcsData> data;
-	};
-
-	struct ERA_CORE_API EntityNode
-	{
-		EntityNode() = default;
-		~EntityNode() = default;
-
-		std::vector<Entity::Handle> childs;
+		World* world = nullptr;
+		Entity::Handle handle = Entity::NullHandle;
 	};
 
+	// Parent -> child links. The links themselves live next to the entity data in the world's EntityDataPool.
 	class ERA_CORE_API EntityContainer final
 	{
 		EntityContainer() = delete;
@@ -169,9 +167,8 @@ namespace era_engine
 
 		static std::vector<Entity> get_entity_childs(World* world, Entity::Handle parent);
 
-	private:
-		static inline std::unordered_map<Entity::Handle, EntityNode> container;
-
-		friend class World;
+		// Same as get_childs(), but without copying the child list. Defined in world.h.
+		template <typename Func_>
+		static void for_each_child(World* world, Entity::Handle parent, const Func_& func);
 	};
 }
\ No newline at end of file
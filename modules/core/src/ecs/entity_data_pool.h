@@ -0,0 +1,234 @@
+#pragma once
+
+#include "core_api.h"
+
+#include "ecs/entity.h"
+
+#include <atomic>
+
+namespace era_engine
+{
+	// Per-entity data of a world, indexed by the entity part of the entt handle.
+	// Slots live in fixed-size chunks that are never moved or freed while the world lives, so an EcsData* stays valid
+	// for as long as its entity does. The full handle (including the entt version) is stored in the slot and doubles
+	// as the generation check: a handle of a destroyed or recycled entity simply isn't found anymore.
+	// Each slot also holds intrusive child/sibling links, so hierarchy edits are O(1) instead of searching child arrays.
+	class EntityDataPool final
+	{
+	public:
+		static constexpr uint32 chunk_shift = 12;
+		static constexpr uint32 chunk_size = 1u << chunk_shift;
+		static constexpr uint32 chunk_mask = chunk_size - 1;
+		static constexpr uint32 max_num_entities = (uint32)entt::entt_traits<Entity::Handle>::entity_mask + 1;
+		static constexpr uint32 max_num_chunks = (max_num_entities + chunk_size - 1) / chunk_size;
+
+		EntityDataPool() = default;
+		EntityDataPool(const EntityDataPool&) = delete;
+		EntityDataPool& operator=(const EntityDataPool&) = delete;
+
+		~EntityDataPool()
+		{
+			for (std::atomic<Slot*>& chunk : chunks)
+			{
+				delete[] chunk.load(std::memory_order_relaxed);
+			}
+		}
+
+		// Writers are expected to be serialized by the owner. find() may run concurrently with emplace().
+		Entity::EcsData* emplace(Entity::Handle handle, Entity::Handle parent, World* world, entt::registry* registry)
+		{
+			const uint32 index = (uint32)entt::to_entity(handle);
+			ASSERT(index < max_num_entities);
+
+			Slot* chunk = chunks[index >> chunk_shift].load(std::memory_order_acquire);
+			if (chunk == nullptr)
+			{
+				chunk = new Slot[chunk_size];
+				chunks[index >> chunk_shift].store(chunk, std::memory_order_release);
+			}
+
+			Slot& slot = chunk[index & chunk_mask];
+			if (slot.data.entity_handle == Entity::NullHandle)
+			{
+				++num_alive;
+			}
+
+			slot = Slot{};
+			slot.data.entity_handle = handle;
+			slot.data.parent_handle = parent;
+			slot.data.world = world;
+			slot.data.native_registry = registry;
+			return &slot.data;
+		}
+
+		void erase(Entity::Handle handle)
+		{
+			Slot* slot = find_slot(handle);
+			if (slot == nullptr)
+			{
+				return;
+			}
+
+			unlink_child(slot->linked_parent, handle);
+
+			// Children outlive their parent here (World::destroy_entity destroys or re-parents them first if asked to).
+			for (Entity::Handle child = slot->first_child; child != Entity::NullHandle;)
+			{
+				Slot* child_slot = find_slot(child);
+				child = child_slot->next_sibling;
+				child_slot->linked_parent = Entity::NullHandle;
+				child_slot->prev_sibling = Entity::NullHandle;
+				child_slot->next_sibling = Entity::NullHandle;
+			}
+
+			*slot = Slot{};
+			--num_alive;
+		}
+
+		Entity::EcsData* find(Entity::Handle handle) const
+		{
+			Slot* slot = find_slot(handle);
+			return (slot != nullptr) ? &slot->data : nullptr;
+		}
+
+		bool contains(Entity::Handle handle) const
+		{
+			return find_slot(handle) != nullptr;
+		}
+
+		size_t size() const
+		{
+			return num_alive;
+		}
+
+		// Appends 'child' to the child list of 'parent'. Moves it out of its previous list first.
+		void link_child(Entity::Handle parent, Entity::Handle child)
+		{
+			Slot* parent_slot = find_slot(parent);
+			Slot* child_slot = find_slot(child);
+			if (parent_slot == nullptr || child_slot == nullptr)
+			{
+				return;
+			}
+
+			unlink_child(child_slot->linked_parent, child);
+
+			child_slot->linked_parent = parent;
+			child_slot->prev_sibling = parent_slot->last_child;
+			child_slot->next_sibling = Entity::NullHandle;
+
+			if (parent_slot->last_child != Entity::NullHandle)
+			{
+				find_slot(parent_slot->last_child)->next_sibling = child;
+			}
+			else
+			{
+				parent_slot->first_child = child;
+			}
+			parent_slot->last_child = child;
+			++parent_slot->num_childs;
+		}
+
+		void unlink_child(Entity::Handle parent, Entity::Handle child)
+		{
+			Slot* parent_slot = find_slot(parent);
+			Slot* child_slot = find_slot(child);
+			if (parent_slot == nullptr || child_slot == nullptr || child_slot->linked_parent != parent)
+			{
+				return;
+			}
+
+			if (child_slot->prev_sibling != Entity::NullHandle)
+			{
+				find_slot(child_slot->prev_sibling)->next_sibling = child_slot->next_sibling;
+			}
+			else
+			{
+				parent_slot->first_child = child_slot->next_sibling;
+			}
+
+			if (child_slot->next_sibling != Entity::NullHandle)
+			{
+				find_slot(child_slot->next_sibling)->prev_sibling = child_slot->prev_sibling;
+			}
+			else
+			{
+				parent_slot->last_child = child_slot->prev_sibling;
+			}
+
+			child_slot->linked_parent = Entity::NullHandle;
+			child_slot->prev_sibling = Entity::NullHandle;
+			child_slot->next_sibling = Entity::NullHandle;
+			--parent_slot->num_childs;
+		}
+
+		uint32 get_num_childs(Entity::Handle parent) const
+		{
+			Slot* parent_slot = find_slot(parent);
+			return (parent_slot != nullptr) ? parent_slot->num_childs : 0;
+		}
+
+		template <typename Func_>
+		void for_each_child(Entity::Handle parent, const Func_& func) const
+		{
+			Slot* parent_slot = find_slot(parent);
+			if (parent_slot == nullptr)
+			{
+				return;
+			}
+
+			for (Entity::Handle child = parent_slot->first_child; child != Entity::NullHandle;)
+			{
+				// Read the link first, so that 'func' may unlink the current child.
+				const Entity::Handle next = find_slot(child)->next_sibling;
+				func(child);
+				child = next;
+			}
+		}
+
+		// Resets all slots, but keeps the chunks for reuse.
+		void clear()
+		{
+			for (std::atomic<Slot*>& chunk : chunks)
+			{
+				if (Slot* slots = chunk.load(std::memory_order_relaxed))
+				{
+					std::fill(slots, slots + chunk_size, Slot{});
+				}
+			}
+			num_alive = 0;
+		}
+
+	private:
+		struct Slot
+		{
+			Entity::EcsData data;
+
+			Entity::Handle linked_parent = Entity::NullHandle;
+			Entity::Handle first_child = Entity::NullHandle;
+			Entity::Handle last_child = Entity::NullHandle;
+			Entity::Handle prev_sibling = Entity::NullHandle;
+			Entity::Handle next_sibling = Entity::NullHandle;
+			uint32 num_childs = 0;
+		};
+
+		Slot* find_slot(Entity::Handle handle) const
+		{
+			const uint32 index = (uint32)entt::to_entity(handle);
+			if (index >= max_num_entities)
+			{
+				return nullptr;
+			}
+
+			Slot* chunk = chunks[index >> chunk_shift].load(std::memory_order_acquire);
+			if (chunk == nullptr || chunk[index & chunk_mask].data.entity_handle != handle)
+			{
+				return nullptr;
+			}
+			return &chunk[index & chunk_mask];
+		}
+
+		std::atomic<Slot*> chunks[max_num_chunks] = {};
+		size_t num_alive = 0;
+	};
+}
@@ -18,7 +18,7 @@ namespace era_engine
 
 	public:
 		template <typename Context_, typename... Args_>
-		inline Context_& create_or_get_context_variable(entt::registry& registry, Args_&&... a)
+		static Context_& create_or_get_context_variable(entt::registry& registry, Args_&&... a)
 		{
 			auto& c = registry.ctx();
 			Context_* context = c.find<Context_>();
@@ -31,28 +31,28 @@ namespace era_engine
 		}
 
 		template <typename Context_>
-		inline Context_& get_context_variable(entt::registry& registry)
+		static Context_& get_context_variable(entt::registry& registry)
 		{
 			auto& c = registry.ctx();
 			return *c.find<Context_>();
 		}
 
 		template <typename Context_>
-		inline Context_* try_get_context_variable(entt::registry& registry)
+		static Context_* try_get_context_variable(entt::registry& registry)
 		{
 			auto& c = registry.ctx();
 			return c.find<Context_>();
 		}
 
 		template <typename Context_>
-		inline bool does_context_variable_exist(entt::registry& registry)
+		static bool does_context_variable_exist(entt::registry& registry)
 		{
 			auto& c = registry.ctx();
 			return c.contains<Context_>();
 		}
 
 		template <typename Context_>
-		inline void delete_context_variable(entt::registry& registry)
+		static void delete_context_variable(entt::registry& registry)
 		{
 			auto& c = registry.ctx();
 			c.erase<Context_>();
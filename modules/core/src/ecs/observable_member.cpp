@@ -11,10 +11,10 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<ObservableMemberChangedFlagComponent>("ObservableMemberChangedFlagComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	ObservableMemberChangedFlagComponent::ObservableMemberChangedFlagComponent(ref<Entity::EcsData> _data)
+	ObservableMemberChangedFlagComponent::ObservableMemberChangedFlagComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
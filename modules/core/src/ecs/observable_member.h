@@ -146,7 +146,7 @@ namespace era_engine
 	class ERA_CORE_API ObservableMemberChangedFlagComponent final : public Component
 	{
 	public:
-		ObservableMemberChangedFlagComponent(ref<Entity::EcsData> _data);
+		ObservableMemberChangedFlagComponent(Entity::EcsData* _data);
 
 		ERA_VIRTUAL_REFLECT(Component)
 	};
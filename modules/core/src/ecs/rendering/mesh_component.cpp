@@ -9,12 +9,12 @@ namespace era_engine
 	{
 		using namespace rttr;
 		rttr::registration::class_<MeshComponent>("MeshComponent")
-			.constructor<ref<Entity::EcsData>, ref<multi_mesh>, bool>()
+			.constructor<Entity::EcsData*, ref<multi_mesh>, bool>()
 			.property("mesh", &MeshComponent::mesh)
 			.property("is_hidden", &MeshComponent::is_hidden);
 	}
 
-	MeshComponent::MeshComponent(ref<Entity::EcsData> _data, ref<multi_mesh> _mesh, bool _is_hidden)
+	MeshComponent::MeshComponent(Entity::EcsData* _data, ref<multi_mesh> _mesh, bool _is_hidden)
 		: Component(_data), mesh(_mesh), is_hidden(_is_hidden)
 	{
 	}
@@ -10,7 +10,7 @@ namespace era_engine
 	class ERA_CORE_API MeshComponent : public Component
 	{
 	public:
-		MeshComponent(ref<Entity::EcsData> _data, ref<multi_mesh> _mesh, bool _is_hidden = false);
+		MeshComponent(Entity::EcsData* _data, ref<multi_mesh> _mesh, bool _is_hidden = false);
 		virtual ~MeshComponent();
 
 		ERA_VIRTUAL_REFLECT(Component)
@@ -3,12 +3,14 @@
 #include "ecs/base_components/base_components.h"
 
 #include "core/cpu_profiling.h"
+#include "core/job_system.h"
 #include "core/string.h"
 
 #include "rendering/pbr.h"
 #include "rendering/depth_prepass.h"
 #include "rendering/outline.h"
 #include "rendering/shadow_map.h"
+#include "rendering/visibility.h"
 
 #include "asset/pbr_material_desc.h"
 
@@ -25,29 +27,11 @@
 namespace era_engine
 {
 
-	static bool shouldRender(bounding_sphere s, bounding_box aabb, const trs& transform)
-	{
-		s.center = conjugate(transform.rotation) * (s.center - transform.position) + transform.position;
-		aabb.minCorner *= transform.scale;
-		aabb.maxCorner *= transform.scale;
-		return aabb.contains(s.center) || sphereVsAABB(s, aabb);
-	}
-
 	static bool shouldRender(const camera_frustum_planes& frustum, const MeshComponent& mesh, const TransformComponent& transform)
 	{
 		return mesh.mesh && !mesh.is_hidden && (mesh.mesh->loadState.load() == AssetLoadState::LOADED) && ((mesh.mesh->aabb.maxCorner.x == mesh.mesh->aabb.minCorner.x) || !frustum.cullModelSpaceAABB(mesh.mesh->aabb, transform.get_world_transform()));
 	}
 
-	static bool shouldRender(const bounding_sphere& frustum, const MeshComponent& mesh, const TransformComponent& transform)
-	{
-		return mesh.mesh && !mesh.is_hidden && (mesh.mesh->loadState.load() == AssetLoadState::LOADED) && ((mesh.mesh->aabb.maxCorner.x == mesh.mesh->aabb.minCorner.x) || shouldRender(frustum, mesh.mesh->aabb, transform.get_world_transform()));
-	}
-
-	static bool shouldRender(const light_frustum& frustum, const MeshComponent& mesh, const TransformComponent& transform)
-	{
-		return (frustum.type == light_frustum_standard) ? shouldRender(frustum.frustum, mesh, transform) : shouldRender(frustum.sphere, mesh, transform);
-	}
-
 	template <typename group_t>
 	std::unordered_map<multi_mesh*, offset_count> getOffsetsPerMesh(group_t group)
 	{
@@ -174,218 +158,174 @@ namespace era_engine
 		}
 	}
 
-	template <typename group_t>
-	static void renderStaticObjectsToMainCamera(group_t group, std::unordered_map<multi_mesh*, offset_count> ocPerMesh,
-		const camera_frustum_planes& frustum, Allocator& arena, Entity::Handle selectedObjectID,
-		opaque_render_pass* opaqueRenderPass, transparent_render_pass* transparentRenderPass, ldr_render_pass* ldrRenderPass)
+	struct visibility_object
 	{
-		uint32 groupSize = (uint32)group.size();
-
-		dx_allocation transformAllocation = dxContext.allocateDynamicBuffer(groupSize * sizeof(mat4), 4);
-		mat4* transforms = (mat4*)transformAllocation.cpuPtr;
-
-		dx_allocation objectIDAllocation = dxContext.allocateDynamicBuffer(groupSize * sizeof(uint32), 4);
-		uint32* objectIDs = (uint32*)objectIDAllocation.cpuPtr;
-
-		for (auto [entityHandle, transform, mesh] : group.each())
-		{
-			if (!shouldRender(frustum, mesh, transform))
-				continue;
-
-			if (transform.type == TransformComponent::DYNAMIC)
-				continue;
+		Entity::Handle entityHandle;
+		multi_mesh* mesh;
+		uint32 transformVersion;
+		bool renderable;
+	};
+
+	// Objects keep their place in the visibility hierarchy across frames and only moved, shown or hidden objects are refit.
+	// The objects are sorted by mesh, so the visible objects of a mesh are consecutive in every view's index list and their
+	// instances can be written without per-mesh buckets. Static and dynamic objects have a hierarchy each, so that the
+	// objects moving every frame don't loosen the static one. Lives in the registry context of its world.
+	struct visibility_cache
+	{
+		// Group order of last frame, to notice added and removed entities.
+		std::vector<Entity::Handle> groupEntities;
 
-			const dx_mesh& dxMesh = mesh.mesh->mesh;
+		std::vector<visibility_object> objects;
+		std::vector<bounding_box> aabbs;
+		std::vector<uint32> changedObjects;
 
-			offset_count& oc = ocPerMesh.at(mesh.mesh.get());
+		VisibilityBVH bvh;
+		VisibilityResult visibility;
+	};
 
-			uint32 index = oc.offset + oc.count;
-			const trs& world_transform = transform.get_world_transform();
+	struct static_visibility_cache : visibility_cache {};
+	struct dynamic_visibility_cache : visibility_cache {};
 
-			transforms[index] = trs_to_mat4(world_transform);
-			objectIDs[index] = (uint32)entityHandle;
+	static bool isStaticRenderable(const MeshComponent& mesh, const TransformComponent& transform)
+	{
+		return mesh.mesh && !mesh.is_hidden && (mesh.mesh->loadState.load() == AssetLoadState::LOADED) && (transform.type != TransformComponent::DYNAMIC);
+	}
 
-			++oc.count;
+	static bool isDynamicRenderable(const MeshComponent& mesh, const TransformComponent& transform)
+	{
+		return mesh.mesh && !mesh.is_hidden && (mesh.mesh->loadState.load() == AssetLoadState::LOADED) && (transform.type == TransformComponent::DYNAMIC);
+	}
 
-			if (entityHandle == selectedObjectID)
-			{
-				for (auto& sm : mesh.mesh->submeshes)
-				{
-					renderOutline(ldrRenderPass, transforms[index], dxMesh.vertexBuffer, dxMesh.indexBuffer, sm.info);
-				}
-			}
+	static bounding_box getWorldSpaceAABB(const MeshComponent& mesh, const TransformComponent& transform, bool renderable)
+	{
+		if (!renderable)
+		{
+			return bounding_box::negativeInfinity();
 		}
 
-		D3D12_GPU_VIRTUAL_ADDRESS transformsAddress = transformAllocation.gpuPtr;
-		D3D12_GPU_VIRTUAL_ADDRESS objectIDAddress = objectIDAllocation.gpuPtr;
-
-		uint32 numDrawCalls = 0;
-
-		for (auto& [mesh, oc] : ocPerMesh)
+		// Meshes without bounds are never culled.
+		const bounding_box& aabb = mesh.mesh->aabb;
+		if (aabb.maxCorner.x == aabb.minCorner.x)
 		{
-			if (oc.count == 0)
-				continue;
-
-			D3D12_GPU_VIRTUAL_ADDRESS baseM = transformsAddress + (oc.offset * sizeof(mat4));
-			D3D12_GPU_VIRTUAL_ADDRESS baseObjectID = objectIDAddress + (oc.offset * sizeof(uint32));
-
-			const dx_mesh& dxMesh = mesh->mesh;
-
-			if (!dxMesh.indexBuffer || !dxMesh.vertexBuffer.positions)
-				continue;
-
-			pbr_render_data data;
-			data.transformPtr = baseM;
-			data.vertexBuffer = dxMesh.vertexBuffer;
-			data.indexBuffer = dxMesh.indexBuffer;
-			data.numInstances = oc.count;
-
-			depth_prepass_data depthPrepassData;
-			depthPrepassData.transformPtr = baseM;
-			depthPrepassData.prevFrameTransformPtr = baseM;
-			depthPrepassData.objectIDPtr = baseObjectID;
-			depthPrepassData.vertexBuffer = dxMesh.vertexBuffer;
-			depthPrepassData.prevFrameVertexBuffer = dxMesh.vertexBuffer.positions;
-			depthPrepassData.indexBuffer = dxMesh.indexBuffer;
-			depthPrepassData.numInstances = oc.count;
-
-			for (auto& sm : mesh->submeshes)
-			{
-				data.submesh = sm.info;
-				data.material = sm.material;
-
-				depthPrepassData.submesh = data.submesh;
-				depthPrepassData.alphaCutoutTextureSRV = (sm.material && sm.material->albedo) ? sm.material->albedo->defaultSRV : dx_cpu_descriptor_handle{};
-
-				addToRenderPass(sm.material->shader, data, depthPrepassData, opaqueRenderPass, transparentRenderPass);
-
-				++numDrawCalls;
-			}
+			return bounding_box::everything();
 		}
 
-		CPU_PROFILE_STAT("Static draw calls", numDrawCalls);
+		const trs& worldTransform = transform.get_world_transform();
+		bounding_box scaled = { aabb.minCorner * worldTransform.scale, aabb.maxCorner * worldTransform.scale };
+		return scaled.transformToAABB(worldTransform.rotation, worldTransform.position);
 	}
 
-	template <typename group_t>
-	static void renderStaticObjectsToShadowMap(group_t group, std::unordered_map<multi_mesh*, offset_count> ocPerMesh,
-		const light_frustum& frustum, Allocator& arena, shadow_render_pass_base* shadowRenderPass)
+	template <typename group_t, typename renderable_func_t>
+	static void updateVisibility(group_t group, visibility_cache& cache, const renderable_func_t& isRenderable)
 	{
-		uint32 groupSize = (uint32)group.size();
+		CPU_PROFILE_BLOCK("Update visibility");
 
-		dx_allocation transformAllocation = dxContext.allocateDynamicBuffer(groupSize * sizeof(mat4), 4);
-		mat4* transforms = (mat4*)transformAllocation.cpuPtr;
+		const uint32 groupSize = (uint32)group.size();
 
-		for (auto [entityHandle, transform, mesh] : group.each())
+		// Added or removed entities and meshes swapped on existing ones change the order of the objects. Start over then.
+		bool rebuild = (groupSize != (uint32)cache.groupEntities.size()) || !std::equal(group.begin(), group.end(), cache.groupEntities.begin());
+		for (uint32 i = 0; i < groupSize && !rebuild; ++i)
 		{
-			if (!shouldRender(frustum, mesh, transform))
-				continue;
-
-			if (transform.type == TransformComponent::DYNAMIC)
-				continue;
-
-			const dx_mesh& dxMesh = mesh.mesh->mesh;
-
-			offset_count& oc = ocPerMesh.at(mesh.mesh.get());
+			rebuild = (group.get<MeshComponent>(cache.objects[i].entityHandle).mesh.get() != cache.objects[i].mesh);
+		}
 
-			uint32 index = oc.offset + oc.count;
-			const trs& world_transform = transform.get_world_transform();
+		if (rebuild)
+		{
+			cache.groupEntities.assign(group.begin(), group.end());
 
-			transforms[index] = trs_to_mat4(world_transform);
+			cache.objects.resize(groupSize);
+			for (uint32 i = 0; i < groupSize; ++i)
+			{
+				cache.objects[i].entityHandle = cache.groupEntities[i];
+				cache.objects[i].mesh = group.get<MeshComponent>(cache.groupEntities[i]).mesh.get();
+			}
 
-			++oc.count;
+			std::sort(cache.objects.begin(), cache.objects.end(), [](const visibility_object& a, const visibility_object& b)
+				{
+					return (a.mesh != b.mesh) ? (a.mesh < b.mesh) : (a.entityHandle < b.entityHandle);
+				});
 		}
 
-		D3D12_GPU_VIRTUAL_ADDRESS transformsAddress = transformAllocation.gpuPtr;
+		cache.aabbs.resize(groupSize);
+		cache.changedObjects.clear();
 
-		for (auto& [mesh, oc] : ocPerMesh)
+		for (uint32 i = 0; i < groupSize; ++i)
 		{
-			if (oc.count == 0)
-				continue;
-
-			D3D12_GPU_VIRTUAL_ADDRESS baseM = transformsAddress + (oc.offset * sizeof(mat4));
-
-			const dx_mesh& dxMesh = mesh->mesh;
+			visibility_object& object = cache.objects[i];
+			auto [transform, mesh] = group.get<TransformComponent, MeshComponent>(object.entityHandle);
 
-			if (!dxMesh.indexBuffer || !dxMesh.vertexBuffer.positions)
-				continue;
+			// World transforms are resolved lazily. Do it here, the passes read them from several threads afterwards.
+			transform.get_world_transform();
 
-			shadow_render_data data;
-			data.transformPtr = baseM;
-			data.vertexBuffer = dxMesh.vertexBuffer.positions;
-			data.indexBuffer = dxMesh.indexBuffer;
-			data.numInstances = oc.count;
+			const bool renderable = isRenderable(mesh, transform);
+			const uint32 transformVersion = transform.get_world_transform_version();
 
-			for (auto& sm : mesh->submeshes)
+			if (rebuild || renderable != object.renderable || (renderable && transformVersion != object.transformVersion))
 			{
-				data.submesh = sm.info;
-				addToStaticRenderPass(sm.material->shader, data, shadowRenderPass, frustum.type == light_frustum_sphere);
+				object.renderable = renderable;
+				object.transformVersion = transformVersion;
+				cache.aabbs[i] = getWorldSpaceAABB(mesh, transform, renderable);
+				cache.changedObjects.push_back(i);
 			}
 		}
+
+		if (rebuild)
+		{
+			cache.bvh.build(cache.aabbs.data(), groupSize);
+		}
+		else
+		{
+			cache.bvh.update(cache.aabbs.data(), cache.changedObjects.data(), (uint32)cache.changedObjects.size());
+		}
 	}
 
-	static void renderStaticObjects(World* world, const camera_frustum_planes& frustum, Allocator& arena, Entity::Handle selectedObjectID,
-		opaque_render_pass* opaqueRenderPass, transparent_render_pass* transparentRenderPass, ldr_render_pass* ldrRenderPass, shadow_passes& shadow)
+	// Calls func(mesh, offset, count) for every run of visible objects with the same mesh.
+	template <typename func_t>
+	static void forEachVisibleMesh(const visibility_cache& cache, const uint32* visibleIndices, uint32 numVisible, const func_t& func)
 	{
-		CPU_PROFILE_BLOCK("Static objects");
-
-		using specialized_components = ComponentsGroup<
-			animation::AnimationComponent,
-			TreeComponent
-		>;
-
-		auto group = world->group(
-			components_group<TransformComponent, MeshComponent>,
-			specialized_components{});
-
-		std::unordered_map<multi_mesh*, offset_count> ocPerMesh = getOffsetsPerMesh(group);
+		uint32 offset = 0;
+		while (offset < numVisible)
+		{
+			multi_mesh* mesh = cache.objects[visibleIndices[offset]].mesh;
 
-		renderStaticObjectsToMainCamera(group, ocPerMesh, frustum, arena, selectedObjectID, opaqueRenderPass, transparentRenderPass, ldrRenderPass);
+			uint32 end = offset + 1;
+			while (end < numVisible && cache.objects[visibleIndices[end]].mesh == mesh)
+			{
+				++end;
+			}
 
-		for (uint32 i = 0; i < shadow.numShadowRenderPasses; ++i)
-		{
-			auto& pass = shadow.shadowRenderPasses[i];
-			renderStaticObjectsToShadowMap(group, ocPerMesh, pass.frustum, arena, pass.pass);
+			func(mesh, offset, end - offset);
+			offset = end;
 		}
 	}
 
+	// Dynamic objects also write their previous frame transforms (after the current ones) for the motion vectors of the depth prepass.
 	template <typename group_t>
-	static void renderDynamicObjectsToMainCamera(group_t group, std::unordered_map<multi_mesh*, offset_count> ocPerMesh,
-		const camera_frustum_planes& frustum, Allocator& arena, Entity::Handle selectedObjectID,
+	static void renderVisibleObjectsToMainCamera(group_t group, const visibility_cache& cache, const uint32* visibleIndices, uint32 numVisible, bool dynamic,
+		dx_allocation transformAllocation, dx_allocation objectIDAllocation, Entity::Handle selectedObjectID,
 		opaque_render_pass* opaqueRenderPass, transparent_render_pass* transparentRenderPass, ldr_render_pass* ldrRenderPass)
 	{
-		uint32 groupSize = (uint32)group.size();
-
-		dx_allocation transformAllocation = dxContext.allocateDynamicBuffer(groupSize * sizeof(mat4) * 2, 4);
 		mat4* transforms = (mat4*)transformAllocation.cpuPtr;
-		mat4* prevFrameTransforms = transforms + groupSize;
-
-		dx_allocation objectIDAllocation = dxContext.allocateDynamicBuffer(groupSize * sizeof(uint32), 4);
+		mat4* prevFrameTransforms = transforms + numVisible;
 		uint32* objectIDs = (uint32*)objectIDAllocation.cpuPtr;
 
-		for (auto [entityHandle, transform, mesh] : group.each())
+		for (uint32 index = 0; index < numVisible; ++index)
 		{
-			if (!shouldRender(frustum, mesh, transform))
-				continue;
-
-			if (transform.type != TransformComponent::DYNAMIC)
-				continue;
-
-			const dx_mesh& dxMesh = mesh.mesh->mesh;
-
-			offset_count& oc = ocPerMesh.at(mesh.mesh.get());
+			const visibility_object& object = cache.objects[visibleIndices[index]];
+			const TransformComponent& transform = group.get<TransformComponent>(object.entityHandle);
 
-			uint32 index = oc.offset + oc.count;
-			const trs& world_transform = transform.get_world_transform();
-
-			transforms[index] = trs_to_mat4(world_transform);
-			prevFrameTransforms[index] = trs_to_mat4(world_transform);
-			objectIDs[index] = (uint32)entityHandle;
+			transforms[index] = trs_to_mat4(transform.get_world_transform());
+			objectIDs[index] = (uint32)object.entityHandle;
 
-			++oc.count;
+			if (dynamic)
+			{
+				prevFrameTransforms[index] = transforms[index];
+			}
 
-			if (entityHandle == selectedObjectID)
+			if (object.entityHandle == selectedObjectID)
 			{
-				for (auto& sm : mesh.mesh->submeshes)
+				const dx_mesh& dxMesh = object.mesh->mesh;
+				for (auto& sm : object.mesh->submeshes)
 				{
 					renderOutline(ldrRenderPass, transforms[index], dxMesh.vertexBuffer, dxMesh.indexBuffer, sm.info);
 				}
@@ -393,113 +333,174 @@ namespace era_engine
 		}
 
 		D3D12_GPU_VIRTUAL_ADDRESS transformsAddress = transformAllocation.gpuPtr;
-		D3D12_GPU_VIRTUAL_ADDRESS prevFrameTransformsAddress = transformAllocation.gpuPtr + (groupSize * sizeof(mat4));
+		D3D12_GPU_VIRTUAL_ADDRESS prevFrameTransformsAddress = dynamic ? (transformAllocation.gpuPtr + (numVisible * sizeof(mat4))) : transformAllocation.gpuPtr;
 		D3D12_GPU_VIRTUAL_ADDRESS objectIDAddress = objectIDAllocation.gpuPtr;
 
 		uint32 numDrawCalls = 0;
 
-		for (auto& [mesh, oc] : ocPerMesh)
-		{
-			if (oc.count == 0)
-				continue;
+		forEachVisibleMesh(cache, visibleIndices, numVisible, [&](multi_mesh* mesh, uint32 offset, uint32 count)
+			{
+				D3D12_GPU_VIRTUAL_ADDRESS baseM = transformsAddress + (offset * sizeof(mat4));
+				D3D12_GPU_VIRTUAL_ADDRESS prevBaseM = prevFrameTransformsAddress + (offset * sizeof(mat4));
+				D3D12_GPU_VIRTUAL_ADDRESS baseObjectID = objectIDAddress + (offset * sizeof(uint32));
+
+				const dx_mesh& dxMesh = mesh->mesh;
+
+				if (!dxMesh.indexBuffer || !dxMesh.vertexBuffer.positions)
+					return;
+
+				pbr_render_data data;
+				data.transformPtr = baseM;
+				data.vertexBuffer = dxMesh.vertexBuffer;
+				data.indexBuffer = dxMesh.indexBuffer;
+				data.numInstances = count;
+
+				depth_prepass_data depthPrepassData;
+				depthPrepassData.transformPtr = baseM;
+				depthPrepassData.prevFrameTransformPtr = prevBaseM;
+				depthPrepassData.objectIDPtr = baseObjectID;
+				depthPrepassData.vertexBuffer = dxMesh.vertexBuffer;
+				depthPrepassData.prevFrameVertexBuffer = dxMesh.vertexBuffer.positions;
+				depthPrepassData.indexBuffer = dxMesh.indexBuffer;
+				depthPrepassData.numInstances = count;
+
+				for (auto& sm : mesh->submeshes)
+				{
+					data.submesh = sm.info;
+					data.material = sm.material;
 
-			D3D12_GPU_VIRTUAL_ADDRESS baseM = transformsAddress + (oc.offset * sizeof(mat4));
-			D3D12_GPU_VIRTUAL_ADDRESS prevBaseM = prevFrameTransformsAddress + (oc.offset * sizeof(mat4));
-			D3D12_GPU_VIRTUAL_ADDRESS baseObjectID = objectIDAddress + (oc.offset * sizeof(uint32));
+					depthPrepassData.submesh = data.submesh;
+					depthPrepassData.alphaCutoutTextureSRV = (sm.material && sm.material->albedo) ? sm.material->albedo->defaultSRV : dx_cpu_descriptor_handle{};
 
-			const dx_mesh& dxMesh = mesh->mesh;
+					addToRenderPass(sm.material->shader, data, depthPrepassData, opaqueRenderPass, transparentRenderPass);
 
-			if (!dxMesh.indexBuffer || !dxMesh.vertexBuffer.positions)
-				continue;
+					++numDrawCalls;
+				}
+			});
 
-			pbr_render_data data;
-			data.transformPtr = baseM;
-			data.vertexBuffer = dxMesh.vertexBuffer;
-			data.indexBuffer = dxMesh.indexBuffer;
-			data.numInstances = oc.count;
+		CPU_PROFILE_STAT(dynamic ? "Dynamic draw calls" : "Static draw calls", numDrawCalls);
+	}
 
-			depth_prepass_data depthPrepassData;
-			depthPrepassData.transformPtr = baseM;
-			depthPrepassData.prevFrameTransformPtr = prevBaseM;
-			depthPrepassData.objectIDPtr = baseObjectID;
-			depthPrepassData.vertexBuffer = dxMesh.vertexBuffer;
-			depthPrepassData.prevFrameVertexBuffer = dxMesh.vertexBuffer.positions;
-			depthPrepassData.indexBuffer = dxMesh.indexBuffer;
-			depthPrepassData.numInstances = oc.count;
+	template <typename group_t>
+	static void renderVisibleObjectsToShadowMap(group_t group, const visibility_cache& cache, const uint32* visibleIndices, uint32 numVisible, bool dynamic,
+		const light_frustum& frustum, dx_allocation transformAllocation, shadow_render_pass_base* shadowRenderPass)
+	{
+		mat4* transforms = (mat4*)transformAllocation.cpuPtr;
+
+		for (uint32 index = 0; index < numVisible; ++index)
+		{
+			const visibility_object& object = cache.objects[visibleIndices[index]];
+			transforms[index] = trs_to_mat4(group.get<TransformComponent>(object.entityHandle).get_world_transform());
+		}
+
+		D3D12_GPU_VIRTUAL_ADDRESS transformsAddress = transformAllocation.gpuPtr;
 
-			for (auto& sm : mesh->submeshes)
+		forEachVisibleMesh(cache, visibleIndices, numVisible, [&](multi_mesh* mesh, uint32 offset, uint32 count)
 			{
-				data.submesh = sm.info;
-				data.material = sm.material;
+				D3D12_GPU_VIRTUAL_ADDRESS baseM = transformsAddress + (offset * sizeof(mat4));
 
-				depthPrepassData.submesh = data.submesh;
-				depthPrepassData.alphaCutoutTextureSRV = (sm.material && sm.material->albedo) ? sm.material->albedo->defaultSRV : dx_cpu_descriptor_handle{};
+				const dx_mesh& dxMesh = mesh->mesh;
 
-				addToRenderPass(sm.material->shader, data, depthPrepassData, opaqueRenderPass, transparentRenderPass);
+				if (!dxMesh.indexBuffer || !dxMesh.vertexBuffer.positions)
+					return;
 
-				++numDrawCalls;
-			}
-		}
+				shadow_render_data data;
+				data.transformPtr = baseM;
+				data.vertexBuffer = dxMesh.vertexBuffer.positions;
+				data.indexBuffer = dxMesh.indexBuffer;
+				data.numInstances = count;
 
-		CPU_PROFILE_STAT("Dynamic draw calls", numDrawCalls);
+				const bool isPointLight = (frustum.type == light_frustum_sphere);
+				for (auto& sm : mesh->submeshes)
+				{
+					data.submesh = sm.info;
+					if (dynamic)
+					{
+						addToDynamicRenderPass(sm.material->shader, data, shadowRenderPass, isPointLight);
+					}
+					else
+					{
+						addToStaticRenderPass(sm.material->shader, data, shadowRenderPass, isPointLight);
+					}
+				}
+			});
 	}
 
+	// Culls the objects of the cache against the main camera and all shadow passes in one traversal, then records the main
+	// camera and each shadow pass in parallel.
 	template <typename group_t>
-	static void renderDynamicObjectsToShadowMap(group_t group, std::unordered_map<multi_mesh*, offset_count> ocPerMesh,
-		const light_frustum& frustum, Allocator& arena, shadow_render_pass_base* shadowRenderPass)
+	static void renderVisibleObjects(group_t group, visibility_cache& cache, bool dynamic, const camera_frustum_planes& frustum, Allocator& arena,
+		Entity::Handle selectedObjectID, opaque_render_pass* opaqueRenderPass, transparent_render_pass* transparentRenderPass, ldr_render_pass* ldrRenderPass,
+		shadow_passes& shadow)
 	{
-		uint32 groupSize = (uint32)group.size();
-
-		dx_allocation transformAllocation = dxContext.allocateDynamicBuffer(groupSize * sizeof(mat4), 4);
-		mat4* transforms = (mat4*)transformAllocation.cpuPtr;
+		// The main camera is view 0, the shadow passes follow.
+		const uint32 numViews = 1 + shadow.numShadowRenderPasses;
+		ASSERT(numViews <= VisibilityBVH::MAX_VIEWS);
 
-		for (auto [entityHandle, transform, mesh] : group.each())
+		VisibilityView* views = arena.allocate<VisibilityView>(numViews);
+		views[0] = VisibilityView::from_frustum(frustum);
+		for (uint32 i = 0; i < shadow.numShadowRenderPasses; ++i)
 		{
-			if (!shouldRender(frustum, mesh, transform))
-				continue;
-
-			if (transform.type != TransformComponent::DYNAMIC)
-				continue;
+			const light_frustum& lightFrustum = shadow.shadowRenderPasses[i].frustum;
+			views[i + 1] = (lightFrustum.type == light_frustum_standard) ? VisibilityView::from_frustum(lightFrustum.frustum) : VisibilityView::from_sphere(lightFrustum.sphere);
+		}
 
-			const dx_mesh& dxMesh = mesh.mesh->mesh;
-			if (!ocPerMesh.contains(mesh.mesh.get()))
-				continue;
-			offset_count& oc = ocPerMesh.at(mesh.mesh.get());
+		{
+			CPU_PROFILE_BLOCK("Cull");
+			cache.bvh.cull(views, numViews, cache.visibility);
+		}
 
-			uint32 index = oc.offset + oc.count;
-			const trs& world_transform = transform.get_world_transform();
+		const VisibilityResult& visibility = cache.visibility;
 
-			transforms[index] = trs_to_mat4(world_transform);
+		// The upload buffer is not thread safe, so everything is allocated up front. A pass only writes its own allocation
+		// and command buffers.
+		const uint32 numMainCameraTransforms = visibility.get_num_visible(0) * (dynamic ? 2 : 1);
+		dx_allocation transformAllocation = dxContext.allocateDynamicBuffer(numMainCameraTransforms * sizeof(mat4), 4);
+		dx_allocation objectIDAllocation = dxContext.allocateDynamicBuffer(visibility.get_num_visible(0) * sizeof(uint32), 4);
 
-			++oc.count;
+		dx_allocation* shadowTransformAllocations = arena.allocate<dx_allocation>(shadow.numShadowRenderPasses);
+		for (uint32 i = 0; i < shadow.numShadowRenderPasses; ++i)
+		{
+			shadowTransformAllocations[i] = dxContext.allocateDynamicBuffer(visibility.get_num_visible(i + 1) * sizeof(mat4), 4);
 		}
 
-		D3D12_GPU_VIRTUAL_ADDRESS transformsAddress = transformAllocation.gpuPtr;
-
-		for (auto& [mesh, oc] : ocPerMesh)
-		{
-			if (oc.count == 0)
-				continue;
+		parallel_for(0, numViews, 1, [&](uint32 begin, uint32 end)
+			{
+				for (uint32 i = begin; i < end; ++i)
+				{
+					if (i == 0)
+					{
+						renderVisibleObjectsToMainCamera(group, cache, visibility.get_visible_indices(0), visibility.get_num_visible(0), dynamic,
+							transformAllocation, objectIDAllocation, selectedObjectID, opaqueRenderPass, transparentRenderPass, ldrRenderPass);
+					}
+					else
+					{
+						auto& pass = shadow.shadowRenderPasses[i - 1];
+						renderVisibleObjectsToShadowMap(group, cache, visibility.get_visible_indices(i), visibility.get_num_visible(i), dynamic,
+							pass.frustum, shadowTransformAllocations[i - 1], pass.pass);
+					}
+				}
+			});
+	}
 
-			D3D12_GPU_VIRTUAL_ADDRESS baseM = transformsAddress + (oc.offset * sizeof(mat4));
+	static void renderStaticObjects(World* world, const camera_frustum_planes& frustum, Allocator& arena, Entity::Handle selectedObjectID,
+		opaque_render_pass* opaqueRenderPass, transparent_render_pass* transparentRenderPass, ldr_render_pass* ldrRenderPass, shadow_passes& shadow)
+	{
+		CPU_PROFILE_BLOCK("Static objects");
 
-			const dx_mesh& dxMesh = mesh->mesh;
+		using specialized_components = ComponentsGroup<
+			animation::AnimationComponent,
+			TreeComponent
+		>;
 
-			if (!dxMesh.indexBuffer || !dxMesh.vertexBuffer.positions)
-				continue;
+		auto group = world->group(
+			components_group<TransformComponent, MeshComponent>,
+			specialized_components{});
 
-			shadow_render_data data;
-			data.transformPtr = baseM;
-			data.vertexBuffer = dxMesh.vertexBuffer.positions;
-			data.indexBuffer = dxMesh.indexBuffer;
-			data.numInstances = oc.count;
+		static_visibility_cache& cache = EntityUtils::create_or_get_context_variable<static_visibility_cache>(world->get_registry());
+		updateVisibility(group, cache, &isStaticRenderable);
 
-			for (auto& sm : mesh->submeshes)
-			{
-				data.submesh = sm.info;
-				addToDynamicRenderPass(sm.material->shader, data, shadowRenderPass, frustum.type == light_frustum_sphere);
-			}
-		}
+		renderVisibleObjects(group, cache, false, frustum, arena, selectedObjectID, opaqueRenderPass, transparentRenderPass, ldrRenderPass, shadow);
 	}
 
 	static void renderDynamicObjects(World* world, const camera_frustum_planes& frustum, Allocator& arena, Entity::Handle selectedObjectID,
@@ -511,14 +512,11 @@ namespace era_engine
 			components_group<TransformComponent, MeshComponent>,
 			components_group<animation::AnimationComponent>);
 
-		std::unordered_map<multi_mesh*, offset_count> ocPerMesh = getOffsetsPerMesh(group);
-		renderDynamicObjectsToMainCamera(group, ocPerMesh, frustum, arena, selectedObjectID, opaqueRenderPass, transparentRenderPass, ldrRenderPass);
+		// Dynamic objects usually move every frame, so most of them are refit. The hierarchy rebuilds itself once that pays off.
+		dynamic_visibility_cache& cache = EntityUtils::create_or_get_context_variable<dynamic_visibility_cache>(world->get_registry());
+		updateVisibility(group, cache, &isDynamicRenderable);
 
-		for (uint32 i = 0; i < shadow.numShadowRenderPasses; ++i)
-		{
-			auto& pass = shadow.shadowRenderPasses[i];
-			renderDynamicObjectsToShadowMap(group, ocPerMesh, pass.frustum, arena, pass.pass);
-		}
+		renderVisibleObjects(group, cache, true, frustum, arena, selectedObjectID, opaqueRenderPass, transparentRenderPass, ldrRenderPass, shadow);
 	}
 
 	static void renderAnimatedObjects(World* world, const camera_frustum_planes& frustum, Allocator& arena, Entity::Handle selectedObjectID,
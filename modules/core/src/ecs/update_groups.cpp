@@ -6,6 +6,12 @@ namespace era_engine::update_types
 {
 	void register_default_order()
 	{
+		// Every world's scheduler registers the order. Groups listed twice would run twice per update.
+		if (!UpdatesHolder::update_order.empty())
+		{
+			return;
+		}
+
 		UpdatesHolder::update_order.push_back(std::string(INPUT.name));
 
 		UpdatesHolder::update_order.push_back(std::string(BEGIN.name));
@@ -14,7 +14,7 @@ namespace era_engine
 	{
 		world_data = new WorldData();
 		world_data->name = _name;
-		world_data->scheduler = new WorldSystemScheduler(this, 1, 1);
+		world_data->scheduler = new WorldSystemScheduler(this);
 
 		world_data->scheduler->set_fixed_update_rate(60.0);
 
@@ -28,8 +28,7 @@ namespace era_engine
 
 	void World::init()
 	{
-		ref<Entity::EcsData> new_data = make_ref<Entity::EcsData>(world_data->registry.create(), Entity::NullHandle, this, &world_data->registry);
-		world_data->entity_datas.emplace(new_data->entity_handle, new_data);
+		Entity::EcsData* new_data = world_data->entity_datas.emplace(world_data->registry.create(), Entity::NullHandle, this, &world_data->registry);
 		world_data->root_entity = Entity(new_data);
 		world_data->root_entity.add_component<TransformComponent>();
 		world_data->root_entity.add_component<NameComponent>("RootEntity");
@@ -40,13 +39,13 @@ namespace era_engine
 	{
 		std::lock_guard _lock{ world_data->sync};
 
-		ref<Entity::EcsData> new_data = make_ref<Entity::EcsData>(world_data->registry.create(), world_data->root_entity.get_handle(), this, &world_data->registry);
-		world_data->entity_datas.emplace(new_data->entity_handle, new_data);
+		Entity::EcsData* new_data = world_data->entity_datas.emplace(world_data->registry.create(), world_data->root_entity.get_handle(), this, &world_data->registry);
 
 		Entity entity = Entity(new_data);
 		add_base_components(entity);
 
 		EntityContainer::emplace_pair(this, world_data->root_entity.get_handle(), new_data->entity_handle);
+		++hierarchy_version;
 
 		return entity;
 	}
@@ -62,24 +61,24 @@ namespace era_engine
 	{
 		std::lock_guard _lock{ world_data->sync };
 
-		if (world_data->entity_datas.find(_handle) == world_data->entity_datas.end())
+		if (!world_data->entity_datas.contains(_handle))
 		{
 			if (world_data->registry.create(_handle) == Entity::NullHandle)
 			{
 				LOG_ERROR("ECS> Entity creation failed!");
 			}
 
-			ref<Entity::EcsData> new_data = make_ref<Entity::EcsData>(_handle, world_data->root_entity.get_handle(), this, &world_data->registry);
-			world_data->entity_datas.emplace(new_data->entity_handle, new_data);
+			Entity::EcsData* new_data = world_data->entity_datas.emplace(_handle, world_data->root_entity.get_handle(), this, &world_data->registry);
 
 			Entity entity = Entity(new_data);
 			add_base_components(entity);
 
 			EntityContainer::emplace_pair(this, world_data->root_entity.get_handle(), new_data->entity_handle);
+			++hierarchy_version;
 
 			return entity;
 		}
-		return Entity(world_data->entity_datas[_handle]);
+		return Entity(world_data->entity_datas.find(_handle));
 	}
 
 	Entity World::create_entity(Entity::Handle _handle, const char* _name)
@@ -118,9 +117,16 @@ namespace era_engine
 				destroy_entity(child);
 			}
 		}
+		else
+		{
+			// Children stay alive, so move them under the root instead of leaving them pointing at a dead parent.
+			EntityContainer::erase(this, _handle);
+		}
 
 		world_data->registry.destroy(_handle);
 		world_data->entity_datas.erase(_handle);
+
+		++hierarchy_version;
 	}
 
 	Entity World::try_create_entity_in_place(const Entity& place, const char* _name)
@@ -134,30 +140,17 @@ namespace era_engine
 
 	Entity World::get_entity(Entity::Handle _handle)
 	{
-		if (world_data->entity_datas.find(_handle) == world_data->entity_datas.end())
-		{
-			return Entity();
-		}
-		return Entity(world_data->entity_datas[_handle]);
+		return Entity(world_data->entity_datas.find(_handle));
 	}
 
 	void World::destroy(bool _destroy_components)
 	{
-		for (auto iter = world_data->entity_datas.begin(); iter != world_data->entity_datas.end();)
-		{
-			if (iter->first == Entity::NullHandle)
-			{
-				continue;
-			}
+		// The fixed update thread runs systems on this world, so it has to be joined before anything is torn down.
+		world_data->scheduler->stop();
+		delete world_data->scheduler;
+		world_data->scheduler = nullptr;
 
-			world_data->registry.destroy(iter->first);
-			iter = world_data->entity_datas.erase(iter);
-			if (iter == world_data->entity_datas.end())
-			{
-				break;
-			}
-			++iter;
-		}
+		// Components may still look at their entity data while being destroyed, so the registry goes first.
 		world_data->registry.clear();
 		world_data->entity_datas.clear();
 
@@ -211,6 +204,16 @@ namespace era_engine
 		return world_data->root_entity;
 	}
 
+	Entity::Handle World::get_root_handle() const
+	{
+		return world_data->root_entity.get_handle();
+	}
+
+	uint64 World::get_hierarchy_version() const
+	{
+		return hierarchy_version.load(std::memory_order_relaxed);
+	}
+
 	void World::add_base_components(Entity& entity)
 	{
 		entity.add_component<TransformComponent>();
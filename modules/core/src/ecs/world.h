@@ -5,6 +5,7 @@
 #include "core/tags_container.h"
 
 #include "ecs/entity.h"
+#include "ecs/entity_data_pool.h"
 #include "ecs/entity_utils.h"
 
 #include "ecs/reflection.h"
@@ -26,6 +27,7 @@
 #include <entt/entity/helper.hpp>
 
 #include <unordered_map>
+#include <atomic>
 
 namespace era_engine
 {
@@ -43,7 +45,7 @@ namespace era_engine
 		{
 			std::mutex sync;
 
-			std::unordered_map<Entity::Handle, ref<Entity::EcsData>> entity_datas;
+			EntityDataPool entity_datas;
 
 			entt::registry registry;
 
@@ -81,6 +83,10 @@ namespace era_engine
 		Entity get_entity(Entity::Handle _handle);
 
 		Entity get_root_entity() const;
+		Entity::Handle get_root_handle() const;
+
+		// Incremented whenever an entity is created, destroyed or re-parented.
+		uint64 get_hierarchy_version() const;
 
 		void destroy(bool _destroy_components = true);
 
@@ -207,12 +213,21 @@ namespace era_engine
 
 		uint64 fixed_frame_id = 0;
 
+		std::atomic<uint64> hierarchy_version = 0;
+
 		float fixed_update_dt = 0.0f;
 
 		friend class Entity;
+		friend class EntityContainer;
 		friend class WorldSystemScheduler;
 	};
 
+	template <typename Func_>
+	inline void EntityContainer::for_each_child(World* world, Entity::Handle parent, const Func_& func)
+	{
+		world->world_data->entity_datas.for_each_child(parent, func);
+	}
+
 	ERA_CORE_API World* get_world_by_name(const std::string& _name);
 
 	ERA_CORE_API std::unordered_map<std::string, World*>& get_worlds();
@@ -16,45 +16,42 @@
 namespace era_engine
 {
 
-	struct TasksParams
+	struct GroupJobData
 	{
-		std::vector<ref<Task>>& updates;
-		float elapsed = 0.0f;
 	};
 
-	static void set_high_priority(std::thread& thread, bool is_critical = false)
+	static double to_milliseconds(std::chrono::steady_clock::duration duration)
 	{
-		auto handle = thread.native_handle();
-
-#ifdef _WIN32
-		SetThreadPriority(handle, is_critical ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_NORMAL);
-#else
-		pthread_t pt_handle = handle;
-		sched_param sch_params;
-		int policy = SCHED_FIFO;
-		sch_params.sched_priority = is_critical ? 99 : 80;
-		pthread_setschedparam(pt_handle, policy, &sch_params);
-#endif
+		return std::chrono::duration<double, std::milli>(duration).count();
 	}
 
-	WorldSystemScheduler::WorldSystemScheduler(World* _world, size_t normal_threads, size_t fixed_threads)
-		: world(_world), running(false)
+	// A task without Reads/Writes conflicts with nothing, only its After/Before edges order it.
+	static bool has_access_conflict(const Task& first, const Task& second)
 	{
-		running = true;
-		fixed_update_thread = std::thread(&WorldSystemScheduler::fixed_update_loop, this);
+		auto intersects = [](const std::vector<std::string>& a, const std::vector<std::string>& b)
+		{
+			for (const std::string& name : a)
+			{
+				if (std::find(b.begin(), b.end(), name) != b.end())
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+
+		return intersects(first.writes, second.writes)
+			|| intersects(first.writes, second.reads)
+			|| intersects(first.reads, second.writes);
+	}
 
+	WorldSystemScheduler::WorldSystemScheduler(World* _world, JobQueue* _job_queue, JobQueue* _fixed_job_queue)
+		: job_queue(_job_queue), fixed_job_queue(_fixed_job_queue), running(false), world(_world)
+	{
 		set_fixed_update_rate(60.0f);
 
-		for (size_t i = 0; i < normal_threads; ++i)
-		{
-			normal_thread_pool.emplace_back(&WorldSystemScheduler::normal_worker, this);
-			set_high_priority(normal_thread_pool.back(), false);
-		}
-		for (size_t i = 0; i < fixed_threads; ++i)
-		{
-			fixed_thread_pool.emplace_back(&WorldSystemScheduler::fixed_worker, this);
-			set_high_priority(fixed_thread_pool.back(), true);
-		}
+		running = true;
+		fixed_update_thread = std::thread(&WorldSystemScheduler::fixed_update_loop, this);
 
 		update_types::register_default_order();
 	}
@@ -62,7 +59,8 @@ namespace era_engine
 	WorldSystemScheduler::~WorldSystemScheduler()
 	{
 		stop();
-		grouped_ordered_tasks.clear();
+		normal_graphs.clear();
+		fixed_graphs.clear();
 		systems.clear();
 		system_types.clear();
 	}
@@ -70,31 +68,11 @@ namespace era_engine
 	void WorldSystemScheduler::stop()
 	{
 		running = false;
-		{
-			std::unique_lock<std::mutex> lock(queue_mutex);
-			normal_condition.notify_all();
-			fixed_condition.notify_all();
-		}
 
 		if (fixed_update_thread.joinable())
 		{
 			fixed_update_thread.join();
 		}
-
-		for (auto& thread : normal_thread_pool)
-		{
-			if (thread.joinable())
-			{
-				thread.join();
-			}
-		}
-		for (auto& thread : fixed_thread_pool)
-		{
-			if (thread.joinable())
-			{
-				thread.join();
-			}
-		}
 	}
 
 	void WorldSystemScheduler::set_fixed_update_rate(double rate)
@@ -142,9 +120,15 @@ namespace era_engine
 					std::vector<std::string> dependencies = after.is_valid() ? after.get_value<std::vector<std::string>>() : std::vector<std::string>{};
 					std::vector<std::string> dependent = before.is_valid() ? before.get_value<std::vector<std::string>>() : std::vector<std::string>{};
 
+					variant reads_meta = system_method.get_metadata("Reads");
+					variant writes_meta = system_method.get_metadata("Writes");
+
+					std::vector<std::string> reads = reads_meta.is_valid() ? reads_meta.get_value<std::vector<std::string>>() : std::vector<std::string>{};
+					std::vector<std::string> writes = writes_meta.is_valid() ? writes_meta.get_value<std::vector<std::string>>() : std::vector<std::string>{};
+
 					UpdateGroup group = meta.get_value<UpdateGroup>();
 
-					ref<Task> task = make_ref<Task>(system, system_method, std::string(group.name), system_tag, dependencies, dependent);
+					ref<Task> task = make_ref<Task>(system, system_method, std::string(group.name), system_tag, dependencies, dependent, reads, writes);
 
 					add_task(task, group.update_type);
 				}
@@ -168,224 +152,251 @@ namespace era_engine
 	{
 		if(inited)
 		{
-			grouped_ordered_tasks = build_task_order(UpdateType::NORMAL);
-			fixed_grouped_ordered_tasks = build_task_order(UpdateType::FIXED);
+			normal_graphs_dirty = true;
+			fixed_graphs_dirty = true;
 		}
 	}
 
 	void WorldSystemScheduler::update_normal(float dt)
 	{
+		if (normal_graphs_dirty.exchange(false))
 		{
-			std::unique_lock<std::mutex> lock(queue_mutex);
-			for (auto& group_name : UpdatesHolder::update_order)
-			{
-				UpdateGroup* group = find_group(group_name);
-				auto found_group_iter = grouped_ordered_tasks.find(group_name);
-				if (found_group_iter != grouped_ordered_tasks.end())
-				{
-					auto& group_tasks = found_group_iter->second;
-					if (group)
-					{
-						if (!group->main_thread)
-						{
-							for (auto& task : group_tasks)
-							{
-								normal_task_queue.push({ task, dt });
-							}
-						}
-						else
-						{
-							for (auto& task : group_tasks)
-							{
-								auto type_name = task->system->get_type().get_name().data();
-								auto method_name = task->method.get_name().data();
+			normal_graphs = build_task_graphs(UpdateType::NORMAL);
+		}
 
-								std::stringstream stream{};
-								stream << type_name << ": " << method_name;
+		std::vector<UpdateGroupTiming> timings;
+		run_update(normal_graphs, dt, timings);
 
-								CPU_PROFILE_BLOCK(stream.str().c_str());
+		std::lock_guard<std::mutex> lock(timings_mutex);
+		normal_timings = std::move(timings);
+	}
 
-								task->method.invoke(*task->system, dt);
-							}
-						}
-					}
-				}
-			}
+	void WorldSystemScheduler::update_fixed(float dt)
+	{
+		if (fixed_graphs_dirty.exchange(false))
+		{
+			fixed_graphs = build_task_graphs(UpdateType::FIXED);
 		}
-		normal_condition.notify_all();
+
+		std::vector<UpdateGroupTiming> timings;
+		run_update(fixed_graphs, dt, timings);
+
+		std::lock_guard<std::mutex> lock(timings_mutex);
+		fixed_timings = std::move(timings);
 	}
 
-	void WorldSystemScheduler::add_task(ref<Task> task, UpdateType type)
+	void WorldSystemScheduler::run_fixed_step(float dt)
 	{
-		auto& current_in_degree = type == UpdateType::NORMAL ? in_degree : fixed_in_degree;
-		auto& current_tasks = type == UpdateType::NORMAL ? tasks : fixed_tasks;
-		auto& current_adj_list = type == UpdateType::NORMAL ? adj_list : fixed_adj_list;
+		update_fixed(dt);
 
-		std::string task_name = task->system->get_type().get_name() + std::string("::") + task->method.get_name();
-		current_tasks[task_name] = task;
+		ObservableStorage::sync_all_changes(world);
 
-		if (current_adj_list.find(task_name) == current_adj_list.end())
+		++world->fixed_frame_id;
+	}
+
+	std::vector<UpdateGroupTiming> WorldSystemScheduler::get_normal_timings() const
+	{
+		std::lock_guard<std::mutex> lock(timings_mutex);
+		return normal_timings;
+	}
+
+	std::vector<UpdateGroupTiming> WorldSystemScheduler::get_fixed_timings() const
+	{
+		std::lock_guard<std::mutex> lock(timings_mutex);
+		return fixed_timings;
+	}
+
+	void WorldSystemScheduler::run_update(std::vector<ref<TaskGraph>>& graphs, float dt, std::vector<UpdateGroupTiming>& timings)
+	{
+		// Concurrent groups overlap with the main thread groups that follow them,
+		// but are joined before the next concurrent group starts and at the end of the update.
+		TaskGraph* pending_graph = nullptr;
+
+		for (auto& graph : graphs)
 		{
-			current_adj_list[task_name] = {};
+			if (graph->main_thread)
+			{
+				start_graph(*graph, dt);
+				timings.push_back(collect_timing(*graph));
+				continue;
+			}
+
+			if (pending_graph != nullptr)
+			{
+				pending_graph->group_job.wait_for_completion();
+				timings.push_back(collect_timing(*pending_graph));
+			}
+
+			start_graph(*graph, dt);
+			pending_graph = graph.get();
 		}
-		if (current_in_degree.find(task_name) == current_in_degree.end())
+
+		if (pending_graph != nullptr)
 		{
-			current_in_degree[task_name] = 0;
+			pending_graph->group_job.wait_for_completion();
+			timings.push_back(collect_timing(*pending_graph));
 		}
+	}
 
-		for (const auto& dep : task->dependencies)
+	void WorldSystemScheduler::start_graph(TaskGraph& graph, float dt)
+	{
+		graph.dt = dt;
+		graph.start_time = std::chrono::steady_clock::now();
+
+		if (graph.main_thread)
 		{
-			current_adj_list[dep].push_back(task_name);
-			current_in_degree[task_name]++;
+			for (uint32 i = 0; i < (uint32)graph.nodes.size(); ++i)
+			{
+				run_node(graph, i);
+			}
+			return;
 		}
 
-		for (const auto& dep : task->dependents)
+		for (auto& node : graph.nodes)
 		{
-			current_adj_list[task_name].push_back(dep);
-			current_in_degree[dep]++;
+			node->remaining_dependencies.store((uint32)node->dependencies.size(), std::memory_order_relaxed);
 		}
-	}
 
-	UpdateGroup* find_group(const std::string& name)
-	{
-		auto iter = UpdatesHolder::global_groups.find(name);
-		if (iter == UpdatesHolder::global_groups.end())
+		// The group job only collects the task jobs, so that a single wait covers the whole DAG.
+		graph.group_job = graph.job_queue->createJob<GroupJobData>([](GroupJobData&, JobHandle) {}, {});
+
+		for (uint32 root : graph.roots)
 		{
-			return nullptr;
+			submit_node(graph, root);
 		}
-		return iter->second;
+
+		graph.group_job.submit_now();
 	}
 
-	void WorldSystemScheduler::normal_worker()
+	void WorldSystemScheduler::submit_node(TaskGraph& graph, uint32 node_index)
 	{
-		while (true)
-		{
-			TaskItem item;
-			{
-				std::unique_lock<std::mutex> lock(queue_mutex);
-				auto timeout = std::chrono::milliseconds(100);
-				if (!normal_condition.wait_for(lock, timeout, [this]
-					{
-						return !normal_task_queue.empty() || !running;
-					}))
-				{
-					continue;
-				}
+		TaskJobData data = { this, &graph, node_index };
+		graph.job_queue->createJob<TaskJobData>(task_job, data, graph.group_job).submit_now();
+	}
 
-				if (!running)
-				{
-					break;
-				}
+	void WorldSystemScheduler::task_job(TaskJobData& data, JobHandle job)
+	{
+		TaskGraph& graph = *data.graph;
+		data.scheduler->run_node(graph, data.node_index);
 
-				item = normal_task_queue.front();
-				normal_task_queue.pop();
+		for (uint32 dependent : graph.nodes[data.node_index]->dependents)
+		{
+			if (graph.nodes[dependent]->remaining_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				data.scheduler->submit_node(graph, dependent);
 			}
+		}
+	}
 
-			auto type_name = item.task->system->get_type().get_name().data();
-			auto method_name = item.task->method.get_name().data();
-
-			std::stringstream stream{};
-			stream << type_name << ": " << method_name;
+	void WorldSystemScheduler::run_node(TaskGraph& graph, uint32 node_index)
+	{
+		TaskNode& node = *graph.nodes[node_index];
 
-			CPU_PROFILE_BLOCK(stream.str().c_str());
+		CPU_PROFILE_BLOCK(node.name.c_str());
 
-			item.task->method.invoke(*item.task->system, item.dt);
-		}
+		node.start_time = std::chrono::steady_clock::now();
+		node.task->method.invoke(*node.task->system, graph.dt);
+		node.end_time = std::chrono::steady_clock::now();
 	}
 
-	void WorldSystemScheduler::update_fixed(float dt)
+	UpdateGroupTiming WorldSystemScheduler::collect_timing(const TaskGraph& graph) const
 	{
+		UpdateGroupTiming timing;
+		timing.group = graph.group;
+
+		const uint32 num_nodes = (uint32)graph.nodes.size();
+		if (num_nodes == 0)
 		{
-			std::lock_guard<std::mutex> lock(queue_mutex);
+			return timing;
+		}
 
-			const std::vector<std::string>& order = UpdatesHolder::update_order;
-			for (auto& group_name : order)
-			{
-				if (group_name.empty())
-				{
-					continue;
-				}
-				UpdateGroup* group = find_group(group_name);
-				auto found_group_iter = fixed_grouped_ordered_tasks.find(group_name);
-				if(found_group_iter != fixed_grouped_ordered_tasks.end())
-				{
-					auto& group_tasks = found_group_iter->second;
+		// Longest path through the DAG, weighted by the measured durations. Nodes are in topological order.
+		std::vector<double> path_length(num_nodes, 0.0);
+		std::vector<int32> path_predecessor(num_nodes, -1);
 
-					if (group)
-					{
-						if (!group->main_thread)
-						{
-							for (auto& task : group_tasks)
-							{
-								fixed_task_queue.push({ task, dt });
-							}
-						}
-						else
-						{
-							for (auto& task : group_tasks)
-							{
-								auto type_name = task->system->get_type().get_name().data();
-								auto method_name = task->method.get_name().data();
+		std::chrono::steady_clock::time_point group_end = graph.start_time;
 
-								std::stringstream stream{};
-								stream << type_name << ": " << method_name;
+		timing.tasks.resize(num_nodes);
+		for (uint32 i = 0; i < num_nodes; ++i)
+		{
+			const TaskNode& node = *graph.nodes[i];
 
-								CPU_PROFILE_BLOCK(stream.str().c_str());
+			TaskTiming& task_timing = timing.tasks[i];
+			task_timing.name = node.name;
+			task_timing.start_ms = to_milliseconds(node.start_time - graph.start_time);
+			task_timing.duration_ms = to_milliseconds(node.end_time - node.start_time);
 
-								task->method.invoke(*task->system, dt);
-							}
-						}
-					}
+			double longest_dependency = 0.0;
+			for (uint32 dependency : node.dependencies)
+			{
+				if (path_length[dependency] > longest_dependency)
+				{
+					longest_dependency = path_length[dependency];
+					path_predecessor[i] = (int32)dependency;
 				}
 			}
-		}
+			path_length[i] = longest_dependency + task_timing.duration_ms;
 
-		fixed_condition.notify_all();
-	}
+			if (node.end_time > group_end)
+			{
+				group_end = node.end_time;
+			}
+		}
 
-	void WorldSystemScheduler::fixed_worker()
-	{
-		while (true)
+		int32 critical_node = 0;
+		for (uint32 i = 1; i < num_nodes; ++i)
 		{
-			TaskItem item;
+			if (path_length[i] > path_length[critical_node])
 			{
-				std::unique_lock<std::mutex> lock(queue_mutex);
-				auto timeout = std::chrono::milliseconds(100);
-				if (!fixed_condition.wait_for(lock, timeout, [this]
-					{
-						return !fixed_task_queue.empty() || !running;
-					})) 
-				{
-					continue;
-				}
+				critical_node = (int32)i;
+			}
+		}
 
-				if (!running)
-				{
-					break;
-				}
+		timing.critical_path_ms = path_length[critical_node];
+		timing.duration_ms = to_milliseconds(group_end - graph.start_time);
 
-				item = fixed_task_queue.front();
-				fixed_task_queue.pop();
+		for (; critical_node != -1; critical_node = path_predecessor[critical_node])
+		{
+			timing.tasks[critical_node].on_critical_path = true;
+		}
 
-				++active_fixed_tasks;
-			}
+		return timing;
+	}
 
-			auto type_name = item.task->system->get_type().get_name().data();
-			auto method_name = item.task->method.get_name().data();
+	void WorldSystemScheduler::add_task(ref<Task> task, UpdateType type)
+	{
+		auto& current_tasks = type == UpdateType::NORMAL ? tasks : fixed_tasks;
+		auto& current_adj_list = type == UpdateType::NORMAL ? adj_list : fixed_adj_list;
 
-			std::stringstream stream{};
-			stream << type_name << ": " << method_name;
+		std::string task_name = task->system->get_type().get_name() + std::string("::") + task->method.get_name();
+		current_tasks[task_name] = task;
 
-			CPU_PROFILE_BLOCK(stream.str().c_str());
+		if (current_adj_list.find(task_name) == current_adj_list.end())
+		{
+			current_adj_list[task_name] = {};
+		}
 
-			item.task->method.invoke(*item.task->system, item.dt);
+		// Edges may name tasks which are added later or never (systems of modules which aren't loaded).
+		// build_task_order() only counts the edges between tasks which exist.
+		for (const auto& dep : task->dependencies)
+		{
+			current_adj_list[dep].push_back(task_name);
+		}
 
-			{
-				std::lock_guard<std::mutex> lock(queue_mutex);
-				--active_fixed_tasks;
-			}
-			tasks_done_cv.notify_one();
+		for (const auto& dep : task->dependents)
+		{
+			current_adj_list[task_name].push_back(dep);
+		}
+	}
+
+	UpdateGroup* find_group(const std::string& name)
+	{
+		auto iter = UpdatesHolder::global_groups.find(name);
+		if (iter == UpdatesHolder::global_groups.end())
+		{
+			return nullptr;
 		}
+		return iter->second;
 	}
 
 	void WorldSystemScheduler::fixed_update_loop()
@@ -402,18 +413,7 @@ namespace era_engine
 				ZoneScopedN("WorldSystemScheduler::fixed_update_loop");
 
 				float fixed_dt = std::chrono::duration<float>(elapsed).count();
-				update_fixed(fixed_dt);
-
-				{
-					std::unique_lock<std::mutex> lock(queue_mutex);
-					tasks_done_cv.wait(lock, [this] {
-						return active_fixed_tasks == 0 && fixed_task_queue.empty();
-						});
-				}
-
-				ObservableStorage::sync_all_changes(world);
-
-				++world->fixed_frame_id;
+				run_fixed_step(fixed_dt);
 
 				last_fixed_update = now;
 			}
@@ -426,9 +426,31 @@ namespace era_engine
 
 	std::unordered_map<std::string, std::vector<ref<Task>>> WorldSystemScheduler::build_task_order(UpdateType type)
 	{
-		auto& current_in_degree = type == UpdateType::NORMAL ? in_degree : fixed_in_degree;
-		auto& current_tasks = type == UpdateType::NORMAL ? tasks : fixed_tasks;
-		auto& current_adj_list = type == UpdateType::NORMAL ? adj_list : fixed_adj_list;
+		const auto& current_tasks = type == UpdateType::NORMAL ? tasks : fixed_tasks;
+		const auto& current_adj_list = type == UpdateType::NORMAL ? adj_list : fixed_adj_list;
+
+		std::unordered_map<std::string, int> current_in_degree;
+		for (const auto& [task_name, task] : current_tasks)
+		{
+			current_in_degree.emplace(task_name, 0);
+		}
+
+		for (const auto& [task_name, neighbors] : current_adj_list)
+		{
+			if (current_tasks.find(task_name) == current_tasks.end())
+			{
+				continue;
+			}
+
+			for (const auto& neighbor : neighbors)
+			{
+				auto neighbor_iter = current_in_degree.find(neighbor);
+				if (neighbor_iter != current_in_degree.end())
+				{
+					++neighbor_iter->second;
+				}
+			}
+		}
 
 		std::queue<std::string> zero_in_degree;
 		std::vector<ref<Task>> task_order;
@@ -444,17 +466,20 @@ namespace era_engine
 		while (!zero_in_degree.empty())
 		{
 			std::string current = zero_in_degree.front();
+			zero_in_degree.pop();
 
-			auto& current_task = current_tasks[current];
+			task_order.push_back(current_tasks.find(current)->second);
 
-			task_order.push_back(current_task);
-			
-			zero_in_degree.pop();
+			auto adj_iter = current_adj_list.find(current);
+			if (adj_iter == current_adj_list.end())
+			{
+				continue;
+			}
 
-			for (const auto& neighbor : current_adj_list[current])
+			for (const auto& neighbor : adj_iter->second)
 			{
-				current_in_degree[neighbor]--;
-				if (current_in_degree[neighbor] == 0)
+				auto neighbor_iter = current_in_degree.find(neighbor);
+				if (neighbor_iter != current_in_degree.end() && --neighbor_iter->second == 0)
 				{
 					zero_in_degree.push(neighbor);
 				}
@@ -472,23 +497,129 @@ namespace era_engine
 			grouped_tasks[task->group].push_back(task);
 		}
 
+		// Tags enable whole groups: a group runs with all of its tasks as soon as one of them has a tag of the world.
+		// Groups mix tags, e.g. the editor never adds "motion_matching", "game" or "debug", but their systems run in groups
+		// which it enables.
 		std::unordered_map<std::string, std::vector<ref<Task>>> ordered_groups;
-		std::unordered_set<std::string> added_groups;
-
 		for (const auto& task : task_order)
 		{
-			if (added_groups.find(task->group) == added_groups.end() && task->system->world->has_tag(task->tag))
+			if (ordered_groups.find(task->group) == ordered_groups.end() && world->has_tag(task->tag))
 			{
 				ordered_groups.emplace(task->group, grouped_tasks[task->group]);
-				added_groups.insert(task->group);
 			}
 		}
 
 		return ordered_groups;
 	}
 
-	Task::Task(System* _system, const rttr::method& _method, const std::string& _group, const std::string& _tag, const std::vector<std::string>& _dependencies, const std::vector<std::string>& _dependents)
-		: system(_system), method(_method), group(_group), tag(_tag), dependencies(_dependencies), dependents(_dependents)
+	std::vector<ref<WorldSystemScheduler::TaskGraph>> WorldSystemScheduler::build_task_graphs(UpdateType type)
+	{
+		auto& current_adj_list = type == UpdateType::NORMAL ? adj_list : fixed_adj_list;
+
+		std::unordered_map<std::string, std::vector<ref<Task>>> ordered_groups = build_task_order(type);
+
+		std::vector<ref<TaskGraph>> graphs;
+		for (const std::string& group_name : UpdatesHolder::update_order)
+		{
+			UpdateGroup* group = find_group(group_name);
+			auto found_group_iter = ordered_groups.find(group_name);
+			if (group == nullptr || found_group_iter == ordered_groups.end())
+			{
+				continue;
+			}
+
+			const std::vector<ref<Task>>& group_tasks = found_group_iter->second;
+
+			ref<TaskGraph> graph = make_ref<TaskGraph>();
+			graph->group = group_name;
+			graph->main_thread = group->main_thread;
+			graph->job_queue = type == UpdateType::NORMAL ? job_queue : fixed_job_queue;
+
+			std::unordered_map<std::string, uint32> node_indices;
+			for (const ref<Task>& task : group_tasks)
+			{
+				auto node = std::make_unique<TaskNode>();
+				node->task = task;
+				node->name = task->system->get_type().get_name() + std::string("::") + task->method.get_name();
+
+				node_indices.emplace(node->name, (uint32)graph->nodes.size());
+				graph->nodes.push_back(std::move(node));
+			}
+
+			if (!graph->main_thread)
+			{
+				const uint32 num_nodes = (uint32)graph->nodes.size();
+
+				// Explicit After/Before edges inside the group. Edges to other groups are covered by the group order.
+				std::vector<std::vector<bool>> edges(num_nodes, std::vector<bool>(num_nodes, false));
+				for (uint32 i = 0; i < num_nodes; ++i)
+				{
+					auto adj_iter = current_adj_list.find(graph->nodes[i]->name);
+					if (adj_iter == current_adj_list.end())
+					{
+						continue;
+					}
+
+					for (const std::string& neighbor : adj_iter->second)
+					{
+						auto neighbor_iter = node_indices.find(neighbor);
+						if (neighbor_iter != node_indices.end())
+						{
+							edges[i][neighbor_iter->second] = true;
+						}
+					}
+				}
+
+				// Conflicting component access is ordered like the topological order.
+				for (uint32 i = 0; i < num_nodes; ++i)
+				{
+					for (uint32 j = i + 1; j < num_nodes; ++j)
+					{
+						if (!edges[i][j] && has_access_conflict(*graph->nodes[i]->task, *graph->nodes[j]->task))
+						{
+							edges[i][j] = true;
+						}
+					}
+				}
+
+				for (uint32 i = 0; i < num_nodes; ++i)
+				{
+					for (uint32 j = 0; j < num_nodes; ++j)
+					{
+						if (edges[i][j])
+						{
+							graph->nodes[i]->dependents.push_back(j);
+							graph->nodes[j]->dependencies.push_back(i);
+						}
+					}
+				}
+
+				for (uint32 i = 0; i < num_nodes; ++i)
+				{
+					if (graph->nodes[i]->dependencies.empty())
+					{
+						graph->roots.push_back(i);
+					}
+				}
+			}
+			else
+			{
+				// Main thread groups run in topological order, which is a chain for the critical path.
+				for (uint32 i = 1; i < (uint32)graph->nodes.size(); ++i)
+				{
+					graph->nodes[i - 1]->dependents.push_back(i);
+					graph->nodes[i]->dependencies.push_back(i - 1);
+				}
+			}
+
+			graphs.push_back(graph);
+		}
+
+		return graphs;
+	}
+
+	Task::Task(System* _system, const rttr::method& _method, const std::string& _group, const std::string& _tag, const std::vector<std::string>& _dependencies, const std::vector<std::string>& _dependents, const std::vector<std::string>& _reads, const std::vector<std::string>& _writes)
+		: system(_system), method(_method), group(_group), tag(_tag), dependencies(_dependencies), dependents(_dependents), reads(_reads), writes(_writes)
 	{
 	}
 
@@ -13,8 +13,8 @@
 #include <queue>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
 #include <atomic>
+#include <memory>
 #include <chrono>
 #include <functional>
 
@@ -29,7 +29,9 @@ namespace era_engine
 			 const std::string& _group,
 			 const std::string& _tag,
 			 const std::vector<std::string>& _dependencies,
-			 const std::vector<std::string>& _dependents);
+			 const std::vector<std::string>& _dependents,
+			 const std::vector<std::string>& _reads = {},
+			 const std::vector<std::string>& _writes = {});
 		Task(Task&& _other) noexcept = default;
 		Task(const Task& _other) noexcept = default;
 
@@ -42,6 +44,28 @@ namespace era_engine
 		std::string tag;
 		std::vector<std::string> dependencies;
 		std::vector<std::string> dependents;
+
+		// Optional component access declaration ("Reads"/"Writes" metadata, component type names).
+		// Tasks of the same group that don't conflict are allowed to overlap, conflicting ones run in topological order.
+		// A task without any declaration conflicts with nothing and is only ordered by its After/Before edges.
+		std::vector<std::string> reads;
+		std::vector<std::string> writes;
+	};
+
+	struct TaskTiming
+	{
+		std::string name;
+		double start_ms = 0.0; // Relative to the start of the group.
+		double duration_ms = 0.0;
+		bool on_critical_path = false;
+	};
+
+	struct UpdateGroupTiming
+	{
+		std::string group;
+		double duration_ms = 0.0;
+		double critical_path_ms = 0.0;
+		std::vector<TaskTiming> tasks;
 	};
 
     ERA_CORE_API UpdateGroup* find_group(const std::string& name);
@@ -49,7 +73,9 @@ namespace era_engine
     class ERA_CORE_API WorldSystemScheduler
     {
     public:
-        WorldSystemScheduler(World* _world, size_t normal_threads = 2, size_t fixed_threads = 2);
+        // The normal and fixed update graphs run on separate queues, so that neither update helps out with (and waits for)
+        // the jobs of the other one.
+        WorldSystemScheduler(World* _world, JobQueue* _job_queue = &high_priority_job_queue, JobQueue* _fixed_job_queue = &fixed_update_job_queue);
 
         ~WorldSystemScheduler();
 
@@ -67,35 +93,73 @@ namespace era_engine
 
         void update_fixed(float dt);
 
+        // One step of the fixed update thread: update_fixed() followed by the observable sync and the fixed frame counter.
+        // Used to drive the fixed update manually (fixed step runs, headless runtime) after stop().
+        void run_fixed_step(float dt);
+
+        std::vector<UpdateGroupTiming> get_normal_timings() const;
+
+        std::vector<UpdateGroupTiming> get_fixed_timings() const;
+
     protected:
-        struct TaskItem 
+        struct TaskNode
         {
             ref<Task> task;
+            std::string name;
+
+            std::vector<uint32> dependencies;
+            std::vector<uint32> dependents;
+            std::atomic<uint32> remaining_dependencies = 0;
+
+            std::chrono::steady_clock::time_point start_time;
+            std::chrono::steady_clock::time_point end_time;
+        };
+
+        // DAG of a single update group. Nodes are stored in topological order.
+        struct TaskGraph
+        {
+            std::string group;
+            bool main_thread = true;
+
+            std::vector<std::unique_ptr<TaskNode>> nodes;
+            std::vector<uint32> roots;
+
             float dt = 0.0f;
+            JobQueue* job_queue = nullptr;
+        JobQueue* fixed_job_queue = nullptr;
+            JobHandle group_job;
+            std::chrono::steady_clock::time_point start_time;
+        };
+
+        struct TaskJobData
+        {
+            WorldSystemScheduler* scheduler;
+            TaskGraph* graph;
+            uint32 node_index;
         };
 
-        void normal_worker();
+        static void task_job(TaskJobData& data, JobHandle job);
 
-        void fixed_worker();
-     
         void fixed_update_loop();
 
-        std::unordered_map<std::string, std::vector<ref<Task>>> build_task_order(UpdateType type);
+        void run_update(std::vector<ref<TaskGraph>>& graphs, float dt, std::vector<UpdateGroupTiming>& timings);
 
-        void add_task(ref<Task> task, UpdateType type);
+        void start_graph(TaskGraph& graph, float dt);
 
-        std::vector<std::thread> normal_thread_pool;
-        std::queue<TaskItem> normal_task_queue;
+        void submit_node(TaskGraph& graph, uint32 node_index);
 
-        std::atomic<int> active_fixed_tasks = 0;
-        std::condition_variable tasks_done_cv;
+        void run_node(TaskGraph& graph, uint32 node_index);
 
-        std::vector<std::thread> fixed_thread_pool;
-        std::queue<TaskItem> fixed_task_queue;
+        UpdateGroupTiming collect_timing(const TaskGraph& graph) const;
+
+        std::unordered_map<std::string, std::vector<ref<Task>>> build_task_order(UpdateType type);
+
+        std::vector<ref<TaskGraph>> build_task_graphs(UpdateType type);
+
+        void add_task(ref<Task> task, UpdateType type);
+
+        JobQueue* job_queue = nullptr;
 
-        std::mutex queue_mutex;
-        std::condition_variable normal_condition;
-        std::condition_variable fixed_condition;
         std::atomic<bool> running = false;
 
         std::thread fixed_update_thread;
@@ -108,14 +172,19 @@ namespace era_engine
 
         std::unordered_map<std::string, ref<Task>> tasks;
         std::unordered_map<std::string, std::vector<std::string>> adj_list;
-        std::unordered_map<std::string, int> in_degree;
 
         std::unordered_map<std::string, ref<Task>> fixed_tasks;
         std::unordered_map<std::string, std::vector<std::string>> fixed_adj_list;
-        std::unordered_map<std::string, int> fixed_in_degree;
 
-        std::unordered_map<std::string, std::vector<ref<Task>>> grouped_ordered_tasks;
-        std::unordered_map<std::string, std::vector<ref<Task>>> fixed_grouped_ordered_tasks;
+        // Each graph set is only touched by the thread running its update, refresh_graph() just marks them dirty.
+        std::vector<ref<TaskGraph>> normal_graphs;
+        std::vector<ref<TaskGraph>> fixed_graphs;
+        std::atomic<bool> normal_graphs_dirty = false;
+        std::atomic<bool> fixed_graphs_dirty = false;
+
+        std::vector<UpdateGroupTiming> normal_timings;
+        std::vector<UpdateGroupTiming> fixed_timings;
+        mutable std::mutex timings_mutex;
 
         World* world = nullptr;
         bool inited = false;
@@ -4,6 +4,7 @@
 #include "core/imgui.h"
 #include "core/cpu_profiling.h"
 #include "core/job_system.h"
+#include "core/frame_allocator.h"
 #include "core/debug/debug_var_storage.h"
 
 #include "dx/dx_context.h"
@@ -233,6 +234,7 @@ namespace era_engine
 			{
 				ZoneScopedN("Engine::start_frame");
 				status = newFrame(dt, *window);
+				frame_allocator.begin_frame();
 			}
 
 			uint64 gameplay_fixed_frame_id = 0;
@@ -275,6 +277,8 @@ namespace era_engine
 				renderToMainWindow(*window);
 			}
 
+			report_job_system_stats();
+			report_frame_allocator_stats();
 			cpu_profiling_frame_end_marker();
 
 			++frameID;
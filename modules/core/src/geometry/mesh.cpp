@@ -49,7 +49,18 @@ namespace era_engine
 		result->aabb = bounding_box::negativeInfinity();
 
 		ModelAsset asset = load_3d_model_from_file(sceneFilename);
-		mesh_builder builder(flags | mesh_creation_flags_with_skin);
+
+		// Importers only emit 32-bit indices for submeshes which don't fit into 16 bits.
+		bool needs32BitIndices = false;
+		for (const MeshAsset& mesh : asset.meshes)
+		{
+			for (const SubmeshAsset& sub : mesh.submeshes)
+			{
+				needs32BitIndices |= !sub.triangles32.empty();
+			}
+		}
+
+		mesh_builder builder(flags | mesh_creation_flags_with_skin, needs32BitIndices ? mesh_index_uint32 : mesh_index_uint16);
 
 		for (auto& mesh : asset.meshes)
 		{
@@ -1249,11 +1249,12 @@ namespace era_engine
 	void mesh_builder::pushMesh(const SubmeshAsset& mesh, float scale, bounding_box* aabb)
 	{
 		uint32 numVertices = (uint32)mesh.positions.size();
-		uint32 numFaces = (uint32)mesh.triangles.size();
+		uint32 numFaces = mesh.get_num_triangles();
 
 		if (indexType == mesh_index_uint16)
 		{
 			ASSERT(numVertices - 1 <= UINT16_MAX);
+			ASSERT(mesh.triangles32.empty());
 		}
 
 		auto [positionPtr, othersPtr, indexPtr, indexOffset] = beginPrimitive(numVertices, numFaces);
@@ -1315,9 +1316,12 @@ namespace era_engine
 		}
 
 		const bool flipWindingOrder = false;
-		for (uint32 i = 0; i < numFaces; ++i)
+		for (const indexed_triangle16& tri : mesh.triangles)
+		{
+			pushTriangle(tri.a, tri.b, tri.c);
+		}
+		for (const indexed_triangle32& tri : mesh.triangles32)
 		{
-			const indexed_triangle16& tri = mesh.triangles[i];
 			pushTriangle(tri.a, tri.b, tri.c);
 		}
 	}
@@ -4,6 +4,8 @@
 
 #include "engine/engine.h"
 
+#include "ecs/world.h"
+
 #include <rttr/registration>
 
 namespace era_engine
@@ -13,12 +15,18 @@ namespace era_engine
 	{
 		using namespace rttr;
 		rttr::registration::class_<RendererHolderRootComponent>("RendererHolderRootComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	RendererHolderRootComponent::RendererHolderRootComponent(ref<Entity::EcsData> _data)
+	RendererHolderRootComponent::RendererHolderRootComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
+		// Worlds without rendering (headless runtime) keep the camera and light settings, but get no renderer and no debug draw pass.
+		if (!get_world()->has_tag("render"))
+		{
+			return;
+		}
+
 		renderer_spec spec;
 		spec.allowObjectPicking = true;
 		spec.allowAO = true;
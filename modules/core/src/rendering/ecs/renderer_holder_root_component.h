@@ -19,7 +19,7 @@ namespace era_engine
 	{
 	public:
 		RendererHolderRootComponent() = default;
-		RendererHolderRootComponent(ref<Entity::EcsData> _data);
+		RendererHolderRootComponent(Entity::EcsData* _data);
 
 		RendererHolderRootComponent(const RendererHolderRootComponent& other) noexcept = default;
 		RendererHolderRootComponent(RendererHolderRootComponent&& other) noexcept = default;
@@ -148,7 +148,7 @@ namespace era_engine
 			.property("shadowMapResolution", &SpotLightComponent::shadowMapResolution);
 	}
 
-	PointLightComponent::PointLightComponent(ref<Entity::EcsData> _data, const vec3& _color, float _intensity, float _radius, bool _castsShadow, uint32 _shadowMapResolution)
+	PointLightComponent::PointLightComponent(Entity::EcsData* _data, const vec3& _color, float _intensity, float _radius, bool _castsShadow, uint32 _shadowMapResolution)
 		: Component(_data), color(_color), intensity(_intensity), radius(_radius), castsShadow(_castsShadow), shadowMapResolution(_shadowMapResolution)
 	{
 	}
@@ -157,7 +157,7 @@ namespace era_engine
 	{
 	}
 
-	SpotLightComponent::SpotLightComponent(ref<Entity::EcsData> _data, const vec3& _color, float _intensity, float _distance, float _innerAngle, float _outerAngle, bool _castsShadow, uint32 _shadowMapResolution)
+	SpotLightComponent::SpotLightComponent(Entity::EcsData* _data, const vec3& _color, float _intensity, float _distance, float _innerAngle, float _outerAngle, bool _castsShadow, uint32 _shadowMapResolution)
 		: Component(_data), color(_color), intensity(_intensity), distance(_distance), innerAngle(_innerAngle), outerAngle(_outerAngle), castsShadow(_castsShadow), shadowMapResolution(_shadowMapResolution)
 
 	{
@@ -51,7 +51,7 @@ namespace era_engine
 	{
 	public:
 		PointLightComponent() = default;
-		PointLightComponent(ref<Entity::EcsData> _data, const vec3& _color, float _intensity, float _radius, bool _castsShadow = false, uint32 _shadowMapResolution = 2048);
+		PointLightComponent(Entity::EcsData* _data, const vec3& _color, float _intensity, float _radius, bool _castsShadow = false, uint32 _shadowMapResolution = 2048);
 		PointLightComponent(const PointLightComponent&) = default;
 		virtual ~PointLightComponent();
 
@@ -71,7 +71,7 @@ namespace era_engine
 	{
 	public:
 		SpotLightComponent() = default;
-		SpotLightComponent(ref<Entity::EcsData> _data, const vec3& _color, float _intensity, float _distance, float _innerAngle, float _outerAngle, bool _castsShadow = false, uint32 _shadowMapResolution = 2048);		
+		SpotLightComponent(Entity::EcsData* _data, const vec3& _color, float _intensity, float _distance, float _innerAngle, float _outerAngle, bool _castsShadow = false, uint32 _shadowMapResolution = 2048);		
 		SpotLightComponent(const SpotLightComponent&) = default;
 		virtual ~SpotLightComponent();
 
@@ -562,11 +562,11 @@ namespace era_engine
 		using namespace rttr;
 		rttr::registration::class_<RaytraceComponent>("RaytraceComponent")
 			.constructor<>()
-			.constructor<ref<Entity::EcsData>, const raytracing_object_type&>()
+			.constructor<Entity::EcsData*, const raytracing_object_type&>()
 			.property("type", &RaytraceComponent::type);
 	}
 
-	RaytraceComponent::RaytraceComponent(ref<Entity::EcsData> _data, const raytracing_object_type& _type)
+	RaytraceComponent::RaytraceComponent(Entity::EcsData* _data, const raytracing_object_type& _type)
 		:  Component(_data), type(_type)
 	{
 	}
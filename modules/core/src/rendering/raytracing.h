@@ -68,7 +68,7 @@ namespace era_engine
 	{
 	public:
 		RaytraceComponent() = default;
-		RaytraceComponent(ref<Entity::EcsData> _data, const raytracing_object_type& _type);
+		RaytraceComponent(Entity::EcsData* _data, const raytracing_object_type& _type);
 		virtual ~RaytraceComponent();
 
 		ERA_VIRTUAL_REFLECT(Component)
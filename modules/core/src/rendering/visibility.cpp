@@ -0,0 +1,549 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#include "rendering/visibility.h"
+
+#include "core/bounding_volumes_simd.h"
+#include "core/job_system.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace era_engine
+{
+#if defined(SIMD_AVX_2)
+	typedef w8_float visibility_float;
+#else
+	typedef w4_float visibility_float;
+#endif
+
+	typedef wN_vec3<visibility_float> visibility_vec3;
+	typedef wN_bounding_box<visibility_float> visibility_box;
+
+	static constexpr uint32 visibility_lanes = sizeof(visibility_float) / sizeof(float);
+
+	// Refitting keeps the topology of the tree, which gets worse the further objects move. Rebuild once the slots have grown
+	// this much in total.
+	static constexpr double visibility_rebuild_cost_ratio = 1.5;
+
+	// Objects per block when writing the visible indices.
+	static constexpr uint32 visibility_block_size = 4096;
+
+	struct visibility_plane
+	{
+		vec4 plane;
+
+		// Whether the corner farthest along the normal (the positive vertex) takes the minimum on an axis.
+		bool negative[3];
+	};
+
+	struct visibility_prepared_view
+	{
+		visibility_plane planes[6];
+		bounding_sphere sphere;
+		bool is_sphere;
+	};
+
+	struct VisibilityBVH::CullContext
+	{
+		const visibility_prepared_view* views;
+		uint64* view_masks;
+	};
+
+	static double get_surface_area(const bounding_box& aabb)
+	{
+		vec3 d = aabb.maxCorner - aabb.minCorner;
+
+		// Empty and unbounded boxes say nothing about the quality of the tree.
+		if (!(d.x >= 0.f && d.y >= 0.f && d.z >= 0.f && d.x <= FLT_MAX && d.y <= FLT_MAX && d.z <= FLT_MAX))
+		{
+			return 0.0;
+		}
+		return 2.0 * ((double)d.x * d.y + (double)d.y * d.z + (double)d.z * d.x);
+	}
+
+	// Bit masks of the lanes which are outside of the view and of those which are completely inside of it. For frustums, this is
+	// the same test as camera_frustum_planes::cullWorldSpaceAABB, so both agree on every box.
+	static void test_view(const visibility_prepared_view& view, const visibility_box& box, int& outside, int& inside)
+	{
+		const visibility_float zero = visibility_float::zero();
+
+		if (view.is_sphere)
+		{
+			const visibility_vec3 center(view.sphere.center.x, view.sphere.center.y, view.sphere.center.z);
+			const visibility_float radius_sq = view.sphere.radius * view.sphere.radius;
+
+			visibility_float near_sq = zero;
+			visibility_float far_sq = zero;
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				const visibility_float to_min = box.minCorner.data[axis] - center.data[axis];
+				const visibility_float to_max = center.data[axis] - box.maxCorner.data[axis];
+
+				const visibility_float near_distance = maximum(maximum(to_min, to_max), zero);
+				const visibility_float far_distance = maximum(zero - to_min, zero - to_max);
+
+				near_sq = near_sq + near_distance * near_distance;
+				far_sq = far_sq + far_distance * far_distance;
+			}
+
+			outside = to_bit_mask(near_sq > radius_sq);
+			inside = to_bit_mask(far_sq <= radius_sq);
+			return;
+		}
+
+		visibility_float min_far_distance;
+		visibility_float min_near_distance;
+		for (uint32 i = 0; i < 6; ++i)
+		{
+			const visibility_plane& p = view.planes[i];
+
+			const visibility_float& far_x = p.negative[0] ? box.minCorner.x : box.maxCorner.x;
+			const visibility_float& far_y = p.negative[1] ? box.minCorner.y : box.maxCorner.y;
+			const visibility_float& far_z = p.negative[2] ? box.minCorner.z : box.maxCorner.z;
+			const visibility_float& near_x = p.negative[0] ? box.maxCorner.x : box.minCorner.x;
+			const visibility_float& near_y = p.negative[1] ? box.maxCorner.y : box.minCorner.y;
+			const visibility_float& near_z = p.negative[2] ? box.maxCorner.z : box.minCorner.z;
+
+			// Same order of operations as dot(plane, vec4(vertex, 1)).
+			const visibility_float far_distance = far_x * p.plane.x + far_y * p.plane.y + far_z * p.plane.z + p.plane.w;
+			const visibility_float near_distance = near_x * p.plane.x + near_y * p.plane.y + near_z * p.plane.z + p.plane.w;
+
+			min_far_distance = (i == 0) ? far_distance : minimum(min_far_distance, far_distance);
+			min_near_distance = (i == 0) ? near_distance : minimum(min_near_distance, near_distance);
+		}
+
+		outside = to_bit_mask(min_far_distance < zero);
+		inside = to_bit_mask(min_near_distance >= zero);
+	}
+
+	VisibilityView VisibilityView::from_frustum(const camera_frustum_planes& frustum)
+	{
+		VisibilityView result;
+		for (uint32 i = 0; i < 6; ++i)
+		{
+			result.planes[i] = frustum.planes[i];
+		}
+		result.is_sphere = false;
+		return result;
+	}
+
+	VisibilityView VisibilityView::from_sphere(const bounding_sphere& sphere)
+	{
+		VisibilityView result;
+		result.sphere = sphere;
+		result.is_sphere = true;
+		return result;
+	}
+
+	void VisibilityBVH::build(const bounding_box* aabbs, uint32 num_objects)
+	{
+		this->num_objects = num_objects;
+		++num_builds;
+
+		nodes.clear();
+		object_nodes.resize(num_objects);
+		object_slots.resize(num_objects);
+		cost = 0.0;
+
+		if (num_objects > 0)
+		{
+			std::vector<uint32> objects(num_objects);
+			std::iota(objects.begin(), objects.end(), 0);
+
+			std::vector<vec3> centers(num_objects);
+			for (uint32 i = 0; i < num_objects; ++i)
+			{
+				centers[i] = aabbs[i].getCenter();
+			}
+
+			nodes.reserve(num_objects / (WIDTH / 2) + 1);
+			build_node(objects.data(), num_objects, aabbs, centers.data(), -1, 0);
+		}
+
+		built_cost = cost;
+		dirty_nodes.assign(nodes.size(), 0);
+	}
+
+	uint32 VisibilityBVH::build_node(uint32* objects, uint32 count, const bounding_box* aabbs, const vec3* centers, int32 parent, uint32 parent_slot)
+	{
+		const uint32 index = (uint32)nodes.size();
+
+		{
+			Node& node = nodes.emplace_back();
+			node.parent = parent;
+			node.parent_slot = parent_slot;
+			node.num_children = 0;
+
+			// Unused slots are empty boxes, which no view can see.
+			const bounding_box empty = bounding_box::negativeInfinity();
+			for (uint32 slot = 0; slot < WIDTH; ++slot)
+			{
+				node.min_x[slot] = empty.minCorner.x;
+				node.min_y[slot] = empty.minCorner.y;
+				node.min_z[slot] = empty.minCorner.z;
+				node.max_x[slot] = empty.maxCorner.x;
+				node.max_y[slot] = empty.maxCorner.y;
+				node.max_z[slot] = empty.maxCorner.z;
+				node.children[slot] = 0;
+			}
+		}
+
+		// Split the objects into up to WIDTH ranges, always halving the largest range at the median along the longest axis of
+		// its centers. Ranges are only split while they hold more objects than a full subtree one level down, so that nodes
+		// near the leaves are not left half empty. Eight or fewer objects end up in a slot each.
+		uint32 subtree_capacity = 1;
+		while (subtree_capacity * WIDTH < count)
+		{
+			subtree_capacity *= WIDTH;
+		}
+
+		uint32 range_begin[WIDTH] = { 0 };
+		uint32 range_count[WIDTH] = { count };
+		uint32 num_ranges = 1;
+
+		while (num_ranges < WIDTH)
+		{
+			uint32 largest = 0;
+			for (uint32 r = 1; r < num_ranges; ++r)
+			{
+				if (range_count[r] > range_count[largest])
+				{
+					largest = r;
+				}
+			}
+
+			if (range_count[largest] <= subtree_capacity)
+			{
+				break;
+			}
+
+			uint32* begin = objects + range_begin[largest];
+			uint32* end = begin + range_count[largest];
+
+			bounding_box center_bounds = bounding_box::negativeInfinity();
+			for (uint32* object = begin; object != end; ++object)
+			{
+				center_bounds.grow(centers[*object]);
+			}
+
+			const vec3 extent = center_bounds.maxCorner - center_bounds.minCorner;
+			const uint32 axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z) ? 1 : 2;
+
+			const uint32 half = range_count[largest] / 2;
+			std::nth_element(begin, begin + half, end, [centers, axis](uint32 a, uint32 b)
+				{
+					return centers[a].data[axis] < centers[b].data[axis];
+				});
+
+			range_begin[num_ranges] = range_begin[largest] + half;
+			range_count[num_ranges] = range_count[largest] - half;
+			range_count[largest] = half;
+			++num_ranges;
+		}
+
+		nodes[index].num_children = num_ranges;
+
+		for (uint32 r = 0; r < num_ranges; ++r)
+		{
+			if (range_count[r] == 1)
+			{
+				const uint32 object = objects[range_begin[r]];
+				nodes[index].children[r] = ~(int32)object;
+				object_nodes[object] = index;
+				object_slots[object] = (uint8)r;
+
+				set_slot_bounds(index, r, aabbs[object]);
+			}
+			else
+			{
+				// Recursion may reallocate the nodes, so no reference is held across it.
+				const uint32 child = build_node(objects + range_begin[r], range_count[r], aabbs, centers, (int32)index, r);
+				nodes[index].children[r] = (int32)child;
+
+				set_slot_bounds(index, r, get_node_bounds(child));
+			}
+		}
+
+		return index;
+	}
+
+	bounding_box VisibilityBVH::get_node_bounds(uint32 index) const
+	{
+		const Node& node = nodes[index];
+
+		// Empty children (hidden objects) are skipped. Growing by their inverted corners would make the box span everything,
+		// all the way up to the root.
+		bounding_box result = bounding_box::negativeInfinity();
+		for (uint32 slot = 0; slot < node.num_children; ++slot)
+		{
+			if (node.min_x[slot] > node.max_x[slot] || node.min_y[slot] > node.max_y[slot] || node.min_z[slot] > node.max_z[slot])
+			{
+				continue;
+			}
+
+			result.minCorner = min(result.minCorner, vec3(node.min_x[slot], node.min_y[slot], node.min_z[slot]));
+			result.maxCorner = max(result.maxCorner, vec3(node.max_x[slot], node.max_y[slot], node.max_z[slot]));
+		}
+		return result;
+	}
+
+	bounding_box VisibilityBVH::get_bounds() const
+	{
+		return nodes.empty() ? bounding_box::negativeInfinity() : get_node_bounds(0);
+	}
+
+	void VisibilityBVH::set_slot_bounds(uint32 index, uint32 slot, const bounding_box& aabb)
+	{
+		Node& node = nodes[index];
+
+		const bounding_box old_aabb =
+		{
+			vec3(node.min_x[slot], node.min_y[slot], node.min_z[slot]),
+			vec3(node.max_x[slot], node.max_y[slot], node.max_z[slot]),
+		};
+		cost += get_surface_area(aabb) - get_surface_area(old_aabb);
+
+		node.min_x[slot] = aabb.minCorner.x;
+		node.min_y[slot] = aabb.minCorner.y;
+		node.min_z[slot] = aabb.minCorner.z;
+		node.max_x[slot] = aabb.maxCorner.x;
+		node.max_y[slot] = aabb.maxCorner.y;
+		node.max_z[slot] = aabb.maxCorner.z;
+	}
+
+	void VisibilityBVH::update(const bounding_box* aabbs, const uint32* changed_indices, uint32 num_changed)
+	{
+		if (num_changed == 0)
+		{
+			return;
+		}
+
+		if (num_changed * 4 > num_objects)
+		{
+			build(aabbs, num_objects);
+			return;
+		}
+
+		uint32 last_dirty_node = 0;
+		for (uint32 i = 0; i < num_changed; ++i)
+		{
+			const uint32 object = changed_indices[i];
+			ASSERT(object < num_objects);
+
+			const uint32 node = object_nodes[object];
+			set_slot_bounds(node, object_slots[object], aabbs[object]);
+
+			dirty_nodes[node] = 1;
+			last_dirty_node = max(last_dirty_node, node);
+		}
+
+		// Children always come after their parent, so one backwards sweep refits every node before its parent.
+		for (int32 node = (int32)last_dirty_node; node >= 0; --node)
+		{
+			if (!dirty_nodes[node])
+			{
+				continue;
+			}
+			dirty_nodes[node] = 0;
+
+			const int32 parent = nodes[node].parent;
+			if (parent < 0)
+			{
+				continue;
+			}
+
+			const uint32 slot = nodes[node].parent_slot;
+			const bounding_box aabb = get_node_bounds(node);
+
+			const Node& parent_node = nodes[parent];
+			if (aabb.minCorner.x != parent_node.min_x[slot] || aabb.minCorner.y != parent_node.min_y[slot] || aabb.minCorner.z != parent_node.min_z[slot] ||
+				aabb.maxCorner.x != parent_node.max_x[slot] || aabb.maxCorner.y != parent_node.max_y[slot] || aabb.maxCorner.z != parent_node.max_z[slot])
+			{
+				set_slot_bounds(parent, slot, aabb);
+				dirty_nodes[parent] = 1;
+			}
+		}
+
+		if (built_cost > 0.0 && cost > built_cost * visibility_rebuild_cost_ratio)
+		{
+			build(aabbs, num_objects);
+		}
+	}
+
+	void VisibilityBVH::cull_node(const CullEntry& entry, const CullContext& context, std::vector<CullEntry>& out_entries) const
+	{
+		const Node& node = nodes[entry.node];
+
+		uint64 child_active_views[WIDTH] = {};
+		uint64 child_accepted_views[WIDTH];
+		for (uint32 slot = 0; slot < WIDTH; ++slot)
+		{
+			child_accepted_views[slot] = entry.accepted_views;
+		}
+
+		if (entry.active_views)
+		{
+			for (uint32 first_slot = 0; first_slot < node.num_children; first_slot += visibility_lanes)
+			{
+				const visibility_box box = visibility_box::fromMinMax(
+					visibility_vec3(visibility_float(node.min_x + first_slot), visibility_float(node.min_y + first_slot), visibility_float(node.min_z + first_slot)),
+					visibility_vec3(visibility_float(node.max_x + first_slot), visibility_float(node.max_y + first_slot), visibility_float(node.max_z + first_slot)));
+
+				for (uint64 views = entry.active_views; views; views &= views - 1)
+				{
+					const uint32 view = (uint32)std::countr_zero(views);
+					const uint64 view_bit = 1ull << view;
+
+					int outside, inside;
+					test_view(context.views[view], box, outside, inside);
+
+					for (uint32 lanes = ~(uint32)outside & ((1u << visibility_lanes) - 1); lanes; lanes &= lanes - 1)
+					{
+						const uint32 lane = (uint32)std::countr_zero(lanes);
+						uint64* views_of_slot = (inside & (1 << lane)) ? child_accepted_views : child_active_views;
+						views_of_slot[first_slot + lane] |= view_bit;
+					}
+				}
+			}
+		}
+
+		for (uint32 slot = 0; slot < node.num_children; ++slot)
+		{
+			const uint64 visible_views = child_active_views[slot] | child_accepted_views[slot];
+			if (!visible_views)
+			{
+				continue;
+			}
+
+			const int32 child = node.children[slot];
+			if (child < 0)
+			{
+				context.view_masks[~child] = visible_views;
+			}
+			else
+			{
+				out_entries.push_back(CullEntry{ (uint32)child, child_active_views[slot], child_accepted_views[slot] });
+			}
+		}
+	}
+
+	void VisibilityBVH::cull(const VisibilityView* views, uint32 num_views, VisibilityResult& result) const
+	{
+		ASSERT(num_views <= MAX_VIEWS);
+
+		result.view_offsets.assign(num_views + 1, 0);
+		result.visible_indices.clear();
+
+		if (num_objects == 0 || num_views == 0)
+		{
+			return;
+		}
+
+		visibility_prepared_view prepared_views[MAX_VIEWS];
+		for (uint32 v = 0; v < num_views; ++v)
+		{
+			visibility_prepared_view& prepared = prepared_views[v];
+			prepared.is_sphere = views[v].is_sphere;
+			prepared.sphere = views[v].sphere;
+			for (uint32 i = 0; i < 6; ++i)
+			{
+				const vec4& plane = views[v].planes[i];
+				prepared.planes[i] = visibility_plane{ plane, { plane.x < 0.f, plane.y < 0.f, plane.z < 0.f } };
+			}
+		}
+
+		result.view_masks.resize(num_objects);
+		std::fill(result.view_masks.begin(), result.view_masks.end(), 0);
+
+		const CullContext context = { prepared_views, result.view_masks.data() };
+
+		// Walk the top of the tree on this thread until there are enough subtrees to keep all workers busy, then finish each
+		// subtree in its own job.
+		const uint32 num_jobs_target = 4 * (high_priority_job_queue.get_num_threads() + 1);
+		const uint64 all_views = (num_views == 64) ? ~0ull : ((1ull << num_views) - 1);
+
+		std::vector<CullEntry> entries = { CullEntry{ 0, all_views, 0 } };
+		std::vector<CullEntry> next_entries;
+		while (!entries.empty() && entries.size() < num_jobs_target)
+		{
+			next_entries.clear();
+			for (const CullEntry& entry : entries)
+			{
+				cull_node(entry, context, next_entries);
+			}
+			entries.swap(next_entries);
+		}
+
+		parallel_for(0, (uint32)entries.size(), 1, [&](uint32 begin, uint32 end)
+			{
+				std::vector<CullEntry> stack;
+				stack.reserve(64);
+
+				for (uint32 i = begin; i < end; ++i)
+				{
+					stack.push_back(entries[i]);
+					while (!stack.empty())
+					{
+						const CullEntry entry = stack.back();
+						stack.pop_back();
+						cull_node(entry, context, stack);
+					}
+				}
+			});
+
+		// Turn the masks into index lists: count per block and view, assign each block its write offsets, then write. Blocks
+		// are written in order, so the indices of each view come out ascending.
+		const uint32 num_blocks = (num_objects + visibility_block_size - 1) / visibility_block_size;
+		result.block_offsets.resize(num_blocks * num_views);
+
+		auto for_each_visible = [&](uint32 block, auto&& func)
+			{
+				const uint32 first_object = block * visibility_block_size;
+				const uint32 last_object = min(first_object + visibility_block_size, num_objects);
+				for (uint32 object = first_object; object < last_object; ++object)
+				{
+					for (uint64 mask = result.view_masks[object]; mask; mask &= mask - 1)
+					{
+						func(object, (uint32)std::countr_zero(mask));
+					}
+				}
+			};
+
+		parallel_for(0, num_blocks, 1, [&](uint32 begin, uint32 end)
+			{
+				for (uint32 block = begin; block < end; ++block)
+				{
+					uint32* counts = result.block_offsets.data() + block * num_views;
+					std::fill(counts, counts + num_views, 0);
+					for_each_visible(block, [counts](uint32 object, uint32 view) { ++counts[view]; });
+				}
+			});
+
+		uint32 offset = 0;
+		for (uint32 v = 0; v < num_views; ++v)
+		{
+			result.view_offsets[v] = offset;
+			for (uint32 block = 0; block < num_blocks; ++block)
+			{
+				uint32& block_offset = result.block_offsets[block * num_views + v];
+				const uint32 count = block_offset;
+				block_offset = offset;
+				offset += count;
+			}
+		}
+		result.view_offsets[num_views] = offset;
+
+		result.visible_indices.resize(offset);
+
+		parallel_for(0, num_blocks, 1, [&](uint32 begin, uint32 end)
+			{
+				for (uint32 block = begin; block < end; ++block)
+				{
+					uint32* offsets = result.block_offsets.data() + block * num_views;
+					uint32* visible_indices = result.visible_indices.data();
+					for_each_visible(block, [offsets, visible_indices](uint32 object, uint32 view) { visible_indices[offsets[view]++] = object; });
+				}
+			});
+	}
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2023-present Eldar Muradov. All rights reserved.
+
+#pragma once
+
+#include "core_api.h"
+
+#include "core/math.h"
+#include "core/bounding_volumes.h"
+#include "core/camera.h"
+
+namespace era_engine
+{
+	// One view to cull against: a camera or shadow frustum, or the sphere of a point light.
+	struct ERA_CORE_API VisibilityView
+	{
+		static VisibilityView from_frustum(const camera_frustum_planes& frustum);
+		static VisibilityView from_sphere(const bounding_sphere& sphere);
+
+		vec4 planes[6];
+		bounding_sphere sphere;
+		bool is_sphere = false;
+	};
+
+	// Indices of the visible objects, ascending, one range per view.
+	struct ERA_CORE_API VisibilityResult
+	{
+		NODISCARD const uint32* get_visible_indices(uint32 view) const { return visible_indices.data() + view_offsets[view]; }
+		NODISCARD uint32 get_num_visible(uint32 view) const { return view_offsets[view + 1] - view_offsets[view]; }
+
+		std::vector<uint32> visible_indices;
+		std::vector<uint32> view_offsets;
+
+		// Scratch memory, kept to avoid reallocating every frame. Per object, one bit per view it is visible in, and the
+		// per view write offsets of each block of objects.
+		std::vector<uint64> view_masks;
+		std::vector<uint32> block_offsets;
+	};
+
+	// Hierarchy of world-space AABBs with eight children per node, whose bounds are stored as SIMD lanes. A cull tests the
+	// eight children of a node against every view at once and walks the tree a single time for all views. Views a subtree
+	// lies completely inside of are not tested again below it.
+	// Objects are referred to by their index into the AABB array given to build() and update(). Objects which should never be
+	// visible can be given bounding_box::negativeInfinity(), objects which should always be visible bounding_box::everything().
+	class ERA_CORE_API VisibilityBVH
+	{
+	public:
+		static constexpr uint32 MAX_VIEWS = 64;
+
+		void build(const bounding_box* aabbs, uint32 num_objects);
+
+		// Writes the new bounds of the changed objects and refits the nodes above them. Once refitting has made the tree too
+		// loose, or too many objects have changed for refitting to pay off, the tree is rebuilt from 'aabbs' instead.
+		void update(const bounding_box* aabbs, const uint32* changed_indices, uint32 num_changed);
+
+		// Runs in parallel on the high priority job queue. Must not overlap with build() or update().
+		void cull(const VisibilityView* views, uint32 num_views, VisibilityResult& result) const;
+
+		NODISCARD uint32 get_num_objects() const { return num_objects; }
+		NODISCARD uint32 get_num_nodes() const { return (uint32)nodes.size(); }
+		NODISCARD uint32 get_num_builds() const { return num_builds; }
+
+		// Union of all visible objects, negativeInfinity() if there are none.
+		NODISCARD bounding_box get_bounds() const;
+
+	private:
+		static constexpr uint32 WIDTH = 8;
+
+		struct alignas(32) Node
+		{
+			float min_x[WIDTH];
+			float min_y[WIDTH];
+			float min_z[WIDTH];
+			float max_x[WIDTH];
+			float max_y[WIDTH];
+			float max_z[WIDTH];
+
+			// Node index if positive, ~object index if negative.
+			int32 children[WIDTH];
+
+			int32 parent;
+			uint32 parent_slot;
+			uint32 num_children;
+		};
+
+		struct CullEntry
+		{
+			uint32 node;
+
+			// Views which still have to be tested and views which the node is completely inside of.
+			uint64 active_views;
+			uint64 accepted_views;
+		};
+
+		struct CullContext;
+
+		uint32 build_node(uint32* objects, uint32 count, const bounding_box* aabbs, const vec3* centers, int32 parent, uint32 parent_slot);
+
+		bounding_box get_node_bounds(uint32 node) const;
+		void set_slot_bounds(uint32 node, uint32 slot, const bounding_box& aabb);
+
+		// Tests the children of a node, writes the view masks of child objects and pushes the child nodes still visible.
+		void cull_node(const CullEntry& entry, const CullContext& context, std::vector<CullEntry>& out_entries) const;
+
+		std::vector<Node> nodes;
+
+		// Where each object sits in the tree.
+		std::vector<uint32> object_nodes;
+		std::vector<uint8> object_slots;
+
+		std::vector<uint8> dirty_nodes;
+
+		uint32 num_objects = 0;
+		uint32 num_builds = 0;
+
+		// Sum of the surface areas of all slots, right after the last build and now. Grows as refitting loosens the tree.
+		double built_cost = 0.0;
+		double cost = 0.0;
+	};
+}
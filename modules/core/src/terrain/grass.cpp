@@ -330,11 +330,11 @@ namespace era_engine
 		using namespace rttr;
 		rttr::registration::class_<GrassComponent>("GrassComponent")
 			.constructor<>()
-			.constructor<ref<Entity::EcsData>, const grass_settings&>()
+			.constructor<Entity::EcsData*, const grass_settings&>()
 			.property("settings", &GrassComponent::settings);
 	}
 
-	GrassComponent::GrassComponent(ref<Entity::EcsData> _data, const grass_settings& _settings)
+	GrassComponent::GrassComponent(Entity::EcsData* _data, const grass_settings& _settings)
 		: Component(_data), settings(_settings)
 	{
 		uint32 num_vertices_LOD0 = numSegmentsLOD0 * 2 + 1;
@@ -31,7 +31,7 @@ namespace era_engine
 	{
 	public:
 		GrassComponent() = default;
-		GrassComponent(ref<Entity::EcsData> _data, const grass_settings& _settings = {});
+		GrassComponent(Entity::EcsData* _data, const grass_settings& _settings = {});
 		virtual ~GrassComponent();
 
 		void generate(struct compute_pass* compute_pass, const render_camera& camera, const TerrainComponent& terrain, vec3 position_offset, float dt);
@@ -108,11 +108,11 @@ namespace era_engine
 		using namespace rttr;
 		rttr::registration::class_<ProcPlacementComponent>("ProcPlacementComponent")
 			.constructor<>()
-			.constructor<ref<Entity::EcsData>, const std::vector<proc_placement_layer_desc>&>()
+			.constructor<Entity::EcsData*, const std::vector<proc_placement_layer_desc>&>()
 			.property("layers", &ProcPlacementComponent::layers);
 	}
 
-	ProcPlacementComponent::ProcPlacementComponent(ref<Entity::EcsData> _data, const std::vector<proc_placement_layer_desc>& _layers)
+	ProcPlacementComponent::ProcPlacementComponent(Entity::EcsData* _data, const std::vector<proc_placement_layer_desc>& _layers)
 		: Component(_data)
 	{
 		std::vector<placement_draw> drawArgs;
@@ -21,7 +21,7 @@ namespace era_engine
 	{
 	public:
 		ProcPlacementComponent() = default;
-		ProcPlacementComponent(ref<Entity::EcsData> _data, const std::vector<proc_placement_layer_desc>& _layers);
+		ProcPlacementComponent(Entity::EcsData* _data, const std::vector<proc_placement_layer_desc>& _layers);
 		virtual ~ProcPlacementComponent();
 
 		void generate(const render_camera& camera, const TerrainComponent& terrain, const vec3& position_offset);
@@ -430,7 +430,7 @@ namespace era_engine
 			.property("genSettings", &TerrainComponent::genSettings);
 	}
 
-	TerrainComponent::TerrainComponent(ref<Entity::EcsData> _data, uint32 _chunks_per_dim, float _chunk_size, float _amplitude_scale, ref<pbr_material> ground_material, ref<pbr_material> rock_material, ref<pbr_material> _mud_material, const terrain_generation_settings& _gen_settings)
+	TerrainComponent::TerrainComponent(Entity::EcsData* _data, uint32 _chunks_per_dim, float _chunk_size, float _amplitude_scale, ref<pbr_material> ground_material, ref<pbr_material> rock_material, ref<pbr_material> _mud_material, const terrain_generation_settings& _gen_settings)
 		: Component(_data),
 		chunksPerDim(_chunks_per_dim),
 		chunkSize(_chunk_size),
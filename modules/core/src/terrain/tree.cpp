@@ -129,11 +129,11 @@ namespace era_engine
         using namespace rttr;
         rttr::registration::class_<TreeComponent>("TreeComponent")
             .constructor<>()
-            .constructor<ref<Entity::EcsData>, const tree_settings&>()
+            .constructor<Entity::EcsData*, const tree_settings&>()
             .property("settings", &TreeComponent::settings);
     }
 
-    TreeComponent::TreeComponent(ref<Entity::EcsData> _data, const tree_settings& _settings)
+    TreeComponent::TreeComponent(Entity::EcsData* _data, const tree_settings& _settings)
        : Component(_data), settings(_settings)
     {
     }
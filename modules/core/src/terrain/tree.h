@@ -23,7 +23,7 @@ namespace era_engine
 	{
 	public:
 		TreeComponent() = default;
-		TreeComponent(ref<Entity::EcsData> _data, const tree_settings& _settings);
+		TreeComponent(Entity::EcsData* _data, const tree_settings& _settings);
 		virtual ~TreeComponent();
 
 		ERA_VIRTUAL_REFLECT(Component)
@@ -111,11 +111,11 @@ namespace era_engine
 		using namespace rttr;
 		rttr::registration::class_<WaterComponent>("WaterComponent")
 			.constructor<>()
-			.constructor<ref<Entity::EcsData>, const water_settings&>()
+			.constructor<Entity::EcsData*, const water_settings&>()
 			.property("settings", &WaterComponent::settings);
 	}
 
-	WaterComponent::WaterComponent(ref<Entity::EcsData> _data, const water_settings& _settings)
+	WaterComponent::WaterComponent(Entity::EcsData* _data, const water_settings& _settings)
 		: Component(_data), settings(_settings)
 	{
 	}
@@ -15,7 +15,7 @@ namespace era_engine::physics
 	public:
 		AggregateHolderComponent() = default;
 
-		AggregateHolderComponent(ref<Entity::EcsData> _data);
+		AggregateHolderComponent(Entity::EcsData* _data);
 		~AggregateHolderComponent() override;
 
 		bool enable_self_collision = true;
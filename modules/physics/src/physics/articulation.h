@@ -43,7 +43,7 @@ namespace era_engine::physics
 		};
 
 		ArticulationComponent() = default;
-		ArticulationComponent(ref<Entity::EcsData> _data, const ArticulationComponentDescriptor& _descriptor = {});
+		ArticulationComponent(Entity::EcsData* _data, const ArticulationComponentDescriptor& _descriptor = {});
 		~ArticulationComponent() override;
 
 		void apply_cache(ArticulationCacheFlags flags = ArticulationCacheFlags::ALL, physx::PxArticulationCache* in_cache = nullptr);
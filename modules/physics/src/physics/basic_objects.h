@@ -15,7 +15,7 @@ namespace era_engine::physics
 	{
 	public:
 		PlaneComponent() = default;
-		PlaneComponent(ref<Entity::EcsData> _data, CollisionType _collision_type, const vec3& _point, const vec3& _norm = vec3(0.0f, 1.0f, 0.0f));
+		PlaneComponent(Entity::EcsData* _data, CollisionType _collision_type, const vec3& _point, const vec3& _norm = vec3(0.0f, 1.0f, 0.0f));
 		~PlaneComponent() override;
 
 		ERA_VIRTUAL_REFLECT(Component)
@@ -66,7 +66,7 @@ namespace era_engine::physics
 	{
 	public:
 		BodyComponent() = default;
-		BodyComponent(ref<Entity::EcsData> _data);
+		BodyComponent(Entity::EcsData* _data);
 		~BodyComponent() override;
 
 		physx::PxRigidActor* get_rigid_actor() const;
@@ -91,7 +91,7 @@ namespace era_engine::physics
 	{
 	public:
 		DynamicBodyComponent() = default;
-		DynamicBodyComponent(ref<Entity::EcsData> _data);
+		DynamicBodyComponent(Entity::EcsData* _data);
 		~DynamicBodyComponent() override;
 
 		physx::PxRigidDynamic* get_rigid_dynamic() const;
@@ -144,7 +144,7 @@ namespace era_engine::physics
 	{
 	public:
 		StaticBodyComponent() = default;
-		StaticBodyComponent(ref<Entity::EcsData> _data);
+		StaticBodyComponent(Entity::EcsData* _data);
 		~StaticBodyComponent() override;
 
 		physx::PxRigidStatic* get_rigid_static() const;
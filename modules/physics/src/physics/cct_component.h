@@ -41,7 +41,7 @@ namespace era_engine::physics
         };
 
         CharacterControllerComponent() = default;
-        CharacterControllerComponent(ref<Entity::EcsData> _data);
+        CharacterControllerComponent(Entity::EcsData* _data);
         ~CharacterControllerComponent() override;
 
         ObservableMember<CollisionType> collision_type = CollisionType::NONE;
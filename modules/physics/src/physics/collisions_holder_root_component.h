@@ -14,7 +14,7 @@ namespace era_engine::physics
 	{
 	public:
 		CollisionsHolderRootComponent() = default;
-		CollisionsHolderRootComponent(ref<Entity::EcsData> _data);
+		CollisionsHolderRootComponent(Entity::EcsData* _data);
 
 		void set_collision_filter(uint32 type, uint32 types_to_collide_with, bool collide);
 		uint32 get_collision_filter(uint32 types) const;
@@ -19,8 +19,8 @@ namespace era_engine::physics
 		static physx::PxRigidDynamic* create_rigid_dynamic(const physx::PxTransform& transform, void* user_data);
 		static physx::PxRigidStatic* create_rigid_static(const physx::PxTransform& transform, void* user_data);
 
-		static BodyComponent* get_body_component(ref<Entity::EcsData> entity_data);
-		static BodyComponent* get_body_component(weakref<Entity::EcsData> entity_data);
+		static BodyComponent* get_body_component(Entity::EcsData* entity_data);
+		static BodyComponent* get_body_component(const EntityPtr& entity_ptr);
 		static BodyComponent* get_body_component(Entity entity);
 
 		static void manual_update_mass(DynamicBodyComponent* dynamic_body_component);
@@ -107,19 +107,19 @@ namespace era_engine::physics
 		return actor;
 	}
 
-	BodyComponent* PhysicsUtils::get_body_component(ref<Entity::EcsData> entity_data)
+	BodyComponent* PhysicsUtils::get_body_component(Entity::EcsData* entity_data)
 	{
 		return get_body_component(Entity(entity_data));
 	}
 
-	BodyComponent* PhysicsUtils::get_body_component(weakref<Entity::EcsData> entity_data)
+	BodyComponent* PhysicsUtils::get_body_component(const EntityPtr& entity_ptr)
 	{
-		if (entity_data.expired())
+		if (entity_ptr.is_empty())
 		{
 			return nullptr;
 		}
 
-		return get_body_component(Entity(entity_data.lock()));
+		return get_body_component(entity_ptr.get());
 	}
 
 	BodyComponent* PhysicsUtils::get_body_component(Entity entity)
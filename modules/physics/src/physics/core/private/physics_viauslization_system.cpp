@@ -39,7 +39,7 @@ namespace era_engine::physics
 	{
 		using namespace physx;
 
-		if (!visualize_shapes)
+		if (!visualize_shapes || renderer_holder_rc->ldrRenderPass == nullptr)
 		{
 			return;
 		}
@@ -248,10 +248,9 @@ namespace era_engine::physics
 				continue;
 			}
 
-			if (ref<Entity::EcsData> reference_data = shape_component->entity_reference.lock())
+			Entity referenced_entity = shape_component->entity_reference.get();
+			if (referenced_entity.is_valid())
 			{
-				Entity referenced_entity = world->get_entity(reference_data->entity_handle);
-
 				const SkeletonComponent* skeleton_component = referenced_entity.get_component_if_exists<SkeletonComponent>();
 				if (skeleton_component == nullptr)
 				{
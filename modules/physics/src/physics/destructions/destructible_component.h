@@ -14,7 +14,7 @@ namespace era_engine::physics
 	{
 	public:
 		DestructibleComponent() = default;
-		DestructibleComponent(ref<Entity::EcsData> _data, uint32 _health = 100, bool _is_root = true);
+		DestructibleComponent(Entity::EcsData* _data, uint32 _health = 100, bool _is_root = true);
 		~DestructibleComponent() override;
 
 	protected:
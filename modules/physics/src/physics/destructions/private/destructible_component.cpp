@@ -11,7 +11,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	DestructibleComponent::DestructibleComponent(ref<Entity::EcsData> _data, uint32 _health, bool _is_root)
+	DestructibleComponent::DestructibleComponent(Entity::EcsData* _data, uint32 _health, bool _is_root)
 		: Component(_data)
 		, health(_health)
 		, is_root(_is_root)
@@ -36,7 +36,7 @@ namespace era_engine::physics
 		};
 
 		JointComponent() = default;
-		JointComponent(ref<Entity::EcsData> _data, const BaseDescriptor& _base_descriptor);
+		JointComponent(Entity::EcsData* _data, const BaseDescriptor& _base_descriptor);
 
 		~JointComponent() override;
 
@@ -75,7 +75,7 @@ namespace era_engine::physics
 	{
 	public:
 		FixedJointComponent() = default;
-		FixedJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor);
+		FixedJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor);
 		~FixedJointComponent() override;
 
 		ERA_VIRTUAL_REFLECT(JointComponent)
@@ -85,7 +85,7 @@ namespace era_engine::physics
 	{
 	public:
 		RevoluteJointComponent() = default;
-		RevoluteJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor);
+		RevoluteJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor);
 		~RevoluteJointComponent() override;
 
 		ObservableMember<bool> enable_drive = false;
@@ -104,7 +104,7 @@ namespace era_engine::physics
 	{
 	public:
 		DistanceJointComponent() = default;
-		DistanceJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor);
+		DistanceJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor);
 		~DistanceJointComponent() override;
 
 		ObservableMember<float> stiffness = 0.0f;
@@ -122,7 +122,7 @@ namespace era_engine::physics
 	{
 	public:
 		SphericalJointComponent() = default;
-		SphericalJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor);
+		SphericalJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor);
 		~SphericalJointComponent() override;
 
 		//x = swing_y, y = swing_z
@@ -142,7 +142,7 @@ namespace era_engine::physics
 		};
 
 		D6JointComponent() = default;
-		D6JointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor);
+		D6JointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor);
 		~D6JointComponent() override;
 
 		bool perform_slerp_drive = false;
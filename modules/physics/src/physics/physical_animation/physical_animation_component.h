@@ -29,7 +29,7 @@ namespace era_engine::physics
 	{
 	public:
 		PhysicalAnimationLimbComponent() = default;
-		PhysicalAnimationLimbComponent(ref<Entity::EcsData> _data, uint32 _joint_id = INVALID_JOINT);
+		PhysicalAnimationLimbComponent(Entity::EcsData* _data, uint32 _joint_id = INVALID_JOINT);
 		~PhysicalAnimationLimbComponent() override;
 
 		std::shared_ptr<BaseLimbState> get_current_state() const;
@@ -90,7 +90,7 @@ namespace era_engine::physics
 	{
 	public:
 		PhysicalAnimationComponent() = default;
-		PhysicalAnimationComponent(ref<Entity::EcsData> _data);
+		PhysicalAnimationComponent(Entity::EcsData* _data);
 		~PhysicalAnimationComponent() override;
 
 		bool try_to_apply_ragdoll_profile(ref<RagdollProfile> new_profile, RagdollProfileStrengthType new_strength_type = RagdollProfileStrengthType::DEFAULT, bool force_reload = false);
@@ -101,8 +101,8 @@ namespace era_engine::physics
 		Entity& e1)
 	{
 		JointComponent::BaseDescriptor descriptor;
-		descriptor.connected_entity = e0.get_data_weakref();
-		descriptor.second_connected_entity = e1.get_data_weakref();
+		descriptor.connected_entity = e0;
+		descriptor.second_connected_entity = e1;
 		descriptor.local_frame = trs::identity;
 		descriptor.second_local_frame = trs::identity;
 
@@ -145,8 +145,8 @@ namespace era_engine::physics
 		e1_to_e1_joint_transform.scale = vec3(1.0f);
 
 		JointComponent::BaseDescriptor descriptor;
-		descriptor.connected_entity = e0.get_data_weakref();
-		descriptor.second_connected_entity = e1.get_data_weakref();
+		descriptor.connected_entity = e0;
+		descriptor.second_connected_entity = e1;
 		descriptor.local_frame = e0_to_e0_joint_transform;
 		descriptor.second_local_frame = e1_to_e1_joint_transform;
 
@@ -238,8 +238,8 @@ namespace era_engine::physics
 		const MotorDriveDetails& motor_drive = details.motor_drive.value();
 
 		JointComponent::BaseDescriptor descriptor;
-		descriptor.connected_entity = e0.get_data_weakref();
-		descriptor.second_connected_entity = e1.get_data_weakref();
+		descriptor.connected_entity = e0;
+		descriptor.second_connected_entity = e1;
 		descriptor.local_frame = trs::identity;
 		descriptor.second_local_frame = trs::identity;
 
@@ -757,8 +757,8 @@ namespace era_engine::physics
 			shape_component->use_in_scene_queries = false;
 
 			JointComponent::BaseDescriptor descriptor;
-			descriptor.connected_entity = body_lower_ghost.get_data_weakref();
-			descriptor.second_connected_entity = body_lower.get_data_weakref();
+			descriptor.connected_entity = body_lower_ghost;
+			descriptor.second_connected_entity = body_lower;
 
 			if (physical_animation_component->use_fixed_pelvis_attachment)
 			{
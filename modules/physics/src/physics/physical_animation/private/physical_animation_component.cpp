@@ -72,7 +72,7 @@ namespace era_engine::physics
 		collision_time = 0.0f;
 	}
 
-	PhysicalAnimationLimbComponent::PhysicalAnimationLimbComponent(ref<Entity::EcsData> _data, uint32 _joint_id /*= INVALID_JOINT*/)
+	PhysicalAnimationLimbComponent::PhysicalAnimationLimbComponent(Entity::EcsData* _data, uint32 _joint_id /*= INVALID_JOINT*/)
 		: RagdollLimbComponent(_data, _joint_id)
 	{
 		ComponentPtr this_component_ptr = ComponentPtr(this);
@@ -119,7 +119,7 @@ namespace era_engine::physics
 		get_current_state()->update(dt);
 	}
 
-	PhysicalAnimationComponent::PhysicalAnimationComponent(ref<Entity::EcsData> _data)
+	PhysicalAnimationComponent::PhysicalAnimationComponent(Entity::EcsData* _data)
 		: RagdollComponent(_data)
 	{
 		ComponentPtr this_component_ptr = ComponentPtr(this);
@@ -12,7 +12,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	AggregateHolderComponent::AggregateHolderComponent(ref<Entity::EcsData> _data)
+	AggregateHolderComponent::AggregateHolderComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		
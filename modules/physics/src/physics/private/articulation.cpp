@@ -26,7 +26,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	ArticulationComponent::ArticulationComponent(ref<Entity::EcsData> _data, const ArticulationComponentDescriptor& _descriptor)
+	ArticulationComponent::ArticulationComponent(Entity::EcsData* _data, const ArticulationComponentDescriptor& _descriptor)
 		: Component(_data), descriptor(_descriptor)
 	{
 		using namespace physx;
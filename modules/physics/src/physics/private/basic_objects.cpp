@@ -14,7 +14,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	PlaneComponent::PlaneComponent(ref<Entity::EcsData> _data, CollisionType _collision_type, const vec3& _point, const vec3& _norm)
+	PlaneComponent::PlaneComponent(Entity::EcsData* _data, CollisionType _collision_type, const vec3& _point, const vec3& _norm)
 		: Component(_data), point(_point), normal(_norm)
 	{
 		using namespace physx;
@@ -28,7 +28,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	BodyComponent::BodyComponent(ref<Entity::EcsData> _data)
+	BodyComponent::BodyComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
@@ -53,7 +53,7 @@ namespace era_engine::physics
 		}
 	}
 
-	DynamicBodyComponent::DynamicBodyComponent(ref<Entity::EcsData> _data)
+	DynamicBodyComponent::DynamicBodyComponent(Entity::EcsData* _data)
 		: BodyComponent(_data)
 	{
 		ComponentPtr this_component = ComponentPtr(this);
@@ -117,7 +117,7 @@ namespace era_engine::physics
 		}
 	}
 
-	StaticBodyComponent::StaticBodyComponent(ref<Entity::EcsData> _data)
+	StaticBodyComponent::StaticBodyComponent(Entity::EcsData* _data)
 		: BodyComponent(_data)
 	{
 		simulated.set_component(ComponentPtr(this));
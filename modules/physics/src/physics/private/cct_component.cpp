@@ -15,7 +15,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	CharacterControllerComponent::CharacterControllerComponent(ref<Entity::EcsData> _data)
+	CharacterControllerComponent::CharacterControllerComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		velocity.set_component(ComponentPtr{this});
@@ -13,7 +13,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	CollisionsHolderRootComponent::CollisionsHolderRootComponent(ref<Entity::EcsData> _data)
+	CollisionsHolderRootComponent::CollisionsHolderRootComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 	}
@@ -92,7 +92,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	JointComponent::JointComponent(ref<Entity::EcsData> _data, const BaseDescriptor& _base_descriptor)
+	JointComponent::JointComponent(Entity::EcsData* _data, const BaseDescriptor& _base_descriptor)
 		: Component(_data), base_descriptor(_base_descriptor)
 	{
 		enable_collision.set_component(ComponentPtr(this));
@@ -136,7 +136,7 @@ namespace era_engine::physics
 		return base_descriptor.second_local_frame;
 	}
 
-	FixedJointComponent::FixedJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor)
+	FixedJointComponent::FixedJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor)
 		: JointComponent(_data, _base_descriptor)
 	{
 	}
@@ -145,7 +145,7 @@ namespace era_engine::physics
 	{
 	}
 
-	RevoluteJointComponent::RevoluteJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor)
+	RevoluteJointComponent::RevoluteJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor)
 		: JointComponent(_data, _base_descriptor)
 	{
 		drive_force_limit.set_component(ComponentPtr(this));
@@ -158,7 +158,7 @@ namespace era_engine::physics
 	{
 	}
 
-	DistanceJointComponent::DistanceJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor)
+	DistanceJointComponent::DistanceJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor)
 		: JointComponent(_data, _base_descriptor)
 	{
 		stiffness.set_component(ComponentPtr(this));
@@ -172,7 +172,7 @@ namespace era_engine::physics
 	{
 	}
 	
-	SphericalJointComponent::SphericalJointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor)
+	SphericalJointComponent::SphericalJointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor)
 		: JointComponent(_data, _base_descriptor)
 	{
 		angular_limit.set_component(ComponentPtr(this));
@@ -182,7 +182,7 @@ namespace era_engine::physics
 	{
 	}
 
-	D6JointComponent::D6JointComponent(ref<Entity::EcsData> _data, const JointComponent::BaseDescriptor& _base_descriptor)
+	D6JointComponent::D6JointComponent(Entity::EcsData* _data, const JointComponent::BaseDescriptor& _base_descriptor)
 		: JointComponent(_data, _base_descriptor)
 	{
 		drive_transform.set_component(ComponentPtr(this));
@@ -33,7 +33,7 @@ namespace era_engine::physics
             .constructor<>();
     }
 
-    ShapeComponent::ShapeComponent(ref<Entity::EcsData> _data)
+    ShapeComponent::ShapeComponent(Entity::EcsData* _data)
         : Component(_data)
     {
         register_shape();
@@ -66,7 +66,7 @@ namespace era_engine::physics
         return shape->getGeometry();
     }
 
-    void ShapeComponent::sync_with_joint(weakref<Entity::EcsData> _entity_reference, uint32 _connected_joint_id)
+    void ShapeComponent::sync_with_joint(const EntityPtr& _entity_reference, uint32 _connected_joint_id)
     {
         connected_joint_id = _connected_joint_id;
         entity_reference = _entity_reference;
@@ -88,7 +88,7 @@ namespace era_engine::physics
         return nullptr;
     }
 
-    BoxShapeComponent::BoxShapeComponent(ref<Entity::EcsData> _data)
+    BoxShapeComponent::BoxShapeComponent(Entity::EcsData* _data)
         : ShapeComponent(_data)
     {
     }
@@ -113,7 +113,7 @@ namespace era_engine::physics
         return shape;
     }
 
-    SphereShapeComponent::SphereShapeComponent(ref<Entity::EcsData> _data)
+    SphereShapeComponent::SphereShapeComponent(Entity::EcsData* _data)
         : ShapeComponent(_data)
     {
     }
@@ -139,7 +139,7 @@ namespace era_engine::physics
         return shape;
     }
 
-    CapsuleShapeComponent::CapsuleShapeComponent(ref<Entity::EcsData> _data)
+    CapsuleShapeComponent::CapsuleShapeComponent(Entity::EcsData* _data)
         : ShapeComponent(_data)
     {
     }
@@ -165,7 +165,7 @@ namespace era_engine::physics
         return shape;
     }
 
-    TriangleMeshShapeComponent::TriangleMeshShapeComponent(ref<Entity::EcsData> _data)
+    TriangleMeshShapeComponent::TriangleMeshShapeComponent(Entity::EcsData* _data)
         : ShapeComponent(_data)
     {
     }
@@ -191,7 +191,7 @@ namespace era_engine::physics
         return shape;
     }
 
-    ConvexMeshShapeComponent::ConvexMeshShapeComponent(ref<Entity::EcsData> _data)
+    ConvexMeshShapeComponent::ConvexMeshShapeComponent(Entity::EcsData* _data)
         : ShapeComponent(_data)
     {
     }
@@ -76,29 +76,24 @@ namespace era_engine::physics
 
 		for (size_t s = 0; s < submeshes_count; s++)
 		{
-			SubmeshAsset root = asset->submeshes[s];
+			const SubmeshAsset& root = asset->submeshes[s];
 
-			const auto& triangles = root.triangles;
 			const auto& positions = root.positions;
 
-			size_t triangles_count = triangles.size();
-			size_t vertices_count = positions.size();
+			const uint32 triangles_count = root.get_num_triangles();
+			const size_t vertices_count = positions.size();
+
+			// Submeshes are merged into one mesh, their indices start at their first vertex.
+			const PxU32 base_vertex = vertices.size();
 
 			total_triangles_count += triangles_count;
 
-			for (size_t i = 0; i < triangles_count; i += 3)
+			for (uint32 i = 0; i < triangles_count; i++)
 			{
-				indices.pushBack(triangles[i + 0].a);
-				indices.pushBack(triangles[i + 0].b);
-				indices.pushBack(triangles[i + 0].c);
-
-				indices.pushBack(triangles[i + 1].a);
-				indices.pushBack(triangles[i + 1].b);
-				indices.pushBack(triangles[i + 1].c);
-
-				indices.pushBack(triangles[i + 2].a);
-				indices.pushBack(triangles[i + 2].b);
-				indices.pushBack(triangles[i + 2].c);
+				const indexed_triangle32 triangle = root.get_triangle(i);
+				indices.pushBack(base_vertex + triangle.a);
+				indices.pushBack(base_vertex + triangle.b);
+				indices.pushBack(base_vertex + triangle.c);
 			}
 
 			for (size_t i = 0; i < vertices_count; i++)
@@ -249,13 +244,14 @@ namespace era_engine::physics
 		float volume = 0.0f;
 
 		const auto& vertices = mesh->positions;
-		const auto& triangles = mesh->triangles;
 
-		for (int i = 0; i < mesh->triangles.size(); i++)
+		const uint32 triangles_count = mesh->get_num_triangles();
+		for (uint32 i = 0; i < triangles_count; i++)
 		{
-			const vec3& p1 = vertices[triangles[i].a];
-			const vec3& p2 = vertices[triangles[i].b];
-			const vec3& p3 = vertices[triangles[i].c];
+			const indexed_triangle32 triangle = mesh->get_triangle(i);
+			const vec3& p1 = vertices[triangle.a];
+			const vec3& p2 = vertices[triangle.b];
+			const vec3& p3 = vertices[triangle.c];
 
 			volume += signed_volume_of_triangle(p1, p2, p3);
 		}
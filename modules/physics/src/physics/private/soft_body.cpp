@@ -68,7 +68,7 @@ namespace era_engine::physics
 		}
 	}
 
-	SoftBodyComponent::SoftBodyComponent(ref<Entity::EcsData> _data)
+	SoftBodyComponent::SoftBodyComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		using namespace physx;
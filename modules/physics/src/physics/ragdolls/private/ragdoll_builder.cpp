@@ -78,8 +78,8 @@ namespace era_engine::physics
 		e1_to_e1_joint_transform.scale = vec3(1.0f);
 
 		JointComponent::BaseDescriptor descriptor;
-		descriptor.connected_entity = e0.get_data_weakref();
-		descriptor.second_connected_entity = e1.get_data_weakref();
+		descriptor.connected_entity = e0;
+		descriptor.second_connected_entity = e1;
 		descriptor.local_frame = e0_to_e0_joint_transform;
 		descriptor.second_local_frame = e1_to_e1_joint_transform;
 
@@ -15,7 +15,7 @@ namespace era_engine::physics
 			.constructor<>();
 	}
 
-	RagdollLimbComponent::RagdollLimbComponent(ref<Entity::EcsData> _data, uint32 _joint_id /*= INVALID_JOINT*/)
+	RagdollLimbComponent::RagdollLimbComponent(Entity::EcsData* _data, uint32 _joint_id /*= INVALID_JOINT*/)
 		: Component(_data), joint_id(_joint_id)
 	{
 		simulated.set_component(ComponentPtr(this));
@@ -25,7 +25,7 @@ namespace era_engine::physics
 	{
 	}
 
-	RagdollComponent::RagdollComponent(ref<Entity::EcsData> _data)
+	RagdollComponent::RagdollComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		simulated.set_component(ComponentPtr(this));
@@ -120,7 +120,7 @@ namespace era_engine::physics
 	{
 	public:
 		RagdollLimbComponent() = default;
-		RagdollLimbComponent(ref<Entity::EcsData> _data, uint32 _joint_id = INVALID_JOINT);
+		RagdollLimbComponent(Entity::EcsData* _data, uint32 _joint_id = INVALID_JOINT);
 
 		~RagdollLimbComponent() override;
 
@@ -142,7 +142,7 @@ namespace era_engine::physics
 	{
 	public:
 		RagdollComponent() = default;
-		RagdollComponent(ref<Entity::EcsData> _data);
+		RagdollComponent(Entity::EcsData* _data);
 		~RagdollComponent() override;
 
 		ObservableMember<bool> simulated = false;
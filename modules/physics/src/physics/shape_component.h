@@ -24,7 +24,7 @@ namespace era_engine::physics
 	{
 	public:
 		ShapeComponent() = default;
-		ShapeComponent(ref<Entity::EcsData> _data);
+		ShapeComponent(Entity::EcsData* _data);
 		~ShapeComponent() override;
 
 		template<class T>
@@ -51,7 +51,7 @@ namespace era_engine::physics
 
 		ref<PhysicsMaterial> material = nullptr;
 
-		void sync_with_joint(weakref<Entity::EcsData> _entity_reference, uint32 _connected_joint_id);
+		void sync_with_joint(const EntityPtr& _entity_reference, uint32 _connected_joint_id);
 		void set_attacment_state(bool active);
 
 		ERA_VIRTUAL_REFLECT(Component)
@@ -65,7 +65,7 @@ namespace era_engine::physics
 		physx::PxShape* shape = nullptr;
 
 		uint32 connected_joint_id;
-		weakref<Entity::EcsData> entity_reference;
+		EntityPtr entity_reference;
 		bool attachment_active = false;
 
 		friend class DynamicBodyComponent;
@@ -79,7 +79,7 @@ namespace era_engine::physics
 	{
 	public:
 		BoxShapeComponent() = default;
-		BoxShapeComponent(ref<Entity::EcsData> _data);
+		BoxShapeComponent(Entity::EcsData* _data);
 		~BoxShapeComponent() override;
 
 		vec3 half_extents = vec3(1.0f);
@@ -94,7 +94,7 @@ namespace era_engine::physics
 	{
 	public:
 		SphereShapeComponent() = default;
-		SphereShapeComponent(ref<Entity::EcsData> _data);
+		SphereShapeComponent(Entity::EcsData* _data);
 		~SphereShapeComponent() override;
 
 		float radius = 1.0f;
@@ -109,7 +109,7 @@ namespace era_engine::physics
 	{
 	public:
 		CapsuleShapeComponent() = default;
-		CapsuleShapeComponent(ref<Entity::EcsData> _data);
+		CapsuleShapeComponent(Entity::EcsData* _data);
 		~CapsuleShapeComponent() override;
 
 		float radius = 1.0f;
@@ -125,7 +125,7 @@ namespace era_engine::physics
 	{
 	public:
 		TriangleMeshShapeComponent() = default;
-		TriangleMeshShapeComponent(ref<Entity::EcsData> _data);
+		TriangleMeshShapeComponent(Entity::EcsData* _data);
 		~TriangleMeshShapeComponent() override;
 
 		vec3 size = vec3(1.0f);
@@ -141,7 +141,7 @@ namespace era_engine::physics
 	{
 	public:
 		ConvexMeshShapeComponent() = default;
-		ConvexMeshShapeComponent(ref<Entity::EcsData> _data);
+		ConvexMeshShapeComponent(Entity::EcsData* _data);
 		~ConvexMeshShapeComponent() override;
 
 		vec3 size = vec3(1.0f);
@@ -16,7 +16,7 @@ namespace era_engine::physics
 	public:
 		SoftBodyComponent() = default;
 
-		SoftBodyComponent(ref<Entity::EcsData> _data);
+		SoftBodyComponent(Entity::EcsData* _data);
 		~SoftBodyComponent() override;
 
 		uint32 get_nb_vertices() const;
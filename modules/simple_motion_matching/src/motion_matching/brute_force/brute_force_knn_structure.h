@@ -0,0 +1,49 @@
+#pragma once
+
+#include "motion_matching_api.h"
+
+#include "motion_matching/motion_matching_knn_structure.h"
+
+namespace era_engine
+{
+	// Exact search over every row of the feature matrix. Rows are stored transposed in blocks of 8, so one AVX2 register
+	// holds one feature of 8 rows and distances of a block need no horizontal sums. A block is dropped as soon as the
+	// partial distances of all its rows exceed the current k-th best after a group of 8 features. Search features are PCA
+	// components sorted by variance, so most blocks are rejected after the first group.
+	// Batches run all their queries over small tiles of blocks, so each tile is loaded once per batch (or per worker).
+	class ERA_MOTION_MATCHING_API BruteForceKnnStructure : public KnnStructure
+	{
+	public:
+		static constexpr uint32 BLOCK_ROWS = 8;
+
+		~BruteForceKnnStructure() override;
+
+		void build_structure(const MotionMatchingDatabase& database) override;
+
+		void search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates) override;
+		void search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+			const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts) override;
+
+		bool serialize(std::ostream& os, const MotionMatchingDatabase& database) const override;
+		bool deserialize(std::istream& is, const MotionMatchingDatabase& database) override;
+
+		// Squared distance between a row and a query padded to the row stride. Once the partial sum reaches 'bound' the
+		// remaining blocks are skipped and the partial sum is returned.
+		static float get_distance_sqr(const float* row, const float* padded_query, uint32 stride, float bound = std::numeric_limits<float>::max());
+
+	private:
+		// Searches the row blocks [first_block, last_block) for 'num_queries' queries, candidates[i] belongs to query i.
+		void search_blocks(const float* queries, uint32 query_stride, uint32 num_queries, uint32 first_block, uint32 last_block,
+			KnnCandidateList* candidates) const;
+
+		uint32 dimension = 0;
+		uint32 num_rows = 0;
+
+		// Row b holds rows [b * BLOCK_ROWS, (b + 1) * BLOCK_ROWS) of the search features as [feature][row in block].
+		FeatureMatrix row_blocks;
+
+		// Per chunk candidate lists of the last batch, kept to avoid reallocating. Batches on one structure don't overlap.
+		std::vector<KnnCandidate> batch_candidates;
+		std::vector<KnnCandidateList> batch_lists;
+	};
+}
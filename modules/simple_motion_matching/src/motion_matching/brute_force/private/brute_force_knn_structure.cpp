@@ -0,0 +1,291 @@
+#include "motion_matching/brute_force/brute_force_knn_structure.h"
+
+#include <core/job_system.h>
+#include <core/simd.h>
+
+#include <algorithm>
+
+namespace era_engine
+{
+    // 16 blocks of 24 features are 12 KB, they stay in L1 while all queries of a batch run over them.
+    static constexpr uint32 bf_tile_blocks = 16;
+
+    // Batches split the queries between workers. Matrices past cache size (64k rows) are split into row chunks of at
+    // least this many blocks instead, each with its own candidate lists per query. Chunks start with loose bounds and
+    // prune less, so they only pay off when the matrix would otherwise come from memory once per worker.
+    static constexpr uint32 bf_batch_chunk_blocks = 8192;
+    static constexpr uint32 bf_batch_max_chunks = 32;
+
+    static constexpr uint32 bf_batch_query_grain = 16;
+
+#if defined(SIMD_AVX_2)
+    static float horizontal_sum(__m256 value)
+    {
+        const __m128 quad = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+        const __m128 pair = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(pair, _mm_movehdup_ps(pair)));
+    }
+#endif
+
+    static void search_block_range(const FeatureMatrix& row_blocks, uint32 dimension, uint32 num_rows, const float* query,
+        uint32 first_block, uint32 last_block, KnnCandidateList& candidates)
+    {
+        constexpr uint32 block_rows = BruteForceKnnStructure::BLOCK_ROWS;
+
+        alignas(32) float distances[block_rows];
+
+        for (uint32 block = first_block; block < last_block; ++block)
+        {
+            const float* block_values = row_blocks.get_row(block);
+
+#if defined(SIMD_AVX_2)
+            const __m256 bound = _mm256_set1_ps(candidates.get_bound());
+
+            __m256 sum = _mm256_setzero_ps();
+            uint32 mask = 0xFF;
+            for (uint32 feature = 0; feature < dimension; ++feature)
+            {
+                const __m256 diff = _mm256_sub_ps(_mm256_load_ps(block_values + feature * block_rows), _mm256_broadcast_ss(query + feature));
+                sum = _mm256_fmadd_ps(diff, diff, sum);
+
+                if (feature % 8 == 7 || feature + 1 == dimension)
+                {
+                    mask = uint32(_mm256_movemask_ps(_mm256_cmp_ps(sum, bound, _CMP_LT_OQ)));
+                    if (mask == 0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            if (mask == 0)
+            {
+                continue;
+            }
+            _mm256_store_ps(distances, sum);
+#else
+            const float bound = candidates.get_bound();
+
+            for (uint32 lane = 0; lane < block_rows; ++lane)
+            {
+                distances[lane] = 0.0f;
+            }
+
+            uint32 mask = 0xFF;
+            for (uint32 feature = 0; feature < dimension; ++feature)
+            {
+                for (uint32 lane = 0; lane < block_rows; ++lane)
+                {
+                    const float diff = block_values[feature * block_rows + lane] - query[feature];
+                    distances[lane] += diff * diff;
+                }
+
+                if (feature % 8 == 7 || feature + 1 == dimension)
+                {
+                    mask = 0;
+                    for (uint32 lane = 0; lane < block_rows; ++lane)
+                    {
+                        mask |= distances[lane] < bound ? (1u << lane) : 0u;
+                    }
+                    if (mask == 0)
+                    {
+                        break;
+                    }
+                }
+            }
+#endif
+
+            for (uint32 lane = 0; lane < block_rows; ++lane)
+            {
+                const uint32 row = block * block_rows + lane;
+                if ((mask & (1u << lane)) && row < num_rows)
+                {
+                    candidates.insert(row, distances[lane]);
+                }
+            }
+        }
+    }
+
+    BruteForceKnnStructure::~BruteForceKnnStructure()
+    {
+    }
+
+    void BruteForceKnnStructure::build_structure(const MotionMatchingDatabase& database)
+    {
+        const FeatureMatrix& features = database.search_features;
+
+        dimension = features.get_cols();
+        num_rows = features.get_rows();
+
+        const uint32 num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        row_blocks.resize(num_blocks, dimension * BLOCK_ROWS);
+
+        for (uint32 row = 0; row < num_rows; ++row)
+        {
+            const float* values = features.get_row(row);
+            float* block_values = row_blocks.get_row(row / BLOCK_ROWS);
+
+            for (uint32 feature = 0; feature < dimension; ++feature)
+            {
+                block_values[feature * BLOCK_ROWS + row % BLOCK_ROWS] = values[feature];
+            }
+        }
+    }
+
+    float BruteForceKnnStructure::get_distance_sqr(const float* row, const float* padded_query, uint32 stride, float bound)
+    {
+        ASSERT(stride % FeatureMatrix::COLUMN_ALIGNMENT == 0);
+
+#if defined(SIMD_AVX_2)
+        __m256 sum = _mm256_setzero_ps();
+        for (uint32 block = 0; block < stride; block += 8)
+        {
+            const __m256 diff = _mm256_sub_ps(_mm256_load_ps(row + block), _mm256_loadu_ps(padded_query + block));
+            sum = _mm256_fmadd_ps(diff, diff, sum);
+
+            if (block + 8 < stride)
+            {
+                const float partial_sum = horizontal_sum(sum);
+                if (partial_sum >= bound)
+                {
+                    return partial_sum;
+                }
+            }
+        }
+        return horizontal_sum(sum);
+#else
+        float sum = 0.0f;
+        for (uint32 block = 0; block < stride; block += 8)
+        {
+            for (uint32 i = block; i < block + 8; ++i)
+            {
+                const float diff = row[i] - padded_query[i];
+                sum += diff * diff;
+            }
+
+            if (sum >= bound)
+            {
+                return sum;
+            }
+        }
+        return sum;
+#endif
+    }
+
+    void BruteForceKnnStructure::search_blocks(const float* queries, uint32 query_stride, uint32 num_queries, uint32 first_block, uint32 last_block,
+        KnnCandidateList* candidates) const
+    {
+        // Matrix style blocking: every query of the batch runs over a tile of blocks while it is in L1.
+        for (uint32 tile = first_block; tile < last_block; tile += bf_tile_blocks)
+        {
+            const uint32 tile_end = std::min(tile + bf_tile_blocks, last_block);
+
+            for (uint32 query = 0; query < num_queries; ++query)
+            {
+                search_block_range(row_blocks, dimension, num_rows, queries + size_t(query) * query_stride, tile, tile_end, candidates[query]);
+            }
+        }
+    }
+
+    void BruteForceKnnStructure::search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates)
+    {
+        out_candidates.resize(max_candidates);
+
+        KnnCandidateList candidates(out_candidates.data(), max_candidates);
+        if (num_rows > 0)
+        {
+            ASSERT(database.search_features.get_rows() == num_rows && database.search_features.get_cols() == dimension);
+
+            search_blocks(query, dimension, 1, 0, row_blocks.get_rows(), &candidates);
+        }
+
+        out_candidates.resize(candidates.get_size());
+    }
+
+    void BruteForceKnnStructure::search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+        const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts)
+    {
+        if (num_rows == 0 || max_candidates == 0)
+        {
+            std::fill(out_counts, out_counts + num_queries, 0);
+            return;
+        }
+
+        ASSERT(database.search_features.get_rows() == num_rows && database.search_features.get_cols() == dimension);
+
+        const uint32 num_blocks = row_blocks.get_rows();
+        const uint32 num_chunks = std::clamp(num_blocks / bf_batch_chunk_blocks, 1u, bf_batch_max_chunks);
+
+        if (num_chunks == 1)
+        {
+            parallel_for(0, num_queries, bf_batch_query_grain, [&](uint32 begin, uint32 end)
+            {
+                KnnCandidateList* candidates = (KnnCandidateList*)alloca(sizeof(KnnCandidateList) * (end - begin));
+                for (uint32 query = begin; query < end; ++query)
+                {
+                    candidates[query - begin] = KnnCandidateList(out_candidates + size_t(query) * max_candidates, max_candidates);
+                }
+
+                search_blocks(queries + size_t(begin) * query_stride, query_stride, end - begin, 0, num_blocks, candidates);
+
+                for (uint32 query = begin; query < end; ++query)
+                {
+                    out_counts[query] = candidates[query - begin].get_size();
+                }
+            });
+            return;
+        }
+
+        // Every chunk runs all queries over its rows, then the per chunk lists are merged.
+        batch_candidates.resize(size_t(num_chunks) * num_queries * max_candidates);
+        batch_lists.resize(size_t(num_chunks) * num_queries);
+
+        parallel_for(0, num_chunks, 1, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 chunk = begin; chunk < end; ++chunk)
+            {
+                KnnCandidateList* candidates = batch_lists.data() + size_t(chunk) * num_queries;
+                for (uint32 query = 0; query < num_queries; ++query)
+                {
+                    candidates[query] = KnnCandidateList(batch_candidates.data() + (size_t(chunk) * num_queries + query) * max_candidates, max_candidates);
+                }
+
+                const uint32 first_block = uint32(uint64(num_blocks) * chunk / num_chunks);
+                const uint32 last_block = uint32(uint64(num_blocks) * (chunk + 1) / num_chunks);
+                search_blocks(queries, query_stride, num_queries, first_block, last_block, candidates);
+            }
+        });
+
+        parallel_for(0, num_queries, bf_batch_query_grain, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 query = begin; query < end; ++query)
+            {
+                KnnCandidateList candidates(out_candidates + size_t(query) * max_candidates, max_candidates);
+
+                for (uint32 chunk = 0; chunk < num_chunks; ++chunk)
+                {
+                    const KnnCandidateList& chunk_candidates = batch_lists[size_t(chunk) * num_queries + query];
+                    for (uint32 index = 0; index < chunk_candidates.get_size(); ++index)
+                    {
+                        const KnnCandidate& candidate = chunk_candidates.get_candidates()[index];
+                        candidates.insert(candidate.sample_index, candidate.distance_sqr);
+                    }
+                }
+
+                out_counts[query] = candidates.get_size();
+            }
+        });
+    }
+
+    bool BruteForceKnnStructure::serialize(std::ostream& os, const MotionMatchingDatabase& database) const
+    {
+        return true;
+    }
+
+    bool BruteForceKnnStructure::deserialize(std::istream& is, const MotionMatchingDatabase& database)
+    {
+        // The blocked copy is cheap to rebuild from the search features, nothing is stored.
+        build_structure(database);
+        return true;
+    }
+}
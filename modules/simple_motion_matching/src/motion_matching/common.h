@@ -30,6 +30,27 @@ namespace era_engine
 		float anim_position = -1.0f;
 	};
 
+	// One query of MotionMatchingDatabase::search_batch. Points into caller memory, nothing is copied.
+	struct ERA_MOTION_MATCHING_API SearchBatchQuery final
+	{
+		// Raw feature values, as many as the database was baked with.
+		const float* query = nullptr;
+
+		const animation::AnimationAssetClip* current_animation = nullptr;
+		float current_anim_position = 0.0f;
+	};
+
+	struct ERA_MOTION_MATCHING_API SearchBatchResult final
+	{
+		static constexpr uint32 INVALID_SAMPLE = ~0u;
+
+		// Database sample to continue from. INVALID_SAMPLE if no candidate passed the narrow phase.
+		uint32 sample_index = INVALID_SAMPLE;
+
+		// The current animation already plays close to the best candidate (NarrowPhaseFlags::SAME_FRAME_CHECK).
+		bool keep_current = false;
+	};
+
 	static inline float clampf(float x, float min, float max)
 	{
 		return x > max ? max : x < min ? min : x;
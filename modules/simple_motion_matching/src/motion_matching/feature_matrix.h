@@ -0,0 +1,52 @@
+#pragma once
+
+#include "motion_matching_api.h"
+
+namespace era_engine
+{
+	// Row-major matrix of feature vectors. Every row starts on a 32 byte boundary and is padded with zeros to a multiple
+	// of 8 columns, so search kernels can read whole 8-wide blocks without a scalar tail.
+	class ERA_MOTION_MATCHING_API FeatureMatrix final
+	{
+	public:
+		static constexpr uint32 COLUMN_ALIGNMENT = 8;
+
+		FeatureMatrix() = default;
+		FeatureMatrix(uint32 rows, uint32 cols);
+		FeatureMatrix(const FeatureMatrix& other);
+		FeatureMatrix(FeatureMatrix&& other) noexcept;
+		~FeatureMatrix();
+
+		FeatureMatrix& operator=(const FeatureMatrix& other);
+		FeatureMatrix& operator=(FeatureMatrix&& other) noexcept;
+
+		// Contents are zeroed. Memory is only reallocated when the matrix grows past its capacity, so scratch matrices can be
+		// resized every frame.
+		void resize(uint32 rows, uint32 cols);
+		void clear();
+
+		bool empty() const { return rows == 0; }
+
+		uint32 get_rows() const { return rows; }
+		uint32 get_cols() const { return cols; }
+		uint32 get_stride() const { return stride; }
+
+		float* get_row(uint32 row) { ASSERT(row < rows); return data + size_t(row) * stride; }
+		const float* get_row(uint32 row) const { ASSERT(row < rows); return data + size_t(row) * stride; }
+
+		float* get_data() { return data; }
+		const float* get_data() const { return data; }
+
+		// Copies 'cols' floats into the row, padding stays zero.
+		void set_row(uint32 row, const float* values);
+
+	private:
+		float* data = nullptr;
+
+		uint32 rows = 0;
+		uint32 cols = 0;
+		uint32 stride = 0;
+
+		size_t capacity = 0;
+	};
+}
@@ -23,6 +23,7 @@ namespace era_engine
         std::vector<rttr::type> get_feature_types() const;
 
         std::vector<float> get_all_feature_values() const;
+        void append_all_feature_values(std::vector<float>& out_values) const;
 
         const std::vector<float>* get_feature_values(rttr::type type) const;
 
@@ -39,12 +39,17 @@ namespace era_engine
     std::vector<float> MotionMatchingFeatureSet::get_all_feature_values() const
     {
         std::vector<float> result;
+        append_all_feature_values(result);
+
+        return result;
+    }
+
+    void MotionMatchingFeatureSet::append_all_feature_values(std::vector<float>& out_values) const
+    {
         for (const Feature& feature_node : features)
         {
-            result.insert(result.end(), feature_node.params_values.begin(), feature_node.params_values.end());
+            out_values.insert(out_values.end(), feature_node.params_values.begin(), feature_node.params_values.end());
         }
-
-        return result;
     }
 
     const std::vector<float>* MotionMatchingFeatureSet::get_feature_values(rttr::type type) const
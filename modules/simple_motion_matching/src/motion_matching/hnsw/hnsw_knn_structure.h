@@ -15,7 +15,9 @@ namespace era_engine
 
 		void build_structure(const MotionMatchingDatabase& database) override;
 
-		std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>> search_knn(float* query, uint32 query_size, uint32 max_candidates, const MotionMatchingDatabase& database) override;
+		void search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates) override;
+		void search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+			const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts) override;
 
 		bool serialize(std::ostream& os, const MotionMatchingDatabase& database) const override;
 		bool deserialize(std::istream& is, const MotionMatchingDatabase& database) override;
@@ -24,6 +26,9 @@ namespace era_engine
 		uint32 max_edges_per_vertex = 10;
 		uint32 construction_exploration_factor = 50;
 
+		// Size of the dynamic candidate list during search (hnswlib's ef), raised to k if smaller. Trades latency for recall.
+		uint32 search_exploration_factor = 10;
+
 	private:
 		hnswlib::L2Space hnsw_l2_space = hnswlib::L2Space(0);
 		std::shared_ptr<hnswlib::HierarchicalNSW<float>> hnsw;
@@ -1,75 +1,91 @@
 #include "motion_matching/hnsw/hnsw_knn_structure.h"
 
 #include <core/math.h>
+#include <core/job_system.h>
 
 namespace era_engine
 {
+    static constexpr uint32 hnsw_batch_grain = 8;
+    static constexpr uint32 hnsw_build_grain = 256;
+
     HnswKnnStructure::~HnswKnnStructure()
     {
     }
 
     void HnswKnnStructure::build_structure(const MotionMatchingDatabase& database)
     {
+        const FeatureMatrix& features = database.search_features;
+
         hnsw_l2_space = hnswlib::L2Space(database.search_dimension);
 
-        std::vector<float> features_array;
-        features_array.reserve(database.samples.size() * database.search_dimension);
+        hnsw = std::shared_ptr<hnswlib::HierarchicalNSW<float>>(new hnswlib::HierarchicalNSW<float>(&hnsw_l2_space, features.get_rows(), max_edges_per_vertex, construction_exploration_factor));
 
-        for (size_t sample_index = 0; sample_index < database.samples.size(); ++sample_index)
+        // addPoint is safe to run concurrently once the graph has an entry point. The graph depends on the insertion order,
+        // so parallel builds of the same features aren't identical, their recall is the same.
+        if (features.get_rows() > 0)
         {
-            const std::shared_ptr<MotionMatchingDatabase::Sample>& sample = database.samples[sample_index];
-            const std::vector<float> sample_features = database.normalize_query(sample->features);
-
-            features_array.insert(features_array.end(), sample_features.begin(), sample_features.end());
+            hnsw->addPoint(features.get_row(0), 0);
         }
 
-        array2d<float> features_matrix(uint32(database.samples.size()), database.samples.front()->features.size());
-        features_matrix.fill(features_array.data());
-
-        database.subtract_column_means(features_matrix);
-
-        const array2d<float> final_features_matrix = transpose(database.transform_matrix * transpose(features_matrix));
-
-        hnsw = std::shared_ptr<hnswlib::HierarchicalNSW<float>>(new hnswlib::HierarchicalNSW<float>(&hnsw_l2_space, database.samples.size(), max_edges_per_vertex, construction_exploration_factor));
-
-        for (uint32 point_index = 0; point_index < static_cast<uint32>(database.samples.size()); ++point_index)
+        parallel_for(1, features.get_rows(), hnsw_build_grain, [&](uint32 begin, uint32 end)
         {
-            std::vector<float> animation_data;
-
-            for (uint32 feature_index = 0; feature_index < database.search_dimension; ++feature_index)
+            for (uint32 point_index = begin; point_index < end; ++point_index)
             {
-                animation_data.push_back(final_features_matrix(point_index, feature_index));
+                hnsw->addPoint(features.get_row(point_index), point_index);
             }
-
-            hnsw->addPoint(animation_data.data(), point_index);
-        }
+        });
 
         hnsw->saveIndex(writable);
     }
 
-    std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>> HnswKnnStructure::search_knn(float* query, uint32 query_size, uint32 max_candidates, const MotionMatchingDatabase& database)
+    // hnswlib searches are safe to run concurrently, changing ef is not.
+    static uint32 search_query(hnswlib::HierarchicalNSW<float>& hnsw, const float* query, uint32 max_candidates, const MotionMatchingDatabase& database,
+        KnnCandidate* out_candidates)
     {
-        std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>> found_samples;
-
-        std::priority_queue<std::pair<float, hnswlib::labeltype>> search_result = hnsw->searchKnn(query, max_candidates);
+        std::priority_queue<std::pair<float, hnswlib::labeltype>> search_result = hnsw.searchKnn(query, max_candidates);
 
-        for (uint32 index = 0; index < uint32(search_result.size()); ++index)
+        // The queue pops the farthest candidate first.
+        const uint32 num_candidates = uint32(search_result.size());
+        for (uint32 index = num_candidates; index > 0; --index)
         {
             const uint32 sample_index = uint32(search_result.top().second);
+            ASSERT(sample_index < database.search_features.get_rows());
+
+            out_candidates[index - 1] = KnnCandidate{ sample_index, search_result.top().first };
             search_result.pop();
+        }
 
-            ASSERT(sample_index < database.samples.size());
+        return num_candidates;
+    }
 
-            found_samples.emplace_back(database.samples[sample_index]);
-        }
+    void HnswKnnStructure::search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates)
+    {
+        hnsw->setEf(std::max(search_exploration_factor, max_candidates));
+
+        out_candidates.resize(max_candidates);
+        out_candidates.resize(search_query(*hnsw, query, max_candidates, database, out_candidates.data()));
+    }
 
-        return found_samples;
+    void HnswKnnStructure::search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+        const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts)
+    {
+        hnsw->setEf(std::max(search_exploration_factor, max_candidates));
+
+        parallel_for(0, num_queries, hnsw_batch_grain, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 query = begin; query < end; ++query)
+            {
+                out_counts[query] = search_query(*hnsw, queries + size_t(query) * query_stride, max_candidates, database,
+                    out_candidates + size_t(query) * max_candidates);
+            }
+        });
     }
 
 	bool HnswKnnStructure::serialize(std::ostream& os, const MotionMatchingDatabase& database) const
 	{
         IO::write_value(os, max_edges_per_vertex);
         IO::write_value(os, construction_exploration_factor);
+        IO::write_value(os, search_exploration_factor);
 
 		return true;
 	}
@@ -78,6 +94,7 @@ namespace era_engine
     {
         IO::read_value(is, max_edges_per_vertex);
         IO::read_value(is, construction_exploration_factor);
+        IO::read_value(is, search_exploration_factor);
 
         hnsw_l2_space = hnswlib::L2Space(database.search_dimension);
 
@@ -12,7 +12,7 @@ namespace era_engine
 	{
 	public:
 		MotionComponent() = default;
-		MotionComponent(ref<Entity::EcsData> _data);
+		MotionComponent(Entity::EcsData* _data);
 
 		~MotionComponent() override;
 
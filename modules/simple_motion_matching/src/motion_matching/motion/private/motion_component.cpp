@@ -12,10 +12,10 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<MotionComponent>("MotionComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	MotionComponent::MotionComponent(ref<Entity::EcsData> _data)
+	MotionComponent::MotionComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		const trs& world_transform = get_entity().get_component<TransformComponent>()->get_world_transform();
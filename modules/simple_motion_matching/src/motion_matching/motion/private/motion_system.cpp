@@ -123,7 +123,7 @@ namespace era_engine
 	{
 		ZoneScopedN("MotionSystem::debug_draw_update");
 
-		if (draw_motion)
+		if (draw_motion && renderer_holder_rc->ldrRenderPass != nullptr)
 		{
 			for (auto [handle, transform_component, motion_component] : world->group(components_group<TransformComponent, MotionComponent>).each())
 			{
@@ -14,13 +14,16 @@ namespace era_engine
 	{
 	public:
 		MotionMatchingComponent() = default;
-		MotionMatchingComponent(ref<Entity::EcsData> _data);
+		MotionMatchingComponent(Entity::EcsData* _data);
 
 		~MotionMatchingComponent() override;
 
 		SearchResult search_animation(const std::string& database_id, float dt) const;
 		SearchResult search_animation(const MotionMatchingFeatureSet& feature_set, const std::string& database_id) const;
 
+		// Pose, trajectory and phase features of the entity, in the order databases are baked with.
+		void compute_feature_set(float dt, MotionMatchingFeatureSet& out_feature_set) const;
+
 		ERA_VIRTUAL_REFLECT(Component)
 
 	public:
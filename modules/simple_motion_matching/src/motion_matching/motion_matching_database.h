@@ -4,12 +4,15 @@
 
 #include "motion_matching/array.h"
 #include "motion_matching/common.h"
+#include "motion_matching/feature_matrix.h"
 #include "motion_matching/features/motion_matching_feature.h"
 
 #include <asset/game_asset.h>
 
 #include <core/serialization/binary_serializer.h>
 
+#include <functional>
+
 namespace era_engine 
 {
 	namespace animation
@@ -19,9 +22,17 @@ namespace era_engine
 
 	class KnnStructure;
 
+	struct KnnCandidate
+	{
+		uint32 sample_index = 0;
+		float distance_sqr = 0.0f;
+	};
+
 	enum class KnnStructureType : uint8
 	{
 		HNSW = 0,
+		BRUTE_FORCE = 1, // Exact, fastest for small and medium databases.
+		PRODUCT_QUANTIZATION = 2, // Approximate, compressed codes for large databases.
 		DEFAULT = HNSW,
 		COUNT
 	};
@@ -43,6 +54,17 @@ namespace era_engine
 		float max_euclidean_distance = 15.0f;
 	};
 
+	// Scratch memory of MotionMatchingDatabase::search_batch. It grows to the largest batch and is kept, so batches of
+	// a steady size don't allocate. One context per concurrently running batch.
+	struct ERA_MOTION_MATCHING_API SearchBatchContext final
+	{
+		FeatureMatrix normalized_queries;
+		FeatureMatrix packed_queries;
+
+		std::vector<KnnCandidate> candidates;
+		std::vector<uint32> candidate_counts;
+	};
+
 	class ERA_MOTION_MATCHING_API MotionMatchingDatabase : public GameAsset
 	{
 	public:
@@ -56,14 +78,35 @@ namespace era_engine
 			ERA_BINARY_SERIALIZE(features, anim_index, anim_position)
 		};
 
+		// Fills 'out_samples' with the samples of one clip, taken every 1 / sample_rate seconds. Runs on the worker threads,
+		// one call per clip. anim_index is assigned by the database.
+		using SampleExtractor = std::function<void(const animation::AnimationAssetClip& clip, float sample_rate, std::vector<std::shared_ptr<Sample>>& out_samples)>;
+
 		MotionMatchingDatabase(KnnStructureType _knn_type = KnnStructureType::DEFAULT);
 		~MotionMatchingDatabase() override;
 
+		// Extracts the samples of clips whose animations_hashes entry isn't in clip_samples_cache yet (one job per clip),
+		// reuses the cached samples of all other clips and bakes them in clip order. Cache entries of removed clips are dropped.
+		void bake(const SampleExtractor& extract_samples);
+
+		// Builds the normalization, the PCA transform, the search features and the knn structure from the samples.
 		void bake();
 
+		// Fills normalized_features and search_features from the samples. Part of bake(), also run after loading.
+		void build_search_features();
+
 		SearchResult search(const SearchParams& params) const;
 
+		// Searches 'num_queries' queries at once and writes one result per query. Normalization, projection, the knn
+		// search and the narrow phase each run over the whole batch on the worker threads.
+		void search_batch(const SearchBatchQuery* queries, uint32 num_queries, SearchBatchResult* results, SearchBatchContext& context) const;
+
 		std::vector<float> normalize_query(const std::vector<float>& query) const;
+		void normalize_query(const float* query, float* out_normalized_query) const;
+
+		// Projects a normalized query to the search_dimension PCA components that the knn structures index.
+		void project_query(const float* normalized_query, float* out_packed_query) const;
+
 		void subtract_column_means(array2d<float>& matrix) const;
 		array2d<float> pack_query(const std::vector<float>& query) const;
 
@@ -75,10 +118,19 @@ namespace era_engine
 	protected:
 		void fill_normalize_factors();
 
-		SearchResult narrow_phase_search(const std::vector<std::shared_ptr<Sample>>& broadphase_candidates,
+		// Row by row parts of build_search_features(), on the worker threads.
+		void normalize_samples();
+		void project_samples();
+
+		SearchResult narrow_phase_search(const std::vector<KnnCandidate>& broadphase_candidates,
 			const std::vector<float>& normalized_query,
 			const SearchParams& params) const;
 
+		SearchBatchResult narrow_phase_search(const KnnCandidate* broadphase_candidates, uint32 num_candidates,
+			const float* normalized_query,
+			const animation::AnimationAssetClip* current_animation,
+			float current_anim_position) const;
+
 	public:
 		// Settings
 		std::string database_id;
@@ -98,6 +150,14 @@ namespace era_engine
 		// Generated
 		std::vector<std::shared_ptr<Sample>> samples;
 
+		// Samples of every baked clip by animation hash.
+		std::unordered_map<uint32, std::vector<std::shared_ptr<Sample>>> clip_samples_cache;
+
+		// One row per sample. Normalized features (see normalize_query) and their PCA projection to search_dimension,
+		// which is what the knn structures index.
+		FeatureMatrix normalized_features;
+		FeatureMatrix search_features;
+
 		std::shared_ptr<KnnStructure> knn_structure;
 
 		std::vector<float> mean_values;
@@ -1,24 +1,59 @@
-#pragma once 
+#pragma once
 
 #include "motion_matching_api.h"
 
 #include "motion_matching/motion_matching_database.h"
 
-namespace era_engine 
+namespace era_engine
 {
+	// The 'capacity' closest candidates seen so far, closest first. Lives in caller provided memory, so searches don't allocate.
+	class ERA_MOTION_MATCHING_API KnnCandidateList final
+	{
+	public:
+		KnnCandidateList() = default;
+		KnnCandidateList(KnnCandidate* _storage, uint32 _capacity)
+			: storage(_storage), capacity(_capacity)
+		{
+		}
+
+		// Candidates at or beyond this distance can't get in anymore.
+		float get_bound() const { return size < capacity ? std::numeric_limits<float>::max() : (size > 0 ? storage[size - 1].distance_sqr : 0.0f); }
+
+		void insert(uint32 sample_index, float distance_sqr);
+
+		uint32 get_size() const { return size; }
+		uint32 get_capacity() const { return capacity; }
+		const KnnCandidate* get_candidates() const { return storage; }
+
+	private:
+		KnnCandidate* storage = nullptr;
+		uint32 size = 0;
+		uint32 capacity = 0;
+	};
+
 	class ERA_MOTION_MATCHING_API KnnStructure
 	{
 	public:
 		virtual ~KnnStructure();
 
+		// Indexes database.search_features.
 		virtual void build_structure(const MotionMatchingDatabase& database);
 
-		virtual std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>> search_knn(float* query, uint32 query_size, uint32 max_candidates, const MotionMatchingDatabase& database);
-	
+		// Up to 'max_candidates' rows of database.search_features closest to 'query' (search_dimension floats), closest first.
+		virtual void search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates);
+
+		// Searches 'num_queries' queries stored 'query_stride' floats apart. Query i writes up to 'max_candidates' candidates,
+		// closest first, to out_candidates + i * max_candidates and their number to out_counts[i]. The default runs
+		// search_knn per query on the worker threads.
+		virtual void search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+			const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts);
+
 		virtual bool serialize(std::ostream& os, const MotionMatchingDatabase& database) const;
 		virtual bool deserialize(std::istream& is, const MotionMatchingDatabase& database);
 
+		static ref<KnnStructure> create(KnnStructureType type);
+
 	public:
 		mutable std::string writable; // Serializable data
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,103 @@
+#include "motion_matching/feature_matrix.h"
+
+namespace era_engine
+{
+    static constexpr std::align_val_t feature_matrix_alignment = std::align_val_t(32);
+
+    FeatureMatrix::FeatureMatrix(uint32 _rows, uint32 _cols)
+    {
+        resize(_rows, _cols);
+    }
+
+    FeatureMatrix::FeatureMatrix(const FeatureMatrix& other)
+    {
+        *this = other;
+    }
+
+    FeatureMatrix::FeatureMatrix(FeatureMatrix&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    FeatureMatrix::~FeatureMatrix()
+    {
+        clear();
+    }
+
+    FeatureMatrix& FeatureMatrix::operator=(const FeatureMatrix& other)
+    {
+        if (this != &other)
+        {
+            resize(other.rows, other.cols);
+            if (data != nullptr)
+            {
+                memcpy(data, other.data, sizeof(float) * size_t(rows) * stride);
+            }
+        }
+        return *this;
+    }
+
+    FeatureMatrix& FeatureMatrix::operator=(FeatureMatrix&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+
+            data = other.data;
+            rows = other.rows;
+            cols = other.cols;
+            stride = other.stride;
+
+            capacity = other.capacity;
+
+            other.data = nullptr;
+            other.rows = 0;
+            other.cols = 0;
+            other.stride = 0;
+            other.capacity = 0;
+        }
+        return *this;
+    }
+
+    void FeatureMatrix::resize(uint32 _rows, uint32 _cols)
+    {
+        const uint32 new_stride = (_cols + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+        const size_t new_size = size_t(_rows) * new_stride;
+
+        if (new_size > capacity)
+        {
+            clear();
+
+            data = static_cast<float*>(::operator new(sizeof(float) * new_size, feature_matrix_alignment));
+            capacity = new_size;
+        }
+
+        rows = _rows;
+        cols = _cols;
+        stride = new_stride;
+
+        if (new_size > 0)
+        {
+            memset(data, 0, sizeof(float) * new_size);
+        }
+    }
+
+    void FeatureMatrix::clear()
+    {
+        if (data != nullptr)
+        {
+            ::operator delete(data, feature_matrix_alignment);
+            data = nullptr;
+        }
+
+        rows = 0;
+        cols = 0;
+        stride = 0;
+        capacity = 0;
+    }
+
+    void FeatureMatrix::set_row(uint32 row, const float* values)
+    {
+        memcpy(get_row(row), values, sizeof(float) * cols);
+    }
+}
@@ -18,10 +18,10 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<MotionMatchingComponent>("MotionMatchingComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	MotionMatchingComponent::MotionMatchingComponent(ref<Entity::EcsData> _data)
+	MotionMatchingComponent::MotionMatchingComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		
@@ -39,6 +39,14 @@ namespace era_engine
 			return SearchResult();
 		}
 
+		MotionMatchingFeatureSet feature_set;
+		compute_feature_set(dt, feature_set);
+
+		return search_animation(feature_set, database_id);
+	}
+
+	void MotionMatchingComponent::compute_feature_set(float dt, MotionMatchingFeatureSet& out_feature_set) const
+	{
 		FeatureComputationContext context;
 		context.fill_context(get_entity(), dt);
 
@@ -51,13 +59,9 @@ namespace era_engine
 		PhaseFeature phase_feature{};
 		phase_feature.compute_features(context);
 
-		MotionMatchingFeatureSet feature_set;
-
-		feature_set.add_feature(pose_feature.get_type(), std::move(pose_feature.get_values()));
-		feature_set.add_feature(trajectory_feature.get_type(), std::move(trajectory_feature.get_values()));
-		feature_set.add_feature(phase_feature.get_type(), std::move(phase_feature.get_values()));
-
-		return search_animation(feature_set, database_id);
+		out_feature_set.add_feature(pose_feature.get_type(), std::move(pose_feature.get_values()));
+		out_feature_set.add_feature(trajectory_feature.get_type(), std::move(trajectory_feature.get_values()));
+		out_feature_set.add_feature(phase_feature.get_type(), std::move(phase_feature.get_values()));
 	}
 
 	SearchResult MotionMatchingComponent::search_animation(const MotionMatchingFeatureSet& feature_set, const std::string& database_id) const
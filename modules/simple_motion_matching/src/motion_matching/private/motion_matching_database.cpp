@@ -1,7 +1,6 @@
 #include "motion_matching/motion_matching_database.h"
 #include "motion_matching/motion_matching_knn_structure.h"
 #include "motion_matching/common.h"
-#include "motion_matching/hnsw/hnsw_knn_structure.h"
 
 #include <animation/animation_clip.h>
 
@@ -11,24 +10,16 @@
 
 #include <core/math.h>
 #include <core/log.h>
+#include <core/job_system.h>
 
 #include <core/traits.h>
+#include <core/simd.h>
+
+#include <algorithm>
+#include <numeric>
 
 namespace era_engine
 {
-    class PCAResult
-    {
-    public:
-        PCAResult(uint32 num_components)
-        {
-            eigenvalues.resize(num_components);
-            eigenvectors.resize(num_components);
-        }
-
-        std::vector<float> eigenvalues;
-        std::vector<std::vector<float>> eigenvectors;
-    };
-
     static float length(const std::vector<float>& query)
     {
         float sum = std::accumulate(query.begin(), query.end(), 0.0f, [](float sum, float v)
@@ -54,12 +45,14 @@ namespace era_engine
         }
     }
 
-    static float square_distance(const std::vector<float>& lhs, const std::vector<float>& rhs)
-    {
-        ASSERT(lhs.size() == rhs.size());
+    static constexpr uint32 search_features_grain = 256;
+    static constexpr uint32 search_batch_grain = 32;
+    static constexpr uint32 bake_rows_grain = 1024;
 
+    static float square_distance(const float* lhs, const float* rhs, uint32 size)
+    {
         float result = 0.0f;
-        for (size_t index = 0; index < lhs.size(); ++index)
+        for (uint32 index = 0; index < size; ++index)
         {
             const float diff = lhs[index] - rhs[index];
             result += squaref(diff);
@@ -68,252 +61,220 @@ namespace era_engine
         return result;
     }
 
-    static void eigen_decomposition_symmetric(array2d<float>& A, 
-        std::vector<float>& eigenvalues,
-        array2d<float>& eigenvectors, 
-        uint32 max_iterations = 100)
+    // Ranges and sums of the raw features of a range of samples.
+    struct FeatureStatistics
     {
-        uint32 n = A.rows;
-        eigenvectors = array2d<float>(n, n);
-
-        for (uint32 i = 0; i < n; ++i)
+        FeatureStatistics(uint32 num_features)
+            : min_values(num_features, std::numeric_limits<float>::max()),
+            max_values(num_features, std::numeric_limits<float>::lowest()),
+            sums(num_features, 0.0)
         {
-            for (uint32 j = 0; j < n; ++j)
-            {
-                eigenvectors(i, j) = (i == j) ? 1.0f : 0.0f;
-            }
         }
 
-        eigenvalues.resize(n);
+        std::vector<float> min_values;
+        std::vector<float> max_values;
+        std::vector<double> sums;
+    };
 
-        for (uint32 iter = 0; iter < max_iterations; ++iter)
+    static FeatureStatistics combine_statistics(const FeatureStatistics& lhs, const FeatureStatistics& rhs)
+    {
+        FeatureStatistics result = lhs;
+        for (size_t index = 0; index < result.sums.size(); ++index)
         {
-            uint32 p = 0, q = 1;
-            float max_off_diag = std::abs(A(0, 1));
+            result.min_values[index] = std::min(result.min_values[index], rhs.min_values[index]);
+            result.max_values[index] = std::max(result.max_values[index], rhs.max_values[index]);
+            result.sums[index] += rhs.sums[index];
+        }
+        return result;
+    }
 
-            for (uint32 i = 0; i < n; ++i)
+    static std::vector<double> add_sums(const std::vector<double>& lhs, const std::vector<double>& rhs)
+    {
+        std::vector<double> result = lhs;
+        for (size_t index = 0; index < result.size(); ++index)
+        {
+            result[index] += rhs[index];
+        }
+        return result;
+    }
+
+    // Adds the upper triangle of sum((row - means) * (row - means)^T) over rows [begin, end) to 'covariance', a
+    // stride x stride row major matrix. A rank-1 update per row would be bound by loading and storing 'covariance', so
+    // rows are centered in tiles of 4 and every covariance row is updated once per tile.
+    static void accumulate_covariance(const FeatureMatrix& matrix, const float* means, uint32 begin, uint32 end, float* covariance)
+    {
+        constexpr uint32 tile_rows = 4;
+
+        const uint32 cols = matrix.get_cols();
+        const uint32 stride = matrix.get_stride();
+
+        std::vector<float> centered(size_t(tile_rows) * stride, 0.0f);
+
+        for (uint32 tile = begin; tile < end; tile += tile_rows)
+        {
+            for (uint32 tile_row = 0; tile_row < tile_rows; ++tile_row)
             {
-                for (uint32 j = i + 1; j < n; ++j)
+                float* centered_row = centered.data() + size_t(tile_row) * stride;
+                if (tile + tile_row < end)
                 {
-                    float val = std::abs(A(i, j));
-                    if (val > max_off_diag)
+                    const float* row = matrix.get_row(tile + tile_row);
+                    for (uint32 column = 0; column < cols; ++column)
                     {
-                        max_off_diag = val;
-                        p = i;
-                        q = j;
+                        centered_row[column] = row[column] - means[column];
                     }
                 }
+                else
+                {
+                    std::fill(centered_row, centered_row + cols, 0.0f);
+                }
             }
 
-            if (max_off_diag < 1e-10f)
-            {
-                break;
-            }
+            const float* row0 = centered.data();
+            const float* row1 = row0 + stride;
+            const float* row2 = row1 + stride;
+            const float* row3 = row2 + stride;
 
-            float app = A(p, p);
-            float aqq = A(q, q);
-            float apq = A(p, q);
+            for (uint32 i = 0; i < cols; ++i)
+            {
+                float* covariance_row = covariance + size_t(i) * stride;
 
-            float theta = 0.5f * std::atan2(2.0f * apq, aqq - app);
-            float c = std::cos(theta);
-            float s = std::sin(theta);
+#if defined(SIMD_AVX_2)
+                const __m256 x0 = _mm256_set1_ps(row0[i]);
+                const __m256 x1 = _mm256_set1_ps(row1[i]);
+                const __m256 x2 = _mm256_set1_ps(row2[i]);
+                const __m256 x3 = _mm256_set1_ps(row3[i]);
 
-            for (uint32 i = 0; i < n; ++i)
-            {
-                if (i != p && i != q)
+                for (uint32 j = i / 8 * 8; j < stride; j += 8)
                 {
-                    float aip = A(i, p);
-                    float aiq = A(i, q);
-                    A(i, p) = c * aip - s * aiq;
-                    A(p, i) = A(i, p);
-                    A(i, q) = c * aiq + s * aip;
-                    A(q, i) = A(i, q);
+                    __m256 sum = _mm256_loadu_ps(covariance_row + j);
+                    sum = _mm256_fmadd_ps(x0, _mm256_loadu_ps(row0 + j), sum);
+                    sum = _mm256_fmadd_ps(x1, _mm256_loadu_ps(row1 + j), sum);
+                    sum = _mm256_fmadd_ps(x2, _mm256_loadu_ps(row2 + j), sum);
+                    sum = _mm256_fmadd_ps(x3, _mm256_loadu_ps(row3 + j), sum);
+                    _mm256_storeu_ps(covariance_row + j, sum);
                 }
-            }
-
-            float app_new = c * c * app - 2 * c * s * apq + s * s * aqq;
-            float aqq_new = s * s * app + 2 * c * s * apq + c * c * aqq;
-            A(p, p) = app_new;
-            A(q, q) = aqq_new;
-            A(p, q) = A(q, p) = 0.0f;
-
-            for (uint32 i = 0; i < n; ++i)
-            {
-                float vip = eigenvectors(i, p);
-                float viq = eigenvectors(i, q);
-                eigenvectors(i, p) = c * vip - s * viq;
-                eigenvectors(i, q) = c * viq + s * vip;
+#else
+                for (uint32 j = i; j < cols; ++j)
+                {
+                    covariance_row[j] += row0[i] * row0[j] + row1[i] * row1[j] + row2[i] * row2[j] + row3[i] * row3[j];
+                }
+#endif
             }
         }
-
-        for (uint32 i = 0; i < n; ++i)
-        {
-            eigenvalues[i] = A(i, i);
-        }
     }
 
-    static void pcabuildbasis(const array2d<float>& source_data, PCAResult& result)
+    // Cyclic Jacobi eigen decomposition of the symmetric n x n row major 'matrix', which is destroyed. Column i of
+    // 'eigenvectors' belongs to eigenvalues[i]. Every sweep rotates each off-diagonal element to zero once and
+    // convergence is quadratic, so a few sweeps are enough for any feature count.
+    static void eigen_decomposition_symmetric(std::vector<double>& matrix, uint32 n,
+        std::vector<double>& eigenvalues,
+        std::vector<double>& eigenvectors,
+        uint32 max_sweeps = 50)
     {
-        uint32 num_samples = source_data.rows;
-        uint32 num_features = source_data.cols;
-
-        std::vector<float> means(num_features, 0.0f);
-
-        for (uint32 j = 0; j < num_features; ++j)
-        {
-            for (uint32 i = 0; i < num_samples; ++i)
-            {
-                means[j] += source_data(i, j);
-            }
-            means[j] /= num_samples;
-        }
+        auto a = [&](uint32 row, uint32 column) -> double& { return matrix[size_t(row) * n + column]; };
+        auto v = [&](uint32 row, uint32 column) -> double& { return eigenvectors[size_t(row) * n + column]; };
 
-        array2d<float> centered_data(num_samples, num_features);
-        for (uint32 i = 0; i < num_samples; ++i)
+        eigenvectors.assign(size_t(n) * n, 0.0);
+        for (uint32 i = 0; i < n; ++i)
         {
-            for (uint32 j = 0; j < num_features; ++j)
-            {
-                centered_data(i, j) = source_data(i, j) - means[j];
-            }
+            v(i, i) = 1.0;
         }
 
-        array2d<float> covariance(num_features, num_features);
-
-        for (uint32 i = 0; i < num_features; ++i)
+        for (uint32 sweep = 0; sweep < max_sweeps; ++sweep)
         {
-            for (uint32 j = i; j < num_features; ++j)
+            double off_diagonal = 0.0;
+            double diagonal = 0.0;
+            for (uint32 i = 0; i < n; ++i)
             {
-                float cov = 0.0f;
-                for (uint32 k = 0; k < num_samples; ++k)
+                diagonal += a(i, i) * a(i, i);
+                for (uint32 j = i + 1; j < n; ++j)
                 {
-                    cov += centered_data(k, i) * centered_data(k, j);
+                    off_diagonal += a(i, j) * a(i, j);
                 }
-                cov /= (num_samples - 1);
-                covariance(i, j) = cov;
-                covariance(j, i) = cov;
             }
-        }
-
-        std::vector<float> eigenvalues;
-        array2d<float> eigenvectors(num_features, num_features);
-
-        eigen_decomposition_symmetric(covariance, eigenvalues, eigenvectors);
 
-        std::vector<uint32> indices(num_features);
-        for (uint32 i = 0; i < num_features; ++i) indices[i] = i;
+            if (off_diagonal <= 1e-24 * diagonal)
+            {
+                break;
+            }
 
-        std::sort(indices.begin(), indices.end(), [&](uint32 a, uint32 b)
+            for (uint32 p = 0; p < n; ++p)
             {
-            return eigenvalues[a] > eigenvalues[b];
-            });
+                for (uint32 q = p + 1; q < n; ++q)
+                {
+                    const double apq = a(p, q);
+                    if (std::abs(apq) <= 1e-300)
+                    {
+                        continue;
+                    }
 
-        result = PCAResult(num_features);
+                    // Smaller root of t^2 + 2 * theta * t - 1 = 0, the rotation angle stays below 45 degrees.
+                    const double theta = (a(q, q) - a(p, p)) / (2.0 * apq);
+                    const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                    const double c = 1.0 / std::sqrt(t * t + 1.0);
+                    const double s = t * c;
 
-        for (uint32 i = 0; i < num_features; ++i)
-        {
-            uint32 idx = indices[i];
+                    for (uint32 k = 0; k < n; ++k)
+                    {
+                        const double akp = a(k, p);
+                        const double akq = a(k, q);
+                        a(k, p) = c * akp - s * akq;
+                        a(k, q) = s * akp + c * akq;
+                    }
 
-            result.eigenvalues[i] = eigenvalues[idx];
-            result.eigenvectors[i].resize(num_features);
+                    for (uint32 k = 0; k < n; ++k)
+                    {
+                        const double apk = a(p, k);
+                        const double aqk = a(q, k);
+                        a(p, k) = c * apk - s * aqk;
+                        a(q, k) = s * apk + c * aqk;
+                    }
 
-            for (uint32 j = 0; j < num_features; ++j)
-            {
-                result.eigenvectors[i][j] = eigenvectors(j, idx);
+                    for (uint32 k = 0; k < n; ++k)
+                    {
+                        const double vkp = v(k, p);
+                        const double vkq = v(k, q);
+                        v(k, p) = c * vkp - s * vkq;
+                        v(k, q) = s * vkp + c * vkq;
+                    }
+                }
             }
         }
-    }
 
-    void pcabuildbasis(const float* source_data_ptr, uint32 rows, uint32 cols,
-        std::vector<float>& out_s, std::vector<std::vector<float>>& out_v)
-    {
-        array2d<float> mat(rows, cols);
-        for (uint32 i = 0; i < rows * cols; ++i)
+        eigenvalues.resize(n);
+        for (uint32 i = 0; i < n; ++i)
         {
-            mat.data[i] = source_data_ptr[i];
+            eigenvalues[i] = a(i, i);
         }
-
-        PCAResult result(cols);
-        pcabuildbasis(mat, result);
-
-        out_s = result.eigenvalues;
-        out_v = result.eigenvectors;
     }
 
-    static array2d<float> build_transform_matrix(array2d<float> mat)
+    // Rows of the result are the 'num_components' eigenvectors of the n x n 'covariance' with the largest eigenvalues,
+    // largest first.
+    static array2d<float> build_principal_axes(std::vector<double> covariance, uint32 n, uint32 num_components)
     {
-        PCAResult result_pca(mat.cols);
-
-        pcabuildbasis(mat, result_pca);
-
-        const uint32 rows = result_pca.eigenvectors.size();
-        const uint32 cols = result_pca.eigenvectors[0].size();
+        std::vector<double> eigenvalues;
+        std::vector<double> eigenvectors;
+        eigen_decomposition_symmetric(covariance, n, eigenvalues, eigenvectors);
 
-        array2d<float> result(rows, cols);
-        for (uint32 row = 0; row < rows; ++row)
-        {
-            for (uint32 column = 0; column < cols; ++column)
+        std::vector<uint32> indices(n);
+        std::iota(indices.begin(), indices.end(), 0u);
+        std::sort(indices.begin(), indices.end(), [&](uint32 a, uint32 b)
             {
-                result(row, column) = result_pca.eigenvectors[row][column];
-            }
-        }
-
-        return result;
-    }
+                return eigenvalues[a] > eigenvalues[b];
+            });
 
-    static std::vector<float> build_column_means(array2d<float>& mat)
-    {
-        std::vector<float> result;
-        result.resize(mat.cols);
-        for (uint32 column = 0; column < mat.cols; ++column)
+        array2d<float> result(num_components, n);
+        for (uint32 component = 0; component < num_components; ++component)
         {
-            float sum = 0.0f;
-            for (uint32 row = 0; row < mat.rows; ++row)
+            for (uint32 column = 0; column < n; ++column)
             {
-                sum += mat(row, column);
+                result(component, column) = float(eigenvectors[size_t(column) * n + indices[component]]);
             }
-
-            result[column] = sum / static_cast<float>(mat.rows);
         }
 
         return result;
     }
 
-    static void substract_column_means(array2d<float>& mat, const std::vector<float>& column_means)
-    {
-        for (uint32 column = 0; column < mat.cols; ++column)
-        {
-            float mean_value = column_means[column];
-            for (uint32 row = 0; row < mat.rows; ++row)
-            {
-                mat(row, column) -= mean_value;
-            }
-        }
-    }
-
-    static void separate(array2d<float>& mat, array2d<float>& output1, array2d<float>& output2, uint32 output1_column_count)
-    {
-        uint32 column_count1 = output1_column_count;
-        uint32 column_count2 = mat.cols - output1_column_count;
-
-        output1 = array2d<float>(mat.rows, column_count1);
-        output2 = array2d<float>(mat.rows, column_count2);
-
-        for (uint32 row = 0; row < mat.rows; ++row)
-        {
-            for (uint32 column = 0; column < mat.cols; ++column)
-            {
-                if (column < output1_column_count)
-                {
-                    output1(row, column) = mat(row, column);
-                }
-                else
-                {
-                    output2(row, column - output1_column_count) = mat(row, column);
-                }
-            }
-        }
-    }
-
 	void MotionMatchingDatabase::fill_normalize_factors()
 	{
         normalize_factors.clear();
@@ -331,69 +292,78 @@ namespace era_engine
 		}
 	}
 
-    SearchResult MotionMatchingDatabase::narrow_phase_search(const std::vector<std::shared_ptr<Sample>>& broadphase_candidates,
+    SearchResult MotionMatchingDatabase::narrow_phase_search(const std::vector<KnnCandidate>& broadphase_candidates,
         const std::vector<float>& normalized_query,
         const SearchParams& params) const
     {
-        std::optional<std::shared_ptr<MotionMatchingDatabase::Sample>> result_candidate;
-        if (!broadphase_candidates.empty())
+        ASSERT(normalized_query.size() == normalized_features.get_cols());
+
+        const SearchBatchResult result = narrow_phase_search(broadphase_candidates.data(), uint32(broadphase_candidates.size()),
+            normalized_query.data(),
+            params.current_animation.get(),
+            params.current_anim_position);
+
+        if (result.keep_current)
+        {
+            return SearchResult(params.current_animation, database_id, params.current_features, params.current_anim_position);
+        }
+
+        if (result.sample_index == SearchBatchResult::INVALID_SAMPLE)
+        {
+            return SearchResult();
+        }
+
+        const ref<Sample>& sample = samples[result.sample_index];
+        return SearchResult(animations[sample->anim_index], database_id, sample->features, sample->anim_position);
+    }
+
+    SearchBatchResult MotionMatchingDatabase::narrow_phase_search(const KnnCandidate* broadphase_candidates, uint32 num_candidates,
+        const float* normalized_query,
+        const animation::AnimationAssetClip* current_animation,
+        float current_anim_position) const
+    {
+        SearchBatchResult result;
+        if (num_candidates == 0)
         {
-            result_candidate = broadphase_candidates.front();
+            return result;
         }
 
+        const uint32 candidate_index = broadphase_candidates[0].sample_index;
+
         if (has_flag(narrow_phase_params.flags, NarrowPhaseFlags::EUCLIDIAN_DISTANCE_CHECK))
         {
-            if (result_candidate.has_value())
-            {
-                const float result_candidate_to_query_distance_sqr = square_distance(normalized_query, normalize_query(result_candidate.value()->features));
+            const float candidate_to_query_distance_sqr = square_distance(normalized_query,
+                normalized_features.get_row(candidate_index),
+                normalized_features.get_cols());
 
-                const float max_euclidean_distance_sqr = squaref(narrow_phase_params.max_euclidean_distance);
-                if (result_candidate.has_value() && result_candidate_to_query_distance_sqr >= max_euclidean_distance_sqr)
-                {
-                    result_candidate.reset();
-                }
+            if (candidate_to_query_distance_sqr >= squaref(narrow_phase_params.max_euclidean_distance))
+            {
+                return result;
             }
         }
 
-        if (!result_candidate.has_value())
-		{
-			return SearchResult();
-		}
+        const Sample& candidate = *samples[candidate_index];
 
         if (has_flag(narrow_phase_params.flags, NarrowPhaseFlags::SAME_FRAME_CHECK) &&
-            params.current_animation == animations[result_candidate.value()->anim_index])
+            current_animation == animations[candidate.anim_index].get())
         {
-            const float anim_position_diff = result_candidate.value()->anim_position - params.current_anim_position;
+            const float anim_position_diff = candidate.anim_position - current_anim_position;
 
             if (abs(anim_position_diff) < narrow_phase_params.same_frame_time_threshold)
             {
-                return SearchResult(params.current_animation, database_id, params.current_features, params.current_anim_position);
-
+                result.keep_current = true;
+                return result;
             }
         }
 
-        if (result_candidate.has_value())
-        {
-            ref<Sample> sample = result_candidate.value();
-            return SearchResult(animations[sample->anim_index], database_id, sample->features, sample->anim_position);
-        }
-        else
-        {
-            return SearchResult();
-        }
+        result.sample_index = candidate_index;
+        return result;
     }
 
     MotionMatchingDatabase::MotionMatchingDatabase(KnnStructureType _knn_type /*= KnnStructureType::DEFAULT*/)
     {
         knn_type = _knn_type;
-        if (knn_type == KnnStructureType::HNSW)
-        {
-            knn_structure = ref<KnnStructure>(new HnswKnnStructure());
-        }
-        else
-        {
-            ASSERT(false);
-        }
+        knn_structure = KnnStructure::create(knn_type);
     }
 
     MotionMatchingDatabase::~MotionMatchingDatabase()
@@ -404,84 +374,210 @@ namespace era_engine
         }
     }
 
-    void MotionMatchingDatabase::bake()
+    void MotionMatchingDatabase::bake(const SampleExtractor& extract_samples)
     {
-        uint32 total_features_size = samples[0]->features.size();
+        ASSERT(animations_hashes.size() == animations.size());
 
-        for (uint32 i = 0; i < total_features_size; i++)
+        // Clips that are new or changed since the last bake get an empty cache entry and one extraction job each.
+        std::vector<uint32> clips_to_extract;
+        std::vector<std::vector<std::shared_ptr<Sample>>*> extracted_samples;
+        for (uint32 anim_index = 0; anim_index < uint32(animations.size()); ++anim_index)
         {
-            min_values[i] = std::numeric_limits<float>::max();
-            max_values[i] = std::numeric_limits<float>::min();
+            auto [cache_iter, inserted] = clip_samples_cache.try_emplace(animations_hashes[anim_index]);
+            if (inserted)
+            {
+                clips_to_extract.push_back(anim_index);
+                extracted_samples.push_back(&cache_iter->second);
+            }
         }
 
-        std::vector<float> feature_sums;
-        feature_sums.resize(total_features_size, 0.0f);
+        parallel_for(0, uint32(clips_to_extract.size()), 1, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 index = begin; index < end; ++index)
+            {
+                extract_samples(*animations[clips_to_extract[index]], sample_rate, *extracted_samples[index]);
+            }
+        });
 
-        for (std::shared_ptr<Sample> motion_sample : samples)
+        std::unordered_set<uint32> baked_hashes;
+
+        samples.clear();
+        for (uint32 anim_index = 0; anim_index < uint32(animations.size()); ++anim_index)
         {
-            ASSERT(motion_sample->features.size() == total_features_size);
+            const uint32 hash = animations_hashes[anim_index];
+            const bool duplicate = !baked_hashes.insert(hash).second;
 
-            for (uint32 i = 0; i < total_features_size; i++)
+            for (const std::shared_ptr<Sample>& sample : clip_samples_cache[hash])
             {
-                if (motion_sample->features[i] < min_values[i])
-                {
-                    min_values[i] = motion_sample->features[i];
-                }
+                // The same clip listed twice can't share samples, they differ in anim_index.
+                std::shared_ptr<Sample> clip_sample = duplicate ? std::make_shared<Sample>(*sample) : sample;
+                clip_sample->anim_index = anim_index;
+                samples.push_back(std::move(clip_sample));
+            }
+        }
 
-                if (motion_sample->features[i] > max_values[i])
+        for (auto cache_iter = clip_samples_cache.begin(); cache_iter != clip_samples_cache.end();)
+        {
+            if (baked_hashes.count(cache_iter->first) == 0)
+            {
+                cache_iter = clip_samples_cache.erase(cache_iter);
+            }
+            else
+            {
+                ++cache_iter;
+            }
+        }
+
+        bake();
+    }
+
+    void MotionMatchingDatabase::bake()
+    {
+        ASSERT(!samples.empty());
+
+        const uint32 rows = uint32(samples.size());
+        const uint32 total_features_size = uint32(samples[0]->features.size());
+
+        ASSERT(weights.size() == total_features_size);
+        ASSERT(search_dimension <= total_features_size);
+
+        // Ranges and means of the raw features
+        {
+            const FeatureStatistics statistics = parallel_reduce(0, rows, bake_rows_grain, FeatureStatistics(total_features_size),
+                [&](uint32 begin, uint32 end, FeatureStatistics value)
                 {
-                    max_values[i] = motion_sample->features[i];
-                }
+                    for (uint32 row = begin; row < end; ++row)
+                    {
+                        const std::vector<float>& sample_features = samples[row]->features;
+                        ASSERT(sample_features.size() == total_features_size);
+
+                        for (uint32 index = 0; index < total_features_size; ++index)
+                        {
+                            value.min_values[index] = std::min(value.min_values[index], sample_features[index]);
+                            value.max_values[index] = std::max(value.max_values[index], sample_features[index]);
+                            value.sums[index] += sample_features[index];
+                        }
+                    }
+                    return value;
+                }, combine_statistics);
 
-                feature_sums[i] += motion_sample->features[i];
+            min_values = statistics.min_values;
+            max_values = statistics.max_values;
+
+            mean_values.resize(total_features_size);
+            for (uint32 index = 0; index < total_features_size; ++index)
+            {
+                mean_values[index] = float(statistics.sums[index] / rows);
             }
         }
 
-        mean_values.clear();
-        mean_values.reserve(total_features_size);
-        for (uint32 i = 0; i < total_features_size; ++i)
+        fill_normalize_factors();
+
+        normalized_features.resize(rows, total_features_size);
+        normalize_samples();
+
+        // PCA of the normalized features. The covariance is summed in float per block of rows and in double across blocks.
         {
-            mean_values.emplace_back(feature_sums[i] / samples.size());
+            const uint32 stride = normalized_features.get_stride();
+
+            const std::vector<double> column_sums = parallel_reduce(0, rows, bake_rows_grain, std::vector<double>(total_features_size, 0.0),
+                [&](uint32 begin, uint32 end, std::vector<double> value)
+                {
+                    for (uint32 row = begin; row < end; ++row)
+                    {
+                        const float* values = normalized_features.get_row(row);
+                        for (uint32 column = 0; column < total_features_size; ++column)
+                        {
+                            value[column] += values[column];
+                        }
+                    }
+                    return value;
+                }, add_sums);
+
+            transform_column_means.resize(total_features_size);
+            for (uint32 column = 0; column < total_features_size; ++column)
+            {
+                transform_column_means[column] = float(column_sums[column] / rows);
+            }
+
+            const std::vector<double> upper_covariance = parallel_reduce(0, rows, bake_rows_grain, std::vector<double>(size_t(stride) * stride, 0.0),
+                [&](uint32 begin, uint32 end, std::vector<double> value)
+                {
+                    std::vector<float> block_covariance(size_t(stride) * stride, 0.0f);
+                    accumulate_covariance(normalized_features, transform_column_means.data(), begin, end, block_covariance.data());
+
+                    for (size_t index = 0; index < value.size(); ++index)
+                    {
+                        value[index] += block_covariance[index];
+                    }
+                    return value;
+                }, add_sums);
+
+            const double normalizer = 1.0 / double(std::max(rows, 2u) - 1);
+
+            std::vector<double> covariance(size_t(total_features_size) * total_features_size);
+            for (uint32 i = 0; i < total_features_size; ++i)
+            {
+                for (uint32 j = i; j < total_features_size; ++j)
+                {
+                    const double value = upper_covariance[size_t(i) * stride + j] * normalizer;
+                    covariance[size_t(i) * total_features_size + j] = value;
+                    covariance[size_t(j) * total_features_size + i] = value;
+                }
+            }
+
+            transform_matrix = build_principal_axes(std::move(covariance), total_features_size, search_dimension);
         }
 
-        fill_normalize_factors();
+        search_features.resize(rows, search_dimension);
+        project_samples();
 
-        std::vector<float> all_feature_values;
-        all_feature_values.reserve(samples.size() * total_features_size);
-		for (const auto& sample : samples)
-		{
-			for (uint32 index = 0; index < uint32(sample->features.size()); ++index)
-			{
-				float normalized_feature = 0.0f;
-
-				if (fuzzy_equals(sample->features[index], min_values[index], 1e-3f))
-				{
-					normalized_feature = 0.0f;
-				}
-				else
-				{
-					float normalize_factor = weights[index] / (max_values[index] - min_values[index]);
-					normalized_feature = (sample->features[index] - min_values[index]) * normalize_factor;
-				}
-
-				all_feature_values.push_back(normalized_feature);
-			}
-		}
+        knn_structure->build_structure(*this);
+    }
 
+    void MotionMatchingDatabase::build_search_features()
+    {
+        const uint32 rows = uint32(samples.size());
+        const uint32 total_features_size = rows > 0 ? uint32(samples[0]->features.size()) : 0;
 
-        uint32 matching_row_count = uint32(samples.size());
-        uint32 matching_column_count = uint32(total_features_size);
+        normalized_features.resize(rows, total_features_size);
+        search_features.resize(rows, search_dimension);
 
-        array2d<float> features_matrix(matching_row_count, matching_column_count);
-        features_matrix.fill(all_feature_values.data());
+        if (rows == 0)
+        {
+            return;
+        }
 
-        array2d<float> pca_matrix = build_transform_matrix(features_matrix);
-        transform_column_means = build_column_means(features_matrix);
-        substract_column_means(features_matrix, transform_column_means);
+        ASSERT(uint32(transform_matrix.rows) == search_dimension);
+        ASSERT(uint32(transform_matrix.cols) == total_features_size);
+        ASSERT(transform_column_means.size() == total_features_size);
 
-        array2d<float> other;
-        separate(pca_matrix, transform_matrix, other, search_dimension);
-        transform_matrix = transpose(transform_matrix);
+        normalize_samples();
+        project_samples();
+    }
+
+    void MotionMatchingDatabase::normalize_samples()
+    {
+        parallel_for(0, normalized_features.get_rows(), search_features_grain, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 row = begin; row < end; ++row)
+            {
+                ASSERT(samples[row]->features.size() == normalized_features.get_cols());
+
+                normalize_query(samples[row]->features.data(), normalized_features.get_row(row));
+            }
+        });
+    }
+
+    void MotionMatchingDatabase::project_samples()
+    {
+        parallel_for(0, search_features.get_rows(), search_features_grain, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 row = begin; row < end; ++row)
+            {
+                project_query(normalized_features.get_row(row), search_features.get_row(row));
+            }
+        });
     }
 
     SearchResult MotionMatchingDatabase::search(const SearchParams& params) const
@@ -494,31 +590,95 @@ namespace era_engine
 
         ASSERT(query_size == search_dimension);
 
-        std::vector<std::shared_ptr<Sample>> knn = knn_structure->search_knn(packed_normalized_query, query_size, max_broardphase_candidates, *this);
+        std::vector<KnnCandidate> knn;
+        knn_structure->search_knn(packed_normalized_query, max_broardphase_candidates, *this, knn);
 
         return narrow_phase_search(knn, normalized_query_values, params);
     }
 
+    void MotionMatchingDatabase::search_batch(const SearchBatchQuery* queries, uint32 num_queries, SearchBatchResult* results, SearchBatchContext& context) const
+    {
+        if (num_queries == 0)
+        {
+            return;
+        }
+
+        const uint32 total_features_size = uint32(mean_values.size());
+
+        context.normalized_queries.resize(num_queries, total_features_size);
+        context.packed_queries.resize(num_queries, search_dimension);
+        context.candidates.resize(size_t(num_queries) * max_broardphase_candidates);
+        context.candidate_counts.resize(num_queries);
+
+        parallel_for(0, num_queries, search_batch_grain, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 query = begin; query < end; ++query)
+            {
+                normalize_query(queries[query].query, context.normalized_queries.get_row(query));
+                project_query(context.normalized_queries.get_row(query), context.packed_queries.get_row(query));
+            }
+        });
+
+        knn_structure->search_knn_batch(context.packed_queries.get_data(), context.packed_queries.get_stride(), num_queries, max_broardphase_candidates,
+            *this, context.candidates.data(), context.candidate_counts.data());
+
+        parallel_for(0, num_queries, search_batch_grain, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 query = begin; query < end; ++query)
+            {
+                results[query] = narrow_phase_search(context.candidates.data() + size_t(query) * max_broardphase_candidates, context.candidate_counts[query],
+                    context.normalized_queries.get_row(query),
+                    queries[query].current_animation,
+                    queries[query].current_anim_position);
+            }
+        });
+    }
+
     std::vector<float> MotionMatchingDatabase::normalize_query(const std::vector<float>& query) const
     {
         ASSERT(query.size() == mean_values.size());
-        ASSERT(query.size() == normalize_factors.size());
 
-        std::vector<float> result;
-        result.reserve(query.size());
-        for (size_t index = 0; index < query.size(); ++index)
+        std::vector<float> result(query.size());
+        normalize_query(query.data(), result.data());
+
+        return result;
+    }
+
+    void MotionMatchingDatabase::normalize_query(const float* query, float* out_normalized_query) const
+    {
+        ASSERT(mean_values.size() == normalize_factors.size());
+
+        for (size_t index = 0; index < mean_values.size(); ++index)
         {
             if (fuzzy_equals(query[index], mean_values[index], 1e-3f))
             {
-                result.push_back(0.0f);
+                out_normalized_query[index] = 0.0f;
             }
             else
             {
-                result.push_back((query[index] - mean_values[index]) * normalize_factors[index]);
+                out_normalized_query[index] = (query[index] - mean_values[index]) * normalize_factors[index];
             }
         }
+    }
 
-        return result;
+    void MotionMatchingDatabase::project_query(const float* normalized_query, float* out_packed_query) const
+    {
+        const uint32 total_features_size = uint32(transform_column_means.size());
+
+        ASSERT(uint32(transform_matrix.rows) == search_dimension);
+        ASSERT(uint32(transform_matrix.cols) == total_features_size);
+
+        for (uint32 component = 0; component < search_dimension; ++component)
+        {
+            const float* basis = &transform_matrix.data[component * total_features_size];
+
+            float value = 0.0f;
+            for (uint32 column = 0; column < total_features_size; ++column)
+            {
+                value += basis[column] * (normalized_query[column] - transform_column_means[column]);
+            }
+            out_packed_query[component] = value;
+        }
     }
 
     void MotionMatchingDatabase::subtract_column_means(array2d<float>& matrix) const
@@ -593,7 +753,25 @@ namespace era_engine
                 IO::write_vector(os, transform_column_means);
                 IO::write_value(os, transform_matrix.cols);
                 IO::write_value(os, transform_matrix.rows);
-                IO::write_data(os, transform_matrix.data, static_cast<uint32>(transform_matrix.cols * transform_matrix.rows));
+                IO::write_data(os, transform_matrix.data, sizeof(float) * transform_matrix.cols * transform_matrix.rows);
+            }
+
+            // Samples
+            {
+                const uint32 num_samples = uint32(samples.size());
+                const uint32 total_features_size = num_samples > 0 ? uint32(samples[0]->features.size()) : 0;
+
+                IO::write_value(os, num_samples);
+                IO::write_value(os, total_features_size);
+
+                for (const std::shared_ptr<Sample>& sample : samples)
+                {
+                    ASSERT(sample->features.size() == total_features_size);
+
+                    IO::write_data(os, sample->features.data(), sizeof(float) * total_features_size);
+                    IO::write_value(os, sample->anim_index);
+                    IO::write_value(os, sample->anim_position);
+                }
             }
 
             // Knn
@@ -605,7 +783,7 @@ namespace era_engine
                     knn_structure->build_structure(*this);
                 }
 
-                IO::write_value(os, knn_structure->writable.size());
+                IO::write_value(os, uint64(knn_structure->writable.size()));
                 IO::write_data(os, knn_structure->writable.data(), knn_structure->writable.size());
 
                 knn_structure->serialize(os, *this);
@@ -682,20 +860,69 @@ namespace era_engine
             // Transform
             {
                 IO::read_vector(is, transform_column_means);
-                IO::read_value(is, transform_matrix.cols);
-                IO::read_value(is, transform_matrix.rows);
-                IO::read_data(is, transform_matrix.data, static_cast<uint32>(transform_matrix.cols * transform_matrix.rows));
+
+                int transform_cols = 0;
+                int transform_rows = 0;
+                IO::read_value(is, transform_cols);
+                IO::read_value(is, transform_rows);
+
+                transform_matrix.resize(transform_rows, transform_cols);
+                IO::read_data(is, transform_matrix.data, sizeof(float) * transform_cols * transform_rows);
+            }
+
+            // Samples
+            {
+                uint32 num_samples = 0;
+                uint32 total_features_size = 0;
+                IO::read_value(is, num_samples);
+                IO::read_value(is, total_features_size);
+
+                samples.clear();
+                samples.reserve(num_samples);
+                for (uint32 index = 0; index < num_samples; ++index)
+                {
+                    std::shared_ptr<Sample> sample = std::make_shared<Sample>();
+                    sample->features.resize(total_features_size);
+
+                    IO::read_data(is, sample->features.data(), sizeof(float) * total_features_size);
+                    IO::read_value(is, sample->anim_index);
+                    IO::read_value(is, sample->anim_position);
+
+                    samples.emplace_back(std::move(sample));
+                }
+
+                build_search_features();
+
+                // Seeds the cache, so the next bake(extract_samples) only extracts clips that changed since this one was saved.
+                clip_samples_cache.clear();
+                if (animations_hashes.size() == animations.size())
+                {
+                    std::vector<bool> caches_clip(animations_hashes.size());
+                    for (uint32 anim_index = 0; anim_index < uint32(animations_hashes.size()); ++anim_index)
+                    {
+                        caches_clip[anim_index] = clip_samples_cache.try_emplace(animations_hashes[anim_index]).second;
+                    }
+
+                    for (const std::shared_ptr<Sample>& sample : samples)
+                    {
+                        if (sample->anim_index < caches_clip.size() && caches_clip[sample->anim_index])
+                        {
+                            clip_samples_cache[animations_hashes[sample->anim_index]].push_back(sample);
+                        }
+                    }
+                }
             }
 
             // Knn
             {
                 IO::read_value(is, knn_type);
+                knn_structure = KnnStructure::create(knn_type);
 
-                uint32 knn_size = 0;
+                uint64 knn_size = 0;
                 IO::read_value(is, knn_size);
 
                 std::vector<uint8> knn_data;
-                knn_data.reserve(knn_size);
+                knn_data.resize(knn_size);
                 IO::read_data(is, knn_data.data(), knn_size);
 
                 knn_structure->writable.assign(
@@ -1,9 +1,32 @@
 #include "motion_matching/motion_matching_knn_structure.h"
+#include "motion_matching/hnsw/hnsw_knn_structure.h"
+#include "motion_matching/brute_force/brute_force_knn_structure.h"
+#include "motion_matching/product_quantization/product_quantization_knn_structure.h"
 
 #include <core/math.h>
+#include <core/job_system.h>
 
 namespace era_engine
 {
+    static constexpr uint32 knn_batch_grain = 16;
+
+    void KnnCandidateList::insert(uint32 sample_index, float distance_sqr)
+    {
+        if (distance_sqr >= get_bound())
+        {
+            return;
+        }
+
+        // Lists are short (tens of entries), so a linear insertion beats a heap.
+        uint32 position = size < capacity ? size++ : size - 1;
+        while (position > 0 && storage[position - 1].distance_sqr > distance_sqr)
+        {
+            storage[position] = storage[position - 1];
+            --position;
+        }
+        storage[position] = KnnCandidate{ sample_index, distance_sqr };
+    }
+
     KnnStructure::~KnnStructure()
     {
     }
@@ -12,9 +35,27 @@ namespace era_engine
     {
     }
 
-    std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>> KnnStructure::search_knn(float* query, uint32 query_size, uint32 max_candidates, const MotionMatchingDatabase& database)
+    void KnnStructure::search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates)
     {
-        return std::vector<std::shared_ptr<MotionMatchingDatabase::Sample>>();
+        out_candidates.clear();
+    }
+
+    void KnnStructure::search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+        const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts)
+    {
+        parallel_for(0, num_queries, knn_batch_grain, [&](uint32 begin, uint32 end)
+        {
+            std::vector<KnnCandidate> candidates;
+            candidates.reserve(max_candidates);
+
+            for (uint32 query = begin; query < end; ++query)
+            {
+                search_knn(queries + size_t(query) * query_stride, max_candidates, database, candidates);
+
+                out_counts[query] = uint32(candidates.size());
+                std::copy(candidates.begin(), candidates.end(), out_candidates + size_t(query) * max_candidates);
+            }
+        });
     }
 
     bool KnnStructure::serialize(std::ostream& os, const MotionMatchingDatabase& database) const
@@ -26,4 +67,20 @@ namespace era_engine
     {
         return false;
     }
+
+    ref<KnnStructure> KnnStructure::create(KnnStructureType type)
+    {
+        switch (type)
+        {
+        case KnnStructureType::HNSW:
+            return make_ref<HnswKnnStructure>();
+        case KnnStructureType::BRUTE_FORCE:
+            return make_ref<BruteForceKnnStructure>();
+        case KnnStructureType::PRODUCT_QUANTIZATION:
+            return make_ref<ProductQuantizationKnnStructure>();
+        default:
+            ASSERT(false);
+            return nullptr;
+        }
+    }
 }
@@ -43,22 +43,72 @@ namespace era_engine
 	{
 		using namespace animation;
 
+		ref<MotionMatchingDatabase> database = MotionDatabaseRegistry::get_by_id("LOCOMOTION");
+		if (database == nullptr)
+		{
+			return;
+		}
+
+		const uint32 query_size = uint32(database->mean_values.size());
+
+		batch_animation_components.clear();
+		batch_query_values.clear();
+
+		MotionMatchingFeatureSet feature_set;
+
         for (auto [handle, transform_component, mm_controller, animation_component] : world->group(components_group<TransformComponent, MotionMatchingComponent, AnimationComponent>).each())
         {
 			mm_controller.search_timer -= dt;
-			if (mm_controller.search_timer <= 0.0f)
+			if (mm_controller.search_timer > 0.0f)
+			{
+				continue;
+			}
+			mm_controller.search_timer = mm_controller.search_time;
+
+			feature_set.clear();
+			mm_controller.compute_feature_set(dt, feature_set);
+
+			const size_t query_offset = batch_query_values.size();
+			feature_set.append_all_feature_values(batch_query_values);
+
+			if (batch_query_values.size() - query_offset != query_size)
 			{
-				mm_controller.search_timer = mm_controller.search_time;
-
-				MotionMatchingFeatureSet feature_set;
-				SearchResult search_result = mm_controller.search_animation(feature_set, "LOCOMOTION");
-				
-				if (search_result.animation != nullptr)
-				{
-					animation_component.current_animation = search_result.animation;
-					animation_component.current_anim_position = search_result.anim_position;
-				}
+				batch_query_values.resize(query_offset);
+				continue;
 			}
+
+			batch_animation_components.push_back(&animation_component);
         }
+
+		const uint32 num_queries = uint32(batch_animation_components.size());
+
+		batch_queries.resize(num_queries);
+		batch_results.resize(num_queries);
+		for (uint32 index = 0; index < num_queries; ++index)
+		{
+			const AnimationComponent* animation_component = batch_animation_components[index];
+
+			SearchBatchQuery& query = batch_queries[index];
+			query.query = batch_query_values.data() + size_t(index) * query_size;
+			query.current_animation = animation_component->current_animation.get();
+			query.current_anim_position = animation_component->current_anim_position;
+		}
+
+		database->search_batch(batch_queries.data(), num_queries, batch_results.data(), batch_context);
+
+		for (uint32 index = 0; index < num_queries; ++index)
+		{
+			const SearchBatchResult& result = batch_results[index];
+			if (result.keep_current || result.sample_index == SearchBatchResult::INVALID_SAMPLE)
+			{
+				continue;
+			}
+
+			const MotionMatchingDatabase::Sample& sample = *database->samples[result.sample_index];
+
+			AnimationComponent* animation_component = batch_animation_components[index];
+			animation_component->current_animation = database->animations[sample.anim_index];
+			animation_component->current_anim_position = sample.anim_position;
+		}
 	}
 }
\ No newline at end of file
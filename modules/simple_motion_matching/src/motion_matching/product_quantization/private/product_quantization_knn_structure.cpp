@@ -0,0 +1,370 @@
+#include "motion_matching/product_quantization/product_quantization_knn_structure.h"
+#include "motion_matching/brute_force/brute_force_knn_structure.h"
+
+#include <asset/io.h>
+
+#include <core/job_system.h>
+#include <core/simd.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+namespace era_engine
+{
+    static constexpr uint32 pq_encoding_grain = 512;
+    static constexpr uint32 pq_batch_grain = 8;
+
+    static float get_component(const float* row, uint32 cols, uint32 index)
+    {
+        return index < cols ? row[index] : 0.0f;
+    }
+
+    static uint8 find_nearest_centroid(const float* point, const float* subspace_centroids, uint32 num_centroids, uint32 subspace_dimension)
+    {
+        uint32 nearest = 0;
+        float nearest_distance_sqr = std::numeric_limits<float>::max();
+
+        for (uint32 centroid = 0; centroid < num_centroids; ++centroid)
+        {
+            const float* centroid_values = subspace_centroids + centroid * subspace_dimension;
+
+            float distance_sqr = 0.0f;
+            for (uint32 i = 0; i < subspace_dimension; ++i)
+            {
+                const float diff = point[i] - centroid_values[i];
+                distance_sqr += diff * diff;
+            }
+
+            if (distance_sqr < nearest_distance_sqr)
+            {
+                nearest_distance_sqr = distance_sqr;
+                nearest = centroid;
+            }
+        }
+
+        return uint8(nearest);
+    }
+
+    // Lloyd's k-means over the training points of one subspace.
+    static void train_subspace(const std::vector<float>& points, uint32 num_centroids, uint32 subspace_dimension, uint32 iterations, uint32 seed,
+        float* out_centroids)
+    {
+        const uint32 num_points = uint32(points.size() / subspace_dimension);
+
+        std::mt19937 rng(seed);
+
+        std::vector<uint32> order(num_points);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        for (uint32 centroid = 0; centroid < num_centroids; ++centroid)
+        {
+            memcpy(out_centroids + centroid * subspace_dimension, points.data() + order[centroid] * subspace_dimension, sizeof(float) * subspace_dimension);
+        }
+
+        std::vector<uint8> assignments(num_points);
+        std::vector<float> sums(num_centroids * subspace_dimension);
+        std::vector<uint32> counts(num_centroids);
+
+        std::uniform_int_distribution<uint32> random_point(0, num_points - 1);
+
+        for (uint32 iteration = 0; iteration < iterations; ++iteration)
+        {
+            std::fill(sums.begin(), sums.end(), 0.0f);
+            std::fill(counts.begin(), counts.end(), 0);
+
+            for (uint32 point = 0; point < num_points; ++point)
+            {
+                const float* values = points.data() + point * subspace_dimension;
+                const uint8 centroid = find_nearest_centroid(values, out_centroids, num_centroids, subspace_dimension);
+
+                assignments[point] = centroid;
+                ++counts[centroid];
+                for (uint32 i = 0; i < subspace_dimension; ++i)
+                {
+                    sums[centroid * subspace_dimension + i] += values[i];
+                }
+            }
+
+            for (uint32 centroid = 0; centroid < num_centroids; ++centroid)
+            {
+                float* centroid_values = out_centroids + centroid * subspace_dimension;
+                if (counts[centroid] == 0)
+                {
+                    // Empty cluster, restart it on some point.
+                    memcpy(centroid_values, points.data() + random_point(rng) * subspace_dimension, sizeof(float) * subspace_dimension);
+                    continue;
+                }
+
+                const float inv_count = 1.0f / float(counts[centroid]);
+                for (uint32 i = 0; i < subspace_dimension; ++i)
+                {
+                    centroid_values[i] = sums[centroid * subspace_dimension + i] * inv_count;
+                }
+            }
+        }
+    }
+
+    ProductQuantizationKnnStructure::~ProductQuantizationKnnStructure()
+    {
+    }
+
+    void ProductQuantizationKnnStructure::build_structure(const MotionMatchingDatabase& database)
+    {
+        const FeatureMatrix& features = database.search_features;
+
+        subspace_dimension = std::clamp(subspace_dimension, 1u, FeatureMatrix::COLUMN_ALIGNMENT);
+
+        dimension = features.get_cols();
+        num_rows = features.get_rows();
+        num_subspaces = (dimension + subspace_dimension - 1) / subspace_dimension;
+        num_centroids = 0;
+
+        centroids.clear();
+        codes.clear();
+
+        if (num_rows == 0 || dimension == 0)
+        {
+            write_writable();
+            return;
+        }
+
+        // Training rows are spread evenly over the database, which mixes all clips in.
+        const uint32 num_training_rows = std::min(num_rows, std::max(max_training_samples, 1u));
+        num_centroids = std::min(MAX_CENTROIDS, num_training_rows);
+
+        centroids.resize(size_t(num_subspaces) * num_centroids * subspace_dimension);
+
+        parallel_for(0, num_subspaces, 1, [&](uint32 begin, uint32 end)
+        {
+            std::vector<float> points(size_t(num_training_rows) * subspace_dimension);
+
+            for (uint32 subspace = begin; subspace < end; ++subspace)
+            {
+                for (uint32 i = 0; i < num_training_rows; ++i)
+                {
+                    const float* row = features.get_row(uint32(uint64(i) * num_rows / num_training_rows));
+                    for (uint32 j = 0; j < subspace_dimension; ++j)
+                    {
+                        points[i * subspace_dimension + j] = get_component(row, dimension, subspace * subspace_dimension + j);
+                    }
+                }
+
+                train_subspace(points, num_centroids, subspace_dimension, training_iterations, subspace + 1,
+                    centroids.data() + size_t(subspace) * num_centroids * subspace_dimension);
+            }
+        });
+
+        const uint32 num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        codes.assign(size_t(num_blocks) * num_subspaces * BLOCK_ROWS, 0);
+
+        parallel_for(0, num_blocks, pq_encoding_grain / BLOCK_ROWS, [&](uint32 begin, uint32 end)
+        {
+            float point[FeatureMatrix::COLUMN_ALIGNMENT];
+
+            for (uint32 block = begin; block < end; ++block)
+            {
+                for (uint32 lane = 0; lane < BLOCK_ROWS && block * BLOCK_ROWS + lane < num_rows; ++lane)
+                {
+                    const float* row = features.get_row(block * BLOCK_ROWS + lane);
+
+                    for (uint32 subspace = 0; subspace < num_subspaces; ++subspace)
+                    {
+                        for (uint32 j = 0; j < subspace_dimension; ++j)
+                        {
+                            point[j] = get_component(row, dimension, subspace * subspace_dimension + j);
+                        }
+
+                        const float* subspace_centroids = centroids.data() + size_t(subspace) * num_centroids * subspace_dimension;
+                        codes[(size_t(block) * num_subspaces + subspace) * BLOCK_ROWS + lane] = find_nearest_centroid(point, subspace_centroids, num_centroids, subspace_dimension);
+                    }
+                }
+            }
+        });
+
+        write_writable();
+    }
+
+    void ProductQuantizationKnnStructure::search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates)
+    {
+        out_candidates.resize(max_candidates);
+
+        KnnCandidateList candidates(out_candidates.data(), max_candidates);
+        search_query(query, database.search_features, candidates);
+
+        out_candidates.resize(candidates.get_size());
+    }
+
+    void ProductQuantizationKnnStructure::search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+        const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts)
+    {
+        parallel_for(0, num_queries, pq_batch_grain, [&](uint32 begin, uint32 end)
+        {
+            for (uint32 query = begin; query < end; ++query)
+            {
+                KnnCandidateList candidates(out_candidates + size_t(query) * max_candidates, max_candidates);
+                search_query(queries + size_t(query) * query_stride, database.search_features, candidates);
+
+                out_counts[query] = candidates.get_size();
+            }
+        });
+    }
+
+    void ProductQuantizationKnnStructure::search_query(const float* query, const FeatureMatrix& features, KnnCandidateList& candidates) const
+    {
+        const uint32 max_candidates = candidates.get_capacity();
+        if (num_rows == 0 || max_candidates == 0)
+        {
+            return;
+        }
+
+        ASSERT(features.get_rows() == num_rows && features.get_cols() == dimension);
+
+        // Distances of the query to every centroid, per subspace.
+        float* table = (float*)alloca(sizeof(float) * num_subspaces * num_centroids);
+        for (uint32 subspace = 0; subspace < num_subspaces; ++subspace)
+        {
+            const float* subspace_centroids = centroids.data() + size_t(subspace) * num_centroids * subspace_dimension;
+            for (uint32 centroid = 0; centroid < num_centroids; ++centroid)
+            {
+                float distance_sqr = 0.0f;
+                for (uint32 j = 0; j < subspace_dimension; ++j)
+                {
+                    const float diff = get_component(query, dimension, subspace * subspace_dimension + j) - subspace_centroids[centroid * subspace_dimension + j];
+                    distance_sqr += diff * diff;
+                }
+                table[subspace * num_centroids + centroid] = distance_sqr;
+            }
+        }
+
+        const uint32 num_coarse_candidates = std::max(max_candidates * rerank_factor, max_candidates);
+        KnnCandidateList coarse_candidates((KnnCandidate*)alloca(sizeof(KnnCandidate) * num_coarse_candidates), num_coarse_candidates);
+
+        const uint32 num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        alignas(32) float block_distances[BLOCK_ROWS];
+
+        for (uint32 block = 0; block < num_blocks; ++block)
+        {
+            const uint8* block_codes = codes.data() + size_t(block) * num_subspaces * BLOCK_ROWS;
+
+#if defined(SIMD_AVX_2)
+            __m256 sum = _mm256_setzero_ps();
+            for (uint32 subspace = 0; subspace < num_subspaces; ++subspace)
+            {
+                const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(block_codes + subspace * BLOCK_ROWS)));
+                sum = _mm256_add_ps(sum, _mm256_i32gather_ps(table + subspace * num_centroids, indices, 4));
+            }
+
+            const float bound = coarse_candidates.get_bound();
+            uint32 mask = uint32(_mm256_movemask_ps(_mm256_cmp_ps(sum, _mm256_set1_ps(bound), _CMP_LT_OQ)));
+            if (mask == 0)
+            {
+                continue;
+            }
+            _mm256_store_ps(block_distances, sum);
+#else
+            for (uint32 lane = 0; lane < BLOCK_ROWS; ++lane)
+            {
+                block_distances[lane] = 0.0f;
+            }
+            for (uint32 subspace = 0; subspace < num_subspaces; ++subspace)
+            {
+                const float* subspace_table = table + subspace * num_centroids;
+                for (uint32 lane = 0; lane < BLOCK_ROWS; ++lane)
+                {
+                    block_distances[lane] += subspace_table[block_codes[subspace * BLOCK_ROWS + lane]];
+                }
+            }
+            uint32 mask = (1u << BLOCK_ROWS) - 1;
+#endif
+
+            for (uint32 lane = 0; lane < BLOCK_ROWS; ++lane)
+            {
+                const uint32 row = block * BLOCK_ROWS + lane;
+                if ((mask & (1u << lane)) && row < num_rows)
+                {
+                    coarse_candidates.insert(row, block_distances[lane]);
+                }
+            }
+        }
+
+        // Exact distances for the survivors.
+        float* padded_query = (float*)alloca(sizeof(float) * features.get_stride());
+        memset(padded_query, 0, sizeof(float) * features.get_stride());
+        memcpy(padded_query, query, sizeof(float) * dimension);
+
+        for (uint32 index = 0; index < coarse_candidates.get_size(); ++index)
+        {
+            const KnnCandidate& coarse_candidate = coarse_candidates.get_candidates()[index];
+
+            const float bound = candidates.get_bound();
+            const float distance_sqr = BruteForceKnnStructure::get_distance_sqr(features.get_row(coarse_candidate.sample_index), padded_query, features.get_stride(), bound);
+            if (distance_sqr < bound)
+            {
+                candidates.insert(coarse_candidate.sample_index, distance_sqr);
+            }
+        }
+    }
+
+    bool ProductQuantizationKnnStructure::serialize(std::ostream& os, const MotionMatchingDatabase& database) const
+    {
+        IO::write_value(os, subspace_dimension);
+        IO::write_value(os, rerank_factor);
+        IO::write_value(os, max_training_samples);
+        IO::write_value(os, training_iterations);
+
+        return true;
+    }
+
+    bool ProductQuantizationKnnStructure::deserialize(std::istream& is, const MotionMatchingDatabase& database)
+    {
+        IO::read_value(is, subspace_dimension);
+        IO::read_value(is, rerank_factor);
+        IO::read_value(is, max_training_samples);
+        IO::read_value(is, training_iterations);
+
+        if (!read_writable() || num_rows != database.search_features.get_rows() || dimension != database.search_features.get_cols())
+        {
+            build_structure(database);
+        }
+
+        return true;
+    }
+
+    void ProductQuantizationKnnStructure::write_writable() const
+    {
+        std::ostringstream os(std::ios::binary);
+
+        IO::write_value(os, dimension);
+        IO::write_value(os, num_subspaces);
+        IO::write_value(os, num_centroids);
+        IO::write_value(os, num_rows);
+        IO::write_value(os, subspace_dimension);
+        IO::write_vector(os, centroids);
+        IO::write_vector(os, codes);
+
+        writable = os.str();
+    }
+
+    bool ProductQuantizationKnnStructure::read_writable()
+    {
+        if (writable.empty())
+        {
+            return false;
+        }
+
+        std::istringstream is(writable, std::ios::binary);
+
+        bool result = IO::read_value(is, dimension);
+        result = IO::read_value(is, num_subspaces) && result;
+        result = IO::read_value(is, num_centroids) && result;
+        result = IO::read_value(is, num_rows) && result;
+        result = IO::read_value(is, subspace_dimension) && result;
+        result = IO::read_vector(is, centroids) && result;
+        result = IO::read_vector(is, codes) && result;
+
+        return result;
+    }
+}
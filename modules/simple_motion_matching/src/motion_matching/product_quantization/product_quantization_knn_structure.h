@@ -0,0 +1,54 @@
+#pragma once
+
+#include "motion_matching_api.h"
+
+#include "motion_matching/motion_matching_knn_structure.h"
+
+namespace era_engine
+{
+	// Approximate search for large databases. The search dimensions are split into subspaces of 'subspace_dimension'
+	// features and every row keeps, per subspace, the one byte index of the closest of up to 256 k-means centroids.
+	// A query builds a table of its distances to all centroids, scans the codes with table lookups (8 rows per step)
+	// and re-ranks the best 'rerank_factor * k' rows with exact distances from the feature matrix.
+	class ERA_MOTION_MATCHING_API ProductQuantizationKnnStructure : public KnnStructure
+	{
+	public:
+		static constexpr uint32 MAX_CENTROIDS = 256;
+		static constexpr uint32 BLOCK_ROWS = 8;
+
+		~ProductQuantizationKnnStructure() override;
+
+		void build_structure(const MotionMatchingDatabase& database) override;
+
+		void search_knn(const float* query, uint32 max_candidates, const MotionMatchingDatabase& database, std::vector<KnnCandidate>& out_candidates) override;
+		void search_knn_batch(const float* queries, uint32 query_stride, uint32 num_queries, uint32 max_candidates,
+			const MotionMatchingDatabase& database, KnnCandidate* out_candidates, uint32* out_counts) override;
+
+		bool serialize(std::ostream& os, const MotionMatchingDatabase& database) const override;
+		bool deserialize(std::istream& is, const MotionMatchingDatabase& database) override;
+
+	public:
+		uint32 subspace_dimension = 2;
+		uint32 rerank_factor = 8;
+
+		uint32 max_training_samples = 32768;
+		uint32 training_iterations = 12;
+
+	private:
+		void search_query(const float* query, const FeatureMatrix& features, KnnCandidateList& candidates) const;
+
+		void write_writable() const;
+		bool read_writable();
+
+		uint32 dimension = 0;
+		uint32 num_subspaces = 0;
+		uint32 num_centroids = 0;
+		uint32 num_rows = 0;
+
+		// [subspace][centroid][subspace_dimension]
+		std::vector<float> centroids;
+
+		// Blocks of BLOCK_ROWS rows: [block][subspace][row in block].
+		std::vector<uint8> codes;
+	};
+}
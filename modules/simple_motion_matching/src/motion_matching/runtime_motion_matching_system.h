@@ -3,11 +3,17 @@
 #include "ecs/system.h"
 
 #include "motion_matching/array.h"
+#include "motion_matching/motion_matching_database.h"
 
 #include "core/math.h"
 
 namespace era_engine
 {
+	namespace animation
+	{
+		class AnimationComponent;
+	}
+
 	class RuntimeMotionMatchingSystem final : public System
 	{
 	public:
@@ -18,5 +24,13 @@ namespace era_engine
 		void update(float dt) override;
 
 		ERA_VIRTUAL_REFLECT(System)
+
+	private:
+		// Characters due for a search this frame are searched as one batch. Reused between frames.
+		std::vector<animation::AnimationComponent*> batch_animation_components;
+		std::vector<float> batch_query_values;
+		std::vector<SearchBatchQuery> batch_queries;
+		std::vector<SearchBatchResult> batch_results;
+		SearchBatchContext batch_context;
 	};
 }
\ No newline at end of file
@@ -9,10 +9,10 @@ namespace era_engine
 	{
 		using namespace rttr;
 		registration::class_<TrajectoryComponent>("TrajectoryComponent")
-			.constructor<ref<Entity::EcsData>>();
+			.constructor<Entity::EcsData*>();
 	}
 
-	TrajectoryComponent::TrajectoryComponent(ref<Entity::EcsData> _data)
+	TrajectoryComponent::TrajectoryComponent(Entity::EcsData* _data)
 		: Component(_data)
 	{
 		trajectory_desired_velocities.resize(4);
@@ -274,7 +274,7 @@ namespace era_engine
 
 	void TrajectoryMotionSystem::debug_draw_update(float dt)
 	{
-		if (draw_trajectories)
+		if (draw_trajectories && renderer_holder_rc->ldrRenderPass != nullptr)
 		{
 			for (auto [handle, transform_component, trajectory_component]
 				: world->group(components_group<TransformComponent, TrajectoryComponent>).each())
@@ -14,7 +14,7 @@ namespace era_engine
 	{
 	public:
 		TrajectoryComponent() = default;
-		TrajectoryComponent(ref<Entity::EcsData> _data);
+		TrajectoryComponent(Entity::EcsData* _data);
 
 		~TrajectoryComponent() override;
 
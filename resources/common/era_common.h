@@ -13,9 +13,13 @@
 #define PX_ENABLE_PVD 1
 #endif
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <windowsx.h>
 #include <tchar.h>
+#else
+#include <signal.h>
+#endif
 
 #include <limits>
 #include <array>
@@ -36,13 +40,24 @@ namespace fs = std::filesystem;
 
 #include <mutex>
 #include <unordered_map>
+
+#ifdef _WIN32
 #include <wrl.h>
+#endif
 
 #include <map>
 #include <future>
 #include <random>
 #include <iomanip>
 
+#ifndef _WIN32
+// Same name as the MSVC intrinsic, so that ASSERT and the code calling it directly stay as they are.
+inline void __debugbreak()
+{
+	raise(SIGTRAP);
+}
+#endif
+
 #define RELEASE_PTR(ptr) if(ptr) { delete ptr; ptr = nullptr; }
 #define RELEASE_ARRAY_PTR(array_ptr) if(array_ptr) { delete[] array_ptr; array_ptr = nullptr; } 
 
@@ -88,8 +103,10 @@ template <typename T> struct is_ref<ref<T>> : std::true_type {};
 
 template <typename T> inline constexpr bool is_ref_v = is_ref<T>::value;
 
+#ifdef _WIN32
 template <typename T>
 using com = Microsoft::WRL::ComPtr<T>;
+#endif
 
 template <typename T>
 NODISCARD constexpr inline auto min(T a, T b)
@@ -105,6 +122,7 @@ NODISCARD constexpr inline auto max(T a, T b)
 
 template <auto V> static constexpr auto force_consteval = V;
 
+#ifdef _WIN32
 static void check_result_internal(HRESULT hr, const char* file, int32 line)
 {
 	if (FAILED(hr))
@@ -123,6 +141,7 @@ static void check_result_internal(HRESULT hr, const char* file, int32 line)
 		__debugbreak();
 	}
 }
+#endif
 
 #define DEFINE_BITWISE_OPERATORS_FOR_ENUM(enum_type) \
     inline constexpr enum_type operator|(enum_type l, enum_type r) { return static_cast<enum_type>(static_cast<uint32>(l) | static_cast<uint32>(r)); } \